@@ -1,7 +1,7 @@
 # -*- coding: utf-8 -*-
 
 #
-# Authors: Tomi Jylhä-Ollila, Finland 2010-2018
+# Authors: Tomi Jylhä-Ollila, Finland 2010-2019
 #          Toni Ruottu, Finland 2013
 #
 # This file is part of Kunquat.
@@ -96,6 +96,7 @@ class Kunquat():
                 raise _get_error(json.loads(error_str))
         self._track = None
         self._nanoseconds = 0
+        self._snapshot_data = None
         self._audio_buffer_size = _kunquat.kqt_Handle_get_audio_buffer_size(
                 self._handle)
         if audio_rate <= 0:
@@ -146,6 +147,57 @@ class Kunquat():
         """
         _kunquat.kqt_Handle_validate(self._handle)
 
+    def set_snapshot(self, data):
+        """Set a snapshot of precomputed data.
+
+        Data found in the snapshot is used instead of computing it
+        when the corresponding composition data is set.  A snapshot
+        created by a different build of libkunquat is ignored.
+
+        Arguments:
+        data -- The snapshot data as bytes, or None for removing the
+                current snapshot.
+
+        Exceptions:
+        KunquatFormatError -- The data is not a valid snapshot.
+
+        """
+        if data == None:
+            _kunquat.kqt_Handle_set_snapshot(self._handle, None, 0)
+            self._snapshot_data = None
+            return
+
+        cdata = ctypes.create_string_buffer(data, len(data))
+        _kunquat.kqt_Handle_set_snapshot(self._handle, cdata, len(data))
+        self._snapshot_data = cdata
+
+    def set_snapshot_recording(self, enabled):
+        """Enable or disable recording of snapshot data.
+
+        Recording should be enabled before setting the composition
+        data.  Disabling recording discards all recorded data.
+
+        """
+        _kunquat.kqt_Handle_set_snapshot_recording(self._handle, int(enabled))
+
+    def get_snapshot(self):
+        """Get a snapshot of the recorded data as bytes."""
+        length = ctypes.c_long(0)
+        cdata = _kunquat.kqt_Handle_get_snapshot(self._handle, ctypes.byref(length))
+        return ctypes.string_at(cdata, length.value)
+
+    def get_memory_usage(self):
+        """Get the memory usage of the Handle.
+
+        Return value:
+        A dictionary with the total number of bytes in 'total', the
+        bytes of each subsystem in 'subsystems', and the memory usage
+        of each audio unit in 'audio_units'.
+
+        """
+        raw_data = _kunquat.kqt_Handle_get_memory_usage(self._handle)
+        return json.loads(str(raw_data, encoding='utf-8'))
+
     @property
     def track(self):
         """The current track ([0, 255], or None for all tracks)"""
@@ -201,6 +253,34 @@ class Kunquat():
         """
         _kunquat.kqt_Handle_set_loader_thread_count(self._handle, value)
 
+    def get_loading_progress(self):
+        """Get the progress of loading since the last validation.
+
+        Return value:
+        A tuple (tasks done, tasks total, bytes done, bytes total).
+        Only tasks processed in loading threads are included.
+
+        """
+        tasks_done = ctypes.c_long(0)
+        tasks_total = ctypes.c_long(0)
+        bytes_done = ctypes.c_longlong(0)
+        bytes_total = ctypes.c_longlong(0)
+        _kunquat.kqt_Handle_get_loading_progress(
+                self._handle,
+                ctypes.byref(tasks_done),
+                ctypes.byref(tasks_total),
+                ctypes.byref(bytes_done),
+                ctypes.byref(bytes_total))
+        return (tasks_done.value, tasks_total.value, bytes_done.value, bytes_total.value)
+
+    def cancel_loading(self):
+        """Cancel loading operations.
+
+        The Handle can no longer be used after cancellation.
+
+        """
+        _kunquat.kqt_Handle_cancel_loading(self._handle)
+
     def get_player_thread_count(self):
         """Get the number of threads used for audio rendering."""
         return _kunquat.kqt_Handle_get_player_thread_count(self._handle)
@@ -214,6 +294,38 @@ class Kunquat():
         """
         _kunquat.kqt_Handle_set_player_thread_count(self._handle, value)
 
+    def get_voice_pool_size(self):
+        """Get the maximum number of voices."""
+        return _kunquat.kqt_Handle_get_voice_pool_size(self._handle)
+
+    def set_voice_pool_size(self, value):
+        """Set the maximum number of voices.
+
+        Setting the voice pool size stops all notes that are playing.
+
+        """
+        _kunquat.kqt_Handle_set_voice_pool_size(self._handle, value)
+
+    def get_voice_governor_budget(self):
+        """Get the render time budget of the voice governor in nanoseconds."""
+        return _kunquat.kqt_Handle_get_voice_governor_budget(self._handle)
+
+    def set_voice_governor_budget(self, value):
+        """Set the render time budget of the voice governor.
+
+        When a call of play takes longer than value nanoseconds, the
+        quietest and oldest background voices are released. A budget of
+        0 disables the voice governor. Setting the budget resets the
+        intervention count.
+
+        """
+        _kunquat.kqt_Handle_set_voice_governor_budget(self._handle, value)
+
+    def get_voice_governor_intervention_count(self):
+        """Get the number of times the voice governor has released voices."""
+        return _kunquat.kqt_Handle_get_voice_governor_intervention_count(
+                self._handle)
+
 
     @property
     def audio_rate(self):
@@ -473,6 +585,18 @@ def fake_out_of_memory():
     _kunquat.kqt_fake_out_of_memory(0)
 
 
+def set_render_alloc_trap(enabled):
+    _kunquat.kqt_set_render_alloc_trap(1 if enabled else 0)
+
+
+def get_render_alloc_count():
+    return _kunquat.kqt_get_render_alloc_count()
+
+
+def set_voice_batching(enabled):
+    _kunquat.kqt_set_voice_batching(1 if enabled else 0)
+
+
 class _ErrorHookRef():
 
     def __init__(self):
@@ -561,12 +685,40 @@ _kunquat.kqt_Handle_set_loader_thread_count.errcheck = _error_check
 _kunquat.kqt_Handle_get_loader_thread_count.argtypes = [kqt_Handle]
 _kunquat.kqt_Handle_get_loader_thread_count.restype = ctypes.c_int
 _kunquat.kqt_Handle_get_loader_thread_count.errcheck = _error_check
+_kunquat.kqt_Handle_get_loading_progress.argtypes = [
+        kqt_Handle,
+        ctypes.POINTER(ctypes.c_long),
+        ctypes.POINTER(ctypes.c_long),
+        ctypes.POINTER(ctypes.c_longlong),
+        ctypes.POINTER(ctypes.c_longlong)]
+_kunquat.kqt_Handle_get_loading_progress.restype = ctypes.c_int
+_kunquat.kqt_Handle_get_loading_progress.errcheck = _error_check
+_kunquat.kqt_Handle_cancel_loading.argtypes = [kqt_Handle]
+_kunquat.kqt_Handle_cancel_loading.restype = ctypes.c_int
+_kunquat.kqt_Handle_cancel_loading.errcheck = _error_check
 
 _kunquat.kqt_Handle_set_data.argtypes = [
         kqt_Handle, ctypes.c_char_p, ctypes.POINTER(ctypes.c_ubyte), ctypes.c_long]
 _kunquat.kqt_Handle_set_data.restype = ctypes.c_int
 _kunquat.kqt_Handle_set_data.errcheck = _error_check
 
+_kunquat.kqt_Handle_set_snapshot.argtypes = [kqt_Handle, ctypes.c_char_p, ctypes.c_long]
+_kunquat.kqt_Handle_set_snapshot.restype = ctypes.c_int
+_kunquat.kqt_Handle_set_snapshot.errcheck = _error_check
+
+_kunquat.kqt_Handle_set_snapshot_recording.argtypes = [kqt_Handle, ctypes.c_int]
+_kunquat.kqt_Handle_set_snapshot_recording.restype = ctypes.c_int
+_kunquat.kqt_Handle_set_snapshot_recording.errcheck = _error_check
+
+_kunquat.kqt_Handle_get_snapshot.argtypes = [
+        kqt_Handle, ctypes.POINTER(ctypes.c_long)]
+_kunquat.kqt_Handle_get_snapshot.restype = ctypes.c_void_p
+_kunquat.kqt_Handle_get_snapshot.errcheck = _error_check
+
+_kunquat.kqt_Handle_get_memory_usage.argtypes = [kqt_Handle]
+_kunquat.kqt_Handle_get_memory_usage.restype = ctypes.c_char_p
+_kunquat.kqt_Handle_get_memory_usage.errcheck = _error_check
+
 _kunquat.kqt_Handle_play.argtypes = [kqt_Handle, ctypes.c_long]
 _kunquat.kqt_Handle_play.restype = ctypes.c_int
 _kunquat.kqt_Handle_play.errcheck = _error_check
@@ -587,6 +739,22 @@ _kunquat.kqt_Handle_set_player_thread_count.errcheck = _error_check
 _kunquat.kqt_Handle_get_player_thread_count.argtypes = [kqt_Handle]
 _kunquat.kqt_Handle_get_player_thread_count.restype = ctypes.c_int
 _kunquat.kqt_Handle_get_player_thread_count.errcheck = _error_check
+_kunquat.kqt_Handle_set_voice_pool_size.argtypes = [kqt_Handle, ctypes.c_int]
+_kunquat.kqt_Handle_set_voice_pool_size.restype = ctypes.c_int
+_kunquat.kqt_Handle_set_voice_pool_size.errcheck = _error_check
+_kunquat.kqt_Handle_get_voice_pool_size.argtypes = [kqt_Handle]
+_kunquat.kqt_Handle_get_voice_pool_size.restype = ctypes.c_int
+_kunquat.kqt_Handle_get_voice_pool_size.errcheck = _error_check
+_kunquat.kqt_Handle_set_voice_governor_budget.argtypes = [
+        kqt_Handle, ctypes.c_longlong]
+_kunquat.kqt_Handle_set_voice_governor_budget.restype = ctypes.c_int
+_kunquat.kqt_Handle_set_voice_governor_budget.errcheck = _error_check
+_kunquat.kqt_Handle_get_voice_governor_budget.argtypes = [kqt_Handle]
+_kunquat.kqt_Handle_get_voice_governor_budget.restype = ctypes.c_longlong
+_kunquat.kqt_Handle_get_voice_governor_budget.errcheck = _error_check
+_kunquat.kqt_Handle_get_voice_governor_intervention_count.argtypes = [kqt_Handle]
+_kunquat.kqt_Handle_get_voice_governor_intervention_count.restype = ctypes.c_longlong
+_kunquat.kqt_Handle_get_voice_governor_intervention_count.errcheck = _error_check
 
 _kunquat.kqt_Handle_set_audio_rate.argtypes = [kqt_Handle, ctypes.c_long]
 _kunquat.kqt_Handle_set_audio_rate.restype = ctypes.c_int
@@ -649,4 +817,12 @@ _kunquat.kqt_get_version.restype = ctypes.c_char_p
 _kunquat.kqt_fake_out_of_memory.argtypes = [ctypes.c_long]
 _kunquat.kqt_fake_out_of_memory.restype = None
 
+_kunquat.kqt_set_render_alloc_trap.argtypes = [ctypes.c_int]
+_kunquat.kqt_set_render_alloc_trap.restype = None
+_kunquat.kqt_get_render_alloc_count.argtypes = []
+_kunquat.kqt_get_render_alloc_count.restype = ctypes.c_long
+
+_kunquat.kqt_set_voice_batching.argtypes = [ctypes.c_int]
+_kunquat.kqt_set_voice_batching.restype = None
+
 
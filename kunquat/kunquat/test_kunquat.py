@@ -2,7 +2,7 @@
 
 #
 # Authors: Toni Ruottu, Finland 2013
-#          Tomi Jylhä-Ollila, Finland 2013-2016
+#          Tomi Jylhä-Ollila, Finland 2013-2019
 #
 # This file is part of Kunquat.
 #
@@ -13,7 +13,10 @@
 #
 
 import doctest
+import json
+import os.path
 import unittest
+import zipfile
 
 from . import kunquat as wrapper
 from .kunquat import Kunquat
@@ -34,6 +37,46 @@ class TestKunquat(unittest.TestCase):
         wrapper.fake_out_of_memory()
         self.assertRaises(MemoryError, Kunquat)
 
+    def test_rendering_example_does_not_allocate_memory(self):
+        path = os.path.join('examples', 'Asturias.kqt')
+        if not os.path.exists(path):
+            self.skipTest('example module {} not found'.format(path))
+
+        handle = Kunquat()
+        with zipfile.ZipFile(path) as module:
+            for name in module.namelist():
+                # WAV support is optional in libkunquat, so leave out the samples
+                if name.endswith('.wav'):
+                    continue
+                key = name.split('/', 1)[1]
+                data = module.read(name)
+                if key.endswith('.json'):
+                    data = json.loads(str(data, encoding='utf-8')) if data else None
+                handle.set_data(key, data)
+        handle.validate()
+        handle.track = 0
+
+        # Let the first render call settle any lazily created state
+        handle.play(2048)
+        handle.get_audio()
+
+        wrapper.set_render_alloc_trap(True)
+        try:
+            for _ in range(200):
+                handle.play(2048)
+                handle.get_audio()
+                handle.receive_events()
+                if handle.has_stopped():
+                    break
+            handle.fire_event(0, ['n+', 0])
+            handle.play(2048)
+            handle.receive_events()
+            alloc_count = wrapper.get_render_alloc_count()
+        finally:
+            wrapper.set_render_alloc_trap(False)
+
+        self.assertEqual(alloc_count, 0)
+
 
 if __name__ == '__main__':
     unittest.main()
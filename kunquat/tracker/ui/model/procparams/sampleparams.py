@@ -30,6 +30,9 @@ class SampleParams(ProcParams):
 
     _SAMPLES_MAX = 512
 
+    _INTERP_NAME_MAP = { 0: 'linear', 1: 'cubic', 2: 'sinc' }
+    _NAME_INTERP_MAP = dict((v, k) for (k, v) in _INTERP_NAME_MAP.items())
+
     @staticmethod
     def get_default_signal_type():
         return 'voice'
@@ -78,6 +81,19 @@ class SampleParams(ProcParams):
     def get_max_sample_count(self):
         return self._SAMPLES_MAX
 
+    def get_interpolation(self):
+        return self._INTERP_NAME_MAP.get(
+                self._get_value('p_i_interpolation.json', 0), 'unsupported')
+
+    def set_interpolation(self, interp):
+        self._set_value('p_i_interpolation.json', self._NAME_INTERP_MAP[interp])
+
+    def get_mipmaps_enabled(self):
+        return self._get_value('p_b_mipmaps.json', False)
+
+    def set_mipmaps_enabled(self, enabled):
+        self._set_value('p_b_mipmaps.json', enabled)
+
     def get_sample_ids(self):
         ret_ids = []
         for i in range(self._SAMPLES_MAX):
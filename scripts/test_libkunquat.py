@@ -44,6 +44,8 @@ def test_libkunquat(builder, options, cc):
         cc.add_define('KQT_LONG_TESTS')
     if options.enable_tests_mem_debug:
         cc.add_define('K_MEM_DEBUG')
+    if options.with_sndfile:
+        cc.add_define('WITH_SNDFILE')
 
     # Allow simpler structure in tests
     cc.add_compile_flag('-Wno-missing-prototypes')
@@ -55,7 +57,7 @@ def test_libkunquat(builder, options, cc):
     # Define which tests depend on others
     deps = defaultdict(lambda: [], {
             'handle': ['streader', 'tstamp'],
-            'filter': ['fast_exp2', 'fast_sin'],
+            'filter': ['fast_exp2', 'fast_sin', 'player'],
             'player': [
                 'handle',
                 'streader',
@@ -69,11 +71,13 @@ def test_libkunquat(builder, options, cc):
             'instrument': ['connections'],
             'dsp': ['connections', 'fast_sin'],
             'validation': ['handle'],
+            'work_buffer': ['handle'],
         })
     finished_tests = set()
 
     # Specify tests that should always run without memory debugging (for performance)
-    force_disable_mem_tests = set(['fast_sin', 'fast_exp2', 'fast_log2', 'fast_tan'])
+    force_disable_mem_tests = set(
+            ['fast_sin', 'fast_exp2', 'fast_log2', 'fast_tan', 'random'])
 
     echo = '\n   Testing libkunquat\n'
 
@@ -1,7 +1,7 @@
 
 
 /*
- * Author: Tomi Jylhä-Ollila, Finland 2010-2018
+ * Author: Tomi Jylhä-Ollila, Finland 2010-2019
  *
  * This file is part of Kunquat.
  *
@@ -51,6 +51,10 @@ extern "C" {
  * particular, multiple threads must not create new Kunquat Handles or access
  * a single Kunquat Handle in parallel. However, accessing different Kunquat
  * Handles from different threads in parallel should be safe.
+ *
+ * Kunquat Handles that load identical sample data, such as the same WavPack
+ * samples or PADsynth parameters, share the decoded and generated data
+ * instead of computing it again. The sharing is invisible to the caller.
  */
 typedef int kqt_Handle;
 
@@ -95,6 +99,51 @@ int kqt_Handle_set_loader_thread_count(kqt_Handle handle, int count);
 int kqt_Handle_get_loader_thread_count(kqt_Handle handle);
 
 
+/**
+ * Get the progress of background loading in the Kunquat Handle.
+ *
+ * Data set with kqt_Handle_set_data may be processed in loading threads until
+ * the Kunquat Handle is validated. The progress counts cover all loading tasks
+ * started after the previous validation. Tasks that are processed without
+ * loading threads are not included.
+ *
+ * \param handle        The Handle -- should be valid.
+ * \param tasks_done    Destination for the number of finished tasks, or \c 0.
+ * \param tasks_total   Destination for the number of started tasks, or \c 0.
+ * \param bytes_done    Destination for the amount of data processed by the
+ *                      finished tasks in bytes, or \c 0.
+ * \param bytes_total   Destination for the amount of data to be processed by
+ *                      the started tasks in bytes, or \c 0.
+ *
+ * \return   \c 1 if successful, otherwise \c 0.
+ */
+int kqt_Handle_get_loading_progress(
+        kqt_Handle handle,
+        long* tasks_done,
+        long* tasks_total,
+        long long* bytes_done,
+        long long* bytes_total);
+
+
+/**
+ * Cancel background loading in the Kunquat Handle.
+ *
+ * Loading tasks that have not started are discarded and tasks in progress
+ * are stopped as soon as possible. This function returns when all loading
+ * threads have stopped. As the composition data is left incomplete, the
+ * Kunquat Handle can no longer be used and should be deallocated by calling
+ * kqt_del_Handle(\a handle).
+ *
+ * Note that kqt_del_Handle cancels loading automatically, so this function
+ * is only needed for stopping the loading threads before that.
+ *
+ * \param handle   The Handle -- should be valid.
+ *
+ * \return   \c 1 if successful, otherwise \c 0.
+ */
+int kqt_Handle_cancel_loading(kqt_Handle handle);
+
+
 /**
  * Set data of the Kunquat Handle associated with the given key.
  *
@@ -103,6 +152,10 @@ int kqt_Handle_get_loader_thread_count(kqt_Handle handle);
  * functions can be called successfully on the handle:
  *
  * \li kqt_Handle_set_data
+ * \li kqt_Handle_set_snapshot
+ * \li kqt_Handle_get_loading_progress
+ * \li kqt_Handle_get_memory_usage
+ * \li kqt_Handle_cancel_loading
  * \li kqt_Handle_get_error
  * \li kqt_Handle_clear_error
  * \li kqt_Handle_validate
@@ -195,6 +248,90 @@ void kqt_Handle_clear_error(kqt_Handle handle);
 int kqt_Handle_validate(kqt_Handle handle);
 
 
+/**
+ * Set a snapshot of precomputed data used by the Kunquat Handle.
+ *
+ * A snapshot contains data that is expensive to derive from the composition,
+ * such as decoded samples and generated PADsynth tables. When data matching a
+ * snapshot entry is set with kqt_Handle_set_data, the entry is copied instead
+ * of computing the data again. A snapshot can be created with
+ * kqt_Handle_set_snapshot_recording and kqt_Handle_get_snapshot.
+ *
+ * A snapshot created by a different build of libkunquat is ignored, in which
+ * case all data is computed normally.
+ *
+ * \param handle   The Handle -- should be valid.
+ * \param data     The snapshot data, or \c 0 for removing the current
+ *                 snapshot. The data is not copied and must remain valid
+ *                 until the snapshot is replaced or the Handle is destroyed,
+ *                 which allows \a data to be a memory-mapped file.
+ * \param length   The length of \a data -- must not exceed the real length.
+ *
+ * \return   \c 1 if successful, or \c 0 if \a data is not a valid snapshot.
+ */
+int kqt_Handle_set_snapshot(kqt_Handle handle, const char* data, long length);
+
+
+/**
+ * Set snapshot recording in the Kunquat Handle.
+ *
+ * While recording is enabled, all derived data that can be stored in a
+ * snapshot is copied into the Handle when it is computed. Recording should
+ * therefore be enabled before setting the composition data. Disabling
+ * recording discards all recorded data.
+ *
+ * \param handle    The Handle -- should be valid.
+ * \param enabled   \c 1 if recording should be enabled, otherwise \c 0.
+ *
+ * \return   \c 1 if successful, otherwise \c 0.
+ */
+int kqt_Handle_set_snapshot_recording(kqt_Handle handle, int enabled);
+
+
+/**
+ * Get a snapshot of the data recorded in the Kunquat Handle.
+ *
+ * \param handle   The Handle -- should be valid.
+ * \param length   Destination for the length of the snapshot data
+ *                 -- should not be \c NULL.
+ *
+ * \return   The snapshot data, or \c NULL if failed. The data is valid until
+ *           the next call of this function or until the Handle is destroyed.
+ */
+const char* kqt_Handle_get_snapshot(kqt_Handle handle, long* length);
+
+
+/**
+ * Get the memory usage of the Kunquat Handle.
+ *
+ * The memory usage is described as a JSON object with the following keys:
+ *
+ * \li "total": The number of bytes allocated for the Handle.
+ * \li "subsystems": An object that splits the total into the categories
+ *     "samples", "padsynth", "voices", "work_buffers", "device_states",
+ *     "patterns" and "other".
+ * \li "audio_units": An object that maps keys of audio units (such as
+ *     "au_00") to their memory usage. The memory usage of an audio unit has
+ *     the keys "total" and "subsystems" as above, and the keys "processors"
+ *     and "audio_units" for its processors and contained audio units.
+ * \li "shared": The memory usage of data shared between all Handles of the
+ *     process, such as sample data loaded by several Handles and FFT plans,
+ *     with the keys "total" and "subsystems" as above. This memory is not
+ *     included in the totals of any Handle.
+ *
+ * The counters are updated whenever memory is allocated or freed, so this
+ * function does not need to traverse the allocated data. Memory used by the
+ * voice pool and shared work buffers is not attributed to audio units.
+ *
+ * \param handle   The Handle -- should be valid.
+ *
+ * \return   The memory usage description, or \c NULL if failed. The
+ *           description is valid until the next call of this function or
+ *           until the Handle is destroyed.
+ */
+const char* kqt_Handle_get_memory_usage(kqt_Handle handle);
+
+
 /**
  * Free all the resources allocated for an existing Kunquat Handle.
  *
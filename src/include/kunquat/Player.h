@@ -1,7 +1,7 @@
 
 
 /*
- * Author: Tomi Jylhä-Ollila, Finland 2010-2018
+ * Author: Tomi Jylhä-Ollila, Finland 2010-2019
  *
  * This file is part of Kunquat.
  *
@@ -148,6 +148,84 @@ int kqt_Handle_set_player_thread_count(kqt_Handle handle, int count);
 int kqt_Handle_get_player_thread_count(kqt_Handle handle);
 
 
+/**
+ * Set the maximum number of voices used by the Kunquat Handle.
+ *
+ * Memory for voice states, including the delay lines of Karplus-Strong
+ * voices, is reserved in advance according to this limit, so a smaller limit
+ * reduces memory usage. Setting the limit stops all notes that are currently
+ * playing.
+ *
+ * \param handle   The Handle -- should be valid.
+ * \param size     The number of voices -- should be >= \c 1 and
+ *                 <= \c KQT_VOICES_MAX (the default).
+ *
+ * \return   \c 1 if successful, otherwise \c 0.
+ *           Note: if memory allocation fails, the Handle should no longer be
+ *           used for playback.
+ */
+int kqt_Handle_set_voice_pool_size(kqt_Handle handle, int size);
+
+
+/**
+ * Get the maximum number of voices used by the Kunquat Handle.
+ *
+ * \param handle   The Handle -- should be valid.
+ *
+ * \return   The number of voices, or \c 0 if \a handle is invalid.
+ */
+int kqt_Handle_get_voice_pool_size(kqt_Handle handle);
+
+
+/**
+ * Set the render time budget of the voice governor.
+ *
+ * The voice governor measures the time spent in each call of kqt_Handle_play.
+ * When the time exceeds the budget, the governor releases background voices
+ * (that is, notes that have been released but are still audible) in
+ * proportion to the excess time. The quietest voices are released first, and
+ * the oldest voices are released first among voices of equal force. Voices of
+ * notes that are being held are never released by the governor.
+ *
+ * The budget applies to each call of kqt_Handle_play as a whole, regardless
+ * of the number of frames requested. Callers that vary \a nframes should
+ * set the budget for the typical call size.
+ *
+ * Setting the budget resets the intervention count.
+ *
+ * \param handle        The Handle -- should be valid.
+ * \param nanoseconds   The budget in nanoseconds per call of kqt_Handle_play,
+ *                      or \c 0 to disable the voice governor (the default)
+ *                      -- should be >= \c 0.
+ *
+ * \return   \c 1 if successful, otherwise \c 0.
+ */
+int kqt_Handle_set_voice_governor_budget(kqt_Handle handle, long long nanoseconds);
+
+
+/**
+ * Get the render time budget of the voice governor.
+ *
+ * \param handle   The Handle -- should be valid.
+ *
+ * \return   The budget in nanoseconds, \c 0 if the voice governor is disabled,
+ *           or \c -1 if \a handle is invalid.
+ */
+long long kqt_Handle_get_voice_governor_budget(kqt_Handle handle);
+
+
+/**
+ * Get the number of times the voice governor has released voices.
+ *
+ * \param handle   The Handle -- should be valid.
+ *
+ * \return   The number of calls of kqt_Handle_play after which the voice
+ *           governor released voices since the budget was last set, or \c -1
+ *           if \a handle is invalid.
+ */
+long long kqt_Handle_get_voice_governor_intervention_count(kqt_Handle handle);
+
+
 /**
  * Set the audio rate of the Kunquat Handle.
  *
@@ -1,7 +1,7 @@
 
 
 /*
- * Author: Tomi Jylhä-Ollila, Finland 2013-2014
+ * Author: Tomi Jylhä-Ollila, Finland 2013-2019
  *
  * This file is part of Kunquat.
  *
@@ -47,6 +47,37 @@ void kqt_fake_out_of_memory(long steps);
 long kqt_get_memory_alloc_count(void);
 
 
+/**
+ * Set trapping of memory allocations made during rendering.
+ *
+ * When the trap is enabled, memory allocations made by \a kqt_Handle_play,
+ * \a kqt_Handle_fire_event and \a kqt_Handle_receive_events (including the
+ * player threads) are counted. Enabling the trap resets the count.
+ *
+ * \param enabled   \c 1 to enable the trap, \c 0 to disable it.
+ */
+void kqt_set_render_alloc_trap(int enabled);
+
+
+/**
+ * Get the number of memory allocations made during rendering.
+ *
+ * \return   The number of allocations trapped since the trap was enabled.
+ */
+long kqt_get_render_alloc_count(void);
+
+
+/**
+ * Set batch rendering of background voices.
+ *
+ * Batching is enabled by default and does not change the rendered output.
+ * This function must not be called while a Kunquat Handle is rendering.
+ *
+ * \param enabled   \c 1 to enable batching, \c 0 to disable it.
+ */
+void kqt_set_voice_batching(int enabled);
+
+
 /**
  * Suppress assert message printing to standard error output.
  *
@@ -1,7 +1,7 @@
 
 
 /*
- * Author: Tomi Jylhä-Ollila, Finland 2010-2018
+ * Author: Tomi Jylhä-Ollila, Finland 2010-2019
  *
  * This file is part of Kunquat.
  *
@@ -17,6 +17,8 @@
 #include <debug/assert.h>
 #include <init/Connections.h>
 #include <init/devices/Audio_unit.h>
+#include <init/devices/Processor.h>
+#include <init/devices/processors/Proc_sample.h>
 #include <init/Module.h>
 #include <init/Parse_manager.h>
 #include <kunquat/limits.h>
@@ -161,6 +163,58 @@ int kqt_Handle_get_loader_thread_count(kqt_Handle handle)
 }
 
 
+int kqt_Handle_get_loading_progress(
+        kqt_Handle handle,
+        long* tasks_done,
+        long* tasks_total,
+        long long* bytes_done,
+        long long* bytes_total)
+{
+    check_handle(handle, 0);
+
+    Handle* h = get_handle(handle);
+    check_data_is_valid(h, 0);
+
+    int64_t loader_tasks_done = 0;
+    int64_t loader_tasks_total = 0;
+    int64_t loader_bytes_done = 0;
+    int64_t loader_bytes_total = 0;
+    Background_loader_get_progress(
+            h->bkg_loader,
+            &loader_tasks_done,
+            &loader_tasks_total,
+            &loader_bytes_done,
+            &loader_bytes_total);
+
+    if (tasks_done != NULL)
+        *tasks_done = (long)loader_tasks_done;
+    if (tasks_total != NULL)
+        *tasks_total = (long)loader_tasks_total;
+    if (bytes_done != NULL)
+        *bytes_done = (long long)loader_bytes_done;
+    if (bytes_total != NULL)
+        *bytes_total = (long long)loader_bytes_total;
+
+    return 1;
+}
+
+
+int kqt_Handle_cancel_loading(kqt_Handle handle)
+{
+    check_handle(handle, 0);
+
+    Handle* h = get_handle(handle);
+    check_data_is_valid(h, 0);
+
+    Background_loader_cancel(h->bkg_loader);
+
+    // Cancelled tasks leave the composition incomplete
+    h->data_is_valid = false;
+
+    return 1;
+}
+
+
 int kqt_Handle_set_data(
         kqt_Handle handle, const char* key, const void* data, long length)
 {
@@ -192,7 +246,10 @@ int kqt_Handle_set_data(
         return 0;
     }
 
-    if (!parse_data(h, key, data, length))
+    Memory_usage* prev_usage = memory_set_usage(h->mem_usage);
+    const bool success = parse_data(h, key, data, length);
+    memory_set_usage(prev_usage);
+    if (!success)
         return 0;
 
     h->data_is_validated = false;
@@ -201,6 +258,109 @@ int kqt_Handle_set_data(
 }
 
 
+int kqt_Handle_set_snapshot(kqt_Handle handle, const char* data, long length)
+{
+    check_handle(handle, 0);
+
+    Handle* h = get_handle(handle);
+    check_data_is_valid(h, 0);
+
+    if (length < 0)
+    {
+        Handle_set_error(
+                h, ERROR_ARGUMENT, "Snapshot length must be non-negative");
+        return 0;
+    }
+
+    if (data == NULL && length > 0)
+    {
+        Handle_set_error(
+                h,
+                ERROR_ARGUMENT,
+                "Snapshot must not be null if given length (%ld) is positive",
+                length);
+        return 0;
+    }
+
+    // Snapshot entries are only restored in the calling thread,
+    // so we can replace the source without waiting for background tasks
+    Error* error = ERROR_AUTO;
+    Memory_usage* prev_usage = memory_set_usage(h->mem_usage);
+    const bool success = Snapshot_read(h->snapshot, data, length, error);
+    memory_set_usage(prev_usage);
+    if (!success && Error_is_set(error))
+    {
+        Handle_set_error_from_Error(h, error);
+        return 0;
+    }
+
+    return 1;
+}
+
+
+int kqt_Handle_set_snapshot_recording(kqt_Handle handle, int enabled)
+{
+    check_handle(handle, 0);
+
+    Handle* h = get_handle(handle);
+    check_data_is_valid(h, 0);
+    check_data_is_validated(h, 0);
+
+    Snapshot_set_recording(h->snapshot, enabled != 0);
+
+    return 1;
+}
+
+
+const char* kqt_Handle_get_snapshot(kqt_Handle handle, long* length)
+{
+    check_handle(handle, NULL);
+
+    Handle* h = get_handle(handle);
+    check_data_is_valid(h, NULL);
+    check_data_is_validated(h, NULL);
+
+    if (length == NULL)
+    {
+        Handle_set_error(h, ERROR_ARGUMENT, "Length destination must not be null");
+        return NULL;
+    }
+
+    int64_t snapshot_length = 0;
+    Memory_usage* prev_usage = memory_set_usage(h->mem_usage);
+    const char* data = Snapshot_serialise(h->snapshot, &snapshot_length);
+    memory_set_usage(prev_usage);
+    if (data == NULL)
+    {
+        Handle_set_error(h, ERROR_MEMORY, "Could not allocate memory for snapshot");
+        return NULL;
+    }
+
+    *length = (long)snapshot_length;
+
+    return data;
+}
+
+
+static void Validation_scope_init(Validation_scope* scope, bool check_all)
+{
+    rassert(scope != NULL);
+
+    scope->check_all = check_all;
+    scope->check_sheet = false;
+    scope->check_controls = false;
+    scope->check_top_level_connections = false;
+
+    for (int i = 0; i < KQT_PATTERNS_MAX; ++i)
+        scope->check_pats[i] = false;
+
+    for (int i = 0; i < KQT_AUDIO_UNITS_MAX; ++i)
+        scope->check_aus[i] = false;
+
+    return;
+}
+
+
 bool Handle_init(Handle* handle)
 {
     rassert(handle != NULL);
@@ -208,32 +368,52 @@ bool Handle_init(Handle* handle)
     handle->data_is_valid = true;
     handle->data_is_validated = true;
     handle->update_connections = false;
+    Validation_scope_init(&handle->validation_scope, true);
     handle->module = NULL;
     handle->bkg_loader = NULL;
+    handle->snapshot = NULL;
     handle->error = *ERROR_AUTO;
     handle->validation_error = *ERROR_AUTO;
     memset(handle->position, '\0', POSITION_LENGTH);
     handle->player = NULL;
     handle->length_counter = NULL;
+    handle->mem_usage = NULL;
+    handle->memory_report = NULL;
+
+    handle->mem_usage = new_Memory_usage(NULL);
+    if (handle->mem_usage == NULL)
+    {
+        Handle_set_error(NULL, ERROR_MEMORY, "Couldn't allocate memory");
+        return false;
+    }
+
+    Memory_usage* prev_usage = memory_set_usage(handle->mem_usage);
 
 //    int buffer_count = SONG_DEFAULT_BUF_COUNT;
 //    int voice_count = 256;
 
     handle->module = new_Module();
     handle->bkg_loader = new_Background_loader();
-    if ((handle->module == NULL) || (handle->bkg_loader == NULL))
+    handle->snapshot = new_Snapshot();
+    if ((handle->module == NULL) ||
+            (handle->bkg_loader == NULL) ||
+            (handle->snapshot == NULL))
     {
+        memory_set_usage(prev_usage);
         Handle_set_error(NULL, ERROR_MEMORY, "Couldn't allocate memory");
         Handle_deinit(handle);
         return false;
     }
 
+    Background_loader_set_snapshot(handle->bkg_loader, handle->snapshot);
+
     // Create players
     handle->player = new_Player(
             handle->module, DEFAULT_AUDIO_RATE, 2048, 16384, 1024);
     handle->length_counter = new_Player(handle->module, 1000000000L, 0, 0, 0);
     if (handle->player == NULL || handle->length_counter == NULL)
     {
+        memory_set_usage(prev_usage);
         Handle_set_error(NULL, ERROR_MEMORY, "Couldn't allocate memory");
         Handle_deinit(handle);
         return false;
@@ -241,6 +421,8 @@ bool Handle_init(Handle* handle)
 
     Player_reset(handle->player, -1);
 
+    memory_set_usage(prev_usage);
+
     return true;
 }
 
@@ -301,7 +483,11 @@ static bool Handle_update_connections(Handle* handle)
 {
     rassert(handle != NULL);
 
-    if (!Player_prepare_mixing(handle->player))
+    Memory_usage* prev_usage = memory_set_usage(handle->mem_usage);
+    const bool success = Player_prepare_mixing(handle->player);
+    memory_set_usage(prev_usage);
+
+    if (!success)
     {
         Handle_set_error(handle, ERROR_MEMORY,
                 "Couldn't allocate memory for mixing states");
@@ -312,6 +498,66 @@ static bool Handle_update_connections(Handle* handle)
 }
 
 
+static void build_sample_mips(const Audio_unit* au, Background_loader* bkg_loader)
+{
+    rassert(au != NULL);
+    rassert(bkg_loader != NULL);
+
+    Proc_table* procs = Audio_unit_get_procs(au);
+    for (int proc_index = 0; proc_index < KQT_PROCESSORS_MAX; ++proc_index)
+    {
+        const Processor* proc = Proc_table_get_proc(procs, proc_index);
+        if ((proc == NULL) || !Device_is_existent((const Device*)proc))
+            continue;
+
+        const Device_impl* dimpl = Device_get_impl((const Device*)proc);
+        if ((dimpl == NULL) || (dimpl->proc_type != Proc_type_sample))
+            continue;
+
+        const Proc_sample* sample_p = (const Proc_sample*)dimpl;
+        if (sample_p->use_mipmaps)
+            Device_params_build_sample_mips(((const Device*)proc)->dparams, bkg_loader);
+    }
+
+    return;
+}
+
+
+static void Handle_build_sample_mips(Handle* handle, const Validation_scope* scope)
+{
+    rassert(handle != NULL);
+    rassert(scope != NULL);
+
+    Memory_usage* prev_usage = memory_set_usage(handle->mem_usage);
+    const Memory_category prev_category = memory_set_category(MEMORY_CATEGORY_SAMPLES);
+
+    Au_table* au_table = Module_get_au_table(handle->module);
+    for (int au_index = 0; au_index < KQT_AUDIO_UNITS_MAX; ++au_index)
+    {
+        if (!scope->check_all && !scope->check_aus[au_index])
+            continue;
+
+        const Audio_unit* au = Au_table_get(au_table, au_index);
+        if ((au == NULL) || !Device_is_existent((const Device*)au))
+            continue;
+
+        build_sample_mips(au, handle->bkg_loader);
+
+        for (int sub_au_index = 0; sub_au_index < KQT_AUDIO_UNITS_MAX; ++sub_au_index)
+        {
+            const Audio_unit* sub_au = Audio_unit_get_au(au, sub_au_index);
+            if ((sub_au != NULL) && Device_is_existent((const Device*)sub_au))
+                build_sample_mips(sub_au, handle->bkg_loader);
+        }
+    }
+
+    memory_set_category(prev_category);
+    memory_set_usage(prev_usage);
+
+    return;
+}
+
+
 #define set_invalid_if(cond, ...)                           \
     if (true)                                               \
     {                                                       \
@@ -353,8 +599,19 @@ int kqt_Handle_validate(kqt_Handle handle)
     }
     Background_loader_reset(h->bkg_loader);
 
+    const Validation_scope* scope = &h->validation_scope;
+    const bool check_sheet = scope->check_all || scope->check_sheet;
+
+    bool check_any_pats = check_sheet;
+    for (int i = 0; (i < KQT_PATTERNS_MAX) && !check_any_pats; ++i)
+        check_any_pats = scope->check_pats[i];
+
+    bool check_any_aus = scope->check_all;
+    for (int i = 0; (i < KQT_AUDIO_UNITS_MAX) && !check_any_aus; ++i)
+        check_any_aus = scope->check_aus[i];
+
     // Check album
-    if (h->module->album_is_existent)
+    if (check_sheet && h->module->album_is_existent)
     {
         const Track_list* tl = h->module->track_list;
         set_invalid_if(
@@ -366,27 +623,30 @@ int kqt_Handle_validate(kqt_Handle handle)
     }
 
     // Check songs
-    for (int i = 0; i < KQT_SONGS_MAX; ++i)
+    for (int i = 0; (i < KQT_SONGS_MAX) && check_any_pats; ++i)
     {
         if (!Song_table_get_existent(h->module->songs, i))
             continue;
 
-        // Check for orphans
-        const Track_list* tl = h->module->track_list;
-        set_invalid_if(
-                !h->module->album_is_existent || tl == NULL,
-                "Module contains song %d but no album", i);
-
-        bool found = false;
-        for (int k = 0; k < Track_list_get_len(tl); ++k)
+        if (check_sheet)
         {
-            if (Track_list_get_song_index(tl, k) == i)
+            // Check for orphans
+            const Track_list* tl = h->module->track_list;
+            set_invalid_if(
+                    !h->module->album_is_existent || tl == NULL,
+                    "Module contains song %d but no album", i);
+
+            bool found = false;
+            for (int k = 0; k < Track_list_get_len(tl); ++k)
             {
-                found = true;
-                break;
+                if (Track_list_get_song_index(tl, k) == i)
+                {
+                    found = true;
+                    break;
+                }
             }
+            set_invalid_if(!found, "Song %d is not included in the album", i);
         }
-        set_invalid_if(!found, "Song %d is not included in the album", i);
 
         // Check for empty songs
         const Order_list* ol = h->module->order_lists[i];
@@ -398,6 +658,9 @@ int kqt_Handle_validate(kqt_Handle handle)
         for (int system = 0; system < Order_list_get_len(ol); ++system)
         {
             const Pat_inst_ref* piref = Order_list_get_pat_inst_ref(ol, system);
+            if (!check_sheet && !scope->check_pats[piref->pat])
+                continue;
+
             Pattern* pat = Pat_table_get(h->module->pats, piref->pat);
 
             set_invalid_if(
@@ -410,7 +673,7 @@ int kqt_Handle_validate(kqt_Handle handle)
     }
 
     // Check for nonexistent songs in the track list
-    if (h->module->album_is_existent)
+    if (check_sheet && h->module->album_is_existent)
     {
         const Track_list* tl = h->module->track_list;
         rassert(tl != NULL);
@@ -425,8 +688,11 @@ int kqt_Handle_validate(kqt_Handle handle)
     }
 
     // Check existing patterns
-    for (int i = 0; i < KQT_PATTERNS_MAX; ++i)
+    for (int i = 0; (i < KQT_PATTERNS_MAX) && check_any_pats; ++i)
     {
+        if (!check_sheet && !scope->check_pats[i])
+            continue;
+
         if (!Pat_table_get_existent(h->module->pats, i))
             continue;
 
@@ -435,6 +701,33 @@ int kqt_Handle_validate(kqt_Handle handle)
                 pat == NULL,
                 "Pattern %d exists but contains no data", i);
 
+        // Count the occurrences of each instance in the album
+        uint8_t inst_uses[KQT_PAT_INSTANCES_MAX] = { 0 };
+        if (h->module->album_is_existent)
+        {
+            const Track_list* tl = h->module->track_list;
+            rassert(tl != NULL);
+
+            for (int track = 0; track < Track_list_get_len(tl); ++track)
+            {
+                const int song_index = Track_list_get_song_index(tl, track);
+
+                if (!Song_table_get_existent(h->module->songs, song_index))
+                    continue;
+
+                const Order_list* ol = h->module->order_lists[song_index];
+                rassert(ol != NULL);
+
+                for (int system = 0; system < Order_list_get_len(ol); ++system)
+                {
+                    const Pat_inst_ref* piref =
+                        Order_list_get_pat_inst_ref(ol, system);
+                    if ((piref->pat == i) && (inst_uses[piref->inst] < 2))
+                        ++inst_uses[piref->inst];
+                }
+            }
+        }
+
         bool pattern_has_instance = false;
         for (int k = 0; k < KQT_PAT_INSTANCES_MAX; ++k)
         {
@@ -449,38 +742,13 @@ int kqt_Handle_validate(kqt_Handle handle)
                         "Pattern instance [%d, %d] exists but no album"
                         " is present", i, k);
 
-                bool instance_found = false;
-
-                const Track_list* tl = h->module->track_list;
-                rassert(tl != NULL);
-
-                for (int track = 0; track < Track_list_get_len(tl); ++track)
-                {
-                    const int song_index = Track_list_get_song_index(tl, track);
-
-                    if (!Song_table_get_existent(h->module->songs, song_index))
-                        continue;
-
-                    const Order_list* ol = h->module->order_lists[song_index];
-                    rassert(ol != NULL);
-
-                    for (int system = 0; system < Order_list_get_len(ol); ++system)
-                    {
-                        const Pat_inst_ref* piref =
-                            Order_list_get_pat_inst_ref(ol, system);
-                        if (piref->pat == i && piref->inst == k)
-                        {
-                            set_invalid_if(
-                                    instance_found,
-                                    "Duplicate occurrence of pattern instance"
-                                    " [%d, %d]", i, k);
-                            instance_found = true;
-                        }
-                    }
-                }
+                set_invalid_if(
+                        inst_uses[k] > 1,
+                        "Duplicate occurrence of pattern instance"
+                        " [%d, %d]", i, k);
 
                 set_invalid_if(
-                        !instance_found,
+                        inst_uses[k] == 0,
                         "Pattern instance [%d, %d] exists but is not used",
                         i, k);
             }
@@ -492,7 +760,7 @@ int kqt_Handle_validate(kqt_Handle handle)
     }
 
     // Check controls
-    if (h->module->au_map != NULL)
+    if ((scope->check_all || scope->check_controls) && (h->module->au_map != NULL))
     {
         set_invalid_if(
                 !Input_map_is_valid(h->module->au_map, h->module->au_controls),
@@ -507,6 +775,9 @@ int kqt_Handle_validate(kqt_Handle handle)
         Au_table* au_table = Module_get_au_table(h->module);
         for (int au_index = 0; au_index < KQT_AUDIO_UNITS_MAX; ++au_index)
         {
+            if (!scope->check_all && !scope->check_aus[au_index])
+                continue;
+
             const Audio_unit* au = Au_table_get(au_table, au_index);
             if ((au != NULL) && Device_is_existent((const Device*)au))
             {
@@ -568,6 +839,9 @@ int kqt_Handle_validate(kqt_Handle handle)
         Au_table* au_table = Module_get_au_table(h->module);
         for (int au_index = 0; au_index < KQT_AUDIO_UNITS_MAX; ++au_index)
         {
+            if (!scope->check_all && !scope->check_aus[au_index])
+                continue;
+
             const Audio_unit* au = Au_table_get(au_table, au_index);
             if ((au != NULL) && Device_is_existent((const Device*)au))
             {
@@ -601,7 +875,8 @@ int kqt_Handle_validate(kqt_Handle handle)
         }
 
         // Top-level connections
-        if (h->module->connections != NULL)
+        if ((scope->check_all || scope->check_top_level_connections || check_any_aus) &&
+                (h->module->connections != NULL))
         {
             set_invalid_if(
                     !Connections_check_connections(
@@ -616,6 +891,9 @@ int kqt_Handle_validate(kqt_Handle handle)
         Au_table* au_table = Module_get_au_table(h->module);
         for (int au_index = 0; au_index < KQT_AUDIO_UNITS_MAX; ++au_index)
         {
+            if (!scope->check_all && !scope->check_aus[au_index])
+                continue;
+
             const Audio_unit* au = Au_table_get(au_table, au_index);
             if ((au != NULL) && Device_is_existent((const Device*)au))
             {
@@ -654,6 +932,9 @@ int kqt_Handle_validate(kqt_Handle handle)
         Au_table* au_table = Module_get_au_table(h->module);
         for (int au_index = 0; au_index < KQT_AUDIO_UNITS_MAX; ++au_index)
         {
+            if (!scope->check_all && !scope->check_aus[au_index])
+                continue;
+
             const Audio_unit* au = Au_table_get(au_table, au_index);
             if ((au != NULL) && Device_is_existent((const Device*)au))
             {
@@ -667,8 +948,20 @@ int kqt_Handle_validate(kqt_Handle handle)
         }
     }
 
-    // Data is OK
-    h->data_is_validated = true;
+    // Build the mip levels needed by sample processors
+    Handle_build_sample_mips(h, scope);
+    Background_loader_wait_idle(h->bkg_loader);
+    bkg_error = Background_loader_get_first_error(h->bkg_loader);
+    if (bkg_error != NULL)
+    {
+        Error* bkg_error_copy = ERROR_AUTO;
+        Error_copy(bkg_error_copy, bkg_error);
+
+        Background_loader_reset(h->bkg_loader);
+
+        set_invalid_if(true, bkg_error_copy->message);
+    }
+    Background_loader_reset(h->bkg_loader);
 
     // Update connections if needed
     if (h->update_connections)
@@ -679,6 +972,10 @@ int kqt_Handle_validate(kqt_Handle handle)
         h->update_connections = false;
     }
 
+    // Data is OK
+    h->data_is_validated = true;
+    Validation_scope_init(&h->validation_scope, false);
+
     return 1;
 }
 
@@ -826,6 +1123,207 @@ bool key_is_valid(Handle* handle, const char* key)
 }
 
 
+static const char* memory_category_names[MEMORY_CATEGORY_COUNT] =
+{
+    [MEMORY_CATEGORY_OTHER] = "other",
+    [MEMORY_CATEGORY_SAMPLES] = "samples",
+    [MEMORY_CATEGORY_PADSYNTH] = "padsynth",
+    [MEMORY_CATEGORY_VOICES] = "voices",
+    [MEMORY_CATEGORY_WORK_BUFFERS] = "work_buffers",
+    [MEMORY_CATEGORY_DEVICE_STATES] = "device_states",
+    [MEMORY_CATEGORY_PATTERNS] = "patterns",
+};
+
+
+#define MEMORY_REPORT_INIT_CAPACITY 4096
+
+
+typedef struct Memory_report
+{
+    char* data;
+    int64_t length;
+    int64_t capacity;
+    bool is_valid;
+} Memory_report;
+
+
+static void Memory_report_append(Memory_report* report, const char* format, ...)
+{
+    rassert(report != NULL);
+    rassert(format != NULL);
+
+    if (!report->is_valid)
+        return;
+
+    while (true)
+    {
+        const int64_t space = report->capacity - report->length;
+
+        va_list args;
+        va_start(args, format);
+        const int printed =
+            vsnprintf(report->data + report->length, (size_t)space, format, args);
+        va_end(args);
+        rassert(printed >= 0);
+
+        if (printed < space)
+        {
+            report->length += printed;
+            return;
+        }
+
+        int64_t new_capacity = report->capacity * 2;
+        if (new_capacity <= report->length + printed)
+            new_capacity = report->length + printed + 1;
+
+        char* new_data = memory_realloc_items(char, new_capacity, report->data);
+        if (new_data == NULL)
+        {
+            report->is_valid = false;
+            return;
+        }
+
+        report->data = new_data;
+        report->capacity = new_capacity;
+    }
+}
+
+
+static void Memory_report_append_usage(Memory_report* report, const Memory_usage* usage)
+{
+    rassert(report != NULL);
+    rassert(usage != NULL);
+
+    Memory_report_append(
+            report, "\"total\": %" PRId64 ", \"subsystems\": {",
+            Memory_usage_get_total_size(usage));
+
+    for (int i = 0; i < MEMORY_CATEGORY_COUNT; ++i)
+        Memory_report_append(
+                report,
+                "%s\"%s\": %" PRId64,
+                (i > 0) ? ", " : "",
+                memory_category_names[i],
+                Memory_usage_get_size(usage, (Memory_category)i));
+
+    Memory_report_append(report, "}");
+
+    return;
+}
+
+
+static void Memory_report_append_au(Memory_report* report, const Audio_unit* au)
+{
+    rassert(report != NULL);
+    rassert(au != NULL);
+
+    Memory_report_append(report, "{");
+    Memory_report_append_usage(
+            report, Device_get_memory_usage((const Device*)au));
+
+    Memory_report_append(report, ", \"processors\": {");
+    bool is_first = true;
+    for (int i = 0; i < KQT_PROCESSORS_MAX; ++i)
+    {
+        const Processor* proc = Audio_unit_get_proc(au, i);
+        if (proc == NULL)
+            continue;
+
+        Memory_report_append(report, "%s\"proc_%02x\": {", is_first ? "" : ", ", i);
+        Memory_report_append_usage(
+                report, Device_get_memory_usage((const Device*)proc));
+        Memory_report_append(report, "}");
+        is_first = false;
+    }
+
+    Memory_report_append(report, "}, \"audio_units\": {");
+    is_first = true;
+    for (int i = 0; i < KQT_AUDIO_UNITS_MAX; ++i)
+    {
+        const Audio_unit* sub_au = Audio_unit_get_au(au, i);
+        if (sub_au == NULL)
+            continue;
+
+        Memory_report_append(report, "%s\"au_%02x\": ", is_first ? "" : ", ", i);
+        Memory_report_append_au(report, sub_au);
+        is_first = false;
+    }
+
+    Memory_report_append(report, "}}");
+
+    return;
+}
+
+
+static char* make_memory_report(const Handle* handle)
+{
+    rassert(handle != NULL);
+
+    Memory_report* report = &(Memory_report){
+        .data = NULL, .length = 0, .capacity = 0, .is_valid = true };
+
+    report->data = memory_alloc_items(char, MEMORY_REPORT_INIT_CAPACITY);
+    if (report->data == NULL)
+        return NULL;
+    report->capacity = MEMORY_REPORT_INIT_CAPACITY;
+    report->data[0] = '\0';
+
+    Memory_report_append(report, "{");
+    Memory_report_append_usage(report, handle->mem_usage);
+
+    Memory_report_append(report, ", \"audio_units\": {");
+    bool is_first = true;
+    Au_table* au_table = Module_get_au_table(handle->module);
+    for (int i = 0; i < KQT_AUDIO_UNITS_MAX; ++i)
+    {
+        const Audio_unit* au = Au_table_get(au_table, i);
+        if (au == NULL)
+            continue;
+
+        Memory_report_append(report, "%s\"au_%02x\": ", is_first ? "" : ", ", i);
+        Memory_report_append_au(report, au);
+        is_first = false;
+    }
+
+    Memory_report_append(report, "}, \"shared\": {");
+    Memory_report_append_usage(report, memory_get_shared_usage());
+    Memory_report_append(report, "}}");
+
+    if (!report->is_valid)
+    {
+        memory_free(report->data);
+        return NULL;
+    }
+
+    return report->data;
+}
+
+
+const char* kqt_Handle_get_memory_usage(kqt_Handle handle)
+{
+    check_handle(handle, NULL);
+
+    Handle* h = get_handle(handle);
+    check_data_is_valid(h, NULL);
+
+    // The report is not included in the memory usage of the Handle
+    Memory_usage* prev_usage = memory_set_usage(NULL);
+
+    memory_free(h->memory_report);
+    h->memory_report = make_memory_report(h);
+
+    memory_set_usage(prev_usage);
+
+    if (h->memory_report == NULL)
+    {
+        Handle_set_error(h, ERROR_MEMORY, "Couldn't allocate memory for memory usage");
+        return NULL;
+    }
+
+    return h->memory_report;
+}
+
+
 Module* Handle_get_module(Handle* handle)
 {
     rassert(handle != NULL);
@@ -843,9 +1341,17 @@ void Handle_deinit(Handle* handle)
     handle->player = NULL;
 
     del_Background_loader(handle->bkg_loader);
+    handle->bkg_loader = NULL;
+    del_Snapshot(handle->snapshot);
+    handle->snapshot = NULL;
     del_Module(handle->module);
     handle->module = NULL;
 
+    memory_free(handle->memory_report);
+    handle->memory_report = NULL;
+    del_Memory_usage(handle->mem_usage);
+    handle->mem_usage = NULL;
+
     return;
 }
 
@@ -1,7 +1,7 @@
 
 
 /*
- * Author: Tomi Jylhä-Ollila, Finland 2010-2018
+ * Author: Tomi Jylhä-Ollila, Finland 2010-2019
  *
  * This file is part of Kunquat.
  *
@@ -21,11 +21,13 @@
 #include <kunquat/Player.h>
 #include <kunquat/limits.h>
 #include <mathnum/common.h>
+#include <memory.h>
 #include <string/common.h>
 
 #include <inttypes.h>
 #include <limits.h>
 #include <math.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
@@ -45,7 +47,11 @@ int kqt_Handle_play(kqt_Handle handle, long nframes)
         return 0;
     }
 
+    Memory_usage* prev_usage = memory_set_usage(h->mem_usage);
+    memory_enter_render_path();
     Player_play(h->player, (int32_t)min(nframes, KQT_AUDIO_BUFFER_SIZE_MAX));
+    memory_leave_render_path();
+    memory_set_usage(prev_usage);
 
     return 1;
 }
@@ -97,7 +103,11 @@ int kqt_Handle_set_player_thread_count(kqt_Handle handle, int count)
 
     Error* error = ERROR_AUTO;
 
-    if (!Player_set_thread_count(h->player, count, error))
+    Memory_usage* prev_usage = memory_set_usage(h->mem_usage);
+    const bool success = Player_set_thread_count(h->player, count, error);
+    memory_set_usage(prev_usage);
+
+    if (!success)
     {
         Handle_set_error_from_Error(h, error);
         return 0;
@@ -119,6 +129,97 @@ int kqt_Handle_get_player_thread_count(kqt_Handle handle)
 }
 
 
+int kqt_Handle_set_voice_pool_size(kqt_Handle handle, int size)
+{
+    check_handle(handle, 0);
+
+    Handle* h = get_handle(handle);
+    check_data_is_valid(h, 0);
+    check_data_is_validated(h, 0);
+
+    if (size < 1)
+    {
+        Handle_set_error(h, ERROR_ARGUMENT, "Voice pool size must be positive");
+        return 0;
+    }
+    if (size > KQT_VOICES_MAX)
+    {
+        Handle_set_error(
+                h, ERROR_ARGUMENT, "Voice pool size must not exceed %d", KQT_VOICES_MAX);
+        return 0;
+    }
+
+    Memory_usage* prev_usage = memory_set_usage(h->mem_usage);
+    const bool success = Player_set_voice_pool_size(h->player, size);
+    memory_set_usage(prev_usage);
+
+    if (!success)
+    {
+        Handle_set_error(h, ERROR_MEMORY, "Couldn't allocate memory for voices");
+        return 0;
+    }
+
+    return 1;
+}
+
+
+int kqt_Handle_get_voice_pool_size(kqt_Handle handle)
+{
+    check_handle(handle, 0);
+
+    Handle* h = get_handle(handle);
+    check_data_is_valid(h, 0);
+    check_data_is_validated(h, 0);
+
+    return Player_get_voice_pool_size(h->player);
+}
+
+
+int kqt_Handle_set_voice_governor_budget(kqt_Handle handle, long long nanoseconds)
+{
+    check_handle(handle, 0);
+
+    Handle* h = get_handle(handle);
+    check_data_is_valid(h, 0);
+    check_data_is_validated(h, 0);
+
+    if (nanoseconds < 0)
+    {
+        Handle_set_error(
+                h, ERROR_ARGUMENT, "Voice governor budget must not be negative");
+        return 0;
+    }
+
+    Player_set_voice_governor_budget(h->player, (int64_t)nanoseconds);
+
+    return 1;
+}
+
+
+long long kqt_Handle_get_voice_governor_budget(kqt_Handle handle)
+{
+    check_handle(handle, -1);
+
+    Handle* h = get_handle(handle);
+    check_data_is_valid(h, -1);
+    check_data_is_validated(h, -1);
+
+    return Player_get_voice_governor_budget(h->player);
+}
+
+
+long long kqt_Handle_get_voice_governor_intervention_count(kqt_Handle handle)
+{
+    check_handle(handle, -1);
+
+    Handle* h = get_handle(handle);
+    check_data_is_valid(h, -1);
+    check_data_is_validated(h, -1);
+
+    return Player_get_voice_governor_intervention_count(h->player);
+}
+
+
 int kqt_Handle_set_audio_rate(kqt_Handle handle, long rate)
 {
     check_handle(handle, 0);
@@ -140,7 +241,11 @@ int kqt_Handle_set_audio_rate(kqt_Handle handle, long rate)
     }
 #endif
 
-    if (!Player_set_audio_rate(h->player, (int32_t)rate))
+    Memory_usage* prev_usage = memory_set_usage(h->mem_usage);
+    const bool success = Player_set_audio_rate(h->player, (int32_t)rate);
+    memory_set_usage(prev_usage);
+
+    if (!success)
     {
         Handle_set_error(
                 h, ERROR_MEMORY, "Couldn't allocate memory after change of audio rate.");
@@ -186,7 +291,11 @@ int kqt_Handle_set_audio_buffer_size(kqt_Handle handle, long size)
         return 0;
     }
 
-    if (!Player_set_audio_buffer_size(h->player, (int32_t)size))
+    Memory_usage* prev_usage = memory_set_usage(h->mem_usage);
+    const bool success = Player_set_audio_buffer_size(h->player, (int32_t)size);
+    memory_set_usage(prev_usage);
+
+    if (!success)
     {
         Handle_set_error(h, ERROR_MEMORY, "Couldn't allocate memory for new buffers");
         return 0;
@@ -248,8 +357,10 @@ long long kqt_Handle_get_duration(kqt_Handle handle, int track)
         return -1;
     }
 
+    Memory_usage* prev_usage = memory_set_usage(h->mem_usage);
     Player_reset(h->length_counter, track);
     Player_skip(h->length_counter, KQT_CALC_DURATION_MAX);
+    memory_set_usage(prev_usage);
 
     return Player_get_nanoseconds(h->length_counter);
 }
@@ -279,8 +390,10 @@ int kqt_Handle_set_position(kqt_Handle handle, int track, long long nanoseconds)
 
     Device_states_reset(Player_get_device_states(h->player));
 
+    Memory_usage* prev_usage = memory_set_usage(h->mem_usage);
     Player_reset(h->player, track);
     Player_skip(h->player, skip_frames);
+    memory_set_usage(prev_usage);
 
     return 1;
 }
@@ -351,7 +464,14 @@ int kqt_Handle_fire_event(kqt_Handle handle, int channel, const char* event)
     }
 
     Streader* sr = Streader_init(STREADER_AUTO, event, (int64_t)length);
-    if (!Player_fire(h->player, channel, sr))
+
+    Memory_usage* prev_usage = memory_set_usage(h->mem_usage);
+    memory_enter_render_path();
+    const bool success = Player_fire(h->player, channel, sr);
+    memory_leave_render_path();
+    memory_set_usage(prev_usage);
+
+    if (!success)
     {
         rassert(Streader_is_error_set(sr));
         Handle_set_error(
@@ -374,7 +494,11 @@ const char* kqt_Handle_receive_events(kqt_Handle handle)
     check_data_is_valid(h, 0);
     check_data_is_validated(h, 0);
 
-    return Player_get_events(h->player);
+    memory_enter_render_path();
+    const char* events = Player_get_events(h->player);
+    memory_leave_render_path();
+
+    return events;
 }
 
 
@@ -1,7 +1,7 @@
 
 
 /*
- * Author: Tomi Jylhä-Ollila, Finland 2010-2018
+ * Author: Tomi Jylhä-Ollila, Finland 2010-2019
  *
  * This file is part of Kunquat.
  *
@@ -21,7 +21,10 @@
 #include <Error.h>
 #include <init/Background_loader.h>
 #include <init/Module.h>
+#include <init/Snapshot.h>
+#include <kunquat/limits.h>
 #include <kunquat/Player.h>
+#include <memory.h>
 #include <player/Player.h>
 
 #include <stdbool.h>
@@ -39,19 +42,38 @@ typedef enum
 } Error_delay_type;
 
 
+/**
+ * Parts of the module data that need to be checked in the next validation.
+ */
+typedef struct Validation_scope
+{
+    bool check_all;
+    bool check_sheet; ///< Album, songs and order lists
+    bool check_controls;
+    bool check_top_level_connections;
+    bool check_pats[KQT_PATTERNS_MAX];
+    bool check_aus[KQT_AUDIO_UNITS_MAX];
+} Validation_scope;
+
+
 typedef struct Handle
 {
     bool data_is_valid;
     bool data_is_validated;
     bool update_connections;
+    Validation_scope validation_scope;
     Module* module;
     Background_loader* bkg_loader;
+    Snapshot* snapshot;
     Error error;
     Error validation_error;
     char position[POSITION_LENGTH];
 
     Player* player;
     Player* length_counter;
+
+    Memory_usage* mem_usage;
+    char* memory_report;
 } Handle;
 
 
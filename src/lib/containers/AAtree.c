@@ -1,7 +1,7 @@
 
 
 /*
- * Author: Tomi Jylhä-Ollila, Finland 2010-2017
+ * Author: Tomi Jylhä-Ollila, Finland 2010-2019
  *
  * This file is part of Kunquat.
  *
@@ -14,6 +14,7 @@
 
 #include <containers/AAtree.h>
 
+#include <containers/Arena.h>
 #include <debug/assert.h>
 #include <mathnum/common.h>
 #include <memory.h>
@@ -38,6 +39,7 @@ struct AAtree
     AAnode* root;
     AAtree_item_cmp* cmp;
     AAtree_item_destroy* destroy;
+    Arena* arena;
 };
 
 
@@ -49,7 +51,7 @@ static AAnode* aaskew(AAnode* root);
 
 static AAnode* aasplit(AAnode* root);
 
-static void aafree(AAnode* node, void (*destroy)(void*));
+static void aafree(AAnode* node, void (*destroy)(void*), bool free_nodes);
 
 #ifdef ENABLE_DEBUG_ASSERTS
 #define aavalidate(node, msg) (dassert(aavalidate_(node, msg)))
@@ -71,12 +73,13 @@ AAiter* AAiter_init(AAiter* iter, const AAtree* tree)
 }
 
 
-static AAnode* new_AAnode(AAnode* nil, void* data)
+static AAnode* new_AAnode(Arena* arena, AAnode* nil, void* data)
 {
     rassert(implies(nil == NULL, data == NULL));
     rassert(implies(data == NULL, nil == NULL));
 
-    AAnode* node = memory_alloc_item(AAnode);
+    AAnode* node = (arena != NULL)
+        ? Arena_alloc_item(arena, AAnode) : memory_alloc_item(AAnode);
     if (node == NULL)
         return NULL;
 
@@ -115,7 +118,7 @@ AAtree* new_AAtree(AAtree_item_cmp* cmp, AAtree_item_destroy* destroy)
     if (tree == NULL)
         return NULL;
 
-    tree->nil = new_AAnode(NULL, NULL);
+    tree->nil = new_AAnode(NULL, NULL, NULL);
     if (tree->nil == NULL)
     {
         memory_free(tree);
@@ -125,6 +128,31 @@ AAtree* new_AAtree(AAtree_item_cmp* cmp, AAtree_item_destroy* destroy)
     tree->root = tree->nil;
     tree->cmp = cmp;
     tree->destroy = destroy;
+    tree->arena = NULL;
+    aavalidate(tree->root, "init");
+
+    return tree;
+}
+
+
+AAtree* new_AAtree_in_arena(
+        Arena* arena, AAtree_item_cmp* cmp, AAtree_item_destroy* destroy)
+{
+    rassert(arena != NULL);
+    rassert(cmp != NULL);
+
+    AAtree* tree = Arena_alloc_item(arena, AAtree);
+    if (tree == NULL)
+        return NULL;
+
+    tree->nil = new_AAnode(arena, NULL, NULL);
+    if (tree->nil == NULL)
+        return NULL;
+
+    tree->root = tree->nil;
+    tree->cmp = cmp;
+    tree->destroy = destroy;
+    tree->arena = arena;
     aavalidate(tree->root, "init");
 
     return tree;
@@ -146,7 +174,7 @@ bool AAtree_ins(AAtree* tree, void* data)
     rassert(data != NULL);
     rassert(!AAtree_contains(tree, data));
 
-    AAnode* node = new_AAnode(tree->nil, data);
+    AAnode* node = new_AAnode(tree->arena, tree->nil, data);
     if (node == NULL)
         return false;
 
@@ -532,7 +560,8 @@ void* AAtree_remove(AAtree* tree, const void* key)
         return NULL;
 
     void* data = node->data;
-    memory_free(node);
+    if (tree->arena == NULL)
+        memory_free(node);
 
     return data;
 }
@@ -545,7 +574,12 @@ void AAtree_clear(AAtree* tree)
 
     if (tree->root != tree->nil)
     {
-        aafree(tree->root, tree->destroy);
+        // Nodes allocated from an Arena are released along with the Arena
+        if (tree->arena == NULL)
+            aafree(tree->root, tree->destroy, true);
+        else if (tree->destroy != NULL)
+            aafree(tree->root, tree->destroy, false);
+
         tree->root = tree->nil;
     }
 
@@ -560,6 +594,9 @@ void del_AAtree(AAtree* tree)
 
     aavalidate(tree->root, "del");
     AAtree_clear(tree);
+    if (tree->arena != NULL)
+        return;
+
     memory_free(tree->nil);
     memory_free(tree);
 
@@ -670,7 +707,7 @@ static AAnode* aasplit(AAnode* root)
 }
 
 
-static void aafree(AAnode* node, void (*destroy)(void*))
+static void aafree(AAnode* node, void (*destroy)(void*), bool free_nodes)
 {
     rassert(node != NULL);
     rassert(destroy != NULL);
@@ -678,10 +715,11 @@ static void aafree(AAnode* node, void (*destroy)(void*))
     if (node->level == 0)
         return;
 
-    aafree(node->left, destroy);
-    aafree(node->right, destroy);
+    aafree(node->left, destroy, free_nodes);
+    aafree(node->right, destroy, free_nodes);
     destroy(node->data);
-    memory_free(node);
+    if (free_nodes)
+        memory_free(node);
 
     return;
 }
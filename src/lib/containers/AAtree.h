@@ -1,7 +1,7 @@
 
 
 /*
- * Author: Tomi Jylhä-Ollila, Finland 2010-2016
+ * Author: Tomi Jylhä-Ollila, Finland 2010-2019
  *
  * This file is part of Kunquat.
  *
@@ -16,6 +16,8 @@
 #define KQT_AATREE_H
 
 
+#include <decl.h>
+
 #include <stdbool.h>
 #include <stdlib.h>
 
@@ -132,6 +134,26 @@ void* AAnode_get_data(AAnode* node);
 AAtree* new_AAtree(AAtree_item_cmp* cmp, AAtree_item_destroy* destroy);
 
 
+/**
+ * Create a new AAtree that allocates its nodes from an Arena.
+ *
+ * The tree and its nodes are released along with \a arena. Calling
+ * \a del_AAtree is only needed if the stored elements must be destroyed
+ * separately.
+ *
+ * \param arena     The Arena -- must not be \c NULL.
+ * \param cmp       The comparison function for stored elements -- must not be
+ *                  \c NULL.
+ * \param destroy   The destructor for stored elements, or \c NULL if the
+ *                  elements do not need to be destroyed.
+ *
+ * \return   The new AAtree if successful, or \c NULL if memory allocation
+ *           failed.
+ */
+AAtree* new_AAtree_in_arena(
+        Arena* arena, AAtree_item_cmp* cmp, AAtree_item_destroy* destroy);
+
+
 /**
  * Find out if a key exists inside the AAtree.
  *
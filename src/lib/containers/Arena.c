@@ -0,0 +1,138 @@
+
+
+/*
+ * Author: agent, 2026
+ *
+ * This file is part of Kunquat.
+ *
+ * CC0 1.0 Universal, http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * To the extent possible under law, Kunquat Affirmers have waived all
+ * copyright and related or neighboring rights to Kunquat.
+ */
+
+
+#include <containers/Arena.h>
+
+#include <debug/assert.h>
+#include <mathnum/common.h>
+#include <memory.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+
+#define ARENA_ALIGNMENT ((int64_t)_Alignof(max_align_t))
+
+#define ARENA_CHUNK_SIZE_MIN 128
+#define ARENA_CHUNK_SIZE_MAX 65536
+
+
+typedef struct Arena_chunk
+{
+    struct Arena_chunk* next;
+    int64_t size;
+    int64_t used;
+} Arena_chunk;
+
+
+// Chunk contents start after the header, rounded up to the arena alignment
+#define ARENA_CHUNK_HEADER_SIZE \
+    (((int64_t)sizeof(Arena_chunk) + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1))
+
+
+struct Arena
+{
+    Arena_chunk* chunks;
+    int64_t next_chunk_size;
+    int64_t total_size;
+};
+
+
+Arena* new_Arena(void)
+{
+    Arena* arena = memory_alloc_item(Arena);
+    if (arena == NULL)
+        return NULL;
+
+    arena->chunks = NULL;
+    arena->next_chunk_size = ARENA_CHUNK_SIZE_MIN;
+    arena->total_size = 0;
+
+    return arena;
+}
+
+
+void* Arena_alloc(Arena* arena, int64_t size)
+{
+    rassert(arena != NULL);
+    rassert(size > 0);
+
+    const int64_t aligned_size = (size + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+
+    Arena_chunk* chunk = arena->chunks;
+    if ((chunk != NULL) && (chunk->size - chunk->used >= aligned_size))
+    {
+        char* block = (char*)chunk + ARENA_CHUNK_HEADER_SIZE + chunk->used;
+        chunk->used += aligned_size;
+        return block;
+    }
+
+    const bool is_oversized = (aligned_size > arena->next_chunk_size);
+    const int64_t chunk_size = is_oversized ? aligned_size : arena->next_chunk_size;
+
+    Arena_chunk* new_chunk = memory_alloc(ARENA_CHUNK_HEADER_SIZE + chunk_size);
+    if (new_chunk == NULL)
+        return NULL;
+
+    new_chunk->size = chunk_size;
+    new_chunk->used = aligned_size;
+    arena->total_size += ARENA_CHUNK_HEADER_SIZE + chunk_size;
+
+    if (is_oversized && (chunk != NULL))
+    {
+        // Keep allocating from the current chunk as it may still have room
+        new_chunk->next = chunk->next;
+        chunk->next = new_chunk;
+    }
+    else
+    {
+        new_chunk->next = chunk;
+        arena->chunks = new_chunk;
+        if (!is_oversized)
+            arena->next_chunk_size =
+                min(arena->next_chunk_size * 2, ARENA_CHUNK_SIZE_MAX);
+    }
+
+    return (char*)new_chunk + ARENA_CHUNK_HEADER_SIZE;
+}
+
+
+int64_t Arena_get_size(const Arena* arena)
+{
+    rassert(arena != NULL);
+    return arena->total_size;
+}
+
+
+void del_Arena(Arena* arena)
+{
+    if (arena == NULL)
+        return;
+
+    Arena_chunk* chunk = arena->chunks;
+    while (chunk != NULL)
+    {
+        Arena_chunk* next = chunk->next;
+        memory_free(chunk);
+        chunk = next;
+    }
+
+    memory_free(arena);
+
+    return;
+}
+
+
@@ -0,0 +1,82 @@
+
+
+/*
+ * Author: agent, 2026
+ *
+ * This file is part of Kunquat.
+ *
+ * CC0 1.0 Universal, http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * To the extent possible under law, Kunquat Affirmers have waived all
+ * copyright and related or neighboring rights to Kunquat.
+ */
+
+
+#ifndef KQT_ARENA_H
+#define KQT_ARENA_H
+
+
+#include <decl.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+
+
+/**
+ * Arena is a region allocator for objects that share a single lifetime, such
+ * as the contents of one parsed key. Objects are carved out of larger chunks
+ * and released all at once when the Arena is destroyed, so they must not be
+ * passed to \a memory_free.
+ */
+
+
+#define Arena_alloc_item(arena, type) Arena_alloc((arena), (int64_t)sizeof(type))
+#define Arena_alloc_items(arena, type, n) \
+    Arena_alloc((arena), (int64_t)sizeof(type) * (n))
+
+
+/**
+ * Create a new Arena.
+ *
+ * No chunks are allocated until the first call of \a Arena_alloc.
+ *
+ * \return   The new Arena if successful, or \c NULL if memory allocation failed.
+ */
+Arena* new_Arena(void);
+
+
+/**
+ * Allocate a block of memory from the Arena.
+ *
+ * The returned block is suitably aligned for any fundamental type.
+ *
+ * \param arena   The Arena -- must not be \c NULL.
+ * \param size    The amount of bytes to be allocated -- must be > \c 0.
+ *
+ * \return   The starting address of the allocated memory block, or \c NULL if
+ *           memory allocation failed.
+ */
+void* Arena_alloc(Arena* arena, int64_t size);
+
+
+/**
+ * Get the amount of memory reserved by the Arena.
+ *
+ * \param arena   The Arena -- must not be \c NULL.
+ *
+ * \return   The total size of the chunks in bytes.
+ */
+int64_t Arena_get_size(const Arena* arena);
+
+
+/**
+ * Destroy an existing Arena and all memory allocated from it.
+ *
+ * \param arena   The Arena, or \c NULL.
+ */
+void del_Arena(Arena* arena);
+
+
+#endif // KQT_ARENA_H
+
+
@@ -1,7 +1,7 @@
 
 
 /*
- * Author: Tomi Jylhä-Ollila, Finland 2013-2016
+ * Author: Tomi Jylhä-Ollila, Finland 2013-2019
  *
  * This file is part of Kunquat.
  *
@@ -17,6 +17,7 @@
 #include <debug/assert.h>
 #include <mathnum/common.h>
 #include <memory.h>
+#include <player/Player.h>
 
 #include <stdint.h>
 
@@ -34,6 +35,26 @@ long kqt_get_memory_alloc_count(void)
 }
 
 
+void kqt_set_render_alloc_trap(int enabled)
+{
+    memory_set_render_alloc_trap(enabled != 0);
+    return;
+}
+
+
+long kqt_get_render_alloc_count(void)
+{
+    return memory_get_render_alloc_count();
+}
+
+
+void kqt_set_voice_batching(int enabled)
+{
+    Player_set_voice_batching_enabled(enabled != 0);
+    return;
+}
+
+
 void kqt_suppress_assert_messages(void)
 {
     assert_suppress_messages();
@@ -18,6 +18,7 @@
 
 #define DECLS(name) typedef struct name name
 
+DECLS(Arena);
 DECLS(Array);
 DECLS(Au_event_map);
 DECLS(Au_expressions);
@@ -52,6 +53,7 @@ DECLS(Processor);
 DECLS(Random);
 DECLS(Sample);
 DECLS(Sample_params);
+DECLS(Snapshot);
 DECLS(Song);
 DECLS(Streader);
 DECLS(Tstamp);
@@ -19,20 +19,23 @@
 #include <Error.h>
 #include <init/Background_loader.h>
 #include <kunquat/limits.h>
+#include <mathnum/common.h>
 #include <memory.h>
 #include <threads/Condition.h>
 #include <threads/Mutex.h>
 #include <threads/Thread.h>
 
+#include <stdatomic.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 
 
-#define QUEUE_SIZE 32
+#define QUEUE_INIT_CAPACITY 32
 
 
-#define BACKGROUND_LOADER_TASK_AUTO \
-    (&(Background_loader_task){ .process = NULL, .cleanup = NULL, .user_data = NULL })
+#define BACKGROUND_LOADER_TASK_AUTO (&(Background_loader_task){ \
+        .process = NULL, .cleanup = NULL, .user_data = NULL, .size = 0 })
 
 
 typedef enum
@@ -57,15 +60,21 @@ typedef enum
 typedef struct Task_info
 {
     Background_loader_task task;
+    int64_t order;
     Task_info_state state;
     Error error;
+    Memory_usage* mem_usage;
+    Memory_category mem_category;
 } Task_info;
 
 
-#define TASK_INFO_AUTO (&(Task_info){           \
-        .task = *BACKGROUND_LOADER_TASK_AUTO,   \
-        .state = TASK_INFO_EMPTY,               \
-        .error = *ERROR_AUTO,                   \
+#define TASK_INFO_AUTO (&(Task_info){                   \
+        .task = *BACKGROUND_LOADER_TASK_AUTO,           \
+        .order = 0,                                     \
+        .state = TASK_INFO_EMPTY,                       \
+        .error = *ERROR_AUTO,                           \
+        .mem_usage = NULL,                              \
+        .mem_category = MEMORY_CATEGORY_OTHER,          \
     })
 
 
@@ -89,13 +98,29 @@ static void Task_info_init(Task_info* info)
     rassert(info != NULL);
 
     info->task = *BACKGROUND_LOADER_TASK_AUTO;
+    info->order = 0;
     info->state = TASK_INFO_EMPTY;
     info->error = *ERROR_AUTO;
+    info->mem_usage = NULL;
+    info->mem_category = MEMORY_CATEGORY_OTHER;
 
     return;
 }
 
 
+static bool Task_info_precedes(const Task_info* info1, const Task_info* info2)
+{
+    rassert(info1 != NULL);
+    rassert(info2 != NULL);
+
+    // Start smaller tasks first so that cheap work is not stuck behind large tasks
+    if (info1->task.size != info2->task.size)
+        return (info1->task.size < info2->task.size);
+
+    return (info1->order < info2->order);
+}
+
+
 typedef struct Task_worker
 {
     Thread thread;
@@ -115,8 +140,24 @@ static void Task_worker_run_tasks(Task_worker* worker)
         rassert(worker->task_info.state == TASK_INFO_IN_PROGRESS);
         rassert(worker->task_info.task.process != NULL);
 
-        worker->task_info.task.process(
-                &worker->task_info.error, worker->task_info.task.user_data);
+        // Tasks that have not started are only cleaned up after cancellation
+        if (Background_loader_is_cancelled(worker->host))
+            Error_set(
+                    &worker->task_info.error,
+                    ERROR_RESOURCE,
+                    "Background loading was cancelled");
+        else
+        {
+            // Charge allocations to the context that added the task
+            memory_set_usage(worker->task_info.mem_usage);
+            memory_set_category(worker->task_info.mem_category);
+
+            worker->task_info.task.process(
+                    &worker->task_info.error, worker->task_info.task.user_data);
+
+            memory_set_usage(NULL);
+            memory_set_category(MEMORY_CATEGORY_OTHER);
+        }
 
         Background_loader_add_cleanup_task_info(worker->host, &worker->task_info);
 
@@ -190,9 +231,11 @@ static void Task_worker_deinit(Task_worker* worker)
 typedef struct Task_queue
 {
     Mutex lock;
-    int add_index;
-    int fetch_index;
-    Task_info tasks[QUEUE_SIZE];
+    bool is_closed;
+    int64_t next_order;
+    int64_t count;
+    int64_t capacity;
+    Task_info* tasks;
 } Task_queue;
 
 
@@ -206,37 +249,87 @@ static void Task_queue_init(Task_queue* queue)
     Mutex_init(&queue->lock);
 #endif
 
-    queue->add_index = 0;
-    queue->fetch_index = 0;
-
-    for (int i = 0; i < QUEUE_SIZE; ++i)
-        Task_info_init(&queue->tasks[i]);
+    queue->is_closed = false;
+    queue->next_order = 0;
+    queue->count = 0;
+    queue->capacity = 0;
+    queue->tasks = NULL;
 
     return;
 }
 
 
-static bool Task_queue_add(Task_queue* queue, Task_info* task_info)
+static bool Task_queue_reserve_locked(Task_queue* queue, int64_t count)
 {
     rassert(queue != NULL);
-    rassert(task_info != NULL);
+    rassert(count >= 0);
+
+    if (count <= queue->capacity)
+        return true;
+
+    int64_t new_capacity = max(queue->capacity, QUEUE_INIT_CAPACITY);
+    while (new_capacity < count)
+        new_capacity *= 2;
+
+    Task_info* new_tasks =
+        memory_realloc_items(Task_info, new_capacity, queue->tasks);
+    if (new_tasks == NULL)
+        return false;
+
+    queue->tasks = new_tasks;
+    queue->capacity = new_capacity;
+
+    return true;
+}
+
+
+static bool Task_queue_reserve(Task_queue* queue, int64_t count)
+{
+    rassert(queue != NULL);
+    rassert(count >= 0);
 
     Mutex_lock(&queue->lock);
+    const bool success = Task_queue_reserve_locked(queue, count);
+    Mutex_unlock(&queue->lock);
+
+    return success;
+}
+
 
-    bool is_full =
-        (((queue->add_index + 1) % QUEUE_SIZE) == queue->fetch_index);
+static bool Task_queue_add(Task_queue* queue, const Task_info* task_info)
+{
+    rassert(queue != NULL);
+    rassert(task_info != NULL);
+    rassert(task_info->state == TASK_INFO_READY_TO_START ||
+            task_info->state == TASK_INFO_IN_PROGRESS);
 
-    if (task_info->state != TASK_INFO_END_QUEUE)
-        is_full |= (((queue->add_index + 2) % QUEUE_SIZE) == queue->fetch_index);
+    Mutex_lock(&queue->lock);
 
-    if (is_full)
+    if (!Task_queue_reserve_locked(queue, queue->count + 1))
     {
         Mutex_unlock(&queue->lock);
         return false;
     }
 
-    queue->tasks[queue->add_index] = *task_info;
-    queue->add_index = (queue->add_index + 1) % QUEUE_SIZE;
+    // Sift up
+    int64_t index = queue->count;
+    Task_info* new_info = &queue->tasks[index];
+    *new_info = *task_info;
+    new_info->order = queue->next_order;
+    ++queue->next_order;
+    ++queue->count;
+
+    while (index > 0)
+    {
+        const int64_t parent_index = (index - 1) / 2;
+        if (!Task_info_precedes(&queue->tasks[index], &queue->tasks[parent_index]))
+            break;
+
+        const Task_info tmp = queue->tasks[index];
+        queue->tasks[index] = queue->tasks[parent_index];
+        queue->tasks[parent_index] = tmp;
+        index = parent_index;
+    }
 
     Mutex_unlock(&queue->lock);
 
@@ -244,20 +337,18 @@ static bool Task_queue_add(Task_queue* queue, Task_info* task_info)
 }
 
 
-static void Task_queue_undo_add(Task_queue* queue)
+#ifdef ENABLE_THREADS
+static void Task_queue_close(Task_queue* queue)
 {
     rassert(queue != NULL);
 
     Mutex_lock(&queue->lock);
-
-    rassert(queue->fetch_index != queue->add_index);
-    queue->add_index = (queue->add_index + QUEUE_SIZE - 1) % QUEUE_SIZE;
-    Task_info_init(&queue->tasks[queue->add_index]);
-
+    queue->is_closed = true;
     Mutex_unlock(&queue->lock);
 
     return;
 }
+#endif // ENABLE_THREADS
 
 
 static bool Task_queue_fetch(Task_queue* queue, Task_info* dest_task_info)
@@ -267,18 +358,47 @@ static bool Task_queue_fetch(Task_queue* queue, Task_info* dest_task_info)
 
     Mutex_lock(&queue->lock);
 
-    const bool is_empty = (queue->fetch_index == queue->add_index);
-    if (is_empty)
+    if (queue->count == 0)
     {
+        const bool is_closed = queue->is_closed;
+        if (is_closed)
+        {
+            Task_info_init(dest_task_info);
+            dest_task_info->state = TASK_INFO_END_QUEUE;
+        }
+
         Mutex_unlock(&queue->lock);
-        return false;
+        return is_closed;
     }
 
-    *dest_task_info = queue->tasks[queue->fetch_index];
-    if (dest_task_info->state != TASK_INFO_END_QUEUE)
+    *dest_task_info = queue->tasks[0];
+
+    // Sift down
+    --queue->count;
+    queue->tasks[0] = queue->tasks[queue->count];
+
+    int64_t index = 0;
+    while (true)
     {
-        Task_info_init(&queue->tasks[queue->fetch_index]);
-        queue->fetch_index = (queue->fetch_index + 1) % QUEUE_SIZE;
+        const int64_t left_index = index * 2 + 1;
+        const int64_t right_index = left_index + 1;
+
+        const Task_info* tasks = queue->tasks;
+        int64_t first_index = index;
+        if ((left_index < queue->count) &&
+                Task_info_precedes(&tasks[left_index], &tasks[first_index]))
+            first_index = left_index;
+        if ((right_index < queue->count) &&
+                Task_info_precedes(&tasks[right_index], &tasks[first_index]))
+            first_index = right_index;
+
+        if (first_index == index)
+            break;
+
+        const Task_info tmp = queue->tasks[index];
+        queue->tasks[index] = queue->tasks[first_index];
+        queue->tasks[first_index] = tmp;
+        index = first_index;
     }
 
     Mutex_unlock(&queue->lock);
@@ -291,11 +411,9 @@ static void Task_queue_reset(Task_queue* queue)
 {
     rassert(queue != NULL);
 
-    queue->add_index = 0;
-    queue->fetch_index = 0;
-
-    for (int i = 0; i < QUEUE_SIZE; ++i)
-        Task_info_init(&queue->tasks[i]);
+    queue->is_closed = false;
+    queue->next_order = 0;
+    queue->count = 0;
 
     return;
 }
@@ -309,6 +427,9 @@ static void Task_queue_deinit(Task_queue* queue)
     Mutex_deinit(&queue->lock);
 #endif
 
+    memory_free(queue->tasks);
+    queue->tasks = NULL;
+
     return;
 }
 
@@ -320,6 +441,12 @@ struct Background_loader
 
     int active_task_count;
 
+    int64_t tasks_total;
+    int64_t bytes_total;
+    atomic_int_least64_t tasks_done;
+    atomic_int_least64_t bytes_done;
+    atomic_bool is_cancelled;
+
     Error first_error;
 
     Condition signal;
@@ -329,6 +456,8 @@ struct Background_loader
     Task_queue cleanup_queue;
 
     Array* final_cleanups;
+
+    Snapshot* snapshot;
 };
 
 
@@ -347,12 +476,19 @@ Background_loader* new_Background_loader(void)
     }
 
     loader->thread_count = 0;
+    loader->snapshot = NULL;
 
     for (int i = 0; i < KQT_THREADS_MAX; ++i)
         Task_worker_init(&loader->workers[i], loader);
 
     loader->active_task_count = 0;
 
+    loader->tasks_total = 0;
+    loader->bytes_total = 0;
+    loader->tasks_done = 0;
+    loader->bytes_done = 0;
+    loader->is_cancelled = false;
+
     loader->first_error = *ERROR_AUTO;
 
     loader->signal = *CONDITION_AUTO;
@@ -392,6 +528,21 @@ int Background_loader_get_thread_count(const Background_loader* loader)
 }
 
 
+void Background_loader_set_snapshot(Background_loader* loader, Snapshot* snapshot)
+{
+    rassert(loader != NULL);
+    loader->snapshot = snapshot;
+    return;
+}
+
+
+Snapshot* Background_loader_get_snapshot(const Background_loader* loader)
+{
+    rassert(loader != NULL);
+    return loader->snapshot;
+}
+
+
 static void Background_loader_run_cleanups(Background_loader* loader)
 {
     rassert(loader != NULL);
@@ -401,8 +552,17 @@ static void Background_loader_run_cleanups(Background_loader* loader)
     while (Task_queue_fetch(&loader->cleanup_queue, task_info))
     {
         rassert(task_info->task.cleanup != NULL);
+
+        Memory_usage* prev_usage = memory_set_usage(task_info->mem_usage);
+        const Memory_category prev_category =
+            memory_set_category(task_info->mem_category);
+
         task_info->task.cleanup(&task_info->error, task_info->task.user_data);
 
+        memory_set_usage(prev_usage);
+        memory_set_category(prev_category);
+        del_Memory_usage(task_info->mem_usage);
+
         if (Error_is_set(&task_info->error) && !Error_is_set(&loader->first_error))
             Error_copy(&loader->first_error, &task_info->error);
 
@@ -421,22 +581,23 @@ bool Background_loader_add_task(Background_loader* loader, Background_loader_tas
     rassert(task->process != NULL);
     rassert(task->cleanup != NULL);
 
-    if (loader->thread_count == 0)
-        return false;
+    rassert(task->size >= 0);
 
-    Background_loader_run_cleanups(loader);
-    if (loader->active_task_count + 2 >= QUEUE_SIZE)
+    if ((loader->thread_count == 0) || Background_loader_is_cancelled(loader))
         return false;
 
-    // Add new task info
-    Task_info* task_info = TASK_INFO_AUTO;
-    task_info->task = *task;
-    task_info->state = TASK_INFO_READY_TO_START;
-    task_info->error = *ERROR_AUTO;
+    Background_loader_run_cleanups(loader);
 
-    if (!Task_queue_add(&loader->work_queue, task_info))
+    // Make sure that workers never need to allocate memory for cleanup
+    if (!Task_queue_reserve(&loader->cleanup_queue, loader->active_task_count + 1))
         return false;
 
+    // Make sure that workers started below wait for the new task
+    Mutex* signal_mutex = Condition_get_mutex(&loader->signal);
+    Mutex_lock(signal_mutex);
+    loader->state = LOADER_STATE_IN_PROGRESS;
+    Mutex_unlock(signal_mutex);
+
     // Start workers if not running yet
     {
         bool any_workers_running = false;
@@ -456,21 +617,34 @@ bool Background_loader_add_task(Background_loader* loader, Background_loader_tas
         }
 
         if (!any_workers_running)
-        {
-            // Clear the task info as there are no workers that could run it
-            Task_queue_undo_add(&loader->work_queue);
             return false;
-        }
+    }
+
+    // Add new task info
+    Task_info* task_info = TASK_INFO_AUTO;
+    task_info->task = *task;
+    task_info->state = TASK_INFO_READY_TO_START;
+    task_info->error = *ERROR_AUTO;
+    task_info->mem_usage = memory_get_usage();
+    task_info->mem_category = memory_get_category();
+
+    if (task_info->mem_usage != NULL)
+        Memory_usage_retain(task_info->mem_usage);
+
+    if (!Task_queue_add(&loader->work_queue, task_info))
+    {
+        del_Memory_usage(task_info->mem_usage);
+        return false;
     }
 
     // Signal threads that there is more work to be done
-    Mutex* signal_mutex = Condition_get_mutex(&loader->signal);
     Mutex_lock(signal_mutex);
-    loader->state = LOADER_STATE_IN_PROGRESS;
     Condition_broadcast(&loader->signal);
     Mutex_unlock(signal_mutex);
 
     ++loader->active_task_count;
+    ++loader->tasks_total;
+    loader->bytes_total += task->size;
 
     return true;
 }
@@ -537,6 +711,9 @@ static void Background_loader_add_cleanup_task_info(
     bool success = Task_queue_add(&loader->cleanup_queue, task_info);
     rassert(success);
 
+    ++loader->tasks_done;
+    loader->bytes_done += task_info->task.size;
+
     return;
 }
 
@@ -547,9 +724,7 @@ void Background_loader_wait_idle(Background_loader* loader)
 
 #ifdef ENABLE_THREADS
     // Let all workers know that no more tasks are coming
-    Task_info* task_info = TASK_INFO_AUTO;
-    task_info->state = TASK_INFO_END_QUEUE;
-    Task_queue_add(&loader->work_queue, task_info);
+    Task_queue_close(&loader->work_queue);
 
     Mutex* signal_mutex = Condition_get_mutex(&loader->signal);
     Mutex_lock(signal_mutex);
@@ -577,10 +752,55 @@ void Background_loader_wait_idle(Background_loader* loader)
     Array_clear(loader->final_cleanups);
 #endif // ENABLE_THREADS
 
+    loader->tasks_total = 0;
+    loader->bytes_total = 0;
+    loader->tasks_done = 0;
+    loader->bytes_done = 0;
+
+    return;
+}
+
+
+void Background_loader_get_progress(
+        const Background_loader* loader,
+        int64_t* tasks_done,
+        int64_t* tasks_total,
+        int64_t* bytes_done,
+        int64_t* bytes_total)
+{
+    rassert(loader != NULL);
+    rassert(tasks_done != NULL);
+    rassert(tasks_total != NULL);
+    rassert(bytes_done != NULL);
+    rassert(bytes_total != NULL);
+
+    *tasks_done = loader->tasks_done;
+    *tasks_total = loader->tasks_total;
+    *bytes_done = loader->bytes_done;
+    *bytes_total = loader->bytes_total;
+
     return;
 }
 
 
+void Background_loader_cancel(Background_loader* loader)
+{
+    rassert(loader != NULL);
+
+    loader->is_cancelled = true;
+    Background_loader_wait_idle(loader);
+
+    return;
+}
+
+
+bool Background_loader_is_cancelled(const Background_loader* loader)
+{
+    rassert(loader != NULL);
+    return loader->is_cancelled;
+}
+
+
 const Error* Background_loader_get_first_error(const Background_loader* loader)
 {
     rassert(loader != NULL);
@@ -607,6 +827,8 @@ void Background_loader_reset(Background_loader* loader)
     Task_queue_reset(&loader->work_queue);
     Task_queue_reset(&loader->cleanup_queue);
 
+    loader->is_cancelled = false;
+
     return;
 }
 
@@ -616,7 +838,8 @@ void del_Background_loader(Background_loader* loader)
     if (loader == NULL)
         return;
 
-    Background_loader_wait_idle(loader);
+    // Any remaining work is obsolete
+    Background_loader_cancel(loader);
 
     for (int i = 0; i < KQT_THREADS_MAX; ++i)
         Task_worker_deinit(&loader->workers[i]);
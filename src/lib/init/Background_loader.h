@@ -20,6 +20,7 @@
 #include <Error.h>
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 
 
@@ -28,16 +29,28 @@ typedef void Background_loader_callback(Error* error, void* user_data);
 typedef void Background_loader_delayed_callback(void* user_data);
 
 
+/**
+ * A task executed in a background thread.
+ *
+ * The process callback is called in a background thread, and the cleanup
+ * callback is called afterwards in the thread that uses the Background
+ * loader. If the task is cancelled before it starts, only the cleanup
+ * callback is called with an error set.
+ *
+ * The size of the task is the amount of data processed in bytes. It is used
+ * for reporting progress, and tasks with smaller sizes are started first.
+ */
 typedef struct Background_loader_task
 {
     Background_loader_callback* process;
     Background_loader_callback* cleanup;
     void* user_data;
+    int64_t size;
 } Background_loader_task;
 
 
-#define MAKE_BACKGROUND_LOADER_TASK(pr, cl, ud) (&(Background_loader_task){ \
-        .process = (pr), .cleanup = (cl), .user_data = (ud) })
+#define MAKE_BACKGROUND_LOADER_TASK(pr, cl, ud, sz) (&(Background_loader_task){ \
+        .process = (pr), .cleanup = (cl), .user_data = (ud), .size = (sz) })
 
 
 /**
@@ -72,6 +85,25 @@ void Background_loader_set_thread_count(Background_loader* loader, int count);
 int Background_loader_get_thread_count(const Background_loader* loader);
 
 
+/**
+ * Set the Snapshot used for restoring and recording loaded data.
+ *
+ * \param loader     The Background loader -- must not be \c NULL.
+ * \param snapshot   The Snapshot, or \c NULL.
+ */
+void Background_loader_set_snapshot(Background_loader* loader, Snapshot* snapshot);
+
+
+/**
+ * Get the Snapshot used for restoring and recording loaded data.
+ *
+ * \param loader   The Background loader -- must not be \c NULL.
+ *
+ * \return   The Snapshot, or \c NULL if not set.
+ */
+Snapshot* Background_loader_get_snapshot(const Background_loader* loader);
+
+
 /**
  * Execute a task in the Background loader.
  *
@@ -79,7 +111,8 @@ int Background_loader_get_thread_count(const Background_loader* loader);
  * \param task     The Background loader task -- must not be \c NULL.
  *
  * \return   \c true if \a task was successfully put into the task queue,
- *           otherwise \c false.
+ *           otherwise \c false. The caller should execute \a task directly
+ *           in the latter case.
  */
 bool Background_loader_add_task(Background_loader* loader, Background_loader_task* task);
 
@@ -110,6 +143,52 @@ bool Background_loader_add_delayed_task(
 void Background_loader_wait_idle(Background_loader* loader);
 
 
+/**
+ * Get the progress of tasks added since the Background loader was last idle.
+ *
+ * \param loader        The Background loader -- must not be \c NULL.
+ * \param tasks_done    Destination for the number of finished tasks
+ *                      -- must not be \c NULL.
+ * \param tasks_total   Destination for the number of added tasks
+ *                      -- must not be \c NULL.
+ * \param bytes_done    Destination for the total size of finished tasks
+ *                      -- must not be \c NULL.
+ * \param bytes_total   Destination for the total size of added tasks
+ *                      -- must not be \c NULL.
+ */
+void Background_loader_get_progress(
+        const Background_loader* loader,
+        int64_t* tasks_done,
+        int64_t* tasks_total,
+        int64_t* bytes_done,
+        int64_t* bytes_total);
+
+
+/**
+ * Cancel all tasks in the Background loader and wait until it is idle.
+ *
+ * Tasks that have not started are finished with an error without calling
+ * their process callbacks. Tasks in progress may stop early by checking
+ * \a Background_loader_is_cancelled. No new tasks are accepted until the
+ * Background loader is reset.
+ *
+ * \param loader   The Background loader -- must not be \c NULL.
+ */
+void Background_loader_cancel(Background_loader* loader);
+
+
+/**
+ * Check if the Background loader has been cancelled.
+ *
+ * This function may be called from the process callbacks of tasks.
+ *
+ * \param loader   The Background loader -- must not be \c NULL.
+ *
+ * \return   \c true if \a loader has been cancelled, otherwise \c false.
+ */
+bool Background_loader_is_cancelled(const Background_loader* loader);
+
+
 /**
  * Get the first error set in the Background loader.
  *
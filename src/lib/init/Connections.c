@@ -281,6 +281,29 @@ static bool Connections_is_cyclic(const Connections* graph)
 }
 
 
+bool Connections_is_equal(const Connections* graph1, const Connections* graph2)
+{
+    rassert(graph1 != NULL);
+    rassert(graph2 != NULL);
+
+    AAiter* iter1 = AAiter_init(AAITER_AUTO, graph1->nodes);
+    AAiter* iter2 = AAiter_init(AAITER_AUTO, graph2->nodes);
+
+    const Device_node* node1 = AAiter_get_at_least(iter1, "");
+    const Device_node* node2 = AAiter_get_at_least(iter2, "");
+    while ((node1 != NULL) && (node2 != NULL))
+    {
+        if (!Device_node_has_same_connections(node1, node2))
+            return false;
+
+        node1 = AAiter_get_next(iter1);
+        node2 = AAiter_get_next(iter2);
+    }
+
+    return (node1 == NULL) && (node2 == NULL);
+}
+
+
 int Connections_get_depth(const Connections* graph)
 {
     rassert(graph != NULL);
@@ -71,6 +71,18 @@ bool Connections_check_connections(
         const Connections* graph, char err[DEVICE_CONNECTION_ERROR_LENGTH_MAX]);
 
 
+/**
+ * Tell whether two Connections describe the same graph.
+ *
+ * \param graph1   The first Connections -- must not be \c NULL.
+ * \param graph2   The second Connections -- must not be \c NULL.
+ *
+ * \return   \c true if \a graph1 and \a graph2 contain the same Device nodes
+ *           with identical connections, otherwise \c false.
+ */
+bool Connections_is_equal(const Connections* graph1, const Connections* graph2);
+
+
 /**
  * Retrieve the master Device node of the Connections.
  *
@@ -122,6 +122,39 @@ int Device_node_cmp(const Device_node* n1, const Device_node* n2)
 }
 
 
+bool Device_node_has_same_connections(const Device_node* n1, const Device_node* n2)
+{
+    rassert(n1 != NULL);
+    rassert(n2 != NULL);
+
+    if ((Device_node_cmp(n1, n2) != 0) ||
+            (n1->type != n2->type) ||
+            (n1->index != n2->index) ||
+            (n1->last_receive_port != n2->last_receive_port))
+        return false;
+
+    for (int port = 0; port <= n1->last_receive_port; ++port)
+    {
+        const Connection* edge1 = n1->receive[port];
+        const Connection* edge2 = n2->receive[port];
+        while ((edge1 != NULL) && (edge2 != NULL))
+        {
+            if ((edge1->port != edge2->port) ||
+                    (Device_node_cmp(edge1->node, edge2->node) != 0))
+                return false;
+
+            edge1 = edge1->next;
+            edge2 = edge2->next;
+        }
+
+        if ((edge1 != NULL) || (edge2 != NULL))
+            return false;
+    }
+
+    return true;
+}
+
+
 bool Device_node_check_connections(
         const Device_node* node, char err[DEVICE_CONNECTION_ERROR_LENGTH_MAX])
 {
@@ -82,6 +82,21 @@ Device_node* new_Device_node(const char* name, Au_table* au_table, const Device*
 int Device_node_cmp(const Device_node* n1, const Device_node* n2);
 
 
+/**
+ * Tell whether two Device nodes receive identical connections.
+ *
+ * The neighbour nodes are compared by name, so the nodes may belong to
+ * different Connections.
+ *
+ * \param n1   The first Device node -- must not be \c NULL.
+ * \param n2   The second Device node -- must not be \c NULL.
+ *
+ * \return   \c true if \a n1 and \a n2 have the same name and receive the
+ *           same connections in the same order, otherwise \c false.
+ */
+bool Device_node_has_same_connections(const Device_node* n1, const Device_node* n2);
+
+
 /**
  * Check that each connection to the Device node is between existing ports.
  *
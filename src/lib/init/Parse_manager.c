@@ -184,6 +184,19 @@ static bool is_proc_out_conn_possible(
 }
 
 
+static void mark_au_connections_changed(Handle* handle, int32_t au_index)
+{
+    rassert(handle != NULL);
+
+    if ((au_index >= 0) && (au_index < KQT_AUDIO_UNITS_MAX))
+        Player_invalidate_voice_signal_plan(handle->player, au_index);
+
+    handle->update_connections = true;
+
+    return;
+}
+
+
 static bool is_connection_possible(
         Handle* handle, const char* keyp, const Key_indices indices)
 {
@@ -214,6 +227,55 @@ static bool is_connection_possible(
 }
 
 
+static void mark_validation_scope(
+        Handle* handle, const char* keyp, const Key_indices indices)
+{
+    rassert(handle != NULL);
+    rassert(keyp != NULL);
+    rassert(indices != NULL);
+
+    Validation_scope* scope = &handle->validation_scope;
+
+    if (string_has_prefix(keyp, "au_XX/"))
+    {
+        if ((indices[0] >= 0) && (indices[0] < KQT_AUDIO_UNITS_MAX))
+            scope->check_aus[indices[0]] = true;
+        else
+            scope->check_all = true;
+    }
+    else if (string_has_prefix(keyp, "pat_XXX/"))
+    {
+        // Pattern contents do not affect validity
+        if (string_eq(keyp, "pat_XXX/p_manifest.json") ||
+                string_has_prefix(keyp, "pat_XXX/instance_XXX/"))
+        {
+            if ((indices[0] >= 0) && (indices[0] < KQT_PATTERNS_MAX))
+                scope->check_pats[indices[0]] = true;
+            else
+                scope->check_all = true;
+        }
+    }
+    else if (string_has_prefix(keyp, "album/") ||
+            string_eq(keyp, "song_XX/p_manifest.json") ||
+            string_eq(keyp, "song_XX/p_order_list.json"))
+    {
+        scope->check_sheet = true;
+    }
+    else if (string_has_prefix(keyp, "control_XX/") ||
+            string_eq(keyp, "p_control_map.json"))
+    {
+        scope->check_controls = true;
+    }
+    else if (string_has_prefix(keyp, "out_XX/") ||
+            string_eq(keyp, "p_connections.json"))
+    {
+        scope->check_top_level_connections = true;
+    }
+
+    return;
+}
+
+
 bool parse_data(Handle* handle, const char* key, const void* data, long length)
 {
     //fprintf(stderr, "parsing %s\n", key);
@@ -298,10 +360,17 @@ bool parse_data(Handle* handle, const char* key, const void* data, long length)
             }
 
             // Send read parameters to our callback
+            // Readers switch the Memory usage and category to the part they modify
+            Memory_usage* prev_usage = memory_get_usage();
+            const Memory_category prev_category = memory_get_category();
             const bool success = keyp_to_func[i].func(&params);
+            memory_set_usage(prev_usage);
+            memory_set_category(prev_category);
             if (!success)
                 return false;
 
+            mark_validation_scope(handle, key_pattern, key_indices);
+
             // TODO: Currently we don't always scan all the data, so we might
             //       not be at the correct location for checking the end bracket
             /*
@@ -318,7 +387,7 @@ bool parse_data(Handle* handle, const char* key, const void* data, long length)
             // Mark connections for update if needed
             if (was_connection_possible != is_connection_possible(
                         handle, key_pattern, key_indices))
-                handle->update_connections = true;
+                mark_au_connections_changed(handle, key_indices[0]);
 
             return true;
         }
@@ -427,11 +496,20 @@ static bool read_connections(Reader_params* params)
         return false;
     }
 
+    // Skip the update if the graph did not change
+    if ((module->connections != NULL) &&
+            Connections_is_equal(module->connections, graph))
+    {
+        del_Connections(graph);
+        return true;
+    }
+
     if (module->connections != NULL)
         del_Connections(module->connections);
 
     module->connections = graph;
 
+    // Voice signal plans do not depend on top-level connections
     params->handle->update_connections = true;
 
     return true;
@@ -598,7 +676,10 @@ static Audio_unit* add_audio_unit(Handle* handle, Au_table* au_table, int index)
     // Return existing audio unit
     Audio_unit* au = Au_table_get(au_table, index);
     if (au != NULL)
+    {
+        memory_set_usage(Device_get_memory_usage((const Device*)au));
         return au;
+    }
 
     // Create new audio unit
     au = new_Audio_unit();
@@ -609,6 +690,8 @@ static Audio_unit* add_audio_unit(Handle* handle, Au_table* au_table, int index)
         return NULL;
     }
 
+    memory_set_usage(Device_get_memory_usage((const Device*)au));
+
     // Allocate Device states for the new audio unit
     const Device* au_devices[] =
     {
@@ -802,10 +885,15 @@ static bool read_any_au_connections(Reader_params* params, Au_table* au_table, i
     Audio_unit* au = NULL;
     acquire_au(au, params->handle, au_table, index);
 
+    const Connections* old_graph = Audio_unit_get_connections(au);
+
     if (!Streader_has_data(params->sr))
     {
+        if (old_graph == NULL)
+            return true;
+
         Audio_unit_set_connections(au, NULL);
-        params->handle->update_connections = true;
+        mark_au_connections_changed(params->handle, params->indices[0]);
     }
     else
     {
@@ -817,8 +905,15 @@ static bool read_any_au_connections(Reader_params* params, Au_table* au_table, i
             return false;
         }
 
+        // Skip the update if the graph did not change
+        if ((old_graph != NULL) && Connections_is_equal(old_graph, graph))
+        {
+            del_Connections(graph);
+            return true;
+        }
+
         Audio_unit_set_connections(au, graph);
-        params->handle->update_connections = true;
+        mark_au_connections_changed(params->handle, params->indices[0]);
     }
 
     return true;
@@ -1015,7 +1110,10 @@ static Processor* add_processor(
     // Return existing processor
     Processor* proc = Proc_table_get_proc_mut(proc_table, proc_index);
     if (proc != NULL)
+    {
+        memory_set_usage(Device_get_memory_usage((const Device*)proc));
         return proc;
+    }
 
     // Create new processor
     proc = new_Processor(proc_index, Audio_unit_get_params(au));
@@ -1026,6 +1124,8 @@ static Processor* add_processor(
         return NULL;
     }
 
+    memory_set_usage(Device_get_memory_usage((const Device*)proc));
+
     return proc;
 }
 
@@ -1119,8 +1219,13 @@ static bool allocate_voice_work_buffers(Reader_params* params, Device_impl* proc
     const int32_t req_size = Device_impl_get_voice_wb_size(proc_impl, audio_rate);
     if (req_size > cur_size)
     {
-        if (!Player_reserve_voice_work_buffer_space(
-                    params->handle->player, req_size))
+        // Voice work buffers are shared by all processors
+        Memory_usage* prev_usage = memory_set_usage(params->handle->mem_usage);
+        const bool success =
+            Player_reserve_voice_work_buffer_space(params->handle->player, req_size);
+        memory_set_usage(prev_usage);
+
+        if (!success)
         {
             Handle_set_error(params->handle, ERROR_MEMORY,
                     "Could not allocate memory for voice work buffers");
@@ -1199,6 +1304,9 @@ static bool read_any_proc_manifest(Reader_params* params, Au_table* au_table, in
             Device* device =
                 (Device*)Proc_table_get_proc_mut(proc_table, proc_index);
             Device_set_impl(device, NULL, params->handle->bkg_loader);
+
+            // Make sure that signal plans do not refer to the removed state
+            mark_au_connections_changed(params->handle, params->indices[0]);
         }
 
         Proc_table_set_existent(proc_table, proc_index, false);
@@ -1240,11 +1348,19 @@ static bool read_any_proc_manifest(Reader_params* params, Au_table* au_table, in
     Device_states* dstates = Player_get_device_states(params->handle->player);
     Device_states_remove_state(dstates, Device_get_id((Device*)proc));
 
-    // Allocate Voice state space
+    // Allocate Voice state space, shared by all processors of the same type
     {
         const int32_t size = Device_impl_get_vstate_size(proc_impl);
-        if (!Player_reserve_voice_state_space(params->handle->player, size) ||
-                !Player_reserve_voice_state_space(params->handle->length_counter, size))
+        const bool use_wbs = (proc_impl->get_voice_wb_size != NULL);
+        Memory_usage* prev_usage = memory_set_usage(params->handle->mem_usage);
+        const bool success =
+            Player_reserve_voice_state_space(
+                    params->handle->player, d->type, size, use_wbs) &&
+            Player_reserve_voice_state_space(
+                    params->handle->length_counter, d->type, size, use_wbs);
+        memory_set_usage(prev_usage);
+
+        if (!success)
         {
             Handle_set_error(params->handle, ERROR_MEMORY,
                     "Could not allocate memory for processor voice states");
@@ -1287,7 +1403,7 @@ static bool read_any_proc_manifest(Reader_params* params, Au_table* au_table, in
     }
 
     // Force connection update so that we get buffers for the new Device state(s)
-    params->handle->update_connections = true;
+    mark_au_connections_changed(params->handle, params->indices[0]);
 
     Proc_table_set_existent(proc_table, proc_index, true);
 
@@ -1338,7 +1454,7 @@ static bool read_any_proc_signal_type(
     Processor_set_voice_signals(proc, voice_signals_selected);
     Device_set_mixed_signals((Device*)proc, mixed_signals_selected);
 
-    params->handle->update_connections = true;
+    mark_au_connections_changed(params->handle, params->indices[0]);
 
     return true;
 }
@@ -1463,6 +1579,7 @@ static bool read_any_proc_conf_key(
 #define acquire_pattern(pattern, handle, index)                         \
     if (true)                                                           \
     {                                                                   \
+        memory_set_category(MEMORY_CATEGORY_PATTERNS);                  \
         Module* module = Handle_get_module((handle));                   \
         (pattern) = Pat_table_get(Module_get_pats(module), (index));    \
         if ((pattern) == NULL)                                          \
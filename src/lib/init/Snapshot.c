@@ -0,0 +1,546 @@
+
+
+/*
+ * Author: agent, 2026
+ *
+ * This file is part of Kunquat.
+ *
+ * CC0 1.0 Universal, http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * To the extent possible under law, Kunquat Affirmers have waived all
+ * copyright and related or neighboring rights to Kunquat.
+ */
+
+
+#include <init/Snapshot.h>
+
+#include <containers/AAtree.h>
+#include <containers/Array.h>
+#include <debug/assert.h>
+#include <init/devices/param_types/Sample.h>
+#include <kunquat/version.h>
+#include <memory.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#define SNAPSHOT_MAGIC "KQTSNAP"
+#define SNAPSHOT_FORMAT_VERSION 2
+#define SNAPSHOT_BYTE_ORDER_MARK 0x01020304UL
+#define SNAPSHOT_BUILD_LENGTH 64
+#define SNAPSHOT_ALIGNMENT 8
+
+
+typedef struct Snapshot_header
+{
+    char magic[8];
+    uint32_t format_version;
+    uint32_t byte_order_mark;
+    char build[SNAPSHOT_BUILD_LENGTH];
+    uint32_t generator_revision;
+    uint32_t reserved;
+    uint64_t entry_count;
+} Snapshot_header;
+
+
+typedef struct Snapshot_entry_header
+{
+    uint64_t id;
+    int64_t length;
+    uint32_t channels;
+    uint32_t bits;
+    uint32_t is_float;
+    uint32_t reserved;
+} Snapshot_entry_header;
+
+
+typedef struct Snapshot_entry
+{
+    uint64_t id;
+    int channels;
+    int bits;
+    bool is_float;
+    int64_t length;
+    const char* data[2];
+    char* buffers[2]; ///< Buffers owned by recorded entries
+} Snapshot_entry;
+
+
+#define SNAPSHOT_ENTRY_KEY(entry_id) (&(Snapshot_entry){ .id = (entry_id) })
+
+
+struct Snapshot
+{
+    Array* source_entries;
+    bool is_recording;
+    bool is_recording_incomplete;
+    AAtree* recorded_entries;
+    char* serialised;
+};
+
+
+uint64_t Snapshot_id_add(uint64_t id, const void* data, int64_t size)
+{
+    rassert(data != NULL);
+    rassert(size >= 0);
+
+    // FNV-1a
+    const unsigned char* bytes = data;
+    for (int64_t i = 0; i < size; ++i)
+    {
+        id ^= bytes[i];
+        id *= (uint64_t)0x100000001b3ULL;
+    }
+
+    return id;
+}
+
+
+uint64_t Snapshot_id_add_float(uint64_t id, double value)
+{
+    return Snapshot_id_add(id, &value, sizeof(double));
+}
+
+
+uint64_t Snapshot_id_add_int(uint64_t id, int64_t value)
+{
+    return Snapshot_id_add(id, &value, sizeof(int64_t));
+}
+
+
+static int64_t get_padded_size(int64_t size)
+{
+    rassert(size >= 0);
+    return ((size + SNAPSHOT_ALIGNMENT - 1) / SNAPSHOT_ALIGNMENT) * SNAPSHOT_ALIGNMENT;
+}
+
+
+static int64_t Snapshot_entry_get_buffer_size(const Snapshot_entry* entry)
+{
+    rassert(entry != NULL);
+    return entry->length * (entry->bits / 8);
+}
+
+
+static int Snapshot_entry_cmp(const Snapshot_entry* entry1, const Snapshot_entry* entry2)
+{
+    rassert(entry1 != NULL);
+    rassert(entry2 != NULL);
+
+    if (entry1->id < entry2->id)
+        return -1;
+    else if (entry1->id > entry2->id)
+        return 1;
+    return 0;
+}
+
+
+static void del_Snapshot_entry(Snapshot_entry* entry)
+{
+    if (entry == NULL)
+        return;
+
+    memory_free(entry->buffers[0]);
+    memory_free(entry->buffers[1]);
+    memory_free(entry);
+
+    return;
+}
+
+
+Snapshot* new_Snapshot(void)
+{
+    Snapshot* snapshot = memory_alloc_item(Snapshot);
+    if (snapshot == NULL)
+        return NULL;
+
+    snapshot->source_entries = NULL;
+    snapshot->is_recording = false;
+    snapshot->is_recording_incomplete = false;
+    snapshot->recorded_entries = NULL;
+    snapshot->serialised = NULL;
+
+    snapshot->source_entries = new_Array(sizeof(Snapshot_entry));
+    snapshot->recorded_entries = new_AAtree(
+            (AAtree_item_cmp*)Snapshot_entry_cmp,
+            (AAtree_item_destroy*)del_Snapshot_entry);
+    if ((snapshot->source_entries == NULL) || (snapshot->recorded_entries == NULL))
+    {
+        del_Snapshot(snapshot);
+        return NULL;
+    }
+
+    return snapshot;
+}
+
+
+static void init_build_string(char build[SNAPSHOT_BUILD_LENGTH])
+{
+    rassert(build != NULL);
+
+    memset(build, '\0', SNAPSHOT_BUILD_LENGTH);
+    strncpy(build, kqt_get_version(), SNAPSHOT_BUILD_LENGTH - 1);
+
+    return;
+}
+
+
+bool Snapshot_read(Snapshot* snapshot, const char* data, int64_t length, Error* error)
+{
+    rassert(snapshot != NULL);
+    rassert(length >= 0);
+    rassert((data != NULL) || (length == 0));
+    rassert(error != NULL);
+
+    Array_clear(snapshot->source_entries);
+
+    if (data == NULL)
+        return false;
+
+    Snapshot_header header;
+    if (length < (int64_t)sizeof(header))
+    {
+        Error_set(error, ERROR_FORMAT, "Snapshot header is incomplete");
+        return false;
+    }
+
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0)
+    {
+        Error_set(error, ERROR_FORMAT, "Data is not a Kunquat snapshot");
+        return false;
+    }
+
+    // Fall back to the normal loading process with incompatible snapshots
+    char build[SNAPSHOT_BUILD_LENGTH];
+    init_build_string(build);
+    if ((header.format_version != SNAPSHOT_FORMAT_VERSION) ||
+            (header.byte_order_mark != SNAPSHOT_BYTE_ORDER_MARK) ||
+            (memcmp(header.build, build, SNAPSHOT_BUILD_LENGTH) != 0) ||
+            (header.generator_revision != SNAPSHOT_GENERATOR_REVISION))
+        return false;
+
+    int64_t pos = (int64_t)sizeof(header);
+    for (uint64_t i = 0; i < header.entry_count; ++i)
+    {
+        Snapshot_entry_header entry_header;
+        if (length - pos < (int64_t)sizeof(entry_header))
+        {
+            Array_clear(snapshot->source_entries);
+            Error_set(error, ERROR_FORMAT, "Snapshot entry %d is incomplete", (int)i);
+            return false;
+        }
+
+        memcpy(&entry_header, data + pos, sizeof(entry_header));
+        pos += (int64_t)sizeof(entry_header);
+
+        if ((entry_header.channels < 1) || (entry_header.channels > 2) ||
+                ((entry_header.bits != 8) &&
+                 (entry_header.bits != 16) &&
+                 (entry_header.bits != 32)) ||
+                (entry_header.is_float && (entry_header.bits != 32)) ||
+                (entry_header.length < 0))
+        {
+            Array_clear(snapshot->source_entries);
+            Error_set(error, ERROR_FORMAT, "Invalid format in snapshot entry %d", (int)i);
+            return false;
+        }
+
+        Snapshot_entry* entry = &(Snapshot_entry){
+            .id = entry_header.id,
+            .channels = (int)entry_header.channels,
+            .bits = (int)entry_header.bits,
+            .is_float = (entry_header.is_float != 0),
+            .length = entry_header.length,
+            .data = { NULL, NULL },
+            .buffers = { NULL, NULL },
+        };
+
+        const int64_t buf_size = Snapshot_entry_get_buffer_size(entry);
+        if ((entry->length > (length - pos) / (entry->bits / 8)) ||
+                (get_padded_size(buf_size) * entry->channels > length - pos))
+        {
+            Array_clear(snapshot->source_entries);
+            Error_set(error, ERROR_FORMAT, "Snapshot entry %d is incomplete", (int)i);
+            return false;
+        }
+
+        const int64_t entry_count = Array_get_size(snapshot->source_entries);
+        if (entry_count > 0)
+        {
+            const Snapshot_entry* prev =
+                Array_get_ref(snapshot->source_entries, entry_count - 1);
+            if (prev->id >= entry->id)
+            {
+                Array_clear(snapshot->source_entries);
+                Error_set(error, ERROR_FORMAT, "Snapshot entries are not sorted");
+                return false;
+            }
+        }
+
+        for (int ch = 0; ch < entry->channels; ++ch)
+        {
+            entry->data[ch] = data + pos;
+            pos += get_padded_size(buf_size);
+        }
+
+        if (!Array_append(snapshot->source_entries, entry))
+        {
+            Array_clear(snapshot->source_entries);
+            Error_set(error, ERROR_MEMORY, "Could not allocate memory for snapshot index");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+bool Snapshot_is_active(const Snapshot* snapshot)
+{
+    if (snapshot == NULL)
+        return false;
+
+    return snapshot->is_recording || (Array_get_size(snapshot->source_entries) > 0);
+}
+
+
+static const Snapshot_entry* Snapshot_find_source_entry(
+        const Snapshot* snapshot, uint64_t id)
+{
+    rassert(snapshot != NULL);
+
+    int64_t start = 0;
+    int64_t stop = Array_get_size(snapshot->source_entries);
+    while (start < stop)
+    {
+        const int64_t middle = start + (stop - start) / 2;
+        const Snapshot_entry* entry = Array_get_ref(snapshot->source_entries, middle);
+        if (entry->id == id)
+            return entry;
+        else if (entry->id < id)
+            start = middle + 1;
+        else
+            stop = middle;
+    }
+
+    return NULL;
+}
+
+
+bool Snapshot_restore_sample(const Snapshot* snapshot, uint64_t id, Sample* sample)
+{
+    rassert(sample != NULL);
+
+    if (snapshot == NULL)
+        return false;
+
+    const Snapshot_entry* entry = Snapshot_find_source_entry(snapshot, id);
+    if (entry == NULL)
+        return false;
+
+    const int64_t buf_size = Snapshot_entry_get_buffer_size(entry);
+
+    if (sample->data[0] == NULL)
+    {
+        rassert(sample->data[1] == NULL);
+
+        void* bufs[2] = { NULL, NULL };
+        for (int ch = 0; ch < entry->channels; ++ch)
+        {
+            bufs[ch] = memory_alloc_items(char, buf_size);
+            if (bufs[ch] == NULL)
+            {
+                memory_free(bufs[0]);
+                return false;
+            }
+        }
+
+        sample->channels = entry->channels;
+        sample->bits = entry->bits;
+        sample->is_float = entry->is_float;
+        sample->len = entry->length;
+        sample->data[0] = bufs[0];
+        sample->data[1] = bufs[1];
+    }
+    else if ((sample->channels != entry->channels) ||
+            (sample->bits != entry->bits) ||
+            (sample->is_float != entry->is_float) ||
+            (sample->len != entry->length))
+    {
+        return false;
+    }
+
+    for (int ch = 0; ch < entry->channels; ++ch)
+        memcpy(sample->data[ch], entry->data[ch], (size_t)buf_size);
+
+    return true;
+}
+
+
+void Snapshot_set_recording(Snapshot* snapshot, bool enabled)
+{
+    rassert(snapshot != NULL);
+
+    snapshot->is_recording = enabled;
+    if (!enabled)
+    {
+        snapshot->is_recording_incomplete = false;
+        AAtree_clear(snapshot->recorded_entries);
+    }
+
+    return;
+}
+
+
+void Snapshot_record_sample(Snapshot* snapshot, uint64_t id, const Sample* sample)
+{
+    rassert(sample != NULL);
+
+    if ((snapshot == NULL) || !snapshot->is_recording)
+        return;
+
+    if (AAtree_contains(snapshot->recorded_entries, SNAPSHOT_ENTRY_KEY(id)))
+        return;
+
+    Snapshot_entry* entry = memory_alloc_item(Snapshot_entry);
+    if (entry == NULL)
+    {
+        snapshot->is_recording_incomplete = true;
+        return;
+    }
+
+    entry->id = id;
+    entry->channels = sample->channels;
+    entry->bits = sample->bits;
+    entry->is_float = sample->is_float;
+    entry->length = sample->len;
+    entry->data[0] = NULL;
+    entry->data[1] = NULL;
+    entry->buffers[0] = NULL;
+    entry->buffers[1] = NULL;
+
+    const int64_t buf_size = Snapshot_entry_get_buffer_size(entry);
+    for (int ch = 0; ch < entry->channels; ++ch)
+    {
+        rassert(sample->data[ch] != NULL);
+
+        entry->buffers[ch] = memory_alloc_items(char, buf_size);
+        if (entry->buffers[ch] == NULL)
+        {
+            del_Snapshot_entry(entry);
+            snapshot->is_recording_incomplete = true;
+            return;
+        }
+
+        memcpy(entry->buffers[ch], sample->data[ch], (size_t)buf_size);
+        entry->data[ch] = entry->buffers[ch];
+    }
+
+    if (!AAtree_ins(snapshot->recorded_entries, entry))
+    {
+        del_Snapshot_entry(entry);
+        snapshot->is_recording_incomplete = true;
+        return;
+    }
+
+    return;
+}
+
+
+const char* Snapshot_serialise(Snapshot* snapshot, int64_t* length)
+{
+    rassert(snapshot != NULL);
+    rassert(length != NULL);
+
+    memory_free(snapshot->serialised);
+    snapshot->serialised = NULL;
+
+    if (snapshot->is_recording_incomplete)
+        return NULL;
+
+    Snapshot_header header;
+    memset(&header, '\0', sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.format_version = SNAPSHOT_FORMAT_VERSION;
+    header.byte_order_mark = SNAPSHOT_BYTE_ORDER_MARK;
+    init_build_string(header.build);
+    header.generator_revision = SNAPSHOT_GENERATOR_REVISION;
+    header.entry_count = 0;
+
+    // Get total size
+    int64_t total_size = (int64_t)sizeof(header);
+
+    AAiter* iter = AAiter_init(AAITER_AUTO, snapshot->recorded_entries);
+    const Snapshot_entry* entry = AAiter_get_at_least(iter, SNAPSHOT_ENTRY_KEY(0));
+    while (entry != NULL)
+    {
+        const int64_t buf_size = Snapshot_entry_get_buffer_size(entry);
+        total_size += (int64_t)sizeof(Snapshot_entry_header);
+        total_size += get_padded_size(buf_size) * entry->channels;
+        ++header.entry_count;
+
+        entry = AAiter_get_next(iter);
+    }
+
+    char* data = memory_alloc_items(char, total_size);
+    if (data == NULL)
+        return NULL;
+
+    memset(data, '\0', (size_t)total_size);
+
+    // Write data
+    memcpy(data, &header, sizeof(header));
+    int64_t pos = (int64_t)sizeof(header);
+
+    iter = AAiter_init(AAITER_AUTO, snapshot->recorded_entries);
+    entry = AAiter_get_at_least(iter, SNAPSHOT_ENTRY_KEY(0));
+    while (entry != NULL)
+    {
+        Snapshot_entry_header entry_header;
+        memset(&entry_header, '\0', sizeof(entry_header));
+        entry_header.id = entry->id;
+        entry_header.length = entry->length;
+        entry_header.channels = (uint32_t)entry->channels;
+        entry_header.bits = (uint32_t)entry->bits;
+        entry_header.is_float = entry->is_float ? 1 : 0;
+
+        memcpy(data + pos, &entry_header, sizeof(entry_header));
+        pos += (int64_t)sizeof(entry_header);
+
+        const int64_t buf_size = Snapshot_entry_get_buffer_size(entry);
+        for (int ch = 0; ch < entry->channels; ++ch)
+        {
+            memcpy(data + pos, entry->data[ch], (size_t)buf_size);
+            pos += get_padded_size(buf_size);
+        }
+
+        entry = AAiter_get_next(iter);
+    }
+
+    rassert(pos == total_size);
+
+    snapshot->serialised = data;
+    *length = total_size;
+
+    return snapshot->serialised;
+}
+
+
+void del_Snapshot(Snapshot* snapshot)
+{
+    if (snapshot == NULL)
+        return;
+
+    del_Array(snapshot->source_entries);
+    del_AAtree(snapshot->recorded_entries);
+    memory_free(snapshot->serialised);
+    memory_free(snapshot);
+
+    return;
+}
+
+
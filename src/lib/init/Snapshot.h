@@ -0,0 +1,198 @@
+
+
+/*
+ * Author: agent, 2026
+ *
+ * This file is part of Kunquat.
+ *
+ * CC0 1.0 Universal, http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * To the extent possible under law, Kunquat Affirmers have waived all
+ * copyright and related or neighboring rights to Kunquat.
+ */
+
+
+#ifndef KQT_SNAPSHOT_H
+#define KQT_SNAPSHOT_H
+
+
+#include <decl.h>
+#include <Error.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+
+/**
+ * Snapshot contains sample data that is expensive to derive from the module
+ * data, such as decoded samples and generated PADsynth tables.
+ *
+ * Each entry is identified by a hash of the inputs it was derived from, so
+ * entries that no longer match the module data are simply never used.
+ *
+ * The serialised format consists of a header followed by entries sorted by
+ * identifier. Each entry contains the sample format and the raw contents of
+ * each channel buffer. Reading a serialised Snapshot only builds an index to
+ * the entries, the sample data is copied directly from the source buffer when
+ * it is restored. A serialised Snapshot created by a different build of
+ * libkunquat or by a different revision of the generating code is ignored.
+ */
+
+
+/**
+ * The revision of the code that generates Snapshot contents.
+ *
+ * This must be incremented whenever the data generated from the same inputs
+ * changes, e.g. when the FFT used by PADsynth is modified, as the library
+ * version alone does not identify the generating code.
+ */
+#define SNAPSHOT_GENERATOR_REVISION 1
+
+
+#define SNAPSHOT_ID_INIT ((uint64_t)0xcbf29ce484222325ULL)
+
+
+/**
+ * Add data to a Snapshot entry identifier.
+ *
+ * \param id     The identifier so far, initially \c SNAPSHOT_ID_INIT.
+ * \param data   The data -- must not be \c NULL.
+ * \param size   The size of \a data in bytes -- must be >= \c 0.
+ *
+ * \return   The updated identifier.
+ */
+uint64_t Snapshot_id_add(uint64_t id, const void* data, int64_t size);
+
+
+/**
+ * Add a floating-point value to a Snapshot entry identifier.
+ *
+ * \param id      The identifier so far.
+ * \param value   The value.
+ *
+ * \return   The updated identifier.
+ */
+uint64_t Snapshot_id_add_float(uint64_t id, double value);
+
+
+/**
+ * Add an integer value to a Snapshot entry identifier.
+ *
+ * \param id      The identifier so far.
+ * \param value   The value.
+ *
+ * \return   The updated identifier.
+ */
+uint64_t Snapshot_id_add_int(uint64_t id, int64_t value);
+
+
+/**
+ * Create a new empty Snapshot.
+ *
+ * \return   The new Snapshot, or \c NULL if memory allocation failed.
+ */
+Snapshot* new_Snapshot(void);
+
+
+/**
+ * Read a serialised Snapshot as the source of restored entries.
+ *
+ * Any previously read source is discarded.
+ *
+ * \param snapshot   The Snapshot -- must not be \c NULL.
+ * \param data       The serialised data, or \c NULL for no source. The data
+ *                   is not copied and must remain valid until the source is
+ *                   replaced or \a snapshot is destroyed.
+ * \param length     The length of \a data -- must be >= \c 0.
+ * \param error      Destination for error information -- must not be \c NULL.
+ *
+ * \return   \c true if \a data is used as the source, or \c false if \a data
+ *           is not a compatible Snapshot. In the latter case \a error is set
+ *           if \a data is malformed or if memory allocation failed, but not
+ *           if \a data was created by a different build of libkunquat.
+ */
+bool Snapshot_read(Snapshot* snapshot, const char* data, int64_t length, Error* error);
+
+
+/**
+ * Check if the Snapshot has a source or is recording Samples.
+ *
+ * Callers can use this to skip computing entry identifiers.
+ *
+ * \param snapshot   The Snapshot, or \c NULL.
+ *
+ * \return   \c true if \a snapshot is in use, otherwise \c false.
+ */
+bool Snapshot_is_active(const Snapshot* snapshot);
+
+
+/**
+ * Restore a Sample from the source of the Snapshot.
+ *
+ * If \a sample has no data, new buffers are allocated for it. Otherwise, the
+ * Snapshot entry must match the format and length of \a sample and the
+ * existing buffers are overwritten.
+ *
+ * \param snapshot   The Snapshot, or \c NULL.
+ * \param id         The identifier of the entry.
+ * \param sample     The destination Sample -- must not be \c NULL.
+ *
+ * \return   \c true if \a sample was restored, or \c false if a matching
+ *           entry was not found or memory allocation failed.
+ */
+bool Snapshot_restore_sample(const Snapshot* snapshot, uint64_t id, Sample* sample);
+
+
+/**
+ * Set recording of derived Samples in the Snapshot.
+ *
+ * Disabling recording removes all recorded entries and clears any recording
+ * failure.
+ *
+ * \param snapshot   The Snapshot -- must not be \c NULL.
+ * \param enabled    \c true if recording should be enabled, otherwise \c false.
+ */
+void Snapshot_set_recording(Snapshot* snapshot, bool enabled);
+
+
+/**
+ * Record a copy of a derived Sample in the Snapshot.
+ *
+ * This function does nothing if recording is disabled or the Snapshot
+ * already contains an entry with the same identifier. If memory allocation
+ * fails, the failure is reported by \a Snapshot_serialise.
+ *
+ * \param snapshot   The Snapshot, or \c NULL.
+ * \param id         The identifier of the entry.
+ * \param sample     The Sample -- must not be \c NULL.
+ */
+void Snapshot_record_sample(Snapshot* snapshot, uint64_t id, const Sample* sample);
+
+
+/**
+ * Get the serialised form of the recorded entries of the Snapshot.
+ *
+ * \param snapshot   The Snapshot -- must not be \c NULL.
+ * \param length     Destination for the length of the serialised data
+ *                   -- must not be \c NULL.
+ *
+ * \return   The serialised data, or \c NULL if memory allocation failed
+ *           during serialisation or recording since it was enabled. The
+ *           data is valid until the next call of this function or until
+ *           \a snapshot is destroyed.
+ */
+const char* Snapshot_serialise(Snapshot* snapshot, int64_t* length);
+
+
+/**
+ * Destroy an existing Snapshot.
+ *
+ * \param snapshot   The Snapshot, or \c NULL.
+ */
+void del_Snapshot(Snapshot* snapshot);
+
+
+#endif // KQT_SNAPSHOT_H
+
+
@@ -1,7 +1,7 @@
 
 
 /*
- * Author: Tomi Jylhä-Ollila, Finland 2010-2018
+ * Author: Tomi Jylhä-Ollila, Finland 2010-2019
  *
  * This file is part of Kunquat.
  *
@@ -119,8 +119,13 @@ Audio_unit* new_Audio_unit(void)
         memory_free(au);
         return NULL;
     }
+
+    // Charge the contents of the audio unit to its own Memory usage
+    Memory_usage* prev_usage = memory_set_usage(Device_get_memory_usage(&au->parent));
+
     if (Au_params_init(&au->params, Device_get_id(&au->parent)) == NULL)
     {
+        memory_set_usage(prev_usage);
         Device_deinit(&au->parent);
         memory_free(au);
         return NULL;
@@ -133,6 +138,9 @@ Audio_unit* new_Audio_unit(void)
     au->in_iface = new_Au_interface();
     au->procs = new_Proc_table(KQT_PROCESSORS_MAX);
     au->au_table = new_Au_table(KQT_AUDIO_UNITS_MAX);
+
+    memory_set_usage(prev_usage);
+
     if ((au->out_iface == NULL) ||
             (au->in_iface == NULL) ||
             (au->procs == NULL) ||
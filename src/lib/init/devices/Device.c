@@ -20,6 +20,7 @@
 #include <init/Background_loader.h>
 #include <init/devices/Device_impl.h>
 #include <mathnum/common.h>
+#include <memory.h>
 #include <string/common.h>
 #include <Value.h>
 
@@ -44,6 +45,8 @@ bool Device_init(Device* device, bool req_impl)
     device->dparams = NULL;
     device->dimpl = NULL;
 
+    device->mem_usage = NULL;
+
     device->create_state = new_Device_state_plain;
 
     for (int port_type = 0; port_type < DEVICE_PORT_TYPES; ++port_type)
@@ -52,18 +55,31 @@ bool Device_init(Device* device, bool req_impl)
         device->last_existence_set[port_type] = 0;
     }
 
+    device->mem_usage = new_Memory_usage(memory_get_usage());
+    if (device->mem_usage == NULL)
+        return false;
+
+    Memory_usage* prev_usage = memory_set_usage(device->mem_usage);
+
+    bool success = true;
+
     for (int port_type = 0; port_type < DEVICE_PORT_TYPES; ++port_type)
     {
         device->existence[port_type] = new_Bit_array(KQT_DEVICE_PORTS_MAX);
         if (device->existence[port_type] == NULL)
-        {
-            Device_deinit(device);
-            return false;
-        }
+            success = false;
+    }
+
+    if (success)
+    {
+        device->dparams = new_Device_params();
+        if (device->dparams == NULL)
+            success = false;
     }
 
-    device->dparams = new_Device_params();
-    if (device->dparams == NULL)
+    memory_set_usage(prev_usage);
+
+    if (!success)
     {
         Device_deinit(device);
         return false;
@@ -80,6 +96,13 @@ uint32_t Device_get_id(const Device* device)
 }
 
 
+Memory_usage* Device_get_memory_usage(const Device* device)
+{
+    rassert(device != NULL);
+    return device->mem_usage;
+}
+
+
 bool Device_has_complete_type(const Device* device)
 {
     rassert(device != NULL);
@@ -145,7 +168,12 @@ Device_state* Device_create_state(
     rassert(audio_rate > 0);
     rassert(buffer_size >= 0);
 
-    return device->create_state(device, audio_rate, buffer_size);
+    const Memory_category prev_category =
+        memory_set_category(MEMORY_CATEGORY_DEVICE_STATES);
+    Device_state* ds = device->create_state(device, audio_rate, buffer_size);
+    memory_set_category(prev_category);
+
+    return ds;
 }
 
 
@@ -411,6 +439,9 @@ void Device_deinit(Device* device)
         device->existence[port_type] = NULL;
     }
 
+    del_Memory_usage(device->mem_usage);
+    device->mem_usage = NULL;
+
     return;
 }
 
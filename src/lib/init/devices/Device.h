@@ -21,6 +21,7 @@
 #include <kunquat/limits.h>
 #include <mathnum/Random.h>
 #include <mathnum/Tstamp.h>
+#include <memory.h>
 #include <player/Device_states.h>
 #include <player/devices/Device_state.h>
 #include <player/Linear_controls.h>
@@ -42,6 +43,8 @@ struct Device
     Device_params* dparams;
     Device_impl* dimpl;
 
+    Memory_usage* mem_usage;
+
     Device_state_create_func* create_state;
 
     Bit_array* existence[DEVICE_PORT_TYPES];
@@ -71,6 +74,19 @@ bool Device_init(Device* device, bool req_impl);
 uint32_t Device_get_id(const Device* device);
 
 
+/**
+ * Get the Memory usage of the Device.
+ *
+ * The Memory usage is a child of the Memory usage that was current when
+ * the Device was initialised.
+ *
+ * \param device   The Device -- must not be \c NULL.
+ *
+ * \return   The Memory usage.
+ */
+Memory_usage* Device_get_memory_usage(const Device* device);
+
+
 /**
  * Find out if the Device has a complete type.
  *
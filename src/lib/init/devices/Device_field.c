@@ -16,6 +16,7 @@
 
 #include <debug/assert.h>
 #include <decl.h>
+#include <init/Background_loader.h>
 #include <init/devices/param_types/Wav.h>
 #include <init/devices/param_types/Wavpack.h>
 #include <memory.h>
@@ -290,15 +291,20 @@ bool Device_field_change(
             Sample* sample = NULL;
             if (data != NULL)
             {
-                sample = new_Sample();
-                if (sample == NULL)
-                    return false;
+                const Memory_category prev_category =
+                    memory_set_category(MEMORY_CATEGORY_SAMPLES);
 
-                if (!Sample_parse_wavpack(sample, sr, bkg_loader))
+                sample = new_Sample();
+                if ((sample != NULL) && !Sample_parse_wavpack(sample, sr, bkg_loader))
                 {
                     del_Sample(sample);
-                    return false;
+                    sample = NULL;
                 }
+
+                memory_set_category(prev_category);
+
+                if (sample == NULL)
+                    return false;
             }
 
             rassert(!Streader_is_error_set(sr));
@@ -314,15 +320,20 @@ bool Device_field_change(
             Sample* sample = NULL;
             if (data != NULL)
             {
-                sample = new_Sample();
-                if (sample == NULL)
-                    return false;
+                const Memory_category prev_category =
+                    memory_set_category(MEMORY_CATEGORY_SAMPLES);
 
-                if (!Sample_parse_wav(sample, sr))
+                sample = new_Sample();
+                if ((sample != NULL) && !Sample_parse_wav(sample, sr))
                 {
                     del_Sample(sample);
-                    return false;
+                    sample = NULL;
                 }
+
+                memory_set_category(prev_category);
+
+                if (sample == NULL)
+                    return false;
             }
 
             rassert(!Streader_is_error_set(sr));
@@ -552,6 +563,56 @@ const Sample* Device_field_get_sample(const Device_field* field)
 }
 
 
+static void build_sample_mips(Error* error, void* user_data)
+{
+    rassert(error != NULL);
+    rassert(user_data != NULL);
+
+    // Mip levels are optional, so failed allocation is not an error
+    Sample* sample = user_data;
+    Sample_build_mips(sample);
+
+    return;
+}
+
+
+static void finish_sample_mips(Error* error, void* user_data)
+{
+    rassert(error != NULL);
+    rassert(user_data != NULL);
+
+    return;
+}
+
+
+void Device_field_build_sample_mips(Device_field* field, Background_loader* bkg_loader)
+{
+    rassert(field != NULL);
+    rassert(bkg_loader != NULL);
+
+    if ((field->type != DEVICE_FIELD_WAVPACK) && (field->type != DEVICE_FIELD_WAV))
+        return;
+
+    Sample* sample = field->data.Sample_type;
+    if (field->empty || (sample == NULL) || (sample->mip_count > 0))
+        return;
+
+    const int64_t sample_size = sample->len * sample->channels * (sample->bits / 8);
+
+    Background_loader_task* task = MAKE_BACKGROUND_LOADER_TASK(
+            build_sample_mips, finish_sample_mips, sample, sample_size);
+
+    if (!Background_loader_add_task(bkg_loader, task))
+    {
+        Error* error = ERROR_AUTO;
+        build_sample_mips(error, sample);
+        finish_sample_mips(error, sample);
+    }
+
+    return;
+}
+
+
 const Sample_params* Device_field_get_sample_params(const Device_field* field)
 {
     rassert(field != NULL);
@@ -1,7 +1,7 @@
 
 
 /*
- * Author: Tomi Jylhä-Ollila, Finland 2010-2018
+ * Author: Tomi Jylhä-Ollila, Finland 2010-2019
  *
  * This file is part of Kunquat.
  *
@@ -231,6 +231,19 @@ const Envelope* Device_field_get_envelope(const Device_field* field);
 const Sample* Device_field_get_sample(const Device_field* field);
 
 
+/**
+ * Start building the mip levels of a Sample in the Device field.
+ *
+ * The levels are built in a task of the Background loader, so they are only
+ * available after \a Background_loader_wait_idle has been called. Mip levels
+ * are optional, so the Sample remains usable if memory allocation fails.
+ *
+ * \param field        The Device field -- must not be \c NULL.
+ * \param bkg_loader   The Background loader -- must not be \c NULL.
+ */
+void Device_field_build_sample_mips(Device_field* field, Background_loader* bkg_loader);
+
+
 /**
  * Get Sample parameters from the Device field.
  *
@@ -72,6 +72,7 @@ bool Device_impl_init(Device_impl* dimpl, Device_impl_destroy_func* destroy)
     dimpl->get_voice_wb_size = NULL;
     dimpl->init_vstate = NULL;
     dimpl->render_voice = NULL;
+    dimpl->render_voices = NULL;
     dimpl->fire_voice_dev_event = NULL;
     dimpl->destroy = destroy;
 
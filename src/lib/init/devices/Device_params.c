@@ -1,7 +1,7 @@
 
 
 /*
- * Author: Tomi Jylhä-Ollila, Finland 2010-2018
+ * Author: Tomi Jylhä-Ollila, Finland 2010-2019
  *
  * This file is part of Kunquat.
  *
@@ -410,6 +410,36 @@ const Padsynth_params* Device_params_get_padsynth_params(
 #undef get_of_type
 
 
+static void build_sample_mips(AAtree* fields, Background_loader* bkg_loader)
+{
+    rassert(fields != NULL);
+    rassert(bkg_loader != NULL);
+
+    AAiter* iter = AAiter_init(AAITER_AUTO, fields);
+    Device_field* field = AAiter_get_at_least(iter, "");
+    while (field != NULL)
+    {
+        Device_field_build_sample_mips(field, bkg_loader);
+        field = AAiter_get_next(iter);
+    }
+
+    return;
+}
+
+
+void Device_params_build_sample_mips(
+        Device_params* params, Background_loader* bkg_loader)
+{
+    rassert(params != NULL);
+    rassert(bkg_loader != NULL);
+
+    build_sample_mips(params->implement, bkg_loader);
+    build_sample_mips(params->config, bkg_loader);
+
+    return;
+}
+
+
 void del_Device_params(Device_params* params)
 {
     if (params == NULL)
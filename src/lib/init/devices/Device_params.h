@@ -1,7 +1,7 @@
 
 
 /*
- * Author: Tomi Jylhä-Ollila, Finland 2010-2018
+ * Author: Tomi Jylhä-Ollila, Finland 2010-2019
  *
  * This file is part of Kunquat.
  *
@@ -384,6 +384,18 @@ const Padsynth_params* Device_params_get_padsynth_params(
         const Device_params* params, const char* key);
 
 
+/**
+ * Start building the mip levels of all Samples in the Device parameters.
+ *
+ * \see Device_field_build_sample_mips
+ *
+ * \param params       The Device parameters -- must not be \c NULL.
+ * \param bkg_loader   The Background loader -- must not be \c NULL.
+ */
+void Device_params_build_sample_mips(
+        Device_params* params, Background_loader* bkg_loader);
+
+
 /**
  * Destroy existing Device parameters.
  *
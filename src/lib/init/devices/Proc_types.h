@@ -22,6 +22,7 @@ PROC_TYPE(debug)
 PROC_TYPE(add)
 PROC_TYPE(bitcrusher)
 PROC_TYPE(compress)
+PROC_TYPE(convolve)
 PROC_TYPE(delay)
 PROC_TYPE(envgen)
 PROC_TYPE(filter)
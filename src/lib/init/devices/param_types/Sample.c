@@ -1,7 +1,7 @@
 
 
 /*
- * Author: Tomi Jylhä-Ollila, Finland 2010-2016
+ * Author: Tomi Jylhä-Ollila, Finland 2010-2019
  *
  * This file is part of Kunquat.
  *
@@ -14,13 +14,179 @@
 
 #include <init/devices/param_types/Sample.h>
 
+#include <containers/AAtree.h>
 #include <debug/assert.h>
+#include <mathnum/common.h>
 #include <memory.h>
+#include <threads/Mutex.h>
 
+#include <math.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+
+struct Shared_sample_data
+{
+    uint64_t id;
+    char* source;
+    int64_t source_size;
+    int ref_count;
+    int channels;
+    int bits;
+    bool is_float;
+    int64_t len;
+    void* data[2];
+    int mip_count;
+    Sample* mips[SAMPLE_MIP_LEVELS_MAX];
+};
+
+
+#define SHARED_SAMPLE_DATA_KEY(id_value) (&(Shared_sample_data){ .id = (id_value) })
+
+
+static int Shared_sample_data_cmp(const void* v1, const void* v2)
+{
+    rassert(v1 != NULL);
+    rassert(v2 != NULL);
+
+    const Shared_sample_data* d1 = v1;
+    const Shared_sample_data* d2 = v2;
+
+    if (d1->id < d2->id)
+        return -1;
+    else if (d1->id > d2->id)
+        return 1;
+    return 0;
+}
+
+
+#ifdef ENABLE_THREADS
+static Mutex shared_data_lock = MUTEX_STATIC_INIT;
+#endif
+static AAtree* shared_datas = NULL;
+static int shared_data_count = 0;
+
+
+static void lock_shared_datas(void)
+{
+#ifdef ENABLE_THREADS
+    Mutex_lock(&shared_data_lock);
+#endif
+    return;
+}
+
+
+static void unlock_shared_datas(void)
+{
+#ifdef ENABLE_THREADS
+    Mutex_unlock(&shared_data_lock);
+#endif
+    return;
+}
+
+
+static bool Shared_sample_data_has_source(
+        const Shared_sample_data* shared, const void* source, int64_t source_size)
+{
+    rassert(shared != NULL);
+    rassert(source != NULL);
+    rassert(source_size >= 0);
+
+    // The identifier is only a hash, so check that the inputs really match
+    return (shared->source_size == source_size) &&
+        (memcmp(shared->source, source, (size_t)source_size) == 0);
+}
+
+
+static void release_shared_data(Shared_sample_data* shared)
+{
+    rassert(shared != NULL);
+
+    lock_shared_datas();
+
+    rassert(shared->ref_count > 0);
+    --shared->ref_count;
+    if (shared->ref_count > 0)
+    {
+        unlock_shared_datas();
+        return;
+    }
+
+    rassert(shared_datas != NULL);
+    const Shared_sample_data* removed = AAtree_remove(shared_datas, shared);
+    rassert(removed == shared);
+    --shared_data_count;
+    if (shared_data_count == 0)
+    {
+        del_AAtree(shared_datas);
+        shared_datas = NULL;
+    }
+
+    unlock_shared_datas();
+
+    memory_free(shared->source);
+    memory_free(shared->data[0]);
+    memory_free(shared->data[1]);
+    for (int i = 0; i < shared->mip_count; ++i)
+        del_Sample(shared->mips[i]);
+    memory_free(shared);
+
+    return;
+}
+
+
+static void Sample_release_data(Sample* sample)
+{
+    rassert(sample != NULL);
+
+    if (sample->shared != NULL)
+    {
+        release_shared_data(sample->shared);
+        sample->shared = NULL;
+    }
+    else
+    {
+        memory_free(sample->data[0]);
+        memory_free(sample->data[1]);
+        for (int i = 0; i < sample->mip_count; ++i)
+            del_Sample(sample->mips[i]);
+    }
+
+    sample->data[0] = NULL;
+    sample->data[1] = NULL;
+    sample->mip_count = 0;
+    for (int i = 0; i < SAMPLE_MIP_LEVELS_MAX; ++i)
+        sample->mips[i] = NULL;
+
+    return;
+}
+
+
+static void Sample_set_shared_data(Sample* sample, Shared_sample_data* shared)
+{
+    rassert(sample != NULL);
+    rassert(shared != NULL);
+
+    sample->channels = shared->channels;
+    sample->bits = shared->bits;
+    sample->is_float = shared->is_float;
+    sample->len = shared->len;
+    sample->data[0] = shared->data[0];
+    sample->data[1] = shared->data[1];
+    sample->shared = shared;
+
+    // Mip levels may be added to the shared data later
+    lock_shared_datas();
+    sample->mip_count = shared->mip_count;
+    for (int i = 0; i < SAMPLE_MIP_LEVELS_MAX; ++i)
+        sample->mips[i] = shared->mips[i];
+    unlock_shared_datas();
+
+    return;
+}
 
 
 Sample* new_Sample(void)
@@ -39,6 +205,10 @@ Sample* new_Sample(void)
     sample->len = 0;
     sample->data[0] = NULL;
     sample->data[1] = NULL;
+    sample->shared = NULL;
+    sample->mip_count = 0;
+    for (int i = 0; i < SAMPLE_MIP_LEVELS_MAX; ++i)
+        sample->mips[i] = NULL;
 
     return sample;
 }
@@ -85,14 +255,488 @@ int64_t Sample_get_len(const Sample* sample)
     return sample->len;
 }
 
+// Mip levels are not created from data shorter than this
+#define MIP_SOURCE_LENGTH_MIN 64
+
+#define MIP_FILTER_EXTENT 7
+
+
+static void Sample_remove_mips(Sample* sample)
+{
+    rassert(sample != NULL);
+    rassert(sample->shared == NULL);
+
+    for (int i = 0; i < sample->mip_count; ++i)
+    {
+        del_Sample(sample->mips[i]);
+        sample->mips[i] = NULL;
+    }
+    sample->mip_count = 0;
+
+    return;
+}
+
+
+static bool Sample_alloc_mips(Sample* sample)
+{
+    rassert(sample != NULL);
+    rassert(sample->data[0] != NULL);
+    rassert(sample->shared == NULL);
+
+    Sample_remove_mips(sample);
+
+    const int64_t item_size = sample->bits / 8;
+
+    int64_t source_len = sample->len;
+    while ((sample->mip_count < SAMPLE_MIP_LEVELS_MAX) &&
+            (source_len >= MIP_SOURCE_LENGTH_MIN))
+    {
+        Sample* mip = new_Sample();
+        if (mip == NULL)
+        {
+            Sample_remove_mips(sample);
+            return false;
+        }
+
+        sample->mips[sample->mip_count] = mip;
+        ++sample->mip_count;
+
+        mip->channels = sample->channels;
+        mip->bits = sample->bits;
+        mip->is_float = sample->is_float;
+        mip->len = (source_len + 1) / 2;
+
+        for (int ch = 0; ch < sample->channels; ++ch)
+        {
+            mip->data[ch] = memory_alloc_items(char, mip->len * item_size);
+            if (mip->data[ch] == NULL)
+            {
+                Sample_remove_mips(sample);
+                return false;
+            }
+        }
+
+        source_len = mip->len;
+    }
+
+    return true;
+}
+
+
+#define make_mip_level(type, is_int, item_min, item_max)                    \
+    if (true)                                                               \
+    {                                                                       \
+        const type* src = source->data[ch];                                 \
+        type* dest = mip->data[ch];                                         \
+                                                                            \
+        for (int64_t i = 0; i < mip->len; ++i)                              \
+        {                                                                   \
+            const int64_t center = i * 2;                                   \
+            double value = coeffs[0] * (double)src[center];                 \
+            for (int k = 1; k <= MIP_FILTER_EXTENT; k += 2)                 \
+            {                                                               \
+                const int64_t prev = center - k;                            \
+                const int64_t next = center + k;                            \
+                if (prev >= 0)                                              \
+                    value += coeffs[k] * (double)src[prev];                 \
+                if (next < source->len)                                     \
+                    value += coeffs[k] * (double)src[next];                 \
+            }                                                               \
+                                                                            \
+            const double rounded = (is_int) ? floor(value + 0.5) : value;   \
+            dest[i] = (type)clamp(rounded, (item_min), (item_max));         \
+        }                                                                   \
+    }                                                                       \
+    else ignore(0)
+
+static void Sample_make_mips(Sample* sample)
+{
+    rassert(sample != NULL);
+    rassert(sample->shared == NULL);
+
+    if (sample->mip_count == 0)
+        return;
+
+    // Halfband lowpass filter with a Blackman window, every other coefficient
+    // except the centre one is zero
+    double coeffs[MIP_FILTER_EXTENT + 1] = { 0 };
+    double coeff_sum = 0.5;
+    coeffs[0] = 0.5;
+    for (int k = 1; k <= MIP_FILTER_EXTENT; k += 2)
+    {
+        const double x = k * 0.5 * PI;
+        const double w = (k + MIP_FILTER_EXTENT + 1) * PI / (MIP_FILTER_EXTENT + 1);
+        const double window = 0.42 - 0.5 * cos(w) + 0.08 * cos(2 * w);
+        coeffs[k] = 0.5 * (sin(x) / x) * window;
+        coeff_sum += 2 * coeffs[k];
+    }
+    for (int k = 0; k <= MIP_FILTER_EXTENT; ++k)
+        coeffs[k] /= coeff_sum;
+
+    const Sample* source = sample;
+    for (int level = 0; level < sample->mip_count; ++level)
+    {
+        Sample* mip = sample->mips[level];
+        rassert(mip != NULL);
+        rassert(mip->len == (source->len + 1) / 2);
+
+        for (int ch = 0; ch < sample->channels; ++ch)
+        {
+            if (sample->is_float)
+            {
+                make_mip_level(float, false, -INFINITY, INFINITY);
+            }
+            else if (sample->bits == 8)
+            {
+                make_mip_level(int8_t, true, INT8_MIN, INT8_MAX);
+            }
+            else if (sample->bits == 16)
+            {
+                make_mip_level(int16_t, true, INT16_MIN, INT16_MAX);
+            }
+            else
+            {
+                rassert(sample->bits == 32);
+                make_mip_level(int32_t, true, INT32_MIN, INT32_MAX);
+            }
+        }
+
+        source = mip;
+    }
+
+    return;
+}
+
+#undef make_mip_level
+
+
+static bool build_shared_mips(Sample* sample)
+{
+    rassert(sample != NULL);
+    rassert(sample->shared != NULL);
+
+    Shared_sample_data* shared = sample->shared;
+
+    // Build the levels from a private view of the shared data
+    Sample* view = &(Sample){ .mip_count = 0 };
+    view->channels = sample->channels;
+    view->bits = sample->bits;
+    view->is_float = sample->is_float;
+    view->len = sample->len;
+    view->data[0] = sample->data[0];
+    view->data[1] = sample->data[1];
+    view->shared = NULL;
+
+    // The levels belong to all users of the shared data
+    Memory_usage* prev_usage = memory_set_usage(memory_get_shared_usage());
+    const Memory_category prev_category = memory_set_category(MEMORY_CATEGORY_SAMPLES);
+    const bool allocated = Sample_alloc_mips(view);
+    memory_set_category(prev_category);
+    memory_set_usage(prev_usage);
+    if (!allocated)
+        return false;
+
+    Sample_make_mips(view);
+
+    lock_shared_datas();
+
+    // Another user may have built the levels in the meantime
+    const bool is_installed = (shared->mip_count == 0);
+    if (is_installed)
+    {
+        shared->mip_count = view->mip_count;
+        for (int i = 0; i < SAMPLE_MIP_LEVELS_MAX; ++i)
+            shared->mips[i] = view->mips[i];
+    }
+
+    sample->mip_count = shared->mip_count;
+    for (int i = 0; i < SAMPLE_MIP_LEVELS_MAX; ++i)
+        sample->mips[i] = shared->mips[i];
+
+    unlock_shared_datas();
+
+    if (!is_installed)
+    {
+        for (int i = 0; i < view->mip_count; ++i)
+            del_Sample(view->mips[i]);
+    }
+
+    return true;
+}
+
+
+bool Sample_build_mips(Sample* sample)
+{
+    rassert(sample != NULL);
+
+    if ((sample->mip_count > 0) || (sample->data[0] == NULL))
+        return true;
+
+    if (sample->shared != NULL)
+        return build_shared_mips(sample);
+
+    if (!Sample_alloc_mips(sample))
+        return false;
+
+    Sample_make_mips(sample);
+
+    return true;
+}
+
+
+const Sample* Sample_get_mip(const Sample* sample, int level)
+{
+    rassert(sample != NULL);
+    rassert(level >= 0);
+    rassert(level <= sample->mip_count);
+
+    if (level == 0)
+        return sample;
+
+    return sample->mips[level - 1];
+}
+
+
+int Sample_get_mip_level(
+        const Sample* sample,
+        Sample_loop loop_mode,
+        const Sample_params* params,
+        double max_shift)
+{
+    rassert(sample != NULL);
+    rassert(params != NULL);
+
+    int level = 0;
+    while ((level < sample->mip_count) && (max_shift >= (double)(2 << level)))
+        ++level;
+
+    if (loop_mode != SAMPLE_LOOP_OFF)
+    {
+        while (level > 0)
+        {
+            const int64_t mask = (1 << level) - 1;
+            const int64_t mip_loop_len = (params->loop_end - params->loop_start) >> level;
+            if (((params->loop_start & mask) == 0) &&
+                    ((params->loop_end & mask) == 0) &&
+                    (mip_loop_len >= 2))
+                break;
+
+            --level;
+        }
+    }
+
+    return level;
+}
+
+
+bool Sample_use_shared_data(
+        Sample* sample, uint64_t id, const void* source, int64_t source_size)
+{
+    rassert(sample != NULL);
+    rassert(source != NULL);
+    rassert(source_size >= 0);
+
+    if ((sample->shared != NULL) &&
+            (sample->shared->id == id) &&
+            Shared_sample_data_has_source(sample->shared, source, source_size))
+        return true;
+
+    lock_shared_datas();
+
+    Shared_sample_data* shared = NULL;
+    if (shared_datas != NULL)
+        shared = AAtree_get_exact(shared_datas, SHARED_SAMPLE_DATA_KEY(id));
+    if ((shared != NULL) &&
+            !Shared_sample_data_has_source(shared, source, source_size))
+        shared = NULL;
+    if (shared != NULL)
+        ++shared->ref_count;
+
+    unlock_shared_datas();
+
+    if (shared == NULL)
+        return false;
+
+    Sample_release_data(sample);
+    Sample_set_shared_data(sample, shared);
+
+    return true;
+}
+
+
+static void Sample_transfer_data(Sample* sample, Memory_usage* usage)
+{
+    rassert(sample != NULL);
+
+    memory_transfer(sample->data[0], usage);
+    memory_transfer(sample->data[1], usage);
+    for (int i = 0; i < sample->mip_count; ++i)
+    {
+        Sample_transfer_data(sample->mips[i], usage);
+        memory_transfer(sample->mips[i], usage);
+    }
+
+    return;
+}
+
+
+static void share_data(
+        Sample* sample, uint64_t id, const void* source, int64_t source_size)
+{
+    rassert(sample != NULL);
+    rassert(sample->data[0] != NULL);
+    rassert(sample->shared == NULL);
+    rassert(source != NULL);
+    rassert(source_size >= 0);
+
+    lock_shared_datas();
+
+    if (shared_datas == NULL)
+    {
+        shared_datas = new_AAtree(Shared_sample_data_cmp, memory_free);
+        if (shared_datas == NULL)
+        {
+            unlock_shared_datas();
+            return;
+        }
+    }
+
+    Shared_sample_data* shared =
+        AAtree_get_exact(shared_datas, SHARED_SAMPLE_DATA_KEY(id));
+    if (shared != NULL)
+    {
+        // Only switch to data that is known to be interchangeable
+        if (!Shared_sample_data_has_source(shared, source, source_size) ||
+                (shared->channels != sample->channels) ||
+                (shared->bits != sample->bits) ||
+                (shared->is_float != sample->is_float) ||
+                (shared->len != sample->len))
+        {
+            unlock_shared_datas();
+            return;
+        }
+
+        ++shared->ref_count;
+        unlock_shared_datas();
+
+        Sample_release_data(sample);
+        Sample_set_shared_data(sample, shared);
+
+        return;
+    }
+
+    shared = memory_alloc_item(Shared_sample_data);
+    char* shared_source = memory_alloc_items(char, max(source_size, 1));
+    if ((shared == NULL) || (shared_source == NULL))
+    {
+        memory_free(shared);
+        memory_free(shared_source);
+        if (shared_data_count == 0)
+        {
+            del_AAtree(shared_datas);
+            shared_datas = NULL;
+        }
+        unlock_shared_datas();
+        return;
+    }
+
+    memcpy(shared_source, source, (size_t)source_size);
+
+    shared->id = id;
+    shared->source = shared_source;
+    shared->source_size = source_size;
+    shared->ref_count = 1;
+    shared->channels = sample->channels;
+    shared->bits = sample->bits;
+    shared->is_float = sample->is_float;
+    shared->len = sample->len;
+    shared->data[0] = sample->data[0];
+    shared->data[1] = sample->data[1];
+    shared->mip_count = sample->mip_count;
+    for (int i = 0; i < SAMPLE_MIP_LEVELS_MAX; ++i)
+        shared->mips[i] = sample->mips[i];
+
+    if (!AAtree_ins(shared_datas, shared))
+    {
+        memory_free(shared_source);
+        memory_free(shared);
+        if (shared_data_count == 0)
+        {
+            del_AAtree(shared_datas);
+            shared_datas = NULL;
+        }
+        unlock_shared_datas();
+        return;
+    }
+
+    ++shared_data_count;
+    sample->shared = shared;
+
+    // The data now outlives the Handle that loaded it
+    Sample_transfer_data(sample, memory_get_shared_usage());
+
+    unlock_shared_datas();
+
+    return;
+}
+
+
+void Sample_share_data(
+        Sample* sample, uint64_t id, const void* source, int64_t source_size)
+{
+    rassert(sample != NULL);
+
+    // The registry is shared by all Handles, so it is charged to none of them
+    Memory_usage* prev_usage = memory_set_usage(memory_get_shared_usage());
+    const Memory_category prev_category = memory_set_category(MEMORY_CATEGORY_SAMPLES);
+    share_data(sample, id, source, source_size);
+    memory_set_category(prev_category);
+    memory_set_usage(prev_usage);
+
+    return;
+}
+
+
+bool Sample_unshare_data(Sample* sample)
+{
+    rassert(sample != NULL);
+
+    if (sample->shared == NULL)
+        return true;
+
+    const int64_t buf_size = sample->len * (sample->bits / 8);
+
+    void* data[2] = { NULL };
+    for (int ch = 0; ch < sample->channels; ++ch)
+    {
+        data[ch] = memory_alloc_items(char, buf_size);
+        if (data[ch] == NULL)
+        {
+            memory_free(data[0]);
+            return false;
+        }
+
+        memcpy(data[ch], sample->data[ch], (size_t)buf_size);
+    }
+
+    release_shared_data(sample->shared);
+    sample->shared = NULL;
+    sample->data[0] = data[0];
+    sample->data[1] = data[1];
+    sample->mip_count = 0;
+    for (int i = 0; i < SAMPLE_MIP_LEVELS_MAX; ++i)
+        sample->mips[i] = NULL;
+
+    return true;
+}
+
 
 void del_Sample(Sample* sample)
 {
     if (sample == NULL)
         return;
 
-    memory_free(sample->data[0]);
-    memory_free(sample->data[1]);
+    Sample_release_data(sample);
     memory_free(sample);
 
     return;
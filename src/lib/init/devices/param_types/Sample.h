@@ -1,7 +1,7 @@
 
 
 /*
- * Author: Tomi Jylhä-Ollila, Finland 2010-2016
+ * Author: Tomi Jylhä-Ollila, Finland 2010-2019
  *
  * This file is part of Kunquat.
  *
@@ -24,8 +24,25 @@
 #include <stdlib.h>
 
 
+typedef struct Shared_sample_data Shared_sample_data;
+
+
+#define SAMPLE_MIP_LEVELS_MAX 3
+
+
 /**
  * Sample contains a digital sound sample.
+ *
+ * Sample data that is derived from module data, such as decoded samples and
+ * generated PADsynth tables, may be shared between all Samples in the process
+ * that are derived from identical inputs. Shared data is identified with the
+ * same identifiers as Snapshot entries and must not be modified; a Sample
+ * must call \a Sample_unshare_data before writing to its buffers.
+ *
+ * A Sample may also contain mip levels, which are versions of the sample data
+ * lowpass filtered and decimated to half of the rate of the previous level.
+ * They are used for playback at high pitch ratios, built only on request
+ * and shared along with the sample data.
  */
 struct Sample
 {
@@ -38,6 +55,9 @@ struct Sample
     bool is_float;        ///< Whether this sample is in floating point format.
     int64_t len;          ///< The length of the sample (in amplitude values per channel).
     void* data[2];        ///< The sample data.
+    Shared_sample_data* shared; ///< The shared data entry, or \c NULL if the data is private.
+    int mip_count;        ///< The number of mip levels.
+    Sample* mips[SAMPLE_MIP_LEVELS_MAX]; ///< The mip levels, starting at half rate.
 };
 
 
@@ -90,6 +110,111 @@ int64_t Sample_get_len(const Sample* sample);
 void* Sample_get_buffer(Sample* sample, int ch);
 
 
+/**
+ * Build the mip levels of the Sample.
+ *
+ * Mip levels are only needed by processors that enable them, so they are
+ * built on demand outside rendering. If the Sample uses shared data, the
+ * levels are built once and shared by all users of the data. Levels are not
+ * created for very short sample data. Calling this function again after a
+ * successful call has no effect.
+ *
+ * \param sample   The Sample -- must not be \c NULL.
+ *
+ * \return   \c true if successful, or \c false if memory allocation failed.
+ *           In the latter case \a sample has no mip levels.
+ */
+bool Sample_build_mips(Sample* sample);
+
+
+/**
+ * Get a mip level of the Sample.
+ *
+ * \param sample   The Sample -- must not be \c NULL.
+ * \param level    The mip level -- must be >= \c 0 and not greater than the
+ *                 number of mip levels in \a sample. Level \c 0 is
+ *                 \a sample itself.
+ *
+ * \return   The mip level.
+ */
+const Sample* Sample_get_mip(const Sample* sample, int level);
+
+
+/**
+ * Choose the mip level for rendering the Sample.
+ *
+ * The level is chosen so that the pitch ratio stays below 2 if possible.
+ * With a loop enabled, levels where the loop start or end is not a multiple
+ * of the level step, or where the loop would be shorter than 2 frames, are
+ * not used.
+ *
+ * \param sample      The Sample -- must not be \c NULL.
+ * \param loop_mode   The loop mode.
+ * \param params      The Sample parameters -- must not be \c NULL.
+ * \param max_shift   The largest pitch ratio used in rendering.
+ *
+ * \return   The mip level, between \c 0 and the number of mip levels in
+ *           \a sample.
+ */
+int Sample_get_mip_level(
+        const Sample* sample,
+        Sample_loop loop_mode,
+        const Sample_params* params,
+        double max_shift);
+
+
+/**
+ * Replace the data of the Sample with shared data.
+ *
+ * Shared data is only used if it was derived from the same source, so an
+ * identifier collision cannot cause data of another Sample to be used.
+ *
+ * \param sample        The Sample -- must not be \c NULL.
+ * \param id            The identifier of the data, i.e. a hash of \a source.
+ * \param source        The description of the inputs the data is derived
+ *                      from -- must not be \c NULL.
+ * \param source_size   The size of \a source in bytes -- must be >= \c 0.
+ *
+ * \return   \c true if shared data derived from \a source was found, or
+ *           \c false if the Sample was not modified.
+ */
+bool Sample_use_shared_data(
+        Sample* sample, uint64_t id, const void* source, int64_t source_size);
+
+
+/**
+ * Make the data of the Sample available to other Samples.
+ *
+ * If data derived from the same source is already shared, the Sample starts
+ * using that data instead and its own buffers are released. A copy of
+ * \a source is kept for comparison. Failure to share is not an error, the
+ * Sample keeps its private data in that case.
+ *
+ * \param sample        The Sample -- must not be \c NULL, must contain data
+ *                      and must not use shared data.
+ * \param id            The identifier of the data, i.e. a hash of \a source.
+ * \param source        The description of the inputs the data is derived
+ *                      from -- must not be \c NULL.
+ * \param source_size   The size of \a source in bytes -- must be >= \c 0.
+ */
+void Sample_share_data(
+        Sample* sample, uint64_t id, const void* source, int64_t source_size);
+
+
+/**
+ * Give the Sample a private copy of its data if the data is shared.
+ *
+ * Shared mip levels are removed from the Sample, as they would no longer
+ * match the data after it is modified.
+ *
+ * \param sample   The Sample -- must not be \c NULL.
+ *
+ * \return   \c true if the data of \a sample is private, or \c false if
+ *           memory allocation failed.
+ */
+bool Sample_unshare_data(Sample* sample);
+
+
 /**
  * Destroy a Sample.
  *
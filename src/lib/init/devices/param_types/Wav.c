@@ -1,7 +1,7 @@
 
 
 /*
- * Author: Tomi Jylhä-Ollila, Finland 2015-2016
+ * Author: Tomi Jylhä-Ollila, Finland 2015-2019
  *
  * This file is part of Kunquat.
  *
@@ -21,6 +21,7 @@
 #include <string/Streader.h>
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -28,6 +29,48 @@
 
 #ifndef WITH_SNDFILE
 
+// Without libsndfile, uncompressed PCM and 32-bit floating point data are read directly
+
+#define WAV_FORMAT_PCM 1
+#define WAV_FORMAT_FLOAT 3
+#define WAV_FORMAT_EXTENSIBLE 0xfffe
+
+
+static uint32_t read_le(const unsigned char* src, int bytes)
+{
+    rassert(src != NULL);
+    rassert(bytes >= 1);
+    rassert(bytes <= 4);
+
+    uint32_t value = 0;
+    for (int i = 0; i < bytes; ++i)
+        value |= (uint32_t)src[i] << (i * 8);
+
+    return value;
+}
+
+
+static float read_item(const unsigned char* src, int format, int item_size)
+{
+    rassert(src != NULL);
+
+    if (format == WAV_FORMAT_FLOAT)
+    {
+        const uint32_t bits = read_le(src, 4);
+        float value = 0;
+        memcpy(&value, &bits, sizeof(float));
+        return value;
+    }
+
+    // 8-bit data is unsigned, other sizes are signed
+    if (item_size == 1)
+        return ((float)src[0] - 128.0f) / 128.0f;
+
+    const int32_t value = (int32_t)(read_le(src, item_size) << (32 - item_size * 8));
+    return (float)((double)value / 2147483648.0);
+}
+
+
 bool Sample_parse_wav(Sample* sample, Streader* sr)
 {
     rassert(sample != NULL);
@@ -36,11 +79,106 @@ bool Sample_parse_wav(Sample* sample, Streader* sr)
     if (Streader_is_error_set(sr))
         return false;
 
-    Streader_set_error(sr, "This build of libkunquat does not support WAV.");
+    const unsigned char* data = (const unsigned char*)sr->str;
+    const int64_t length = sr->len;
+
+    if ((length < 12) ||
+            (memcmp(data, "RIFF", 4) != 0) ||
+            (memcmp(data + 8, "WAVE", 4) != 0))
+    {
+        Streader_set_error(sr, "Data is not a WAV file");
+        return false;
+    }
+
+    // Find the format and the frames
+    int format = 0;
+    int channels = 0;
+    int item_size = 0;
+    const unsigned char* frames = NULL;
+    int64_t frames_size = 0;
+
+    int64_t pos = 12;
+    while (pos + 8 <= length)
+    {
+        const unsigned char* chunk = data + pos;
+        const int64_t chunk_size = read_le(chunk + 4, 4);
+        const int64_t avail_size = min(chunk_size, length - pos - 8);
+
+        if ((memcmp(chunk, "fmt ", 4) == 0) && (avail_size >= 16))
+        {
+            format = (int)read_le(chunk + 8, 2);
+            channels = (int)read_le(chunk + 10, 2);
+            item_size = (int)read_le(chunk + 22, 2) / 8;
+
+            if ((format == WAV_FORMAT_EXTENSIBLE) && (avail_size >= 26))
+                format = (int)read_le(chunk + 32, 2);
+        }
+        else if (memcmp(chunk, "data", 4) == 0)
+        {
+            frames = chunk + 8;
+            frames_size = avail_size;
+        }
 
-    return false;
+        // Chunks are padded to even sizes
+        pos += 8 + chunk_size + (chunk_size & 1);
+    }
+
+    const bool is_format_supported =
+        ((format == WAV_FORMAT_PCM) && (item_size >= 1) && (item_size <= 4)) ||
+        ((format == WAV_FORMAT_FLOAT) && (item_size == 4));
+    if (!is_format_supported)
+    {
+        Streader_set_error(sr,
+                "This build of libkunquat only supports uncompressed PCM"
+                " and 32-bit floating point WAV data.");
+        return false;
+    }
+
+    if ((channels != 1) && (channels != 2))
+    {
+        Streader_set_error(
+                sr, "Unsupported amount of channels (%d) in the data", channels);
+        return false;
+    }
+
+    if (frames == NULL)
+    {
+        Streader_set_error(sr, "WAV data does not contain frames");
+        return false;
+    }
+
+    // Initialise the sample fields
+    sample->channels = channels;
+    sample->bits = 32;
+    sample->is_float = true;
+    sample->len = frames_size / (channels * item_size);
+    sample->data[0] = sample->data[1] = NULL;
+
+    for (int ch = 0; ch < channels; ++ch)
+    {
+        float* buf = memory_alloc_items(float, sample->len);
+        if (buf == NULL)
+        {
+            memory_free(sample->data[0]);
+            sample->data[0] = NULL;
+            Streader_set_memory_error(sr, "Could not allocate memory for sample");
+            return false;
+        }
+
+        for (int64_t i = 0; i < sample->len; ++i)
+            buf[i] = read_item(
+                    frames + (i * channels + ch) * item_size, format, item_size);
+
+        sample->data[ch] = buf;
+    }
+
+    return true;
 }
 
+#undef WAV_FORMAT_PCM
+#undef WAV_FORMAT_FLOAT
+#undef WAV_FORMAT_EXTENSIBLE
+
 #else
 
 
@@ -1,7 +1,7 @@
 
 
 /*
- * Author: Tomi Jylhä-Ollila, Finland 2010-2018
+ * Author: Tomi Jylhä-Ollila, Finland 2010-2019
  *
  * This file is part of Kunquat.
  *
@@ -17,6 +17,7 @@
 #include <debug/assert.h>
 #include <init/Background_loader.h>
 #include <init/devices/param_types/Sample.h>
+#include <init/Snapshot.h>
 #include <mathnum/common.h>
 #include <memory.h>
 
@@ -219,6 +220,9 @@ typedef struct Callback_data
     void* copied_data;
     Sample* sample;
     String_context sc;
+    Snapshot* snapshot;
+    uint64_t snapshot_id;
+    const Background_loader* bkg_loader;
 } Callback_data;
 
 
@@ -238,6 +242,9 @@ static Callback_data* new_Callback_data(void)
     cb_data->context = NULL;
     cb_data->copied_data = NULL;
     cb_data->sample = NULL;
+    cb_data->snapshot = NULL;
+    cb_data->snapshot_id = 0;
+    cb_data->bkg_loader = NULL;
 
     return cb_data;
 }
@@ -291,7 +298,8 @@ static void load_wavpack_data(Error* error, void* user_data)
     int64_t read = WavpackUnpackSamples(
             cb_data->context, buf, (uint32_t)(WAVPACK_BUFFER_SIZE / sample->channels));
     int64_t written = 0;
-    while (read > 0 && written < sample->len)
+    bool is_cancelled = false;
+    while (read > 0 && written < sample->len && !is_cancelled)
     {
         if (req_bytes == 1)
         {
@@ -329,11 +337,23 @@ static void load_wavpack_data(Error* error, void* user_data)
                 cb_data->context,
                 buf,
                 (uint32_t)(WAVPACK_BUFFER_SIZE / sample->channels));
+
+        is_cancelled = Background_loader_is_cancelled(cb_data->bkg_loader);
     }
 
 #undef WAVPACK_BUFFER_SIZE
 
-    if (written < sample->len)
+    if (is_cancelled)
+    {
+        Error_set_desc(
+                error,
+                ERROR_RESOURCE,
+                __FILE__,
+                __LINE__,
+                __func__,
+                "WavPack decoding was cancelled");
+    }
+    else if (written < sample->len)
     {
         Error_set_desc(
                 error,
@@ -362,6 +382,13 @@ static void cleanup_loader(Error* error, void* user_data)
 
     Sample* sample = cb_data->sample;
 
+    if (!Error_is_set(error))
+    {
+        Snapshot_record_sample(cb_data->snapshot, cb_data->snapshot_id, sample);
+        Sample_share_data(
+                sample, cb_data->snapshot_id, cb_data->sc.data, cb_data->sc.length);
+    }
+
     del_Callback_data(cb_data);
 
     if (Error_is_set(error))
@@ -388,6 +415,25 @@ bool Sample_parse_wavpack(Sample* sample, Streader* sr, Background_loader* bkg_l
     const void* data = sr->str;
     const int64_t length = sr->len;
 
+    // The identifier is also used for sharing decoded data between Handles
+    static const char tag[] = "WavPack";
+    uint64_t snapshot_id = Snapshot_id_add(SNAPSHOT_ID_INIT, tag, sizeof(tag));
+    snapshot_id = Snapshot_id_add(snapshot_id, data, length);
+
+    Snapshot* snapshot = Background_loader_get_snapshot(bkg_loader);
+    if (Sample_use_shared_data(sample, snapshot_id, data, length))
+    {
+        Snapshot_record_sample(snapshot, snapshot_id, sample);
+        return true;
+    }
+
+    if (Snapshot_restore_sample(snapshot, snapshot_id, sample))
+    {
+        Snapshot_record_sample(snapshot, snapshot_id, sample);
+        Sample_share_data(sample, snapshot_id, data, length);
+        return true;
+    }
+
     Callback_data* cb_data = new_Callback_data();
     if (cb_data == NULL)
     {
@@ -496,9 +542,12 @@ bool Sample_parse_wavpack(Sample* sample, Streader* sr, Background_loader* bkg_l
     sample->data[0] = nbuf_l;
 
     cb_data->sample = sample;
+    cb_data->snapshot = snapshot;
+    cb_data->snapshot_id = snapshot_id;
+    cb_data->bkg_loader = bkg_loader;
 
-    Background_loader_task* task =
-        MAKE_BACKGROUND_LOADER_TASK(load_wavpack_data, cleanup_loader, cb_data);
+    Background_loader_task* task = MAKE_BACKGROUND_LOADER_TASK(
+            load_wavpack_data, cleanup_loader, cb_data, length);
 
     if (!Background_loader_add_task(bkg_loader, task))
     {
@@ -1,7 +1,7 @@
 
 
 /*
- * Author: Tomi Jylhä-Ollila, Finland 2018
+ * Author: Tomi Jylhä-Ollila, Finland 2018-2019
  *
  * This file is part of Kunquat.
  *
@@ -21,6 +21,7 @@
 #include <mathnum/common.h>
 #include <memory.h>
 #include <player/devices/processors/Bitcrusher_state.h>
+#include <player/devices/processors/Proc_state_utils.h>
 
 #include <stdbool.h>
 #include <stdlib.h>
@@ -29,6 +30,7 @@
 static Set_float_func   Proc_bitcrusher_set_cutoff;
 static Set_float_func   Proc_bitcrusher_set_resolution;
 static Set_float_func   Proc_bitcrusher_set_res_ignore_min;
+static Set_int_func     Proc_bitcrusher_set_control_interval;
 
 static void del_Proc_bitcrusher(Device_impl* dimpl);
 
@@ -53,6 +55,7 @@ Device_impl* new_Proc_bitcrusher(void)
     bitcrusher->cutoff = BITCRUSHER_DEFAULT_CUTOFF;
     bitcrusher->resolution = BITCRUSHER_DEFAULT_RESOLUTION;
     bitcrusher->res_ignore_min = BITCRUSHER_DEFAULT_RES_IGNORE_MIN;
+    bitcrusher->control_interval = 1;
 
     if (!(REGISTER_SET_FIXED_STATE(
                 bitcrusher,
@@ -71,7 +74,13 @@ Device_impl* new_Proc_bitcrusher(void)
                 float,
                 res_ignore_min,
                 "p_f_res_ignore_min.json",
-                BITCRUSHER_DEFAULT_RES_IGNORE_MIN)
+                BITCRUSHER_DEFAULT_RES_IGNORE_MIN) &&
+            REGISTER_SET_FIXED_STATE(
+                bitcrusher,
+                int,
+                control_interval,
+                "p_i_control_interval.json",
+                1)
          ))
     {
         del_Device_impl(&bitcrusher->parent);
@@ -124,6 +133,19 @@ static bool Proc_bitcrusher_set_res_ignore_min(
 }
 
 
+static bool Proc_bitcrusher_set_control_interval(
+        Device_impl* dimpl, const Key_indices indices, int64_t value)
+{
+    rassert(dimpl != NULL);
+    rassert(indices != NULL);
+
+    Proc_bitcrusher* bc = (Proc_bitcrusher*)dimpl;
+    Proc_set_control_interval(&bc->control_interval, value);
+
+    return true;
+}
+
+
 static void del_Proc_bitcrusher(Device_impl* dimpl)
 {
     if (dimpl == NULL)
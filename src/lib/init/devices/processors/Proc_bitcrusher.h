@@ -1,7 +1,7 @@
 
 
 /*
- * Author: Tomi Jylhä-Ollila, Finland 2018
+ * Author: Tomi Jylhä-Ollila, Finland 2018-2019
  *
  * This file is part of Kunquat.
  *
@@ -18,6 +18,8 @@
 
 #include <init/devices/Device_impl.h>
 
+#include <stdint.h>
+
 
 #define BITCRUSHER_DEFAULT_CUTOFF 100.0
 #define BITCRUSHER_DEFAULT_RESOLUTION 16.0
@@ -30,6 +32,7 @@ typedef struct Proc_bitcrusher
     double cutoff;
     double resolution;
     double res_ignore_min;
+    int32_t control_interval;
 } Proc_bitcrusher;
 
 
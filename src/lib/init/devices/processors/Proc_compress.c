@@ -1,7 +1,7 @@
 
 
 /*
- * Author: Tomi Jylhä-Ollila, Finland 2016-2017
+ * Author: Tomi Jylhä-Ollila, Finland 2016-2019
  *
  * This file is part of Kunquat.
  *
@@ -19,6 +19,7 @@
 #include <init/devices/processors/Proc_init_utils.h>
 #include <memory.h>
 #include <player/devices/processors/Compress_state.h>
+#include <player/devices/processors/Proc_state_utils.h>
 
 #include <stdbool.h>
 #include <stdint.h>
@@ -48,6 +49,8 @@ static Set_float_func   Proc_compress_set_downward_threshold;
 static Set_float_func   Proc_compress_set_downward_range;
 static Set_float_func   Proc_compress_set_downward_ratio;
 
+static Set_int_func     Proc_compress_set_control_interval;
+
 static Device_impl_destroy_func del_Proc_compress;
 
 
@@ -70,6 +73,8 @@ Device_impl* new_Proc_compress(void)
     compress->downward_range = DEFAULT_DOWNWARD_RANGE;
     compress->downward_ratio = DEFAULT_RATIO;
 
+    compress->control_interval = 1;
+
     if (!Device_impl_init(&compress->parent, del_Proc_compress))
     {
         del_Device_impl(&compress->parent);
@@ -94,7 +99,8 @@ Device_impl* new_Proc_compress(void)
                 "p_f_downward_threshold.json", DEFAULT_DOWNWARD_THRESHOLD) &&
             REG_KEY(float, downward_range,
                 "p_f_downward_range.json", DEFAULT_DOWNWARD_RANGE) &&
-            REG_KEY(float, downward_ratio, "p_f_downward_ratio.json", DEFAULT_RATIO)
+            REG_KEY(float, downward_ratio, "p_f_downward_ratio.json", DEFAULT_RATIO) &&
+            REG_KEY(int, control_interval, "p_i_control_interval.json", 1)
          ))
     {
         del_Device_impl(&compress->parent);
@@ -278,6 +284,19 @@ static bool Proc_compress_set_downward_ratio(
 }
 
 
+static bool Proc_compress_set_control_interval(
+        Device_impl* dimpl, const Key_indices indices, int64_t value)
+{
+    rassert(dimpl != NULL);
+    ignore(indices);
+
+    Proc_compress* compress = (Proc_compress*)dimpl;
+    Proc_set_control_interval(&compress->control_interval, value);
+
+    return true;
+}
+
+
 static void del_Proc_compress(Device_impl* dimpl)
 {
     if (dimpl == NULL)
@@ -1,7 +1,7 @@
 
 
 /*
- * Author: Tomi Jylhä-Ollila, Finland 2016
+ * Author: Tomi Jylhä-Ollila, Finland 2016-2019
  *
  * This file is part of Kunquat.
  *
@@ -18,6 +18,8 @@
 
 #include <init/devices/Device_impl.h>
 
+#include <stdint.h>
+
 
 typedef struct Proc_compress
 {
@@ -35,6 +37,8 @@ typedef struct Proc_compress
     double downward_threshold;
     double downward_ratio;
     double downward_range;
+
+    int32_t control_interval;
 } Proc_compress;
 
 
@@ -0,0 +1,191 @@
+
+
+/*
+ * Author: agent, 2026
+ *
+ * This file is part of Kunquat.
+ *
+ * CC0 1.0 Universal, http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * To the extent possible under law, Kunquat Affirmers have waived all
+ * copyright and related or neighboring rights to Kunquat.
+ */
+
+
+#include <init/devices/processors/Proc_convolve.h>
+
+#include <debug/assert.h>
+#include <init/devices/Device_impl.h>
+#include <init/devices/Proc_cons.h>
+#include <init/devices/Processor.h>
+#include <init/devices/param_types/Sample.h>
+#include <init/devices/processors/Proc_init_utils.h>
+#include <mathnum/common.h>
+#include <mathnum/fft.h>
+#include <memory.h>
+#include <player/devices/processors/Convolve_state.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+
+static Set_sample_func Proc_convolve_set_ir;
+
+static void del_Proc_convolve(Device_impl* dimpl);
+
+
+Device_impl* new_Proc_convolve(void)
+{
+    Proc_convolve* convolve = memory_alloc_item(Proc_convolve);
+    if (convolve == NULL)
+        return NULL;
+
+    convolve->tail_partition_count = 0;
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        convolve->heads[ch] = NULL;
+        convolve->tail_spectra[ch] = NULL;
+    }
+    convolve->ir_data = NULL;
+
+    if (!Device_impl_init(&convolve->parent, del_Proc_convolve))
+    {
+        del_Device_impl(&convolve->parent);
+        return NULL;
+    }
+
+    convolve->parent.create_pstate = new_Convolve_pstate;
+
+    if (!REGISTER_SET_WITH_STATE_CB(
+                convolve, sample, ir, "p_ir.wav", NULL, Convolve_pstate_set_ir))
+    {
+        del_Device_impl(&convolve->parent);
+        return NULL;
+    }
+
+    return &convolve->parent;
+}
+
+
+static void clear_ir(Proc_convolve* convolve)
+{
+    rassert(convolve != NULL);
+
+    memory_free(convolve->ir_data);
+    convolve->ir_data = NULL;
+
+    convolve->tail_partition_count = 0;
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        convolve->heads[ch] = NULL;
+        convolve->tail_spectra[ch] = NULL;
+    }
+
+    return;
+}
+
+
+static bool Proc_convolve_set_ir(
+        Device_impl* dimpl, const Key_indices indices, const Sample* value)
+{
+    rassert(dimpl != NULL);
+    rassert(indices != NULL);
+
+    Proc_convolve* convolve = (Proc_convolve*)dimpl;
+
+    clear_ir(convolve);
+
+    if ((value == NULL) || (value->data[0] == NULL) || !value->is_float ||
+            (value->len <= 0))
+        return true;
+
+    static const int32_t part_size = CONVOLVE_PARTITION_SIZE;
+
+    const int32_t ir_length = (int32_t)min(value->len, CONVOLVE_IR_LENGTH_MAX);
+    const int32_t tail_partition_count = (ir_length - 1) / part_size;
+    const int ir_channels = (value->channels == 2) ? 2 : 1;
+
+    const int64_t channel_data_size =
+        part_size + (int64_t)tail_partition_count * part_size * 2;
+    float* ir_data = memory_alloc_items(float, channel_data_size * ir_channels);
+    if (ir_data == NULL)
+        return false;
+
+    FFT_worker* fw = FFT_worker_init(FFT_WORKER_AUTO, part_size * 2);
+    if (fw == NULL)
+    {
+        memory_free(ir_data);
+        return false;
+    }
+
+    convolve->ir_data = ir_data;
+    convolve->tail_partition_count = tail_partition_count;
+
+    // Include the scaling of the inverse transform in the spectra
+    const float spectrum_scale = 1.0f / (float)(part_size * 2);
+
+    for (int ch = 0; ch < ir_channels; ++ch)
+    {
+        const float* ir = value->data[ch];
+
+        // Store the head in reverse order for the direct convolution
+        float* head = ir_data + ch * channel_data_size;
+        for (int32_t i = 0; i < part_size; ++i)
+        {
+            const int32_t ir_index = part_size - 1 - i;
+            head[i] = (ir_index < ir_length) ? ir[ir_index] : 0.0f;
+        }
+
+        float* tail_spectra = head + part_size;
+        for (int32_t p = 0; p < tail_partition_count; ++p)
+        {
+            const int32_t start = (p + 1) * part_size;
+            const int32_t stop = min(start + part_size, ir_length);
+
+            float buf[CONVOLVE_PARTITION_SIZE * 2] = { 0 };
+            for (int32_t i = start; i < stop; ++i)
+                buf[i - start] = ir[i];
+
+            FFT_worker_rfft(fw, buf, part_size * 2);
+
+            float* spectrum_res = tail_spectra + p * part_size * 2;
+            float* spectrum_ims = spectrum_res + part_size;
+            spectrum_res[0] = buf[0] * spectrum_scale;
+            spectrum_ims[0] = buf[part_size * 2 - 1] * spectrum_scale;
+            for (int32_t k = 1; k < part_size; ++k)
+            {
+                spectrum_res[k] = buf[k * 2 - 1] * spectrum_scale;
+                spectrum_ims[k] = buf[k * 2] * spectrum_scale;
+            }
+        }
+
+        convolve->heads[ch] = head;
+        convolve->tail_spectra[ch] = tail_spectra;
+    }
+
+    FFT_worker_deinit(fw);
+
+    if (ir_channels == 1)
+    {
+        convolve->heads[1] = convolve->heads[0];
+        convolve->tail_spectra[1] = convolve->tail_spectra[0];
+    }
+
+    return true;
+}
+
+
+static void del_Proc_convolve(Device_impl* dimpl)
+{
+    if (dimpl == NULL)
+        return;
+
+    Proc_convolve* convolve = (Proc_convolve*)dimpl;
+    clear_ir(convolve);
+    memory_free(convolve);
+
+    return;
+}
+
+
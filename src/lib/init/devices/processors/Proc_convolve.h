@@ -0,0 +1,50 @@
+
+
+/*
+ * Author: agent, 2026
+ *
+ * This file is part of Kunquat.
+ *
+ * CC0 1.0 Universal, http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * To the extent possible under law, Kunquat Affirmers have waived all
+ * copyright and related or neighboring rights to Kunquat.
+ */
+
+
+#ifndef KQT_PROC_CONVOLVE_H
+#define KQT_PROC_CONVOLVE_H
+
+
+#include <init/devices/Device_impl.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+
+
+#define CONVOLVE_PARTITION_SIZE 256
+#define CONVOLVE_IR_LENGTH_MAX 1048576
+
+
+/*
+ * The impulse response is divided into partitions of CONVOLVE_PARTITION_SIZE
+ * frames. The first partition is applied directly in the time domain so that
+ * the output has no latency. The remaining partitions are stored as spectra
+ * of length CONVOLVE_PARTITION_SIZE * 2 in split format: the real parts of
+ * bins [0, CONVOLVE_PARTITION_SIZE) followed by the imaginary parts, with the
+ * real Nyquist bin in place of the imaginary part of the DC bin.
+ */
+typedef struct Proc_convolve
+{
+    Device_impl parent;
+
+    int32_t tail_partition_count;
+    float* heads[2];
+    float* tail_spectra[2];
+    float* ir_data;
+} Proc_convolve;
+
+
+#endif // KQT_PROC_CONVOLVE_H
+
+
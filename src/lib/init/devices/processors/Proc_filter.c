@@ -20,6 +20,7 @@
 #include <init/devices/processors/Proc_init_utils.h>
 #include <memory.h>
 #include <player/devices/processors/Filter_state.h>
+#include <player/devices/processors/Proc_state_utils.h>
 
 #include <stdbool.h>
 
@@ -27,6 +28,7 @@
 static Set_int_func   Proc_filter_set_type;
 static Set_float_func Proc_filter_set_cutoff;
 static Set_float_func Proc_filter_set_resonance;
+static Set_int_func   Proc_filter_set_control_interval;
 
 static void del_Proc_filter(Device_impl* dimpl);
 
@@ -47,10 +49,12 @@ Device_impl* new_Proc_filter(void)
     filter->parent.get_vstate_size = Filter_vstate_get_size;
     filter->parent.init_vstate = Filter_vstate_init;
     filter->parent.render_voice = Filter_vstate_render_voice;
+    filter->parent.render_voices = Filter_vstate_render_voices;
 
     filter->type = FILTER_TYPE_LOWPASS;
     filter->cutoff = FILTER_DEFAULT_CUTOFF;
     filter->resonance = FILTER_DEFAULT_RESONANCE;
+    filter->control_interval = 1;
 
     if (!(REGISTER_SET_FIXED_STATE(
                 filter,
@@ -69,7 +73,13 @@ Device_impl* new_Proc_filter(void)
                 float,
                 resonance,
                 "p_f_resonance.json",
-                FILTER_DEFAULT_RESONANCE)
+                FILTER_DEFAULT_RESONANCE) &&
+            REGISTER_SET_FIXED_STATE(
+                filter,
+                int,
+                control_interval,
+                "p_i_control_interval.json",
+                1)
         ))
     {
         del_Device_impl(&filter->parent);
@@ -124,6 +134,19 @@ static bool Proc_filter_set_resonance(
 }
 
 
+static bool Proc_filter_set_control_interval(
+        Device_impl* dimpl, const Key_indices indices, int64_t value)
+{
+    rassert(dimpl != NULL);
+    rassert(indices != NULL);
+
+    Proc_filter* filter = (Proc_filter*)dimpl;
+    Proc_set_control_interval(&filter->control_interval, value);
+
+    return true;
+}
+
+
 static void del_Proc_filter(Device_impl* dimpl)
 {
     if (dimpl == NULL)
@@ -1,7 +1,7 @@
 
 
 /*
- * Author: Tomi Jylhä-Ollila, Finland 2015-2017
+ * Author: Tomi Jylhä-Ollila, Finland 2015-2019
  *
  * This file is part of Kunquat.
  *
@@ -18,6 +18,8 @@
 
 #include <init/devices/Device_impl.h>
 
+#include <stdint.h>
+
 
 #define FILTER_DEFAULT_CUTOFF 100.0
 #define FILTER_DEFAULT_RESONANCE 0.0
@@ -37,6 +39,7 @@ typedef struct Proc_filter
     Filter_type type;
     double cutoff;
     double resonance;
+    int32_t control_interval;
 } Proc_filter;
 
 
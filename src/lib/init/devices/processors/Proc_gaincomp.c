@@ -1,7 +1,7 @@
 
 
 /*
- * Author: Tomi Jylhä-Ollila, Finland 2011-2017
+ * Author: Tomi Jylhä-Ollila, Finland 2011-2019
  *
  * This file is part of Kunquat.
  *
@@ -20,6 +20,7 @@
 #include <init/devices/Proc_cons.h>
 #include <init/devices/Processor.h>
 #include <init/devices/processors/Proc_init_utils.h>
+#include <mathnum/common.h>
 #include <memory.h>
 #include <player/devices/processors/Gaincomp_state.h>
 #include <string/common.h>
@@ -31,8 +32,11 @@
 
 
 static Set_bool_func     Proc_gc_set_map_enabled;
+static Set_bool_func     Proc_gc_set_map_use_table;
 static Set_envelope_func Proc_gc_set_map;
 
+static bool Proc_gc_update_map_table(Proc_gaincomp* gc);
+
 static void del_Proc_gaincomp(Device_impl* dimpl);
 
 
@@ -53,10 +57,15 @@ Device_impl* new_Proc_gaincomp(void)
     gc->parent.render_voice = Gaincomp_vstate_render_voice;
 
     gc->is_map_enabled = false;
+    gc->use_map_table = false;
     gc->map = NULL;
+    gc->is_map_symmetric = false;
+    gc->map_table = NULL;
 
     if (!(REGISTER_SET_FIXED_STATE(
                 gc, bool, map_enabled, "p_b_map_enabled.json", false) &&
+            REGISTER_SET_FIXED_STATE(
+                gc, bool, map_use_table, "p_b_map_use_table.json", false) &&
             REGISTER_SET_FIXED_STATE(gc, envelope, map, "p_e_map.json", NULL)
         ))
     {
@@ -81,6 +90,19 @@ static bool Proc_gc_set_map_enabled(
 }
 
 
+static bool Proc_gc_set_map_use_table(
+        Device_impl* dimpl, const Key_indices indices, bool value)
+{
+    rassert(dimpl != NULL);
+    rassert(indices != NULL);
+
+    Proc_gaincomp* gc = (Proc_gaincomp*)dimpl;
+    gc->use_map_table = value;
+
+    return Proc_gc_update_map_table(gc);
+}
+
+
 static bool Proc_gc_set_map(
         Device_impl* dimpl, const Key_indices indices, const Envelope* value)
 {
@@ -118,6 +140,37 @@ static bool Proc_gc_set_map(
     }
 
     gc->map = valid ? value : NULL;
+    gc->is_map_symmetric = valid && (Envelope_get_node(value, 0)[0] == 0);
+
+    return Proc_gc_update_map_table(gc);
+}
+
+
+static bool Proc_gc_update_map_table(Proc_gaincomp* gc)
+{
+    rassert(gc != NULL);
+
+    memory_free(gc->map_table);
+    gc->map_table = NULL;
+
+    if (!gc->use_map_table || (gc->map == NULL))
+        return true;
+
+    // Sample the map for table lookups
+    float* map_table = memory_alloc_items(float, GAINCOMP_MAP_TABLE_SIZE + 1);
+    if (map_table == NULL)
+        return false;
+
+    const double range_start = gc->is_map_symmetric ? 0 : -1;
+    const double step = (1 - range_start) / GAINCOMP_MAP_TABLE_SIZE;
+
+    for (int i = 0; i <= GAINCOMP_MAP_TABLE_SIZE; ++i)
+    {
+        const double x = min(range_start + i * step, 1.0);
+        map_table[i] = (float)Envelope_get_value(gc->map, x);
+    }
+
+    gc->map_table = map_table;
 
     return true;
 }
@@ -129,6 +182,7 @@ static void del_Proc_gaincomp(Device_impl* dimpl)
         return;
 
     Proc_gaincomp* gc = (Proc_gaincomp*)dimpl;
+    memory_free(gc->map_table);
     memory_free(gc);
 
     return;
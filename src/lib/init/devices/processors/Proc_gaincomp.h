@@ -1,7 +1,7 @@
 
 
 /*
- * Author: Tomi Jylhä-Ollila, Finland 2011-2016
+ * Author: Tomi Jylhä-Ollila, Finland 2011-2019
  *
  * This file is part of Kunquat.
  *
@@ -19,15 +19,29 @@
 #include <decl.h>
 #include <init/devices/Device_impl.h>
 
+#include <stdbool.h>
 #include <stdlib.h>
 
 
+#define GAINCOMP_MAP_TABLE_SIZE 4096
+
+
+/*
+ * The map is sampled into a table of GAINCOMP_MAP_TABLE_SIZE intervals that
+ * covers the range [0, 1] for symmetric maps and [-1, 1] for asymmetric maps.
+ * The table contains one extra value for the end of the last interval.
+ * The table is only built when use_map_table is set, otherwise rendering
+ * evaluates the map exactly.
+ */
 typedef struct Proc_gaincomp
 {
     Device_impl parent;
 
     bool is_map_enabled;
+    bool use_map_table;
     const Envelope* map;
+    bool is_map_symmetric;
+    float* map_table;
 } Proc_gaincomp;
 
 
@@ -20,6 +20,7 @@
 #include <init/devices/processors/Proc_init_utils.h>
 #include <mathnum/common.h>
 #include <memory.h>
+#include <player/devices/processors/Ks_resample.h>
 #include <player/devices/processors/Ks_state.h>
 
 #include <stdlib.h>
@@ -53,6 +54,8 @@ Device_impl* new_Proc_ks(void)
         return NULL;
     }
 
+    Ks_resample_init_sinc_table();
+
 #define REG_KEY(type, name, keyp, def_value) \
     REGISTER_SET_FIXED_STATE(ks, type, name, keyp, def_value)
 #define REG_KEY_BOOL(name, keyp, def_value) \
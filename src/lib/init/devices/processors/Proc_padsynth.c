@@ -21,6 +21,7 @@
 #include <init/devices/param_types/Padsynth_params.h>
 #include <init/devices/Proc_cons.h>
 #include <init/devices/processors/Proc_init_utils.h>
+#include <init/Snapshot.h>
 #include <mathnum/common.h>
 #include <mathnum/conversions.h>
 #include <mathnum/fft.h>
@@ -33,6 +34,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 
 static Set_padsynth_params_func Proc_padsynth_set_params;
@@ -349,7 +351,11 @@ Device_impl* new_Proc_padsynth(void)
 
     Random_init(&padsynth->random, "PADsynth");
 
-    if (!apply_padsynth(padsynth, NULL, NULL))
+    const Memory_category prev_category = memory_set_category(MEMORY_CATEGORY_PADSYNTH);
+    const bool success = apply_padsynth(padsynth, NULL, NULL);
+    memory_set_category(prev_category);
+
+    if (!success)
     {
         del_Device_impl(&padsynth->parent);
         return NULL;
@@ -370,7 +376,11 @@ static bool Proc_padsynth_set_params(
 
     Proc_padsynth* padsynth = (Proc_padsynth*)dimpl;
 
-    return apply_padsynth(padsynth, params, bkg_loader);
+    const Memory_category prev_category = memory_set_category(MEMORY_CATEGORY_PADSYNTH);
+    const bool success = apply_padsynth(padsynth, params, bkg_loader);
+    memory_set_category(prev_category);
+
+    return success;
 }
 
 
@@ -482,6 +492,197 @@ static double get_phase_spread(double freq_i, double bandwidth_i)
 }
 
 
+/*
+ * The source of a PADsynth sample describes all inputs of the sample
+ * generation. Its hash is used as the Snapshot identifier of the sample, and
+ * the source itself is used to verify matches of shared data.
+ */
+typedef struct Source_writer
+{
+    uint64_t id;
+    char* data;
+    int64_t size;
+} Source_writer;
+
+
+#define SOURCE_WRITER_AUTO \
+    (&(Source_writer){ .id = SNAPSHOT_ID_INIT, .data = NULL, .size = 0 })
+
+
+static void Source_writer_add(Source_writer* sw, const void* data, int64_t size)
+{
+    rassert(sw != NULL);
+    rassert(data != NULL);
+    rassert(size >= 0);
+
+    sw->id = Snapshot_id_add(sw->id, data, size);
+    if (sw->data != NULL)
+        memcpy(sw->data + sw->size, data, (size_t)size);
+    sw->size += size;
+
+    return;
+}
+
+
+static void Source_writer_add_int(Source_writer* sw, int64_t value)
+{
+    Source_writer_add(sw, &value, sizeof(int64_t));
+    return;
+}
+
+
+static void Source_writer_add_float(Source_writer* sw, double value)
+{
+    Source_writer_add(sw, &value, sizeof(double));
+    return;
+}
+
+
+static void write_padsynth_sample_source(
+        Source_writer* sw,
+        const Padsynth_params* params,
+        double centre_pitch,
+        int context_index)
+{
+    rassert(sw != NULL);
+    rassert(params != NULL);
+
+    static const char tag[] = "PADsynth";
+    Source_writer_add(sw, tag, sizeof(tag));
+
+    Source_writer_add_int(sw, params->sample_length);
+    Source_writer_add_int(sw, params->audio_rate);
+    Source_writer_add_float(sw, params->bandwidth_base);
+    Source_writer_add_float(sw, params->bandwidth_scale);
+    Source_writer_add_int(sw, params->use_phase_data);
+    if (params->use_phase_data)
+    {
+        Source_writer_add_float(sw, params->phase_var_at_harmonic);
+        Source_writer_add_float(sw, params->phase_var_off_harmonic);
+        Source_writer_add_float(sw, params->phase_spread_bandwidth_base);
+        Source_writer_add_float(sw, params->phase_spread_bandwidth_scale);
+    }
+
+    const int64_t harmonic_count = Array_get_size(params->harmonics);
+    Source_writer_add_int(sw, harmonic_count);
+    for (int64_t h = 0; h < harmonic_count; ++h)
+    {
+        const Padsynth_harmonic* harmonic = Array_get_ref(params->harmonics, h);
+        Source_writer_add_float(sw, harmonic->freq_mul);
+        Source_writer_add_float(sw, harmonic->amplitude);
+        Source_writer_add_float(sw, harmonic->phase);
+    }
+
+    const bool use_res_env = params->is_res_env_enabled && (params->res_env != NULL);
+    Source_writer_add_int(sw, use_res_env);
+    if (use_res_env)
+    {
+        const Envelope* env = params->res_env;
+        Source_writer_add_int(sw, Envelope_get_interp(env));
+
+        const int node_count = Envelope_node_count(env);
+        Source_writer_add_int(sw, node_count);
+        for (int i = 0; i < node_count; ++i)
+        {
+            const double* node = Envelope_get_node(env, i);
+            Source_writer_add_float(sw, node[0]);
+            Source_writer_add_float(sw, node[1]);
+        }
+    }
+
+    Source_writer_add_float(sw, centre_pitch);
+    Source_writer_add_int(sw, context_index);
+
+    return;
+}
+
+
+static uint64_t get_padsynth_sample_id(
+        const Padsynth_params* params, double centre_pitch, int context_index)
+{
+    rassert(params != NULL);
+
+    Source_writer* sw = SOURCE_WRITER_AUTO;
+    write_padsynth_sample_source(sw, params, centre_pitch, context_index);
+
+    return sw->id;
+}
+
+
+static char* new_padsynth_sample_source(
+        const Padsynth_params* params,
+        double centre_pitch,
+        int context_index,
+        int64_t* size)
+{
+    rassert(params != NULL);
+    rassert(size != NULL);
+
+    Source_writer* sw = SOURCE_WRITER_AUTO;
+    write_padsynth_sample_source(sw, params, centre_pitch, context_index);
+
+    char* source = memory_alloc_items(char, sw->size);
+    if (source == NULL)
+        return NULL;
+
+    *size = sw->size;
+
+    sw->id = SNAPSHOT_ID_INIT;
+    sw->data = source;
+    sw->size = 0;
+    write_padsynth_sample_source(sw, params, centre_pitch, context_index);
+    rassert(sw->size == *size);
+
+    return source;
+}
+
+
+static bool use_shared_padsynth_sample(
+        Sample* sample,
+        uint64_t id,
+        const Padsynth_params* params,
+        double centre_pitch,
+        int context_index)
+{
+    rassert(sample != NULL);
+    rassert(params != NULL);
+
+    int64_t source_size = 0;
+    char* source =
+        new_padsynth_sample_source(params, centre_pitch, context_index, &source_size);
+    if (source == NULL)
+        return false;
+
+    const bool found = Sample_use_shared_data(sample, id, source, source_size);
+    memory_free(source);
+
+    return found;
+}
+
+
+static void share_padsynth_sample(
+        Sample* sample,
+        uint64_t id,
+        const Padsynth_params* params,
+        double centre_pitch,
+        int context_index)
+{
+    rassert(sample != NULL);
+    rassert(params != NULL);
+
+    int64_t source_size = 0;
+    char* source =
+        new_padsynth_sample_source(params, centre_pitch, context_index, &source_size);
+    if (source == NULL)
+        return;
+
+    Sample_share_data(sample, id, source, source_size);
+    memory_free(source);
+
+    return;
+}
+
+
 typedef struct Callback_data
 {
     Padsynth_sample_entry* entry;
@@ -490,6 +691,9 @@ typedef struct Callback_data
     double* freq_phase;
     FFT_worker fw;
     const Padsynth_params* params;
+    Snapshot* snapshot;
+    uint64_t snapshot_id;
+    const Background_loader* bkg_loader;
 } Callback_data;
 
 
@@ -519,6 +723,9 @@ static Callback_data* new_Callback_data(const Padsynth_params* params)
     cb_data->freq_amp = NULL;
     cb_data->freq_phase = NULL;
     cb_data->params = params;
+    cb_data->snapshot = NULL;
+    cb_data->snapshot_id = 0;
+    cb_data->bkg_loader = NULL;
 
     int32_t sample_length = PADSYNTH_DEFAULT_SAMPLE_LENGTH;
     if (params != NULL)
@@ -545,12 +752,46 @@ static void cleanup_cb_data(Error* error, void* user_data)
     rassert(user_data != NULL);
 
     Callback_data* cb_data = user_data;
+
+    if (!Error_is_set(error) && (cb_data->params != NULL))
+    {
+        Sample* sample = cb_data->entry->sample;
+        Snapshot_record_sample(cb_data->snapshot, cb_data->snapshot_id, sample);
+        share_padsynth_sample(
+                sample,
+                cb_data->snapshot_id,
+                cb_data->params,
+                cb_data->entry->centre_pitch,
+                cb_data->context_index);
+    }
+
     del_Callback_data(cb_data);
 
     return;
 }
 
 
+static bool is_generation_cancelled(const Callback_data* cb_data, Error* error)
+{
+    rassert(cb_data != NULL);
+    rassert(error != NULL);
+
+    if ((cb_data->bkg_loader == NULL) ||
+            !Background_loader_is_cancelled(cb_data->bkg_loader))
+        return false;
+
+    Error_set_desc(
+            error,
+            ERROR_RESOURCE,
+            __FILE__,
+            __LINE__,
+            __func__,
+            "PADsynth sample generation was cancelled");
+
+    return true;
+}
+
+
 static void make_padsynth_sample(Error* error, void* user_data)
 {
     rassert(error != NULL);
@@ -606,6 +847,9 @@ static void make_padsynth_sample(Error* error, void* user_data)
 
         for (int64_t h = 0; h < Array_get_size(params->harmonics); ++h)
         {
+            if (is_generation_cancelled(cb_data, error))
+                return;
+
             const Padsynth_harmonic* harmonic = Array_get_ref(params->harmonics, h);
 
             // Skip harmonics that are not representable
@@ -730,6 +974,9 @@ static void make_padsynth_sample(Error* error, void* user_data)
             freq_phase[i] = Random_get_float_lb(random) * PI2;
     }
 
+    if (is_generation_cancelled(cb_data, error))
+        return;
+
     // Set up frequencies in half-complex representation
     float* buf = Sample_get_buffer(cb_data->entry->sample, 0);
     rassert(buf != NULL);
@@ -795,6 +1042,8 @@ static bool apply_padsynth(
     if (fabs(min_pitch - max_pitch) < 1)
         sample_count = 1;
 
+    const int64_t sample_size = (int64_t)sample_length * (int64_t)sizeof(float);
+
     Callback_data* cb_datas[PADSYNTH_MAX_SAMPLE_COUNT] = { NULL };
 
     int cb_data_count = 0;
@@ -840,6 +1089,44 @@ static bool apply_padsynth(
     {
         rassert(bkg_loader != NULL);
 
+        Snapshot* snapshot = Background_loader_get_snapshot(bkg_loader);
+
+        // Use data shared by other Handles where possible, and make sure
+        // that we only write to private data
+        uint64_t sample_ids[PADSYNTH_MAX_SAMPLE_COUNT] = { 0 };
+        bool is_sample_shared[PADSYNTH_MAX_SAMPLE_COUNT] = { false };
+
+        {
+            AAiter* iter = AAiter_init(AAITER_AUTO, padsynth->sample_map->map);
+
+            int context_index = 0;
+
+            const Padsynth_sample_entry* key = PADSYNTH_SAMPLE_ENTRY_KEY(-INFINITY);
+            Padsynth_sample_entry* entry = AAiter_get_at_least(iter, key);
+            while (entry != NULL)
+            {
+                rassert(context_index < PADSYNTH_MAX_SAMPLE_COUNT);
+
+                const uint64_t id =
+                    get_padsynth_sample_id(params, entry->centre_pitch, context_index);
+                sample_ids[context_index] = id;
+                is_sample_shared[context_index] = use_shared_padsynth_sample(
+                        entry->sample, id, params, entry->centre_pitch, context_index);
+
+                if (!is_sample_shared[context_index] &&
+                        !Sample_unshare_data(entry->sample))
+                {
+                    for (int i = 0; i < cb_data_count; ++i)
+                        del_Callback_data(cb_datas[i]);
+                    return false;
+                }
+
+                ++context_index;
+
+                entry = AAiter_get_next(iter);
+            }
+        }
+
         AAiter* iter = AAiter_init(AAITER_AUTO, padsynth->sample_map->map);
 
         int context_index = 0;
@@ -848,25 +1135,67 @@ static bool apply_padsynth(
         Padsynth_sample_entry* entry = AAiter_get_at_least(iter, key);
         while (entry != NULL)
         {
+            const bool is_cb_data_direct =
+                last_cb_data_is_direct && (context_index >= cb_data_count - 1);
+
             Callback_data* cb_data = cb_datas[min(context_index, cb_data_count - 1)];
             rassert(cb_data != NULL);
 
             cb_data->entry = entry;
             cb_data->context_index = context_index;
+            cb_data->snapshot = snapshot;
+            cb_data->snapshot_id = sample_ids[context_index];
 
-            if (last_cb_data_is_direct && (context_index >= cb_data_count - 1))
+            if (is_sample_shared[context_index])
+            {
+                Snapshot_record_sample(snapshot, cb_data->snapshot_id, entry->sample);
+                if (!is_cb_data_direct)
+                {
+                    del_Callback_data(cb_data);
+                    cb_datas[context_index] = NULL;
+                }
+            }
+            else if (Snapshot_restore_sample(
+                        snapshot, cb_data->snapshot_id, entry->sample))
+            {
+                Snapshot_record_sample(snapshot, cb_data->snapshot_id, entry->sample);
+                share_padsynth_sample(
+                        entry->sample,
+                        cb_data->snapshot_id,
+                        params,
+                        entry->centre_pitch,
+                        context_index);
+                if (!is_cb_data_direct)
+                {
+                    del_Callback_data(cb_data);
+                    cb_datas[context_index] = NULL;
+                }
+            }
+            else if (is_cb_data_direct)
             {
                 Error* error = ERROR_AUTO;
                 make_padsynth_sample(error, cb_data);
                 rassert(!Error_is_set(error));
+                Snapshot_record_sample(snapshot, cb_data->snapshot_id, entry->sample);
+                share_padsynth_sample(
+                        entry->sample,
+                        cb_data->snapshot_id,
+                        params,
+                        entry->centre_pitch,
+                        context_index);
             }
             else
             {
+                cb_data->bkg_loader = bkg_loader;
+
                 Background_loader_task* task = MAKE_BACKGROUND_LOADER_TASK(
-                        make_padsynth_sample, cleanup_cb_data, cb_data);
+                        make_padsynth_sample, cleanup_cb_data, cb_data, sample_size);
 
                 if (!Background_loader_add_task(bkg_loader, task))
                 {
+                    // Generating directly cannot be cancelled
+                    cb_data->bkg_loader = NULL;
+
                     Error* error = ERROR_AUTO;
                     make_padsynth_sample(error, cb_data);
                     cleanup_cb_data(error, cb_data);
@@ -886,6 +1215,14 @@ static bool apply_padsynth(
             AAtree_get_at_least(padsynth->sample_map->map, key);
         rassert(entry != NULL);
 
+        // The entry may still use data shared with other Handles
+        if (!Sample_unshare_data(entry->sample))
+        {
+            for (int i = 0; i < cb_data_count; ++i)
+                del_Callback_data(cb_datas[i]);
+            return false;
+        }
+
         Callback_data* cb_data = cb_datas[0];
         rassert(cb_data != NULL);
 
@@ -894,10 +1231,15 @@ static bool apply_padsynth(
 
         rassert(!last_cb_data_is_direct);
 
+        cb_data->bkg_loader = bkg_loader;
+
         Background_loader_task* task = MAKE_BACKGROUND_LOADER_TASK(
-                make_padsynth_sample, cleanup_cb_data, cb_data);
+                make_padsynth_sample, cleanup_cb_data, cb_data, sample_size);
         if ((bkg_loader == NULL) || !Background_loader_add_task(bkg_loader, task))
         {
+            // Generating directly cannot be cancelled
+            cb_data->bkg_loader = NULL;
+
             Error* error = ERROR_AUTO;
             make_padsynth_sample(error, cb_data);
             cleanup_cb_data(error, cb_data);
@@ -20,6 +20,7 @@
 #include <init/devices/processors/Proc_init_utils.h>
 #include <memory.h>
 #include <player/devices/processors/Phaser_state.h>
+#include <player/devices/processors/Proc_state_utils.h>
 
 #include <stdlib.h>
 
@@ -28,6 +29,7 @@ static Set_int_func     Proc_phaser_set_stage_count;
 static Set_float_func   Proc_phaser_set_cutoff;
 static Set_float_func   Proc_phaser_set_bandwidth;
 static Set_float_func   Proc_phaser_set_dry_wet_ratio;
+static Set_int_func     Proc_phaser_set_control_interval;
 
 static Device_impl_destroy_func del_Proc_phaser;
 
@@ -53,6 +55,7 @@ Device_impl* new_Proc_phaser(void)
     phaser->cutoff = 100;
     phaser->bandwidth = PHASER_BANDWIDTH_DEFAULT;
     phaser->dry_wet_ratio = 1;
+    phaser->control_interval = 1;
 
     if (!(REGISTER_SET_FIXED_STATE(
                     phaser,
@@ -77,6 +80,12 @@ Device_impl* new_Proc_phaser(void)
                     float,
                     dry_wet_ratio,
                     "p_f_dry_wet_ratio.json",
+                    1) &&
+                REGISTER_SET_FIXED_STATE(
+                    phaser,
+                    int,
+                    control_interval,
+                    "p_i_control_interval.json",
                     1)
          ))
     {
@@ -152,6 +161,19 @@ static bool Proc_phaser_set_dry_wet_ratio(
 }
 
 
+static bool Proc_phaser_set_control_interval(
+        Device_impl* dimpl, const Key_indices indices, int64_t value)
+{
+    rassert(dimpl != NULL);
+    rassert(indices != NULL);
+
+    Proc_phaser* phaser = (Proc_phaser*)dimpl;
+    Proc_set_control_interval(&phaser->control_interval, value);
+
+    return true;
+}
+
+
 void del_Proc_phaser(Device_impl* dimpl)
 {
     if (dimpl == NULL)
@@ -18,6 +18,8 @@
 
 #include <init/devices/Device_impl.h>
 
+#include <stdint.h>
+
 
 #define PHASER_STAGES_MIN 1
 #define PHASER_STAGES_MAX 32
@@ -36,6 +38,7 @@ typedef struct Proc_phaser
     double cutoff;
     double bandwidth;
     double dry_wet_ratio;
+    int32_t control_interval;
 } Proc_phaser;
 
 
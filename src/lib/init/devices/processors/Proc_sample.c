@@ -18,6 +18,7 @@
 #include <init/devices/Proc_cons.h>
 #include <init/devices/Processor.h>
 #include <memory.h>
+#include <player/devices/processors/Sample_interp.h>
 #include <player/devices/processors/Sample_state.h>
 #include <string/common.h>
 
@@ -27,6 +28,9 @@
 #include <string.h>
 
 
+static Set_int_func  Proc_sample_set_interp;
+static Set_bool_func Proc_sample_set_use_mipmaps;
+
 static void del_Proc_sample(Device_impl* dimpl);
 
 
@@ -36,12 +40,34 @@ Device_impl* new_Proc_sample(void)
     if (sample_p == NULL)
         return NULL;
 
+    sample_p->interp = SAMPLE_INTERP_LINEAR;
+    sample_p->use_mipmaps = false;
+
     if (!Device_impl_init(&sample_p->parent, del_Proc_sample))
     {
         del_Device_impl(&sample_p->parent);
         return NULL;
     }
 
+    Sample_interp_init_tables();
+
+    if (!(Device_impl_register_set_int(
+                    &sample_p->parent,
+                    "p_i_interpolation.json",
+                    SAMPLE_INTERP_LINEAR,
+                    Proc_sample_set_interp,
+                    NULL) &&
+                Device_impl_register_set_bool(
+                    &sample_p->parent,
+                    "p_b_mipmaps.json",
+                    false,
+                    Proc_sample_set_use_mipmaps,
+                    NULL)))
+    {
+        del_Device_impl(&sample_p->parent);
+        return NULL;
+    }
+
     sample_p->parent.get_vstate_size = Sample_vstate_get_size;
     sample_p->parent.init_vstate = Sample_vstate_init;
     sample_p->parent.render_voice = Sample_vstate_render_voice;
@@ -50,6 +76,35 @@ Device_impl* new_Proc_sample(void)
 }
 
 
+static bool Proc_sample_set_interp(
+        Device_impl* dimpl, const Key_indices indices, int64_t value)
+{
+    rassert(dimpl != NULL);
+    rassert(indices != NULL);
+
+    Proc_sample* sample_p = (Proc_sample*)dimpl;
+    if ((value >= SAMPLE_INTERP_LINEAR) && (value < SAMPLE_INTERP_COUNT))
+        sample_p->interp = (Sample_interp)value;
+    else
+        sample_p->interp = SAMPLE_INTERP_LINEAR;
+
+    return true;
+}
+
+
+static bool Proc_sample_set_use_mipmaps(
+        Device_impl* dimpl, const Key_indices indices, bool enabled)
+{
+    rassert(dimpl != NULL);
+    rassert(indices != NULL);
+
+    Proc_sample* sample_p = (Proc_sample*)dimpl;
+    sample_p->use_mipmaps = enabled;
+
+    return true;
+}
+
+
 void del_Proc_sample(Device_impl* dimpl)
 {
     if (dimpl == NULL)
@@ -27,9 +27,21 @@
 #define SAMPLE_RANDOMS_MAX (8)
 
 
+typedef enum
+{
+    SAMPLE_INTERP_LINEAR = 0,
+    SAMPLE_INTERP_CUBIC,
+    SAMPLE_INTERP_SINC,
+    SAMPLE_INTERP_COUNT
+} Sample_interp;
+
+
 typedef struct Proc_sample
 {
     Device_impl parent;
+
+    Sample_interp interp;
+    bool use_mipmaps;
 } Proc_sample;
 
 
@@ -14,6 +14,7 @@
 
 #include <init/sheet/Column.h>
 
+#include <containers/Arena.h>
 #include <debug/assert.h>
 #include <mathnum/Tstamp.h>
 #include <memory.h>
@@ -32,25 +33,27 @@ struct Column
     Tstamp len;
     uint32_t version;
     Column_iter* edit_iter;
+    Arena* arena;
     AAtree* triggers;
 };
 
 
-static Trigger_list* new_Trigger_list(Trigger_list* nil, Trigger* trigger);
+static Trigger_list* new_Trigger_list(
+        Arena* arena, Trigger_list* nil, Trigger* trigger);
 
 static Trigger_list* Trigger_list_init(Trigger_list* trlist);
 
 static int Trigger_list_cmp(const Trigger_list* list1, const Trigger_list* list2);
 
-static void del_Trigger_list(Trigger_list* trlist);
 
-
-static Trigger_list* new_Trigger_list(Trigger_list* nil, Trigger* trigger)
+static Trigger_list* new_Trigger_list(
+        Arena* arena, Trigger_list* nil, Trigger* trigger)
 {
+    rassert(arena != NULL);
     rassert(!(nil == NULL) || (trigger == NULL));
     rassert(!(trigger == NULL) || (nil == NULL));
 
-    Trigger_list* trlist = memory_alloc_item(Trigger_list);
+    Trigger_list* trlist = Arena_alloc_item(arena, Trigger_list);
     if (trlist == NULL)
         return NULL;
 
@@ -249,19 +252,29 @@ Column* new_Column(const Tstamp* len)
         return NULL;
 
     col->version = 1;
-    col->triggers = new_AAtree(
-            (AAtree_item_cmp*)Trigger_list_cmp, (AAtree_item_destroy*)del_Trigger_list);
+    col->edit_iter = NULL;
+    col->triggers = NULL;
+
+    // Triggers and their lists share the lifetime of the Column
+    col->arena = new_Arena();
+    if (col->arena == NULL)
+    {
+        del_Column(col);
+        return NULL;
+    }
+
+    col->triggers = new_AAtree_in_arena(
+            col->arena, (AAtree_item_cmp*)Trigger_list_cmp, NULL);
     if (col->triggers == NULL)
     {
-        memory_free(col);
+        del_Column(col);
         return NULL;
     }
 
     col->edit_iter = new_Column_iter(col);
     if (col->edit_iter == NULL)
     {
-        del_AAtree(col->triggers);
-        memory_free(col);
+        del_Column(col);
         return NULL;
     }
 
@@ -311,23 +324,19 @@ static bool read_trigger(Streader* sr, int32_t index, void* userdata)
 
     Read_trigger_data* rtdata = userdata;
 
+    Column* col = rtdata->col;
+
     if (Trigger_data_contains_name_spec(sr))
     {
-        Trigger* trigger =
-            new_Trigger_of_name_spec_from_string(sr, rtdata->event_names);
-        if (trigger == NULL || !Column_ins(rtdata->col, trigger))
-        {
-            del_Trigger(trigger);
+        Trigger* trigger = new_Trigger_of_name_spec_from_string(
+                sr, rtdata->event_names, col->arena);
+        if (trigger == NULL || !Column_ins(col, trigger))
             return false;
-        }
     }
 
-    Trigger* trigger = new_Trigger_from_string(sr, rtdata->event_names);
-    if (trigger == NULL || !Column_ins(rtdata->col, trigger))
-    {
-        del_Trigger(trigger);
+    Trigger* trigger = new_Trigger_from_string(sr, rtdata->event_names, col->arena);
+    if (trigger == NULL || !Column_ins(col, trigger))
         return false;
-    }
 
     return true;
 }
@@ -363,35 +372,25 @@ bool Column_ins(Column* col, Trigger* trigger)
     if (ret == NULL || Tstamp_cmp(Trigger_get_pos(trigger),
             Trigger_get_pos(ret->next->trigger)) != 0)
     {
-        Trigger_list* nil = new_Trigger_list(NULL, NULL);
+        Trigger_list* nil = new_Trigger_list(col->arena, NULL, NULL);
         if (nil == NULL)
             return false;
 
-        Trigger_list* node = new_Trigger_list(nil, trigger);
+        Trigger_list* node = new_Trigger_list(col->arena, nil, trigger);
         if (node == NULL)
-        {
-            del_Trigger_list(nil);
             return false;
-        }
 
         nil->prev = nil->next = node;
         node->prev = node->next = nil;
 
-        if (!AAtree_ins(col->triggers, nil))
-        {
-            del_Trigger_list(nil);
-            del_Trigger_list(node);
-            return false;
-        }
-
-        return true;
+        return AAtree_ins(col->triggers, nil);
     }
 
     rassert(ret->next != ret);
     rassert(ret->prev != ret);
     rassert(ret->trigger == NULL);
 
-    Trigger_list* node = new_Trigger_list(ret, trigger);
+    Trigger_list* node = new_Trigger_list(col->arena, ret, trigger);
     if (node == NULL)
         return false;
 
@@ -409,36 +408,12 @@ void del_Column(Column* col)
     if (col == NULL)
         return;
 
-    del_AAtree(col->triggers);
+    // The trigger tree lives in the Arena
     del_Column_iter(col->edit_iter);
+    del_Arena(col->arena);
     memory_free(col);
 
     return;
 }
 
 
-static void del_Trigger_list(Trigger_list* trlist)
-{
-    if (trlist == NULL)
-        return;
-
-    rassert(trlist->trigger == NULL);
-    Trigger_list* cur = trlist->next;
-    rassert(cur->trigger != NULL);
-
-    while (cur->trigger != NULL)
-    {
-        Trigger_list* next = cur->next;
-        rassert(cur->trigger != NULL);
-        del_Trigger(cur->trigger);
-        memory_free(cur);
-        cur = next;
-    }
-
-    rassert(cur == trlist);
-    memory_free(cur);
-
-    return;
-}
-
-
@@ -1,7 +1,7 @@
 
 
 /*
- * Author: Tomi Jylhä-Ollila, Finland 2010-2018
+ * Author: Tomi Jylhä-Ollila, Finland 2010-2019
  *
  * This file is part of Kunquat.
  *
@@ -14,9 +14,9 @@
 
 #include <init/sheet/Trigger.h>
 
+#include <containers/Arena.h>
 #include <debug/assert.h>
 #include <kunquat/limits.h>
-#include <memory.h>
 #include <string/Streader.h>
 
 #include <stdbool.h>
@@ -52,12 +52,13 @@ bool Trigger_data_contains_name_spec(Streader* sr)
 }
 
 
-Trigger* new_Trigger(Event_type type, Tstamp* pos)
+Trigger* new_Trigger(Event_type type, Tstamp* pos, Arena* arena)
 {
     rassert(Event_is_valid(type));
     rassert(pos != NULL);
+    rassert(arena != NULL);
 
-    Trigger* trigger = memory_alloc_item(Trigger);
+    Trigger* trigger = Arena_alloc_item(arena, Trigger);
     if (trigger == NULL)
         return NULL;
 
@@ -69,10 +70,11 @@ Trigger* new_Trigger(Event_type type, Tstamp* pos)
 }
 
 
-Trigger* new_Trigger_from_string(Streader* sr, const Event_names* names)
+Trigger* new_Trigger_from_string(Streader* sr, const Event_names* names, Arena* arena)
 {
     rassert(sr != NULL);
     rassert(names != NULL);
+    rassert(arena != NULL);
 
     if (Streader_is_error_set(sr))
         return NULL;
@@ -137,7 +139,7 @@ Trigger* new_Trigger_from_string(Streader* sr, const Event_names* names)
         return NULL;
 
     // Create the trigger
-    Trigger* trigger = new_Trigger(type, pos);
+    Trigger* trigger = new_Trigger(type, pos, arena);
     if (trigger == NULL)
     {
         Streader_set_memory_error(
@@ -146,17 +148,17 @@ Trigger* new_Trigger_from_string(Streader* sr, const Event_names* names)
     }
 
     // Copy the event description
-    trigger->desc = memory_calloc_items(
-            char, (&sr->str[sr->pos] - event_desc) + 1);
+    const int64_t desc_length = &sr->str[sr->pos] - event_desc;
+    trigger->desc = Arena_alloc_items(arena, char, desc_length + 1);
     if (trigger->desc == NULL)
     {
         Streader_set_memory_error(
                 sr, "Could not allocate memory for a trigger");
-        del_Trigger(trigger);
         return NULL;
     }
 
-    strncpy(trigger->desc, event_desc, (size_t)(&sr->str[sr->pos] - event_desc));
+    memcpy(trigger->desc, event_desc, (size_t)desc_length);
+    trigger->desc[desc_length] = '\0';
 
     if (sep_pos != NULL)
     {
@@ -174,19 +176,18 @@ Trigger* new_Trigger_from_string(Streader* sr, const Event_names* names)
     // End of trigger
     Streader_match_char(sr, ']');
     if (Streader_is_error_set(sr))
-    {
-        del_Trigger(trigger);
         return NULL;
-    }
 
     return trigger;
 }
 
 
-Trigger* new_Trigger_of_name_spec_from_string(Streader* sr, const Event_names* names)
+Trigger* new_Trigger_of_name_spec_from_string(
+        Streader* sr, const Event_names* names, Arena* arena)
 {
     rassert(sr != NULL);
     rassert(names != NULL);
+    rassert(arena != NULL);
 
     if (Streader_is_error_set(sr))
         return NULL;
@@ -248,7 +249,7 @@ Trigger* new_Trigger_of_name_spec_from_string(Streader* sr, const Event_names* n
     rassert(Event_is_trigger(name_setter_type));
 
     // Create the trigger
-    Trigger* trigger = new_Trigger(name_setter_type, pos);
+    Trigger* trigger = new_Trigger(name_setter_type, pos, arena);
     if (trigger == NULL)
     {
         Streader_set_memory_error(
@@ -261,12 +262,11 @@ Trigger* new_Trigger_of_name_spec_from_string(Streader* sr, const Event_names* n
     snprintf(event_desc, 128, "[\"%s\", \"'%s'\"]", name_setter, name_arg);
     event_desc[127] = '\0';
 
-    trigger->desc = memory_calloc_items(char, (int64_t)(strlen(event_desc) + 1));
+    trigger->desc = Arena_alloc_items(arena, char, (int64_t)(strlen(event_desc) + 1));
     if (trigger->desc == NULL)
     {
         Streader_set_memory_error(
                 sr, "Could not allocate memory for a trigger");
-        del_Trigger(trigger);
         return NULL;
     }
 
@@ -297,16 +297,3 @@ const char* Trigger_get_desc(const Trigger* trigger)
 }
 
 
-void del_Trigger(Trigger* trigger)
-{
-    if (trigger == NULL)
-        return;
-
-    rassert(Event_is_valid(trigger->type));
-    memory_free(trigger->desc);
-    memory_free(trigger);
-
-    return;
-}
-
-
@@ -1,7 +1,7 @@
 
 
 /*
- * Author: Tomi Jylhä-Ollila, Finland 2010-2018
+ * Author: Tomi Jylhä-Ollila, Finland 2010-2019
  *
  * This file is part of Kunquat.
  *
@@ -16,6 +16,7 @@
 #define KQT_TRIGGER_H
 
 
+#include <decl.h>
 #include <kunquat/limits.h>
 #include <mathnum/Tstamp.h>
 #include <player/Event_names.h>
@@ -53,13 +54,14 @@ bool Trigger_data_contains_name_spec(Streader* sr);
 /**
  * Create a Trigger of specified type.
  *
- * \param type   The event type -- must be valid.
- * \param pos    The Trigger position -- must not be \c NULL.
+ * \param type    The event type -- must be valid.
+ * \param pos     The Trigger position -- must not be \c NULL.
+ * \param arena   The Arena that owns the Trigger -- must not be \c NULL.
  *
  * \return   The new Trigger if successful, or \c NULL if memory allocation
  *           failed or the event type isn't supported.
  */
-Trigger* new_Trigger(Event_type type, Tstamp* pos);
+Trigger* new_Trigger(Event_type type, Tstamp* pos, Arena* arena);
 
 
 /**
@@ -70,10 +72,12 @@ Trigger* new_Trigger(Event_type type, Tstamp* pos);
  *               The function does not modify the position of \a sr but may
  *               set an error.
  * \param names   The Event names -- must not be \c NULL.
+ * \param arena   The Arena that owns the Trigger -- must not be \c NULL.
  *
  * \return   The new Trigger if successful, otherwise \c NULL.
  */
-Trigger* new_Trigger_of_name_spec_from_string(Streader* sr, const Event_names* names);
+Trigger* new_Trigger_of_name_spec_from_string(
+        Streader* sr, const Event_names* names, Arena* arena);
 
 
 /**
@@ -84,10 +88,11 @@ Trigger* new_Trigger_of_name_spec_from_string(Streader* sr, const Event_names* n
  *                \a new_Trigger_of_name_spec_from_string must be called first
  *                if needed.
  * \param names   The Event names -- must not be \c NULL.
+ * \param arena   The Arena that owns the Trigger -- must not be \c NULL.
  *
  * \return   The new Trigger if successful, otherwise \c NULL.
  */
-Trigger* new_Trigger_from_string(Streader* sr, const Event_names* names);
+Trigger* new_Trigger_from_string(Streader* sr, const Event_names* names, Arena* arena);
 
 
 /**
@@ -120,14 +125,6 @@ Event_type Trigger_get_type(const Trigger* trigger);
 const char* Trigger_get_desc(const Trigger* trigger);
 
 
-/**
- * Destroy an existing Trigger.
- *
- * \param trigger   The Trigger, or \c NULL.
- */
-void del_Trigger(Trigger* trigger);
-
-
 #endif // KQT_TRIGGER_H
 
 
@@ -1,7 +1,7 @@
 
 
 /*
- * Author: Tomi Jylhä-Ollila, Finland 2010-2016
+ * Author: Tomi Jylhä-Ollila, Finland 2010-2019
  *
  * This file is part of Kunquat.
  *
@@ -15,6 +15,7 @@
 #include <mathnum/Random.h>
 
 #include <debug/assert.h>
+#include <intrinsics.h>
 #include <mathnum/hmac.h>
 
 #include <float.h>
@@ -50,6 +51,7 @@ void Random_set_seed(Random* random, uint64_t seed)
     hmac_md5(seed, random->context, &cseed, &dummy);
 
     random->seed = random->state = cseed;
+    random->block_counter = 0;
 
     return;
 }
@@ -59,6 +61,7 @@ void Random_reset(Random* random)
 {
     rassert(random != NULL);
     random->state = random->seed;
+    random->block_counter = 0;
     return;
 }
 
@@ -123,3 +126,112 @@ double Random_get_float_signal(Random* random)
 }
 
 
+// Block values are generated by hashing a counter with a 32-bit integer hash
+// (lowbias32 by Chris Wellons) in two rounds keyed by the seed
+
+static uint32_t mix_bits(uint32_t x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352dU;
+    x ^= x >> 15;
+    x *= 0x846ca68bU;
+    x ^= x >> 16;
+    return x;
+}
+
+
+static uint32_t get_block_bits(uint32_t counter, uint32_t key_lo, uint32_t key_hi)
+{
+    return mix_bits(mix_bits(counter ^ key_lo) + key_hi);
+}
+
+
+#if KQT_SSE4_1
+
+static __m128i mix_bits_i4(__m128i x)
+{
+    x = _mm_xor_si128(x, _mm_srli_epi32(x, 16));
+    x = _mm_mullo_epi32(x, _mm_set1_epi32((int32_t)0x7feb352dU));
+    x = _mm_xor_si128(x, _mm_srli_epi32(x, 15));
+    x = _mm_mullo_epi32(x, _mm_set1_epi32((int32_t)0x846ca68bU));
+    x = _mm_xor_si128(x, _mm_srli_epi32(x, 16));
+    return x;
+}
+
+#endif
+
+
+static void get_float_block(
+        Random* random, float* dest, int32_t count, int32_t offset, float scale)
+{
+    rassert(random != NULL);
+    rassert(dest != NULL);
+    rassert(count >= 0);
+
+    const uint32_t key_lo = (uint32_t)random->seed;
+    const uint32_t key_hi = (uint32_t)(random->seed >> 32);
+    uint32_t counter = (uint32_t)random->block_counter;
+
+    int32_t i = 0;
+
+#if KQT_SSE4_1
+    const __m128i key_lo_i4 = _mm_set1_epi32((int32_t)key_lo);
+    const __m128i key_hi_i4 = _mm_set1_epi32((int32_t)key_hi);
+    const __m128i offset_i4 = _mm_set1_epi32(offset);
+    const __m128 scale_f4 = _mm_set1_ps(scale);
+    const __m128i four = _mm_set1_epi32(4);
+
+    __m128i counters = _mm_add_epi32(
+            _mm_set1_epi32((int32_t)counter), _mm_set_epi32(3, 2, 1, 0));
+
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128i bits = mix_bits_i4(_mm_add_epi32(
+                    mix_bits_i4(_mm_xor_si128(counters, key_lo_i4)), key_hi_i4));
+        const __m128i values = _mm_sub_epi32(_mm_srli_epi32(bits, 8), offset_i4);
+        _mm_storeu_ps(dest + i, _mm_mul_ps(_mm_cvtepi32_ps(values), scale_f4));
+
+        counters = _mm_add_epi32(counters, four);
+    }
+
+    counter += (uint32_t)i;
+#endif
+
+    for (; i < count; ++i)
+    {
+        const uint32_t bits = get_block_bits(counter, key_lo, key_hi);
+        dest[i] = (float)((int32_t)(bits >> 8) - offset) * scale;
+        ++counter;
+    }
+
+    random->block_counter += (uint64_t)count;
+
+    return;
+}
+
+
+void Random_get_float_lb_block(Random* random, float* dest, int32_t count)
+{
+    rassert(random != NULL);
+    rassert(dest != NULL);
+    rassert(count >= 0);
+
+    // Use 24 bits to get exact results with single precision
+    get_float_block(random, dest, count, 0, 1.0f / 16777216.0f);
+
+    return;
+}
+
+
+void Random_get_float_signal_block(Random* random, float* dest, int32_t count)
+{
+    rassert(random != NULL);
+    rassert(dest != NULL);
+    rassert(count >= 0);
+
+    get_float_block(random, dest, count, 8388608, 1.0f / 8388608.0f);
+
+    return;
+}
+
+
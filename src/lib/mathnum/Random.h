@@ -1,7 +1,7 @@
 
 
 /*
- * Author: Tomi Jylhä-Ollila, Finland 2010-2018
+ * Author: Tomi Jylhä-Ollila, Finland 2010-2019
  *
  * This file is part of Kunquat.
  *
@@ -30,16 +30,21 @@
 
 /**
  * This is a portable pseudo-random generator.
+ *
+ * The block functions keep their own counter, so they produce a stream that
+ * is independent of the values retrieved with the other functions.
  */
 struct Random
 {
     char context[CONTEXT_LEN_MAX + 1];
     uint64_t seed;
     uint64_t state;
+    uint64_t block_counter;
 };
 
 
-#define RANDOM_AUTO (&(Random){ .context = "", .seed = 0, .state = 0 })
+#define RANDOM_AUTO \
+    (&(Random){ .context = "", .seed = 0, .state = 0, .block_counter = 0 })
 
 
 /**
@@ -77,7 +82,7 @@ void Random_set_seed(Random* random, uint64_t seed);
 
 
 /**
- * Restart the random sequence in the Random.
+ * Restart the random sequences in the Random.
  *
  * \param random   The Random generator -- must not be \c NULL.
  */
@@ -154,6 +159,34 @@ double Random_get_float_scale(Random* random);
 double Random_get_float_signal(Random* random);
 
 
+/**
+ * Fill a buffer with floating point numbers in the range [0, 1).
+ *
+ * The block functions use a counter-based generator keyed by the current
+ * seed of \a random, so the result is determined by the seed and the number
+ * of block values retrieved after the last reset. The block sequence and the
+ * sequence of the other functions of the Random generator are independent:
+ * retrieving values from one does not affect the other.
+ *
+ * \param random   The Random generator -- must not be \c NULL.
+ * \param dest     The destination buffer -- must not be \c NULL.
+ * \param count    The number of values to be generated -- must be >= \c 0.
+ */
+void Random_get_float_lb_block(Random* random, float* dest, int32_t count);
+
+
+/**
+ * Fill a buffer with floating point numbers in the range [-1.0, 1.0).
+ *
+ * See \a Random_get_float_lb_block for details of the sequence.
+ *
+ * \param random   The Random generator -- must not be \c NULL.
+ * \param dest     The destination buffer -- must not be \c NULL.
+ * \param count    The number of values to be generated -- must be >= \c 0.
+ */
+void Random_get_float_signal_block(Random* random, float* dest, int32_t count);
+
+
 #endif // KQT_RANDOM_H
 
 
@@ -2,7 +2,7 @@
 
 /*
  * Authors: Ossi Saresoja, Finland 2016
- *          Tomi Jylhä-Ollila, Finland 2016-2018
+ *          Tomi Jylhä-Ollila, Finland 2016-2019
  *
  * This file is part of Kunquat.
  *
@@ -92,6 +92,105 @@ static inline __m128 fast_exp2_f4(__m128 x)
 #endif
 
 
+/**
+ * Calculate fast approximations of base-2 exponential function for a buffer.
+ *
+ * Finite input values are clamped to the range [\c -125, \c 127] so that
+ * their results are normal single-precision values. With SSE2, the relative
+ * error is below \c 1e-6, which is close to single-precision rounding error.
+ * Otherwise the values are calculated with \a fast_exp2, whose relative error
+ * is below \c 1e-3.
+ *
+ * \param dest    The destination buffer -- must not be \c NULL. This may be
+ *                the same as \a src.
+ * \param src     The input buffer -- must not be \c NULL. Negative infinity
+ *                and NaN values produce exactly \c 0, and positive infinity
+ *                is treated as the upper bound of the input range.
+ * \param count   The number of values -- must be >= \c 0.
+ */
+static inline void fast_exp2_block(float* dest, const float* src, int32_t count)
+{
+    dassert(dest != NULL);
+    dassert(src != NULL);
+    dassert(count >= 0);
+
+    int32_t i = 0;
+
+#if KQT_SSE2
+    {
+        // Polynomial approximation of 2^x in range [-0.5, 0.5] from Cephes
+        const __m128 c0 = _mm_set1_ps(1.535336188319500e-4f);
+        const __m128 c1 = _mm_set1_ps(1.339887440266574e-3f);
+        const __m128 c2 = _mm_set1_ps(9.618437357674640e-3f);
+        const __m128 c3 = _mm_set1_ps(5.550332471162809e-2f);
+        const __m128 c4 = _mm_set1_ps(2.402264791363012e-1f);
+        const __m128 c5 = _mm_set1_ps(6.931472028550421e-1f);
+        const __m128 one = _mm_set1_ps(1.0f);
+
+        const __m128 min_x = _mm_set1_ps(-125.0f);
+        const __m128 max_x = _mm_set1_ps(127.0f);
+        const __m128 neg_inf = _mm_set1_ps(-INFINITY);
+
+        for (; i + 4 <= count; i += 4)
+        {
+            const __m128 src_x = _mm_loadu_ps(src + i);
+            const __m128 x = _mm_min_ps(_mm_max_ps(src_x, min_x), max_x);
+
+            // Negative infinity and NaN fail this comparison
+            const __m128 is_nonzero = _mm_cmpgt_ps(src_x, neg_inf);
+
+            const __m128i n = _mm_cvtps_epi32(x);
+            const __m128 rem = _mm_sub_ps(x, _mm_cvtepi32_ps(n));
+
+            __m128 p = _mm_add_ps(_mm_mul_ps(c0, rem), c1);
+            p = _mm_add_ps(_mm_mul_ps(p, rem), c2);
+            p = _mm_add_ps(_mm_mul_ps(p, rem), c3);
+            p = _mm_add_ps(_mm_mul_ps(p, rem), c4);
+            p = _mm_add_ps(_mm_mul_ps(p, rem), c5);
+            p = _mm_add_ps(_mm_mul_ps(p, rem), one);
+
+            const __m128i exp_add = _mm_slli_epi32(n, 23);
+            const __m128 result = _mm_and_ps(
+                    _mm_castsi128_ps(_mm_add_epi32(exp_add, _mm_castps_si128(p))),
+                    is_nonzero);
+
+            _mm_storeu_ps(dest + i, result);
+        }
+
+        // Process the remaining values with the same approximation
+        if (i < count)
+        {
+            float tail[4] = { 0 };
+            for (int32_t k = 0; k < count - i; ++k)
+                tail[k] = src[i + k];
+
+            fast_exp2_block(tail, tail, 4);
+
+            for (int32_t k = 0; k < count - i; ++k)
+                dest[i + k] = tail[k];
+
+            i = count;
+        }
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        const float x = src[i];
+        if (!(x > -INFINITY))
+        {
+            dest[i] = 0;
+            continue;
+        }
+
+        const double clamped_x = (x >= -125.0f) ? ((x <= 127.0f) ? x : 127.0) : -125.0;
+        dest[i] = (float)fast_exp2(clamped_x);
+    }
+
+    return;
+}
+
+
 #endif // KQT_FAST_EXP2_H
 
 
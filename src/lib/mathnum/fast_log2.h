@@ -1,7 +1,7 @@
 
 
 /*
- * Author: Tomi Jylhä-Ollila, Finland 2016-2018
+ * Author: Tomi Jylhä-Ollila, Finland 2016-2019
  *
  * This file is part of Kunquat.
  *
@@ -20,6 +20,7 @@
 #include <intrinsics.h>
 
 #include <math.h>
+#include <stdint.h>
 
 
 /**
@@ -96,6 +97,53 @@ static inline __m128 fast_log2_f4(__m128 x)
 #endif // KQT_SSE2
 
 
+/**
+ * Calculate fast approximations of base-2 logarithm function for a buffer.
+ *
+ * This uses the same approximation as \a fast_log2, so the absolute error is
+ * below \c 3e-4.
+ *
+ * \param dest    The destination buffer -- must not be \c NULL. This may be
+ *                the same as \a src.
+ * \param src     The input buffer -- must not be \c NULL. The values must be
+ *                finite, normal and > \c 0.
+ * \param count   The number of values -- must be >= \c 0.
+ */
+static inline void fast_log2_block(float* dest, const float* src, int32_t count)
+{
+    dassert(dest != NULL);
+    dassert(src != NULL);
+    dassert(count >= 0);
+
+    int32_t i = 0;
+
+#if KQT_SSE2
+    for (; i + 4 <= count; i += 4)
+        _mm_storeu_ps(dest + i, fast_log2_f4(_mm_loadu_ps(src + i)));
+
+    // Process the remaining values with the same approximation
+    if (i < count)
+    {
+        float tail[4] = { 1, 1, 1, 1 };
+        for (int32_t k = 0; k < count - i; ++k)
+            tail[k] = src[i + k];
+
+        _mm_storeu_ps(tail, fast_log2_f4(_mm_loadu_ps(tail)));
+
+        for (int32_t k = 0; k < count - i; ++k)
+            dest[i + k] = tail[k];
+
+        i = count;
+    }
+#endif
+
+    for (; i < count; ++i)
+        dest[i] = (float)fast_log2(src[i]);
+
+    return;
+}
+
+
 #endif // KQT_FAST_LOG2_H
 
 
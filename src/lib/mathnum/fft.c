@@ -4,7 +4,7 @@
  * This is a modified version of the FFTPACK C implementation released
  * to the public domain, source: http://www.netlib.org/fftpack/fft.c
  *
- * Modifications for Kunquat by Tomi Jylhä-Ollila, Finland 2016
+ * Modifications for Kunquat by Tomi Jylhä-Ollila, Finland 2016-2019
  *
  * CC0 1.0 Universal, http://creativecommons.org/publicdomain/zero/1.0/
  *
@@ -16,53 +16,765 @@
 #include <mathnum/fft.h>
 
 #include <debug/assert.h>
+#include <intrinsics.h>
 #include <mathnum/common.h>
 #include <memory.h>
+#include <threads/Mutex.h>
 
 #include <math.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
 
 
+static void drfti_factorise(int32_t n, int32_t* ifac);
 static void drfti1(int32_t n, float* wa, int32_t* ifac);
 static void drftf1(int32_t n, float* c, float* ch, float* wa, const int32_t* ifac);
 static void drftb1(int32_t n, float* c, float* ch, const float* wa, const int32_t* ifac);
 
 
-FFT_worker* FFT_worker_init(FFT_worker* worker, int32_t max_tlength)
+/*
+ * Power-of-two lengths are transformed as complex sequences of half the length
+ * with a radix-4 Stockham algorithm in split format, followed by a separation
+ * step that produces the same half-complex layout as FFTPACK.
+ */
+
+
+#define FFT_PLAN_MIN_LENGTH 32
+#define FFT_PLAN_CACHE_SIZE 32
+
+
+struct FFT_plan
 {
-    rassert(worker != NULL);
-    rassert(max_tlength > 0);
+    int32_t length;
+    int ref_count;
 
-    worker->wsave = memory_calloc_items(float, max_tlength * 2);
-    if (worker->wsave == NULL)
+    // Twiddle factors of the first complex stage, each of length/8 items
+    float* stage1_tws[6];
+
+    // Twiddle factors of the remaining complex stages, each of 3*length/8 items
+    float* tw_res;
+    float* tw_ims;
+
+    // Twiddle factors of the real separation step, each of length/2 items
+    float* real_coss;
+    float* real_sins;
+
+    float* data;
+};
+
+
+#ifdef ENABLE_THREADS
+static Mutex plan_cache_lock = MUTEX_STATIC_INIT;
+#endif
+static FFT_plan* plan_cache[FFT_PLAN_CACHE_SIZE] = { NULL };
+
+
+static void lock_plan_cache(void)
+{
+#ifdef ENABLE_THREADS
+    Mutex_lock(&plan_cache_lock);
+#endif
+    return;
+}
+
+
+static void unlock_plan_cache(void)
+{
+#ifdef ENABLE_THREADS
+    Mutex_unlock(&plan_cache_lock);
+#endif
+    return;
+}
+
+
+static bool are_plans_enabled = true;
+
+
+void FFT_set_plans_enabled(bool enabled)
+{
+    are_plans_enabled = enabled;
+    return;
+}
+
+
+static int get_plan_index(int32_t length)
+{
+    rassert(is_p2(length));
+
+    int index = 0;
+    while ((1 << index) < length)
+        ++index;
+
+    rassert(index < FFT_PLAN_CACHE_SIZE);
+
+    return index;
+}
+
+
+static void del_FFT_plan(FFT_plan* plan)
+{
+    if (plan == NULL)
+        return;
+
+    memory_free(plan->data);
+    memory_free(plan);
+
+    return;
+}
+
+
+static FFT_plan* new_FFT_plan(int32_t length)
+{
+    rassert(length >= FFT_PLAN_MIN_LENGTH);
+    rassert(is_p2(length));
+
+    FFT_plan* plan = memory_alloc_item(FFT_plan);
+    if (plan == NULL)
         return NULL;
 
-    worker->max_length = max_tlength;
-    worker->cur_length = 0;
+    const int32_t m = length / 2;
 
-    for (int i = 0; i < 32; ++i)
-        worker->ifac[0] = 0;
+    plan->length = length;
+    plan->ref_count = 0;
+    plan->data = memory_alloc_items(float, (m / 4) * 6 + (m * 3 / 4) * 2 + m * 2);
+    if (plan->data == NULL)
+    {
+        del_FFT_plan(plan);
+        return NULL;
+    }
 
-    return worker;
+    float* next = plan->data;
+    for (int i = 0; i < 6; ++i)
+    {
+        plan->stage1_tws[i] = next;
+        next += m / 4;
+    }
+    plan->tw_res = next;
+    next += m * 3 / 4;
+    plan->tw_ims = next;
+    next += m * 3 / 4;
+    plan->real_coss = next;
+    next += m;
+    plan->real_sins = next;
+
+    for (int32_t p = 0; p < m / 4; ++p)
+    {
+        for (int j = 1; j <= 3; ++j)
+        {
+            const double arg = PI2 * (double)(j * p) / (double)m;
+            plan->stage1_tws[(j - 1) * 2][p] = (float)cos(arg);
+            plan->stage1_tws[(j - 1) * 2 + 1][p] = (float)-sin(arg);
+        }
+    }
+
+    for (int32_t k = 0; k < m * 3 / 4; ++k)
+    {
+        const double arg = PI2 * (double)k / (double)m;
+        plan->tw_res[k] = (float)cos(arg);
+        plan->tw_ims[k] = (float)-sin(arg);
+    }
+
+    for (int32_t k = 0; k < m; ++k)
+    {
+        const double arg = PI2 * (double)k / (double)length;
+        plan->real_coss[k] = (float)cos(arg);
+        plan->real_sins[k] = (float)sin(arg);
+    }
+
+    return plan;
+}
+
+
+static FFT_plan* acquire_FFT_plan(int32_t length)
+{
+    rassert(length >= FFT_PLAN_MIN_LENGTH);
+    rassert(is_p2(length));
+
+    const int index = get_plan_index(length);
+
+    lock_plan_cache();
+    FFT_plan* plan = plan_cache[index];
+    if (plan != NULL)
+        ++plan->ref_count;
+    unlock_plan_cache();
+
+    if (plan != NULL)
+        return plan;
+
+    // Build the plan without holding the lock as it may take a while
+    // The cache is shared by all Handles, so the plan is charged to none of them
+    Memory_usage* prev_usage = memory_set_usage(memory_get_shared_usage());
+    FFT_plan* new_plan = new_FFT_plan(length);
+    memory_set_usage(prev_usage);
+    if (new_plan == NULL)
+        return NULL;
+
+    lock_plan_cache();
+    plan = plan_cache[index];
+    if (plan == NULL)
+    {
+        plan = new_plan;
+        plan_cache[index] = plan;
+        new_plan = NULL;
+    }
+    ++plan->ref_count;
+    unlock_plan_cache();
+
+    del_FFT_plan(new_plan);
+
+    return plan;
+}
+
+
+static void release_FFT_plan(FFT_plan* plan)
+{
+    if (plan == NULL)
+        return;
+
+    const int index = get_plan_index(plan->length);
+
+    lock_plan_cache();
+    rassert(plan_cache[index] == plan);
+    rassert(plan->ref_count > 0);
+    --plan->ref_count;
+    if (plan->ref_count == 0)
+        plan_cache[index] = NULL;
+    else
+        plan = NULL;
+    unlock_plan_cache();
+
+    del_FFT_plan(plan);
+
+    return;
+}
+
+
+#if KQT_SSE
+static void transpose_store(float* dest, __m128 v0, __m128 v1, __m128 v2, __m128 v3)
+{
+    _MM_TRANSPOSE4_PS(v0, v1, v2, v3);
+    _mm_storeu_ps(dest, v0);
+    _mm_storeu_ps(dest + 4, v1);
+    _mm_storeu_ps(dest + 8, v2);
+    _mm_storeu_ps(dest + 12, v3);
+
+    return;
+}
+#endif
+
+
+static void cfft_stage1(
+        const FFT_plan* plan,
+        const float* x_res,
+        const float* x_ims,
+        float* y_res,
+        float* y_ims)
+{
+    const int32_t n4 = plan->length / 8;
+    const float* const* tws = (const float* const*)plan->stage1_tws;
+
+#if KQT_SSE
+    for (int32_t p = 0; p < n4; p += 4)
+    {
+        const __m128 a_re = _mm_loadu_ps(x_res + p);
+        const __m128 a_im = _mm_loadu_ps(x_ims + p);
+        const __m128 b_re = _mm_loadu_ps(x_res + p + n4);
+        const __m128 b_im = _mm_loadu_ps(x_ims + p + n4);
+        const __m128 c_re = _mm_loadu_ps(x_res + p + n4 * 2);
+        const __m128 c_im = _mm_loadu_ps(x_ims + p + n4 * 2);
+        const __m128 d_re = _mm_loadu_ps(x_res + p + n4 * 3);
+        const __m128 d_im = _mm_loadu_ps(x_ims + p + n4 * 3);
+
+        const __m128 apc_re = _mm_add_ps(a_re, c_re);
+        const __m128 apc_im = _mm_add_ps(a_im, c_im);
+        const __m128 amc_re = _mm_sub_ps(a_re, c_re);
+        const __m128 amc_im = _mm_sub_ps(a_im, c_im);
+        const __m128 bpd_re = _mm_add_ps(b_re, d_re);
+        const __m128 bpd_im = _mm_add_ps(b_im, d_im);
+        const __m128 bmd_re = _mm_sub_ps(b_re, d_re);
+        const __m128 bmd_im = _mm_sub_ps(b_im, d_im);
+
+        const __m128 t1_re = _mm_add_ps(amc_re, bmd_im);
+        const __m128 t1_im = _mm_sub_ps(amc_im, bmd_re);
+        const __m128 t2_re = _mm_sub_ps(apc_re, bpd_re);
+        const __m128 t2_im = _mm_sub_ps(apc_im, bpd_im);
+        const __m128 t3_re = _mm_sub_ps(amc_re, bmd_im);
+        const __m128 t3_im = _mm_add_ps(amc_im, bmd_re);
+
+        const __m128 w1_re = _mm_loadu_ps(tws[0] + p);
+        const __m128 w1_im = _mm_loadu_ps(tws[1] + p);
+        const __m128 w2_re = _mm_loadu_ps(tws[2] + p);
+        const __m128 w2_im = _mm_loadu_ps(tws[3] + p);
+        const __m128 w3_re = _mm_loadu_ps(tws[4] + p);
+        const __m128 w3_im = _mm_loadu_ps(tws[5] + p);
+
+        transpose_store(
+                y_res + p * 4,
+                _mm_add_ps(apc_re, bpd_re),
+                _mm_sub_ps(_mm_mul_ps(w1_re, t1_re), _mm_mul_ps(w1_im, t1_im)),
+                _mm_sub_ps(_mm_mul_ps(w2_re, t2_re), _mm_mul_ps(w2_im, t2_im)),
+                _mm_sub_ps(_mm_mul_ps(w3_re, t3_re), _mm_mul_ps(w3_im, t3_im)));
+        transpose_store(
+                y_ims + p * 4,
+                _mm_add_ps(apc_im, bpd_im),
+                _mm_add_ps(_mm_mul_ps(w1_re, t1_im), _mm_mul_ps(w1_im, t1_re)),
+                _mm_add_ps(_mm_mul_ps(w2_re, t2_im), _mm_mul_ps(w2_im, t2_re)),
+                _mm_add_ps(_mm_mul_ps(w3_re, t3_im), _mm_mul_ps(w3_im, t3_re)));
+    }
+#else
+    for (int32_t p = 0; p < n4; ++p)
+    {
+        const float apc_re = x_res[p] + x_res[p + n4 * 2];
+        const float apc_im = x_ims[p] + x_ims[p + n4 * 2];
+        const float amc_re = x_res[p] - x_res[p + n4 * 2];
+        const float amc_im = x_ims[p] - x_ims[p + n4 * 2];
+        const float bpd_re = x_res[p + n4] + x_res[p + n4 * 3];
+        const float bpd_im = x_ims[p + n4] + x_ims[p + n4 * 3];
+        const float bmd_re = x_res[p + n4] - x_res[p + n4 * 3];
+        const float bmd_im = x_ims[p + n4] - x_ims[p + n4 * 3];
+
+        const float t1_re = amc_re + bmd_im;
+        const float t1_im = amc_im - bmd_re;
+        const float t2_re = apc_re - bpd_re;
+        const float t2_im = apc_im - bpd_im;
+        const float t3_re = amc_re - bmd_im;
+        const float t3_im = amc_im + bmd_re;
+
+        y_res[p * 4] = apc_re + bpd_re;
+        y_ims[p * 4] = apc_im + bpd_im;
+        y_res[p * 4 + 1] = tws[0][p] * t1_re - tws[1][p] * t1_im;
+        y_ims[p * 4 + 1] = tws[0][p] * t1_im + tws[1][p] * t1_re;
+        y_res[p * 4 + 2] = tws[2][p] * t2_re - tws[3][p] * t2_im;
+        y_ims[p * 4 + 2] = tws[2][p] * t2_im + tws[3][p] * t2_re;
+        y_res[p * 4 + 3] = tws[4][p] * t3_re - tws[5][p] * t3_im;
+        y_ims[p * 4 + 3] = tws[4][p] * t3_im + tws[5][p] * t3_re;
+    }
+#endif
+
+    return;
+}
+
+
+static void cfft_radix4_stage(
+        const FFT_plan* plan,
+        int32_t s,
+        const float* x_res,
+        const float* x_ims,
+        float* y_res,
+        float* y_ims)
+{
+    const int32_t m = plan->length / 2;
+    const int32_t n4 = m / s / 4;
+    const int32_t offset = s * n4;
+
+    for (int32_t p = 0; p < n4; ++p)
+    {
+        const float w1_re = plan->tw_res[p * s];
+        const float w1_im = plan->tw_ims[p * s];
+        const float w2_re = plan->tw_res[p * s * 2];
+        const float w2_im = plan->tw_ims[p * s * 2];
+        const float w3_re = plan->tw_res[p * s * 3];
+        const float w3_im = plan->tw_ims[p * s * 3];
+
+        const float* a_res = x_res + s * p;
+        const float* a_ims = x_ims + s * p;
+        float* y0_res = y_res + s * p * 4;
+        float* y0_ims = y_ims + s * p * 4;
+
+#if KQT_SSE
+        const __m128 w1_res = _mm_set1_ps(w1_re);
+        const __m128 w1_ims = _mm_set1_ps(w1_im);
+        const __m128 w2_res = _mm_set1_ps(w2_re);
+        const __m128 w2_ims = _mm_set1_ps(w2_im);
+        const __m128 w3_res = _mm_set1_ps(w3_re);
+        const __m128 w3_ims = _mm_set1_ps(w3_im);
+
+        for (int32_t q = 0; q < s; q += 4)
+        {
+            const __m128 a_re = _mm_loadu_ps(a_res + q);
+            const __m128 a_im = _mm_loadu_ps(a_ims + q);
+            const __m128 b_re = _mm_loadu_ps(a_res + q + offset);
+            const __m128 b_im = _mm_loadu_ps(a_ims + q + offset);
+            const __m128 c_re = _mm_loadu_ps(a_res + q + offset * 2);
+            const __m128 c_im = _mm_loadu_ps(a_ims + q + offset * 2);
+            const __m128 d_re = _mm_loadu_ps(a_res + q + offset * 3);
+            const __m128 d_im = _mm_loadu_ps(a_ims + q + offset * 3);
+
+            const __m128 apc_re = _mm_add_ps(a_re, c_re);
+            const __m128 apc_im = _mm_add_ps(a_im, c_im);
+            const __m128 amc_re = _mm_sub_ps(a_re, c_re);
+            const __m128 amc_im = _mm_sub_ps(a_im, c_im);
+            const __m128 bpd_re = _mm_add_ps(b_re, d_re);
+            const __m128 bpd_im = _mm_add_ps(b_im, d_im);
+            const __m128 bmd_re = _mm_sub_ps(b_re, d_re);
+            const __m128 bmd_im = _mm_sub_ps(b_im, d_im);
+
+            const __m128 t1_re = _mm_add_ps(amc_re, bmd_im);
+            const __m128 t1_im = _mm_sub_ps(amc_im, bmd_re);
+            const __m128 t2_re = _mm_sub_ps(apc_re, bpd_re);
+            const __m128 t2_im = _mm_sub_ps(apc_im, bpd_im);
+            const __m128 t3_re = _mm_sub_ps(amc_re, bmd_im);
+            const __m128 t3_im = _mm_add_ps(amc_im, bmd_re);
+
+            _mm_storeu_ps(y0_res + q, _mm_add_ps(apc_re, bpd_re));
+            _mm_storeu_ps(y0_ims + q, _mm_add_ps(apc_im, bpd_im));
+            _mm_storeu_ps(
+                    y0_res + q + s,
+                    _mm_sub_ps(_mm_mul_ps(w1_res, t1_re), _mm_mul_ps(w1_ims, t1_im)));
+            _mm_storeu_ps(
+                    y0_ims + q + s,
+                    _mm_add_ps(_mm_mul_ps(w1_res, t1_im), _mm_mul_ps(w1_ims, t1_re)));
+            _mm_storeu_ps(
+                    y0_res + q + s * 2,
+                    _mm_sub_ps(_mm_mul_ps(w2_res, t2_re), _mm_mul_ps(w2_ims, t2_im)));
+            _mm_storeu_ps(
+                    y0_ims + q + s * 2,
+                    _mm_add_ps(_mm_mul_ps(w2_res, t2_im), _mm_mul_ps(w2_ims, t2_re)));
+            _mm_storeu_ps(
+                    y0_res + q + s * 3,
+                    _mm_sub_ps(_mm_mul_ps(w3_res, t3_re), _mm_mul_ps(w3_ims, t3_im)));
+            _mm_storeu_ps(
+                    y0_ims + q + s * 3,
+                    _mm_add_ps(_mm_mul_ps(w3_res, t3_im), _mm_mul_ps(w3_ims, t3_re)));
+        }
+#else
+        for (int32_t q = 0; q < s; ++q)
+        {
+            const float apc_re = a_res[q] + a_res[q + offset * 2];
+            const float apc_im = a_ims[q] + a_ims[q + offset * 2];
+            const float amc_re = a_res[q] - a_res[q + offset * 2];
+            const float amc_im = a_ims[q] - a_ims[q + offset * 2];
+            const float bpd_re = a_res[q + offset] + a_res[q + offset * 3];
+            const float bpd_im = a_ims[q + offset] + a_ims[q + offset * 3];
+            const float bmd_re = a_res[q + offset] - a_res[q + offset * 3];
+            const float bmd_im = a_ims[q + offset] - a_ims[q + offset * 3];
+
+            const float t1_re = amc_re + bmd_im;
+            const float t1_im = amc_im - bmd_re;
+            const float t2_re = apc_re - bpd_re;
+            const float t2_im = apc_im - bpd_im;
+            const float t3_re = amc_re - bmd_im;
+            const float t3_im = amc_im + bmd_re;
+
+            y0_res[q] = apc_re + bpd_re;
+            y0_ims[q] = apc_im + bpd_im;
+            y0_res[q + s] = w1_re * t1_re - w1_im * t1_im;
+            y0_ims[q + s] = w1_re * t1_im + w1_im * t1_re;
+            y0_res[q + s * 2] = w2_re * t2_re - w2_im * t2_im;
+            y0_ims[q + s * 2] = w2_re * t2_im + w2_im * t2_re;
+            y0_res[q + s * 3] = w3_re * t3_re - w3_im * t3_im;
+            y0_ims[q + s * 3] = w3_re * t3_im + w3_im * t3_re;
+        }
+#endif
+    }
+
+    return;
+}
+
+
+static void cfft_radix2_stage(
+        int32_t s, const float* x_res, const float* x_ims, float* y_res, float* y_ims)
+{
+#if KQT_SSE
+    for (int32_t q = 0; q < s; q += 4)
+    {
+        const __m128 a_re = _mm_loadu_ps(x_res + q);
+        const __m128 a_im = _mm_loadu_ps(x_ims + q);
+        const __m128 b_re = _mm_loadu_ps(x_res + q + s);
+        const __m128 b_im = _mm_loadu_ps(x_ims + q + s);
+        _mm_storeu_ps(y_res + q, _mm_add_ps(a_re, b_re));
+        _mm_storeu_ps(y_ims + q, _mm_add_ps(a_im, b_im));
+        _mm_storeu_ps(y_res + q + s, _mm_sub_ps(a_re, b_re));
+        _mm_storeu_ps(y_ims + q + s, _mm_sub_ps(a_im, b_im));
+    }
+#else
+    for (int32_t q = 0; q < s; ++q)
+    {
+        y_res[q] = x_res[q] + x_res[q + s];
+        y_ims[q] = x_ims[q] + x_ims[q + s];
+        y_res[q + s] = x_res[q] - x_res[q + s];
+        y_ims[q + s] = x_ims[q] - x_ims[q + s];
+    }
+#endif
+
+    return;
+}
+
+
+/**
+ * Calculate the forward complex transform of length plan->length / 2.
+ *
+ * The inverse transform is calculated by swapping the real and imaginary parts
+ * of both the input and the output.
+ *
+ * \return   \c true if the result is in \a tmp_res and \a tmp_ims, or \c false
+ *           if the result is in \a res and \a ims.
+ */
+static bool cfft(
+        const FFT_plan* plan, float* res, float* ims, float* tmp_res, float* tmp_ims)
+{
+    const int32_t m = plan->length / 2;
+
+    float* x_res = res;
+    float* x_ims = ims;
+    float* y_res = tmp_res;
+    float* y_ims = tmp_ims;
+
+    cfft_stage1(plan, x_res, x_ims, y_res, y_ims);
+
+    int32_t s = 4;
+    while (s < m)
+    {
+        float* swap_res = x_res;
+        float* swap_ims = x_ims;
+        x_res = y_res;
+        x_ims = y_ims;
+        y_res = swap_res;
+        y_ims = swap_ims;
+
+        if (s * 2 == m)
+        {
+            cfft_radix2_stage(s, x_res, x_ims, y_res, y_ims);
+            break;
+        }
+
+        cfft_radix4_stage(plan, s, x_res, x_ims, y_res, y_ims);
+        s *= 4;
+    }
+
+    return (y_res == tmp_res);
+}
+
+
+static void rfft_plan(const FFT_plan* plan, float* data, float* work)
+{
+    const int32_t n = plan->length;
+    const int32_t m = n / 2;
+
+    float* res = work;
+    float* ims = work + m;
+
+    // Split the even and odd items into the real and imaginary parts
+    {
+        int32_t k = 0;
+#if KQT_SSE
+        for (; k < m; k += 4)
+        {
+            const __m128 lo = _mm_loadu_ps(data + k * 2);
+            const __m128 hi = _mm_loadu_ps(data + k * 2 + 4);
+            _mm_storeu_ps(res + k, _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0)));
+            _mm_storeu_ps(ims + k, _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1)));
+        }
+#endif
+        for (; k < m; ++k)
+        {
+            res[k] = data[k * 2];
+            ims[k] = data[k * 2 + 1];
+        }
+    }
+
+    if (cfft(plan, res, ims, work + n, work + n + m))
+    {
+        res = work + n;
+        ims = work + n + m;
+    }
+
+    // Separate the transforms of the even and odd items
+    data[0] = res[0] + ims[0];
+    data[n - 1] = res[0] - ims[0];
+
+    int32_t k = 1;
+
+#if KQT_SSE
+    const __m128 halves = _mm_set1_ps(0.5f);
+
+    for (; k + 3 < m; k += 4)
+    {
+        const int32_t j = m - k - 3;
+        const __m128 zk_re = _mm_loadu_ps(res + k);
+        const __m128 zk_im = _mm_loadu_ps(ims + k);
+        const __m128 zj_re =
+            _mm_shuffle_ps(_mm_loadu_ps(res + j), _mm_loadu_ps(res + j), 0x1b);
+        const __m128 zj_im =
+            _mm_shuffle_ps(_mm_loadu_ps(ims + j), _mm_loadu_ps(ims + j), 0x1b);
+
+        const __m128 e_re = _mm_mul_ps(_mm_add_ps(zk_re, zj_re), halves);
+        const __m128 e_im = _mm_mul_ps(_mm_sub_ps(zk_im, zj_im), halves);
+        const __m128 d_re = _mm_mul_ps(_mm_sub_ps(zk_re, zj_re), halves);
+        const __m128 d_im = _mm_mul_ps(_mm_add_ps(zk_im, zj_im), halves);
+
+        const __m128 c = _mm_loadu_ps(plan->real_coss + k);
+        const __m128 s = _mm_loadu_ps(plan->real_sins + k);
+
+        const __m128 x_re = _mm_add_ps(
+                e_re, _mm_sub_ps(_mm_mul_ps(c, d_im), _mm_mul_ps(s, d_re)));
+        const __m128 x_im = _mm_sub_ps(
+                e_im, _mm_add_ps(_mm_mul_ps(c, d_re), _mm_mul_ps(s, d_im)));
+
+        _mm_storeu_ps(data + k * 2 - 1, _mm_unpacklo_ps(x_re, x_im));
+        _mm_storeu_ps(data + k * 2 + 3, _mm_unpackhi_ps(x_re, x_im));
+    }
+#endif
+
+    for (; k < m; ++k)
+    {
+        const int32_t j = m - k;
+        const float e_re = (res[k] + res[j]) * 0.5f;
+        const float e_im = (ims[k] - ims[j]) * 0.5f;
+        const float d_re = (res[k] - res[j]) * 0.5f;
+        const float d_im = (ims[k] + ims[j]) * 0.5f;
+
+        const float c = plan->real_coss[k];
+        const float s = plan->real_sins[k];
+
+        data[k * 2 - 1] = e_re + ((c * d_im) - (s * d_re));
+        data[k * 2] = e_im - ((c * d_re) + (s * d_im));
+    }
+
+    return;
+}
+
+
+static void irfft_plan(const FFT_plan* plan, float* data, float* work)
+{
+    const int32_t n = plan->length;
+    const int32_t m = n / 2;
+
+    float* res = work;
+    float* ims = work + m;
+
+    // Combine the transforms of the even and odd items
+    res[0] = data[0] + data[n - 1];
+    ims[0] = data[0] - data[n - 1];
+
+    int32_t k = 1;
+
+#if KQT_SSE
+    for (; k + 3 < m; k += 4)
+    {
+        const int32_t j = m - k - 3;
+        const __m128 xk_lo = _mm_loadu_ps(data + k * 2 - 1);
+        const __m128 xk_hi = _mm_loadu_ps(data + k * 2 + 3);
+        const __m128 xj_lo = _mm_loadu_ps(data + j * 2 - 1);
+        const __m128 xj_hi = _mm_loadu_ps(data + j * 2 + 3);
+
+        const __m128 xk_re = _mm_shuffle_ps(xk_lo, xk_hi, _MM_SHUFFLE(2, 0, 2, 0));
+        const __m128 xk_im = _mm_shuffle_ps(xk_lo, xk_hi, _MM_SHUFFLE(3, 1, 3, 1));
+        const __m128 xj_re = _mm_shuffle_ps(xj_hi, xj_lo, _MM_SHUFFLE(0, 2, 0, 2));
+        const __m128 xj_im = _mm_shuffle_ps(xj_hi, xj_lo, _MM_SHUFFLE(1, 3, 1, 3));
+
+        const __m128 a_re = _mm_add_ps(xk_re, xj_re);
+        const __m128 a_im = _mm_sub_ps(xk_im, xj_im);
+        const __m128 b_re = _mm_sub_ps(xk_re, xj_re);
+        const __m128 b_im = _mm_add_ps(xk_im, xj_im);
+
+        const __m128 c = _mm_loadu_ps(plan->real_coss + k);
+        const __m128 s = _mm_loadu_ps(plan->real_sins + k);
+
+        _mm_storeu_ps(
+                res + k,
+                _mm_sub_ps(a_re, _mm_add_ps(_mm_mul_ps(b_re, s), _mm_mul_ps(b_im, c))));
+        _mm_storeu_ps(
+                ims + k,
+                _mm_add_ps(a_im, _mm_sub_ps(_mm_mul_ps(b_re, c), _mm_mul_ps(b_im, s))));
+    }
+#endif
+
+    for (; k < m; ++k)
+    {
+        const int32_t j = m - k;
+        const float a_re = data[k * 2 - 1] + data[j * 2 - 1];
+        const float a_im = data[k * 2] - data[j * 2];
+        const float b_re = data[k * 2 - 1] - data[j * 2 - 1];
+        const float b_im = data[k * 2] + data[j * 2];
+
+        const float c = plan->real_coss[k];
+        const float s = plan->real_sins[k];
+
+        res[k] = a_re - ((b_re * s) + (b_im * c));
+        ims[k] = a_im + ((b_re * c) - (b_im * s));
+    }
+
+    if (cfft(plan, ims, res, work + n + m, work + n))
+    {
+        res = work + n;
+        ims = work + n + m;
+    }
+
+    // Interleave the real and imaginary parts into the even and odd items
+    k = 0;
+#if KQT_SSE
+    for (; k < m; k += 4)
+    {
+        const __m128 re = _mm_loadu_ps(res + k);
+        const __m128 im = _mm_loadu_ps(ims + k);
+        _mm_storeu_ps(data + k * 2, _mm_unpacklo_ps(re, im));
+        _mm_storeu_ps(data + k * 2 + 4, _mm_unpackhi_ps(re, im));
+    }
+#endif
+    for (; k < m; ++k)
+    {
+        data[k * 2] = res[k];
+        data[k * 2 + 1] = ims[k];
+    }
+
+    return;
 }
 
 
-static void rfft_init(int32_t n, float* wsave, int32_t* ifac)
+static void rfft_init(FFT_worker* worker, int32_t n)
 {
+    rassert(worker != NULL);
     rassert(n >= 1);
-    rassert(wsave != NULL);
-    rassert(ifac != NULL);
+
+    release_FFT_plan(worker->plan);
+    worker->plan = NULL;
+    worker->cur_length = n;
 
     if (n == 1)
         return;
 
-    drfti1(n, wsave + n, ifac);
+    if (are_plans_enabled && is_p2(n) && (n >= FFT_PLAN_MIN_LENGTH))
+    {
+        worker->plan = acquire_FFT_plan(n);
+        if (worker->plan != NULL)
+        {
+            drfti_factorise(n, worker->ifac);
+            return;
+        }
+    }
+
+    drfti1(n, worker->wsave + n, worker->ifac);
 
     return;
 }
 
 
+FFT_worker* FFT_worker_init(FFT_worker* worker, int32_t max_tlength)
+{
+    rassert(worker != NULL);
+    rassert(max_tlength > 0);
+
+    worker->wsave = memory_calloc_items(float, max_tlength * 2);
+    if (worker->wsave == NULL)
+        return NULL;
+
+    worker->max_length = max_tlength;
+    worker->cur_length = 0;
+    worker->plan = NULL;
+
+    for (int i = 0; i < 32; ++i)
+        worker->ifac[0] = 0;
+
+    // Hold on to the plan of the maximum length so that workers can share it
+    if (is_p2(max_tlength) && (max_tlength >= FFT_PLAN_MIN_LENGTH))
+        rfft_init(worker, max_tlength);
+
+    return worker;
+}
+
+
 void FFT_worker_rfft(FFT_worker* worker, float* data, int32_t length)
 {
     rassert(worker != NULL);
@@ -71,14 +783,17 @@ void FFT_worker_rfft(FFT_worker* worker, float* data, int32_t length)
     rassert(length <= worker->max_length);
 
     if (length != worker->cur_length)
-    {
-        rfft_init(length, worker->wsave, worker->ifac);
-        worker->cur_length = length;
-    }
+        rfft_init(worker, length);
 
     if (length == 1)
         return;
 
+    if (worker->plan != NULL)
+    {
+        rfft_plan(worker->plan, data, worker->wsave);
+        return;
+    }
+
     drftf1(length, data, worker->wsave, worker->wsave + length, worker->ifac);
 
     return;
@@ -93,14 +808,17 @@ void FFT_worker_irfft(FFT_worker* worker, float* data, int32_t length)
     rassert(length <= worker->max_length);
 
     if (length != worker->cur_length)
-    {
-        rfft_init(length, worker->wsave, worker->ifac);
-        worker->cur_length = length;
-    }
+        rfft_init(worker, length);
 
     if (length == 1)
         return;
 
+    if (worker->plan != NULL)
+    {
+        irfft_plan(worker->plan, data, worker->wsave);
+        return;
+    }
+
     drftb1(length, data, worker->wsave, worker->wsave + length, worker->ifac);
 
     return;
@@ -111,6 +829,9 @@ void FFT_worker_deinit(FFT_worker* worker)
 {
     rassert(worker != NULL);
 
+    release_FFT_plan(worker->plan);
+    worker->plan = NULL;
+
     memory_free(worker->wsave);
     worker->wsave = NULL;
 
@@ -118,7 +839,7 @@ void FFT_worker_deinit(FFT_worker* worker)
 }
 
 
-static void drfti1(int32_t n, float* wa, int32_t* ifac)
+static void drfti_factorise(int32_t n, int32_t* ifac)
 {
     const int ntryh[4] = { 4, 2, 3, 5 };
     int nf = 0;
@@ -157,8 +878,16 @@ static void drfti1(int32_t n, float* wa, int32_t* ifac)
     ifac[0] = n;
     ifac[1] = nf;
 
+    return;
+}
+
+
+static void drfti1(int32_t n, float* wa, int32_t* ifac)
+{
+    drfti_factorise(n, ifac);
+
     // Fill in complex roots of unity
-    const int nfm1 = nf - 1;
+    const int nfm1 = ifac[1] - 1;
 
     if (nfm1 == 0)
         return;
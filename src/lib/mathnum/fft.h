@@ -1,7 +1,7 @@
 
 
 /*
- * Author: Tomi Jylhä-Ollila, Finland 2016
+ * Author: Tomi Jylhä-Ollila, Finland 2016-2019
  *
  * This file is part of Kunquat.
  *
@@ -16,25 +16,51 @@
 #define KQT_FFT_H
 
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
 
 
+/**
+ * Precomputed twiddle factors for a power-of-two length, shared by all
+ * FFT workers that use the same length.
+ */
+typedef struct FFT_plan FFT_plan;
+
+
 typedef struct FFT_worker
 {
     int32_t max_length;
     int32_t cur_length;
     float* wsave;
     int32_t ifac[32];
+    FFT_plan* plan;
 } FFT_worker;
 
 
-#define FFT_WORKER_AUTO (&(FFT_worker){ .max_length = 0, .cur_length = 0 })
+#define FFT_WORKER_AUTO \
+    (&(FFT_worker){ .max_length = 0, .cur_length = 0, .plan = NULL })
+
+
+/**
+ * Enable or disable the vectorised transforms of power-of-two lengths.
+ *
+ * This is only intended for testing and benchmarking against FFTPACK. The
+ * setting applies to FFT workers initialised or resized after the call.
+ *
+ * \param enabled   \c true if vectorised transforms should be used, otherwise
+ *                  \c false.
+ */
+void FFT_set_plans_enabled(bool enabled);
 
 
 /**
  * Initialise the FFT worker.
  *
+ * Transforms of power-of-two lengths use vectorised code with twiddle factors
+ * that are cached and shared between workers. Other lengths are computed with
+ * FFTPACK.
+ *
  * \param worker        The FFT worker -- must not be \c NULL.
  * \param max_tlength   Maximum length of Fourier Transform performed
  *                      -- must be positive.
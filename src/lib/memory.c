@@ -1,7 +1,7 @@
 
 
 /*
- * Author: Tomi Jylhä-Ollila, Finland 2013-2018
+ * Author: Tomi Jylhä-Ollila, Finland 2013-2019
  *
  * This file is part of Kunquat.
  *
@@ -16,7 +16,13 @@
 
 #include <debug/assert.h>
 
+#ifdef ENABLE_THREADS
+#include <stdatomic.h>
+#endif
+
+#include <stdalign.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 
@@ -40,6 +46,147 @@ static int32_t out_of_memory_error_steps = -1;
 static int32_t total_alloc_count = 0;
 
 
+#ifdef ENABLE_THREADS
+static _Thread_local int render_path_depth = 0;
+static atomic_bool is_render_alloc_trap_enabled = false;
+static atomic_int_least32_t render_alloc_count = 0;
+#else
+static int render_path_depth = 0;
+static bool is_render_alloc_trap_enabled = false;
+static int32_t render_alloc_count = 0;
+#endif
+
+
+static void update_render_alloc_count(void)
+{
+    if ((render_path_depth > 0) && is_render_alloc_trap_enabled)
+        ++render_alloc_count;
+
+    return;
+}
+
+
+#ifdef ENABLE_THREADS
+typedef atomic_int_least64_t Usage_counter;
+typedef atomic_int_least32_t Usage_ref_count;
+static _Thread_local Memory_usage* current_usage = NULL;
+static _Thread_local Memory_category current_category = MEMORY_CATEGORY_OTHER;
+#else
+typedef int64_t Usage_counter;
+typedef int32_t Usage_ref_count;
+static Memory_usage* current_usage = NULL;
+static Memory_category current_category = MEMORY_CATEGORY_OTHER;
+#endif
+
+
+typedef struct Memory_account
+{
+    Memory_usage* usage;
+    Memory_category category;
+} Memory_account;
+
+
+struct Memory_usage
+{
+    Memory_usage* parent;
+    Usage_ref_count ref_count;
+    Usage_counter sizes[MEMORY_CATEGORY_COUNT];
+    Memory_account accounts[MEMORY_CATEGORY_COUNT];
+};
+
+
+#define SHARED_ACCOUNT(category) [category] = { &shared_usage, category }
+
+/*
+ * The Memory usage of data shared between Handles. It is never destroyed
+ * as its reference count stays above zero.
+ */
+static Memory_usage shared_usage =
+{
+    .parent = NULL,
+    .ref_count = 1,
+    .accounts =
+    {
+        SHARED_ACCOUNT(MEMORY_CATEGORY_OTHER),
+        SHARED_ACCOUNT(MEMORY_CATEGORY_SAMPLES),
+        SHARED_ACCOUNT(MEMORY_CATEGORY_PADSYNTH),
+        SHARED_ACCOUNT(MEMORY_CATEGORY_VOICES),
+        SHARED_ACCOUNT(MEMORY_CATEGORY_WORK_BUFFERS),
+        SHARED_ACCOUNT(MEMORY_CATEGORY_DEVICE_STATES),
+        SHARED_ACCOUNT(MEMORY_CATEGORY_PATTERNS),
+    },
+};
+
+#undef SHARED_ACCOUNT
+
+
+/*
+ * Every block starts with a header that tells where the block is charged.
+ * The header size is rounded up so that the user block keeps the alignment
+ * guaranteed by malloc.
+ */
+typedef struct Block_header
+{
+    Memory_account* account;
+    int64_t size;
+} Block_header;
+
+
+#define BLOCK_HEADER_SIZE ((int64_t)                      \
+        ((sizeof(Block_header) + alignof(max_align_t) - 1) / \
+            alignof(max_align_t) * alignof(max_align_t)))
+
+
+static void Memory_usage_add(Memory_usage* usage, Memory_category category, int64_t size)
+{
+    for (; usage != NULL; usage = usage->parent)
+        usage->sizes[category] += size;
+
+    return;
+}
+
+
+static Memory_account* acquire_current_account(void)
+{
+    if (current_usage == NULL)
+        return NULL;
+
+    Memory_usage_retain(current_usage);
+    return &current_usage->accounts[current_category];
+}
+
+
+static void* alloc_block(int64_t size, bool clear, bool charge)
+{
+    rassert(size > 0);
+    rassert(size <= INT64_MAX - BLOCK_HEADER_SIZE);
+
+    update_out_of_memory_error();
+
+    const size_t total_size = (size_t)(size + BLOCK_HEADER_SIZE);
+    Block_header* header = clear ? calloc(1, total_size) : malloc(total_size);
+    if (header == NULL)
+        return NULL;
+
+    ++total_alloc_count;
+    update_render_alloc_count();
+
+    header->account = charge ? acquire_current_account() : NULL;
+    header->size = size;
+    if (header->account != NULL)
+        Memory_usage_add(header->account->usage, header->account->category, size);
+
+    return (char*)header + BLOCK_HEADER_SIZE;
+}
+
+
+static Block_header* get_header(void* ptr)
+{
+    rassert(ptr != NULL);
+    return (Block_header*)((char*)ptr - BLOCK_HEADER_SIZE);
+}
+
+
 #define ALIGNED_HEADER_SIZE 1
 
 
@@ -50,13 +197,7 @@ void* memory_alloc(int64_t size)
     if (size == 0)
         return NULL;
 
-    update_out_of_memory_error();
-
-    void* block = malloc((size_t)size);
-    if (block != NULL)
-        ++total_alloc_count;
-
-    return block;
+    return alloc_block(size, false, true);
 }
 
 
@@ -68,13 +209,9 @@ void* memory_calloc(int64_t item_count, int64_t item_size)
     if (item_count == 0 || item_size == 0)
         return NULL;
 
-    update_out_of_memory_error();
-
-    void* block = calloc((size_t)item_count, (size_t)item_size);
-    if (block != NULL)
-        ++total_alloc_count;
+    rassert(item_count <= (INT64_MAX - BLOCK_HEADER_SIZE) / item_size);
 
-    return block;
+    return alloc_block(item_count * item_size, true, true);
 }
 
 
@@ -87,13 +224,26 @@ void* memory_realloc(void* ptr, int64_t size)
     else if (size == 0)
         return NULL;
 
+    rassert(size <= INT64_MAX - BLOCK_HEADER_SIZE);
+
     update_out_of_memory_error();
 
-    void* block = realloc(ptr, (size_t)size);
-    if (block != NULL)
-        ++total_alloc_count;
+    Block_header* header = get_header(ptr);
+    const int64_t old_size = header->size;
+
+    header = realloc(header, (size_t)(size + BLOCK_HEADER_SIZE));
+    if (header == NULL)
+        return NULL;
+
+    ++total_alloc_count;
+    update_render_alloc_count();
+
+    header->size = size;
+    if (header->account != NULL)
+        Memory_usage_add(
+                header->account->usage, header->account->category, size - old_size);
 
-    return block;
+    return (char*)header + BLOCK_HEADER_SIZE;
 }
 
 
@@ -106,16 +256,12 @@ void* memory_alloc_aligned(int64_t size, uint8_t alignment)
     if (size == 0)
         return NULL;
 
-    update_out_of_memory_error();
-
     const int64_t min_size = size + alignment + ALIGNED_HEADER_SIZE;
 
-    char* block = malloc((size_t)min_size);
+    char* block = alloc_block(min_size, false, true);
     if (block == NULL)
         return NULL;
 
-    ++total_alloc_count;
-
     const intptr_t header_addr = (intptr_t)block;
 
     const intptr_t min_user_addr = header_addr + ALIGNED_HEADER_SIZE + 1;
@@ -141,7 +287,53 @@ void* memory_alloc_aligned(int64_t size, uint8_t alignment)
 
 void memory_free(void* ptr)
 {
-    free(ptr);
+    if (ptr == NULL)
+        return;
+
+    Block_header* header = get_header(ptr);
+    Memory_account* account = header->account;
+    if (account != NULL)
+    {
+        Memory_usage_add(account->usage, account->category, -header->size);
+        del_Memory_usage(account->usage);
+    }
+
+    free(header);
+
+    return;
+}
+
+
+void memory_transfer(void* ptr, Memory_usage* usage)
+{
+    if (ptr == NULL)
+        return;
+
+    Block_header* header = get_header(ptr);
+    Memory_account* old_account = header->account;
+    if ((old_account != NULL) && (old_account->usage == usage))
+        return;
+
+    const Memory_category category =
+        (old_account != NULL) ? old_account->category : current_category;
+
+    if (usage != NULL)
+    {
+        Memory_usage_retain(usage);
+        Memory_usage_add(usage, category, header->size);
+        header->account = &usage->accounts[category];
+    }
+    else
+    {
+        header->account = NULL;
+    }
+
+    if (old_account != NULL)
+    {
+        Memory_usage_add(old_account->usage, category, -header->size);
+        del_Memory_usage(old_account->usage);
+    }
+
     return;
 }
 
@@ -162,6 +354,116 @@ void memory_free_aligned(void* ptr)
 }
 
 
+Memory_usage* new_Memory_usage(Memory_usage* parent)
+{
+    // Memory usages are not charged to anything themselves
+    Memory_usage* usage = alloc_block((int64_t)sizeof(Memory_usage), false, false);
+    if (usage == NULL)
+        return NULL;
+
+    usage->parent = parent;
+    usage->ref_count = 1;
+    for (int i = 0; i < MEMORY_CATEGORY_COUNT; ++i)
+    {
+        usage->sizes[i] = 0;
+        usage->accounts[i].usage = usage;
+        usage->accounts[i].category = (Memory_category)i;
+    }
+
+    if (parent != NULL)
+        Memory_usage_retain(parent);
+
+    return usage;
+}
+
+
+void Memory_usage_retain(Memory_usage* usage)
+{
+    rassert(usage != NULL);
+    rassert(usage->ref_count > 0);
+
+    ++usage->ref_count;
+
+    return;
+}
+
+
+int64_t Memory_usage_get_size(const Memory_usage* usage, Memory_category category)
+{
+    rassert(usage != NULL);
+    rassert(category >= 0);
+    rassert(category < MEMORY_CATEGORY_COUNT);
+
+    return (int64_t)usage->sizes[category];
+}
+
+
+int64_t Memory_usage_get_total_size(const Memory_usage* usage)
+{
+    rassert(usage != NULL);
+
+    int64_t total = 0;
+    for (int i = 0; i < MEMORY_CATEGORY_COUNT; ++i)
+        total += (int64_t)usage->sizes[i];
+
+    return total;
+}
+
+
+void del_Memory_usage(Memory_usage* usage)
+{
+    while (usage != NULL)
+    {
+        rassert(usage->ref_count > 0);
+        if (--usage->ref_count > 0)
+            return;
+
+        Memory_usage* parent = usage->parent;
+        memory_free(usage);
+        usage = parent;
+    }
+
+    return;
+}
+
+
+Memory_usage* memory_get_shared_usage(void)
+{
+    return &shared_usage;
+}
+
+
+Memory_usage* memory_set_usage(Memory_usage* usage)
+{
+    Memory_usage* prev_usage = current_usage;
+    current_usage = usage;
+    return prev_usage;
+}
+
+
+Memory_usage* memory_get_usage(void)
+{
+    return current_usage;
+}
+
+
+Memory_category memory_set_category(Memory_category category)
+{
+    rassert(category >= 0);
+    rassert(category < MEMORY_CATEGORY_COUNT);
+
+    const Memory_category prev_category = current_category;
+    current_category = category;
+    return prev_category;
+}
+
+
+Memory_category memory_get_category(void)
+{
+    return current_category;
+}
+
+
 void memory_fake_out_of_memory(int32_t steps)
 {
     out_of_memory_error_steps = steps;
@@ -175,3 +477,33 @@ int32_t memory_get_alloc_count(void)
 }
 
 
+void memory_enter_render_path(void)
+{
+    ++render_path_depth;
+    return;
+}
+
+
+void memory_leave_render_path(void)
+{
+    rassert(render_path_depth > 0);
+    --render_path_depth;
+    return;
+}
+
+
+void memory_set_render_alloc_trap(bool enabled)
+{
+    if (enabled)
+        render_alloc_count = 0;
+    is_render_alloc_trap_enabled = enabled;
+    return;
+}
+
+
+int32_t memory_get_render_alloc_count(void)
+{
+    return (int32_t)render_alloc_count;
+}
+
+
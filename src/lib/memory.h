@@ -1,7 +1,7 @@
 
 
 /*
- * Author: Tomi Jylhä-Ollila, Finland 2013-2018
+ * Author: Tomi Jylhä-Ollila, Finland 2013-2019
  *
  * This file is part of Kunquat.
  *
@@ -16,6 +16,7 @@
 #define KQT_MEMORY_H
 
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
 
@@ -126,6 +127,179 @@ void memory_fake_out_of_memory(int32_t steps);
 int32_t memory_get_alloc_count(void);
 
 
+/**
+ * Mark the start of a render path in the calling thread.
+ *
+ * Code in a render path is run in real time and must not allocate memory.
+ * Render paths may be nested, each call of this function must be matched by
+ * a call of \a memory_leave_render_path.
+ */
+void memory_enter_render_path(void);
+
+
+/**
+ * Mark the end of a render path in the calling thread.
+ */
+void memory_leave_render_path(void);
+
+
+/**
+ * Set trapping of memory allocations made in a render path.
+ *
+ * Trapped allocations are performed normally but they are counted
+ * separately. Enabling the trap resets the count.
+ *
+ * \param enabled   \c true if allocations should be trapped, otherwise \c false.
+ */
+void memory_set_render_alloc_trap(bool enabled);
+
+
+/**
+ * Get the number of memory allocations trapped in render paths.
+ *
+ * \return   The number of trapped allocations.
+ */
+int32_t memory_get_render_alloc_count(void);
+
+
+/**
+ * Memory categories used for reporting memory usage.
+ */
+typedef enum
+{
+    MEMORY_CATEGORY_OTHER = 0,
+    MEMORY_CATEGORY_SAMPLES,
+    MEMORY_CATEGORY_PADSYNTH,
+    MEMORY_CATEGORY_VOICES,
+    MEMORY_CATEGORY_WORK_BUFFERS,
+    MEMORY_CATEGORY_DEVICE_STATES,
+    MEMORY_CATEGORY_PATTERNS,
+    MEMORY_CATEGORY_COUNT
+} Memory_category;
+
+
+/**
+ * A node in a tree of memory usage counters.
+ *
+ * Each memory block is charged to the Memory usage and category that are
+ * current in the allocating thread, and the size of the block is added to the
+ * counters of the Memory usage and all of its ancestors. Freeing the block
+ * subtracts the size from the same counters regardless of the thread. A Memory
+ * usage stays alive until it is deleted and no blocks are charged to it or
+ * its descendants.
+ */
+typedef struct Memory_usage Memory_usage;
+
+
+/**
+ * Create a new Memory usage.
+ *
+ * \param parent   The parent Memory usage, or \c NULL.
+ *
+ * \return   The new Memory usage, or \c NULL if memory allocation failed.
+ */
+Memory_usage* new_Memory_usage(Memory_usage* parent);
+
+
+/**
+ * Keep a Memory usage alive until a matching call of \a del_Memory_usage.
+ *
+ * \param usage   The Memory usage -- must not be \c NULL.
+ */
+void Memory_usage_retain(Memory_usage* usage);
+
+
+/**
+ * Get the number of bytes charged to a Memory usage and its descendants.
+ *
+ * \param usage      The Memory usage -- must not be \c NULL.
+ * \param category   The memory category -- must be valid.
+ *
+ * \return   The number of bytes.
+ */
+int64_t Memory_usage_get_size(const Memory_usage* usage, Memory_category category);
+
+
+/**
+ * Get the total number of bytes charged to a Memory usage and its descendants.
+ *
+ * \param usage   The Memory usage -- must not be \c NULL.
+ *
+ * \return   The number of bytes.
+ */
+int64_t Memory_usage_get_total_size(const Memory_usage* usage);
+
+
+/**
+ * Release a Memory usage.
+ *
+ * \param usage   The Memory usage, or \c NULL.
+ */
+void del_Memory_usage(Memory_usage* usage);
+
+
+/**
+ * Get the process-level Memory usage of data shared between Handles.
+ *
+ * The shared Memory usage has no parent and it is never destroyed, so it
+ * does not need to be retained.
+ *
+ * \return   The shared Memory usage.
+ */
+Memory_usage* memory_get_shared_usage(void);
+
+
+/**
+ * Charge an existing memory block to another Memory usage.
+ *
+ * The block keeps its memory category. A block that was not charged to
+ * anything gets the current category of the calling thread. This function
+ * must not be used with blocks returned by \a memory_alloc_aligned.
+ *
+ * \param ptr     The memory block, or \c NULL.
+ * \param usage   The new Memory usage, or \c NULL if the block should not
+ *                be charged.
+ */
+void memory_transfer(void* ptr, Memory_usage* usage);
+
+
+/**
+ * Set the Memory usage charged for allocations in the calling thread.
+ *
+ * \param usage   The Memory usage, or \c NULL if allocations should not
+ *                be charged.
+ *
+ * \return   The previous Memory usage.
+ */
+Memory_usage* memory_set_usage(Memory_usage* usage);
+
+
+/**
+ * Get the Memory usage charged for allocations in the calling thread.
+ *
+ * \return   The Memory usage, or \c NULL if allocations are not charged.
+ */
+Memory_usage* memory_get_usage(void);
+
+
+/**
+ * Set the memory category of allocations in the calling thread.
+ *
+ * \param category   The memory category -- must be valid.
+ *
+ * \return   The previous memory category.
+ */
+Memory_category memory_set_category(Memory_category category);
+
+
+/**
+ * Get the memory category of allocations in the calling thread.
+ *
+ * \return   The memory category.
+ */
+Memory_category memory_get_category(void);
+
+
 #endif // KQT_MEMORY_H
 
 
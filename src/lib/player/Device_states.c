@@ -1,7 +1,7 @@
 
 
 /*
- * Author: Tomi Jylhä-Ollila, Finland 2013-2018
+ * Author: Tomi Jylhä-Ollila, Finland 2013-2019
  *
  * This file is part of Kunquat.
  *
@@ -96,6 +96,7 @@ static Entry* new_Entry(Device_state* state, int thread_count)
 struct Device_states
 {
     int thread_count;
+    bool is_sharing_outdated;
     Entry* entries[ENTRY_TABLE_SIZE];
 };
 
@@ -107,6 +108,7 @@ Device_states* new_Device_states(void)
         return NULL;
 
     states->thread_count = 0;
+    states->is_sharing_outdated = false;
     for (int i = 0; i < ENTRY_TABLE_SIZE; ++i)
         states->entries[i] = NULL;
 
@@ -134,8 +136,11 @@ bool Device_states_set_thread_count(Device_states* states, int new_count)
             {
                 if (entry->thread_states[ti] == NULL)
                 {
+                    const Memory_category prev_category =
+                        memory_set_category(MEMORY_CATEGORY_DEVICE_STATES);
                     Device_thread_state* ts =
                         new_Device_thread_state(device, audio_buffer_size);
+                    memory_set_category(prev_category);
                     if (ts == NULL)
                         return false;
 
@@ -167,7 +172,10 @@ bool Device_states_add_state(Device_states* states, Device_state* state)
 
     const uint32_t h = id_hash(state->device_id);
 
+    const Memory_category prev_category =
+        memory_set_category(MEMORY_CATEGORY_DEVICE_STATES);
     Entry* entry = new_Entry(state, states->thread_count);
+    memory_set_category(prev_category);
     if (entry == NULL)
         return false;
 
@@ -228,6 +236,9 @@ void Device_states_remove_state(Device_states* states, uint32_t id)
         {
             *ref = cur->next;
             del_Entry(cur);
+
+            // Other Work buffers may still borrow the contents of the removed ones
+            states->is_sharing_outdated = true;
             break;
         }
 
@@ -338,6 +349,39 @@ bool Device_states_set_audio_buffer_size(Device_states* states, int32_t size)
 }
 
 
+bool Device_states_restore_buffers(Device_states* states)
+{
+    rassert(states != NULL);
+
+    for (int ei = 0; ei < ENTRY_TABLE_SIZE; ++ei)
+    {
+        Entry* entry = states->entries[ei];
+        while (entry != NULL)
+        {
+            for (int ti = 0; ti < KQT_THREADS_MAX; ++ti)
+            {
+                Device_thread_state* ts = entry->thread_states[ti];
+                if ((ts != NULL) && !Device_thread_state_restore_buffers(ts))
+                    return false;
+            }
+
+            entry = entry->next;
+        }
+    }
+
+    states->is_sharing_outdated = false;
+
+    return true;
+}
+
+
+bool Device_states_is_sharing_outdated(const Device_states* states)
+{
+    rassert(states != NULL);
+    return states->is_sharing_outdated;
+}
+
+
 void Device_states_invalidate_mixed_buffers(Device_states* states)
 {
     rassert(states != NULL);
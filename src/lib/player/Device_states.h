@@ -1,7 +1,7 @@
 
 
 /*
- * Author: Tomi Jylhä-Ollila, Finland 2013-2017
+ * Author: Tomi Jylhä-Ollila, Finland 2013-2019
  *
  * This file is part of Kunquat.
  *
@@ -72,6 +72,11 @@ Device_state* Device_states_get_state(const Device_states* states, uint32_t id);
 /**
  * Remove a Device state in the Device state collection.
  *
+ * Work buffers of other Device states may borrow the contents of the Work
+ * buffers of the removed Device state. Therefore, the caller must make sure
+ * that \a Device_states_restore_buffers is called before the next rendering,
+ * which is done by updating the connections of the Player.
+ *
  * \param states   The Device states -- must not be \c NULL.
  * \param id       The Device ID -- must be > \c 0.
  */
@@ -115,6 +120,30 @@ bool Device_states_set_audio_rate(Device_states* states, int32_t rate);
 bool Device_states_set_audio_buffer_size(Device_states* states, int32_t size);
 
 
+/**
+ * Give back own contents to all Work buffers that borrow contents from others.
+ *
+ * Signal plans bind the Work buffers again after this call.
+ *
+ * \param states   The Device states -- must not be \c NULL.
+ *
+ * \return   \c true if successful, or \c false if memory allocation failed.
+ */
+bool Device_states_restore_buffers(Device_states* states);
+
+
+/**
+ * Find out if a Device state has been removed after the Work buffers have
+ * last been restored.
+ *
+ * \param states   The Device states -- must not be \c NULL.
+ *
+ * \return   \c true if the Work buffers may borrow contents that no longer
+ *           exist, otherwise \c false.
+ */
+bool Device_states_is_sharing_outdated(const Device_states* states);
+
+
 /**
  * Invalidate mixed audio buffers in the Device states.
  *
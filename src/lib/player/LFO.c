@@ -15,6 +15,7 @@
 #include <player/LFO.h>
 
 #include <debug/assert.h>
+#include <intrinsics.h>
 #include <mathnum/common.h>
 #include <mathnum/fast_sin.h>
 #include <player/Player.h>
@@ -27,6 +28,9 @@
 #include <string.h>
 
 
+#define LFO_CHUNK_SIZE 64
+
+
 static void LFO_update_time(LFO* lfo, int32_t audio_rate, double tempo);
 
 
@@ -287,20 +291,11 @@ static void LFO_start_with_init_values(LFO* lfo)
 }
 
 
-double LFO_step(LFO* lfo)
+static double LFO_advance(LFO* lfo, double* depth)
 {
     rassert(lfo != NULL);
-    rassert(lfo->audio_rate > 0);
-    rassert(isfinite(lfo->tempo));
-    rassert(lfo->tempo > 0);
-
-    if (!LFO_active(lfo))
-    {
-        if (LFO_is_standing_by(lfo))
-            LFO_start_with_init_values(lfo);
-        else
-            return 0;
-    }
+    rassert(depth != NULL);
+    rassert(LFO_active(lfo));
 
     double cur_speed = lfo->target_speed;
 
@@ -345,12 +340,173 @@ double LFO_step(LFO* lfo)
         lfo->phase = new_phase;
     }
 
-    const double value = fast_sin(lfo->phase) * cur_depth;
+    *depth = cur_depth;
+
+    return lfo->phase;
+}
+
+
+double LFO_step(LFO* lfo)
+{
+    rassert(lfo != NULL);
+    rassert(lfo->audio_rate > 0);
+    rassert(isfinite(lfo->tempo));
+    rassert(lfo->tempo > 0);
+
+    if (!LFO_active(lfo))
+    {
+        if (LFO_is_standing_by(lfo))
+            LFO_start_with_init_values(lfo);
+        else
+            return 0;
+    }
+
+    double cur_depth = 0;
+    const double phase = LFO_advance(lfo, &cur_depth);
+
+    const double value = fast_sin(phase) * cur_depth;
 
     return value;
 }
 
 
+// Same approximation as in fast_sin, but in single precision
+static float fast_sin_f(float x)
+{
+    const float a = (float)(-4.0 / PI);
+    const float b = (float)(4.0 / (PI * PI));
+    const float x_m_pi = x - (float)PI;
+
+    const float approx1 = (a * x_m_pi) + (b * x_m_pi * fabsf(x_m_pi));
+
+    return (0.775f * approx1) + (0.225f * approx1 * fabsf(approx1));
+}
+
+
+static void add_sines(
+        float* values, const float* phases, const float* depths, int32_t count)
+{
+    rassert(values != NULL);
+    rassert(phases != NULL);
+    rassert(depths != NULL);
+    rassert(count >= 0);
+
+    int32_t i = 0;
+
+#if KQT_SSE
+    const __m128 a = _mm_set1_ps((float)(-4.0 / PI));
+    const __m128 b = _mm_set1_ps((float)(4.0 / (PI * PI)));
+    const __m128 pi = _mm_set1_ps((float)PI);
+    const __m128 q = _mm_set1_ps(0.775f);
+    const __m128 p = _mm_set1_ps(0.225f);
+    const __m128 sign_mask = _mm_set1_ps(-0.0f);
+
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128 x_m_pi = _mm_sub_ps(_mm_loadu_ps(phases + i), pi);
+        const __m128 abs_x_m_pi = _mm_andnot_ps(sign_mask, x_m_pi);
+        const __m128 approx1 = _mm_add_ps(
+                _mm_mul_ps(a, x_m_pi), _mm_mul_ps(b, _mm_mul_ps(x_m_pi, abs_x_m_pi)));
+        const __m128 abs_approx1 = _mm_andnot_ps(sign_mask, approx1);
+        const __m128 approx2 = _mm_add_ps(
+                _mm_mul_ps(q, approx1), _mm_mul_ps(p, _mm_mul_ps(approx1, abs_approx1)));
+
+        _mm_storeu_ps(
+                values + i,
+                _mm_add_ps(
+                    _mm_loadu_ps(values + i),
+                    _mm_mul_ps(approx2, _mm_loadu_ps(depths + i))));
+    }
+#endif
+
+    for (; i < count; ++i)
+        values[i] += fast_sin_f(phases[i]) * depths[i];
+
+    return;
+}
+
+
+void LFO_fill(LFO* lfo, Work_buffer* wb, int32_t buf_start, int32_t buf_stop)
+{
+    rassert(lfo != NULL);
+    rassert(lfo->audio_rate > 0);
+    rassert(isfinite(lfo->tempo));
+    rassert(lfo->tempo > 0);
+    rassert(wb != NULL);
+    rassert(buf_start >= 0);
+    rassert(buf_start < buf_stop);
+
+    const int32_t orig_const_start = Work_buffer_get_const_start(wb);
+    float* values = Work_buffer_get_contents_mut(wb);
+
+    float phases[LFO_CHUNK_SIZE] = { 0 };
+    float depths[LFO_CHUNK_SIZE] = { 0 };
+
+    int32_t cur_pos = buf_start;
+    while (cur_pos < buf_stop)
+    {
+        if (!LFO_active(lfo))
+        {
+            if (LFO_is_standing_by(lfo))
+                LFO_start_with_init_values(lfo);
+            else
+                break;
+        }
+
+        const int32_t chunk_size = min(LFO_CHUNK_SIZE, buf_stop - cur_pos);
+        int32_t count = 0;
+
+        if (lfo->on &&
+                !Slider_in_progress(&lfo->speed_slider) &&
+                !Slider_in_progress(&lfo->depth_slider) &&
+                (lfo->target_depth != 0))
+        {
+            // Speed and depth are fixed and the oscillation cannot end,
+            // so the phase is evaluated directly from the step index
+            const double update = lfo->update;
+            const float depth = (float)lfo->target_depth;
+            double base_phase = lfo->phase;
+            double phase = base_phase;
+            for (int32_t i = 0; i < chunk_size; ++i)
+            {
+                phase = base_phase + update * (double)(i + 1);
+                if (phase >= (2 * PI))
+                {
+                    const double wrapped_phase = fmod(phase, 2 * PI);
+                    base_phase -= phase - wrapped_phase;
+                    phase = wrapped_phase;
+                }
+
+                phases[i] = (float)phase;
+                depths[i] = depth;
+            }
+
+            lfo->phase = phase;
+            count = chunk_size;
+        }
+        else
+        {
+            while ((count < chunk_size) && LFO_active(lfo))
+            {
+                double depth = 0;
+                phases[count] = (float)LFO_advance(lfo, &depth);
+                depths[count] = (float)depth;
+                ++count;
+            }
+        }
+
+        rassert(count > 0);
+        add_sines(values + cur_pos, phases, depths, count);
+
+        cur_pos += count;
+    }
+
+    Work_buffer_set_const_start(wb, max(orig_const_start, cur_pos));
+
+    return;
+}
+
+
 double LFO_skip(LFO* lfo, int64_t steps)
 {
     rassert(lfo != NULL);
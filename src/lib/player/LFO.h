@@ -18,6 +18,7 @@
 
 #include <mathnum/Tstamp.h>
 #include <player/Slider.h>
+#include <player/Work_buffer.h>
 
 #include <stdbool.h>
 #include <stdint.h>
@@ -197,6 +198,24 @@ void LFO_turn_off(LFO* lfo);
 double LFO_step(LFO* lfo);
 
 
+/**
+ * Add consecutive steps of the LFO to a Work buffer area.
+ *
+ * Each frame receives the value that \a LFO_step would return for it added to
+ * the existing contents. While the speed and depth are fixed, the phase is
+ * evaluated from the step index instead of being accumulated, so the values
+ * may differ from \a LFO_step by rounding errors. If the LFO becomes inactive
+ * within the area, the constant start marker of \a wb is moved to the end of
+ * the oscillation unless it is already later.
+ *
+ * \param lfo         The LFO -- must not be \c NULL.
+ * \param wb          The Work buffer -- must not be \c NULL.
+ * \param buf_start   The start index of the area -- must be >= \c 0.
+ * \param buf_stop    The stop index of the area -- must be > \a buf_start.
+ */
+void LFO_fill(LFO* lfo, Work_buffer* wb, int32_t buf_start, int32_t buf_stop);
+
+
 /**
  * Skip a number of steps in the LFO.
  *
@@ -252,71 +252,11 @@ void Linear_controls_fill_work_buffer(
 
     float* values = Work_buffer_get_contents_mut(wb);
 
-    int32_t const_start = buf_start;
-
     // Apply slider
-    {
-        int32_t cur_pos = buf_start;
-        while (cur_pos < buf_stop)
-        {
-            const int32_t estimated_steps =
-                Slider_estimate_active_steps_left(&lc->slider);
-            if (estimated_steps > 0)
-            {
-                int32_t slide_stop = buf_stop;
-                if (estimated_steps < buf_stop - cur_pos)
-                    slide_stop = cur_pos + estimated_steps;
-
-                double new_value = lc->value;
-                for (int32_t i = cur_pos; i < slide_stop; ++i)
-                {
-                    new_value = Slider_step(&lc->slider);
-                    values[i] = (float)new_value;
-                }
-                lc->value = new_value;
-
-                const_start = slide_stop;
-                cur_pos = slide_stop;
-            }
-            else
-            {
-                const float value = (float)lc->value;
-                for (int32_t i = cur_pos; i < buf_stop; ++i)
-                    values[i] = value;
-
-                cur_pos = buf_stop;
-            }
-        }
-    }
+    lc->value = Slider_fill(&lc->slider, wb, buf_start, buf_stop, lc->value);
 
     // Apply LFO
-    {
-        int32_t cur_pos = buf_start;
-        int32_t final_lfo_stop = buf_start;
-        while (cur_pos < buf_stop)
-        {
-            const int32_t estimated_steps = LFO_estimate_active_steps_left(&lc->lfo);
-            if (estimated_steps > 0)
-            {
-                int32_t lfo_stop = buf_stop;
-                if (estimated_steps < buf_stop - cur_pos)
-                    lfo_stop = cur_pos + estimated_steps;
-
-                for (int32_t i = cur_pos; i < lfo_stop; ++i)
-                    values[i] += (float)LFO_step(&lc->lfo);
-
-                final_lfo_stop = lfo_stop;
-                cur_pos = lfo_stop;
-            }
-            else
-            {
-                final_lfo_stop = cur_pos;
-                break;
-            }
-        }
-
-        const_start = max(const_start, final_lfo_stop);
-    }
+    LFO_fill(&lc->lfo, wb, buf_start, buf_stop);
 
     // Clamp values
     if (lc->min_value > -INFINITY)
@@ -333,9 +273,6 @@ void Linear_controls_fill_work_buffer(
             values[i] = min(max_value, values[i]);
     }
 
-    // Mark constant region of the buffer
-    Work_buffer_set_const_start(wb, const_start);
-
     return;
 }
 
@@ -28,6 +28,7 @@
 #include <player/devices/Device_thread_state.h>
 #include <player/Mixed_signal_plan.h>
 #include <player/Work_buffer.h>
+#include <player/Work_buffer_sharing.h>
 
 #include <limits.h>
 #include <stdbool.h>
@@ -42,6 +43,7 @@ typedef uint32_t Task_id;
 struct Mixed_signal_plan
 {
     Array* tasks;
+    Array* bindings;
     Device_states* dstates;
 };
 
@@ -49,7 +51,7 @@ struct Mixed_signal_plan
 typedef struct Buffer_connection
 {
     Work_buffer* receiver;
-    const Work_buffer* sender;
+    Work_buffer* sender;
 } Buffer_connection;
 
 
@@ -174,7 +176,7 @@ static bool Mixed_signal_task_info_is_empty(const Mixed_signal_task_info* task_i
 static bool Mixed_signal_task_info_add_input(
         Mixed_signal_task_info* task_info,
         Work_buffer* recv_buf,
-        const Work_buffer* send_buf)
+        Work_buffer* send_buf)
 {
     rassert(task_info != NULL);
     rassert(task_info->conns != NULL);
@@ -188,7 +190,7 @@ static bool Mixed_signal_task_info_add_input(
 static bool Mixed_signal_task_info_add_bypass_input(
         Mixed_signal_task_info* task_info,
         Work_buffer* recv_buf,
-        const Work_buffer* send_buf)
+        Work_buffer* send_buf)
 {
     rassert(task_info != NULL);
     rassert(recv_buf != NULL);
@@ -311,7 +313,7 @@ static bool Mixed_signal_task_info_add_au_interface(
         {
             Device_thread_state_mark_input_port_connected(source_ts, port);
 
-            const Work_buffer* in_buf = Device_thread_state_get_mixed_buffer(
+            Work_buffer* in_buf = Device_thread_state_get_mixed_buffer(
                     source_ts, DEVICE_PORT_TYPE_RECV, port);
 
             if (in_buf != NULL)
@@ -469,7 +471,7 @@ static bool Mixed_signal_plan_build_from_node(
 
                     if (out_buf != NULL)
                     {
-                        const Work_buffer* in_buf = Device_thread_state_get_mixed_buffer(
+                        Work_buffer* in_buf = Device_thread_state_get_mixed_buffer(
                                 in_iface_ts, DEVICE_PORT_TYPE_SEND, port);
 
                         if (in_buf != NULL)
@@ -522,7 +524,7 @@ static bool Mixed_signal_plan_build_from_node(
             Device_thread_state* send_ts =
                 Device_states_get_thread_state(dstates, 0, Device_get_id(send_device));
 
-            const Work_buffer* send_buf = Device_thread_state_get_mixed_buffer(
+            Work_buffer* send_buf = Device_thread_state_get_mixed_buffer(
                     send_ts, DEVICE_PORT_TYPE_SEND, edge->port);
             Work_buffer* recv_buf = Device_thread_state_get_mixed_buffer(
                     recv_ts, recv_port_type, port);
@@ -662,6 +664,100 @@ static bool Mixed_signal_plan_finalise(Mixed_signal_plan* plan)
 }
 
 
+static bool add_conn_uses(Work_buffer_sharing* sharing, const Array* conns, int32_t step)
+{
+    rassert(sharing != NULL);
+    rassert(step >= 0);
+
+    if (conns == NULL)
+        return true;
+
+    const int64_t conn_count = Array_get_size(conns);
+    for (int64_t i = 0; i < conn_count; ++i)
+    {
+        const Buffer_connection* conn = Array_get_ref(conns, i);
+        if (!Work_buffer_sharing_add_use(sharing, conn->receiver, step, step))
+            return false;
+
+        // Senders without a task are written during voice processing
+        if (!Work_buffer_sharing_extend_use(sharing, conn->sender, step) &&
+                !Work_buffer_sharing_add_use(
+                    sharing, conn->sender, WORK_BUFFER_STEP_BEFORE, step))
+            return false;
+    }
+
+    return true;
+}
+
+
+static bool Mixed_signal_plan_share_buffers(
+        Mixed_signal_plan* plan, Device_states* dstates, const Connections* conns)
+{
+    rassert(plan != NULL);
+    rassert(dstates != NULL);
+    rassert(conns != NULL);
+
+    Work_buffer_sharing* sharing = new_Work_buffer_sharing();
+    if (sharing == NULL)
+        return false;
+
+    // The Player reads the master signal after the plan execution
+    {
+        const Device* master = Device_node_get_device(Connections_get_master(conns));
+        rassert(master != NULL);
+        Device_thread_state* master_ts =
+            Device_states_get_thread_state(dstates, 0, Device_get_id(master));
+
+        for (int port = 0; port < KQT_DEVICE_PORTS_MAX; ++port)
+        {
+            Work_buffer* buffer = Device_thread_state_get_mixed_buffer(
+                    master_ts, DEVICE_PORT_TYPE_RECV, port);
+            if ((buffer != NULL) && !Work_buffer_sharing_add_use(
+                        sharing,
+                        buffer,
+                        WORK_BUFFER_STEP_BEFORE,
+                        WORK_BUFFER_STEP_AFTER))
+            {
+                del_Work_buffer_sharing(sharing);
+                return false;
+            }
+        }
+    }
+
+    // Tasks are executed in the order of the task list
+    const int64_t task_count = Array_get_size(plan->tasks);
+    rassert(task_count < INT32_MAX);
+    for (int32_t step = 0; step < (int32_t)task_count; ++step)
+    {
+        const Mixed_signal_task_info* task_info = Array_get_ref(plan->tasks, step);
+        Device_thread_state* ts =
+            Device_states_get_thread_state(dstates, 0, task_info->device_id);
+
+        bool success = true;
+        for (int port = 0; (port < KQT_DEVICE_PORTS_MAX) && success; ++port)
+        {
+            Work_buffer* buffer =
+                Device_thread_state_get_mixed_buffer(ts, DEVICE_PORT_TYPE_SEND, port);
+            if (buffer != NULL)
+                success = Work_buffer_sharing_add_use(sharing, buffer, step, step);
+        }
+
+        if (!success ||
+                !add_conn_uses(sharing, task_info->conns, step) ||
+                !add_conn_uses(sharing, task_info->bypass_conns, step))
+        {
+            del_Work_buffer_sharing(sharing);
+            return false;
+        }
+    }
+
+    const bool success = Work_buffer_sharing_get_bindings(sharing, plan->bindings);
+    del_Work_buffer_sharing(sharing);
+
+    return success;
+}
+
+
 static bool Mixed_signal_plan_build(
         Mixed_signal_plan* plan,
         Device_states* dstates,
@@ -677,7 +773,8 @@ static bool Mixed_signal_plan_build(
     Device_states_reset_node_states(dstates);
 
     return (Mixed_signal_plan_build_from_node(plan, dstates, master, 0, 0) &&
-            Mixed_signal_plan_finalise(plan));
+            Mixed_signal_plan_finalise(plan) &&
+            Mixed_signal_plan_share_buffers(plan, dstates, conns));
 }
 
 
@@ -692,11 +789,15 @@ Mixed_signal_plan* new_Mixed_signal_plan(
 
     // Sanitise fields
     plan->tasks = NULL;
+    plan->bindings = NULL;
     plan->dstates = dstates;
 
     // Initialise
     plan->tasks = new_Array(sizeof(Mixed_signal_task_info));
-    if ((plan->tasks == NULL) || !Mixed_signal_plan_build(plan, dstates, conns))
+    plan->bindings = new_Array(sizeof(Work_buffer_binding));
+    if ((plan->tasks == NULL) ||
+            (plan->bindings == NULL) ||
+            !Mixed_signal_plan_build(plan, dstates, conns))
     {
         del_Mixed_signal_plan(plan);
         return NULL;
@@ -706,6 +807,16 @@ Mixed_signal_plan* new_Mixed_signal_plan(
 }
 
 
+void Mixed_signal_plan_bind_buffers(const Mixed_signal_plan* plan)
+{
+    rassert(plan != NULL);
+
+    Work_buffer_bindings_apply(plan->bindings);
+
+    return;
+}
+
+
 void Mixed_signal_plan_execute_all_tasks(
         Mixed_signal_plan* plan,
         Work_buffers* wbs,
@@ -742,6 +853,7 @@ void del_Mixed_signal_plan(Mixed_signal_plan* plan)
     }
 
     del_Array(plan->tasks);
+    del_Array(plan->bindings);
     memory_free(plan);
 
     return;
@@ -36,6 +36,19 @@ Mixed_signal_plan* new_Mixed_signal_plan(
         Device_states* dstates, const Connections* conns);
 
 
+/**
+ * Make the mixed buffers of the Mixed signal plan share their contents.
+ *
+ * Mixed buffers that are never in use at the same time during the plan
+ * execution share contents so that the working set of the plan stays small.
+ * The Work buffers of the Device states must not be shared by other plans
+ * when this is called, see \a Device_states_restore_buffers.
+ *
+ * \param plan   The Mixed signal plan -- must not be \c NULL.
+ */
+void Mixed_signal_plan_bind_buffers(const Mixed_signal_plan* plan);
+
+
 /**
  * Execute all tasks in the Mixed signal plan.
  *
@@ -46,6 +46,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 
 #ifdef ENABLE_THREADS
@@ -53,6 +54,9 @@ static void* render_thread_func(void* arg);
 #endif
 
 
+static bool is_voice_batching_enabled = true;
+
+
 static bool Player_prepare_mixing_with_thread_count(Player* player, int thread_count);
 
 
@@ -155,6 +159,8 @@ Player* new_Player(
     player->event_buffer = NULL;
     player->voices = NULL;
     player->mixed_signal_plan = NULL;
+    for (int i = 0; i < KQT_AUDIO_UNITS_MAX; ++i)
+        player->voice_signal_plan_outdated[i] = true;
     Master_params_preinit(&player->master_params);
     for (int i = 0; i < KQT_CHANNELS_MAX; ++i)
         player->channels[i] = NULL;
@@ -171,6 +177,9 @@ Player* new_Player(
 
     player->events_returned = false;
 
+    player->governor_budget = 0;
+    player->governor_intervention_count = 0;
+
     player->susp_event_ch = -1;
     memset(player->susp_event_name, '\0', KQT_EVENT_NAME_MAX + 1);
     player->susp_event_value = *VALUE_AUTO;
@@ -183,10 +192,7 @@ Player* new_Player(
     if (player->device_states == NULL ||
             player->estate == NULL ||
             player->event_buffer == NULL ||
-            player->voices == NULL ||
-            !Voice_pool_reserve_state_space(
-                player->voices,
-                sizeof(Voice_state)))
+            player->voices == NULL)
     {
         del_Player(player);
         return NULL;
@@ -351,6 +357,10 @@ bool Player_set_thread_count(Player* player, int new_count, Error* error)
         }
     }
 
+    // Voice signal plans contain separate tasks for each thread
+    for (int i = 0; i < KQT_AUDIO_UNITS_MAX; ++i)
+        player->voice_signal_plan_outdated[i] = true;
+
     // (De)allocate Work buffers of Device states as needed
     if (!Device_states_set_thread_count(player->device_states, new_count) ||
             !Player_prepare_mixing_with_thread_count(player, new_count))
@@ -457,12 +467,74 @@ int Player_get_thread_count(const Player* player)
 }
 
 
-bool Player_reserve_voice_state_space(Player* player, int32_t size)
+bool Player_set_voice_pool_size(Player* player, int size)
+{
+    rassert(player != NULL);
+    rassert(size >= 1);
+    rassert(size <= KQT_VOICES_MAX);
+
+    if (size == Voice_pool_get_size(player->voices))
+        return true;
+
+    Voice_group_reservations_init(&player->voice_group_res);
+
+    return Voice_pool_set_size(player->voices, size);
+}
+
+
+int Player_get_voice_pool_size(const Player* player)
 {
     rassert(player != NULL);
+    return Voice_pool_get_size(player->voices);
+}
+
+
+void Player_set_voice_batching_enabled(bool enabled)
+{
+    is_voice_batching_enabled = enabled;
+    return;
+}
+
+
+void Player_set_voice_governor_budget(Player* player, int64_t budget)
+{
+    rassert(player != NULL);
+    rassert(budget >= 0);
+
+    player->governor_budget = budget;
+    player->governor_intervention_count = 0;
+
+    return;
+}
+
+
+int64_t Player_get_voice_governor_budget(const Player* player)
+{
+    rassert(player != NULL);
+    return player->governor_budget;
+}
+
+
+int64_t Player_get_voice_governor_intervention_count(const Player* player)
+{
+    rassert(player != NULL);
+    return player->governor_intervention_count;
+}
+
+
+bool Player_reserve_voice_state_space(
+        Player* player,
+        Proc_type proc_type,
+        int32_t size,
+        bool use_work_buffers)
+{
+    rassert(player != NULL);
+    rassert(proc_type >= 0);
+    rassert(proc_type < Proc_type_COUNT);
     rassert(size >= 0);
 
-    return Voice_pool_reserve_state_space(player->voices, size);
+    return Voice_pool_reserve_state_space(
+            player->voices, proc_type, size, use_work_buffers);
 }
 
 
@@ -483,51 +555,120 @@ bool Player_reserve_voice_work_buffer_space(Player* player, int32_t size)
 }
 
 
+void Player_invalidate_voice_signal_plan(Player* player, int au_index)
+{
+    rassert(player != NULL);
+    rassert(au_index >= 0);
+    rassert(au_index < KQT_AUDIO_UNITS_MAX);
+
+    player->voice_signal_plan_outdated[au_index] = true;
+
+    return;
+}
+
+
 static bool Player_prepare_mixing_with_thread_count(Player* player, int thread_count)
 {
     rassert(player != NULL);
     rassert(thread_count > 0);
     rassert(thread_count <= KQT_THREADS_MAX);
 
-    del_Mixed_signal_plan(player->mixed_signal_plan);
-    player->mixed_signal_plan = NULL;
+    // Signal plans may refer to removed Device states, so stop all sharing of
+    // Work buffer contents until the plans have been updated
+    if (!Device_states_restore_buffers(player->device_states))
+        return false;
 
     const Connections* conns = Module_get_connections(player->module);
     if (conns == NULL)
+    {
+        del_Mixed_signal_plan(player->mixed_signal_plan);
+        player->mixed_signal_plan = NULL;
         return true;
+    }
 
+    // Existing buffers are retained, so this only adds buffers for new ports
     if (!Device_states_prepare(player->device_states, conns))
         return false;
 
+    // Build new plans for changed audio units only
+    Au_table* au_table = Module_get_au_table(player->module);
+    Au_state* au_states[KQT_AUDIO_UNITS_MAX] = { NULL };
+    Voice_signal_plan* new_plans[KQT_AUDIO_UNITS_MAX] = { NULL };
+    bool success = true;
+
+    for (int i = 0; (i < KQT_AUDIO_UNITS_MAX) && success; ++i)
     {
-        Au_table* au_table = Module_get_au_table(player->module);
+        const Audio_unit* au = Au_table_get(au_table, i);
+        if ((au == NULL) ||
+                !Device_is_existent((const Device*)au) ||
+                (Audio_unit_get_type(au) != AU_TYPE_INSTRUMENT))
+            continue;
+
+        const Connections* au_conns = Audio_unit_get_connections(au);
+        if (au_conns == NULL)
+            continue;
+
+        const uint32_t au_id = Device_get_id((const Device*)au);
+        Au_state* au_state =
+            (Au_state*)Device_states_get_state(player->device_states, au_id);
+
+        if (!player->voice_signal_plan_outdated[i] &&
+                (au_state->voice_signal_plan != NULL))
+            continue;
+
+        au_states[i] = au_state;
+        new_plans[i] = new_Voice_signal_plan(
+                player->device_states, thread_count, au_conns);
+        if (new_plans[i] == NULL)
+            success = false;
+    }
+
+    Mixed_signal_plan* new_mixed_plan = NULL;
+    if (success)
+    {
+        new_mixed_plan = new_Mixed_signal_plan(player->device_states, conns);
+        if (new_mixed_plan == NULL)
+            success = false;
+    }
+
+    if (!success)
+    {
+        // Keep the old plans intact
         for (int i = 0; i < KQT_AUDIO_UNITS_MAX; ++i)
+            del_Voice_signal_plan(new_plans[i]);
+        return false;
+    }
+
+    // Swap in the new plans
+    for (int i = 0; i < KQT_AUDIO_UNITS_MAX; ++i)
+    {
+        if (new_plans[i] != NULL)
         {
-            const Audio_unit* au = Au_table_get(au_table, i);
-            if ((au != NULL) &&
-                    Device_is_existent((const Device*)au) &&
-                    (Audio_unit_get_type(au) == AU_TYPE_INSTRUMENT))
-            {
-                const Connections* au_conns = Audio_unit_get_connections(au);
-                if (au_conns != NULL)
-                {
-                    const uint32_t au_id = Device_get_id((const Device*)au);
-                    Au_state* au_state =
-                        (Au_state*)Device_states_get_state(player->device_states, au_id);
-
-                    Voice_signal_plan* plan = new_Voice_signal_plan(
-                            player->device_states, thread_count, au_conns);
-                    if (plan == NULL)
-                        return false;
-                    Au_state_set_voice_signal_plan(au_state, plan);
-                }
-            }
+            Au_state_set_voice_signal_plan(au_states[i], new_plans[i]);
+            player->voice_signal_plan_outdated[i] = false;
         }
     }
 
-    player->mixed_signal_plan = new_Mixed_signal_plan(player->device_states, conns);
-    if (player->mixed_signal_plan == NULL)
-        return false;
+    del_Mixed_signal_plan(player->mixed_signal_plan);
+    player->mixed_signal_plan = new_mixed_plan;
+
+    // Share Work buffer contents according to the current plans
+    for (int i = 0; i < KQT_AUDIO_UNITS_MAX; ++i)
+    {
+        const Audio_unit* au = Au_table_get(au_table, i);
+        if ((au == NULL) ||
+                !Device_is_existent((const Device*)au) ||
+                (Audio_unit_get_type(au) != AU_TYPE_INSTRUMENT) ||
+                (Audio_unit_get_connections(au) == NULL))
+            continue;
+
+        const Au_state* au_state = (const Au_state*)Device_states_get_state(
+                player->device_states, Device_get_id((const Device*)au));
+        if (au_state->voice_signal_plan != NULL)
+            Voice_signal_plan_bind_buffers(au_state->voice_signal_plan);
+    }
+
+    Mixed_signal_plan_bind_buffers(player->mixed_signal_plan);
 
     return true;
 }
@@ -932,6 +1073,202 @@ static void Player_process_voice_group(
 }
 
 
+/**
+ * Background Voice groups of the same Audio unit waiting to be rendered as a
+ * batch.
+ */
+typedef struct Vgroup_batch
+{
+    Voice_signal_plan* plan;
+    int32_t frame_offset;
+    int size;
+    Voice_group vgroups[DEVICE_VOICE_LANES_MAX];
+} Vgroup_batch;
+
+
+#define VGROUP_BATCHES_MAX 4
+
+
+static void Player_process_voice_group_batch(
+        Player* player,
+        Player_thread_params* tparams,
+        Vgroup_batch* batch,
+        int32_t total_frame_count,
+        Render_stats* stats)
+{
+    rassert(player != NULL);
+    rassert(tparams != NULL);
+    rassert(batch != NULL);
+    rassert(batch->plan != NULL);
+    rassert(batch->size > 0);
+    rassert(total_frame_count >= batch->frame_offset);
+    rassert(stats != NULL);
+
+    const int32_t frame_count = total_frame_count - batch->frame_offset;
+
+    Voice_group* vgroups[DEVICE_VOICE_LANES_MAX] = { NULL };
+    bool enable_mixing[DEVICE_VOICE_LANES_MAX] = { false };
+    int32_t process_stops[DEVICE_VOICE_LANES_MAX] = { 0 };
+
+    for (int i = 0; i < batch->size; ++i)
+    {
+        Voice_group* vgroup = &batch->vgroups[i];
+        vgroups[i] = vgroup;
+
+        const int ch_num = Voice_group_get_ch_num(vgroup);
+        const bool is_muted = !Voice_group_is_external(vgroup)
+            ? Channel_is_muted(player->channels[ch_num]) : false;
+        enable_mixing[i] = !is_muted;
+    }
+
+    Voice_signal_plan_execute_batch(
+            batch->plan,
+            player->device_states,
+            tparams->thread_id,
+            vgroups,
+            batch->size,
+            tparams->work_buffers,
+            frame_count,
+            batch->frame_offset,
+            total_frame_count,
+            player->master_params.tempo,
+            enable_mixing,
+            process_stops);
+
+    for (int i = 0; i < batch->size; ++i)
+    {
+        Voice_group* vgroup = vgroups[i];
+
+        if (process_stops[i] < frame_count)
+            Voice_group_deactivate_all(vgroup);
+
+        const int active_voice_count = Voice_group_get_active_count(vgroup);
+        stats->voice_count += active_voice_count;
+        if (active_voice_count > 0)
+            ++stats->vgroup_count;
+
+        for (int vi = 0; vi < Voice_group_get_size(vgroup); ++vi)
+            Voice_group_get_voice(vgroup, vi)->frame_offset = 0;
+    }
+
+    batch->size = 0;
+
+    return;
+}
+
+
+static void Player_process_bg_voice_group(
+        Player* player,
+        Player_thread_params* tparams,
+        Vgroup_batch batches[VGROUP_BATCHES_MAX],
+        Voice_group* vgroup,
+        int32_t frame_count,
+        Render_stats* stats)
+{
+    rassert(player != NULL);
+    rassert(tparams != NULL);
+    rassert(batches != NULL);
+    rassert(vgroup != NULL);
+    rassert(frame_count >= 0);
+    rassert(stats != NULL);
+
+    Voice* first_voice = Voice_group_get_voice(vgroup, 0);
+    const int32_t frame_offset = first_voice->frame_offset;
+
+    const Processor* first_proc = Voice_get_proc(first_voice);
+    const uint32_t au_id = Processor_get_au_params(first_proc)->device_id;
+    const Au_state* au_state =
+        (const Au_state*)Device_states_get_state(player->device_states, au_id);
+    Voice_signal_plan* plan = au_state->voice_signal_plan;
+
+    if (!is_voice_batching_enabled ||
+            (plan == NULL) ||
+            (Voice_signal_plan_get_batch_size_max(plan) <= 1) ||
+            Voice_is_using_test_output(first_voice))
+    {
+        Player_process_voice_group(
+                player,
+                tparams,
+                vgroup,
+                frame_count - frame_offset,
+                frame_offset,
+                frame_count,
+                stats);
+
+        for (int vi = 0; vi < Voice_group_get_size(vgroup); ++vi)
+            Voice_group_get_voice(vgroup, vi)->frame_offset = 0;
+
+        return;
+    }
+
+    // Add the Voice group to a batch of the same Audio unit
+    Vgroup_batch* batch = NULL;
+    for (int i = 0; i < VGROUP_BATCHES_MAX; ++i)
+    {
+        if ((batches[i].size > 0) &&
+                (batches[i].plan == plan) &&
+                (batches[i].frame_offset == frame_offset))
+        {
+            batch = &batches[i];
+            break;
+        }
+    }
+
+    if (batch == NULL)
+    {
+        for (int i = 0; i < VGROUP_BATCHES_MAX; ++i)
+        {
+            if (batches[i].size == 0)
+            {
+                batch = &batches[i];
+                break;
+            }
+        }
+
+        if (batch == NULL)
+        {
+            batch = &batches[0];
+            Player_process_voice_group_batch(player, tparams, batch, frame_count, stats);
+        }
+
+        batch->plan = plan;
+        batch->frame_offset = frame_offset;
+    }
+
+    Voice_group_copy(&batch->vgroups[batch->size], vgroup);
+    ++batch->size;
+
+    if (batch->size >= Voice_signal_plan_get_batch_size_max(plan))
+        Player_process_voice_group_batch(player, tparams, batch, frame_count, stats);
+
+    return;
+}
+
+
+static void Player_process_bg_voice_group_batches(
+        Player* player,
+        Player_thread_params* tparams,
+        Vgroup_batch batches[VGROUP_BATCHES_MAX],
+        int32_t frame_count,
+        Render_stats* stats)
+{
+    rassert(player != NULL);
+    rassert(tparams != NULL);
+    rassert(batches != NULL);
+    rassert(frame_count >= 0);
+    rassert(stats != NULL);
+
+    for (int i = 0; i < VGROUP_BATCHES_MAX; ++i)
+    {
+        if (batches[i].size > 0)
+            Player_process_voice_group_batch(
+                    player, tparams, &batches[i], frame_count, stats);
+    }
+
+    return;
+}
+
+
 static void Player_process_channel_fg_voices(
         Player* player,
         Player_thread_params* tparams,
@@ -1174,28 +1511,19 @@ static void Player_process_voice_groups_synced(
     // Background voices
     {
         Voice_group* vgroup = VOICE_GROUP_AUTO;
+        Vgroup_batch batches[VGROUP_BATCHES_MAX] = { { .size = 0 } };
 
         Voice_group* vg = Voice_pool_get_next_bg_group_synced(player->voices, vgroup);
         while (vg != NULL)
         {
-            Voice* first_voice = Voice_group_get_voice(vg, 0);
-            const int32_t frame_offset = first_voice->frame_offset;
-            const int32_t cur_frame_count = frame_count - frame_offset;
-
-            Player_process_voice_group(
-                    player,
-                    tparams,
-                    vg,
-                    cur_frame_count,
-                    frame_offset,
-                    frame_count,
-                    stats);
-
-            for (int vi = 0; vi < Voice_group_get_size(vg); ++vi)
-                Voice_group_get_voice(vg, vi)->frame_offset = 0;
+            Player_process_bg_voice_group(
+                    player, tparams, batches, vg, frame_count, stats);
 
             vg = Voice_pool_get_next_bg_group_synced(player->voices, vgroup);
         }
+
+        Player_process_bg_voice_group_batches(
+                player, tparams, batches, frame_count, stats);
     }
 
     tparams->active_voices = stats->voice_count;
@@ -1234,7 +1562,9 @@ static void* render_thread_func(void* arg)
 
         rassert(params->thread_id < player->thread_count);
 
+        memory_enter_render_path();
         Player_process_voice_groups_synced(player, params, player->render_frame_count);
+        memory_leave_render_path();
 
         // Wait to indicate that we have finished processing voice groups
         Barrier_wait(&player->vgroups_finished_barrier);
@@ -1295,32 +1625,24 @@ static void Player_process_voices_single_threaded(
     // Background voices
     {
         Voice_group* vgroup = VOICE_GROUP_AUTO;
+        Vgroup_batch batches[VGROUP_BATCHES_MAX] = { { .size = 0 } };
 
         Voice_group* vg = Voice_pool_get_next_bg_group(player->voices, vgroup);
         while (vg != NULL)
         {
-            Voice* first_voice = Voice_group_get_voice(vg, 0);
-            const int32_t frame_offset = first_voice->frame_offset;
-            const int32_t cur_frame_count = frame_count - frame_offset;
-
             //fprintf(stdout, "process background voice group %d, frames [%d, %d)\n",
             //        (int)Voice_group_get_voice(vg, 0)->group_id,
-            //        (int)frame_offset, (int)frame_count);
-
-            Player_process_voice_group(
-                    player,
-                    &player->thread_params[0],
-                    vg,
-                    cur_frame_count,
-                    frame_offset,
-                    frame_count,
-                    stats);
+            //        (int)Voice_group_get_voice(vg, 0)->frame_offset,
+            //        (int)frame_count);
 
-            for (int vi = 0; vi < Voice_group_get_size(vg); ++vi)
-                Voice_group_get_voice(vg, vi)->frame_offset = 0;
+            Player_process_bg_voice_group(
+                    player, &player->thread_params[0], batches, vg, frame_count, stats);
 
             vg = Voice_pool_get_next_bg_group(player->voices, vgroup);
         }
+
+        Player_process_bg_voice_group_batches(
+                player, &player->thread_params[0], batches, frame_count, stats);
     }
 
     Voice_pool_finish_group_iteration(player->voices);
@@ -1676,12 +1998,50 @@ static void Player_init_final(Player* player)
 }
 
 
+static int64_t get_render_clock(void)
+{
+    struct timespec ts;
+
+#ifdef CLOCK_MONOTONIC
+    // Rendering time must not be affected by adjustments of the system time
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0)
+        return 0;
+#else
+    // Fall back to the wall clock where POSIX clocks are not available
+    if (timespec_get(&ts, TIME_UTC) != TIME_UTC)
+        return 0;
+#endif
+
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+
+static void Player_update_voice_governor(Player* player, int64_t render_time)
+{
+    rassert(player != NULL);
+    rassert(player->governor_budget > 0);
+
+    if (render_time <= player->governor_budget)
+        return;
+
+    // Assume that the rendering cost is roughly proportional to voice count
+    const double excess =
+        (double)(render_time - player->governor_budget) / (double)render_time;
+    if (Voice_pool_release_bg_groups(player->voices, excess) > 0)
+        ++player->governor_intervention_count;
+
+    return;
+}
+
+
 void Player_play(Player* player, int32_t nframes)
 {
     rassert(player != NULL);
     rassert(player->audio_buffer_size > 0);
     rassert(nframes >= 0);
 
+    const int64_t start_time = (player->governor_budget > 0) ? get_render_clock() : 0;
+
     Player_flush_receive(player);
 
     Event_buffer_clear(player->event_buffer);
@@ -1692,6 +2052,9 @@ void Player_play(Player* player, int32_t nframes)
     rassert(connections != NULL);
     rassert(player->mixed_signal_plan != NULL);
 
+    // Removing a Device state must be followed by Player_prepare_mixing
+    rassert(!Device_states_is_sharing_outdated(player->device_states));
+
     // TODO: check if song or pattern instance location has changed
 
     // Composition-level progress
@@ -1798,6 +2161,9 @@ void Player_play(Player* player, int32_t nframes)
 
     player->events_returned = false;
 
+    if (player->governor_budget > 0)
+        Player_update_voice_governor(player, get_render_clock() - start_time);
+
     return;
 }
 
@@ -1,7 +1,7 @@
 
 
 /*
- * Author: Tomi Jylhä-Ollila, Finland 2013-2018
+ * Author: Tomi Jylhä-Ollila, Finland 2013-2019
  *
  * This file is part of Kunquat.
  *
@@ -18,6 +18,7 @@
 
 #include <Error.h>
 #include <init/devices/Au_streams.h>
+#include <init/devices/Proc_type.h>
 #include <init/Module.h>
 #include <kunquat/limits.h>
 #include <player/Event_handler.h>
@@ -97,14 +98,94 @@ int Player_get_thread_count(const Player* player);
 
 
 /**
- * Reserve state space for internal voice pool.
+ * Set the number of Voices in the internal voice pool.
+ *
+ * This function resets all Voices.
  *
  * \param player   The Player -- must not be \c NULL.
- * \param size     The new size -- must be >= \c 0.
+ * \param size     The number of Voices -- must be >= \c 1 and
+ *                 <= \c KQT_VOICES_MAX.
  *
  * \return   \c true if successful, or \c false if memory allocation failed.
  */
-bool Player_reserve_voice_state_space(Player* player, int32_t size);
+bool Player_set_voice_pool_size(Player* player, int size);
+
+
+/**
+ * Get the number of Voices in the internal voice pool.
+ *
+ * \param player   The Player -- must not be \c NULL.
+ *
+ * \return   The number of Voices.
+ */
+int Player_get_voice_pool_size(const Player* player);
+
+
+/**
+ * Enable or disable batch rendering of background Voice groups.
+ *
+ * Batching is enabled by default. This setting applies to all Players and
+ * is intended for testing that batches render like separate Voice groups.
+ * It must not be changed while any Player is rendering.
+ *
+ * \param enabled   \c true to render background Voice groups in batches,
+ *                  otherwise \c false.
+ */
+void Player_set_voice_batching_enabled(bool enabled);
+
+
+/**
+ * Set the render time budget of the voice governor.
+ *
+ * When the rendering time of Player_play exceeds the budget, the voice
+ * governor releases background Voices in proportion to the excess time.
+ * The budget applies to each call of Player_play regardless of the number
+ * of frames rendered. Setting the budget resets the intervention count.
+ *
+ * \param player   The Player -- must not be \c NULL.
+ * \param budget   The budget in nanoseconds per call of Player_play, or \c 0
+ *                 to disable the voice governor -- must be >= \c 0.
+ */
+void Player_set_voice_governor_budget(Player* player, int64_t budget);
+
+
+/**
+ * Get the render time budget of the voice governor.
+ *
+ * \param player   The Player -- must not be \c NULL.
+ *
+ * \return   The budget in nanoseconds, or \c 0 if the governor is disabled.
+ */
+int64_t Player_get_voice_governor_budget(const Player* player);
+
+
+/**
+ * Get the number of times the voice governor has released Voices.
+ *
+ * \param player   The Player -- must not be \c NULL.
+ *
+ * \return   The number of calls of Player_play after which Voices were
+ *           released.
+ */
+int64_t Player_get_voice_governor_intervention_count(const Player* player);
+
+
+/**
+ * Reserve state space for a Processor type in the internal voice pool.
+ *
+ * \param player             The Player -- must not be \c NULL.
+ * \param proc_type          The Processor type -- must be valid.
+ * \param size               The new size -- must be >= \c 0.
+ * \param use_work_buffers   \c true if the Voices of \a proc_type need Voice
+ *                           work buffers, otherwise \c false.
+ *
+ * \return   \c true if successful, or \c false if memory allocation failed.
+ */
+bool Player_reserve_voice_state_space(
+        Player* player,
+        Proc_type proc_type,
+        int32_t size,
+        bool use_work_buffers);
 
 
 /**
@@ -129,9 +210,26 @@ int32_t Player_get_voice_work_buffer_size(const Player* player);
 bool Player_reserve_voice_work_buffer_space(Player* player, int32_t size);
 
 
+/**
+ * Mark the Voice signal plan of an audio unit as outdated.
+ *
+ * The plan will be rebuilt on the next call of \a Player_prepare_mixing.
+ *
+ * \param player     The Player -- must not be \c NULL.
+ * \param au_index   The index of the top-level audio unit -- must be >= \c 0
+ *                   and < \c KQT_AUDIO_UNITS_MAX.
+ */
+void Player_invalidate_voice_signal_plan(Player* player, int au_index);
+
+
 /**
  * Prepare signal mixing in the Player.
  *
+ * Only the Voice signal plans of audio units marked with
+ * \a Player_invalidate_voice_signal_plan (or not built yet) are rebuilt.
+ * The new signal plans replace the old ones only after all of them have been
+ * built successfully.
+ *
  * \param player   The Player -- must not be \c NULL.
  *
  * \return   \c true if successful, or \c false if memory allocation failed.
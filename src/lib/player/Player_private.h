@@ -76,6 +76,7 @@ struct Player
     Voice_pool*    voices;
     Voice_group_reservations voice_group_res;
     Mixed_signal_plan* mixed_signal_plan;
+    bool voice_signal_plan_outdated[KQT_AUDIO_UNITS_MAX];
     Master_params  master_params;
     Channel*       channels[KQT_CHANNELS_MAX];
     Event_handler* event_handler;
@@ -91,6 +92,10 @@ struct Player
 
     bool events_returned;
 
+    // Voice governor
+    int64_t governor_budget;
+    int64_t governor_intervention_count;
+
     // Suspended event processing state
     int   susp_event_ch;
     char  susp_event_name[KQT_EVENT_NAME_MAX + 1];
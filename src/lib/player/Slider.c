@@ -109,6 +109,70 @@ double Slider_step(Slider* slider)
 }
 
 
+double Slider_fill(
+        Slider* slider,
+        Work_buffer* wb,
+        int32_t buf_start,
+        int32_t buf_stop,
+        double value)
+{
+    rassert(slider != NULL);
+    rassert(wb != NULL);
+    rassert(buf_start >= 0);
+    rassert(buf_start < buf_stop);
+    rassert(isfinite(value));
+
+    float* values = Work_buffer_get_contents_mut(wb);
+
+    int32_t const_start = buf_start;
+
+    int32_t cur_pos = buf_start;
+    while (cur_pos < buf_stop)
+    {
+        const int32_t estimated_steps = Slider_estimate_active_steps_left(slider);
+        if (estimated_steps > 0)
+        {
+            int32_t slide_stop = buf_stop;
+            if (estimated_steps < buf_stop - cur_pos)
+                slide_stop = cur_pos + estimated_steps;
+
+            // Evaluate the slide directly from the step index
+            const double init_progress = slider->progress;
+            const double progress_update = slider->progress_update;
+            const double from = slider->from;
+            const double diff = slider->to - slider->from;
+            const int32_t last_pos = slide_stop - 1;
+            for (int32_t i = cur_pos; i < last_pos; ++i)
+            {
+                const double progress =
+                    init_progress + progress_update * (double)(i - cur_pos + 1);
+                values[i] = (float)(from + diff * min(progress, 1.0));
+            }
+
+            slider->progress =
+                init_progress + progress_update * (double)(slide_stop - cur_pos);
+            value = Slider_get_value(slider);
+            values[last_pos] = (float)value;
+
+            const_start = slide_stop;
+            cur_pos = slide_stop;
+        }
+        else
+        {
+            const float value_f = (float)value;
+            for (int32_t i = cur_pos; i < buf_stop; ++i)
+                values[i] = value_f;
+
+            cur_pos = buf_stop;
+        }
+    }
+
+    Work_buffer_set_const_start(wb, const_start);
+
+    return value;
+}
+
+
 double Slider_skip(Slider* slider, int64_t steps)
 {
     rassert(slider != NULL);
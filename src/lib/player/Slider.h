@@ -17,6 +17,7 @@
 
 
 #include <mathnum/Tstamp.h>
+#include <player/Work_buffer.h>
 
 #include <stdbool.h>
 #include <stdint.h>
@@ -104,6 +105,30 @@ double Slider_get_value(const Slider* slider);
 double Slider_step(Slider* slider);
 
 
+/**
+ * Fill a Work buffer area with consecutive steps of the Slider.
+ *
+ * Each frame receives the value that \a Slider_step would return for it. The
+ * frames after the end of the slide are filled with the final value and marked
+ * as constant with \a Work_buffer_set_const_start.
+ *
+ * \param slider      The Slider -- must not be \c NULL.
+ * \param wb          The Work buffer -- must not be \c NULL.
+ * \param buf_start   The start index of the area -- must be >= \c 0.
+ * \param buf_stop    The stop index of the area -- must be > \a buf_start.
+ * \param value       The current value, used if no slide is in progress
+ *                    -- must be finite.
+ *
+ * \return   The last value written to \a wb.
+ */
+double Slider_fill(
+        Slider* slider,
+        Work_buffer* wb,
+        int32_t buf_start,
+        int32_t buf_stop,
+        double value);
+
+
 /**
  * Skip a portion of the slide in the Slider.
  *
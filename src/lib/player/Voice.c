@@ -35,16 +35,17 @@ void Voice_preinit(Voice* voice)
     voice->group_id = 0;
     voice->proc = NULL;
     voice->state = NULL;
+    voice->state_class = -1;
+    voice->state_index = -1;
     voice->wb = NULL;
 
     return;
 }
 
 
-Voice* Voice_init(Voice* voice, Voice_state* state)
+Voice* Voice_init(Voice* voice)
 {
     rassert(voice != NULL);
-    rassert(state != NULL);
 
     voice->group_id = 0;
     voice->ch_num = -1;
@@ -56,13 +57,12 @@ Voice* Voice_init(Voice* voice, Voice_state* state)
     voice->test_proc_index = -1;
     voice->proc = NULL;
     voice->state = NULL;
+    voice->state_class = -1;
+    voice->state_index = -1;
     voice->wb = NULL;
 
-    voice->state = state;
-
     Random_init(&voice->rand_p, "vp");
     Random_init(&voice->rand_s, "vs");
-    Voice_state_clear(voice->state);
 
     return voice;
 }
@@ -105,6 +105,18 @@ const Processor* Voice_get_proc(const Voice* voice)
 }
 
 
+void Voice_set_state(Voice* voice, Voice_state* state)
+{
+    rassert(voice != NULL);
+
+    voice->state = state;
+    if (voice->state != NULL)
+        Voice_state_clear(voice->state);
+
+    return;
+}
+
+
 void Voice_set_work_buffer(Voice* voice, Work_buffer* wb)
 {
     rassert(voice != NULL);
@@ -139,6 +151,7 @@ void Voice_start(
     rassert(voice != NULL);
     rassert(proc != NULL);
     rassert(proc_state != NULL);
+    rassert(voice->state != NULL);
 
     voice->proc = proc;
     voice->use_test_output = false;
@@ -147,6 +160,7 @@ void Voice_start(
     Random_set_seed(&voice->rand_s, seed);
 
     Proc_type proc_type = Device_impl_get_proc_type(proc->parent.dimpl);
+    rassert(voice->state_class == (int)proc_type);
 
     Voice_state_init(voice->state, proc_type, &voice->rand_p, &voice->rand_s);
     Voice_state_set_work_buffer(voice->state, voice->wb);
@@ -209,7 +223,8 @@ void Voice_reset(Voice* voice)
     voice->is_external = false;
     voice->prio = VOICE_PRIO_INACTIVE;
     voice->frame_offset = 0;
-    Voice_state_clear(voice->state);
+    if (voice->state != NULL)
+        Voice_state_clear(voice->state);
     voice->proc = NULL;
     Random_reset(&voice->rand_p);
     Random_reset(&voice->rand_s);
@@ -284,6 +299,84 @@ int32_t Voice_render(
 }
 
 
+void Voice_render_batch(
+        Voice* voices[DEVICE_VOICE_LANES_MAX],
+        uint32_t proc_id,
+        Device_states* dstates,
+        int thread_id,
+        const Work_buffers* wbs,
+        int32_t frame_count,
+        double tempo,
+        int32_t stops[DEVICE_VOICE_LANES_MAX])
+{
+    rassert(voices != NULL);
+    rassert(proc_id > 0);
+    rassert(dstates != NULL);
+    rassert(thread_id >= 0);
+    rassert(thread_id < KQT_THREADS_MAX);
+    rassert(wbs != NULL);
+    rassert(frame_count >= 0);
+    rassert(stops != NULL);
+
+    Proc_state* pstate = (Proc_state*)Device_states_get_state(dstates, proc_id);
+    const Processor* proc = (const Processor*)pstate->parent.device;
+    Device_thread_state* proc_ts =
+        Device_states_get_thread_state(dstates, thread_id, proc_id);
+    const Au_state* au_state = (const Au_state*)Device_states_get_state(
+            dstates, Processor_get_au_params(proc)->device_id);
+
+    Voice_state* vstates[DEVICE_VOICE_LANES_MAX] = { NULL };
+    for (int lane = 0; lane < DEVICE_VOICE_LANES_MAX; ++lane)
+    {
+        Voice* voice = voices[lane];
+        if ((voice != NULL) && (voice->prio != VOICE_PRIO_INACTIVE))
+        {
+            rassert(voice->proc != NULL);
+            vstates[lane] = voice->state;
+            vstates[lane]->keep_alive_stop = 0;
+        }
+    }
+
+    int32_t process_stops[DEVICE_VOICE_LANES_MAX] = { 0 };
+    Voice_state_render_voices(
+            vstates, pstate, proc_ts, au_state, wbs, frame_count, tempo, process_stops);
+
+    for (int lane = 0; lane < DEVICE_VOICE_LANES_MAX; ++lane)
+    {
+        stops[lane] = 0;
+
+        Voice* voice = voices[lane];
+        if (vstates[lane] == NULL)
+            continue;
+
+        // Make sure that the outputs are either fully valid or fully invalid
+        const int32_t process_stop = process_stops[lane];
+        Device_thread_state_set_voice_lane(proc_ts, lane);
+        if (process_stop == 0)
+            Device_thread_state_invalidate_voice_outputs(proc_ts);
+        else if (process_stop < frame_count)
+            Device_thread_state_clear_voice_outputs(proc_ts, process_stop, frame_count);
+
+        voice->updated = true;
+
+        if (!voice->state->active)
+        {
+            voice->prio = VOICE_PRIO_INACTIVE;
+            continue;
+        }
+
+        if (!voice->state->note_on)
+            voice->prio = VOICE_PRIO_BG;
+
+        stops[lane] = min(voice->state->keep_alive_stop, frame_count);
+    }
+
+    Device_thread_state_set_voice_lane(proc_ts, 0);
+
+    return;
+}
+
+
 void Voice_deinit(Voice* voice)
 {
     rassert(voice != NULL);
@@ -21,6 +21,7 @@
 #include <kunquat/limits.h>
 #include <mathnum/Random.h>
 #include <player/Device_states.h>
+#include <player/devices/Device_thread_state.h>
 #include <player/Work_buffer.h>
 #include <player/Work_buffers.h>
 
@@ -54,6 +55,8 @@ struct Voice
     int test_proc_index;
     const Processor* proc;   ///< The Processor.
     Voice_state* state;      ///< The current playback state.
+    int state_class;         ///< The storage class of the state, or \c -1.
+    int state_index;         ///< The index of the state in its storage class.
     Work_buffer* wb;         ///< The Work buffer associated with this Voice.
     Random rand_p;           ///< Parameter random source.
     Random rand_s;           ///< Signal random source.
@@ -71,12 +74,13 @@ void Voice_preinit(Voice* voice);
 /**
  * Initialise the Voice.
  *
+ * The Voice has no Voice state until one is assigned with \a Voice_set_state.
+ *
  * \param voice   The Voice -- must not be \c NULL.
- * \param state   The Voice state -- must not be \c NULL.
  *
  * \return   \a voice if successful, or \c NULL if memory allocation failed.
  */
-Voice* Voice_init(Voice* voice, Voice_state* state);
+Voice* Voice_init(Voice* voice);
 
 
 /**
@@ -133,6 +137,16 @@ bool Voice_is_external(const Voice* voice);
 const Processor* Voice_get_proc(const Voice* voice);
 
 
+/**
+ * Set the Voice state storage of the Voice.
+ *
+ * \param voice   The Voice -- must not be \c NULL.
+ * \param state   The Voice state, or \c NULL. A new state is cleared before
+ *                use.
+ */
+void Voice_set_state(Voice* voice, Voice_state* state);
+
+
 /**
  * Set the Work buffer associated with the Voice.
  *
@@ -247,6 +261,36 @@ int32_t Voice_render(
         double tempo);
 
 
+/**
+ * Render a batch of Voices of the same Processor.
+ *
+ * The Voice at index i is rendered using the voice buffer lane i of the
+ * Processor. The Processor must support batch rendering.
+ *
+ * \param voices        The Voices -- must not be \c NULL. Lanes that are not
+ *                      rendered are marked with \c NULL.
+ * \param proc_id       The Processor ID -- must be valid.
+ * \param dstates       The Device states -- must not be \c NULL.
+ * \param thread_id     The ID of the thread accessing the Device state
+ *                      -- must be a valid ID currently in use.
+ * \param wbs           The Work buffers -- must not be \c NULL.
+ * \param frame_count   Number of frames to be rendered >= \c 0.
+ * \param tempo         The current tempo -- must be > \c 0.
+ * \param stops         Destination for the stop indices for keeping the
+ *                      Voices alive -- must not be \c NULL. See
+ *                      \a Voice_render for details.
+ */
+void Voice_render_batch(
+        Voice* voices[DEVICE_VOICE_LANES_MAX],
+        uint32_t proc_id,
+        Device_states* dstates,
+        int thread_id,
+        const Work_buffers* wbs,
+        int32_t frame_count,
+        double tempo,
+        int32_t stops[DEVICE_VOICE_LANES_MAX]);
+
+
 /**
  * Deinitialise the Voice.
  *
@@ -16,7 +16,10 @@
 
 #include <debug/assert.h>
 #include <kunquat/limits.h>
+#include <mathnum/common.h>
 #include <memory.h>
+#include <player/devices/Voice_state.h>
+#include <player/devices/processors/Force_state.h>
 #include <player/Voice_work_buffers.h>
 #include <threads/Mutex.h>
 
@@ -24,12 +27,42 @@
 #include <stdatomic.h>
 #endif
 
+#include <math.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
 
 
+/*
+ * Voice states are stored in chunks of storage classes, one class per Processor
+ * type. A class holds a state for every Voice in the pool, so the memory used
+ * by work buffers is bounded by the Voice pool size. The chunks are only
+ * allocated outside rendering; if a class is still full, it gives up the state
+ * of one of its oldest Voices instead of growing.
+ */
+#define VOICE_CHUNK_SIZE 16
+
+static_assert(VOICE_CHUNK_SIZE == 16, "Voice chunk usage is tracked in 16-bit masks");
+
+
+typedef struct Voice_chunk
+{
+    char* states;
+    Voice_work_buffers* wbs;
+    uint16_t used_mask;
+} Voice_chunk;
+
+
+typedef struct Voice_class
+{
+    int32_t state_size;
+    bool uses_work_buffers;
+    int chunk_count;
+    Voice_chunk* chunks;
+} Voice_class;
+
+
 struct Voice_pool
 {
 #ifdef ENABLE_THREADS
@@ -37,11 +70,11 @@ struct Voice_pool
 #endif
 
     int size;
-    int32_t state_size;
+    int32_t work_buffer_size;
     uint64_t new_group_id;
 
-    char* voice_state_memory;
-    Voice voices[KQT_VOICES_MAX];
+    Voice* voices;
+    Voice_class classes[Proc_type_COUNT];
 
     int free_voice_count;
     Voice* free_voices[KQT_VOICES_MAX];
@@ -58,14 +91,198 @@ struct Voice_pool
     int bg_iter_index;
     int bg_group_count;
     int16_t bg_group_offsets[KQT_VOICES_MAX];
-
-    Voice_work_buffers* voice_wbs;
 };
 
 
+static int get_chunk_count_max(int pool_size)
+{
+    rassert(pool_size >= 0);
+    return (pool_size + VOICE_CHUNK_SIZE - 1) / VOICE_CHUNK_SIZE;
+}
+
+
+static bool Voice_class_add_chunk(Voice_class* vc, int32_t wb_size)
+{
+    rassert(vc != NULL);
+    rassert(vc->state_size > 0);
+    rassert(vc->chunks != NULL);
+    rassert(wb_size >= 0);
+
+    Voice_chunk* chunk = &vc->chunks[vc->chunk_count];
+    const Memory_category prev_category = memory_set_category(MEMORY_CATEGORY_VOICES);
+    chunk->states = memory_alloc_aligned(
+            (int64_t)vc->state_size * VOICE_CHUNK_SIZE, VOICE_STATE_ALIGNMENT);
+    memory_set_category(prev_category);
+    if (chunk->states == NULL)
+        return false;
+
+    chunk->wbs = NULL;
+    chunk->used_mask = 0;
+
+    if (vc->uses_work_buffers)
+    {
+        chunk->wbs = new_Voice_work_buffers();
+        if ((chunk->wbs == NULL) ||
+                !Voice_work_buffers_allocate_space(chunk->wbs, VOICE_CHUNK_SIZE, wb_size))
+        {
+            del_Voice_work_buffers(chunk->wbs);
+            chunk->wbs = NULL;
+            memory_free_aligned(chunk->states);
+            chunk->states = NULL;
+            return false;
+        }
+    }
+
+    ++vc->chunk_count;
+
+    return true;
+}
+
+
+static void Voice_class_clear(Voice_class* vc)
+{
+    rassert(vc != NULL);
+
+    for (int i = 0; i < vc->chunk_count; ++i)
+    {
+        Voice_chunk* chunk = &vc->chunks[i];
+        rassert(chunk->used_mask == 0);
+        del_Voice_work_buffers(chunk->wbs);
+        memory_free_aligned(chunk->states);
+    }
+
+    vc->chunk_count = 0;
+    memory_free(vc->chunks);
+    vc->chunks = NULL;
+
+    return;
+}
+
+
+static bool Voice_class_reserve_chunks(Voice_class* vc, int pool_size, int32_t wb_size)
+{
+    rassert(vc != NULL);
+    rassert(vc->state_size > 0);
+    rassert(pool_size >= 0);
+    rassert(wb_size >= 0);
+
+    if (pool_size == 0)
+        return true;
+
+    const int chunk_count_max = get_chunk_count_max(pool_size);
+
+    if (vc->chunks == NULL)
+    {
+        const Memory_category prev_category = memory_set_category(MEMORY_CATEGORY_VOICES);
+        vc->chunks = memory_alloc_items(Voice_chunk, chunk_count_max);
+        memory_set_category(prev_category);
+        if (vc->chunks == NULL)
+            return false;
+    }
+
+    while (vc->chunk_count < chunk_count_max)
+    {
+        if (!Voice_class_add_chunk(vc, wb_size))
+            return false;
+    }
+
+    return true;
+}
+
+
+static void Voice_pool_release_state(Voice_pool* pool, Voice* voice)
+{
+    rassert(pool != NULL);
+    rassert(voice != NULL);
+
+    if (voice->state_class < 0)
+        return;
+
+    Voice_class* vc = &pool->classes[voice->state_class];
+    const int chunk_index = voice->state_index / VOICE_CHUNK_SIZE;
+    const int slot = voice->state_index % VOICE_CHUNK_SIZE;
+    rassert(chunk_index < vc->chunk_count);
+
+    Voice_chunk* chunk = &vc->chunks[chunk_index];
+    rassert((chunk->used_mask & (1 << slot)) != 0);
+    chunk->used_mask &= (uint16_t)~(1 << slot);
+
+    Voice_set_state(voice, NULL);
+    Voice_set_work_buffer(voice, NULL);
+    voice->state_class = -1;
+    voice->state_index = -1;
+
+    return;
+}
+
+
+static bool Voice_pool_bind_state(Voice_pool* pool, Voice* voice, Proc_type proc_type)
+{
+    rassert(pool != NULL);
+    rassert(voice != NULL);
+    rassert(voice->state_class < 0);
+    rassert(proc_type >= 0);
+    rassert(proc_type < Proc_type_COUNT);
+
+    Voice_class* vc = &pool->classes[proc_type];
+    rassert(vc->state_size > 0);
+
+    int chunk_index = 0;
+    while ((chunk_index < vc->chunk_count) &&
+            (vc->chunks[chunk_index].used_mask == UINT16_MAX))
+        ++chunk_index;
+
+    if (chunk_index == vc->chunk_count)
+        return false;
+
+    Voice_chunk* chunk = &vc->chunks[chunk_index];
+    int slot = 0;
+    while ((chunk->used_mask & (1 << slot)) != 0)
+        ++slot;
+    chunk->used_mask |= (uint16_t)(1 << slot);
+
+    Voice_state* state =
+        (Voice_state*)
+#ifdef __GNUC__
+        __builtin_assume_aligned(
+#endif
+        (chunk->states + (vc->state_size * slot))
+#ifdef __GNUC__
+        , VOICE_STATE_ALIGNMENT)
+#endif
+        ;
+
+    voice->state_class = (int)proc_type;
+    voice->state_index = chunk_index * VOICE_CHUNK_SIZE + slot;
+    Voice_set_state(voice, state);
+    Voice_set_work_buffer(
+            voice,
+            (chunk->wbs != NULL)
+                ? Voice_work_buffers_get_buffer_mut(chunk->wbs, slot) : NULL);
+
+    return true;
+}
+
+
+static void Voice_pool_release_voice(Voice_pool* pool, Voice* voice)
+{
+    rassert(pool != NULL);
+    rassert(voice != NULL);
+
+    Voice_pool_release_state(pool, voice);
+
+    rassert(pool->free_voice_count < KQT_VOICES_MAX);
+    pool->free_voices[pool->free_voice_count] = voice;
+    ++pool->free_voice_count;
+
+    return;
+}
+
+
 Voice_pool* new_Voice_pool(int size)
 {
     rassert(size >= 0);
+    rassert(size <= KQT_VOICES_MAX);
 
     Voice_pool* pool = memory_alloc_item(Voice_pool);
     if (pool == NULL)
@@ -75,18 +292,25 @@ Voice_pool* new_Voice_pool(int size)
     pool->atomic_bg_iter_index = 0;
 #endif
 
-    pool->size = size;
-    pool->state_size = 0;
+    pool->size = 0;
+    pool->work_buffer_size = 0;
     pool->new_group_id = 0;
-    pool->voice_state_memory = NULL;
+    pool->voices = NULL;
     pool->free_voice_count = 0;
     pool->bg_iter_index = 0;
     pool->bg_group_count = 0;
-    pool->voice_wbs = NULL;
+
+    for (int i = 0; i < Proc_type_COUNT; ++i)
+    {
+        Voice_class* vc = &pool->classes[i];
+        vc->state_size = 0;
+        vc->uses_work_buffers = false;
+        vc->chunk_count = 0;
+        vc->chunks = NULL;
+    }
 
     for (int i = 0; i < KQT_VOICES_MAX; ++i)
     {
-        Voice_preinit(&pool->voices[i]);
         pool->free_voices[i] = NULL;
         pool->foreground_voices[i] = NULL;
         pool->background_voices[i] = NULL;
@@ -99,84 +323,68 @@ Voice_pool* new_Voice_pool(int size)
         pool->fg_iter_bounds[i].stop = 0;
     }
 
-    pool->voice_wbs = new_Voice_work_buffers();
-    if (pool->voice_wbs == NULL)
+    if (!Voice_pool_set_size(pool, size))
     {
         del_Voice_pool(pool);
         return NULL;
     }
 
-    if (size > 0)
-    {
-        pool->state_size = ((sizeof(Voice_state) - 1) | (VOICE_STATE_ALIGNMENT - 1)) + 1;
-        pool->voice_state_memory = memory_alloc_aligned(
-                pool->state_size * KQT_VOICES_MAX, VOICE_STATE_ALIGNMENT);
-        if (pool->voice_state_memory == NULL)
-        {
-            del_Voice_pool(pool);
-            return NULL;
-        }
-
-        for (int i = 0; i < size; ++i)
-        {
-            Voice_state* state =
-                (Voice_state*)
-#ifdef __GNUC__
-                __builtin_assume_aligned(
-#endif
-                (pool->voice_state_memory + (pool->state_size * i))
-#ifdef __GNUC__
-                , VOICE_STATE_ALIGNMENT)
-#endif
-                ;
-            if (Voice_init(&pool->voices[i], state) == NULL)
-            {
-                del_Voice_pool(pool);
-                return NULL;
-            }
-        }
-
-        for (int i = 0; i < size; ++i)
-            pool->free_voices[i] = &pool->voices[i];
-
-        pool->free_voice_count = size;
-    }
-
     return pool;
 }
 
 
-bool Voice_pool_reserve_state_space(Voice_pool* pool, int32_t state_size)
+bool Voice_pool_set_size(Voice_pool* pool, int size)
 {
     rassert(pool != NULL);
-    rassert(state_size >= 0);
+    rassert(size >= 0);
+    rassert(size <= KQT_VOICES_MAX);
 
-    int32_t actual_state_size = ((state_size - 1) | (VOICE_STATE_ALIGNMENT - 1)) + 1;
-    if (actual_state_size <= pool->state_size)
+    if ((size == pool->size) && (pool->voices != NULL))
         return true;
 
-    char* new_voice_state_memory = memory_alloc_aligned(
-            actual_state_size * KQT_VOICES_MAX, VOICE_STATE_ALIGNMENT);
-    if (new_voice_state_memory == NULL)
-        return false;
+    Voice_pool_reset(pool);
 
-    memory_free_aligned(pool->voice_state_memory);
-    pool->voice_state_memory = new_voice_state_memory;
-    pool->state_size = actual_state_size;
+    // Drop the old Voices and their state storage
+    for (int i = 0; i < pool->free_voice_count; ++i)
+        pool->free_voices[i] = NULL;
+    pool->free_voice_count = 0;
 
     for (int i = 0; i < pool->size; ++i)
+        Voice_deinit(&pool->voices[i]);
+    memory_free(pool->voices);
+    pool->voices = NULL;
+    pool->size = 0;
+
+    for (int i = 0; i < Proc_type_COUNT; ++i)
+        Voice_class_clear(&pool->classes[i]);
+
+    if (size == 0)
+        return true;
+
+    // Create the new Voices
+    const Memory_category prev_category = memory_set_category(MEMORY_CATEGORY_VOICES);
+    pool->voices = memory_alloc_items(Voice, size);
+    memory_set_category(prev_category);
+    if (pool->voices == NULL)
+        return false;
+
+    for (int i = 0; i < size; ++i)
     {
-        Voice_state* state =
-            (Voice_state*)
-#ifdef __GNUC__
-                __builtin_assume_aligned(
-#endif
-            (pool->voice_state_memory + (pool->state_size * i))
-#ifdef __GNUC__
-                , VOICE_STATE_ALIGNMENT)
-#endif
-            ;
-        if (Voice_init(&pool->voices[i], state) == NULL)
+        Voice_preinit(&pool->voices[i]);
+        Voice_init(&pool->voices[i]);
+    }
+
+    pool->size = size;
+
+    for (int i = 0; i < size; ++i)
+        pool->free_voices[i] = &pool->voices[i];
+    pool->free_voice_count = size;
+
+    for (int i = 0; i < Proc_type_COUNT; ++i)
+    {
+        Voice_class* vc = &pool->classes[i];
+        if ((vc->state_size > 0) &&
+                !Voice_class_reserve_chunks(vc, pool->size, pool->work_buffer_size))
             return false;
     }
 
@@ -184,10 +392,42 @@ bool Voice_pool_reserve_state_space(Voice_pool* pool, int32_t state_size)
 }
 
 
+bool Voice_pool_reserve_state_space(
+        Voice_pool* pool,
+        Proc_type proc_type,
+        int32_t state_size,
+        bool use_work_buffers)
+{
+    rassert(pool != NULL);
+    rassert(proc_type >= 0);
+    rassert(proc_type < Proc_type_COUNT);
+    rassert(state_size >= 0);
+
+    Voice_class* vc = &pool->classes[proc_type];
+
+    const int32_t req_state_size = max(state_size, (int32_t)sizeof(Voice_state));
+    const int32_t actual_state_size =
+        ((req_state_size - 1) | (VOICE_STATE_ALIGNMENT - 1)) + 1;
+    if ((actual_state_size > vc->state_size) ||
+            (use_work_buffers && !vc->uses_work_buffers))
+    {
+        // Existing states of the class cannot be moved, so start from scratch
+        if (vc->chunk_count > 0)
+            Voice_pool_reset(pool);
+        Voice_class_clear(vc);
+
+        vc->state_size = max(vc->state_size, actual_state_size);
+        vc->uses_work_buffers = vc->uses_work_buffers || use_work_buffers;
+    }
+
+    return Voice_class_reserve_chunks(vc, pool->size, pool->work_buffer_size);
+}
+
+
 int32_t Voice_pool_get_work_buffer_size(const Voice_pool* pool)
 {
     rassert(pool != NULL);
-    return Voice_work_buffers_get_buffer_size(pool->voice_wbs);
+    return pool->work_buffer_size;
 }
 
 
@@ -197,13 +437,35 @@ bool Voice_pool_reserve_work_buffers(Voice_pool* pool, int32_t buf_size)
     rassert(buf_size >= 0);
     rassert(buf_size <= VOICE_WORK_BUFFER_SIZE_MAX);
 
-    if (!Voice_work_buffers_allocate_space(pool->voice_wbs, pool->size, buf_size))
-        return false;
+    pool->work_buffer_size = buf_size;
+
+    for (int i = 0; i < Proc_type_COUNT; ++i)
+    {
+        const Voice_class* vc = &pool->classes[i];
+        if (!vc->uses_work_buffers)
+            continue;
+
+        for (int ci = 0; ci < vc->chunk_count; ++ci)
+        {
+            if (!Voice_work_buffers_allocate_space(
+                        vc->chunks[ci].wbs, VOICE_CHUNK_SIZE, buf_size))
+                return false;
+        }
+    }
 
     for (int i = 0; i < pool->size; ++i)
     {
+        Voice* voice = &pool->voices[i];
+        if ((voice->state_class < 0) ||
+                !pool->classes[voice->state_class].uses_work_buffers)
+            continue;
+
+        const Voice_class* vc = &pool->classes[voice->state_class];
+        const Voice_chunk* chunk = &vc->chunks[voice->state_index / VOICE_CHUNK_SIZE];
         Voice_set_work_buffer(
-                &pool->voices[i], Voice_work_buffers_get_buffer_mut(pool->voice_wbs, i));
+                voice,
+                Voice_work_buffers_get_buffer_mut(
+                    chunk->wbs, voice->state_index % VOICE_CHUNK_SIZE));
     }
 
     return true;
@@ -225,10 +487,13 @@ uint64_t Voice_pool_new_group_id(Voice_pool* pool)
 }
 
 
-static Voice* try_extract_voice_from_array(Voice* voices[], uint64_t exclude_group_id)
+static Voice* try_extract_voice_from_array(
+        Voice* voices[], uint64_t exclude_group_id, int state_class)
 {
     rassert(voices != NULL);
     rassert(exclude_group_id != 0);
+    rassert(state_class >= -1);
+    rassert(state_class < Proc_type_COUNT);
 
     Voice* selected_voice = NULL;
     int selected_voice_index = 0;
@@ -241,7 +506,8 @@ static Voice* try_extract_voice_from_array(Voice* voices[], uint64_t exclude_gro
             break;
 
         if ((cur_voice->group_id != exclude_group_id) &&
-                (cur_voice->group_id <= selected_group_id))
+                (cur_voice->group_id <= selected_group_id) &&
+                ((state_class < 0) || (cur_voice->state_class == state_class)))
         {
             selected_voice = cur_voice;
             selected_voice_index = i;
@@ -267,14 +533,47 @@ static Voice* try_extract_voice_from_array(Voice* voices[], uint64_t exclude_gro
 }
 
 
+static Voice* Voice_pool_evict_voice(
+        Voice_pool* pool, uint64_t exclude_group_id, int state_class)
+{
+    rassert(pool != NULL);
+    rassert(exclude_group_id != 0);
+    rassert(state_class >= -1);
+    rassert(state_class < Proc_type_COUNT);
+
+    // Try to find an old background voice
+    Voice* voice = try_extract_voice_from_array(
+            pool->background_voices, exclude_group_id, state_class);
+
+    // Get one of the oldest foreground voices as a last resort
+    if (voice == NULL)
+        voice = try_extract_voice_from_array(
+                pool->foreground_voices, exclude_group_id, state_class);
+
+    if (voice == NULL)
+        return NULL;
+
+    Voice_pool_reset_group(pool, voice->group_id);
+    Voice_pool_release_state(pool, voice);
+
+    return voice;
+}
+
+
 Voice* Voice_pool_allocate_voice(
-        Voice_pool* pool, int ch_num, uint64_t group_id, bool is_external)
+        Voice_pool* pool,
+        int ch_num,
+        uint64_t group_id,
+        bool is_external,
+        Proc_type proc_type)
 {
     rassert(pool != NULL);
     rassert(pool->size > 0);
     rassert(ch_num >= 0);
     rassert(ch_num < KQT_CHANNELS_MAX);
     rassert(group_id != 0);
+    rassert(proc_type >= 0);
+    rassert(proc_type < Proc_type_COUNT);
 
     Voice* new_voice = NULL;
 
@@ -288,25 +587,27 @@ Voice* Voice_pool_allocate_voice(
     }
     else
     {
-        // Try to find an old background voice
-        Voice* bg_voice =
-            try_extract_voice_from_array(pool->background_voices, group_id);
+        new_voice = Voice_pool_evict_voice(pool, group_id, -1);
+        if (new_voice == NULL)
+            return NULL;
+    }
 
-        if (bg_voice != NULL)
+    // Steal a state from the oldest Voice of a full storage class
+    if (!Voice_pool_bind_state(pool, new_voice, proc_type))
+    {
+        Voice* evicted_voice = Voice_pool_evict_voice(pool, group_id, (int)proc_type);
+        if (evicted_voice == NULL)
         {
-            Voice_pool_reset_group(pool, bg_voice->group_id);
-            new_voice = bg_voice;
+            Voice_reset(new_voice);
+            Voice_pool_release_voice(pool, new_voice);
+            return NULL;
         }
-        else
-        {
-            // Get one of the oldest foreground voices as a last resort
-            Voice* fg_voice =
-                try_extract_voice_from_array(pool->foreground_voices, group_id);
 
-            rassert(fg_voice != NULL);
-            Voice_pool_reset_group(pool, fg_voice->group_id);
-            new_voice = fg_voice;
-        }
+        Voice_reset(evicted_voice);
+        Voice_pool_release_voice(pool, evicted_voice);
+
+        const bool is_state_bound = Voice_pool_bind_state(pool, new_voice, proc_type);
+        rassert(is_state_bound);
     }
 
     rassert(new_voice != NULL);
@@ -355,10 +656,7 @@ static void reset_voices_in_array(Voice_pool* pool, Voice* voices[], uint64_t gr
             voices[write_pos] = NULL;
 
             Voice_reset(cur_voice);
-
-            rassert(pool->free_voice_count < KQT_VOICES_MAX);
-            pool->free_voices[pool->free_voice_count] = cur_voice;
-            ++pool->free_voice_count;
+            Voice_pool_release_voice(pool, cur_voice);
         }
         else
         {
@@ -713,10 +1011,7 @@ void Voice_pool_clean_up_fg_voices(Voice_pool* pool)
         if (cur_voice->prio == VOICE_PRIO_INACTIVE)
         {
             pool->foreground_voices[write_pos] = NULL;
-
-            rassert(pool->free_voice_count < KQT_VOICES_MAX);
-            pool->free_voices[pool->free_voice_count] = cur_voice;
-            ++pool->free_voice_count;
+            Voice_pool_release_voice(pool, cur_voice);
         }
         else if (cur_voice->prio < VOICE_PRIO_FG)
         {
@@ -768,10 +1063,7 @@ void Voice_pool_finish_group_iteration(Voice_pool* pool)
             if (!cur_voice->updated || (cur_voice->prio == VOICE_PRIO_INACTIVE))
             {
                 pool->background_voices[write_pos] = NULL;
-
-                rassert(pool->free_voice_count < KQT_VOICES_MAX);
-                pool->free_voices[pool->free_voice_count] = cur_voice;
-                ++pool->free_voice_count;
+                Voice_pool_release_voice(pool, cur_voice);
             }
             else
             {
@@ -807,10 +1099,7 @@ void Voice_pool_finish_group_iteration(Voice_pool* pool)
                     (cur_voice->prio == VOICE_PRIO_INACTIVE))
             {
                 pool->foreground_voices[write_pos] = NULL;
-
-                rassert(pool->free_voice_count < KQT_VOICES_MAX);
-                pool->free_voices[pool->free_voice_count] = cur_voice;
-                ++pool->free_voice_count;
+                Voice_pool_release_voice(pool, cur_voice);
             }
             else if (cur_voice->prio < VOICE_PRIO_FG)
             {
@@ -844,12 +1133,137 @@ void Voice_pool_finish_group_iteration(Voice_pool* pool)
 }
 
 
+static double get_voice_force(const Voice* voice)
+{
+    rassert(voice != NULL);
+
+    const Voice_state* vstate = voice->state;
+    if ((vstate == NULL) || (vstate->proc_type != Proc_type_force))
+        return NAN;
+
+    return Force_vstate_get_force(vstate);
+}
+
+
+static void Voice_pool_release_group(Voice_pool* pool, uint64_t group_id)
+{
+    rassert(pool != NULL);
+
+    bool has_force = false;
+
+    for (int i = 0; i < KQT_VOICES_MAX; ++i)
+    {
+        Voice* voice = pool->background_voices[i];
+        if (voice == NULL)
+            break;
+
+        if ((voice->group_id != group_id) || isnan(get_voice_force(voice)))
+            continue;
+
+        Force_vstate_force_release(voice->state);
+        has_force = true;
+    }
+
+    // Without a Force processor there is no way to fade the group out
+    if (!has_force)
+        Voice_pool_reset_group(pool, group_id);
+
+    return;
+}
+
+
+int Voice_pool_release_bg_groups(Voice_pool* pool, double portion)
+{
+    rassert(pool != NULL);
+    rassert(portion >= 0);
+    rassert(portion <= 1);
+
+    // Make the Voices of each group adjacent, oldest group first
+    sort_voice_array(pool->background_voices, cmp_bg_voice);
+
+    uint64_t group_ids[KQT_VOICES_MAX];
+    double group_forces[KQT_VOICES_MAX];
+    bool group_is_releasing[KQT_VOICES_MAX];
+    int group_count = 0;
+
+    for (int i = 0; i < KQT_VOICES_MAX; ++i)
+    {
+        const Voice* voice = pool->background_voices[i];
+        if (voice == NULL)
+            break;
+
+        if ((group_count == 0) || (group_ids[group_count - 1] != voice->group_id))
+        {
+            group_ids[group_count] = voice->group_id;
+            group_forces[group_count] = NAN;
+            group_is_releasing[group_count] = false;
+            ++group_count;
+        }
+
+        // Use the loudest Force in the group, if any
+        const double force = get_voice_force(voice);
+        double* group_force = &group_forces[group_count - 1];
+        if (!isnan(force) && (isnan(*group_force) || (force > *group_force)))
+            *group_force = force;
+
+        if (!isnan(force) && Force_vstate_is_release_forced(voice->state))
+            group_is_releasing[group_count - 1] = true;
+    }
+
+    // Skip groups that are already fading out after an earlier release
+    int candidate_count = 0;
+    for (int i = 0; i < group_count; ++i)
+    {
+        if (group_is_releasing[i])
+            continue;
+
+        group_ids[candidate_count] = group_ids[i];
+        group_forces[candidate_count] = group_forces[i];
+        ++candidate_count;
+    }
+    group_count = candidate_count;
+
+    // Groups without Force information are treated as if playing at full force
+    for (int i = 0; i < group_count; ++i)
+    {
+        if (isnan(group_forces[i]))
+            group_forces[i] = 0;
+    }
+
+    const int release_count = (int)ceil(group_count * portion);
+
+    for (int ri = 0; ri < release_count; ++ri)
+    {
+        // Find the quietest remaining group, preferring the oldest one on ties
+        int selected = -1;
+        for (int i = 0; i < group_count; ++i)
+        {
+            if (group_ids[i] == 0)
+                continue;
+
+            if ((selected < 0) || (group_forces[i] < group_forces[selected]))
+                selected = i;
+        }
+
+        rassert(selected >= 0);
+
+        Voice_pool_release_group(pool, group_ids[selected]);
+        group_ids[selected] = 0;
+    }
+
+    return release_count;
+}
+
+
 void Voice_pool_reset(Voice_pool* pool)
 {
     rassert(pool != NULL);
 
     for (int i = 0; i < pool->size; ++i)
+    {
         Voice_reset(&pool->voices[i]);
+        Voice_pool_release_state(pool, &pool->voices[i]);
+    }
 
     for (int i = 0; i < pool->size; ++i)
         pool->free_voices[i] = &pool->voices[i];
@@ -873,10 +1287,15 @@ void del_Voice_pool(Voice_pool* pool)
         return;
 
     for (int i = 0; i < pool->size; ++i)
+    {
+        Voice_pool_release_state(pool, &pool->voices[i]);
         Voice_deinit(&pool->voices[i]);
+    }
+    memory_free(pool->voices);
+
+    for (int i = 0; i < Proc_type_COUNT; ++i)
+        Voice_class_clear(&pool->classes[i]);
 
-    del_Voice_work_buffers(pool->voice_wbs);
-    memory_free_aligned(pool->voice_state_memory);
     memory_free(pool);
 
     return;
@@ -16,6 +16,7 @@
 #define KQT_VOICE_POOL_H
 
 
+#include <init/devices/Proc_type.h>
 #include <player/Voice.h>
 #include <player/Voice_group.h>
 #include <player/Voice_work_buffers.h>
@@ -26,6 +27,8 @@
 #include <stdlib.h>
 
 
+
+
 /**
  * Voice pool manages the allocation of Voices.
  */
@@ -35,7 +38,8 @@ typedef struct Voice_pool Voice_pool;
 /**
  * Create a new Voice pool.
  *
- * \param size   The number of Voices in the Voice pool -- must be >= \c 0.
+ * \param size   The number of Voices in the Voice pool -- must be >= \c 0 and
+ *               <= \c KQT_VOICES_MAX.
  *
  * \return   The new Voice pool if successful, or \c NULL if memory allocation
  *           failed.
@@ -44,15 +48,41 @@ Voice_pool* new_Voice_pool(int size);
 
 
 /**
- * Reserve space for the Voice states.
+ * Set the number of Voices in the Voice pool.
  *
- * \param pool         The Voice pool -- must not be \c NULL.
- * \param state_size   The amount of bytes to reserve for the Voice states
- *                     -- must be >= \c 0.
+ * This function resets all Voices. Voice state storage is allocated again
+ * for the new size.
+ *
+ * \param pool   The Voice pool -- must not be \c NULL.
+ * \param size   The number of Voices -- must be >= \c 0 and
+ *               <= \c KQT_VOICES_MAX.
  *
  * \return   \c true if successful, or \c false if memory allocation failed.
  */
-bool Voice_pool_reserve_state_space(Voice_pool* pool, int32_t state_size);
+bool Voice_pool_set_size(Voice_pool* pool, int size);
+
+
+/**
+ * Reserve space for the Voice states of a Processor type.
+ *
+ * Voice states of each Processor type are stored separately. This function
+ * reserves states, including Voice work buffers if needed, for all Voices in
+ * the Voice pool. The storage does not grow during playback.
+ *
+ * \param pool               The Voice pool -- must not be \c NULL.
+ * \param proc_type          The Processor type -- must be valid.
+ * \param state_size         The amount of bytes to reserve for each Voice state
+ *                           -- must be >= \c 0.
+ * \param use_work_buffers   \c true if the Voices of \a proc_type need Voice
+ *                           work buffers, otherwise \c false.
+ *
+ * \return   \c true if successful, or \c false if memory allocation failed.
+ */
+bool Voice_pool_reserve_state_space(
+        Voice_pool* pool,
+        Proc_type proc_type,
+        int32_t state_size,
+        bool use_work_buffers);
 
 
 /**
@@ -66,7 +96,7 @@ int32_t Voice_pool_get_work_buffer_size(const Voice_pool* pool);
 
 
 /**
- * Reserve Work buffers for Voices.
+ * Reserve Work buffers for Voices of Processor types that use them.
  *
  * \param pool       The Voice pool -- must not be \c NULL.
  * \param buf_size   The buffer size -- must be >= \c 0 and
@@ -100,9 +130,8 @@ uint64_t Voice_pool_new_group_id(Voice_pool* pool);
 /**
  * Allocate a new Voice from the Voice pool.
  *
- * This function always succeeds. In case all the Voices are in use, an existing
- * Voice group (other than  one of given ID) will be reset and one of its Voices
- * is returned.
+ * In case all the Voices or all the states of \a proc_type are in use, existing
+ * Voice groups (other than the one of given ID) will be reset to make room.
  *
  * \param pool          The Voice pool -- must not be \c NULL.
  * \param ch_num        The number of the channel requesting the Voice -- must be
@@ -110,11 +139,17 @@ uint64_t Voice_pool_new_group_id(Voice_pool* pool);
  * \param group_id      The Voice group ID of the new Voice -- must not be \c 0.
  * \param is_external   \c true if the allocation is used for an externally fired
  *                      event, otherwise \c false.
+ * \param proc_type     The type of the Processor that will use the Voice
+ *                      -- must have state space reserved in the Voice pool.
  *
- * \return   The new Voice.
+ * \return   The new Voice, or \c NULL if no Voice could be made available.
  */
 Voice* Voice_pool_allocate_voice(
-        Voice_pool* pool, int ch_num, uint64_t group_id, bool is_external);
+        Voice_pool* pool,
+        int ch_num,
+        uint64_t group_id,
+        bool is_external,
+        Proc_type proc_type);
 
 
 void Voice_pool_sort_fg_groups(Voice_pool* pool);
@@ -173,6 +208,26 @@ void Voice_pool_clean_up_fg_voices(Voice_pool* pool);
 void Voice_pool_finish_group_iteration(Voice_pool* pool);
 
 
+/**
+ * Release a portion of the background Voice groups to reduce rendering load.
+ *
+ * The groups with the lowest force are released first, and the oldest group
+ * is released first among groups of equal force. Groups that have no Force
+ * processor are treated as if playing at 0 dB. A released group is faded out
+ * with a quick release ramp in its Force processors and it is not released
+ * again while fading out. Groups without a Force processor are reset. This
+ * function must not be called during Voice group iteration.
+ *
+ * \param pool      The Voice pool -- must not be \c NULL.
+ * \param portion   The portion of background groups to release -- must be
+ *                  >= \c 0 and <= \c 1. The number of released groups is
+ *                  rounded up.
+ *
+ * \return   The number of Voice groups released.
+ */
+int Voice_pool_release_bg_groups(Voice_pool* pool, double portion);
+
+
 /**
  * Reset all Voices in the Voice pool.
  *
@@ -29,6 +29,7 @@
 #include <player/Voice.h>
 #include <player/Voice_group.h>
 #include <player/Work_buffer.h>
+#include <player/Work_buffer_sharing.h>
 
 #include <stdbool.h>
 #include <stdint.h>
@@ -53,7 +54,7 @@ typedef struct Voice_signal_task_info
 {
     uint32_t device_id;
     Array* sender_tasks;
-    Array* buf_conns;
+    Array* buf_conns[DEVICE_VOICE_LANES_MAX];
     uint32_t is_connected_to_mixed : 1;
     uint32_t is_processed : 1;
 } Voice_signal_task_info;
@@ -66,27 +67,41 @@ static void Voice_signal_task_info_deinit(Voice_signal_task_info* task_info)
     del_Array(task_info->sender_tasks);
     task_info->sender_tasks = NULL;
 
-    del_Array(task_info->buf_conns);
-    task_info->buf_conns = NULL;
+    for (int lane = 0; lane < DEVICE_VOICE_LANES_MAX; ++lane)
+    {
+        del_Array(task_info->buf_conns[lane]);
+        task_info->buf_conns[lane] = NULL;
+    }
 
     return;
 }
 
 
 static bool Voice_signal_task_info_init(
-        Voice_signal_task_info* task_info, uint32_t device_id)
+        Voice_signal_task_info* task_info, uint32_t device_id, int lane_count)
 {
     rassert(task_info != NULL);
+    rassert(lane_count > 0);
+    rassert(lane_count <= DEVICE_VOICE_LANES_MAX);
 
     task_info->device_id = device_id;
     task_info->is_connected_to_mixed = false;
     task_info->is_processed = false;
 
     task_info->sender_tasks = new_Array(sizeof(Task_index));
-    task_info->buf_conns = new_Array(sizeof(Buffer_connection));
-    if ((task_info->sender_tasks == NULL) || (task_info->buf_conns == NULL))
+    for (int lane = 0; lane < DEVICE_VOICE_LANES_MAX; ++lane)
+        task_info->buf_conns[lane] = NULL;
+
+    if (task_info->sender_tasks == NULL)
         return false;
 
+    for (int lane = 0; lane < lane_count; ++lane)
+    {
+        task_info->buf_conns[lane] = new_Array(sizeof(Buffer_connection));
+        if (task_info->buf_conns[lane] == NULL)
+            return false;
+    }
+
     return true;
 }
 
@@ -113,14 +128,19 @@ static bool Voice_signal_task_info_add_sender_task(
 
 static bool Voice_signal_task_info_add_input(
         Voice_signal_task_info* task_info,
+        int lane,
         Work_buffer* recv_buf,
         const Work_buffer* send_buf)
 {
     rassert(task_info != NULL);
+    rassert(lane >= 0);
+    rassert(lane < DEVICE_VOICE_LANES_MAX);
+    rassert(task_info->buf_conns[lane] != NULL);
     rassert(recv_buf != NULL);
     rassert(send_buf != NULL);
 
-    return Array_append(task_info->buf_conns, MAKE_CONNECTION(recv_buf, send_buf));
+    return Array_append(
+            task_info->buf_conns[lane], MAKE_CONNECTION(recv_buf, send_buf));
 }
 
 
@@ -144,32 +164,41 @@ static void Voice_signal_task_info_invalidate_buffers(
 }
 
 
-static int32_t Voice_signal_task_info_execute(
+static void Voice_signal_task_info_execute(
         Voice_signal_task_info* task_info,
         Array* tasks,
         Device_states* dstates,
         int thread_id,
-        Voice_group* vgroup,
+        Voice_group* vgroups[],
+        int vgroup_count,
         const Work_buffers* wbs,
         int32_t frame_count,
         double tempo,
-        bool* is_task_active)
+        int32_t keep_alive_stops[DEVICE_VOICE_LANES_MAX],
+        bool is_task_active[DEVICE_VOICE_LANES_MAX])
 {
     rassert(task_info != NULL);
     rassert(tasks != NULL);
     rassert(dstates != NULL);
     rassert(thread_id >= 0);
     rassert(thread_id < KQT_THREADS_MAX);
-    rassert(vgroup != NULL);
+    rassert(vgroups != NULL);
+    rassert(vgroup_count > 0);
+    rassert(vgroup_count <= DEVICE_VOICE_LANES_MAX);
     rassert(wbs != NULL);
     rassert(frame_count >= 0);
     rassert(tempo > 0);
+    rassert(keep_alive_stops != NULL);
     rassert(is_task_active != NULL);
 
-    if (task_info->is_processed)
-        return 0;
+    for (int lane = 0; lane < vgroup_count; ++lane)
+    {
+        keep_alive_stops[lane] = 0;
+        is_task_active[lane] = false;
+    }
 
-    int32_t keep_alive_stop = 0;
+    if (task_info->is_processed)
+        return;
 
     // Execute dependencies
     const int64_t sender_count = Array_get_size(task_info->sender_tasks);
@@ -179,70 +208,132 @@ static int32_t Voice_signal_task_info_execute(
         Array_get_copy(task_info->sender_tasks, i, &sender_index);
         Voice_signal_task_info* sender_task_info = Array_get_ref(tasks, sender_index);
 
-        bool is_sender_active = false;
-        const int32_t sender_keep_alive_stop = Voice_signal_task_info_execute(
+        int32_t sender_keep_alive_stops[DEVICE_VOICE_LANES_MAX] = { 0 };
+        bool is_sender_active[DEVICE_VOICE_LANES_MAX] = { false };
+        Voice_signal_task_info_execute(
                 sender_task_info,
                 tasks,
                 dstates,
                 thread_id,
-                vgroup,
+                vgroups,
+                vgroup_count,
                 wbs,
                 frame_count,
                 tempo,
-                &is_sender_active);
+                sender_keep_alive_stops,
+                is_sender_active);
 
-        keep_alive_stop = max(keep_alive_stop, sender_keep_alive_stop);
+        for (int lane = 0; lane < vgroup_count; ++lane)
+            keep_alive_stops[lane] =
+                max(keep_alive_stops[lane], sender_keep_alive_stops[lane]);
     }
 
     // Mix signals to input buffers
-    const int64_t conn_count = Array_get_size(task_info->buf_conns);
-    for (int64_t i = 0; i < conn_count; ++i)
+    for (int lane = 0; lane < vgroup_count; ++lane)
     {
-        const Buffer_connection* conn = Array_get_ref(task_info->buf_conns, i);
-        Work_buffer_mix(conn->receiver, conn->sender, 0, frame_count);
-    }
+        const Array* buf_conns = task_info->buf_conns[lane];
+        rassert(buf_conns != NULL);
 
-    bool active = false;
+        const int64_t conn_count = Array_get_size(buf_conns);
+        for (int64_t i = 0; i < conn_count; ++i)
+        {
+            const Buffer_connection* conn = Array_get_ref(buf_conns, i);
+            Work_buffer_mix(conn->receiver, conn->sender, 0, frame_count);
+        }
+    }
 
     // Process current processor state
     {
-        Voice* voice = NULL;
-        bool call_render = true;
+        Voice* voices[DEVICE_VOICE_LANES_MAX] = { NULL };
+        bool call_render[DEVICE_VOICE_LANES_MAX] = { false };
+        int render_count = 0;
 
         Device_state* dstate = Device_states_get_state(dstates, task_info->device_id);
         const Device_impl* dimpl = dstate->device->dimpl;
         rassert(dimpl != NULL);
 
         const Proc_state* proc_state = (Proc_state*)dstate;
+        const bool needs_vstate = Proc_state_needs_vstate(proc_state);
 
-        if (Proc_state_needs_vstate(proc_state))
+        for (int lane = 0; lane < vgroup_count; ++lane)
         {
-            voice = Voice_group_get_voice_by_proc(vgroup, task_info->device_id);
-            call_render = (voice != NULL) && (voice->prio != VOICE_PRIO_INACTIVE);
+            call_render[lane] = true;
+
+            if (needs_vstate)
+            {
+                voices[lane] =
+                    Voice_group_get_voice_by_proc(vgroups[lane], task_info->device_id);
+                call_render[lane] =
+                    (voices[lane] != NULL) && (voices[lane]->prio != VOICE_PRIO_INACTIVE);
+            }
+
+            if (call_render[lane])
+                ++render_count;
         }
 
-        if (call_render)
+        if (needs_vstate && (render_count > 1) && (dimpl->render_voices != NULL))
         {
-            const int32_t voice_keep_alive_stop = Voice_render(
-                    voice,
+            Voice* batch_voices[DEVICE_VOICE_LANES_MAX] = { NULL };
+            for (int lane = 0; lane < vgroup_count; ++lane)
+            {
+                if (call_render[lane])
+                    batch_voices[lane] = voices[lane];
+            }
+
+            int32_t voice_keep_alive_stops[DEVICE_VOICE_LANES_MAX] = { 0 };
+            Voice_render_batch(
+                    batch_voices,
                     task_info->device_id,
                     dstates,
                     thread_id,
                     wbs,
                     frame_count,
-                    tempo);
+                    tempo,
+                    voice_keep_alive_stops);
+
+            for (int lane = 0; lane < vgroup_count; ++lane)
+            {
+                if (call_render[lane])
+                {
+                    keep_alive_stops[lane] =
+                        max(keep_alive_stops[lane], voice_keep_alive_stops[lane]);
+                    is_task_active[lane] = true;
+                }
+            }
+        }
+        else if (render_count > 0)
+        {
+            Device_thread_state* proc_ts = Device_states_get_thread_state(
+                    dstates, thread_id, task_info->device_id);
+
+            for (int lane = 0; lane < vgroup_count; ++lane)
+            {
+                if (!call_render[lane])
+                    continue;
+
+                Device_thread_state_set_voice_lane(proc_ts, lane);
 
-            keep_alive_stop = max(keep_alive_stop, voice_keep_alive_stop);
+                const int32_t voice_keep_alive_stop = Voice_render(
+                        voices[lane],
+                        task_info->device_id,
+                        dstates,
+                        thread_id,
+                        wbs,
+                        frame_count,
+                        tempo);
 
-            active = true;
+                keep_alive_stops[lane] =
+                    max(keep_alive_stops[lane], voice_keep_alive_stop);
+                is_task_active[lane] = true;
+            }
+
+            Device_thread_state_set_voice_lane(proc_ts, 0);
         }
     }
 
-    *is_task_active = active;
-
     task_info->is_processed = true;
 
-    return keep_alive_stop;
+    return;
 }
 
 
@@ -250,6 +341,7 @@ static void Voice_signal_task_info_mix(
         const Voice_signal_task_info* task_info,
         Device_states* dstates,
         int thread_id,
+        int lane,
         int32_t keep_alive_stop,
         int32_t frame_offset,
         int32_t frame_count)
@@ -258,6 +350,8 @@ static void Voice_signal_task_info_mix(
     rassert(dstates != NULL);
     rassert(thread_id >= 0);
     rassert(thread_id < KQT_THREADS_MAX);
+    rassert(lane >= 0);
+    rassert(lane < DEVICE_VOICE_LANES_MAX);
     rassert(frame_offset >= 0);
     rassert(frame_count >= 0);
 
@@ -265,18 +359,28 @@ static void Voice_signal_task_info_mix(
     {
         Device_thread_state* dev_ts =
             Device_states_get_thread_state(dstates, thread_id, task_info->device_id);
+        Device_thread_state_set_voice_lane(dev_ts, lane);
         Device_thread_state_mix_voice_signals(
                 dev_ts, 0, keep_alive_stop, frame_offset, frame_count);
+        Device_thread_state_set_voice_lane(dev_ts, 0);
     }
 
     return;
 }
 
 
+/*
+ * Voice buffers that are never in use at the same time during the plan
+ * execution share contents so that the working set of the plan stays small.
+ * Each binding makes a Work buffer borrow the contents of a lender that
+ * belongs to another Device in the same thread and voice lane.
+ */
 struct Voice_signal_plan
 {
+    int lane_count;
     Array* roots;
     Array* tasks[KQT_THREADS_MAX];
+    Array* bindings[KQT_THREADS_MAX];
 };
 
 
@@ -339,13 +443,17 @@ static bool Voice_signal_plan_build_from_node(
         rassert(Array_get_size(tasks) <= (int64_t)UINT16_MAX);
         cur_task_index = (Task_index)Array_get_size(tasks);
 
-        if (!Voice_signal_task_info_init(&new_task_info, node_device_id) ||
+        if (!Voice_signal_task_info_init(
+                    &new_task_info, node_device_id, plan->lane_count) ||
                 !Array_append(tasks, &new_task_info))
         {
             Voice_signal_task_info_deinit(&new_task_info);
             return false;
         }
 
+        if (!Device_thread_state_add_voice_lanes(recv_ts, plan->lane_count))
+            return false;
+
         Voice_signal_task_info* task_info = Array_get_ref(tasks, cur_task_index);
         task_info->is_connected_to_mixed = is_parent_mixed;
     }
@@ -392,22 +500,34 @@ static bool Voice_signal_plan_build_from_node(
                         dstates, thread_id, Device_get_id(send_device));
                 rassert(send_ts != NULL);
 
-                const Work_buffer* send_buf = Device_thread_state_get_voice_buffer(
-                        send_ts, DEVICE_PORT_TYPE_SEND, edge->port);
-                Work_buffer* recv_buf = Device_thread_state_get_voice_buffer(
-                        recv_ts, DEVICE_PORT_TYPE_RECV, port);
+                Voice_signal_task_info* task_info = Array_get_ref(tasks, cur_task_index);
+                bool is_sender_connected = false;
 
-                if ((send_buf != NULL) && (recv_buf != NULL) && (sender_task_index >= 0))
+                for (int lane = 0; lane < plan->lane_count; ++lane)
                 {
-                    Voice_signal_task_info* task_info =
-                        Array_get_ref(tasks, cur_task_index);
-                    if (!Voice_signal_task_info_add_sender_task(
-                                task_info, sender_task_index))
-                        return false;
-
-                    if (!Voice_signal_task_info_add_input(task_info, recv_buf, send_buf))
-                        return false;
+                    const Work_buffer* send_buf =
+                        Device_thread_state_get_voice_lane_buffer(
+                                send_ts, lane, DEVICE_PORT_TYPE_SEND, edge->port);
+                    Work_buffer* recv_buf = Device_thread_state_get_voice_lane_buffer(
+                            recv_ts, lane, DEVICE_PORT_TYPE_RECV, port);
+
+                    if ((send_buf != NULL) &&
+                            (recv_buf != NULL) &&
+                            (sender_task_index >= 0))
+                    {
+                        if (!Voice_signal_task_info_add_input(
+                                    task_info, lane, recv_buf, send_buf))
+                            return false;
+
+                        is_sender_connected = true;
+                    }
                 }
+
+                // The sender task is shared by all lanes
+                if (is_sender_connected &&
+                        !Voice_signal_task_info_add_sender_task(
+                            task_info, sender_task_index))
+                    return false;
             }
 
             edge = edge->next;
@@ -446,6 +566,210 @@ static bool Voice_signal_plan_build(
 }
 
 
+static void Voice_signal_plan_order_task(
+        const Array* tasks, Task_index task_index, int32_t* steps, int32_t* next_step)
+{
+    rassert(tasks != NULL);
+    rassert(task_index >= 0);
+    rassert(steps != NULL);
+    rassert(next_step != NULL);
+
+    if (steps[task_index] >= 0)
+        return;
+
+    // Follow the traversal order of Voice_signal_task_info_execute
+    const Voice_signal_task_info* task_info = Array_get_ref(tasks, task_index);
+    const int64_t sender_count = Array_get_size(task_info->sender_tasks);
+    for (int64_t i = 0; i < sender_count; ++i)
+    {
+        Task_index sender_index = -1;
+        Array_get_copy(task_info->sender_tasks, i, &sender_index);
+        Voice_signal_plan_order_task(tasks, sender_index, steps, next_step);
+    }
+
+    steps[task_index] = *next_step;
+    ++*next_step;
+
+    return;
+}
+
+
+static bool Voice_signal_plan_share_lane_buffers(
+        Voice_signal_plan* plan,
+        Device_states* dstates,
+        int thread_id,
+        int lane,
+        const int32_t* steps)
+{
+    rassert(plan != NULL);
+    rassert(dstates != NULL);
+    rassert(thread_id >= 0);
+    rassert(thread_id < KQT_THREADS_MAX);
+    rassert(lane >= 0);
+    rassert(lane < plan->lane_count);
+    rassert(steps != NULL);
+
+    const Array* tasks = plan->tasks[thread_id];
+    const int64_t task_count = Array_get_size(tasks);
+
+    Work_buffer_sharing* sharing = new_Work_buffer_sharing();
+    if (sharing == NULL)
+        return false;
+
+    // Find the steps where the voice buffers of executed tasks are in use
+    for (int64_t i = 0; i < task_count; ++i)
+    {
+        const int32_t step = steps[i];
+        if (step < 0)
+            continue;
+
+        const Voice_signal_task_info* task_info = Array_get_ref(tasks, i);
+        const Device_thread_state* ts =
+            Device_states_get_thread_state(dstates, thread_id, task_info->device_id);
+
+        for (Device_port_type port_type = DEVICE_PORT_TYPE_RECV;
+                port_type < DEVICE_PORT_TYPES; ++port_type)
+        {
+            for (int port = 0; port < KQT_DEVICE_PORTS_MAX; ++port)
+            {
+                Work_buffer* buffer = Device_thread_state_get_voice_lane_buffer(
+                        ts, lane, port_type, port);
+                if (buffer == NULL)
+                    continue;
+
+                // Outputs mixed to mixed signals are read after all tasks,
+                // and the Player reads test output from the main outputs of
+                // lane 0 after the plan execution
+                const bool is_read_after = (port_type == DEVICE_PORT_TYPE_SEND) &&
+                    (task_info->is_connected_to_mixed || ((lane == 0) && (port < 2)));
+
+                if (!Work_buffer_sharing_add_use(
+                            sharing,
+                            buffer,
+                            step,
+                            is_read_after ? WORK_BUFFER_STEP_AFTER : step))
+                {
+                    del_Work_buffer_sharing(sharing);
+                    return false;
+                }
+            }
+        }
+    }
+
+    // Outputs stay in use until the last receiver has read them
+    for (int64_t i = 0; i < task_count; ++i)
+    {
+        const int32_t step = steps[i];
+        if (step < 0)
+            continue;
+
+        const Voice_signal_task_info* task_info = Array_get_ref(tasks, i);
+        const Array* buf_conns = task_info->buf_conns[lane];
+        const int64_t conn_count = Array_get_size(buf_conns);
+        for (int64_t ci = 0; ci < conn_count; ++ci)
+        {
+            const Buffer_connection* conn = Array_get_ref(buf_conns, ci);
+            Work_buffer_sharing_extend_use(sharing, conn->sender, step);
+        }
+    }
+
+    const bool success =
+        Work_buffer_sharing_get_bindings(sharing, plan->bindings[thread_id]);
+    del_Work_buffer_sharing(sharing);
+
+    return success;
+}
+
+
+static bool Voice_signal_plan_share_buffers(
+        Voice_signal_plan* plan, Device_states* dstates, int thread_id)
+{
+    rassert(plan != NULL);
+    rassert(dstates != NULL);
+    rassert(thread_id >= 0);
+    rassert(thread_id < KQT_THREADS_MAX);
+
+    const Array* tasks = plan->tasks[thread_id];
+    rassert(tasks != NULL);
+    rassert(plan->bindings[thread_id] != NULL);
+
+    const int64_t task_count = Array_get_size(tasks);
+    if (task_count == 0)
+        return true;
+
+    int32_t* steps = memory_alloc_items(int32_t, task_count);
+    if (steps == NULL)
+        return false;
+
+    for (int64_t i = 0; i < task_count; ++i)
+        steps[i] = -1;
+
+    int32_t next_step = 0;
+    const int64_t root_count = Array_get_size(plan->roots);
+    for (int64_t i = 0; i < root_count; ++i)
+    {
+        Task_index root_index = -1;
+        Array_get_copy(plan->roots, i, &root_index);
+        Voice_signal_plan_order_task(tasks, root_index, steps, &next_step);
+    }
+
+    for (int lane = 0; lane < plan->lane_count; ++lane)
+    {
+        if (!Voice_signal_plan_share_lane_buffers(plan, dstates, thread_id, lane, steps))
+        {
+            memory_free(steps);
+            return false;
+        }
+    }
+
+    memory_free(steps);
+
+    return true;
+}
+
+
+static void Voice_signal_plan_clear_tasks(Voice_signal_plan* plan, int thread_id)
+{
+    rassert(plan != NULL);
+    rassert(thread_id >= 0);
+    rassert(thread_id < KQT_THREADS_MAX);
+
+    Array* tasks = plan->tasks[thread_id];
+    rassert(tasks != NULL);
+
+    for (int i = 0; i < Array_get_size(tasks); ++i)
+        Voice_signal_task_info_deinit(Array_get_ref(tasks, i));
+
+    Array_clear(tasks);
+
+    return;
+}
+
+
+static bool Voice_signal_plan_has_batch_tasks(
+        const Voice_signal_plan* plan, const Device_states* dstates)
+{
+    rassert(plan != NULL);
+    rassert(dstates != NULL);
+
+    const Array* tasks = plan->tasks[0];
+    rassert(tasks != NULL);
+
+    const int64_t task_count = Array_get_size(tasks);
+    for (int64_t i = 0; i < task_count; ++i)
+    {
+        const Voice_signal_task_info* task_info = Array_get_ref(tasks, i);
+        const Device_state* dstate =
+            Device_states_get_state(dstates, task_info->device_id);
+        const Device_impl* dimpl = dstate->device->dimpl;
+        if ((dimpl != NULL) && (dimpl->render_voices != NULL))
+            return true;
+    }
+
+    return false;
+}
+
+
 Voice_signal_plan* new_Voice_signal_plan(
         Device_states* dstates, int thread_count, const Connections* conns)
 {
@@ -458,9 +782,13 @@ Voice_signal_plan* new_Voice_signal_plan(
     if (plan == NULL)
         return NULL;
 
+    plan->lane_count = 1;
     plan->roots = NULL;
     for (int i = 0; i < KQT_THREADS_MAX; ++i)
+    {
         plan->tasks[i] = NULL;
+        plan->bindings[i] = NULL;
+    }
 
     plan->roots = new_Array(sizeof(Task_index));
     if (plan->roots == NULL)
@@ -478,6 +806,18 @@ Voice_signal_plan* new_Voice_signal_plan(
             del_Voice_signal_plan(plan);
             return NULL;
         }
+
+        // Rebuild with voice buffer lanes if any of our processors render batches
+        if ((thread_id == 0) && Voice_signal_plan_has_batch_tasks(plan, dstates))
+        {
+            Voice_signal_plan_clear_tasks(plan, thread_id);
+            plan->lane_count = DEVICE_VOICE_LANES_MAX;
+            if (!Voice_signal_plan_build(plan, dstates, thread_id, conns))
+            {
+                del_Voice_signal_plan(plan);
+                return NULL;
+            }
+        }
     }
 
     const int64_t task_count = Array_get_size(plan->tasks[0]);
@@ -495,6 +835,17 @@ Voice_signal_plan* new_Voice_signal_plan(
         }
     }
 
+    for (int thread_id = 0; thread_id < thread_count; ++thread_id)
+    {
+        plan->bindings[thread_id] = new_Array(sizeof(Work_buffer_binding));
+        if ((plan->bindings[thread_id] == NULL) ||
+                !Voice_signal_plan_share_buffers(plan, dstates, thread_id))
+        {
+            del_Voice_signal_plan(plan);
+            return NULL;
+        }
+    }
+
     for (int64_t i = 0; i < task_count; ++i)
     {
         const Voice_signal_task_info* task_info = Array_get_ref(plan->tasks[0], i);
@@ -507,33 +858,60 @@ Voice_signal_plan* new_Voice_signal_plan(
 }
 
 
-int32_t Voice_signal_plan_execute(
+void Voice_signal_plan_bind_buffers(const Voice_signal_plan* plan)
+{
+    rassert(plan != NULL);
+
+    for (int thread_id = 0; thread_id < KQT_THREADS_MAX; ++thread_id)
+    {
+        if (plan->bindings[thread_id] != NULL)
+            Work_buffer_bindings_apply(plan->bindings[thread_id]);
+    }
+
+    return;
+}
+
+
+int Voice_signal_plan_get_batch_size_max(const Voice_signal_plan* plan)
+{
+    rassert(plan != NULL);
+    return plan->lane_count;
+}
+
+
+void Voice_signal_plan_execute_batch(
         Voice_signal_plan* plan,
         Device_states* dstates,
         int thread_id,
-        Voice_group* vgroup,
+        Voice_group* vgroups[],
+        int vgroup_count,
         const Work_buffers* wbs,
         int32_t frame_count,
         int32_t frame_offset,
         int32_t total_frame_count,
         double tempo,
-        bool enable_mixing)
+        const bool enable_mixing[],
+        int32_t process_stops[])
 {
     rassert(plan != NULL);
     rassert(dstates != NULL);
     rassert(thread_id >= 0);
     rassert(thread_id < KQT_THREADS_MAX);
-    rassert(vgroup != NULL);
+    rassert(vgroups != NULL);
+    rassert(vgroup_count > 0);
+    rassert(vgroup_count <= plan->lane_count);
     rassert(wbs != NULL);
     rassert(frame_count >= 0);
     rassert(frame_offset >= 0);
     rassert(total_frame_count >= frame_count);
     rassert(frame_count + frame_offset <= total_frame_count);
     rassert(tempo > 0);
+    rassert(enable_mixing != NULL);
+    rassert(process_stops != NULL);
 
-    int32_t keep_alive_stop = 0;
+    int32_t keep_alive_stops[DEVICE_VOICE_LANES_MAX] = { 0 };
 
-    bool any_active_tasks_connected_to_mixed = false;
+    bool any_active_tasks_connected_to_mixed[DEVICE_VOICE_LANES_MAX] = { false };
 
     Array* tasks = plan->tasks[thread_id];
     rassert(tasks != NULL);
@@ -555,47 +933,97 @@ int32_t Voice_signal_plan_execute(
 
         Voice_signal_task_info* task_info = Array_get_ref(tasks, root_index);
 
-        bool is_task_active = false;
+        int32_t task_keep_alive_stops[DEVICE_VOICE_LANES_MAX] = { 0 };
+        bool is_task_active[DEVICE_VOICE_LANES_MAX] = { false };
 
-        const int32_t task_keep_alive_stop = Voice_signal_task_info_execute(
+        Voice_signal_task_info_execute(
                 task_info,
                 tasks,
                 dstates,
                 thread_id,
-                vgroup,
+                vgroups,
+                vgroup_count,
                 wbs,
                 frame_count,
                 tempo,
-                &is_task_active);
+                task_keep_alive_stops,
+                is_task_active);
 
-        if (is_task_active)
-            any_active_tasks_connected_to_mixed = true;
+        for (int lane = 0; lane < vgroup_count; ++lane)
+        {
+            if (is_task_active[lane])
+                any_active_tasks_connected_to_mixed[lane] = true;
 
-        keep_alive_stop = max(keep_alive_stop, task_keep_alive_stop);
+            keep_alive_stops[lane] =
+                max(keep_alive_stops[lane], task_keep_alive_stops[lane]);
+        }
     }
 
-    if (enable_mixing)
+    for (int lane = 0; lane < vgroup_count; ++lane)
     {
-        for (int64_t i = 0; i < root_count; ++i)
+        if (enable_mixing[lane])
         {
-            Task_index root_index = -1;
-            Array_get_copy(plan->roots, i, &root_index);
+            for (int64_t i = 0; i < root_count; ++i)
+            {
+                Task_index root_index = -1;
+                Array_get_copy(plan->roots, i, &root_index);
 
-            Voice_signal_task_info* task_info = Array_get_ref(tasks, root_index);
-            Voice_signal_task_info_mix(
-                    task_info,
-                    dstates,
-                    thread_id,
-                    keep_alive_stop,
-                    frame_offset,
-                    total_frame_count);
+                Voice_signal_task_info* task_info = Array_get_ref(tasks, root_index);
+                Voice_signal_task_info_mix(
+                        task_info,
+                        dstates,
+                        thread_id,
+                        lane,
+                        keep_alive_stops[lane],
+                        frame_offset,
+                        total_frame_count);
+            }
         }
+
+        if (!any_active_tasks_connected_to_mixed[lane])
+            Voice_group_deactivate_all(vgroups[lane]);
+
+        process_stops[lane] = keep_alive_stops[lane];
     }
 
-    if (!any_active_tasks_connected_to_mixed)
-        Voice_group_deactivate_all(vgroup);
+    return;
+}
+
+
+int32_t Voice_signal_plan_execute(
+        Voice_signal_plan* plan,
+        Device_states* dstates,
+        int thread_id,
+        Voice_group* vgroup,
+        const Work_buffers* wbs,
+        int32_t frame_count,
+        int32_t frame_offset,
+        int32_t total_frame_count,
+        double tempo,
+        bool enable_mixing)
+{
+    rassert(plan != NULL);
+    rassert(vgroup != NULL);
 
-    return keep_alive_stop;
+    Voice_group* vgroups[] = { vgroup };
+    const bool enable_mixings[] = { enable_mixing };
+    int32_t process_stops[] = { 0 };
+
+    Voice_signal_plan_execute_batch(
+            plan,
+            dstates,
+            thread_id,
+            vgroups,
+            1,
+            wbs,
+            frame_count,
+            frame_offset,
+            total_frame_count,
+            tempo,
+            enable_mixings,
+            process_stops);
+
+    return process_stops[0];
 }
 
 
@@ -608,12 +1036,11 @@ void del_Voice_signal_plan(Voice_signal_plan* plan)
     {
         if (plan->tasks[thread_id] != NULL)
         {
-            Array* tasks = plan->tasks[thread_id];
-            for (int i = 0; i < Array_get_size(tasks); ++i)
-                Voice_signal_task_info_deinit(Array_get_ref(tasks, i));
-
+            Voice_signal_plan_clear_tasks(plan, thread_id);
             del_Array(plan->tasks[thread_id]);
         }
+
+        del_Array(plan->bindings[thread_id]);
     }
 
     del_Array(plan->roots);
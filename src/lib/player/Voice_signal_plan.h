@@ -37,6 +37,72 @@ Voice_signal_plan* new_Voice_signal_plan(
         Device_states* dstates, int thread_count, const Connections* conns);
 
 
+/**
+ * Make the voice buffers of the Voice signal plan share their contents.
+ *
+ * The Work buffers of the Device states must not be shared by other plans
+ * when this is called, see \a Device_states_restore_buffers.
+ *
+ * \param plan   The Voice signal plan -- must not be \c NULL.
+ */
+void Voice_signal_plan_bind_buffers(const Voice_signal_plan* plan);
+
+
+/**
+ * Get the maximum number of Voice groups that can be rendered as one batch.
+ *
+ * \param plan   The Voice signal plan -- must not be \c NULL.
+ *
+ * \return   The maximum batch size. This is \c 1 if none of the Processors
+ *           in \a plan support batch rendering.
+ */
+int Voice_signal_plan_get_batch_size_max(const Voice_signal_plan* plan);
+
+
+/**
+ * Execute the Voice signal plan for a batch of Voice groups.
+ *
+ * Processors that support batch rendering process the Voices of all the
+ * Voice groups together, other Processors process the Voice groups one at a
+ * time. The Voice signals of each Voice group are mixed in the order of
+ * \a vgroups.
+ *
+ * \param plan                The Voice signal plan -- must not be \c NULL.
+ * \param dstates             The Device states -- must not be \c NULL.
+ * \param thread_id           The ID of the rendering thread -- must be valid.
+ * \param vgroups             The Voice groups -- must not be \c NULL.
+ * \param vgroup_count        The number of Voice groups -- must be > \c 0 and
+ *                            <= \a Voice_signal_plan_get_batch_size_max(plan).
+ * \param wbs                 The Work buffers -- must not be \c NULL.
+ * \param frame_count         Number of frames to be processed
+ *                            -- must be >= \c 0 and not greater than the buffer size.
+ * \param frame_offset        Frame offset for mixed destination buffer -- must be
+ *                            > \c 0.
+ * \param total_frame_count   Total number of frames to be processed for the ongoing
+ *                            mixing cycle -- must be >= \a frame_count.
+ * \param tempo               The current tempo -- must be > \c 0.
+ * \param enable_mixing       For each Voice group, \c true if voice signals should
+ *                            be added to mixed outputs, otherwise \c false
+ *                            -- must not be \c NULL.
+ * \param process_stops       Destination for the stop index of each Voice group
+ *                            -- must not be \c NULL. See
+ *                            \a Voice_signal_plan_execute for details.
+ */
+void Voice_signal_plan_execute_batch(
+        Voice_signal_plan* plan,
+        Device_states* dstates,
+        int thread_id,
+        Voice_group* vgroups[],
+        int vgroup_count,
+        const Work_buffers* wbs,
+        int32_t frame_count,
+        int32_t frame_offset,
+        int32_t total_frame_count,
+        double tempo,
+        const bool enable_mixing[],
+        int32_t process_stops[]);
+
+
 /**
  * Execute the Voice signal plan.
  *
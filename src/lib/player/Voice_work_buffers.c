@@ -88,9 +88,15 @@ bool Voice_work_buffers_allocate_space(
         (req_min_buf_size + (elems_alignment - 1)) & ~(elems_alignment - 1);
 
     // Allocate memory
+    const Memory_category prev_category =
+        memory_set_category(MEMORY_CATEGORY_WORK_BUFFERS);
+
     Work_buffer* new_wbs = memory_alloc_items(Work_buffer, count);
     if (new_wbs == NULL)
+    {
+        memory_set_category(prev_category);
         return false;
+    }
 
     memory_free(wbs->wbs);
     wbs->wbs = new_wbs;
@@ -100,6 +106,7 @@ bool Voice_work_buffers_allocate_space(
     const int32_t total_space_size = count * actual_buf_size;
     void* new_space =
         memory_alloc_items_aligned(float, total_space_size, contents_alignment);
+    memory_set_category(prev_category);
     if (new_space == NULL)
         return false;
     memory_free_aligned(wbs->space);
@@ -32,6 +32,30 @@ static_assert(sizeof(int32_t) <= WORK_BUFFER_ELEM_SIZE,
 #define MARGIN_ELEM_COUNT 3
 
 
+static void* alloc_contents(int32_t size)
+{
+    rassert(size > 0);
+
+    const int32_t actual_size = size + MARGIN_ELEM_COUNT;
+    const Memory_category prev_category =
+        memory_set_category(MEMORY_CATEGORY_WORK_BUFFERS);
+    char* contents =
+        memory_alloc_items_aligned(char, actual_size * WORK_BUFFER_ELEM_SIZE, 64);
+    memory_set_category(prev_category);
+
+    return contents;
+}
+
+
+// Borrowed contents are looked up through the lender so that they stay
+// correct when the lender is resized
+static void* get_data(const Work_buffer* buffer)
+{
+    rassert(buffer != NULL);
+    return (buffer->lender != NULL) ? buffer->lender->contents : buffer->contents;
+}
+
+
 Work_buffer* new_Work_buffer(int32_t size)
 {
     rassert(size > 0);
@@ -47,11 +71,11 @@ Work_buffer* new_Work_buffer(int32_t size)
     buffer->const_start = 0;
     buffer->is_final = true;
     buffer->contents = NULL;
+    buffer->lender = NULL;
 
     // Allocate buffers
     const int32_t actual_size = size + MARGIN_ELEM_COUNT;
-    buffer->contents =
-        memory_alloc_items_aligned(char, actual_size * WORK_BUFFER_ELEM_SIZE, 64);
+    buffer->contents = alloc_contents(size);
     if (buffer->contents == NULL)
     {
         del_Work_buffer(buffer);
@@ -79,6 +103,7 @@ void Work_buffer_init_with_memory(
     buffer->const_start = 0;
     buffer->is_final = true;
     buffer->contents = space;
+    buffer->lender = NULL;
 
     Work_buffer_clear(buffer, 0, Work_buffer_get_size(buffer) + MARGIN_ELEM_COUNT);
 
@@ -86,6 +111,44 @@ void Work_buffer_init_with_memory(
 }
 
 
+void Work_buffer_borrow_contents(Work_buffer* buffer, const Work_buffer* lender)
+{
+    rassert(buffer != NULL);
+    rassert(buffer->lender == NULL);
+    rassert(lender != NULL);
+    rassert(lender != buffer);
+    rassert(lender->lender == NULL);
+    rassert(buffer->size == lender->size);
+
+    memory_free_aligned(buffer->contents);
+    buffer->contents = NULL;
+    buffer->lender = lender;
+
+    return;
+}
+
+
+bool Work_buffer_restore_contents(Work_buffer* buffer)
+{
+    rassert(buffer != NULL);
+
+    if (buffer->lender == NULL)
+        return true;
+
+    void* contents = alloc_contents(buffer->size);
+    if (contents == NULL)
+        return false;
+
+    buffer->contents = contents;
+    buffer->lender = NULL;
+
+    Work_buffer_clear(buffer, 0, buffer->size + MARGIN_ELEM_COUNT);
+    Work_buffer_invalidate(buffer);
+
+    return true;
+}
+
+
 void Work_buffer_invalidate(Work_buffer* buffer)
 {
     rassert(buffer != NULL);
@@ -93,7 +156,7 @@ void Work_buffer_invalidate(Work_buffer* buffer)
     buffer->is_valid = false;
 
 #ifdef ENABLE_DEBUG_ASSERTS
-    float* data = buffer->contents;
+    float* data = get_data(buffer);
     for (int i = 0; i < buffer->size; ++i)
         *data++ = NAN;
 #endif
@@ -122,17 +185,18 @@ bool Work_buffer_resize(Work_buffer* buffer, int32_t new_size)
     rassert(new_size > 0);
     rassert(new_size <= WORK_BUFFER_SIZE_MAX);
 
-    const int32_t actual_size = new_size + MARGIN_ELEM_COUNT;
-    char* new_contents =
-        memory_alloc_items_aligned(char, actual_size * WORK_BUFFER_ELEM_SIZE, 64);
-    if (new_contents == NULL)
-        return false;
+    // Borrowed contents are resized by the lender
+    if (buffer->lender == NULL)
+    {
+        void* new_contents = alloc_contents(new_size);
+        if (new_contents == NULL)
+            return false;
 
-    memory_free_aligned(buffer->contents);
-    buffer->contents = NULL;
+        memory_free_aligned(buffer->contents);
+        buffer->contents = new_contents;
+    }
 
     buffer->size = new_size;
-    buffer->contents = new_contents;
 
     buffer->is_valid = false;
     Work_buffer_clear_const_start(buffer);
@@ -174,7 +238,7 @@ const float* Work_buffer_get_contents(const Work_buffer* buffer)
     rassert(buffer != NULL);
     rassert(Work_buffer_is_valid(buffer));
 
-    return (float*)buffer->contents;
+    return (float*)get_data(buffer);
 }
 
 
@@ -186,7 +250,7 @@ float* Work_buffer_get_contents_mut(Work_buffer* buffer)
     Work_buffer_clear_const_start(buffer);
     Work_buffer_set_final(buffer, false);
 
-    return (float*)buffer->contents;
+    return (float*)get_data(buffer);
 }
 
 
@@ -198,7 +262,7 @@ int32_t* Work_buffer_get_contents_int_mut(Work_buffer* buffer)
     Work_buffer_clear_const_start(buffer);
     Work_buffer_set_final(buffer, false);
 
-    return (int32_t*)buffer->contents;
+    return (int32_t*)get_data(buffer);
 }
 
 
@@ -222,8 +286,8 @@ void Work_buffer_copy(
     if (!Work_buffer_is_valid(src))
         return;
 
-    float* dest_pos = (float*)dest->contents + buf_start;
-    const float* src_pos = (const float*)src->contents + buf_start;
+    float* dest_pos = (float*)get_data(dest) + buf_start;
+    const float* src_pos = (const float*)get_data(src) + buf_start;
 
     const int32_t elem_count = buf_stop - buf_start;
     for (int32_t i = 0; i < elem_count; ++i)
@@ -315,7 +379,7 @@ void Work_buffer_mix(
     const bool in_has_final_value =
         Work_buffer_is_final(src) && (src_const_start < buf_stop);
 
-    float* dest_contents = (float*)dest->contents;
+    float* dest_contents = (float*)get_data(dest);
     const float* src_contents = Work_buffer_get_contents(src);
 
     const bool buffer_has_neg_inf_final_value =
@@ -381,7 +445,7 @@ void Work_buffer_mix_shifted(
     const int32_t shifted_src_const_start = (src_const_start < INT32_MAX - dest_offset)
         ? src_const_start + dest_offset : src_const_start;
 
-    float* dest_contents = (float*)dest->contents + dest_offset;
+    float* dest_contents = (float*)get_data(dest) + dest_offset;
     const float* src_contents = Work_buffer_get_contents(src);
 
     if (!Work_buffer_is_valid(dest))
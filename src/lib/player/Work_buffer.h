@@ -72,6 +72,39 @@ void Work_buffer_init_with_memory(
 bool Work_buffer_resize(Work_buffer* buffer, int32_t new_size);
 
 
+/**
+ * Make the Work buffer use the contents of another Work buffer.
+ *
+ * The Work buffer releases its own contents and uses the contents of
+ * \a lender until \a Work_buffer_restore_contents is called. Resizing the
+ * Work buffer only changes its reported size, as the contents are resized
+ * along with \a lender. Only the contents are shared; validity, constant
+ * start and finality are still tracked separately for each Work buffer. The
+ * caller is responsible for making sure that the two Work buffers are not
+ * used at the same time, and that \a lender is not destroyed first.
+ *
+ * \param buffer   The Work buffer -- must not be \c NULL, created with
+ *                 \a new_Work_buffer and not borrowing contents.
+ * \param lender   The Work buffer whose contents are used -- must not be
+ *                 \c NULL, must not borrow contents and must have the same
+ *                 size as \a buffer.
+ */
+void Work_buffer_borrow_contents(Work_buffer* buffer, const Work_buffer* lender);
+
+
+/**
+ * Make the Work buffer use its own contents again.
+ *
+ * New contents are allocated for a Work buffer that borrows contents, and
+ * the Work buffer is invalidated.
+ *
+ * \param buffer   The Work buffer -- must not be \c NULL.
+ *
+ * \return   \c true if successful, or \c false if memory allocation failed.
+ */
+bool Work_buffer_restore_contents(Work_buffer* buffer);
+
+
 /**
  * Invalidate the contents of the Work buffer.
  *
@@ -25,6 +25,7 @@
 struct Work_buffer
 {
     void* contents;
+    const Work_buffer* lender;
     int32_t size;
     int32_t const_start;
     uint8_t is_valid : 1;
@@ -0,0 +1,236 @@
+
+
+/*
+ * Author: agent, 2026
+ *
+ * This file is part of Kunquat.
+ *
+ * CC0 1.0 Universal, http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * To the extent possible under law, Kunquat Affirmers have waived all
+ * copyright and related or neighboring rights to Kunquat.
+ */
+
+
+#include <player/Work_buffer_sharing.h>
+
+#include <containers/Array.h>
+#include <debug/assert.h>
+#include <mathnum/common.h>
+#include <memory.h>
+#include <player/Work_buffer.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+
+typedef struct Buffer_lifetime
+{
+    Work_buffer* buffer;
+    int32_t first_step;
+    int32_t last_step;
+} Buffer_lifetime;
+
+
+static int Buffer_lifetime_cmp(const void* v1, const void* v2)
+{
+    const Buffer_lifetime* lt1 = v1;
+    const Buffer_lifetime* lt2 = v2;
+
+    if (lt1->first_step != lt2->first_step)
+        return (lt1->first_step < lt2->first_step) ? -1 : 1;
+
+    if (lt1->last_step != lt2->last_step)
+        return (lt1->last_step < lt2->last_step) ? -1 : 1;
+
+    return 0;
+}
+
+
+struct Work_buffer_sharing
+{
+    Array* lifetimes;
+};
+
+
+Work_buffer_sharing* new_Work_buffer_sharing(void)
+{
+    Work_buffer_sharing* sharing = memory_alloc_item(Work_buffer_sharing);
+    if (sharing == NULL)
+        return NULL;
+
+    sharing->lifetimes = new_Array(sizeof(Buffer_lifetime));
+    if (sharing->lifetimes == NULL)
+    {
+        del_Work_buffer_sharing(sharing);
+        return NULL;
+    }
+
+    return sharing;
+}
+
+
+static Buffer_lifetime* Work_buffer_sharing_find(
+        const Work_buffer_sharing* sharing, const Work_buffer* buffer)
+{
+    rassert(sharing != NULL);
+    rassert(buffer != NULL);
+
+    const int64_t lifetime_count = Array_get_size(sharing->lifetimes);
+    for (int64_t i = 0; i < lifetime_count; ++i)
+    {
+        Buffer_lifetime* lifetime = Array_get_ref(sharing->lifetimes, i);
+        if (lifetime->buffer == buffer)
+            return lifetime;
+    }
+
+    return NULL;
+}
+
+
+bool Work_buffer_sharing_add_use(
+        Work_buffer_sharing* sharing,
+        Work_buffer* buffer,
+        int32_t first_step,
+        int32_t last_step)
+{
+    rassert(sharing != NULL);
+    rassert(buffer != NULL);
+    rassert(first_step >= WORK_BUFFER_STEP_BEFORE);
+    rassert(last_step >= first_step);
+
+    Buffer_lifetime* lifetime = Work_buffer_sharing_find(sharing, buffer);
+    if (lifetime != NULL)
+    {
+        lifetime->first_step = min(lifetime->first_step, first_step);
+        lifetime->last_step = max(lifetime->last_step, last_step);
+        return true;
+    }
+
+    const Buffer_lifetime new_lifetime =
+    {
+        .buffer = buffer,
+        .first_step = first_step,
+        .last_step = last_step,
+    };
+
+    return Array_append(sharing->lifetimes, &new_lifetime);
+}
+
+
+bool Work_buffer_sharing_extend_use(
+        Work_buffer_sharing* sharing, const Work_buffer* buffer, int32_t step)
+{
+    rassert(sharing != NULL);
+    rassert(buffer != NULL);
+    rassert(step >= WORK_BUFFER_STEP_BEFORE);
+
+    Buffer_lifetime* lifetime = Work_buffer_sharing_find(sharing, buffer);
+    if (lifetime == NULL)
+        return false;
+
+    lifetime->first_step = min(lifetime->first_step, step);
+    lifetime->last_step = max(lifetime->last_step, step);
+
+    return true;
+}
+
+
+bool Work_buffer_sharing_get_bindings(Work_buffer_sharing* sharing, Array* bindings)
+{
+    rassert(sharing != NULL);
+    rassert(bindings != NULL);
+
+    const int64_t lifetime_count = Array_get_size(sharing->lifetimes);
+    if (lifetime_count == 0)
+        return true;
+
+    qsort(Array_get_ref(sharing->lifetimes, 0),
+            (size_t)lifetime_count,
+            sizeof(Buffer_lifetime),
+            Buffer_lifetime_cmp);
+
+    int32_t* slot_last_steps = memory_alloc_items(int32_t, lifetime_count);
+    const Work_buffer** slot_lenders =
+        memory_alloc_items(const Work_buffer*, lifetime_count);
+    if ((slot_last_steps == NULL) || (slot_lenders == NULL))
+    {
+        memory_free(slot_last_steps);
+        memory_free(slot_lenders);
+        return false;
+    }
+
+    // Reuse slots whose previous occupant is no longer needed
+    int32_t slot_count = 0;
+    for (int64_t i = 0; i < lifetime_count; ++i)
+    {
+        const Buffer_lifetime* lifetime = Array_get_ref(sharing->lifetimes, i);
+
+        int32_t slot = -1;
+        for (int32_t si = 0; si < slot_count; ++si)
+        {
+            if (slot_last_steps[si] < lifetime->first_step)
+            {
+                slot = si;
+                break;
+            }
+        }
+
+        if (slot < 0)
+        {
+            slot_last_steps[slot_count] = lifetime->last_step;
+            slot_lenders[slot_count] = lifetime->buffer;
+            ++slot_count;
+            continue;
+        }
+
+        const Work_buffer_binding binding =
+        {
+            .buffer = lifetime->buffer,
+            .lender = slot_lenders[slot],
+        };
+        if (!Array_append(bindings, &binding))
+        {
+            memory_free(slot_last_steps);
+            memory_free(slot_lenders);
+            return false;
+        }
+
+        slot_last_steps[slot] = lifetime->last_step;
+    }
+
+    memory_free(slot_last_steps);
+    memory_free(slot_lenders);
+
+    return true;
+}
+
+
+void Work_buffer_bindings_apply(const Array* bindings)
+{
+    rassert(bindings != NULL);
+
+    const int64_t binding_count = Array_get_size(bindings);
+    for (int64_t i = 0; i < binding_count; ++i)
+    {
+        const Work_buffer_binding* binding = Array_get_ref(bindings, i);
+        Work_buffer_borrow_contents(binding->buffer, binding->lender);
+    }
+
+    return;
+}
+
+
+void del_Work_buffer_sharing(Work_buffer_sharing* sharing)
+{
+    if (sharing == NULL)
+        return;
+
+    del_Array(sharing->lifetimes);
+    memory_free(sharing);
+
+    return;
+}
+
+
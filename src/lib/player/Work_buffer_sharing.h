@@ -0,0 +1,132 @@
+
+
+/*
+ * Author: agent, 2026
+ *
+ * This file is part of Kunquat.
+ *
+ * CC0 1.0 Universal, http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * To the extent possible under law, Kunquat Affirmers have waived all
+ * copyright and related or neighboring rights to Kunquat.
+ */
+
+
+#ifndef KQT_WORK_BUFFER_SHARING_H
+#define KQT_WORK_BUFFER_SHARING_H
+
+
+#include <containers/Array.h>
+#include <decl.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+
+/**
+ * Execution steps used for Work buffer contents that are written before or
+ * read after the execution of a signal plan.
+ */
+#define WORK_BUFFER_STEP_BEFORE (-1)
+#define WORK_BUFFER_STEP_AFTER INT32_MAX
+
+
+/**
+ * A binding of a Work buffer to a lender whose contents it uses.
+ */
+typedef struct Work_buffer_binding
+{
+    Work_buffer* buffer;
+    const Work_buffer* lender;
+} Work_buffer_binding;
+
+
+/**
+ * A collection of Work buffer lifetimes used for finding Work buffers that
+ * can share contents. A lifetime is a range of execution steps during which
+ * the contents of a Work buffer are in use.
+ */
+typedef struct Work_buffer_sharing Work_buffer_sharing;
+
+
+/**
+ * Create a new Work buffer sharing.
+ *
+ * \return   The new Work buffer sharing, or \c NULL if memory allocation
+ *           failed.
+ */
+Work_buffer_sharing* new_Work_buffer_sharing(void);
+
+
+/**
+ * Add a use of a Work buffer.
+ *
+ * The lifetime of \a buffer is extended to cover the given steps.
+ *
+ * \param sharing      The Work buffer sharing -- must not be \c NULL.
+ * \param buffer       The Work buffer -- must not be \c NULL.
+ * \param first_step   The first step of the use -- must be
+ *                     >= \c WORK_BUFFER_STEP_BEFORE.
+ * \param last_step    The last step of the use -- must be >= \a first_step.
+ *
+ * \return   \c true if successful, or \c false if memory allocation failed.
+ */
+bool Work_buffer_sharing_add_use(
+        Work_buffer_sharing* sharing,
+        Work_buffer* buffer,
+        int32_t first_step,
+        int32_t last_step);
+
+
+/**
+ * Extend the lifetime of a Work buffer that has been added.
+ *
+ * \param sharing   The Work buffer sharing -- must not be \c NULL.
+ * \param buffer    The Work buffer -- must not be \c NULL.
+ * \param step      The step where \a buffer is in use -- must be
+ *                  >= \c WORK_BUFFER_STEP_BEFORE.
+ *
+ * \return   \c true if \a buffer has been added to \a sharing, otherwise
+ *           \c false.
+ */
+bool Work_buffer_sharing_extend_use(
+        Work_buffer_sharing* sharing, const Work_buffer* buffer, int32_t step);
+
+
+/**
+ * Find the bindings of Work buffers whose lifetimes do not overlap.
+ *
+ * The Work buffers are assigned to slots in the order of their first use.
+ * The first Work buffer of each slot keeps its contents and lends them to the
+ * other Work buffers of the slot.
+ *
+ * \param sharing    The Work buffer sharing -- must not be \c NULL.
+ * \param bindings   The destination Array of \a Work_buffer_binding items
+ *                   -- must not be \c NULL.
+ *
+ * \return   \c true if successful, or \c false if memory allocation failed.
+ */
+bool Work_buffer_sharing_get_bindings(Work_buffer_sharing* sharing, Array* bindings);
+
+
+/**
+ * Make the Work buffers borrow the contents of their lenders.
+ *
+ * \param bindings   The Array of \a Work_buffer_binding items -- must not be
+ *                   \c NULL.
+ */
+void Work_buffer_bindings_apply(const Array* bindings);
+
+
+/**
+ * Destroy an existing Work buffer sharing.
+ *
+ * \param sharing   The Work buffer sharing, or \c NULL.
+ */
+void del_Work_buffer_sharing(Work_buffer_sharing* sharing);
+
+
+#endif // KQT_WORK_BUFFER_SHARING_H
+
+
@@ -42,6 +42,8 @@ Device_thread_state* new_Device_thread_state(
     ts->node_state = DEVICE_NODE_STATE_NEW;
     ts->has_mixed_audio = false;
     ts->in_connected = NULL;
+    ts->voice_lane_count = 1;
+    ts->voice_lane = 0;
 
     for (Device_buffer_type buf_type = DEVICE_BUFFER_MIXED;
             buf_type < DEVICE_BUFFER_TYPES; ++buf_type)
@@ -123,6 +125,31 @@ bool Device_thread_state_set_audio_buffer_size(Device_thread_state* ts, int size
 }
 
 
+bool Device_thread_state_restore_buffers(Device_thread_state* ts)
+{
+    rassert(ts != NULL);
+
+    for (Device_buffer_type buf_type = DEVICE_BUFFER_MIXED;
+            buf_type < DEVICE_BUFFER_TYPES; ++buf_type)
+    {
+        for (Device_port_type port_type = DEVICE_PORT_TYPE_RECV;
+                port_type < DEVICE_PORT_TYPES; ++port_type)
+        {
+            Etable* bufs = ts->buffers[buf_type][port_type];
+            const int cap = Etable_get_capacity(bufs);
+            for (int port = 0; port < cap; ++port)
+            {
+                Work_buffer* buffer = Etable_get(bufs, port);
+                if ((buffer != NULL) && !Work_buffer_restore_contents(buffer))
+                    return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+
 static bool Device_thread_state_add_buffer(
         Device_thread_state* ts,
         Device_buffer_type buf_type,
@@ -309,7 +336,13 @@ bool Device_thread_state_add_voice_buffer(
     rassert(port >= 0);
     rassert(port < KQT_DEVICE_PORTS_MAX);
 
-    return Device_thread_state_add_buffer(ts, DEVICE_BUFFER_VOICE, type, port);
+    for (int lane = 0; lane < ts->voice_lane_count; ++lane)
+    {
+        if (!Device_thread_state_add_buffer(ts, DEVICE_BUFFER_VOICE + lane, type, port))
+            return false;
+    }
+
+    return true;
 }
 
 
@@ -317,7 +350,56 @@ void Device_thread_state_invalidate_voice_buffers(Device_thread_state* ts)
 {
     rassert(ts != NULL);
 
-    Device_thread_state_invalidate_buffers(ts, DEVICE_BUFFER_VOICE);
+    for (int lane = 0; lane < ts->voice_lane_count; ++lane)
+        Device_thread_state_invalidate_buffers(ts, DEVICE_BUFFER_VOICE + lane);
+
+    return;
+}
+
+
+bool Device_thread_state_add_voice_lanes(Device_thread_state* ts, int lane_count)
+{
+    rassert(ts != NULL);
+    rassert(lane_count > 0);
+    rassert(lane_count <= DEVICE_VOICE_LANES_MAX);
+
+    for (int lane = ts->voice_lane_count; lane < lane_count; ++lane)
+    {
+        for (Device_port_type port_type = DEVICE_PORT_TYPE_RECV;
+                port_type < DEVICE_PORT_TYPES; ++port_type)
+        {
+            const Etable* bufs = ts->buffers[DEVICE_BUFFER_VOICE][port_type];
+            const int cap = Etable_get_capacity(bufs);
+            for (int port = 0; port < cap; ++port)
+            {
+                if ((Etable_get(bufs, port) != NULL) &&
+                        !Device_thread_state_add_buffer(
+                            ts, DEVICE_BUFFER_VOICE + lane, port_type, port))
+                    return false;
+            }
+        }
+
+        ts->voice_lane_count = lane + 1;
+    }
+
+    return true;
+}
+
+
+int Device_thread_state_get_voice_lane_count(const Device_thread_state* ts)
+{
+    rassert(ts != NULL);
+    return ts->voice_lane_count;
+}
+
+
+void Device_thread_state_set_voice_lane(Device_thread_state* ts, int lane)
+{
+    rassert(ts != NULL);
+    rassert(lane >= 0);
+    rassert(lane < ts->voice_lane_count);
+
+    ts->voice_lane = lane;
 
     return;
 }
@@ -330,7 +412,8 @@ void Device_thread_state_clear_voice_buffers(
     rassert(buf_start >= 0);
     rassert(buf_stop >= buf_start);
 
-    Device_thread_state_clear_buffers(ts, DEVICE_BUFFER_VOICE, buf_start, buf_stop);
+    Device_thread_state_clear_buffers(
+            ts, DEVICE_BUFFER_VOICE + ts->voice_lane, buf_start, buf_stop);
 
     return;
 }
@@ -340,7 +423,8 @@ void Device_thread_state_invalidate_voice_outputs(Device_thread_state* ts)
 {
     rassert(ts != NULL);
 
-    Etable* bufs = ts->buffers[DEVICE_BUFFER_VOICE][DEVICE_PORT_TYPE_SEND];
+    const int buf_type = DEVICE_BUFFER_VOICE + ts->voice_lane;
+    Etable* bufs = ts->buffers[buf_type][DEVICE_PORT_TYPE_SEND];
     rassert(bufs != NULL);
     const int cap = Etable_get_capacity(bufs);
     for (int buf_index = 0; buf_index < cap; ++buf_index)
@@ -361,7 +445,8 @@ void Device_thread_state_clear_voice_outputs(
     rassert(buf_start >= 0);
     rassert(buf_stop > buf_start);
 
-    Etable* bufs = ts->buffers[DEVICE_BUFFER_VOICE][DEVICE_PORT_TYPE_SEND];
+    const int buf_type = DEVICE_BUFFER_VOICE + ts->voice_lane;
+    Etable* bufs = ts->buffers[buf_type][DEVICE_PORT_TYPE_SEND];
     rassert(bufs != NULL);
     const int cap = Etable_get_capacity(bufs);
     for (int buf_index = 0; buf_index < cap; ++buf_index)
@@ -383,7 +468,21 @@ Work_buffer* Device_thread_state_get_voice_buffer(
     rassert(port >= 0);
     rassert(port < KQT_DEVICE_PORTS_MAX);
 
-    return Etable_get(ts->buffers[DEVICE_BUFFER_VOICE][type], port);
+    return Etable_get(ts->buffers[DEVICE_BUFFER_VOICE + ts->voice_lane][type], port);
+}
+
+
+Work_buffer* Device_thread_state_get_voice_lane_buffer(
+        const Device_thread_state* ts, int lane, Device_port_type type, int port)
+{
+    rassert(ts != NULL);
+    rassert(lane >= 0);
+    rassert(lane < ts->voice_lane_count);
+    rassert(type < DEVICE_PORT_TYPES);
+    rassert(port >= 0);
+    rassert(port < KQT_DEVICE_PORTS_MAX);
+
+    return Etable_get(ts->buffers[DEVICE_BUFFER_VOICE + lane][type], port);
 }
 
 
@@ -429,6 +528,8 @@ void Device_thread_state_mix_voice_signals(
     rassert(clear_stop >= mix_stop);
 
     const Etable* mixed_bufs = ts->buffers[DEVICE_BUFFER_MIXED][DEVICE_PORT_TYPE_SEND];
+    const Etable* voice_bufs =
+        ts->buffers[DEVICE_BUFFER_VOICE + ts->voice_lane][DEVICE_PORT_TYPE_SEND];
     const int cap = Etable_get_capacity(mixed_bufs);
     for (int32_t buf_index = 0; buf_index < cap; ++buf_index)
     {
@@ -437,8 +538,7 @@ void Device_thread_state_mix_voice_signals(
         if (mixed_buffer == NULL)
             continue;
 
-        const Work_buffer* voice_buffer = Etable_get(
-                ts->buffers[DEVICE_BUFFER_VOICE][DEVICE_PORT_TYPE_SEND], buf_index);
+        const Work_buffer* voice_buffer = Etable_get(voice_bufs, buf_index);
         rassert(voice_buffer != NULL);
 
         //fprintf(stdout, "%p -> %p\n", (const void*)voice_buffer, (const void*)mixed_buffer);
@@ -26,11 +26,21 @@
 #include <stdlib.h>
 
 
+/**
+ * The maximum number of Voice groups that can be rendered as one batch.
+ *
+ * Each Voice group in a batch uses its own lane of voice buffers. Lanes other
+ * than the first are only allocated for Devices that are part of a Voice
+ * signal plan that renders batches.
+ */
+#define DEVICE_VOICE_LANES_MAX 4
+
+
 typedef enum
 {
     DEVICE_BUFFER_MIXED = 0,
     DEVICE_BUFFER_VOICE,
-    DEVICE_BUFFER_TYPES
+    DEVICE_BUFFER_TYPES = DEVICE_BUFFER_VOICE + DEVICE_VOICE_LANES_MAX
 } Device_buffer_type;
 
 
@@ -50,6 +60,9 @@ struct Device_thread_state
     //       Device node by using Device as a reference -- fix this!
     Bit_array* in_connected;
 
+    int voice_lane_count;
+    int voice_lane;
+
     Etable* buffers[DEVICE_BUFFER_TYPES][DEVICE_PORT_TYPES];
 };
 
@@ -101,6 +114,16 @@ Device_node_state Device_thread_state_get_node_state(const Device_thread_state*
 bool Device_thread_state_set_audio_buffer_size(Device_thread_state* ts, int size);
 
 
+/**
+ * Give back own contents to all Work buffers that borrow contents from others.
+ *
+ * \param ts   The Device thread state -- must not be \c NULL.
+ *
+ * \return   \c true if successful, or \c false if memory allocation failed.
+ */
+bool Device_thread_state_restore_buffers(Device_thread_state* ts);
+
+
 /**
  * Add a mixed audio buffer into the Device thread state.
  *
@@ -184,6 +207,41 @@ bool Device_thread_state_add_voice_buffer(
 void Device_thread_state_invalidate_voice_buffers(Device_thread_state* ts);
 
 
+/**
+ * Add voice buffer lanes into the Device thread state.
+ *
+ * Each voice buffer that exists in the first lane is added to the new lanes.
+ * Voice buffers added afterwards are added to all lanes.
+ *
+ * \param ts           The Device thread state -- must not be \c NULL.
+ * \param lane_count   The number of lanes required -- must be > \c 0 and
+ *                     <= \c DEVICE_VOICE_LANES_MAX.
+ *
+ * \return   \c true if successful, or \c false if memory allocation failed.
+ */
+bool Device_thread_state_add_voice_lanes(Device_thread_state* ts, int lane_count);
+
+
+/**
+ * Get the number of voice buffer lanes in the Device thread state.
+ *
+ * \param ts   The Device thread state -- must not be \c NULL.
+ *
+ * \return   The number of lanes.
+ */
+int Device_thread_state_get_voice_lane_count(const Device_thread_state* ts);
+
+
+/**
+ * Select the voice buffer lane used by the voice buffer functions.
+ *
+ * \param ts     The Device thread state -- must not be \c NULL.
+ * \param lane   The lane index -- must be >= \c 0 and less than the number
+ *               of lanes in \a ts.
+ */
+void Device_thread_state_set_voice_lane(Device_thread_state* ts, int lane);
+
+
 /**
  * Clear voice audio buffers in the Device thread state.
  *
@@ -208,7 +266,7 @@ void Device_thread_state_clear_voice_outputs(
 
 
 /**
- * Return a voice audio buffer of the Device thread state.
+ * Return a voice audio buffer of the selected lane in the Device thread state.
  *
  * \param ts     The Device thread state -- must not be \c NULL.
  * \param type   The port type -- must be valid.
@@ -220,6 +278,21 @@ Work_buffer* Device_thread_state_get_voice_buffer(
         const Device_thread_state* ts, Device_port_type type, int port);
 
 
+/**
+ * Return a voice audio buffer of a specific lane in the Device thread state.
+ *
+ * \param ts     The Device thread state -- must not be \c NULL.
+ * \param lane   The lane index -- must be >= \c 0 and less than the number
+ *               of lanes in \a ts.
+ * \param type   The port type -- must be valid.
+ * \param port   The port number -- must be >= \c 0 and < \c KQT_DEVICE_PORTS_MAX.
+ *
+ * \return   The Work buffer if one exists, otherwise \c NULL.
+ */
+Work_buffer* Device_thread_state_get_voice_lane_buffer(
+        const Device_thread_state* ts, int lane, Device_port_type type, int port);
+
+
 /**
  * Return contents of a voice audio buffer in the Device thread state.
  *
@@ -179,6 +179,89 @@ int32_t Voice_state_render_voice(
 }
 
 
+void Voice_state_render_voices(
+        Voice_state* vstates[DEVICE_VOICE_LANES_MAX],
+        Proc_state* proc_state,
+        const Device_thread_state* proc_ts,
+        const Au_state* au_state,
+        const Work_buffers* wbs,
+        int32_t frame_count,
+        double tempo,
+        int32_t stops[DEVICE_VOICE_LANES_MAX])
+{
+    rassert(vstates != NULL);
+    rassert(proc_state != NULL);
+    rassert(proc_ts != NULL);
+    rassert(au_state != NULL);
+    rassert(wbs != NULL);
+    rassert(frame_count >= 0);
+    rassert(isfinite(tempo));
+    rassert(tempo > 0);
+    rassert(stops != NULL);
+
+    const Device* device = proc_state->parent.device;
+    rassert(device != NULL);
+
+    const Device_impl* dimpl = device->dimpl;
+    rassert(dimpl != NULL);
+    rassert(dimpl->render_voices != NULL);
+
+    const Processor* proc = (const Processor*)device;
+    const Audio_unit* au = (const Audio_unit*)au_state->parent.device;
+    const Au_expressions* ae = Audio_unit_get_expressions(au);
+
+    Voice_state* render_vstates[DEVICE_VOICE_LANES_MAX] = { NULL };
+    bool any_render = false;
+
+    for (int lane = 0; lane < DEVICE_VOICE_LANES_MAX; ++lane)
+    {
+        stops[lane] = 0;
+
+        Voice_state* vstate = vstates[lane];
+        if (vstate == NULL)
+            continue;
+
+        if (!Processor_get_voice_signals(proc))
+        {
+            vstate->active = false;
+            continue;
+        }
+
+        if (!vstate->expr_filters_applied)
+        {
+            // Skip the lane if we are filtered out by current Audio unit expressions
+            if ((ae != NULL) &&
+                    (is_proc_filtered(proc, ae, vstate->ch_expr_name) ||
+                     is_proc_filtered(proc, ae, vstate->note_expr_name)))
+            {
+                vstate->active = false;
+                continue;
+            }
+
+            vstate->expr_filters_applied = true;
+        }
+
+        render_vstates[lane] = vstate;
+        any_render = true;
+    }
+
+    if (!any_render || (frame_count == 0))
+        return;
+
+    // Call the implementation
+    dimpl->render_voices(
+            render_vstates, proc_state, proc_ts, au_state, wbs, frame_count, tempo, stops);
+
+    for (int lane = 0; lane < DEVICE_VOICE_LANES_MAX; ++lane)
+    {
+        rassert(stops[lane] <= frame_count);
+        rassert(implies(render_vstates[lane] == NULL, stops[lane] == 0));
+    }
+
+    return;
+}
+
+
 void Voice_state_set_keep_alive_stop(Voice_state* vstate, int32_t stop)
 {
     rassert(vstate != NULL);
@@ -21,6 +21,7 @@
 #include <kunquat/limits.h>
 #include <mathnum/Random.h>
 #include <mathnum/Tstamp.h>
+#include <player/devices/Device_thread_state.h>
 #include <player/Force_controls.h>
 #include <player/LFO.h>
 #include <player/Pitch_controls.h>
@@ -52,6 +53,17 @@ typedef int32_t Voice_state_render_voice_func(
         double tempo);
 
 
+typedef void Voice_state_render_voices_func(
+        Voice_state* vstates[DEVICE_VOICE_LANES_MAX],
+        Proc_state*,
+        const Device_thread_state*,
+        const Au_state*,
+        const Work_buffers*,
+        int32_t frame_count,
+        double tempo,
+        int32_t rendered_counts[DEVICE_VOICE_LANES_MAX]);
+
+
 typedef void Voice_state_fire_event_func(
         Voice_state*, const Device_state*, const char*, const Value*);
 
@@ -146,6 +158,35 @@ int32_t Voice_state_render_voice(
         double tempo);
 
 
+/**
+ * Render voice signals of a batch of Voice states.
+ *
+ * The Voice state at index i uses the voice buffer lane i of \a proc_ts. The
+ * associated Processor must support batch rendering.
+ *
+ * \param vstates       The Voice states -- must not be \c NULL. Lanes that
+ *                      are not rendered are marked with \c NULL.
+ * \param proc_state    The Processor state -- must not be \c NULL.
+ * \param proc_ts       The Device thread state -- must not be \c NULL.
+ * \param au_state      The Audio unit state -- must not be \c NULL.
+ * \param wbs           The Work buffers -- must not be \c NULL.
+ * \param frame_count   Number of frames to be processed -- must be less than or equal
+ *                      to the audio buffer size.
+ * \param tempo         The current tempo -- must be finite and > \c 0.
+ * \param stops         Destination for the actual stop indices of rendering
+ *                      -- must not be \c NULL.
+ */
+void Voice_state_render_voices(
+        Voice_state* vstates[DEVICE_VOICE_LANES_MAX],
+        Proc_state* proc_state,
+        const Device_thread_state* proc_ts,
+        const Au_state* au_state,
+        const Work_buffers* wbs,
+        int32_t frame_count,
+        double tempo,
+        int32_t stops[DEVICE_VOICE_LANES_MAX]);
+
+
 /**
  * Set request to keep the Voice state alive.
  *
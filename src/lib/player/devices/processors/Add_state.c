@@ -16,6 +16,7 @@
 
 #include <debug/assert.h>
 #include <init/devices/processors/Proc_add.h>
+#include <intrinsics.h>
 #include <mathnum/common.h>
 #include <mathnum/conversions.h>
 #include <mathnum/Random.h>
@@ -72,6 +73,127 @@ static const int ADD_WORK_BUFFER_MOD_L = WORK_BUFFER_IMPL_3;
 //static const int ADD_WORK_BUFFER_MOD_R = WORK_BUFFER_IMPL_4;
 
 
+#define LANE_COUNT 4
+#define ADD_CHUNK_SIZE 64
+
+
+/*
+ * Tones are rendered LANE_COUNT at a time with single-precision phases. The
+ * phases are re-synchronised from double-precision accumulators after each
+ * chunk of ADD_CHUNK_SIZE frames to keep the error from building up.
+ */
+typedef struct Tone_lanes
+{
+    float phases[LANE_COUNT];
+    float phase_incs[LANE_COUNT];
+    float amps[LANE_COUNT];
+    float sizes[LANE_COUNT];
+    int32_t masks[LANE_COUNT];
+    int32_t offsets[LANE_COUNT];
+} Tone_lanes;
+
+
+static double wrap_phase(double phase)
+{
+    return phase - floor(phase);
+}
+
+
+static void add_tone_lanes(
+        float accs[ADD_CHUNK_SIZE * LANE_COUNT],
+        const Tone_lanes* lanes,
+        const float* base,
+        const float* freqs,
+        const float* mod_fracs,
+        int32_t frame_count)
+{
+    rassert(accs != NULL);
+    rassert(lanes != NULL);
+    rassert(base != NULL);
+    rassert(freqs != NULL);
+    rassert(frame_count > 0);
+    rassert(frame_count <= ADD_CHUNK_SIZE);
+
+#if KQT_SSE2
+    __m128 phases = _mm_loadu_ps(lanes->phases);
+    const __m128 phase_incs = _mm_loadu_ps(lanes->phase_incs);
+    const __m128 amps = _mm_loadu_ps(lanes->amps);
+    const __m128 sizes = _mm_loadu_ps(lanes->sizes);
+    const __m128i masks = _mm_loadu_si128((const __m128i*)lanes->masks);
+    const __m128i offsets = _mm_loadu_si128((const __m128i*)lanes->offsets);
+    const __m128 ones = _mm_set1_ps(1);
+    const __m128i int_ones = _mm_set1_epi32(1);
+
+    for (int32_t i = 0; i < frame_count; ++i)
+    {
+        // Note: + mod_fracs[i] is specific to phase modulation
+        __m128 actual_phases = phases;
+        if (mod_fracs != NULL)
+            actual_phases = _mm_add_ps(actual_phases, _mm_set1_ps(mod_fracs[i]));
+
+        // All positions are non-negative, so truncation rounds them down
+        const __m128 poss = _mm_mul_ps(actual_phases, sizes);
+        const __m128i int_poss = _mm_cvttps_epi32(poss);
+        const __m128 lerp_vals = _mm_sub_ps(poss, _mm_cvtepi32_ps(int_poss));
+
+        int32_t pos1s[LANE_COUNT];
+        int32_t pos2s[LANE_COUNT];
+        _mm_storeu_si128(
+                (__m128i*)pos1s, _mm_add_epi32(_mm_and_si128(int_poss, masks), offsets));
+        _mm_storeu_si128(
+                (__m128i*)pos2s,
+                _mm_add_epi32(
+                    _mm_and_si128(_mm_add_epi32(int_poss, int_ones), masks), offsets));
+
+        const __m128 item1s = _mm_setr_ps(
+                base[pos1s[0]], base[pos1s[1]], base[pos1s[2]], base[pos1s[3]]);
+        const __m128 item2s = _mm_setr_ps(
+                base[pos2s[0]], base[pos2s[1]], base[pos2s[2]], base[pos2s[3]]);
+        const __m128 values = _mm_mul_ps(
+                _mm_add_ps(item1s, _mm_mul_ps(lerp_vals, _mm_sub_ps(item2s, item1s))),
+                amps);
+
+        float* acc = accs + i * LANE_COUNT;
+        _mm_storeu_ps(acc, _mm_add_ps(_mm_loadu_ps(acc), values));
+
+        // Normalise to range [0, 1), or close enough if our frequency is too high
+        phases = _mm_add_ps(phases, _mm_mul_ps(_mm_set1_ps(freqs[i]), phase_incs));
+        phases = _mm_sub_ps(phases, _mm_and_ps(_mm_cmpge_ps(phases, ones), ones));
+    }
+#else
+    float phases[LANE_COUNT] = { 0 };
+    for (int k = 0; k < LANE_COUNT; ++k)
+        phases[k] = lanes->phases[k];
+
+    for (int32_t i = 0; i < frame_count; ++i)
+    {
+        const float mod_frac = (mod_fracs != NULL) ? mod_fracs[i] : 0.0f;
+        float* acc = accs + i * LANE_COUNT;
+
+        for (int k = 0; k < LANE_COUNT; ++k)
+        {
+            // Note: + mod_frac is specific to phase modulation
+            const float pos = (phases[k] + mod_frac) * lanes->sizes[k];
+            const int32_t int_pos = (int32_t)pos;
+            const int32_t pos1 = (int_pos & lanes->masks[k]) + lanes->offsets[k];
+            const int32_t pos2 = ((int_pos + 1) & lanes->masks[k]) + lanes->offsets[k];
+
+            const float item1 = base[pos1];
+            const float item_diff = base[pos2] - item1;
+            const float lerp_val = pos - (float)int_pos;
+            acc[k] += (item1 + (lerp_val * item_diff)) * lanes->amps[k];
+
+            phases[k] += freqs[i] * lanes->phase_incs[k];
+            if (phases[k] >= 1)
+                phases[k] -= 1;
+        }
+    }
+#endif
+
+    return;
+}
+
+
 int32_t Add_vstate_render_voice(
         Voice_state* vstate,
         Proc_state* proc_state,
@@ -166,6 +288,41 @@ int32_t Add_vstate_render_voice(
 
     const float* base = Sample_get_buffer(add->base, 0);
 
+    // Get the frequency range of the whole block
+    const int32_t freq_check_stop =
+        min(frame_count, Work_buffer_get_const_start(freqs_wb) + 1);
+    float min_freq = freqs[0];
+    for (int32_t i = 1; i < freq_check_stop; ++i)
+        min_freq = min(min_freq, freqs[i]);
+
+    double freq_sum = 0;
+    for (int32_t i = 0; i < frame_count; ++i)
+        freq_sum += freqs[i];
+
+    // Find tones that contribute to the output, skipping tones above Nyquist
+    int active_tones[ADD_TONES_MAX] = { 0 };
+    int active_count = 0;
+
+    for (int h = 0; h < add_state->tone_limit; ++h)
+    {
+        const Add_tone* tone = &add->tones[h];
+        if ((tone->pitch_factor <= 0) || (tone->volume_factor <= 0))
+            continue;
+
+        const double pitch_factor_inv_audio_rate = tone->pitch_factor * inv_audio_rate;
+        if (min_freq * pitch_factor_inv_audio_rate >= 0.5)
+        {
+            for (int ch = 0; ch < 2; ++ch)
+                add_state->tones[h].phase[ch] = wrap_phase(
+                        add_state->tones[h].phase[ch] +
+                        freq_sum * pitch_factor_inv_audio_rate);
+            continue;
+        }
+
+        active_tones[active_count] = h;
+        ++active_count;
+    }
+
     for (int32_t ch = 0; ch < 2; ++ch)
     {
         float* out_buf_ch = out_bufs[ch];
@@ -173,117 +330,125 @@ int32_t Add_vstate_render_voice(
             continue;
 
         const float* mod_values_ch = Work_buffer_get_contents(mod_wbs[ch]);
-
-        const int32_t res_check_stop = min(frame_count,
-                max(Work_buffer_get_const_start(freqs_wb),
-                    Work_buffer_get_const_start(mod_wbs[ch])) + 1);
-
-        for (int h = 0; h < add_state->tone_limit; ++h)
+        bool has_mod = false;
+        const int32_t mod_check_stop =
+            min(frame_count, Work_buffer_get_const_start(mod_wbs[ch]) + 1);
+        for (int32_t i = 0; i < mod_check_stop; ++i)
         {
-            const Add_tone* tone = &add->tones[h];
-            const double pitch_factor = tone->pitch_factor;
-            const double volume_factor = tone->volume_factor;
-
-            if ((pitch_factor <= 0) || (volume_factor <= 0))
-                continue;
-
-            const double panning_factor =
-                (ch == 0) ? 1 - tone->panning : 1 + tone->panning;
+            if (mod_values_ch[i] != 0)
+            {
+                has_mod = true;
+                break;
+            }
+        }
 
-            const double pitch_factor_inv_audio_rate = pitch_factor * inv_audio_rate;
+        float prev_mod = add_state->prev_mod[ch];
 
-            Add_tone_state* tone_state = &add_state->tones[h];
+        for (int32_t chunk_start = 0; chunk_start < frame_count;
+                chunk_start += ADD_CHUNK_SIZE)
+        {
+            const int32_t chunk_size = min(frame_count - chunk_start, ADD_CHUNK_SIZE);
+            const float* chunk_freqs = freqs + chunk_start;
 
-            double phase = tone_state->phase[ch];
+            float max_freq = chunk_freqs[0];
+            double chunk_freq_sum = 0;
+            for (int32_t i = 0; i < chunk_size; ++i)
+            {
+                max_freq = max(max_freq, chunk_freqs[i]);
+                chunk_freq_sum += chunk_freqs[i];
+            }
 
-            int32_t res_slice_start = 0;
-            while (res_slice_start < frame_count)
+            // Only the fractional part of the modulation affects the output
+            float mod_fracs[ADD_CHUNK_SIZE];
+            float max_mod_shift = 0;
+            if (has_mod)
             {
-                int32_t res_slice_stop = frame_count;
-
-                // Get current pitch range
-                const float first_mod_shift =
-                    mod_values_ch[res_slice_start] - add_state->prev_mod[ch];
-                const float first_phase_shift_abs = (float)fabs(
-                        first_mod_shift +
-                        (freqs[res_slice_start] * pitch_factor_inv_audio_rate));
-                int shift_exp = 0;
-                const float shift_norm = frexpf(first_phase_shift_abs, &shift_exp);
-                const float min_phase_shift_abs = ldexpf(0.5f, shift_exp);
-                const float max_phase_shift_abs = min_phase_shift_abs * 2.0f;
-
-                // Choose appropriate waveform resolution for current pitch range
-                int32_t cur_size = ADD_BASE_FUNC_SIZE;
-                if (isfinite(shift_norm) && (shift_norm > 0.0f))
+                for (int32_t i = 0; i < chunk_size; ++i)
                 {
-                    cur_size = (int32_t)(1 << clamp(-shift_exp + 1, 3, 30));
-                    cur_size = min(cur_size, ADD_BASE_FUNC_SIZE * 2);
-                    rassert(is_p2(cur_size));
+                    const float mod_val = mod_values_ch[chunk_start + i];
+                    mod_fracs[i] = mod_val - floorf(mod_val);
+                    max_mod_shift = max(max_mod_shift, fabsf(mod_val - prev_mod));
+                    prev_mod = mod_val;
                 }
-                const uint32_t cur_size_mask = (uint32_t)cur_size - 1;
-                const int base_offset = (ADD_BASE_FUNC_SIZE * 4 - cur_size * 2);
-                rassert(base_offset >= 0);
-                rassert(base_offset < (ADD_BASE_FUNC_SIZE * 4) - 1);
-                const float* cur_base = base + base_offset;
-
-                // Get length of input compatible with current waveform resolution
-                for (int32_t i = res_slice_start + 1; i < res_check_stop; ++i)
-                {
-                    const float cur_mod_shift = mod_values_ch[i] - mod_values_ch[i - 1];
-                    const float cur_phase_shift_abs = (float)fabs(
-                            cur_mod_shift +
-                            (freqs[i] * pitch_factor_inv_audio_rate));
-                    if (cur_phase_shift_abs < min_phase_shift_abs ||
-                            cur_phase_shift_abs > max_phase_shift_abs)
-                    {
-                        res_slice_stop = i;
-                        break;
-                    }
-                }
-
-                for (int32_t i = res_slice_start; i < res_slice_stop; ++i)
-                {
-                    const float freq = freqs[i];
-                    const float vol_scale = scales[i];
-                    const float mod_val = mod_values_ch[i];
-
-                    // Note: + mod_val is specific to phase modulation
-                    const double actual_phase = phase + mod_val;
-                    const double pos = actual_phase * cur_size;
-
-                    // Note: direct cast of negative doubles to uint32_t is undefined
-                    const uint32_t pos1 = (uint32_t)(int32_t)floor(pos) & cur_size_mask;
-                    const uint32_t pos2 = (pos1 + 1) & cur_size_mask;
-
-                    const float item1 = cur_base[pos1];
-                    const float item_diff = cur_base[pos2] - item1;
-                    const double lerp_val = pos - floor(pos);
-                    const double value =
-                        (item1 + (lerp_val * item_diff)) * volume_factor * panning_factor;
+            }
 
-                    out_buf_ch[i] += (float)value * vol_scale;
+            float accs[ADD_CHUNK_SIZE * LANE_COUNT] = { 0 };
 
-                    phase += freq * pitch_factor_inv_audio_rate;
+            for (int first = 0; first < active_count; first += LANE_COUNT)
+            {
+                Tone_lanes lanes;
 
-                    // Normalise to range [0, 1)
-                    if (phase >= 1)
+                for (int k = 0; k < LANE_COUNT; ++k)
+                {
+                    lanes.phases[k] = 0;
+                    lanes.phase_incs[k] = 0;
+                    lanes.amps[k] = 0;
+                    lanes.sizes[k] = 8;
+                    lanes.masks[k] = 7;
+                    lanes.offsets[k] = ADD_BASE_FUNC_SIZE * 4 - 16;
+
+                    if (first + k >= active_count)
+                        continue;
+
+                    const int h = active_tones[first + k];
+                    const Add_tone* tone = &add->tones[h];
+                    const double pitch_factor_inv_audio_rate =
+                        tone->pitch_factor * inv_audio_rate;
+                    const double panning_factor =
+                        (ch == 0) ? 1 - tone->panning : 1 + tone->panning;
+
+                    // Choose a waveform resolution that fits the largest phase shift
+                    const float max_phase_shift =
+                        max_mod_shift + (float)(max_freq * pitch_factor_inv_audio_rate);
+                    int shift_exp = 0;
+                    const float shift_norm = frexpf(max_phase_shift, &shift_exp);
+                    int32_t cur_size = ADD_BASE_FUNC_SIZE;
+                    if (isfinite(shift_norm) && (shift_norm > 0.0f))
                     {
-                        phase -= 1;
-
-                        // Don't bother updating the phase if our frequency is too high
-                        if (phase >= 1)
-                            phase = tone_state->phase[ch];
+                        cur_size = (int32_t)(1 << clamp(-shift_exp + 1, 3, 30));
+                        cur_size = min(cur_size, ADD_BASE_FUNC_SIZE * 2);
+                        rassert(is_p2(cur_size));
                     }
+
+                    lanes.phases[k] = (float)add_state->tones[h].phase[ch];
+                    lanes.phase_incs[k] = (float)pitch_factor_inv_audio_rate;
+                    lanes.amps[k] = (float)(tone->volume_factor * panning_factor);
+                    lanes.sizes[k] = (float)cur_size;
+                    lanes.masks[k] = cur_size - 1;
+                    lanes.offsets[k] = ADD_BASE_FUNC_SIZE * 4 - cur_size * 2;
                 }
 
-                rassert(res_slice_start < res_slice_stop);
-                add_state->prev_mod[ch] = mod_values_ch[res_slice_stop - 1];
+                add_tone_lanes(
+                        accs,
+                        &lanes,
+                        base,
+                        chunk_freqs,
+                        has_mod ? mod_fracs : NULL,
+                        chunk_size);
 
-                res_slice_start = res_slice_stop;
+                // Re-synchronise the phases with double precision
+                for (int k = 0; (k < LANE_COUNT) && (first + k < active_count); ++k)
+                {
+                    const int h = active_tones[first + k];
+                    Add_tone_state* tone_state = &add_state->tones[h];
+                    const double pitch_factor_inv_audio_rate =
+                        add->tones[h].pitch_factor * inv_audio_rate;
+                    tone_state->phase[ch] = wrap_phase(
+                            tone_state->phase[ch] +
+                            chunk_freq_sum * pitch_factor_inv_audio_rate);
+                }
             }
 
-            tone_state->phase[ch] = phase;
+            for (int32_t i = 0; i < chunk_size; ++i)
+            {
+                float value = 0;
+                for (int k = 0; k < LANE_COUNT; ++k)
+                    value += accs[i * LANE_COUNT + k];
+                out_buf_ch[chunk_start + i] += value * scales[chunk_start + i];
+            }
         }
+
+        add_state->prev_mod[ch] = mod_values_ch[frame_count - 1];
     }
 
     if (add->is_ramp_attack_enabled)
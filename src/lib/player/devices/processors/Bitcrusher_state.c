@@ -22,6 +22,7 @@
 #include <memory.h>
 #include <player/devices/Device_thread_state.h>
 #include <player/devices/Proc_state.h>
+#include <player/devices/processors/Proc_state_utils.h>
 #include <player/devices/Voice_state.h>
 #include <player/Work_buffers.h>
 
@@ -128,14 +129,18 @@ static void Bitcrusher_state_impl_render(
     }
     else
     {
-        const int32_t const_start = Work_buffer_get_const_start(cutoff_wb);
+        const int32_t const_start =
+            min(Work_buffer_get_const_start(cutoff_wb), frame_count);
 
         const float* cutoffs = Work_buffer_get_contents(cutoff_wb);
         float* holds = Work_buffer_get_contents_mut(holds_wb);
 
-        for (int32_t i = 0; i < const_start; ++i)
+        for (int32_t i = 0; i < const_start;
+                i = Proc_get_next_control_point(i, bc->control_interval, const_start))
             holds[i] = (float)get_hold_fast(cutoffs[i], audio_rate);
 
+        Proc_interpolate_control_points(holds, const_start, bc->control_interval);
+
         if (const_start < frame_count)
         {
             const float hold = (float)get_hold(cutoffs[const_start], audio_rate);
@@ -212,14 +217,18 @@ static void Bitcrusher_state_impl_render(
     }
     else
     {
-        const int32_t const_start = Work_buffer_get_const_start(resolution_wb);
+        const int32_t const_start =
+            min(Work_buffer_get_const_start(resolution_wb), frame_count);
 
         const float* res_buf = Work_buffer_get_contents(resolution_wb);
         float* mults = Work_buffer_get_contents_mut(mults_wb);
 
-        for (int32_t i = 0; i < const_start; ++i)
+        for (int32_t i = 0; i < const_start;
+                i = Proc_get_next_control_point(i, bc->control_interval, const_start))
             mults[i] = (float)fast_exp2(max(1, res_buf[i]));
 
+        Proc_interpolate_control_points(mults, const_start, bc->control_interval);
+
         if (const_start < frame_count)
         {
             const float mult = (float)exp2(max(1, res_buf[const_start]));
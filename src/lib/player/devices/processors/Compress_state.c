@@ -122,6 +122,9 @@ static void Compress_states_update(
     for (int32_t i = 0; i < frame_count; ++i)
         gains[i] = 1.0f;
 
+    // Gains are only calculated at control points if control rate is enabled
+    const int32_t interval = compress->control_interval;
+
     if (compress->upward_enabled)
     {
         // Apply upward compression
@@ -133,7 +136,8 @@ static void Compress_states_update(
         const float inv_ratio = (float)(1.0 / compress->upward_ratio);
         const float max_gain = (float)dB_to_scale(compress->upward_range);
 
-        for (int32_t i = 0; i < frame_count; ++i)
+        for (int32_t i = 0; i < frame_count;
+                i = Proc_get_next_control_point(i, interval, frame_count))
         {
             const float level = applied_levels[i];
             if (level < threshold)
@@ -152,7 +156,8 @@ static void Compress_states_update(
         const float inv_ratio = (float)(1.0 / compress->downward_ratio);
         const float min_gain = (float)dB_to_scale(-compress->downward_range);
 
-        for (int32_t i = 0; i < frame_count; ++i)
+        for (int32_t i = 0; i < frame_count;
+                i = Proc_get_next_control_point(i, interval, frame_count))
         {
             const float level = applied_levels[i];
             if (level > threshold)
@@ -164,6 +169,8 @@ static void Compress_states_update(
         }
     }
 
+    Proc_interpolate_control_points(gains, frame_count, interval);
+
     return;
 }
 
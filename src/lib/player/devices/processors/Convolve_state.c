@@ -0,0 +1,478 @@
+
+
+/*
+ * Author: agent, 2026
+ *
+ * This file is part of Kunquat.
+ *
+ * CC0 1.0 Universal, http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * To the extent possible under law, Kunquat Affirmers have waived all
+ * copyright and related or neighboring rights to Kunquat.
+ */
+
+
+#include <player/devices/processors/Convolve_state.h>
+
+#include <debug/assert.h>
+#include <init/devices/Device.h>
+#include <init/devices/processors/Proc_convolve.h>
+#include <intrinsics.h>
+#include <mathnum/common.h>
+#include <mathnum/fft.h>
+#include <memory.h>
+#include <player/devices/Device_thread_state.h>
+#include <player/devices/Proc_state.h>
+#include <player/Work_buffer.h>
+#include <player/Work_buffers.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#define PART_SIZE CONVOLVE_PARTITION_SIZE
+
+
+/*
+ * The tail partitions are applied with uniformly partitioned overlap-save
+ * convolution. The input window contains the previous and the current block
+ * of input, and the spectra of completed windows are kept in a history. The
+ * tail output of the next block is calculated as soon as the current block is
+ * complete, so it is ready in time despite the block latency.
+ */
+typedef struct Convolve_pstate
+{
+    Proc_state parent;
+
+    int32_t tail_partition_count;
+    int32_t block_pos;
+    int32_t history_index;
+
+    float* windows[2];
+    float* tail_outputs[2];
+    float* histories[2];
+    float* fft_buf;
+    float* acc_spectrum;
+    float* buf_data;
+
+    FFT_worker fw;
+} Convolve_pstate;
+
+
+static void Convolve_pstate_clear(Convolve_pstate* cpstate)
+{
+    rassert(cpstate != NULL);
+
+    const int64_t data_size =
+        PART_SIZE * 10 + (int64_t)cpstate->tail_partition_count * PART_SIZE * 4;
+    if (cpstate->buf_data != NULL)
+        memset(cpstate->buf_data, 0, sizeof(float) * (size_t)data_size);
+
+    cpstate->block_pos = 0;
+    cpstate->history_index = 0;
+
+    return;
+}
+
+
+static bool Convolve_pstate_alloc_buffers(
+        Convolve_pstate* cpstate, int32_t tail_partition_count)
+{
+    rassert(cpstate != NULL);
+    rassert(tail_partition_count >= 0);
+
+    // Windows, tail outputs, FFT buffer, accumulated spectrum and histories
+    const int64_t history_size = (int64_t)tail_partition_count * PART_SIZE * 2;
+    const int64_t data_size = PART_SIZE * 10 + history_size * 2;
+
+    float* buf_data = memory_alloc_items(float, data_size);
+    if (buf_data == NULL)
+        return false;
+
+    memory_free(cpstate->buf_data);
+    cpstate->buf_data = buf_data;
+    cpstate->tail_partition_count = tail_partition_count;
+
+    float* next = buf_data;
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        cpstate->windows[ch] = next;
+        next += PART_SIZE * 2;
+        cpstate->tail_outputs[ch] = next;
+        next += PART_SIZE;
+    }
+    cpstate->fft_buf = next;
+    next += PART_SIZE * 2;
+    cpstate->acc_spectrum = next;
+    next += PART_SIZE * 2;
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        cpstate->histories[ch] = next;
+        next += history_size;
+    }
+
+    Convolve_pstate_clear(cpstate);
+
+    return true;
+}
+
+
+static void del_Convolve_pstate(Device_state* dstate)
+{
+    rassert(dstate != NULL);
+
+    Convolve_pstate* cpstate = (Convolve_pstate*)dstate;
+    FFT_worker_deinit(&cpstate->fw);
+    memory_free(cpstate->buf_data);
+    memory_free(cpstate);
+
+    return;
+}
+
+
+static void Convolve_pstate_reset(Device_state* dstate)
+{
+    rassert(dstate != NULL);
+
+    Convolve_pstate* cpstate = (Convolve_pstate*)dstate;
+    Convolve_pstate_clear(cpstate);
+
+    return;
+}
+
+
+static float get_head_output(const float* head, const float* window)
+{
+#if KQT_SSE
+    __m128 sum1 = _mm_setzero_ps();
+    __m128 sum2 = _mm_setzero_ps();
+    for (int32_t i = 0; i < PART_SIZE; i += 8)
+    {
+        sum1 = _mm_add_ps(
+                sum1, _mm_mul_ps(_mm_loadu_ps(head + i), _mm_loadu_ps(window + i)));
+        sum2 = _mm_add_ps(
+                sum2,
+                _mm_mul_ps(_mm_loadu_ps(head + i + 4), _mm_loadu_ps(window + i + 4)));
+    }
+
+    float sums[4] = { 0 };
+    _mm_storeu_ps(sums, _mm_add_ps(sum1, sum2));
+    return (sums[0] + sums[1]) + (sums[2] + sums[3]);
+#else
+    float sum = 0;
+    for (int32_t i = 0; i < PART_SIZE; ++i)
+        sum += head[i] * window[i];
+
+    return sum;
+#endif
+}
+
+
+static void add_spectrum_product(float* acc, const float* spectrum1, const float* spectrum2)
+{
+    // The DC and Nyquist bins are handled separately by the caller
+    float* acc_res = acc;
+    float* acc_ims = acc + PART_SIZE;
+    const float* res1 = spectrum1;
+    const float* ims1 = spectrum1 + PART_SIZE;
+    const float* res2 = spectrum2;
+    const float* ims2 = spectrum2 + PART_SIZE;
+
+#if KQT_SSE
+    for (int32_t k = 0; k < PART_SIZE; k += 4)
+    {
+        const __m128 re1 = _mm_loadu_ps(res1 + k);
+        const __m128 im1 = _mm_loadu_ps(ims1 + k);
+        const __m128 re2 = _mm_loadu_ps(res2 + k);
+        const __m128 im2 = _mm_loadu_ps(ims2 + k);
+
+        _mm_storeu_ps(
+                acc_res + k,
+                _mm_add_ps(
+                    _mm_loadu_ps(acc_res + k),
+                    _mm_sub_ps(_mm_mul_ps(re1, re2), _mm_mul_ps(im1, im2))));
+        _mm_storeu_ps(
+                acc_ims + k,
+                _mm_add_ps(
+                    _mm_loadu_ps(acc_ims + k),
+                    _mm_add_ps(_mm_mul_ps(re1, im2), _mm_mul_ps(im1, re2))));
+    }
+#else
+    for (int32_t k = 0; k < PART_SIZE; ++k)
+    {
+        acc_res[k] += (res1[k] * res2[k]) - (ims1[k] * ims2[k]);
+        acc_ims[k] += (res1[k] * ims2[k]) + (ims1[k] * res2[k]);
+    }
+#endif
+
+    return;
+}
+
+
+static void Convolve_pstate_process_block(
+        Convolve_pstate* cpstate, const Proc_convolve* convolve, int ch)
+{
+    rassert(cpstate != NULL);
+    rassert(convolve != NULL);
+    rassert(ch >= 0);
+    rassert(ch < 2);
+
+    float* window = cpstate->windows[ch];
+    float* tail_output = cpstate->tail_outputs[ch];
+    float* buf = cpstate->fft_buf;
+    const int32_t count = cpstate->tail_partition_count;
+
+    // Get the spectrum of the current window
+    memcpy(buf, window, sizeof(float) * PART_SIZE * 2);
+    FFT_worker_rfft(&cpstate->fw, buf, PART_SIZE * 2);
+
+    float* history = cpstate->histories[ch];
+    float* cur_res = history + cpstate->history_index * PART_SIZE * 2;
+    float* cur_ims = cur_res + PART_SIZE;
+    cur_res[0] = buf[0];
+    cur_ims[0] = buf[PART_SIZE * 2 - 1];
+    for (int32_t k = 1; k < PART_SIZE; ++k)
+    {
+        cur_res[k] = buf[k * 2 - 1];
+        cur_ims[k] = buf[k * 2];
+    }
+
+    // Apply the tail partitions to the most recent windows
+    float* acc = cpstate->acc_spectrum;
+    for (int32_t i = 0; i < PART_SIZE * 2; ++i)
+        acc[i] = 0;
+
+    const float* tail_spectra = convolve->tail_spectra[ch];
+    float dc = 0;
+    float nyquist = 0;
+    for (int32_t p = 0; p < count; ++p)
+    {
+        const int32_t history_index = (cpstate->history_index - p + count) % count;
+        const float* in_spectrum = history + history_index * PART_SIZE * 2;
+        const float* ir_spectrum = tail_spectra + p * PART_SIZE * 2;
+
+        dc += in_spectrum[0] * ir_spectrum[0];
+        nyquist += in_spectrum[PART_SIZE] * ir_spectrum[PART_SIZE];
+        add_spectrum_product(acc, in_spectrum, ir_spectrum);
+    }
+
+    buf[0] = dc;
+    buf[PART_SIZE * 2 - 1] = nyquist;
+    for (int32_t k = 1; k < PART_SIZE; ++k)
+    {
+        buf[k * 2 - 1] = acc[k];
+        buf[k * 2] = acc[PART_SIZE + k];
+    }
+
+    // The second half of the window contains the valid output
+    FFT_worker_irfft(&cpstate->fw, buf, PART_SIZE * 2);
+    memcpy(tail_output, buf + PART_SIZE, sizeof(float) * PART_SIZE);
+
+    return;
+}
+
+
+enum
+{
+    PORT_IN_AUDIO_L = 0,
+    PORT_IN_AUDIO_R,
+    PORT_IN_COUNT
+};
+
+enum
+{
+    PORT_OUT_AUDIO_L = 0,
+    PORT_OUT_AUDIO_R,
+    PORT_OUT_COUNT
+};
+
+
+static const int CONVOLVE_WB_FIXED_INPUT = WORK_BUFFER_IMPL_1;
+
+
+static void Convolve_pstate_render_mixed(
+        Device_state* dstate,
+        Device_thread_state* proc_ts,
+        const Work_buffers* wbs,
+        int32_t frame_count,
+        double tempo)
+{
+    rassert(dstate != NULL);
+    rassert(proc_ts != NULL);
+    rassert(wbs != NULL);
+    rassert(frame_count > 0);
+    rassert(tempo > 0);
+
+    Convolve_pstate* cpstate = (Convolve_pstate*)dstate;
+
+    const Proc_convolve* convolve = (const Proc_convolve*)dstate->device->dimpl;
+
+    const float* in_bufs[2] = { NULL };
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        Work_buffer* in_wb = Device_thread_state_get_mixed_buffer(
+                proc_ts, DEVICE_PORT_TYPE_RECV, PORT_IN_AUDIO_L + ch);
+        if (!Work_buffer_is_valid(in_wb))
+        {
+            in_wb = Work_buffers_get_buffer_mut(wbs, CONVOLVE_WB_FIXED_INPUT);
+            Work_buffer_clear(in_wb, 0, frame_count);
+        }
+
+        in_bufs[ch] = Work_buffer_get_contents(in_wb);
+    }
+
+    float* out_bufs[2] = { NULL };
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        Work_buffer* out_wb = Device_thread_state_get_mixed_buffer(
+                proc_ts, DEVICE_PORT_TYPE_SEND, PORT_OUT_AUDIO_L + ch);
+        if (out_wb != NULL)
+            out_bufs[ch] = Work_buffer_get_contents_mut(out_wb);
+    }
+
+    if ((convolve->heads[0] == NULL) ||
+            (cpstate->tail_partition_count != convolve->tail_partition_count))
+    {
+        for (int ch = 0; ch < 2; ++ch)
+        {
+            if (out_bufs[ch] != NULL)
+            {
+                for (int32_t i = 0; i < frame_count; ++i)
+                    out_bufs[ch][i] = 0;
+            }
+        }
+
+        return;
+    }
+
+    int32_t frame_offset = 0;
+    while (frame_offset < frame_count)
+    {
+        const int32_t block_pos = cpstate->block_pos;
+        const int32_t cur_count = min(frame_count - frame_offset, PART_SIZE - block_pos);
+
+        for (int ch = 0; ch < 2; ++ch)
+        {
+            float* window = cpstate->windows[ch];
+            const float* in_buf = in_bufs[ch] + frame_offset;
+            for (int32_t i = 0; i < cur_count; ++i)
+                window[PART_SIZE + block_pos + i] = in_buf[i];
+
+            float* out_buf = out_bufs[ch];
+            if (out_buf == NULL)
+                continue;
+
+            out_buf += frame_offset;
+
+            const float* head = convolve->heads[ch];
+            const float* tail_output = cpstate->tail_outputs[ch] + block_pos;
+            for (int32_t i = 0; i < cur_count; ++i)
+            {
+                const float head_output =
+                    get_head_output(head, window + block_pos + i + 1);
+                out_buf[i] = head_output + tail_output[i];
+            }
+        }
+
+        frame_offset += cur_count;
+        cpstate->block_pos += cur_count;
+
+        if (cpstate->block_pos == PART_SIZE)
+        {
+            for (int ch = 0; ch < 2; ++ch)
+            {
+                if (cpstate->tail_partition_count > 0)
+                    Convolve_pstate_process_block(cpstate, convolve, ch);
+
+                float* window = cpstate->windows[ch];
+                memcpy(window, window + PART_SIZE, sizeof(float) * PART_SIZE);
+            }
+
+            cpstate->block_pos = 0;
+            if (cpstate->tail_partition_count > 0)
+                cpstate->history_index =
+                    (cpstate->history_index + 1) % cpstate->tail_partition_count;
+        }
+    }
+
+    return;
+}
+
+
+static void Convolve_pstate_clear_history(Proc_state* proc_state)
+{
+    rassert(proc_state != NULL);
+
+    Convolve_pstate* cpstate = (Convolve_pstate*)proc_state;
+    Convolve_pstate_clear(cpstate);
+
+    return;
+}
+
+
+Device_state* new_Convolve_pstate(
+        const Device* device, int32_t audio_rate, int32_t audio_buffer_size)
+{
+    rassert(device != NULL);
+    rassert(audio_rate > 0);
+    rassert(audio_buffer_size >= 0);
+
+    Convolve_pstate* cpstate = memory_alloc_item(Convolve_pstate);
+    if (cpstate == NULL)
+        return NULL;
+
+    cpstate->tail_partition_count = 0;
+    cpstate->block_pos = 0;
+    cpstate->history_index = 0;
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        cpstate->windows[ch] = NULL;
+        cpstate->tail_outputs[ch] = NULL;
+        cpstate->histories[ch] = NULL;
+    }
+    cpstate->fft_buf = NULL;
+    cpstate->acc_spectrum = NULL;
+    cpstate->buf_data = NULL;
+    cpstate->fw = *FFT_WORKER_AUTO;
+
+    if (!Proc_state_init(&cpstate->parent, device, audio_rate, audio_buffer_size))
+    {
+        memory_free(cpstate);
+        return NULL;
+    }
+
+    cpstate->parent.destroy = del_Convolve_pstate;
+    cpstate->parent.reset = Convolve_pstate_reset;
+    cpstate->parent.render_mixed = Convolve_pstate_render_mixed;
+    cpstate->parent.clear_history = Convolve_pstate_clear_history;
+
+    const Proc_convolve* convolve = (const Proc_convolve*)device->dimpl;
+
+    if ((FFT_worker_init(&cpstate->fw, PART_SIZE * 2) == NULL) ||
+            !Convolve_pstate_alloc_buffers(cpstate, convolve->tail_partition_count))
+    {
+        del_Device_state(&cpstate->parent.parent);
+        return NULL;
+    }
+
+    return &cpstate->parent.parent;
+}
+
+
+bool Convolve_pstate_set_ir(
+        Device_state* dstate, const Key_indices indices, const Sample* value)
+{
+    rassert(dstate != NULL);
+    ignore(indices);
+    ignore(value);
+
+    Convolve_pstate* cpstate = (Convolve_pstate*)dstate;
+
+    const Proc_convolve* convolve = (const Proc_convolve*)dstate->device->dimpl;
+
+    return Convolve_pstate_alloc_buffers(cpstate, convolve->tail_partition_count);
+}
+
+
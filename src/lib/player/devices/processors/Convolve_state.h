@@ -0,0 +1,34 @@
+
+
+/*
+ * Author: agent, 2026
+ *
+ * This file is part of Kunquat.
+ *
+ * CC0 1.0 Universal, http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * To the extent possible under law, Kunquat Affirmers have waived all
+ * copyright and related or neighboring rights to Kunquat.
+ */
+
+
+#ifndef KQT_CONVOLVE_STATE_H
+#define KQT_CONVOLVE_STATE_H
+
+
+#include <init/devices/Device_impl.h>
+#include <player/devices/Device_state.h>
+#include <string/key_pattern.h>
+
+#include <stdbool.h>
+
+
+Device_state_create_func new_Convolve_pstate;
+
+bool Convolve_pstate_set_ir(
+        Device_state* dstate, const Key_indices indices, const Sample* value);
+
+
+#endif // KQT_CONVOLVE_STATE_H
+
+
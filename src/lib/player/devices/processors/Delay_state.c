@@ -30,6 +30,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 
 typedef struct Delay_pstate
@@ -116,6 +117,45 @@ enum
 };
 
 
+static void read_span(
+        float* dest,
+        const float* history,
+        int32_t history_size,
+        int32_t history_pos,
+        const float* in_buf,
+        int32_t start_pos,
+        int32_t count)
+{
+    rassert(dest != NULL);
+    rassert(history != NULL);
+    rassert(history_size > 0);
+    rassert(history_pos >= 0);
+    rassert(history_pos < history_size);
+    rassert(in_buf != NULL);
+    rassert(start_pos > -history_size);
+    rassert(count >= 0);
+
+    // Positions before the current block are read from the circular history
+    int32_t pos = start_pos;
+    int32_t remaining = count;
+    while ((remaining > 0) && (pos < 0))
+    {
+        const int32_t history_index = (history_pos + pos + history_size) % history_size;
+        const int32_t seg_count = min(min(remaining, -pos), history_size - history_index);
+        memcpy(dest, history + history_index, sizeof(float) * (size_t)seg_count);
+
+        dest += seg_count;
+        pos += seg_count;
+        remaining -= seg_count;
+    }
+
+    if (remaining > 0)
+        memcpy(dest, in_buf + pos, sizeof(float) * (size_t)remaining);
+
+    return;
+}
+
+
 static const int DELAY_WB_FIXED_INPUT = WORK_BUFFER_IMPL_1;
 static const int DELAY_WB_TOTAL_OFFSETS = WORK_BUFFER_IMPL_2;
 static const int DELAY_WB_FIXED_DELAY = WORK_BUFFER_IMPL_3;
@@ -188,13 +228,37 @@ static void Delay_pstate_render_mixed(
 
     const int32_t audio_rate = dstate->audio_rate;
 
+    // Check if the delay stays constant over the whole block
+    bool is_delay_const = true;
+    for (int32_t i = 1; i < frame_count; ++i)
+    {
+        if (delays[i] != delays[0])
+        {
+            is_delay_const = false;
+            break;
+        }
+    }
+
     // Get total offsets
-    for (int32_t i = 0, chunk_offset = 0; i < frame_count; ++i, ++chunk_offset)
+    int32_t const_start_pos = 0;
+    float const_remainder = 0;
+    if (is_delay_const)
     {
-        const float cur_delay = delays[i];
-        double delay_frames = cur_delay * (double)audio_rate;
-        delay_frames = clamp(delay_frames, 0, delay_max);
-        total_offsets[i] = (float)(chunk_offset - delay_frames);
+        const double delay_frames = clamp(delays[0] * (double)audio_rate, 0, delay_max);
+        const_start_pos = (int32_t)floor(-delay_frames);
+        const_remainder = (float)(-delay_frames - const_start_pos);
+        rassert(const_start_pos <= 0);
+        rassert(implies(const_start_pos == 0, const_remainder == 0));
+    }
+    else
+    {
+        for (int32_t i = 0, chunk_offset = 0; i < frame_count; ++i, ++chunk_offset)
+        {
+            const float cur_delay = delays[i];
+            double delay_frames = cur_delay * (double)audio_rate;
+            delay_frames = clamp(delay_frames, 0, delay_max);
+            total_offsets[i] = (float)(chunk_offset - delay_frames);
+        }
     }
 
     // Clamp input values to finite range
@@ -218,6 +282,37 @@ static void Delay_pstate_render_mixed(
 
         const float* history = history_data[ch];
 
+        if (is_delay_const)
+        {
+            // Copy contiguous spans and interpolate with a fixed remainder
+            read_span(
+                    out_buf,
+                    history,
+                    delay_buf_size,
+                    cur_dpstate_buf_pos,
+                    in_buf,
+                    const_start_pos,
+                    frame_count);
+
+            if (const_remainder > 0)
+            {
+                const int32_t last_pos = const_start_pos + frame_count;
+                rassert(last_pos < frame_count);
+                const float last_val = (last_pos >= 0)
+                    ? in_buf[last_pos]
+                    : history[
+                        (cur_dpstate_buf_pos + last_pos + delay_buf_size) %
+                        delay_buf_size];
+
+                for (int32_t i = 0; i < frame_count - 1; ++i)
+                    out_buf[i] = lerp(out_buf[i], out_buf[i + 1], const_remainder);
+                out_buf[frame_count - 1] =
+                    lerp(out_buf[frame_count - 1], last_val, const_remainder);
+            }
+
+            continue;
+        }
+
         for (int32_t i = 0; i < frame_count; ++i)
         {
             const float total_offset = total_offsets[i];
@@ -17,6 +17,7 @@
 
 #include <debug/assert.h>
 #include <init/devices/Device.h>
+#include <intrinsics.h>
 #include <init/devices/processors/Proc_filter.h>
 #include <kunquat/limits.h>
 #include <mathnum/common.h>
@@ -76,6 +77,25 @@ static bool Filter_state_is_neutral(const Filter_state_impl* fimpl)
 }
 
 
+// We are going to warp the normalised resonance with: (bias^res - 1) / (bias - 1)
+#define RES_BIAS_BASE 50.0
+
+
+static float get_biased_res_fast(double res_param, double res_bias_base_log2)
+{
+    const double biased_res_exp =
+        fast_exp2(res_bias_base_log2 * (100 - res_param) / 100.0);
+    return (float)((biased_res_exp - 1) * 2.0 / (RES_BIAS_BASE - 1));
+}
+
+
+static float get_biased_res(double res_param, double res_bias_base_log2)
+{
+    const double biased_res_exp = exp2(res_bias_base_log2 * (100 - res_param) / 100.0);
+    return (float)((biased_res_exp - 1) * 2.0 / (RES_BIAS_BASE - 1));
+}
+
+
 static const int CONTROL_WB_CUTOFF = WORK_BUFFER_IMPL_1;
 static const int CONTROL_WB_RESONANCE = WORK_BUFFER_IMPL_2;
 static const int FILTER_WB_SILENT_INPUT = WORK_BUFFER_IMPL_3;
@@ -105,7 +125,12 @@ static void Filter_state_impl_apply_input_buffers(
     // Fill cutoff buffer
     {
         transform_cutoff(
-                dest_cutoff_wb, cutoff_wb, filter->cutoff, frame_count, audio_rate);
+                dest_cutoff_wb,
+                cutoff_wb,
+                filter->cutoff,
+                frame_count,
+                audio_rate,
+                filter->control_interval);
         const int32_t const_cutoff_start = Work_buffer_get_const_start(dest_cutoff_wb);
         params_const_start = max(params_const_start, const_cutoff_start);
     }
@@ -116,9 +141,7 @@ static void Filter_state_impl_apply_input_buffers(
     float* resonances = Work_buffers_get_buffer_contents_mut(wbs, CONTROL_WB_RESONANCE);
 
     {
-        // We are going to warp the normalised resonance with: (bias^res - 1) / (bias - 1)
-        const double res_bias_base = 50.0;
-        const double res_bias_base_log2 = log2(res_bias_base);
+        const double res_bias_base_log2 = log2(RES_BIAS_BASE);
 
         int32_t fast_res_stop = 0;
         float const_res = NAN;
@@ -130,31 +153,22 @@ static void Filter_state_impl_apply_input_buffers(
             const float* resonance_buf = Work_buffer_get_contents(resonance_wb);
 
             // Get resonance values from input
-            for (int32_t i = 0; i < fast_res_stop; ++i)
-            {
-                const double res_param = resonance_buf[i];
-                const double biased_res_exp =
-                    fast_exp2(res_bias_base_log2 * (100 - res_param) / 100.0);
-                const float biased_res =
-                    (float)((biased_res_exp - 1) * 2.0 / (res_bias_base - 1));
+            const int32_t interval = filter->control_interval;
+            for (int32_t i = 0; i < fast_res_stop;
+                    i = Proc_get_next_control_point(i, interval, fast_res_stop))
+                resonances[i] =
+                    get_biased_res_fast(resonance_buf[i], res_bias_base_log2);
 
-                resonances[i] = biased_res;
-            }
+            Proc_interpolate_control_points(resonances, fast_res_stop, interval);
 
             if (fast_res_stop < frame_count)
-            {
-                const double biased_res_exp = exp2(
-                        res_bias_base_log2 *
-                        (100 - resonance_buf[fast_res_stop]) / 100.0);
-                const_res = (float)((biased_res_exp - 1) * 2.0 / (res_bias_base - 1));
-            }
+                const_res =
+                    get_biased_res(resonance_buf[fast_res_stop], res_bias_base_log2);
         }
         else
         {
             // Get our default resonance
-            const double biased_res_exp =
-                exp2(res_bias_base_log2 * (100 - filter->resonance) / 100.0);
-            const_res = (float)((biased_res_exp - 1) * 2.0 / (res_bias_base - 1));
+            const_res = get_biased_res(filter->resonance, res_bias_base_log2);
         }
 
         for (int32_t i = fast_res_stop; i < frame_count; ++i)
@@ -430,6 +444,335 @@ int32_t Filter_vstate_render_voice(
 }
 
 
+#define LANE_COUNT DEVICE_VOICE_LANES_MAX
+#define BATCH_CHUNK_SIZE 64
+
+
+static const int BATCH_WB_CUTOFF_FIRST = WORK_BUFFER_IMPL_1;
+static_assert(WORK_BUFFER_IMPL_1 + LANE_COUNT <= WORK_BUFFER_TIME_ENV,
+        "Not enough Work buffers for cutoffs of all lanes");
+
+static_assert(BATCH_CHUNK_SIZE % PROC_CONTROL_INTERVAL_MAX == 0,
+        "Control points of resonance must be aligned with chunks");
+
+
+static void apply_lanes(
+        Filter_ch_state* fstates[LANE_COUNT],
+        float* out,
+        const float* in,
+        const float* cutoffs,
+        const float* resonances,
+        bool is_lowpass,
+        int32_t frame_count)
+{
+    rassert(fstates != NULL);
+    rassert(out != NULL);
+    rassert(in != NULL);
+    rassert(cutoffs != NULL);
+    rassert(resonances != NULL);
+    rassert(frame_count > 0);
+
+    float s1s[LANE_COUNT] = { 0 };
+    float s2s[LANE_COUNT] = { 0 };
+    for (int lane = 0; lane < LANE_COUNT; ++lane)
+    {
+        if (fstates[lane] != NULL)
+        {
+            s1s[lane] = fstates[lane]->s1;
+            s2s[lane] = fstates[lane]->s2;
+        }
+    }
+
+#if KQT_SSE && (LANE_COUNT == 4)
+    __m128 s1 = _mm_loadu_ps(s1s);
+    __m128 s2 = _mm_loadu_ps(s2s);
+
+    const __m128 one = _mm_set1_ps(1.0f);
+
+    for (int32_t i = 0; i < frame_count; ++i)
+    {
+        const __m128 x = _mm_load_ps(in + (i * LANE_COUNT));
+        const __m128 g = _mm_load_ps(cutoffs + (i * LANE_COUNT));
+        const __m128 k = _mm_load_ps(resonances + (i * LANE_COUNT));
+
+        const __m128 hp_mult = _mm_div_ps(
+                one, _mm_add_ps(_mm_add_ps(one, _mm_mul_ps(k, g)), _mm_mul_ps(g, g)));
+        const __m128 hp_sample = _mm_mul_ps(
+                _mm_sub_ps(_mm_sub_ps(x, _mm_mul_ps(s1, _mm_add_ps(k, g))), s2),
+                hp_mult);
+
+        const __m128 input_1 = _mm_mul_ps(g, hp_sample);
+        const __m128 bp_sample = _mm_add_ps(input_1, s1);
+        s1 = _mm_add_ps(input_1, bp_sample);
+
+        const __m128 input_2 = _mm_mul_ps(g, bp_sample);
+        const __m128 lp_sample = _mm_add_ps(input_2, s2);
+        s2 = _mm_add_ps(input_2, lp_sample);
+
+        _mm_store_ps(out + (i * LANE_COUNT), is_lowpass ? lp_sample : hp_sample);
+    }
+
+    _mm_storeu_ps(s1s, s1);
+    _mm_storeu_ps(s2s, s2);
+#else
+    for (int32_t i = 0; i < frame_count; ++i)
+    {
+        for (int lane = 0; lane < LANE_COUNT; ++lane)
+        {
+            const int32_t index = (i * LANE_COUNT) + lane;
+            const float x = in[index];
+            const float g = cutoffs[index];
+            const float k = resonances[index];
+
+            const float hp_mult = 1.0f / (1.0f + (k * g) + (g * g));
+            const float hp_sample = (x - s1s[lane] * (k + g) - s2s[lane]) * hp_mult;
+
+            const float input_1 = g * hp_sample;
+            const float bp_sample = input_1 + s1s[lane];
+            s1s[lane] = input_1 + bp_sample;
+
+            const float input_2 = g * bp_sample;
+            const float lp_sample = input_2 + s2s[lane];
+            s2s[lane] = input_2 + lp_sample;
+
+            out[index] = is_lowpass ? lp_sample : hp_sample;
+        }
+    }
+#endif
+
+    for (int lane = 0; lane < LANE_COUNT; ++lane)
+    {
+        if (fstates[lane] != NULL)
+        {
+            fstates[lane]->s1 = s1s[lane];
+            fstates[lane]->s2 = s2s[lane];
+        }
+    }
+
+    return;
+}
+
+
+void Filter_vstate_render_voices(
+        Voice_state* vstates[LANE_COUNT],
+        Proc_state* proc_state,
+        const Device_thread_state* proc_ts,
+        const Au_state* au_state,
+        const Work_buffers* wbs,
+        int32_t frame_count,
+        double tempo,
+        int32_t rendered_counts[LANE_COUNT])
+{
+    rassert(vstates != NULL);
+    rassert(proc_state != NULL);
+    rassert(proc_ts != NULL);
+    rassert(au_state != NULL);
+    rassert(wbs != NULL);
+    rassert(frame_count > 0);
+    rassert(isfinite(tempo));
+    rassert(tempo > 0);
+    rassert(rendered_counts != NULL);
+
+    const Device_state* dstate = (const Device_state*)proc_state;
+    const Proc_filter* filter = (const Proc_filter*)dstate->device->dimpl;
+
+    const double res_bias_base_log2 = log2(RES_BIAS_BASE);
+
+    // Per-lane sources of our signals, inactive lanes run on silence
+    Filter_vstate* fvstates[LANE_COUNT] = { NULL };
+    const float* in_bufs[2][LANE_COUNT] = { { NULL } };
+    float* out_bufs[2][LANE_COUNT] = { { NULL } };
+    const float* cutoff_bufs[LANE_COUNT] = { NULL };
+    const float* resonance_bufs[LANE_COUNT] = { NULL };
+    int32_t fast_res_stops[LANE_COUNT] = { 0 };
+    float const_ress[LANE_COUNT] = { 0 };
+    bool has_input[LANE_COUNT] = { false };
+
+    bool any_active = false;
+
+    for (int lane = 0; lane < LANE_COUNT; ++lane)
+    {
+        Voice_state* vstate = vstates[lane];
+        if (vstate == NULL)
+            continue;
+
+        // Get audio outputs
+        for (int ch = 0; ch < 2; ++ch)
+        {
+            Work_buffer* out_wb = Device_thread_state_get_voice_lane_buffer(
+                    proc_ts, lane, DEVICE_PORT_TYPE_SEND, PORT_OUT_AUDIO_L + ch);
+            if (out_wb != NULL)
+                out_bufs[ch][lane] = Work_buffer_get_contents_mut(out_wb);
+        }
+        if ((out_bufs[0][lane] == NULL) && (out_bufs[1][lane] == NULL))
+        {
+            vstate->active = false;
+            continue;
+        }
+
+        fvstates[lane] = (Filter_vstate*)vstate;
+        rendered_counts[lane] = frame_count;
+        any_active = true;
+
+        // Get audio inputs
+        for (int ch = 0; ch < 2; ++ch)
+        {
+            const Work_buffer* in_wb = Device_thread_state_get_voice_lane_buffer(
+                    proc_ts, lane, DEVICE_PORT_TYPE_RECV, PORT_IN_AUDIO_L + ch);
+            if (Work_buffer_is_valid(in_wb))
+            {
+                in_bufs[ch][lane] = Work_buffer_get_contents(in_wb);
+                has_input[lane] = true;
+            }
+        }
+
+        // Fill cutoff buffer
+        const Work_buffer* cutoff_wb = Device_thread_state_get_voice_lane_buffer(
+                proc_ts, lane, DEVICE_PORT_TYPE_RECV, PORT_IN_CUTOFF);
+        Work_buffer* dest_cutoff_wb =
+            Work_buffers_get_buffer_mut(wbs, BATCH_WB_CUTOFF_FIRST + lane);
+        transform_cutoff(
+                dest_cutoff_wb,
+                cutoff_wb,
+                filter->cutoff,
+                frame_count,
+                dstate->audio_rate,
+                filter->control_interval);
+        cutoff_bufs[lane] = Work_buffer_get_contents(dest_cutoff_wb);
+
+        // Find resonance parameters, converted per chunk below
+        const Work_buffer* resonance_wb = Device_thread_state_get_voice_lane_buffer(
+                proc_ts, lane, DEVICE_PORT_TYPE_RECV, PORT_IN_RESONANCE);
+        if (Work_buffer_is_valid(resonance_wb))
+        {
+            const int32_t const_start = Work_buffer_get_const_start(resonance_wb);
+            fast_res_stops[lane] = min(const_start, frame_count);
+            resonance_bufs[lane] = Work_buffer_get_contents(resonance_wb);
+
+            if (fast_res_stops[lane] < frame_count)
+                const_ress[lane] = get_biased_res(
+                        resonance_bufs[lane][fast_res_stops[lane]], res_bias_base_log2);
+        }
+        else
+        {
+            const_ress[lane] = get_biased_res(filter->resonance, res_bias_base_log2);
+        }
+    }
+
+    if (!any_active)
+        return;
+
+    const bool is_lowpass = (filter->type == FILTER_TYPE_LOWPASS);
+
+    // Process interleaved chunks of all lanes
+    _Alignas(16) float cutoffs[BATCH_CHUNK_SIZE * LANE_COUNT] = { 0 };
+    _Alignas(16) float resonances[BATCH_CHUNK_SIZE * LANE_COUNT] = { 0 };
+    _Alignas(16) float in[BATCH_CHUNK_SIZE * LANE_COUNT] = { 0 };
+    _Alignas(16) float out[BATCH_CHUNK_SIZE * LANE_COUNT] = { 0 };
+
+    for (int32_t chunk_start = 0; chunk_start < frame_count;
+            chunk_start += BATCH_CHUNK_SIZE)
+    {
+        const int32_t chunk_size = min(frame_count - chunk_start, BATCH_CHUNK_SIZE);
+
+        for (int lane = 0; lane < LANE_COUNT; ++lane)
+        {
+            if (fvstates[lane] == NULL)
+                continue;
+
+            const float* lane_cutoffs = cutoff_bufs[lane] + chunk_start;
+            for (int32_t i = 0; i < chunk_size; ++i)
+                cutoffs[(i * LANE_COUNT) + lane] = lane_cutoffs[i];
+
+            const int32_t fast_res_stop = fast_res_stops[lane];
+            if ((filter->control_interval > 1) && (chunk_start < fast_res_stop))
+            {
+                // Include the first control point of the next chunk
+                const int32_t interval = filter->control_interval;
+                const int32_t res_stop =
+                    min(fast_res_stop - chunk_start, BATCH_CHUNK_SIZE + 1);
+                const float* lane_res_buf = resonance_bufs[lane] + chunk_start;
+
+                float lane_ress[BATCH_CHUNK_SIZE + 1];
+                for (int32_t i = 0; i < res_stop;
+                        i = Proc_get_next_control_point(i, interval, res_stop))
+                    lane_ress[i] =
+                        get_biased_res_fast(lane_res_buf[i], res_bias_base_log2);
+
+                Proc_interpolate_control_points(lane_ress, res_stop, interval);
+
+                for (int32_t i = 0; i < chunk_size; ++i)
+                    resonances[(i * LANE_COUNT) + lane] =
+                        (i < res_stop) ? lane_ress[i] : const_ress[lane];
+
+                continue;
+            }
+
+            for (int32_t i = 0; i < chunk_size; ++i)
+            {
+                const int32_t index = chunk_start + i;
+                resonances[(i * LANE_COUNT) + lane] = (index < fast_res_stop)
+                    ? get_biased_res_fast(resonance_bufs[lane][index], res_bias_base_log2)
+                    : const_ress[lane];
+            }
+        }
+
+        for (int ch = 0; ch < 2; ++ch)
+        {
+            Filter_ch_state* fstates[LANE_COUNT] = { NULL };
+            bool any_out = false;
+
+            for (int lane = 0; lane < LANE_COUNT; ++lane)
+            {
+                if ((fvstates[lane] == NULL) || (out_bufs[ch][lane] == NULL))
+                    continue;
+
+                fstates[lane] = &fvstates[lane]->state_impl.states[ch];
+                any_out = true;
+
+                const float* lane_in = in_bufs[ch][lane];
+                if (lane_in != NULL)
+                {
+                    for (int32_t i = 0; i < chunk_size; ++i)
+                        in[(i * LANE_COUNT) + lane] = lane_in[chunk_start + i];
+                }
+                else
+                {
+                    for (int32_t i = 0; i < chunk_size; ++i)
+                        in[(i * LANE_COUNT) + lane] = 0;
+                }
+            }
+
+            if (!any_out)
+                continue;
+
+            apply_lanes(
+                    fstates, out, in, cutoffs, resonances, is_lowpass, chunk_size);
+
+            for (int lane = 0; lane < LANE_COUNT; ++lane)
+            {
+                if (fstates[lane] == NULL)
+                    continue;
+
+                float* lane_out = out_bufs[ch][lane] + chunk_start;
+                for (int32_t i = 0; i < chunk_size; ++i)
+                    lane_out[i] = out[(i * LANE_COUNT) + lane];
+            }
+        }
+    }
+
+    for (int lane = 0; lane < LANE_COUNT; ++lane)
+    {
+        if ((fvstates[lane] != NULL) &&
+                !has_input[lane] &&
+                Filter_state_is_neutral(&fvstates[lane]->state_impl))
+            fvstates[lane]->parent.active = false;
+    }
+
+    return;
+}
+
+
 void Filter_vstate_init(Voice_state* vstate, const Proc_state* proc_state)
 {
     rassert(vstate != NULL);
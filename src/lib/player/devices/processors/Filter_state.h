@@ -28,6 +28,7 @@ Device_state_create_func new_Filter_pstate;
 Voice_state_get_size_func Filter_vstate_get_size;
 Voice_state_init_func Filter_vstate_init;
 Voice_state_render_voice_func Filter_vstate_render_voice;
+Voice_state_render_voices_func Filter_vstate_render_voices;
 
 
 #endif // KQT_FILTER_STATE_H
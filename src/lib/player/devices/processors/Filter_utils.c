@@ -19,6 +19,7 @@
 #include <mathnum/common.h>
 #include <mathnum/conversions.h>
 #include <mathnum/fast_tan.h>
+#include <player/devices/processors/Proc_state_utils.h>
 #include <player/Work_buffer.h>
 
 #include <math.h>
@@ -74,17 +75,64 @@ static float get_cutoff_ratio(double cutoff_param, int32_t audio_rate)
 }
 
 
+static void transform_cutoff_params_fast(
+        float* cutoffs, const float* params, int32_t count, int32_t audio_rate)
+{
+    rassert(cutoffs != NULL);
+    rassert(params != NULL);
+    rassert(count >= 0);
+    rassert(audio_rate > 0);
+
+#if ENABLE_FILTER_SSE
+    const __m128 inv_audio_rate = _mm_set_ps1((float)(1.0 / audio_rate));
+    for (int32_t i = 0; i < count; i += 4)
+    {
+        const __m128 cutoff_param = _mm_load_ps(params + i);
+        const __m128 offset = _mm_set_ps1(-24);
+        const __m128 scale = _mm_set_ps1(100);
+        const __m128 cutoff_ratio = _mm_mul_ps(
+                fast_cents_to_Hz_f4(
+                    _mm_mul_ps(_mm_add_ps(cutoff_param, offset), scale)),
+                inv_audio_rate);
+
+        const __m128 min_ratio = _mm_set_ps1((float)MIN_CUTOFF_RATIO);
+        const __m128 max_ratio = _mm_set_ps1((float)MAX_CUTOFF_RATIO);
+        const __m128 cutoff_ratio_clamped =
+            _mm_min_ps(_mm_max_ps(min_ratio, cutoff_ratio), max_ratio);
+
+        const __m128 cutoff = get_cutoff_fast_f4(cutoff_ratio_clamped);
+        _mm_store_ps(cutoffs + i, cutoff);
+    }
+#else
+    for (int32_t i = 0; i < count; ++i)
+    {
+        const double cutoff_param = params[i];
+        const double cutoff_ratio =
+            fast_cents_to_Hz((cutoff_param - 24) * 100) / audio_rate;
+        const double cutoff_ratio_clamped =
+            clamp(cutoff_ratio, MIN_CUTOFF_RATIO, MAX_CUTOFF_RATIO);
+
+        cutoffs[i] = get_cutoff_fast(cutoff_ratio_clamped);
+    }
+#endif
+
+    return;
+}
+
+
 void transform_cutoff(
         Work_buffer* dest,
         const Work_buffer* src,
         double def_cutoff,
         int32_t frame_count,
-        int32_t audio_rate)
+        int32_t audio_rate,
+        int32_t control_interval)
 {
     rassert(dest != NULL);
     rassert(isfinite(def_cutoff));
     rassert(frame_count > 0);
     rassert(audio_rate > 0);
+    rassert(Proc_is_valid_control_interval(control_interval));
 
     int32_t fast_cutoff_stop = 0;
     float const_cutoff = NAN;
@@ -98,38 +146,28 @@ void transform_cutoff(
         const float* cutoff_buf = Work_buffer_get_contents(src);
 
         // Get cutoff values from input
-#if ENABLE_FILTER_SSE
-        const __m128 inv_audio_rate = _mm_set_ps1((float)(1.0 / audio_rate));
-        for (int32_t i = 0; i < fast_cutoff_stop; i += 4)
+        if (control_interval > 1)
         {
-            const __m128 cutoff_param = _mm_load_ps(cutoff_buf + i);
-            const __m128 offset = _mm_set_ps1(-24);
-            const __m128 scale = _mm_set_ps1(100);
-            const __m128 cutoff_ratio = _mm_mul_ps(
-                    fast_cents_to_Hz_f4(
-                        _mm_mul_ps(_mm_add_ps(cutoff_param, offset), scale)),
-                    inv_audio_rate);
-
-            const __m128 min_ratio = _mm_set_ps1((float)MIN_CUTOFF_RATIO);
-            const __m128 max_ratio = _mm_set_ps1((float)MAX_CUTOFF_RATIO);
-            const __m128 cutoff_ratio_clamped =
-                _mm_min_ps(_mm_max_ps(min_ratio, cutoff_ratio), max_ratio);
-
-            const __m128 cutoff = get_cutoff_fast_f4(cutoff_ratio_clamped);
-            _mm_store_ps(cutoffs + i, cutoff);
+            // Transform the control points in compact form
+            int32_t point_count = 0;
+            const int32_t interval = control_interval;
+            for (int32_t i = 0; i < fast_cutoff_stop;
+                    i = Proc_get_next_control_point(i, interval, fast_cutoff_stop))
+                cutoffs[point_count++] = cutoff_buf[i];
+
+            transform_cutoff_params_fast(cutoffs, cutoffs, point_count, audio_rate);
+
+            // Move the control points to their positions, last one first
+            for (int32_t point = point_count - 1; point > 0; --point)
+                cutoffs[min(point * interval, fast_cutoff_stop - 1)] = cutoffs[point];
+
+            Proc_interpolate_control_points(cutoffs, fast_cutoff_stop, interval);
         }
-#else
-        for (int32_t i = 0; i < fast_cutoff_stop; ++i)
+        else
         {
-            const double cutoff_param = cutoff_buf[i];
-            const double cutoff_ratio =
-                fast_cents_to_Hz((cutoff_param - 24) * 100) / audio_rate;
-            const double cutoff_ratio_clamped =
-                clamp(cutoff_ratio, MIN_CUTOFF_RATIO, MAX_CUTOFF_RATIO);
-
-            cutoffs[i] = get_cutoff_fast(cutoff_ratio_clamped);
+            transform_cutoff_params_fast(
+                    cutoffs, cutoff_buf, fast_cutoff_stop, audio_rate);
         }
-#endif
 
         if (fast_cutoff_stop < frame_count)
         {
@@ -24,18 +24,21 @@
 /**
  * Convert parameter cutoff buffer to values expected by the filter implementation.
  *
- * \param dest          The destination buffer -- must not be \c NULL.
- * \param src           The source buffer, or \c NULL.
- * \param def_cutoff    Default cutoff value -- must be finite.
- * \param frame_count   Number of frames to be processed -- must be > \c 0.
- * \param audio_rate    The audio rate -- must be > \c 0.
+ * \param dest               The destination buffer -- must not be \c NULL.
+ * \param src                The source buffer, or \c NULL.
+ * \param def_cutoff         Default cutoff value -- must be finite.
+ * \param frame_count        Number of frames to be processed -- must be > \c 0.
+ * \param audio_rate         The audio rate -- must be > \c 0.
+ * \param control_interval   The control interval of the varying part of the
+ *                           cutoff -- must be valid.
  */
 void transform_cutoff(
         Work_buffer* dest,
         const Work_buffer* src,
         double def_cutoff,
         int32_t frame_count,
-        int32_t audio_rate);
+        int32_t audio_rate,
+        int32_t control_interval);
 
 
 #endif // KQT_FILTER_UTILS_H
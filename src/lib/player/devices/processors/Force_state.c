@@ -27,6 +27,7 @@
 #include <player/Time_env_state.h>
 #include <player/Work_buffers.h>
 
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -37,6 +38,8 @@ typedef struct Force_vstate
 
     double fixed_adjust;
     double release_ramp_progress;
+    bool is_release_forced;
+    double forced_release_progress;
 
     Force_controls controls;
     Time_env_state env_state;
@@ -140,76 +143,22 @@ int32_t Force_vstate_render_voice(
     Force_controls_set_audio_rate(fc, dstate->audio_rate);
     Force_controls_set_tempo(fc, tempo);
 
-    int32_t const_start = 0;
-
     int32_t new_buf_stop = frame_count;
 
     // Apply force slide & fixed adjust
-    {
-        const double fixed_adjust = fvstate->fixed_adjust;
-
-        int32_t cur_pos = 0;
-        while (cur_pos < frame_count)
-        {
-            const int32_t estimated_steps =
-                Slider_estimate_active_steps_left(&fc->slider);
-            if (estimated_steps > 0)
-            {
-                int32_t slide_stop = frame_count;
-                if (estimated_steps < frame_count - cur_pos)
-                    slide_stop = cur_pos + estimated_steps;
+    fc->force = Slider_fill(&fc->slider, out_wb, 0, frame_count, fc->force);
 
-                double new_force = fc->force;
-                for (int32_t i = cur_pos; i < slide_stop; ++i)
-                {
-                    new_force = Slider_step(&fc->slider);
-                    out_buf[i] = (float)(new_force + fixed_adjust);
-                }
-                fc->force = new_force;
-
-                const_start = slide_stop;
-                cur_pos = slide_stop;
-            }
-            else
-            {
-                const float actual_force = (float)(fc->force + fixed_adjust);
-                for (int32_t i = cur_pos; i < frame_count; ++i)
-                    out_buf[i] = actual_force;
-
-                cur_pos = frame_count;
-            }
-        }
+    if (fvstate->fixed_adjust != 0)
+    {
+        const float fixed_adjust = (float)fvstate->fixed_adjust;
+        for (int32_t i = 0; i < frame_count; ++i)
+            out_buf[i] += fixed_adjust;
     }
 
     // Apply tremolo
-    {
-        int32_t cur_pos = 0;
-        int32_t final_lfo_stop = 0;
-        while (cur_pos < frame_count)
-        {
-            const int32_t estimated_steps =
-                LFO_estimate_active_steps_left(&fc->tremolo);
-            if (estimated_steps > 0)
-            {
-                int32_t lfo_stop = frame_count;
-                if (estimated_steps < frame_count - cur_pos)
-                    lfo_stop = cur_pos + estimated_steps;
+    LFO_fill(&fc->tremolo, out_wb, 0, frame_count);
 
-                for (int32_t i = cur_pos; i < lfo_stop; ++i)
-                    out_buf[i] += (float)LFO_step(&fc->tremolo);
-
-                final_lfo_stop = lfo_stop;
-                cur_pos = lfo_stop;
-            }
-            else
-            {
-                final_lfo_stop = cur_pos;
-                break;
-            }
-        }
-
-        const_start = max(const_start, final_lfo_stop);
-    }
+    int32_t const_start = Work_buffer_get_const_start(out_wb);
 
     int32_t keep_alive_stop = frame_count;
 
@@ -361,6 +310,37 @@ int32_t Force_vstate_render_voice(
         }
     }
 
+    if (fvstate->is_release_forced)
+    {
+        // Fade out quickly regardless of the note state and release settings
+        const float ramp_step =
+            (float)(RAMP_RELEASE_SPEED / proc_state->parent.audio_rate);
+
+        double progress = fvstate->forced_release_progress;
+        int32_t i = 0;
+
+        for (i = 0; (i < frame_count) && (progress < 1); ++i)
+        {
+            out_buf[i] += (float)fast_scale_to_dB(1 - progress);
+            progress += ramp_step;
+        }
+
+        for (int32_t k = i; k < frame_count; ++k)
+            out_buf[k] = -INFINITY;
+
+        fvstate->forced_release_progress = progress;
+
+        if (progress >= 1)
+        {
+            const_start = i;
+            keep_alive_stop = min(keep_alive_stop, i);
+        }
+        else
+        {
+            const_start = frame_count;
+        }
+    }
+
     // Mark constant region of the buffer
     Work_buffer_set_const_start(out_wb, const_start);
     Work_buffer_set_final(out_wb, keep_alive_stop < frame_count);
@@ -391,6 +371,8 @@ void Force_vstate_init(Voice_state* vstate, const Proc_state* proc_state)
     }
 
     fvstate->release_ramp_progress = 0.0;
+    fvstate->is_release_forced = false;
+    fvstate->forced_release_progress = 0.0;
 
     Force_controls_init(&fvstate->controls, proc_state->parent.audio_rate, 120);
 
@@ -412,3 +394,58 @@ Force_controls* Force_vstate_get_force_controls_mut(Voice_state* vstate)
 }
 
 
+double Force_vstate_get_force(const Voice_state* vstate)
+{
+    rassert(vstate != NULL);
+    rassert(vstate->proc_type == Proc_type_force);
+
+    const Force_vstate* fvstate = (const Force_vstate*)vstate;
+
+    double force = fvstate->controls.force + fvstate->fixed_adjust;
+
+    // Include the envelope values from the most recent rendering step
+    const Time_env_state* env_states[] =
+    {
+        &fvstate->env_state,
+        &fvstate->release_env_state,
+    };
+    for (int i = 0; i < 2; ++i)
+    {
+        const double env_value = env_states[i]->cur_value;
+        if (isfinite(env_value))
+            force += scale_to_dB(max(env_value, 0.0));
+    }
+
+    if (fvstate->release_ramp_progress > 0)
+        force += scale_to_dB(max(1 - fvstate->release_ramp_progress, 0.0));
+
+    if (fvstate->forced_release_progress > 0)
+        force += scale_to_dB(max(1 - fvstate->forced_release_progress, 0.0));
+
+    return force;
+}
+
+
+void Force_vstate_force_release(Voice_state* vstate)
+{
+    rassert(vstate != NULL);
+    rassert(vstate->proc_type == Proc_type_force);
+
+    Force_vstate* fvstate = (Force_vstate*)vstate;
+    fvstate->is_release_forced = true;
+
+    return;
+}
+
+
+bool Force_vstate_is_release_forced(const Voice_state* vstate)
+{
+    rassert(vstate != NULL);
+    rassert(vstate->proc_type == Proc_type_force);
+
+    const Force_vstate* fvstate = (const Force_vstate*)vstate;
+
+    return fvstate->is_release_forced;
+}
+
+
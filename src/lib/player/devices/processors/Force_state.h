@@ -1,7 +1,7 @@
 
 
 /*
- * Author: Tomi Jylhä-Ollila, Finland 2016-2017
+ * Author: Tomi Jylhä-Ollila, Finland 2016-2019
  *
  * This file is part of Kunquat.
  *
@@ -20,6 +20,8 @@
 #include <player/devices/Voice_state.h>
 #include <player/Force_controls.h>
 
+#include <stdbool.h>
+
 
 Voice_state_get_size_func Force_vstate_get_size;
 Voice_state_init_func Force_vstate_init;
@@ -28,6 +30,37 @@ Voice_state_render_voice_func Force_vstate_render_voice;
 Force_controls* Force_vstate_get_force_controls_mut(Voice_state* vstate);
 
 
+/**
+ * Get an estimate of the current force of the Force Voice state.
+ *
+ * \param vstate   The Force Voice state -- must not be \c NULL.
+ *
+ * \return   The force in dB. This is \c -INFINITY if the Voice is silent.
+ */
+double Force_vstate_get_force(const Voice_state* vstate);
+
+
+/**
+ * Start a quick release ramp in the Force Voice state.
+ *
+ * The ramp fades the Voice out regardless of whether the note is on and of
+ * the release settings of the Force processor.
+ *
+ * \param vstate   The Force Voice state -- must not be \c NULL.
+ */
+void Force_vstate_force_release(Voice_state* vstate);
+
+
+/**
+ * Find out whether a release ramp has been started in the Force Voice state.
+ *
+ * \param vstate   The Force Voice state -- must not be \c NULL.
+ *
+ * \return   \c true if the release ramp has been started, otherwise \c false.
+ */
+bool Force_vstate_is_release_forced(const Voice_state* vstate);
+
+
 #endif // KQT_FORCE_STATE_H
 
 
@@ -68,31 +68,72 @@ void Freeverb_allpass_set_feedback(Freeverb_allpass* allpass, float feedback)
 }
 
 
-void Freeverb_allpass_process(
-        Freeverb_allpass* allpass, float* buffer, int32_t frame_count)
+static void process_range(
+        float* line, float feedback, float* buffer, int32_t frame_count)
 {
-    rassert(allpass != NULL);
+    rassert(line != NULL);
     rassert(buffer != NULL);
     rassert(frame_count > 0);
 
+    // Each delay line position is only used once, so we can process
+    // consecutive frames in parallel
+    int32_t i = 0;
+
 #if KQT_SSE
-    dassert(_MM_GET_FLUSH_ZERO_MODE() == _MM_FLUSH_ZERO_ON);
+    const __m128 feedbacks = _mm_set1_ps(feedback);
+    for (; i + 3 < frame_count; i += 4)
+    {
+        const __m128 bufout = _mm_loadu_ps(line + i);
+        const __m128 value = _mm_loadu_ps(buffer + i);
+        _mm_storeu_ps(line + i, _mm_add_ps(value, _mm_mul_ps(bufout, feedbacks)));
+        _mm_storeu_ps(buffer + i, _mm_sub_ps(bufout, value));
+    }
 #endif
 
-    for (int32_t i = 0; i < frame_count; ++i)
+    for (; i < frame_count; ++i)
     {
-        float bufout = allpass->buffer[allpass->buffer_pos];
+        float bufout = line[i];
 #if !KQT_SSE
         bufout = undenormalise(bufout);
 #endif
         const float value = buffer[i];
-        allpass->buffer[allpass->buffer_pos] = value + (bufout * allpass->feedback);
+        line[i] = value + (bufout * feedback);
 
         buffer[i] = -value + bufout;
+    }
+
+    return;
+}
 
-        ++allpass->buffer_pos;
+
+void Freeverb_allpass_process(
+        Freeverb_allpass* allpass, float* buffer, int32_t frame_count)
+{
+    rassert(allpass != NULL);
+    rassert(buffer != NULL);
+    rassert(frame_count > 0);
+
+#if KQT_SSE
+    dassert(_MM_GET_FLUSH_ZERO_MODE() == _MM_FLUSH_ZERO_ON);
+#endif
+
+    int32_t frames_done = 0;
+    while (frames_done < frame_count)
+    {
+        const int32_t chunk_size = min(
+                frame_count - frames_done, allpass->buffer_size - allpass->buffer_pos);
+
+        process_range(
+                allpass->buffer + allpass->buffer_pos,
+                allpass->feedback,
+                buffer + frames_done,
+                chunk_size);
+
+        allpass->buffer_pos += chunk_size;
         if (allpass->buffer_pos >= allpass->buffer_size)
             allpass->buffer_pos = 0;
+
+        frames_done += chunk_size;
     }
 
     return;
@@ -0,0 +1,292 @@
+
+
+/*
+ * Author: Tomi Jylhä-Ollila, Finland 2010-2019
+ *
+ * This file is part of Kunquat.
+ *
+ * CC0 1.0 Universal, http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * To the extent possible under law, Kunquat Affirmers have waived all
+ * copyright and related or neighboring rights to Kunquat.
+ */
+
+
+#include <player/devices/processors/Freeverb_comb_bank.h>
+
+#include <debug/assert.h>
+#include <intrinsics.h>
+#include <mathnum/common.h>
+#include <memory.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+
+
+#define LANE_COUNT FREEVERB_COMB_BANK_SIZE
+
+
+struct Freeverb_comb_bank
+{
+    float filter_stores[LANE_COUNT];
+    float* buffers[LANE_COUNT];
+    int32_t buffer_sizes[LANE_COUNT];
+    int32_t buffer_poss[LANE_COUNT];
+    float* buffer_data;
+};
+
+
+static bool Freeverb_comb_bank_set_buffers(
+        Freeverb_comb_bank* bank, const int32_t buffer_sizes[LANE_COUNT])
+{
+    rassert(bank != NULL);
+    rassert(buffer_sizes != NULL);
+
+    int64_t total_size = 0;
+    for (int i = 0; i < LANE_COUNT; ++i)
+    {
+        rassert(buffer_sizes[i] > 0);
+        total_size += buffer_sizes[i];
+    }
+
+    float* buffer_data = memory_realloc_items(float, total_size, bank->buffer_data);
+    if (buffer_data == NULL)
+        return false;
+
+    bank->buffer_data = buffer_data;
+
+    float* next_buffer = buffer_data;
+    for (int i = 0; i < LANE_COUNT; ++i)
+    {
+        bank->buffers[i] = next_buffer;
+        bank->buffer_sizes[i] = buffer_sizes[i];
+        bank->buffer_poss[i] = 0;
+        next_buffer += buffer_sizes[i];
+    }
+
+    Freeverb_comb_bank_clear(bank);
+
+    return true;
+}
+
+
+Freeverb_comb_bank* new_Freeverb_comb_bank(const int32_t buffer_sizes[LANE_COUNT])
+{
+    rassert(buffer_sizes != NULL);
+
+    Freeverb_comb_bank* bank = memory_alloc_item(Freeverb_comb_bank);
+    if (bank == NULL)
+        return NULL;
+
+    bank->buffer_data = NULL;
+    for (int i = 0; i < LANE_COUNT; ++i)
+    {
+        bank->filter_stores[i] = 0;
+        bank->buffers[i] = NULL;
+        bank->buffer_sizes[i] = 0;
+        bank->buffer_poss[i] = 0;
+    }
+
+    if (!Freeverb_comb_bank_set_buffers(bank, buffer_sizes))
+    {
+        del_Freeverb_comb_bank(bank);
+        return NULL;
+    }
+
+    return bank;
+}
+
+
+static void process_lanes(
+        float filter_stores[LANE_COUNT],
+        float* lines[LANE_COUNT],
+        float* out,
+        const float* in,
+        const float* refls,
+        const float* damps,
+        int32_t frame_count)
+{
+    rassert(filter_stores != NULL);
+    rassert(lines != NULL);
+    rassert(out != NULL);
+    rassert(in != NULL);
+    rassert(refls != NULL);
+    rassert(damps != NULL);
+    rassert(frame_count > 0);
+
+    float outputs[LANE_COUNT] = { 0 };
+    float writes[LANE_COUNT] = { 0 };
+
+#if KQT_SSE
+    dassert(_MM_GET_FLUSH_ZERO_MODE() == _MM_FLUSH_ZERO_ON);
+
+    __m128 stores_lo = _mm_loadu_ps(filter_stores);
+    __m128 stores_hi = _mm_loadu_ps(filter_stores + 4);
+
+    for (int32_t i = 0; i < frame_count; ++i)
+    {
+        const __m128 outputs_lo =
+            _mm_setr_ps(lines[0][i], lines[1][i], lines[2][i], lines[3][i]);
+        const __m128 outputs_hi =
+            _mm_setr_ps(lines[4][i], lines[5][i], lines[6][i], lines[7][i]);
+
+        const __m128 damp1 = _mm_set1_ps(damps[i]);
+        const __m128 damp2 = _mm_set1_ps(1 - damps[i]);
+        const __m128 refl = _mm_set1_ps(refls[i]);
+        const __m128 input = _mm_set1_ps(in[i]);
+
+        stores_lo = _mm_add_ps(
+                _mm_mul_ps(outputs_lo, damp2), _mm_mul_ps(stores_lo, damp1));
+        stores_hi = _mm_add_ps(
+                _mm_mul_ps(outputs_hi, damp2), _mm_mul_ps(stores_hi, damp1));
+
+        _mm_storeu_ps(writes, _mm_add_ps(input, _mm_mul_ps(stores_lo, refl)));
+        _mm_storeu_ps(writes + 4, _mm_add_ps(input, _mm_mul_ps(stores_hi, refl)));
+        _mm_storeu_ps(outputs, outputs_lo);
+        _mm_storeu_ps(outputs + 4, outputs_hi);
+
+        // Add outputs in the order of the combs to keep the result exact
+        float out_value = out[i];
+        for (int k = 0; k < LANE_COUNT; ++k)
+        {
+            lines[k][i] = writes[k];
+            out_value += outputs[k];
+        }
+        out[i] = out_value;
+    }
+
+    _mm_storeu_ps(filter_stores, stores_lo);
+    _mm_storeu_ps(filter_stores + 4, stores_hi);
+#else
+    float stores[LANE_COUNT] = { 0 };
+    for (int k = 0; k < LANE_COUNT; ++k)
+        stores[k] = filter_stores[k];
+
+    for (int32_t i = 0; i < frame_count; ++i)
+    {
+        const float damp1 = damps[i];
+        const float damp2 = 1 - damp1;
+        const float refl = refls[i];
+        const float input = in[i];
+
+        for (int k = 0; k < LANE_COUNT; ++k)
+        {
+            outputs[k] = undenormalise(lines[k][i]);
+            stores[k] = undenormalise((outputs[k] * damp2) + (stores[k] * damp1));
+            writes[k] = input + (stores[k] * refl);
+        }
+
+        float out_value = out[i];
+        for (int k = 0; k < LANE_COUNT; ++k)
+        {
+            lines[k][i] = writes[k];
+            out_value += outputs[k];
+        }
+        out[i] = out_value;
+    }
+
+    for (int k = 0; k < LANE_COUNT; ++k)
+        filter_stores[k] = stores[k];
+#endif
+
+    return;
+}
+
+
+void Freeverb_comb_bank_process(
+        Freeverb_comb_bank* bank,
+        float* out_buf,
+        const float* in_buf,
+        const float* refls,
+        const float* damps,
+        int32_t frame_count)
+{
+    rassert(bank != NULL);
+    rassert(out_buf != NULL);
+    rassert(in_buf != NULL);
+    rassert(refls != NULL);
+    rassert(damps != NULL);
+    rassert(frame_count > 0);
+
+    int32_t frames_done = 0;
+    while (frames_done < frame_count)
+    {
+        // Process the longest range where none of the delay lines wrap around
+        int32_t chunk_size = frame_count - frames_done;
+        float* lines[LANE_COUNT] = { NULL };
+        for (int k = 0; k < LANE_COUNT; ++k)
+        {
+            chunk_size = min(chunk_size, bank->buffer_sizes[k] - bank->buffer_poss[k]);
+            lines[k] = bank->buffers[k] + bank->buffer_poss[k];
+        }
+
+        rassert(chunk_size > 0);
+
+        process_lanes(
+                bank->filter_stores,
+                lines,
+                out_buf + frames_done,
+                in_buf + frames_done,
+                refls + frames_done,
+                damps + frames_done,
+                chunk_size);
+
+        for (int k = 0; k < LANE_COUNT; ++k)
+        {
+            bank->buffer_poss[k] += chunk_size;
+            if (bank->buffer_poss[k] >= bank->buffer_sizes[k])
+                bank->buffer_poss[k] = 0;
+        }
+
+        frames_done += chunk_size;
+    }
+
+    return;
+}
+
+
+bool Freeverb_comb_bank_resize_buffers(
+        Freeverb_comb_bank* bank, const int32_t new_sizes[LANE_COUNT])
+{
+    rassert(bank != NULL);
+    rassert(new_sizes != NULL);
+
+    bool is_changed = false;
+    for (int i = 0; i < LANE_COUNT; ++i)
+        is_changed |= (new_sizes[i] != bank->buffer_sizes[i]);
+
+    if (!is_changed)
+        return true;
+
+    return Freeverb_comb_bank_set_buffers(bank, new_sizes);
+}
+
+
+void Freeverb_comb_bank_clear(Freeverb_comb_bank* bank)
+{
+    rassert(bank != NULL);
+    rassert(bank->buffer_data != NULL);
+
+    for (int i = 0; i < LANE_COUNT; ++i)
+    {
+        bank->filter_stores[i] = 0;
+        for (int32_t k = 0; k < bank->buffer_sizes[i]; ++k)
+            bank->buffers[i][k] = 0;
+    }
+
+    return;
+}
+
+
+void del_Freeverb_comb_bank(Freeverb_comb_bank* bank)
+{
+    if (bank == NULL)
+        return;
+
+    memory_free(bank->buffer_data);
+    memory_free(bank);
+
+    return;
+}
+
+
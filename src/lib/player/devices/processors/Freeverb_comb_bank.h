@@ -0,0 +1,104 @@
+
+
+/*
+ * Author: Tomi Jylhä-Ollila, Finland 2010-2019
+ *
+ * This file is part of Kunquat.
+ *
+ * CC0 1.0 Universal, http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * To the extent possible under law, Kunquat Affirmers have waived all
+ * copyright and related or neighboring rights to Kunquat.
+ */
+
+
+#ifndef KQT_FREEVERB_COMB_BANK_H
+#define KQT_FREEVERB_COMB_BANK_H
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+
+#define FREEVERB_COMB_BANK_SIZE 8
+
+
+/**
+ * This is a bank of parallel lowpass-feedback-comb filters used by the
+ * Freeverb processor.
+ *
+ * All comb filters of the bank are advanced together, one frame at a time,
+ * with each filter occupying a separate SIMD lane. The delay lines of the
+ * filters are stored in a single contiguous block.
+ */
+typedef struct Freeverb_comb_bank Freeverb_comb_bank;
+
+
+/**
+ * Create a new Freeverb comb filter bank.
+ *
+ * \param buffer_sizes   The buffer sizes of the comb filters -- must not be
+ *                       \c NULL and the sizes must be > \c 0.
+ *
+ * \return   The new Freeverb comb filter bank if successful, or \c NULL if
+ *           memory allocation failed.
+ */
+Freeverb_comb_bank* new_Freeverb_comb_bank(
+        const int32_t buffer_sizes[FREEVERB_COMB_BANK_SIZE]);
+
+
+/**
+ * Process data buffer.
+ *
+ * The outputs of all comb filters are added to the output buffer in the
+ * order of the filters.
+ *
+ * \param bank          The Freeverb comb filter bank -- must not be \c NULL.
+ * \param out_buf       The output buffer -- must not be \c NULL.
+ * \param in_buf        The input buffer -- must not be \c NULL.
+ * \param refls         The reflectivity parameter buffer -- must not be \c NULL.
+ * \param damps         The damp parameter buffer -- must not be \c NULL.
+ * \param frame_count   Number of frames to be processed -- must be > \c 0.
+ */
+void Freeverb_comb_bank_process(
+        Freeverb_comb_bank* bank,
+        float* out_buf,
+        const float* in_buf,
+        const float* refls,
+        const float* damps,
+        int32_t frame_count);
+
+
+/**
+ * Resize the internal buffers of the Freeverb comb filter bank.
+ *
+ * \param bank        The Freeverb comb filter bank -- must not be \c NULL.
+ * \param new_sizes   The new buffer sizes -- must not be \c NULL and the
+ *                    sizes must be > \c 0.
+ *
+ * \return   \c true if successful, or \c false if memory allocation failed.
+ */
+bool Freeverb_comb_bank_resize_buffers(
+        Freeverb_comb_bank* bank, const int32_t new_sizes[FREEVERB_COMB_BANK_SIZE]);
+
+
+/**
+ * Clear the internal buffers of the Freeverb comb filter bank.
+ *
+ * \param bank   The Freeverb comb filter bank -- must not be \c NULL.
+ */
+void Freeverb_comb_bank_clear(Freeverb_comb_bank* bank);
+
+
+/**
+ * Destroy an existing Freeverb comb filter bank.
+ *
+ * \param bank   The Freeverb comb filter bank, or \c NULL.
+ */
+void del_Freeverb_comb_bank(Freeverb_comb_bank* bank);
+
+
+#endif // KQT_FREEVERB_COMB_BANK_H
+
+
@@ -23,12 +23,12 @@
 #include <memory.h>
 #include <player/devices/Device_thread_state.h>
 #include <player/devices/processors/Freeverb_allpass.h>
-#include <player/devices/processors/Freeverb_comb.h>
+#include <player/devices/processors/Freeverb_comb_bank.h>
 #include <player/devices/processors/Proc_state_utils.h>
 #include <player/Work_buffers.h>
 
 
-#define FREEVERB_COMBS 8
+#define FREEVERB_COMBS FREEVERB_COMB_BANK_SIZE
 #define FREEVERB_ALLPASSES 4
 
 
@@ -60,11 +60,26 @@ typedef struct Freeverb_pstate
 {
     Proc_state parent;
 
-    Freeverb_comb* combs[2][FREEVERB_COMBS];
+    Freeverb_comb_bank* comb_banks[2];
     Freeverb_allpass* allpasses[2][FREEVERB_ALLPASSES];
 } Freeverb_pstate;
 
 
+static void get_comb_sizes(int32_t sizes[2][FREEVERB_COMBS], int32_t audio_rate)
+{
+    rassert(sizes != NULL);
+    rassert(audio_rate > 0);
+
+    for (int i = 0; i < FREEVERB_COMBS; ++i)
+    {
+        sizes[0][i] = (int32_t)max(1, comb_tuning[i] * audio_rate);
+        sizes[1][i] = (int32_t)max(1, (comb_tuning[i] + stereo_spread) * audio_rate);
+    }
+
+    return;
+}
+
+
 static void del_Freeverb_pstate(Device_state* dstate)
 {
     rassert(dstate != NULL);
@@ -73,8 +88,7 @@ static void del_Freeverb_pstate(Device_state* dstate)
 
     for (int ch = 0; ch < 2; ++ch)
     {
-        for (int i = 0; i < FREEVERB_COMBS; ++i)
-            del_Freeverb_comb(fpstate->combs[ch][i]);
+        del_Freeverb_comb_bank(fpstate->comb_banks[ch]);
 
         for (int i = 0; i < FREEVERB_ALLPASSES; ++i)
             del_Freeverb_allpass(fpstate->allpasses[ch][i]);
@@ -94,10 +108,7 @@ static void Freeverb_pstate_reset(Device_state* dstate)
 
     for (int ch = 0; ch < 2; ++ch)
     {
-        for (int i = 0; i < FREEVERB_COMBS; ++i)
-        {
-            Freeverb_comb_clear(fstate->combs[ch][i]);
-        }
+        Freeverb_comb_bank_clear(fstate->comb_banks[ch]);
 
         for (int i = 0; i < FREEVERB_ALLPASSES; ++i)
         {
@@ -117,18 +128,16 @@ static bool Freeverb_pstate_set_audio_rate(Device_state* dstate, int32_t audio_r
 
     Freeverb_pstate* fstate = (Freeverb_pstate*)dstate;
 
-    for (int i = 0; i < FREEVERB_COMBS; ++i)
     {
-        const int32_t left_size = (int32_t)max(1, comb_tuning[i] * audio_rate);
-
-        if (!Freeverb_comb_resize_buffer(fstate->combs[0][i], left_size))
-            return false;
+        int32_t comb_sizes[2][FREEVERB_COMBS] = { { 0 } };
+        get_comb_sizes(comb_sizes, audio_rate);
 
-        const int32_t right_size =
-            (int32_t)max(1, (comb_tuning[i] + stereo_spread) * audio_rate);
-
-        if (!Freeverb_comb_resize_buffer(fstate->combs[1][i], right_size))
-            return false;
+        for (int ch = 0; ch < 2; ++ch)
+        {
+            if (!Freeverb_comb_bank_resize_buffers(
+                        fstate->comb_banks[ch], comb_sizes[ch]))
+                return false;
+        }
     }
 
     for (int i = 0; i < FREEVERB_ALLPASSES; ++i)
@@ -320,14 +329,13 @@ static void Freeverb_pstate_render_mixed(
             Work_buffer_clear(out_wb, 0, frame_count);
             float* out_contents = Work_buffer_get_contents_mut(out_wb);
 
-            for (int comb_index = 0; comb_index < FREEVERB_COMBS; ++comb_index)
-                Freeverb_comb_process(
-                        fstate->combs[ch][comb_index],
-                        out_contents,
-                        comb_input,
-                        refls,
-                        damps,
-                        frame_count);
+            Freeverb_comb_bank_process(
+                    fstate->comb_banks[ch],
+                    out_contents,
+                    comb_input,
+                    refls,
+                    damps,
+                    frame_count);
 
             for (int allpass_index = 0; allpass_index < FREEVERB_ALLPASSES; ++allpass_index)
                 Freeverb_allpass_process(
@@ -368,32 +376,24 @@ Device_state* new_Freeverb_pstate(
 
     for (int ch = 0; ch < 2; ++ch)
     {
-        for (int i = 0; i < FREEVERB_COMBS; ++i)
-            fpstate->combs[ch][i] = NULL;
+        fpstate->comb_banks[ch] = NULL;
 
         for (int i = 0; i < FREEVERB_ALLPASSES; ++i)
             fpstate->allpasses[ch][i] = NULL;
     }
 
-    for (int i = 0; i < FREEVERB_COMBS; ++i)
     {
-        const int32_t left_size = (int32_t)max(1, comb_tuning[i] * audio_rate);
-
-        fpstate->combs[0][i] = new_Freeverb_comb(left_size);
-        if (fpstate->combs[0][i] == NULL)
-        {
-            del_Device_state(&fpstate->parent.parent);
-            return NULL;
-        }
-
-        const int32_t right_size =
-            (int32_t)max(1, (comb_tuning[i] + stereo_spread) * audio_rate);
+        int32_t comb_sizes[2][FREEVERB_COMBS] = { { 0 } };
+        get_comb_sizes(comb_sizes, audio_rate);
 
-        fpstate->combs[1][i] = new_Freeverb_comb(right_size);
-        if (fpstate->combs[1][i] == NULL)
+        for (int ch = 0; ch < 2; ++ch)
         {
-            del_Device_state(&fpstate->parent.parent);
-            return NULL;
+            fpstate->comb_banks[ch] = new_Freeverb_comb_bank(comb_sizes[ch]);
+            if (fpstate->comb_banks[ch] == NULL)
+            {
+                del_Device_state(&fpstate->parent.parent);
+                return NULL;
+            }
         }
     }
 
@@ -39,7 +39,52 @@ static void distort(
     rassert(out_buffer != NULL);
     rassert(frame_count > 0);
 
-    if (gc->is_map_enabled && (gc->map != NULL))
+    if (gc->is_map_enabled && (gc->map_table != NULL))
+    {
+        rassert(gc->map != NULL);
+
+        const float* in_values = Work_buffer_get_contents(in_buffer);
+        float* out_values = Work_buffer_get_contents_mut(out_buffer);
+
+        const float* table = gc->map_table;
+
+        // The comparisons below also map NaN values inside the table range
+        if (gc->is_map_symmetric)
+        {
+            const float pos_scale = (float)GAINCOMP_MAP_TABLE_SIZE;
+            for (int32_t i = 0; i < frame_count; ++i)
+            {
+                const float in_value = in_values[i];
+                const float abs_value = fabsf(in_value);
+                const float x = (abs_value < 1.0f) ? abs_value : 1.0f;
+
+                const float pos = x * pos_scale;
+                const int32_t index = min((int32_t)pos, GAINCOMP_MAP_TABLE_SIZE - 1);
+                const float t = pos - (float)index;
+
+                const float out_value =
+                    table[index] + (table[index + 1] - table[index]) * t;
+                out_values[i] = (in_value < 0) ? -out_value : out_value;
+            }
+        }
+        else
+        {
+            const float pos_scale = (float)(GAINCOMP_MAP_TABLE_SIZE / 2);
+            for (int32_t i = 0; i < frame_count; ++i)
+            {
+                const float in_value = in_values[i];
+                const float lower_bounded = (in_value > -1.0f) ? in_value : -1.0f;
+                const float x = (lower_bounded < 1.0f) ? lower_bounded : 1.0f;
+
+                const float pos = (x + 1.0f) * pos_scale;
+                const int32_t index = min((int32_t)pos, GAINCOMP_MAP_TABLE_SIZE - 1);
+                const float t = pos - (float)index;
+
+                out_values[i] = table[index] + (table[index + 1] - table[index]) * t;
+            }
+        }
+    }
+    else if (gc->is_map_enabled && (gc->map != NULL))
     {
         const float* in_values = Work_buffer_get_contents(in_buffer);
         float* out_values = Work_buffer_get_contents_mut(out_buffer);
@@ -0,0 +1,320 @@
+
+
+/*
+ * Author: agent, 2026
+ *
+ * This file is part of Kunquat.
+ *
+ * CC0 1.0 Universal, http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * To the extent possible under law, Kunquat Affirmers have waived all
+ * copyright and related or neighboring rights to Kunquat.
+ */
+
+
+#include <player/devices/processors/Ks_resample.h>
+
+#include <debug/assert.h>
+#include <intrinsics.h>
+#include <mathnum/common.h>
+#include <threads/Mutex.h>
+
+#include <math.h>
+#include <stdalign.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+
+#define SINC_WINDOW_EXTENT KS_SINC_WINDOW_EXTENT
+#define RESAMPLE_HISTORY_SIZE KS_SINC_TAP_COUNT
+
+
+// Windowed sinc coefficients, RESAMPLE_HISTORY_SIZE for each of the
+// KS_SINC_PHASE_COUNT + 1 phase offsets in the range [0, 1]
+static alignas(64) float sinc_table[
+    (KS_SINC_PHASE_COUNT + 1) * RESAMPLE_HISTORY_SIZE] = { 0 };
+
+#ifdef ENABLE_THREADS
+static Mutex sinc_table_lock = MUTEX_STATIC_INIT;
+#endif
+static bool is_sinc_table_ready = false;
+
+
+static void fill_sinc_table(void)
+{
+    for (int phase = 0; phase <= KS_SINC_PHASE_COUNT; ++phase)
+    {
+        const double shift_rem = phase / (double)KS_SINC_PHASE_COUNT;
+        float* row = sinc_table + phase * RESAMPLE_HISTORY_SIZE;
+
+        for (int i = 0; i < RESAMPLE_HISTORY_SIZE; ++i)
+        {
+            const double shift = (i - SINC_WINDOW_EXTENT + 1) - shift_rem;
+            if (shift == 0)
+            {
+                row[i] = 1;
+                continue;
+            }
+
+            const double w = shift / SINC_WINDOW_EXTENT;
+            const double w2 = w * w;
+            const double window = 0.5 * w2 * w2 + 1.5 * (1 - w2) - 0.5;
+            const double sinc = sin(shift * PI) / (shift * PI);
+            row[i] = (float)(sinc * window);
+        }
+    }
+
+    return;
+}
+
+
+void Ks_resample_init_sinc_table(void)
+{
+#ifdef ENABLE_THREADS
+    Mutex_lock(&sinc_table_lock);
+#endif
+
+    if (!is_sinc_table_ready)
+    {
+        fill_sinc_table();
+        is_sinc_table_ready = true;
+    }
+
+#ifdef ENABLE_THREADS
+    Mutex_unlock(&sinc_table_lock);
+#endif
+
+    return;
+}
+
+
+void Resample_state_init(Resample_state* state, int32_t from_rate, int32_t to_rate)
+{
+    rassert(state != NULL);
+    rassert(is_sinc_table_ready);
+    rassert(from_rate > 0);
+    rassert(to_rate > 0);
+
+    state->from_wb = NULL;
+    state->to_wb = NULL;
+    state->from_rate = from_rate;
+    state->to_rate = to_rate;
+
+    for (int i = 0; i < RESAMPLE_HISTORY_SIZE; ++i)
+        state->in_history[i] = 0;
+
+    state->from_index = 0;
+    state->sub_phase = 0;
+    state->ds_sub_phase = 0;
+    state->to_index = 0;
+
+    return;
+}
+
+
+void Resample_state_prepare_render(
+        Resample_state* state, const Work_buffer* from_wb, Work_buffer* to_wb)
+{
+    rassert(state != NULL);
+
+    state->from_wb = from_wb;
+    state->to_wb = to_wb;
+    state->from_index = 0;
+    state->to_index = 0;
+
+    return;
+}
+
+
+#define USE_SSE_SINC KQT_SSE
+
+#if USE_SSE_SINC
+
+static_assert(RESAMPLE_HISTORY_SIZE % 4 == 0,
+        "RESAMPLE_HISTORY_SIZE is incompatible with the SSE sinc implementation.");
+
+static float make_sinc_item(const float history[RESAMPLE_HISTORY_SIZE], float shift_rem)
+{
+    dassert(history != NULL);
+    dassert(shift_rem > 0);
+    dassert(shift_rem < 1);
+
+    // Interpolate linearly between the two nearest precomputed phases
+    const float pos = shift_rem * (float)KS_SINC_PHASE_COUNT;
+    const int phase = (int)pos;
+    const __m128 lerp = _mm_set1_ps(pos - (float)phase);
+    const float* row1 = sinc_table + phase * RESAMPLE_HISTORY_SIZE;
+    const float* row2 = row1 + RESAMPLE_HISTORY_SIZE;
+
+    __m128 results = _mm_set1_ps(0);
+
+    for (int i = 0; i < RESAMPLE_HISTORY_SIZE; i += 4)
+    {
+        const __m128 coeffs1 = _mm_load_ps(row1 + i);
+        const __m128 coeffs2 = _mm_load_ps(row2 + i);
+        const __m128 coeffs = _mm_add_ps(
+                coeffs1, _mm_mul_ps(lerp, _mm_sub_ps(coeffs2, coeffs1)));
+
+        const __m128 items = _mm_load_ps(history + i);
+        results = _mm_add_ps(results, _mm_mul_ps(coeffs, items));
+    }
+
+    float ra[4];
+    _mm_store_ps(ra, results);
+    const float result = ra[0] + ra[1] + ra[2] + ra[3];
+    return result;
+}
+
+#else
+
+static float make_sinc_item(const float history[RESAMPLE_HISTORY_SIZE], float shift_rem)
+{
+    dassert(history != NULL);
+    dassert(shift_rem > 0);
+    dassert(shift_rem < 1);
+
+    // Interpolate linearly between the two nearest precomputed phases
+    const float pos = shift_rem * (float)KS_SINC_PHASE_COUNT;
+    const int phase = (int)pos;
+    const float lerp = pos - (float)phase;
+    const float* row1 = sinc_table + phase * RESAMPLE_HISTORY_SIZE;
+    const float* row2 = row1 + RESAMPLE_HISTORY_SIZE;
+
+    float result = 0;
+    for (int i = 0; i < RESAMPLE_HISTORY_SIZE; ++i)
+    {
+        const float coeff = row1[i] + lerp * (row2[i] - row1[i]);
+        result += coeff * history[i];
+    }
+
+    return result;
+}
+
+#endif // USE_SSE_SINC
+
+
+void Resample_state_process(
+        Resample_state* state, int32_t req_input_count, int32_t req_output_count)
+{
+    rassert(state != NULL);
+    rassert(state->from_wb != NULL);
+    rassert(state->to_wb != NULL);
+    rassert(state->from_rate > 0);
+    rassert(state->to_rate > 0);
+    rassert(state->from_rate != state->to_rate);
+    rassert(req_input_count >= 0);
+    rassert(req_output_count > 0);
+
+    const int32_t sub_phase_div = max(state->from_rate, state->to_rate);
+    const int32_t sub_phase_add = min(state->from_rate, state->to_rate);
+
+    int32_t from_index = state->from_index;
+    const int32_t from_size = Work_buffer_get_size(state->from_wb);
+
+    int32_t sub_phase = state->sub_phase;
+
+    int32_t to_index = state->to_index;
+    const int32_t to_size = Work_buffer_get_size(state->to_wb);
+
+    const float* from = Work_buffer_get_contents(state->from_wb);
+    float* to = Work_buffer_get_contents_mut(state->to_wb);
+
+    float* in_history = state->in_history;
+
+    if (state->to_rate < state->from_rate)
+    {
+        int32_t ds_sub_phase = state->ds_sub_phase;
+        const int32_t ds_sub_phase_div = min(state->from_rate, state->to_rate);
+        const int32_t ds_sub_phase_add = max(state->from_rate, state->to_rate);
+
+        // Downsample
+        rassert(req_input_count > 0);
+        const int32_t max_input_count = from_size - from_index;
+        rassert(max_input_count > 0);
+        const int32_t actual_input_count = min(req_input_count, max_input_count);
+        const int32_t output_stop = (req_output_count < INT32_MAX - to_index)
+            ? to_index + req_output_count : INT32_MAX;
+
+        for (int32_t i = 0; i < actual_input_count; ++i)
+        {
+            // Leave the input frame unconsumed if its output would not fit
+            if ((sub_phase + sub_phase_add >= sub_phase_div) &&
+                    (to_index >= output_stop))
+                break;
+
+            const int last_history_index = RESAMPLE_HISTORY_SIZE - 1;
+            for (int k = 0; k < last_history_index; ++k)
+                in_history[k] = in_history[k + 1];
+            in_history[last_history_index] = from[from_index];
+
+            ++from_index;
+
+            sub_phase += sub_phase_add;
+            if (sub_phase >= sub_phase_div)
+            {
+                ds_sub_phase = (ds_sub_phase + ds_sub_phase_add) % ds_sub_phase_div;
+                sub_phase -= sub_phase_div;
+
+                if (sub_phase > 0)
+                    to[to_index] = make_sinc_item(
+                            in_history,
+                            ((float)ds_sub_phase / (float)ds_sub_phase_div));
+                else
+                    to[to_index] = in_history[SINC_WINDOW_EXTENT];
+
+                ++to_index;
+            }
+        }
+
+        state->ds_sub_phase = ds_sub_phase;
+    }
+    else
+    {
+        // Upsample
+        const int32_t max_output_count = to_size - to_index;
+        rassert(max_output_count > 0);
+        const int32_t actual_output_count = min(req_output_count, max_output_count);
+        const int32_t input_stop = (req_input_count < INT32_MAX - from_index)
+            ? from_index + req_input_count : INT32_MAX;
+
+        for (int32_t i = 0; i < actual_output_count; ++i)
+        {
+            sub_phase += sub_phase_add;
+            if (sub_phase >= sub_phase_div)
+            {
+                if (from_index >= input_stop)
+                {
+                    sub_phase -= sub_phase_add;
+                    break;
+                }
+
+                sub_phase -= sub_phase_div;
+
+                const int last_history_index = RESAMPLE_HISTORY_SIZE - 1;
+                for (int k = 0; k < last_history_index; ++k)
+                    in_history[k] = in_history[k + 1];
+                in_history[last_history_index] = from[from_index];
+
+                ++from_index;
+            }
+
+            if (sub_phase > 0)
+                to[to_index] = make_sinc_item(
+                        in_history,
+                        (float)sub_phase / (float)sub_phase_div);
+            else
+                to[to_index] = in_history[SINC_WINDOW_EXTENT - 1];
+
+            ++to_index;
+        }
+    }
+
+    state->from_index = from_index;
+    state->sub_phase = sub_phase;
+    state->to_index = to_index;
+
+    return;
+}
+
+
@@ -0,0 +1,105 @@
+
+
+/*
+ * Author: agent, 2026
+ *
+ * This file is part of Kunquat.
+ *
+ * CC0 1.0 Universal, http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * To the extent possible under law, Kunquat Affirmers have waived all
+ * copyright and related or neighboring rights to Kunquat.
+ */
+
+
+#ifndef KQT_KS_RESAMPLE_H
+#define KQT_KS_RESAMPLE_H
+
+
+#include <player/Work_buffer.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+
+
+#define KS_SINC_WINDOW_EXTENT 8
+#define KS_SINC_TAP_COUNT (KS_SINC_WINDOW_EXTENT * 2)
+#define KS_SINC_PHASE_COUNT 256
+
+
+/**
+ * Windowed sinc resampler between the system audio rate and the internal audio
+ * rate of a Karplus-Strong processor.
+ */
+typedef struct Resample_state
+{
+    // Configuration
+    const Work_buffer* from_wb;
+    Work_buffer* to_wb;
+    int32_t from_rate;
+    int32_t to_rate;
+
+    // State
+    _Alignas(64) float in_history[KS_SINC_TAP_COUNT];
+    int32_t from_index;
+    int32_t sub_phase;
+    int32_t ds_sub_phase;
+    int32_t to_index;
+} Resample_state;
+
+
+/**
+ * Initialise the sinc coefficients shared by all Karplus-Strong processors.
+ *
+ * This function must be called before \a Resample_state_init. It may be called
+ * from several threads, and subsequent calls have no effect.
+ */
+void Ks_resample_init_sinc_table(void);
+
+
+/**
+ * Initialise a Resample state.
+ *
+ * \param state       The Resample state -- must not be \c NULL.
+ * \param from_rate   The audio rate of the input -- must be > \c 0.
+ * \param to_rate     The audio rate of the output -- must be > \c 0.
+ */
+void Resample_state_init(Resample_state* state, int32_t from_rate, int32_t to_rate);
+
+
+/**
+ * Set the buffers of the Resample state for a new render call.
+ *
+ * The input history is kept so that the output continues seamlessly.
+ *
+ * \param state     The Resample state -- must not be \c NULL.
+ * \param from_wb   The input Work buffer.
+ * \param to_wb     The output Work buffer.
+ */
+void Resample_state_prepare_render(
+        Resample_state* state, const Work_buffer* from_wb, Work_buffer* to_wb);
+
+
+/**
+ * Resample audio data.
+ *
+ * Downsampling stops after \a req_input_count input frames or before writing
+ * more than \a req_output_count output frames, and upsampling stops after
+ * \a req_output_count output frames or before reading more than
+ * \a req_input_count input frames. The progress is stored in the
+ * \a from_index and \a to_index fields of \a state.
+ *
+ * \param state              The Resample state -- must not be \c NULL and
+ *                           must have different input and output rates.
+ * \param req_input_count    The maximum number of input frames -- must be
+ *                           >= \c 0, and > \c 0 when downsampling.
+ * \param req_output_count   The maximum number of output frames -- must be
+ *                           > \c 0.
+ */
+void Resample_state_process(
+        Resample_state* state, int32_t req_input_count, int32_t req_output_count);
+
+
+#endif // KQT_KS_RESAMPLE_H
+
+
@@ -17,19 +17,18 @@
 #include <debug/assert.h>
 #include <init/devices/Device.h>
 #include <init/devices/processors/Proc_ks.h>
-#include <intrinsics.h>
 #include <mathnum/common.h>
 #include <mathnum/conversions.h>
 #include <mathnum/Random.h>
 #include <player/devices/Device_thread_state.h>
 #include <player/devices/processors/Filter.h>
+#include <player/devices/processors/Ks_resample.h>
 #include <player/devices/processors/Proc_state_utils.h>
 #include <player/devices/Voice_state.h>
 #include <player/Work_buffer.h>
 #include <player/Work_buffers.h>
 
 #include <math.h>
-#include <stdalign.h>
 #include <stdint.h>
 #include <stdlib.h>
 
@@ -227,285 +226,6 @@ static void Read_state_copy(Read_state* restrict dest, const Read_state* restric
 }
 
 
-#define SINC_WINDOW_EXTENT 8
-#define RESAMPLE_HISTORY_SIZE (SINC_WINDOW_EXTENT * 2)
-
-
-typedef struct Resample_state
-{
-    // Configuration
-    const Work_buffer* from_wb;
-    Work_buffer* to_wb;
-    int32_t from_rate;
-    int32_t to_rate;
-
-    // State
-    _Alignas(64) float in_history[RESAMPLE_HISTORY_SIZE];
-    int32_t from_index;
-    int32_t sub_phase;
-    int32_t ds_sub_phase;
-    int32_t to_index;
-} Resample_state;
-
-
-static void Resample_state_init(
-        Resample_state* state, int32_t from_rate, int32_t to_rate)
-{
-    rassert(state != NULL);
-    rassert(from_rate > 0);
-    rassert(to_rate > 0);
-
-    state->from_wb = NULL;
-    state->to_wb = NULL;
-    state->from_rate = from_rate;
-    state->to_rate = to_rate;
-
-    for (int i = 0; i < RESAMPLE_HISTORY_SIZE; ++i)
-        state->in_history[i] = 0;
-
-    state->from_index = 0;
-    state->sub_phase = 0;
-    state->ds_sub_phase = 0;
-    state->to_index = 0;
-
-    return;
-}
-
-
-static void Resample_state_prepare_render(
-        Resample_state* state, const Work_buffer* from_wb, Work_buffer* to_wb)
-{
-    rassert(state != NULL);
-
-    state->from_wb = from_wb;
-    state->to_wb = to_wb;
-    state->from_index = 0;
-    state->to_index = 0;
-
-    return;
-}
-
-
-#define USE_SSE_SINC KQT_SSE
-
-#if USE_SSE_SINC
-
-static_assert(RESAMPLE_HISTORY_SIZE % 4 == 0,
-        "RESAMPLE_HISTORY_SIZE is incompatible with the SSE sinc implementation.");
-
-static float make_sinc_item(float history[RESAMPLE_HISTORY_SIZE], float shift_rem)
-{
-    dassert(history != NULL);
-    dassert(shift_rem > 0);
-
-    const __m128 shift_rem_adds =
-        _mm_set_ps(3 - shift_rem, 2 - shift_rem, 1 - shift_rem, -shift_rem);
-    int shift_floor = -SINC_WINDOW_EXTENT + 1;
-    float rep_sin_shift = sinf(((float)shift_floor - shift_rem) * (float)PI);
-    const __m128 rep_sin_shifts =
-        _mm_set_ps(-rep_sin_shift, rep_sin_shift, -rep_sin_shift, rep_sin_shift);
-
-    const __m128 window_scale = _mm_set1_ps(1.0f / (float)SINC_WINDOW_EXTENT);
-    const __m128 pi = _mm_set1_ps((float)PI);
-
-    __m128 results = _mm_set1_ps(0);
-
-    for (int i = 0; i < RESAMPLE_HISTORY_SIZE; i += 4)
-    {
-        const __m128 shifts =
-            _mm_add_ps(_mm_set1_ps((float)shift_floor), shift_rem_adds);
-
-        const __m128 w = _mm_mul_ps(shifts, window_scale);
-        const __m128 w2 = _mm_mul_ps(w, w);
-        const __m128 w4 = _mm_mul_ps(w2, w2);
-        const __m128 part4 = _mm_mul_ps(_mm_set1_ps(0.5f), w4);
-        const __m128 part2 =
-            _mm_mul_ps(_mm_set1_ps(1.5f), _mm_sub_ps(_mm_set1_ps(1.0f), w2));
-        const __m128 window = _mm_add_ps(_mm_add_ps(part4, part2), _mm_set1_ps(-0.5f));
-
-        const __m128 items = _mm_load_ps(history + i);
-        const __m128 add = _mm_mul_ps(
-                _mm_mul_ps(_mm_div_ps(rep_sin_shifts, _mm_mul_ps(shifts, pi)), window),
-                items);
-
-        results = _mm_add_ps(results, add);
-
-        shift_floor += 4;
-    }
-
-    float ra[4];
-    _mm_store_ps(ra, results);
-    const float result = ra[0] + ra[1] + ra[2] + ra[3];
-    return result;
-}
-
-#else
-
-#if 0
-static float sinc_norm(float x)
-{
-    dassert(x != 0);
-    const float scaled_x = x * (float)PI;
-    return sinf(scaled_x) / scaled_x;
-}
-#endif
-
-static float make_sinc_item(float history[RESAMPLE_HISTORY_SIZE], float shift_rem)
-{
-    dassert(history != NULL);
-    dassert(shift_rem > 0);
-
-    int8_t shift_floor = -SINC_WINDOW_EXTENT + 1;
-    float rep_sin_shift = sinf((shift_floor - shift_rem) * (float)PI);
-
-    float result = 0;
-    for (int i = 0; i < RESAMPLE_HISTORY_SIZE; ++i)
-    {
-        const float shift = shift_floor - shift_rem;
-        const float w = shift / SINC_WINDOW_EXTENT;
-        const float w2 = w * w;
-        const float w4 = w2 * w2;
-        const float window = 0.5f * w4 + 1.5f * (1 - w2) - 0.5f;
-        //const float window = sinc_norm(shift / SINC_WINDOW_EXTENT);
-        const float add = (rep_sin_shift / (shift * (float)PI)) * window * history[i];
-
-        rep_sin_shift = -rep_sin_shift;
-        result += add;
-        ++shift_floor;
-    }
-
-    return result;
-}
-
-#endif // USE_SSE_SINC
-
-
-static void Resample_state_process(
-        Resample_state* state, int32_t req_input_count, int32_t req_output_count)
-{
-    rassert(state != NULL);
-    rassert(state->from_wb != NULL);
-    rassert(state->to_wb != NULL);
-    rassert(state->from_rate > 0);
-    rassert(state->to_rate > 0);
-    rassert(state->from_rate != state->to_rate);
-    rassert(req_input_count >= 0);
-    rassert(req_output_count > 0);
-
-    const int32_t sub_phase_div = max(state->from_rate, state->to_rate);
-    const int32_t sub_phase_add = min(state->from_rate, state->to_rate);
-
-    int32_t from_index = state->from_index;
-    const int32_t from_size = Work_buffer_get_size(state->from_wb);
-
-    int32_t sub_phase = state->sub_phase;
-
-    int32_t to_index = state->to_index;
-    const int32_t to_size = Work_buffer_get_size(state->to_wb);
-
-    const float* from = Work_buffer_get_contents(state->from_wb);
-    float* to = Work_buffer_get_contents_mut(state->to_wb);
-
-    float* in_history = state->in_history;
-
-    if (state->to_rate < state->from_rate)
-    {
-        int32_t ds_sub_phase = state->ds_sub_phase;
-        const int32_t ds_sub_phase_div = min(state->from_rate, state->to_rate);
-        const int32_t ds_sub_phase_add = max(state->from_rate, state->to_rate);
-
-        // Downsample
-        rassert(req_input_count > 0);
-        const int32_t max_input_count = from_size - from_index;
-        rassert(max_input_count > 0);
-        const int32_t actual_input_count = min(req_input_count, max_input_count);
-        const int32_t output_stop = (req_output_count < INT32_MAX - to_index)
-            ? to_index + req_output_count : INT32_MAX;
-
-        for (int32_t i = 0; i < actual_input_count; ++i)
-        {
-            const int last_history_index = RESAMPLE_HISTORY_SIZE - 1;
-            for (int k = 0; k < last_history_index; ++k)
-                in_history[k] = in_history[k + 1];
-            in_history[last_history_index] = from[from_index];
-
-            ++from_index;
-
-            sub_phase += sub_phase_add;
-            if (sub_phase >= sub_phase_div)
-            {
-                ds_sub_phase = (ds_sub_phase + ds_sub_phase_add) % ds_sub_phase_div;
-
-                if (to_index >= output_stop)
-                {
-                    sub_phase -= sub_phase_add;
-                    ds_sub_phase = (ds_sub_phase + ds_sub_phase_div - ds_sub_phase_add) %
-                        ds_sub_phase_div;
-                    break;
-                }
-
-                sub_phase -= sub_phase_div;
-
-                if (sub_phase > 0)
-                    to[to_index] = make_sinc_item(
-                            in_history, ((float)ds_sub_phase / (float)ds_sub_phase_div));
-                else
-                    to[to_index] = in_history[SINC_WINDOW_EXTENT];
-
-                ++to_index;
-            }
-        }
-
-        state->ds_sub_phase = ds_sub_phase;
-    }
-    else
-    {
-        // Upsample
-        const int32_t max_output_count = to_size - to_index;
-        rassert(max_output_count > 0);
-        const int32_t actual_output_count = min(req_output_count, max_output_count);
-        const int32_t input_stop = (req_input_count < INT32_MAX - from_index)
-            ? from_index + req_input_count : INT32_MAX;
-
-        for (int32_t i = 0; i < actual_output_count; ++i)
-        {
-            sub_phase += sub_phase_add;
-            if (sub_phase >= sub_phase_div)
-            {
-                if (from_index >= input_stop)
-                {
-                    sub_phase -= sub_phase_add;
-                    break;
-                }
-
-                sub_phase -= sub_phase_div;
-
-                const int last_history_index = RESAMPLE_HISTORY_SIZE - 1;
-                for (int k = 0; k < last_history_index; ++k)
-                    in_history[k] = in_history[k + 1];
-                in_history[last_history_index] = from[from_index];
-
-                ++from_index;
-            }
-
-            if (sub_phase > 0)
-                to[to_index] = make_sinc_item(
-                        in_history, (float)sub_phase / (float)sub_phase_div);
-            else
-                to[to_index] = in_history[SINC_WINDOW_EXTENT - 1];
-
-            ++to_index;
-        }
-    }
-
-    state->from_index = from_index;
-    state->sub_phase = sub_phase;
-    state->to_index = to_index;
-
-    return;
-}
-
-
 #define RESAMPLE_LP_ORDER 6
 
 
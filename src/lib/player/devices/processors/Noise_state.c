@@ -158,21 +158,23 @@ int32_t Noise_vstate_render_voice(
         double* buf = noise_vstate->buf[ch];
         Random* random = &noise_vstate->rands[ch];
 
-        if (order >= 0)
+        // Generate white noise in the output buffer and filter it in place
+        Random_get_float_signal_block(random, out, frame_count);
+
+        if (order > 0)
+        {
+            for (int32_t i = 0; i < frame_count; ++i)
+                out[i] = scales[i] * (float)dc_zero_filter(order, buf, out[i]);
+        }
+        else if (order < 0)
         {
             for (int32_t i = 0; i < frame_count; ++i)
-            {
-                *out++ = scales[i] *
-                    (float)dc_zero_filter(order, buf, Random_get_float_signal(random));
-            }
+                out[i] = scales[i] * (float)dc_pole_filter(-order, buf, out[i]);
         }
         else
         {
             for (int32_t i = 0; i < frame_count; ++i)
-            {
-                *out++ = scales[i] *
-                    (float)dc_pole_filter(-order, buf, Random_get_float_signal(random));
-            }
+                out[i] *= scales[i];
         }
     }
 
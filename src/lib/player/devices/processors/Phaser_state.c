@@ -128,7 +128,13 @@ static void Phaser_impl_update(
 
     // Get transformed cutoff values
     Work_buffer* dest_cutoff_wb = Work_buffers_get_buffer_mut(wbs, PHASER_WB_CUTOFF);
-    transform_cutoff(dest_cutoff_wb, cutoff_wb, phaser->cutoff, frame_count, audio_rate);
+    transform_cutoff(
+            dest_cutoff_wb,
+            cutoff_wb,
+            phaser->cutoff,
+            frame_count,
+            audio_rate,
+            phaser->control_interval);
 
     const float* cutoffs = Work_buffer_get_contents(dest_cutoff_wb);
 
@@ -154,8 +160,11 @@ static void Phaser_impl_update(
             const_start = Work_buffer_get_const_start(bandwidth_wb);
             const_start = min(const_start, frame_count);
 
+            const int32_t interval = phaser->control_interval;
+
             const float* src_bws = Work_buffer_get_contents(bandwidth_wb);
-            for (int32_t i = 0; i < const_start; ++i)
+            for (int32_t i = 0; i < const_start;
+                    i = Proc_get_next_control_point(i, interval, const_start))
             {
                 float bw = src_bws[i];
                 bw = clamp(bw, (float)PHASER_BANDWIDTH_MIN, (float)PHASER_BANDWIDTH_MAX);
@@ -167,6 +176,8 @@ static void Phaser_impl_update(
                 bws[i] = sinh_bw * bw_cot_mult;
             }
 
+            Proc_interpolate_control_points(bws, const_start, interval);
+
             if (const_start < frame_count)
                 fixed_bw = clamp(
                         src_bws[const_start],
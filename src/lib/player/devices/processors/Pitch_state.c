@@ -93,42 +93,8 @@ int32_t Pitch_vstate_render_voice(
     Pitch_controls_set_audio_rate(pc, dstate->audio_rate);
     Pitch_controls_set_tempo(pc, tempo);
 
-    int32_t const_start = 0;
-
     // Apply pitch slide
-    {
-        int32_t cur_pos = 0;
-        while (cur_pos < frame_count)
-        {
-            const int32_t estimated_steps =
-                Slider_estimate_active_steps_left(&pc->slider);
-            if (estimated_steps > 0)
-            {
-                int32_t slide_stop = frame_count;
-                if (estimated_steps < frame_count - cur_pos)
-                    slide_stop = cur_pos + estimated_steps;
-
-                double new_pitch = pc->pitch;
-                for (int32_t i = cur_pos; i < slide_stop; ++i)
-                {
-                    new_pitch = Slider_step(&pc->slider);
-                    out_buf[i] = (float)new_pitch;
-                }
-                pc->pitch = new_pitch;
-
-                const_start = slide_stop;
-                cur_pos = slide_stop;
-            }
-            else
-            {
-                const float pitch = (float)pc->pitch;
-                for (int32_t i = cur_pos; i < frame_count; ++i)
-                    out_buf[i] = pitch;
-
-                cur_pos = frame_count;
-            }
-        }
-    }
+    pc->pitch = Slider_fill(&pc->slider, out_wb, 0, frame_count, pc->pitch);
 
     // Adjust carried pitch
     if (pc->pitch_add != 0)
@@ -138,41 +104,11 @@ int32_t Pitch_vstate_render_voice(
     }
 
     // Apply vibrato
-    {
-        int32_t cur_pos = 0;
-        int32_t final_lfo_stop = 0;
-        while (cur_pos < frame_count)
-        {
-            const int32_t estimated_steps =
-                LFO_estimate_active_steps_left(&pc->vibrato);
-            if (estimated_steps > 0)
-            {
-                int32_t lfo_stop = frame_count;
-                if (estimated_steps < frame_count - cur_pos)
-                    lfo_stop = cur_pos + estimated_steps;
-
-                for (int32_t i = cur_pos; i < lfo_stop; ++i)
-                    out_buf[i] += (float)LFO_step(&pc->vibrato);
-
-                final_lfo_stop = lfo_stop;
-                cur_pos = lfo_stop;
-            }
-            else
-            {
-                final_lfo_stop = cur_pos;
-                break;
-            }
-        }
-
-        const_start = max(const_start, final_lfo_stop);
-    }
+    LFO_fill(&pc->vibrato, out_wb, 0, frame_count);
 
     // Update pitch for next iteration
     pvstate->pitch = out_buf[frame_count - 1];
 
-    // Mark constant region of the buffer
-    Work_buffer_set_const_start(out_wb, const_start);
-
     return frame_count;
 }
 
@@ -20,6 +20,7 @@
 #include <kunquat/limits.h>
 #include <mathnum/common.h>
 #include <mathnum/conversions.h>
+#include <mathnum/fast_exp2.h>
 #include <memory.h>
 #include <player/devices/Device_thread_state.h>
 #include <player/devices/Proc_state.h>
@@ -118,24 +119,41 @@ void Proc_fill_freq_buffer(
 
     if (Work_buffer_is_valid(pitches))
     {
-        Proc_clamp_pitch_values(pitches, buf_start, buf_stop);
-
         const int32_t const_start = Work_buffer_get_const_start(pitches);
         float* freqs_data = Work_buffer_get_contents_mut(freqs);
 
-        float* pitches_data = Work_buffer_get_contents_mut(pitches);
+        const float* pitches_data = Work_buffer_get_contents(pitches);
 
         const int32_t fast_stop = clamp(const_start, buf_start, buf_stop);
 
-        for (int32_t i = buf_start; i < fast_stop; ++i)
-            freqs_data[i] = (float)fast_cents_to_Hz(pitches_data[i]);
+        const float bound = 2000000.0f;
+
+        float const_pitch = NAN;
+        if (fast_stop < buf_stop)
+            const_pitch = pitches_data[fast_stop];
+
+        // Convert the varying part via exponents, non-finite pitches yield 0 Hz
+        {
+            const float inv_cents = 1.0f / 1200.0f;
+            for (int32_t i = buf_start; i < fast_stop; ++i)
+            {
+                const float pitch = pitches_data[i];
+                freqs_data[i] = isfinite(pitch) ? (pitch * inv_cents) : -INFINITY;
+            }
+
+            float* fast_freqs = freqs_data + buf_start;
+            fast_exp2_block(fast_freqs, fast_freqs, fast_stop - buf_start);
+
+            for (int32_t i = buf_start; i < fast_stop; ++i)
+                freqs_data[i] *= 440.0f;
+        }
 
         //fprintf(stdout, "%d %d %d\n", (int)buf_start, (int)fast_stop, (int)buf_stop);
 
         if (fast_stop < buf_stop)
         {
-            const float pitch = pitches_data[fast_stop];
-            const float freq = isfinite(pitch) ? (float)cents_to_Hz(pitch) : 0.0f;
+            const float freq = isfinite(const_pitch)
+                ? (float)cents_to_Hz(clamp(const_pitch, -bound, bound)) : 0.0f;
             for (int32_t i = fast_stop; i < buf_stop; ++i)
                 freqs_data[i] = freq;
         }
@@ -171,39 +189,18 @@ void Proc_fill_scale_buffer(Work_buffer* scales, Work_buffer* dBs, int32_t frame
         const int32_t fast_stop = min(const_start, frame_count);
 
         float const_dB = -INFINITY;
+        if (fast_stop < frame_count)
+            const_dB = clamp(dBs_data[fast_stop], -10000.0f, 10000.0f);
 
-#if KQT_SSE4_1
+        // Convert the varying part via exponents
         {
-            if (fast_stop < frame_count)
-                const_dB = clamp(dBs_data[fast_stop], -10000.0f, 10000.0f);
-
-            const __m128 min_dB = _mm_set1_ps(-500);
-            const __m128 max_dB = _mm_set1_ps(500);
-
-            for (int32_t i = 0; i < fast_stop; i += 4)
-            {
-                const __m128 dB = _mm_load_ps(dBs_data + i);
-                const __m128 clamped_dB = _mm_min_ps(_mm_max_ps(min_dB, dB), max_dB);
-                const __m128 scale = fast_dB_to_scale_f4(clamped_dB);
-                _mm_store_ps(scales_data + i, scale);
-            }
-        }
-#else
-        // Sanitise input values
-        {
-            const float bound = 10000.0f;
-
+            const float inv_dB = 1.0f / 6.0f;
             for (int32_t i = 0; i < fast_stop; ++i)
-                dBs_data[i] = clamp(dBs_data[i], -bound, bound);
+                scales_data[i] = dBs_data[i] * inv_dB;
 
-            if (fast_stop < frame_count)
-                const_dB = clamp(dBs_data[fast_stop], -bound, bound);
+            fast_exp2_block(scales_data, scales_data, fast_stop);
         }
 
-        for (int32_t i = 0; i < fast_stop; ++i)
-            scales_data[i] = (float)fast_dB_to_scale(dBs_data[i]);
-#endif
-
         //fprintf(stdout, "%d %d %d\n", 0, (int)fast_stop, (int)frame_count);
 
         if (fast_stop < frame_count)
@@ -259,6 +256,78 @@ void Proc_clamp_pitch_values(Work_buffer* pitches, int32_t buf_start, int32_t bu
 }
 
 
+bool Proc_is_valid_control_interval(int64_t interval)
+{
+    return (interval >= 1) &&
+        (interval <= PROC_CONTROL_INTERVAL_MAX) &&
+        ((interval & (interval - 1)) == 0);
+}
+
+
+void Proc_set_control_interval(int32_t* interval, int64_t value)
+{
+    rassert(interval != NULL);
+
+    if (!Proc_is_valid_control_interval(value))
+        return;
+
+    *interval = (int32_t)value;
+
+    return;
+}
+
+
+void Proc_interpolate_control_points(float* values, int32_t stop, int32_t interval)
+{
+    rassert(values != NULL);
+    rassert(stop >= 0);
+    rassert(Proc_is_valid_control_interval(interval));
+
+    if (interval == 1)
+        return;
+
+    const int32_t last = stop - 1;
+    int32_t start = 0;
+
+#if KQT_SSE
+    if (interval >= 4)
+    {
+        // Full segments have space for whole vectors
+        const __m128 inv_interval = _mm_set1_ps(1.0f / (float)interval);
+        const __m128 four = _mm_set1_ps(4.0f);
+
+        for (; start + interval <= last; start += interval)
+        {
+            const __m128 start_value = _mm_set1_ps(values[start]);
+            const __m128 end_value = _mm_set1_ps(values[start + interval]);
+            const __m128 step =
+                _mm_mul_ps(_mm_sub_ps(end_value, start_value), inv_interval);
+
+            __m128 offsets = _mm_set_ps(3, 2, 1, 0);
+            for (int32_t i = start; i < start + interval; i += 4)
+            {
+                const __m128 value = _mm_add_ps(start_value, _mm_mul_ps(step, offsets));
+                _mm_storeu_ps(values + i, value);
+                offsets = _mm_add_ps(offsets, four);
+            }
+        }
+    }
+#endif
+
+    for (; start < last; start += interval)
+    {
+        const int32_t end = min(start + interval, last);
+        const float start_value = values[start];
+        const float step = (values[end] - start_value) / (float)(end - start);
+
+        for (int32_t i = start + 1; i < end; ++i)
+            values[i] = start_value + step * (float)(i - start);
+    }
+
+    return;
+}
+
+
 Cond_work_buffer* Cond_work_buffer_init(
         Cond_work_buffer* cwb, const Work_buffer* wb, float def_value)
 {
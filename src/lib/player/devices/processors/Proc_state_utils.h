@@ -19,6 +19,7 @@
 #include <debug/assert.h>
 #include <decl.h>
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
 
@@ -67,9 +68,14 @@ void Proc_ramp_attack(
  *       If that is not the case, the const start value of \a freqs may be
  *       incorrect.
  *
+ * Values that change within the buffer area are converted with
+ * \a fast_exp2_block, so their relative error is below \c 1e-6 with SSE2.
+ * The constant tail of the buffer is converted exactly.
+ *
  * \param freqs       The destination buffer -- must not be \c NULL.
  * \param pitches     The pitch buffer -- must not be \c NULL. This buffer may
- *                    be the same as \a freqs.
+ *                    be the same as \a freqs. Non-finite pitches produce
+ *                    frequencies of \c 0.
  * \param buf_start   The start index of the buffer area to be processed.
  * \param buf_stop    The stop index of the buffer area to be processed.
  */
@@ -88,6 +94,10 @@ void Proc_fill_freq_buffer(
  *       If that is not the case, the const start value of \a scales may be
  *       incorrect.
  *
+ * Values that change within the buffer are converted with
+ * \a fast_exp2_block, so their relative error is below \c 1e-6 with SSE2.
+ * The constant tail of the buffer is converted exactly.
+ *
  * \param scales        The destination buffer -- must not be \c NULL.
  * \param dBs           The decibel buffer -- must not be \c NULL. This buffer
  *                      may be the same as \a scales.
@@ -107,6 +117,79 @@ void Proc_fill_scale_buffer(Work_buffer* scales, Work_buffer* dBs, int32_t frame
 void Proc_clamp_pitch_values(Work_buffer* pitches, int32_t buf_start, int32_t buf_stop);
 
 
+/**
+ * The maximum control interval of processors that support control rate
+ * evaluation of their parameters.
+ *
+ * In control rate evaluation, parameter coefficients are calculated at
+ * control points that are located at each multiple of the control interval
+ * and at the last frame of the varying part of the buffer. The coefficients
+ * between control points are interpolated linearly.
+ */
+#define PROC_CONTROL_INTERVAL_MAX 64
+
+
+/**
+ * Check if a value is a valid control interval.
+ *
+ * \param interval   The control interval.
+ *
+ * \return   \c true if \a interval is a power of two in the range
+ *           [1, \c PROC_CONTROL_INTERVAL_MAX], otherwise \c false.
+ */
+bool Proc_is_valid_control_interval(int64_t interval);
+
+
+/**
+ * Set the control interval of a processor from a parameter value.
+ *
+ * Like other integer parameters, the control interval is not changed if the
+ * new value is out of range.
+ *
+ * \param interval   The control interval to be modified -- must not be
+ *                   \c NULL.
+ * \param value      The new control interval.
+ */
+void Proc_set_control_interval(int32_t* interval, int64_t value);
+
+
+/**
+ * Get the next control point in a buffer area.
+ *
+ * \param index      The current control point -- must be >= \c 0 and
+ *                   < \a stop.
+ * \param interval   The control interval -- must be valid.
+ * \param stop       The stop index of the buffer area.
+ *
+ * \return   The next control point, or \a stop if \a index is the last one.
+ */
+static inline int32_t Proc_get_next_control_point(
+        int32_t index, int32_t interval, int32_t stop)
+{
+    dassert(index >= 0);
+    dassert(index < stop);
+    dassert(interval > 0);
+
+    if (index == stop - 1)
+        return stop;
+
+    const int32_t next = index + interval;
+    return (next < stop) ? next : stop - 1;
+}
+
+
+/**
+ * Interpolate values between control points.
+ *
+ * \param values     The values with the control points filled in
+ *                   -- must not be \c NULL.
+ * \param stop       The stop index of the area to be processed -- must be
+ *                   >= \c 0.
+ * \param interval   The control interval -- must be valid.
+ */
+void Proc_interpolate_control_points(float* values, int32_t stop, int32_t interval);
+
+
 /**
  * A helper for conditional Work buffer access.
  *
@@ -0,0 +1,499 @@
+
+
+/*
+ * Author: agent, 2026
+ *
+ * This file is part of Kunquat.
+ *
+ * CC0 1.0 Universal, http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * To the extent possible under law, Kunquat Affirmers have waived all
+ * copyright and related or neighboring rights to Kunquat.
+ */
+
+
+#include <player/devices/processors/Sample_interp.h>
+
+#include <debug/assert.h>
+#include <intrinsics.h>
+#include <mathnum/common.h>
+#include <threads/Mutex.h>
+
+#include <math.h>
+#include <stdalign.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#define SAMPLE_INTERP_PHASE_COUNT 256
+
+#define SAMPLE_CUBIC_TAP_COUNT 4
+#define SAMPLE_CUBIC_TAPS_BEFORE 1
+
+#define SAMPLE_SINC_WINDOW_EXTENT 4
+#define SAMPLE_SINC_TAP_COUNT (SAMPLE_SINC_WINDOW_EXTENT * 2)
+#define SAMPLE_SINC_TAPS_BEFORE (SAMPLE_SINC_WINDOW_EXTENT - 1)
+#define SAMPLE_SINC_KAISER_BETA 5.0
+
+
+// Interpolation coefficients for SAMPLE_INTERP_PHASE_COUNT + 1 phase offsets
+// in the range [0, 1], one row of taps for each offset
+static alignas(64) float cubic_table[
+    (SAMPLE_INTERP_PHASE_COUNT + 1) * SAMPLE_CUBIC_TAP_COUNT] = { 0 };
+static alignas(64) float sinc_table[
+    (SAMPLE_INTERP_PHASE_COUNT + 1) * SAMPLE_SINC_TAP_COUNT] = { 0 };
+
+#ifdef ENABLE_THREADS
+static Mutex tables_lock = MUTEX_STATIC_INIT;
+#endif
+static bool are_tables_ready = false;
+
+
+static void fill_cubic_table(void)
+{
+    // Catmull-Rom spline through the taps at offsets -1, 0, 1 and 2
+    for (int phase = 0; phase <= SAMPLE_INTERP_PHASE_COUNT; ++phase)
+    {
+        const double t = phase / (double)SAMPLE_INTERP_PHASE_COUNT;
+        const double t2 = t * t;
+        const double t3 = t2 * t;
+
+        float* row = cubic_table + phase * SAMPLE_CUBIC_TAP_COUNT;
+        row[0] = (float)(0.5 * (-t3 + 2 * t2 - t));
+        row[1] = (float)(0.5 * (3 * t3 - 5 * t2 + 2));
+        row[2] = (float)(0.5 * (-3 * t3 + 4 * t2 + t));
+        row[3] = (float)(0.5 * (t3 - t2));
+    }
+
+    return;
+}
+
+
+static double bessel_i0(double x)
+{
+    // The power series converges quickly for the arguments used here
+    const double quarter_x2 = x * x * 0.25;
+    double term = 1;
+    double sum = 1;
+    for (int k = 1; k < 32; ++k)
+    {
+        term *= quarter_x2 / (k * k);
+        sum += term;
+    }
+
+    return sum;
+}
+
+
+static void fill_sinc_table(void)
+{
+    const double window_norm = 1.0 / bessel_i0(SAMPLE_SINC_KAISER_BETA);
+
+    for (int phase = 0; phase <= SAMPLE_INTERP_PHASE_COUNT; ++phase)
+    {
+        const double shift_rem = phase / (double)SAMPLE_INTERP_PHASE_COUNT;
+        double coeffs[SAMPLE_SINC_TAP_COUNT] = { 0 };
+        double coeff_sum = 0;
+
+        for (int i = 0; i < SAMPLE_SINC_TAP_COUNT; ++i)
+        {
+            const double shift = (i - SAMPLE_SINC_TAPS_BEFORE) - shift_rem;
+            if (shift == 0)
+            {
+                coeffs[i] = 1;
+            }
+            else
+            {
+                // Kaiser window
+                const double w = shift / SAMPLE_SINC_WINDOW_EXTENT;
+                const double window = bessel_i0(
+                        SAMPLE_SINC_KAISER_BETA * sqrt(max(0.0, 1 - w * w))) *
+                    window_norm;
+                const double sinc = sin(shift * PI) / (shift * PI);
+                coeffs[i] = sinc * window;
+            }
+
+            coeff_sum += coeffs[i];
+        }
+
+        // Normalise to unity gain at DC, the short window leaves a ripple
+        // of a few tenths of a percent otherwise
+        float* row = sinc_table + phase * SAMPLE_SINC_TAP_COUNT;
+        for (int i = 0; i < SAMPLE_SINC_TAP_COUNT; ++i)
+            row[i] = (float)(coeffs[i] / coeff_sum);
+    }
+
+    return;
+}
+
+
+void Sample_interp_init_tables(void)
+{
+#ifdef ENABLE_THREADS
+    Mutex_lock(&tables_lock);
+#endif
+
+    if (!are_tables_ready)
+    {
+        fill_cubic_table();
+        fill_sinc_table();
+        are_tables_ready = true;
+    }
+
+#ifdef ENABLE_THREADS
+    Mutex_unlock(&tables_lock);
+#endif
+
+    return;
+}
+
+
+typedef struct Tap_loop
+{
+    Sample_loop mode;
+    int32_t length;
+    int32_t loop_start;
+    int32_t loop_end;
+    int32_t loop_length;
+    int32_t uni_loop_length;
+} Tap_loop;
+
+
+static void Tap_loop_init(
+        Tap_loop* loop,
+        const Sample* sample,
+        Sample_loop mode,
+        const Sample_params* params)
+{
+    rassert(loop != NULL);
+    rassert(sample != NULL);
+    rassert(params != NULL);
+
+    loop->mode = mode;
+    loop->length = (int32_t)sample->len;
+    loop->loop_start = (int32_t)params->loop_start;
+    loop->loop_end = (int32_t)params->loop_end;
+    loop->loop_length = loop->loop_end - loop->loop_start;
+    loop->uni_loop_length = loop->loop_length - 1;
+
+    if (mode == SAMPLE_LOOP_BI)
+        loop->loop_length = max(1, loop->uni_loop_length * 2);
+
+    return;
+}
+
+
+/**
+ * Get the sample position of an unlooped interpolation tap position.
+ *
+ * \param loop   The Tap_loop -- must not be \c NULL.
+ * \param pos    The unlooped tap position.
+ *
+ * \return   The sample position, or \c -1 if the tap is outside the sample.
+ */
+static int32_t get_tap_pos(const Tap_loop* loop, int32_t pos)
+{
+    dassert(loop != NULL);
+
+    if (pos < 0)
+        return -1;
+
+    switch (loop->mode)
+    {
+        case SAMPLE_LOOP_OFF:
+        {
+            if (pos >= loop->length)
+                return -1;
+        }
+        break;
+
+        case SAMPLE_LOOP_UNI:
+        {
+            if (pos >= loop->loop_end)
+                pos = loop->loop_start + (pos - loop->loop_start) % loop->loop_length;
+        }
+        break;
+
+        case SAMPLE_LOOP_BI:
+        {
+            if (pos > loop->loop_start)
+            {
+                int32_t loop_pos = (pos - loop->loop_start) % loop->loop_length;
+                if (loop_pos >= loop->uni_loop_length)
+                    loop_pos = loop->uni_loop_length * 2 - loop_pos;
+                pos = loop->loop_start + loop_pos;
+            }
+        }
+        break;
+
+        default:
+            dassert(false);
+    }
+
+    return pos;
+}
+
+
+// Interpolation of contiguous taps read directly from sample data
+#define USE_SSE_INTERP KQT_SSE2
+
+#if USE_SSE_INTERP
+
+static_assert(SAMPLE_CUBIC_TAP_COUNT % 4 == 0,
+        "SAMPLE_CUBIC_TAP_COUNT is incompatible with the SSE interpolation.");
+static_assert(SAMPLE_SINC_TAP_COUNT % 4 == 0,
+        "SAMPLE_SINC_TAP_COUNT is incompatible with the SSE interpolation.");
+
+static __m128 load_taps_int8_t(const int8_t* data)
+{
+    int32_t packed = 0;
+    memcpy(&packed, data, sizeof(packed));
+    __m128i items = _mm_cvtsi32_si128(packed);
+    items = _mm_unpacklo_epi8(items, items);
+    items = _mm_unpacklo_epi16(items, items);
+    return _mm_cvtepi32_ps(_mm_srai_epi32(items, 24));
+}
+
+static __m128 load_taps_int16_t(const int16_t* data)
+{
+    const __m128i items = _mm_loadl_epi64((const __m128i*)data);
+    return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(items, items), 16));
+}
+
+static __m128 load_taps_int32_t(const int32_t* data)
+{
+    return _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)data));
+}
+
+static __m128 load_taps_float(const float* data)
+{
+    return _mm_loadu_ps(data);
+}
+
+#define DEF_APPLY_INTERP_TABLE(data_type)                                   \
+    static float apply_interp_table_ ## data_type(                          \
+            const float* table,                                             \
+            int tap_count,                                                  \
+            float phase_rem,                                                \
+            const data_type* taps)                                          \
+    {                                                                       \
+        dassert(table != NULL);                                             \
+        dassert(tap_count > 0);                                             \
+        dassert(phase_rem >= 0);                                            \
+        dassert(phase_rem <= 1);                                            \
+        dassert(taps != NULL);                                              \
+                                                                            \
+        const float pos = phase_rem * (float)SAMPLE_INTERP_PHASE_COUNT;     \
+        const int phase = min((int)pos, SAMPLE_INTERP_PHASE_COUNT - 1);     \
+        const __m128 lerp = _mm_set1_ps(pos - (float)phase);                \
+        const float* row1 = table + phase * tap_count;                      \
+        const float* row2 = row1 + tap_count;                               \
+                                                                            \
+        __m128 results = _mm_setzero_ps();                                  \
+                                                                            \
+        for (int i = 0; i < tap_count; i += 4)                              \
+        {                                                                   \
+            const __m128 coeffs1 = _mm_load_ps(row1 + i);                   \
+            const __m128 coeffs2 = _mm_load_ps(row2 + i);                   \
+            const __m128 coeffs = _mm_add_ps(                               \
+                coeffs1, _mm_mul_ps(lerp, _mm_sub_ps(coeffs2, coeffs1)));   \
+                                                                            \
+            const __m128 items = load_taps_ ## data_type(taps + i);         \
+            results = _mm_add_ps(results, _mm_mul_ps(coeffs, items));       \
+        }                                                                   \
+                                                                            \
+        float ra[4];                                                        \
+        _mm_storeu_ps(ra, results);                                         \
+        return ra[0] + ra[1] + ra[2] + ra[3];                               \
+    }
+
+#else
+
+#define DEF_APPLY_INTERP_TABLE(data_type)                                   \
+    static float apply_interp_table_ ## data_type(                          \
+            const float* table,                                             \
+            int tap_count,                                                  \
+            float phase_rem,                                                \
+            const data_type* taps)                                          \
+    {                                                                       \
+        dassert(table != NULL);                                             \
+        dassert(tap_count > 0);                                             \
+        dassert(phase_rem >= 0);                                            \
+        dassert(phase_rem <= 1);                                            \
+        dassert(taps != NULL);                                              \
+                                                                            \
+        const float pos = phase_rem * (float)SAMPLE_INTERP_PHASE_COUNT;     \
+        const int phase = min((int)pos, SAMPLE_INTERP_PHASE_COUNT - 1);     \
+        const float lerp = pos - (float)phase;                              \
+        const float* row1 = table + phase * tap_count;                      \
+        const float* row2 = row1 + tap_count;                               \
+                                                                            \
+        float result = 0;                                                   \
+        for (int i = 0; i < tap_count; ++i)                                 \
+        {                                                                   \
+            const float coeff = row1[i] + lerp * (row2[i] - row1[i]);       \
+            result += coeff * (float)taps[i];                               \
+        }                                                                   \
+                                                                            \
+        return result;                                                      \
+    }
+
+#endif // USE_SSE_INTERP
+
+DEF_APPLY_INTERP_TABLE(int8_t)
+DEF_APPLY_INTERP_TABLE(int16_t)
+DEF_APPLY_INTERP_TABLE(int32_t)
+DEF_APPLY_INTERP_TABLE(float)
+
+#undef DEF_APPLY_INTERP_TABLE
+
+
+int32_t Sample_render_interpolated(
+        const Sample* sample,
+        Sample_loop loop_mode,
+        const Sample_params* params,
+        Sample_interp interp,
+        const int32_t* positions,
+        const float* positions_rem,
+        const float* force_scales,
+        float* abufs[KQT_BUFFERS_MAX],
+        int32_t frame_count,
+        double vol_scale)
+{
+    rassert(sample != NULL);
+    rassert(params != NULL);
+    rassert(interp != SAMPLE_INTERP_LINEAR);
+    rassert(interp < SAMPLE_INTERP_COUNT);
+    rassert(positions != NULL);
+    rassert(positions_rem != NULL);
+    rassert(force_scales != NULL);
+    rassert(abufs != NULL);
+    rassert(frame_count > 0);
+    rassert(are_tables_ready);
+
+    Tap_loop loop;
+    Tap_loop_init(&loop, sample, loop_mode, params);
+
+    int32_t new_buf_stop = frame_count;
+    if (loop_mode == SAMPLE_LOOP_OFF)
+    {
+        if (positions[0] >= loop.length)
+            return 0;
+
+        for (int32_t i = 0; i < frame_count; ++i)
+        {
+            if (positions[i] >= loop.length)
+            {
+                new_buf_stop = i;
+                break;
+            }
+        }
+    }
+
+    _Alignas(16) float taps[SAMPLE_SINC_TAP_COUNT] = { 0 };
+
+    // Get sample frames, reading the taps directly if they are contiguous
+#define get_item(out_value, data_type)                                      \
+    if (true)                                                               \
+    {                                                                       \
+        const int32_t first = positions[i] - taps_before;                   \
+        const int32_t first_pos = get_tap_pos(&loop, first);                \
+        const int32_t last_pos = get_tap_pos(&loop, first + tap_count - 1); \
+                                                                            \
+        if ((first_pos >= 0) && (last_pos == first_pos + tap_count - 1))    \
+        {                                                                   \
+            (out_value) = apply_interp_table_ ## data_type(                 \
+                    table, tap_count, positions_rem[i], data + first_pos);  \
+        }                                                                   \
+        else                                                                \
+        {                                                                   \
+            for (int k = 0; k < tap_count; ++k)                             \
+            {                                                               \
+                const int32_t pos = get_tap_pos(&loop, first + k);          \
+                taps[k] = (pos >= 0) ? (float)data[pos] : 0.0f;             \
+            }                                                               \
+                                                                            \
+            (out_value) = apply_interp_table_float(                         \
+                    table, tap_count, positions_rem[i], taps);              \
+        }                                                                   \
+    }                                                                       \
+    else ignore(0)
+
+#define render_channels(data_type, scale)                                   \
+    if (true)                                                               \
+    {                                                                       \
+        const float fixed_scale = (float)(vol_scale * (scale));             \
+        for (int ch = 0; ch < sample->channels; ++ch)                       \
+        {                                                                   \
+            const data_type* data = sample->data[ch];                       \
+            float* audio_buffer = abufs[ch];                                \
+            if (audio_buffer == NULL)                                       \
+                continue;                                                   \
+                                                                            \
+            for (int32_t i = 0; i < new_buf_stop; ++i)                      \
+            {                                                               \
+                float item = 0;                                             \
+                get_item(item, data_type);                                  \
+                audio_buffer[i] = item * fixed_scale * force_scales[i];     \
+            }                                                               \
+        }                                                                   \
+    }                                                                       \
+    else ignore(0)
+
+#define render_formats()                                                    \
+    if (true)                                                               \
+    {                                                                       \
+        if (!sample->is_float)                                              \
+        {                                                                   \
+            switch (sample->bits)                                           \
+            {                                                               \
+                case 8:                                                     \
+                    render_channels(int8_t, 1.0 / 0x80);                    \
+                    break;                                                  \
+                                                                            \
+                case 16:                                                    \
+                    render_channels(int16_t, 1.0 / 0x8000UL);               \
+                    break;                                                  \
+                                                                            \
+                case 32:                                                    \
+                    render_channels(int32_t, 1.0 / 0x80000000UL);           \
+                    break;                                                  \
+                                                                            \
+                default:                                                    \
+                    rassert(false);                                         \
+            }                                                               \
+        }                                                                   \
+        else                                                                \
+        {                                                                   \
+            render_channels(float, 1.0);                                    \
+        }                                                                   \
+    }                                                                       \
+    else ignore(0)
+
+    // Use separate loops for each tap count so that they can be unrolled
+    if (interp == SAMPLE_INTERP_CUBIC)
+    {
+        const float* table = cubic_table;
+        const int tap_count = SAMPLE_CUBIC_TAP_COUNT;
+        const int taps_before = SAMPLE_CUBIC_TAPS_BEFORE;
+        render_formats();
+    }
+    else
+    {
+        rassert(interp == SAMPLE_INTERP_SINC);
+        const float* table = sinc_table;
+        const int tap_count = SAMPLE_SINC_TAP_COUNT;
+        const int taps_before = SAMPLE_SINC_TAPS_BEFORE;
+        render_formats();
+    }
+
+#undef render_formats
+#undef render_channels
+#undef get_item
+
+    return new_buf_stop;
+}
+
+
@@ -0,0 +1,78 @@
+
+
+/*
+ * Author: agent, 2026
+ *
+ * This file is part of Kunquat.
+ *
+ * CC0 1.0 Universal, http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * To the extent possible under law, Kunquat Affirmers have waived all
+ * copyright and related or neighboring rights to Kunquat.
+ */
+
+
+#ifndef KQT_SAMPLE_INTERP_H
+#define KQT_SAMPLE_INTERP_H
+
+
+#include <init/devices/param_types/Sample.h>
+#include <init/devices/param_types/Sample_params.h>
+#include <init/devices/processors/Proc_sample.h>
+#include <kunquat/limits.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+
+
+/**
+ * Initialise the interpolation coefficients shared by all sample processors.
+ *
+ * This function must be called before \a Sample_render_interpolated. It may
+ * be called from several threads, and subsequent calls have no effect.
+ */
+void Sample_interp_init_tables(void);
+
+
+/**
+ * Render sample data using cubic or windowed sinc interpolation.
+ *
+ * Interpolation taps that cross a loop boundary follow \a loop_mode, and taps
+ * outside the sample data are read as zeros.
+ *
+ * \param sample         The Sample -- must not be \c NULL.
+ * \param loop_mode      The loop mode.
+ * \param params         The Sample parameters -- must not be \c NULL.
+ * \param interp         The interpolation mode -- must be
+ *                       \c SAMPLE_INTERP_CUBIC or \c SAMPLE_INTERP_SINC.
+ * \param positions      The integer sample positions of the output frames
+ *                       -- must not be \c NULL.
+ * \param positions_rem  The fractional parts of \a positions, each in the
+ *                       range [0, 1] -- must not be \c NULL.
+ * \param force_scales   The force scales of the output frames -- must not
+ *                       be \c NULL.
+ * \param abufs          The output buffers, one for each channel of
+ *                       \a sample -- must not be \c NULL. Buffers that are
+ *                       \c NULL are skipped.
+ * \param frame_count    The number of frames to be rendered -- must be > \c 0.
+ * \param vol_scale      The volume scale.
+ *
+ * \return   The number of frames rendered. This is less than \a frame_count
+ *           if a sample without a loop ended.
+ */
+int32_t Sample_render_interpolated(
+        const Sample* sample,
+        Sample_loop loop_mode,
+        const Sample_params* params,
+        Sample_interp interp,
+        const int32_t* positions,
+        const float* positions_rem,
+        const float* force_scales,
+        float* abufs[KQT_BUFFERS_MAX],
+        int32_t frame_count,
+        double vol_scale);
+
+
+#endif // KQT_SAMPLE_INTERP_H
+
+
@@ -22,6 +22,7 @@
 #include <mathnum/conversions.h>
 #include <player/devices/Device_thread_state.h>
 #include <player/devices/processors/Proc_state_utils.h>
+#include <player/devices/processors/Sample_interp.h>
 #include <player/Work_buffers.h>
 #include <string/common.h>
 #include <string/Streader.h>
@@ -71,124 +72,26 @@ static const int SAMPLE_WB_FIXED_PITCH = WORK_BUFFER_IMPL_4;
 static const int SAMPLE_WB_FIXED_FORCE = WORK_BUFFER_IMPL_5;
 
 
-static int32_t Sample_render(
+static int32_t render_linear(
         const Sample* sample,
+        Sample_loop loop_mode,
         const Sample_params* params,
-        Voice_state* vstate,
-        Proc_state* proc_state,
-        const Device_thread_state* proc_ts,
-        const Work_buffers* wbs,
-        Work_buffer* out_wbs[2],
+        int32_t* positions,
+        int32_t* next_positions,
+        const float* positions_rem,
+        const float* force_scales,
+        float* abufs[KQT_BUFFERS_MAX],
         int32_t frame_count,
-        int32_t audio_rate,
-        double tempo,
-        double middle_tone,
-        double middle_freq,
         double vol_scale)
 {
     rassert(sample != NULL);
     rassert(params != NULL);
-    rassert(vstate != NULL);
-    rassert(proc_state != NULL);
-    rassert(proc_ts != NULL);
-    rassert(wbs != NULL);
-    rassert(out_wbs != NULL);
+    rassert(positions != NULL);
+    rassert(next_positions != NULL);
+    rassert(positions_rem != NULL);
+    rassert(force_scales != NULL);
+    rassert(abufs != NULL);
     rassert(frame_count > 0);
-    rassert(audio_rate > 0);
-    rassert(tempo > 0);
-    rassert(vol_scale >= 0);
-    ignore(tempo);
-
-    float* out_buffers[2] =
-    {
-        (out_wbs[0] != NULL) ? Work_buffer_get_contents_mut(out_wbs[0]) : NULL,
-        (out_wbs[1] != NULL) ? Work_buffer_get_contents_mut(out_wbs[1]) : NULL,
-    };
-
-    // This implementation does not support larger sample lengths :-P
-    rassert(sample->len < INT32_MAX - 1);
-
-    if (sample->len == 0)
-    {
-        vstate->active = false;
-        return 0;
-    }
-
-    // Get frequencies
-    Work_buffer* freqs_wb = Device_thread_state_get_voice_buffer(
-            proc_ts, DEVICE_PORT_TYPE_RECV, PORT_IN_PITCH);
-    Work_buffer* pitches_wb = freqs_wb;
-    if (!Work_buffer_is_valid(freqs_wb))
-        freqs_wb = Work_buffers_get_buffer_mut(wbs, SAMPLE_WB_FIXED_PITCH);
-    Proc_fill_freq_buffer(freqs_wb, pitches_wb, 0, frame_count);
-    const float* freqs = Work_buffer_get_contents(freqs_wb);
-
-    // Get force input
-    Work_buffer* force_scales_wb = Device_thread_state_get_voice_buffer(
-            proc_ts, DEVICE_PORT_TYPE_RECV, PORT_IN_FORCE);
-    Work_buffer* dBs_wb = force_scales_wb;
-    if (Work_buffer_is_valid(dBs_wb) &&
-            Work_buffer_is_final(dBs_wb) &&
-            (Work_buffer_get_const_start(dBs_wb) == 0) &&
-            (Work_buffer_get_contents(dBs_wb)[0] == -INFINITY))
-    {
-        // We are only getting silent force from this point onwards
-        vstate->active = false;
-        return 0;
-    }
-
-    if (!Work_buffer_is_valid(force_scales_wb))
-        force_scales_wb = Work_buffers_get_buffer_mut(wbs, SAMPLE_WB_FIXED_FORCE);
-    Proc_fill_scale_buffer(force_scales_wb, dBs_wb, frame_count);
-    const float* force_scales = Work_buffer_get_contents(force_scales_wb);
-
-    float* abufs[KQT_BUFFERS_MAX] = { out_buffers[0], out_buffers[1] };
-    if ((sample->channels == 1) && (out_buffers[0] == NULL))
-    {
-        // Make sure that mono sample is rendered to right channel
-        // if the left one does not exist
-        out_buffers[0] = out_buffers[1];
-        out_buffers[1] = NULL;
-    }
-
-    int32_t* positions = Work_buffers_get_buffer_contents_int_mut(
-            wbs, SAMPLE_WORK_BUFFER_POSITIONS);
-    int32_t* next_positions = Work_buffers_get_buffer_contents_int_mut(
-            wbs, SAMPLE_WORK_BUFFER_NEXT_POSITIONS);
-    float* positions_rem = Work_buffers_get_buffer_contents_mut(
-            wbs, SAMPLE_WORK_BUFFER_POSITIONS_REM);
-
-    // Position information to be updated
-    int32_t new_pos = (int32_t)vstate->pos;
-    double new_pos_rem = vstate->pos_rem;
-
-    // Get sample positions (assuming no loop at this point)
-    const double shift_factor = middle_freq / (middle_tone * audio_rate);
-    positions[0] = new_pos;
-    positions_rem[0] = (float)new_pos_rem;
-
-    for (int32_t i = 0; i < frame_count; ++i)
-    {
-        const float freq = freqs[i];
-        const double shift_total = freq * shift_factor;
-
-        const int32_t shift_floor = (int32_t)floor(shift_total);
-        const double shift_rem = shift_total - shift_floor;
-
-        new_pos += shift_floor;
-        new_pos_rem += shift_rem;
-        const int32_t excess_whole = (int32_t)floor(new_pos_rem);
-        new_pos += excess_whole;
-        new_pos_rem -= excess_whole;
-
-        positions[i + 1] = new_pos;
-        positions_rem[i + 1] = (float)new_pos_rem;
-    }
-
-    // Prevent invalid loop processing
-    Sample_loop loop_mode = params->loop;
-    if ((params->loop_end > sample->len) || (params->loop_start >= params->loop_end))
-        loop_mode = SAMPLE_LOOP_OFF;
 
     // Apply loop and length constraints to sample positions
     int32_t new_buf_stop = frame_count;
@@ -199,10 +102,7 @@ static int32_t Sample_render(
             const int32_t length = (int32_t)sample->len;
 
             if (positions[0] >= length)
-            {
-                vstate->active = false;
                 return 0;
-            }
 
             // Current positions
             for (int32_t i = 0; i < frame_count; ++i)
@@ -419,6 +319,186 @@ static int32_t Sample_render(
 
 #undef get_item
 
+    return new_buf_stop;
+}
+
+
+static int32_t Sample_render(
+        const Sample* sample,
+        const Sample_params* params,
+        Voice_state* vstate,
+        Proc_state* proc_state,
+        const Device_thread_state* proc_ts,
+        const Work_buffers* wbs,
+        Work_buffer* out_wbs[2],
+        int32_t frame_count,
+        int32_t audio_rate,
+        double tempo,
+        double middle_tone,
+        double middle_freq,
+        double vol_scale)
+{
+    rassert(sample != NULL);
+    rassert(params != NULL);
+    rassert(vstate != NULL);
+    rassert(proc_state != NULL);
+    rassert(proc_ts != NULL);
+    rassert(wbs != NULL);
+    rassert(out_wbs != NULL);
+    rassert(frame_count > 0);
+    rassert(audio_rate > 0);
+    rassert(tempo > 0);
+    rassert(vol_scale >= 0);
+    ignore(tempo);
+
+    float* out_buffers[2] =
+    {
+        (out_wbs[0] != NULL) ? Work_buffer_get_contents_mut(out_wbs[0]) : NULL,
+        (out_wbs[1] != NULL) ? Work_buffer_get_contents_mut(out_wbs[1]) : NULL,
+    };
+
+    // This implementation does not support larger sample lengths :-P
+    rassert(sample->len < INT32_MAX - 1);
+
+    if (sample->len == 0)
+    {
+        vstate->active = false;
+        return 0;
+    }
+
+    // Get frequencies
+    Work_buffer* freqs_wb = Device_thread_state_get_voice_buffer(
+            proc_ts, DEVICE_PORT_TYPE_RECV, PORT_IN_PITCH);
+    Work_buffer* pitches_wb = freqs_wb;
+    if (!Work_buffer_is_valid(freqs_wb))
+        freqs_wb = Work_buffers_get_buffer_mut(wbs, SAMPLE_WB_FIXED_PITCH);
+    Proc_fill_freq_buffer(freqs_wb, pitches_wb, 0, frame_count);
+    const float* freqs = Work_buffer_get_contents(freqs_wb);
+
+    // Get force input
+    Work_buffer* force_scales_wb = Device_thread_state_get_voice_buffer(
+            proc_ts, DEVICE_PORT_TYPE_RECV, PORT_IN_FORCE);
+    Work_buffer* dBs_wb = force_scales_wb;
+    if (Work_buffer_is_valid(dBs_wb) &&
+            Work_buffer_is_final(dBs_wb) &&
+            (Work_buffer_get_const_start(dBs_wb) == 0) &&
+            (Work_buffer_get_contents(dBs_wb)[0] == -INFINITY))
+    {
+        // We are only getting silent force from this point onwards
+        vstate->active = false;
+        return 0;
+    }
+
+    if (!Work_buffer_is_valid(force_scales_wb))
+        force_scales_wb = Work_buffers_get_buffer_mut(wbs, SAMPLE_WB_FIXED_FORCE);
+    Proc_fill_scale_buffer(force_scales_wb, dBs_wb, frame_count);
+    const float* force_scales = Work_buffer_get_contents(force_scales_wb);
+
+    float* abufs[KQT_BUFFERS_MAX] = { out_buffers[0], out_buffers[1] };
+    if ((sample->channels == 1) && (out_buffers[0] == NULL))
+    {
+        // Make sure that mono sample is rendered to right channel
+        // if the left one does not exist
+        out_buffers[0] = out_buffers[1];
+        out_buffers[1] = NULL;
+    }
+
+    int32_t* positions = Work_buffers_get_buffer_contents_int_mut(
+            wbs, SAMPLE_WORK_BUFFER_POSITIONS);
+    int32_t* next_positions = Work_buffers_get_buffer_contents_int_mut(
+            wbs, SAMPLE_WORK_BUFFER_NEXT_POSITIONS);
+    float* positions_rem = Work_buffers_get_buffer_contents_mut(
+            wbs, SAMPLE_WORK_BUFFER_POSITIONS_REM);
+
+    // Position information to be updated
+    int32_t new_pos = (int32_t)vstate->pos;
+    double new_pos_rem = vstate->pos_rem;
+
+    // Get sample positions (assuming no loop at this point)
+    const double shift_factor = middle_freq / (middle_tone * audio_rate);
+    positions[0] = new_pos;
+    positions_rem[0] = (float)new_pos_rem;
+
+    double max_shift = 0;
+
+    for (int32_t i = 0; i < frame_count; ++i)
+    {
+        const float freq = freqs[i];
+        const double shift_total = freq * shift_factor;
+        max_shift = max(max_shift, shift_total);
+
+        const int32_t shift_floor = (int32_t)floor(shift_total);
+        const double shift_rem = shift_total - shift_floor;
+
+        new_pos += shift_floor;
+        new_pos_rem += shift_rem;
+        const int32_t excess_whole = (int32_t)floor(new_pos_rem);
+        new_pos += excess_whole;
+        new_pos_rem -= excess_whole;
+
+        positions[i + 1] = new_pos;
+        positions_rem[i + 1] = (float)new_pos_rem;
+    }
+
+    // Prevent invalid loop processing
+    Sample_loop loop_mode = params->loop;
+    if ((params->loop_end > sample->len) || (params->loop_start >= params->loop_end))
+        loop_mode = SAMPLE_LOOP_OFF;
+
+    const Proc_sample* sample_p = (const Proc_sample*)proc_state->parent.device->dimpl;
+
+    // Render from a mip level if we are stepping through the sample quickly
+    Sample_params mip_params;
+    const int mip_level = sample_p->use_mipmaps
+        ? Sample_get_mip_level(sample, loop_mode, params, max_shift) : 0;
+    if (mip_level > 0)
+    {
+        const int32_t pos_mask = (1 << mip_level) - 1;
+        const float rem_scale = 1.0f / (float)(1 << mip_level);
+        for (int32_t i = 0; i <= frame_count; ++i)
+        {
+            const int32_t pos = positions[i];
+            positions_rem[i] = ((float)(pos & pos_mask) + positions_rem[i]) * rem_scale;
+            positions[i] = pos >> mip_level;
+        }
+
+        mip_params = *params;
+        mip_params.loop_start >>= mip_level;
+        mip_params.loop_end >>= mip_level;
+        params = &mip_params;
+
+        sample = Sample_get_mip(sample, mip_level);
+    }
+
+    const int32_t new_buf_stop = (sample_p->interp == SAMPLE_INTERP_LINEAR)
+        ? render_linear(
+                sample,
+                loop_mode,
+                params,
+                positions,
+                next_positions,
+                positions_rem,
+                force_scales,
+                abufs,
+                frame_count,
+                vol_scale)
+        : Sample_render_interpolated(
+                sample,
+                loop_mode,
+                params,
+                sample_p->interp,
+                positions,
+                positions_rem,
+                force_scales,
+                abufs,
+                frame_count,
+                vol_scale);
+    if (new_buf_stop == 0)
+    {
+        vstate->active = false;
+        return 0;
+    }
+
     // Copy mono signal to the right channel
     if ((sample->channels == 1) && (abufs[0] != NULL) && (abufs[1] != NULL))
     {
@@ -33,16 +33,29 @@
 
 
 static bool reserve_voice(
-        Channel* ch, uint64_t group_id, const Proc_state* proc_state, bool is_external)
+        Channel* ch,
+        uint64_t group_id,
+        const Proc_state* proc_state,
+        bool is_external,
+        bool* out_of_voices)
 {
     rassert(ch != NULL);
     rassert(proc_state != NULL);
+    rassert(out_of_voices != NULL);
 
     if (!Proc_state_needs_vstate(proc_state))
         return false;
 
-    Voice* voice = Voice_pool_allocate_voice(ch->pool, ch->num, group_id, is_external);
-    ignore(voice);
+    const Proc_type proc_type =
+        Device_impl_get_proc_type(proc_state->parent.device->dimpl);
+
+    Voice* voice = Voice_pool_allocate_voice(
+            ch->pool, ch->num, group_id, is_external, proc_type);
+    if (voice == NULL)
+    {
+        *out_of_voices = true;
+        return false;
+    }
     //fprintf(stderr, "reserved Voice %p\n", (void*)voice);
 
     return true;
@@ -63,6 +76,7 @@ bool reserve_voices(
     rassert(arg != NULL);
 
     int reserve_count = 0;
+    bool out_of_voices = false;
 
     if (event_type == Event_channel_note_on)
     {
@@ -84,8 +98,18 @@ bool reserve_voices(
                 const Proc_state* proc_state = (Proc_state*)Device_states_get_state(
                         dstates, Device_get_id((const Device*)proc));
 
-                if (reserve_voice(ch, new_group_id, proc_state, is_external))
+                if (reserve_voice(
+                            ch, new_group_id, proc_state, is_external, &out_of_voices))
                     ++reserve_count;
+                else if (out_of_voices)
+                    break;
+            }
+
+            if (out_of_voices)
+            {
+                // Partial Voice groups would not match the Processors
+                Voice_pool_reset_group(ch->pool, new_group_id);
+                return false;
             }
 
             Voice_group_reservations_add_entry(
@@ -122,8 +146,21 @@ bool reserve_voices(
                     const Proc_state* proc_state = (Proc_state*)Device_states_get_state(
                             dstates, Device_get_id((const Device*)proc));
 
-                    if (reserve_voice(ch, new_group_id, proc_state, is_external))
+                    if (reserve_voice(
+                                ch,
+                                new_group_id,
+                                proc_state,
+                                is_external,
+                                &out_of_voices))
                         ++reserve_count;
+                    else if (out_of_voices)
+                        break;
+                }
+
+                if (out_of_voices)
+                {
+                    Voice_pool_reset_group(ch->pool, new_group_id);
+                    return false;
                 }
 
                 Voice_group_reservations_add_entry(
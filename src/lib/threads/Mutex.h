@@ -1,7 +1,7 @@
 
 
 /*
- * Author: Tomi Jylhä-Ollila, Finland 2016
+ * Author: Tomi Jylhä-Ollila, Finland 2016-2019
  *
  * This file is part of Kunquat.
  *
@@ -36,6 +36,20 @@ typedef struct Mutex
 #define MUTEX_AUTO (&(Mutex){ .initialised = false })
 
 
+/**
+ * Initialiser of a Mutex with static storage duration.
+ *
+ * A Mutex initialised with this does not need to be initialised with
+ * \a Mutex_init, so it may be locked by any thread without a separate
+ * initialisation step.
+ */
+#ifdef WITH_PTHREAD
+#define MUTEX_STATIC_INIT { .initialised = true, .mutex = PTHREAD_MUTEX_INITIALIZER }
+#else
+#define MUTEX_STATIC_INIT { .initialised = false }
+#endif
+
+
 /**
  * Initialise the Mutex.
  *
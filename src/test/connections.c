@@ -216,6 +216,63 @@ START_TEST(Connect_instrument_effect_with_unconnected_dsp_and_mix)
 END_TEST
 
 
+START_TEST(Instrument_connection_changes_are_applied_after_validation)
+{
+    set_audio_rate(220);
+    set_mix_volume(0);
+    pause();
+
+    set_data("p_control_map.json", "[0, [ [0, 0] ]]");
+    set_data("control_00/p_manifest.json", "[0, {}]");
+
+    make_debug_instrument();
+
+    set_data("out_00/p_manifest.json", "[0, {}]");
+    set_data("p_connections.json",
+            "[0, [ [\"au_00/out_00\", \"out_00\"] ]]");
+
+    validate();
+
+    float seq[] = { 1.0f, 0.5f, 0.5f, 0.5f };
+    float expected_buf[buf_len] = { 0.0f };
+    repeat_seq_local(expected_buf, 10, seq);
+
+    float actual_buf[buf_len] = { 0.0f };
+    kqt_Handle_fire_event(handle, 0, Note_On_55_Hz);
+    check_unexpected_error();
+    mix_and_fill(actual_buf, buf_len);
+    check_buffers_equal(expected_buf, actual_buf, buf_len, 0.0f);
+
+    // Disconnect the instrument output
+    set_data("au_00/p_connections.json",
+            "[0, [ [\"proc_01/C/out_00\", \"proc_00/C/in_00\"] ]]");
+    validate();
+
+    float silent_buf[buf_len] = { 0.0f };
+    kqt_Handle_fire_event(handle, 0, Note_On_55_Hz);
+    check_unexpected_error();
+    mix_and_fill(actual_buf, buf_len);
+    check_buffers_equal(silent_buf, actual_buf, buf_len, 0.0f);
+
+    // Reconnect the instrument output, and set unchanged top-level connections
+    set_data("au_00/p_connections.json",
+            "[0,"
+            "[ [\"proc_00/C/out_00\", \"out_00\"]"
+            ", [\"proc_01/C/out_00\", \"proc_00/C/in_00\"]"
+            "]"
+            "]");
+    set_data("p_connections.json",
+            "[0, [ [\"au_00/out_00\", \"out_00\"] ]]");
+    validate();
+
+    kqt_Handle_fire_event(handle, 0, Note_On_55_Hz);
+    check_unexpected_error();
+    mix_and_fill(actual_buf, buf_len);
+    check_buffers_equal(expected_buf, actual_buf, buf_len, 0.0f);
+}
+END_TEST
+
+
 static Suite* Connections_suite(void)
 {
     Suite* s = suite_create("Connections");
@@ -235,6 +292,9 @@ static Suite* Connections_suite(void)
     tcase_add_test(
             tc_effects,
             Connect_instrument_effect_with_unconnected_dsp_and_mix);
+    tcase_add_test(
+            tc_effects,
+            Instrument_connection_changes_are_applied_after_validation);
 
     return s;
 }
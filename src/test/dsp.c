@@ -1,7 +1,7 @@
 
 
 /*
- * Author: Tomi Jylhä-Ollila, Finland 2013-2018
+ * Author: Tomi Jylhä-Ollila, Finland 2013-2019
  *
  * This file is part of Kunquat.
  *
@@ -18,6 +18,11 @@
 #include <kunquat/Handle.h>
 #include <kunquat/Player.h>
 
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
 
 #define buf_len 128
 
@@ -48,12 +53,8 @@ static void make_debug_instrument(void)
 }
 
 
-START_TEST(Trivial_delay_is_identity)
+static void make_delay_effect(void)
 {
-    set_audio_rate(220);
-    set_mix_volume(0);
-    pause();
-
     set_data("au_03/proc_01/in_00/p_manifest.json", "[0, {}]");
     set_data("au_03/proc_01/out_00/p_manifest.json", "[0, {}]");
     set_data("au_03/proc_01/p_manifest.json", "[0, { \"type\": \"delay\" }]");
@@ -79,6 +80,18 @@ START_TEST(Trivial_delay_is_identity)
     set_data("p_control_map.json", "[0, [ [0, 2] ]]");
     set_data("control_00/p_manifest.json", "[0, {}]");
 
+    return;
+}
+
+
+START_TEST(Trivial_delay_is_identity)
+{
+    set_audio_rate(220);
+    set_mix_volume(0);
+    pause();
+
+    make_delay_effect();
+
     validate();
 
     float actual_buf[buf_len] = { 0.0f };
@@ -95,6 +108,529 @@ START_TEST(Trivial_delay_is_identity)
 END_TEST
 
 
+START_TEST(Constant_delay_spans_render_calls)
+{
+    set_audio_rate(220);
+    set_mix_volume(0);
+    pause();
+
+    make_delay_effect();
+    set_data("au_03/proc_01/c/p_f_init_delay.json", "[0, 0.25]");
+
+    validate();
+
+    float actual_buf[buf_len] = { 0.0f };
+    kqt_Handle_fire_event(handle, 0, Note_On_55_Hz);
+    check_unexpected_error();
+
+    const int chunk_size = 23;
+    for (int offset = 0; offset < buf_len; offset += chunk_size)
+        mix_and_fill(actual_buf + offset, min(chunk_size, buf_len - offset));
+
+    float expected_buf[buf_len] = { 0.0f };
+    float seq[] = { 1.0f, 0.5f, 0.5f, 0.5f };
+    repeat_seq_local(expected_buf + 55, 10, seq);
+
+    check_buffers_equal(expected_buf, actual_buf, buf_len, 0.0f);
+}
+END_TEST
+
+
+START_TEST(Fractional_constant_delay_interpolates_linearly)
+{
+    set_audio_rate(220);
+    set_mix_volume(0);
+    pause();
+
+    // Delay by 55.3 frames
+    make_delay_effect();
+    set_data("au_03/proc_01/c/p_f_init_delay.json", "[0, 0.25136363636363636]");
+
+    validate();
+
+    float actual_buf[buf_len] = { 0.0f };
+    kqt_Handle_fire_event(handle, 0, Note_On_55_Hz);
+    check_unexpected_error();
+
+    const int chunk_size = 23;
+    for (int offset = 0; offset < buf_len; offset += chunk_size)
+        mix_and_fill(actual_buf + offset, min(chunk_size, buf_len - offset));
+
+    float input_buf[buf_len] = { 0.0f };
+    float seq[] = { 1.0f, 0.5f, 0.5f, 0.5f };
+    repeat_seq_local(input_buf, 10, seq);
+
+    float expected_buf[buf_len] = { 0.0f };
+    expected_buf[55] = 0.7f * input_buf[0];
+    for (int i = 56; i < buf_len; ++i)
+        expected_buf[i] = 0.3f * input_buf[i - 56] + 0.7f * input_buf[i - 55];
+
+    check_buffers_equal(expected_buf, actual_buf, buf_len, 0.0001f);
+}
+END_TEST
+
+
+static void make_convolution_effect(bool chained)
+{
+    set_data("au_03/proc_00/in_00/p_manifest.json", "[0, {}]");
+    set_data("au_03/proc_00/out_00/p_manifest.json", "[0, {}]");
+    set_data("au_03/proc_00/p_manifest.json", "[0, { \"type\": \"convolve\" }]");
+    set_data("au_03/proc_00/p_signal_type.json", "[0, \"mixed\"]");
+
+    if (chained)
+    {
+        set_data("au_03/proc_01/in_00/p_manifest.json", "[0, {}]");
+        set_data("au_03/proc_01/out_00/p_manifest.json", "[0, {}]");
+        set_data("au_03/proc_01/p_manifest.json", "[0, { \"type\": \"convolve\" }]");
+        set_data("au_03/proc_01/p_signal_type.json", "[0, \"mixed\"]");
+
+        set_data("au_03/p_connections.json",
+                "[0,"
+                "[ [\"in_00\", \"proc_00/C/in_00\"], "
+                "  [\"proc_00/C/out_00\", \"proc_01/C/in_00\"], "
+                "  [\"proc_01/C/out_00\", \"out_00\"] ]"
+                "]");
+    }
+    else
+    {
+        set_data("au_03/p_connections.json",
+                "[0,"
+                "[ [\"in_00\", \"proc_00/C/in_00\"], "
+                "  [\"proc_00/C/out_00\", \"out_00\"] ]"
+                "]");
+    }
+
+    set_data("au_03/in_00/p_manifest.json", "[0, {}]");
+    set_data("au_03/out_00/p_manifest.json", "[0, {}]");
+    set_data("au_03/p_manifest.json", "[0, { \"type\": \"effect\" }]");
+
+    make_debug_instrument();
+    set_data("au_02/proc_00/c/p_b_single_pulse.json", "[0, true]");
+
+    set_data("out_00/p_manifest.json", "[0, {}]");
+    set_data("p_connections.json",
+            "[0,"
+            "[ [\"au_02/out_00\", \"au_03/in_00\"], "
+            "  [\"au_03/out_00\", \"out_00\"] ]"
+            "]");
+    set_data("p_control_map.json", "[0, [ [0, 2] ]]");
+    set_data("control_00/p_manifest.json", "[0, {}]");
+
+    return;
+}
+
+
+static void fill_random(float* dest, int32_t length, uint32_t seed)
+{
+    assert(dest != NULL);
+    assert(length >= 0);
+
+    uint32_t state = seed;
+    for (int32_t i = 0; i < length; ++i)
+    {
+        state = state * 1664525u + 1013904223u;
+        dest[i] = (float)(state >> 8) / (float)(1 << 24) - 0.5f;
+    }
+
+    return;
+}
+
+
+static void write_u32(unsigned char* dest, uint32_t value)
+{
+    for (int i = 0; i < 4; ++i)
+        dest[i] = (unsigned char)((value >> (i * 8)) & 0xff);
+    return;
+}
+
+
+#define WAV_HEADER_SIZE 44
+
+static void set_impulse_response(const char* key, const float* ir, int32_t length)
+{
+    assert(key != NULL);
+    assert(ir != NULL);
+    assert(length > 0);
+
+    // Mono 32-bit floating point WAV
+    const long data_size = (long)length * 4;
+    const long wav_size = WAV_HEADER_SIZE + data_size;
+    unsigned char* wav = malloc((size_t)wav_size);
+    fail_if(wav == NULL, "Could not allocate memory for impulse response");
+
+    memcpy(wav, "RIFF", 4);
+    write_u32(wav + 4, (uint32_t)(wav_size - 8));
+    memcpy(wav + 8, "WAVEfmt ", 8);
+    write_u32(wav + 16, 16);
+    write_u32(wav + 20, 3 | (1 << 16)); // IEEE float format, 1 channel
+    write_u32(wav + 24, 220);
+    write_u32(wav + 28, 220 * 4);
+    write_u32(wav + 32, 4 | (32 << 16)); // 4 bytes per frame, 32 bits per item
+    memcpy(wav + 36, "data", 4);
+    write_u32(wav + 40, (uint32_t)data_size);
+
+    for (int32_t i = 0; i < length; ++i)
+    {
+        uint32_t bits = 0;
+        memcpy(&bits, &ir[i], 4);
+        write_u32(wav + WAV_HEADER_SIZE + i * 4, bits);
+    }
+
+    kqt_Handle_set_data(handle, key, wav, wav_size);
+    free(wav);
+    check_unexpected_error();
+
+    return;
+}
+
+#undef WAV_HEADER_SIZE
+
+
+#define conv_buf_len 2048
+
+
+static void render_single_pulse(float* actual_buf)
+{
+    assert(actual_buf != NULL);
+
+    kqt_Handle_fire_event(handle, 0, Note_On_55_Hz);
+    check_unexpected_error();
+
+    // Use render calls that do not line up with the partitions of the convolution
+    const int chunk_size = 100;
+    for (int offset = 0; offset < conv_buf_len; offset += chunk_size)
+        mix_and_fill(actual_buf + offset, min(chunk_size, conv_buf_len - offset));
+
+    return;
+}
+
+
+static const int32_t ir_lengths[] = { 1, 100, 256, 257, 600, 1000 };
+
+
+START_TEST(Convolution_of_impulse_is_impulse_response)
+{
+    set_audio_rate(220);
+    set_mix_volume(0);
+    pause();
+
+    make_convolution_effect(false);
+
+    const int32_t ir_length = ir_lengths[_i];
+    float ir[conv_buf_len] = { 0.0f };
+    fill_random(ir, ir_length, 1);
+    set_impulse_response("au_03/proc_00/i/p_ir.wav", ir, ir_length);
+
+    validate();
+
+    float actual_buf[conv_buf_len] = { 0.0f };
+    render_single_pulse(actual_buf);
+
+    check_buffers_equal(ir, actual_buf, conv_buf_len, 0.00001f);
+}
+END_TEST
+
+
+START_TEST(Convolution_matches_direct_calculation)
+{
+    set_audio_rate(220);
+    set_mix_volume(0);
+    pause();
+
+    make_convolution_effect(true);
+
+    // The first convolution turns the pulse into a random signal
+    // that is then convolved with the impulse response
+    const int32_t signal_length = 700;
+    float signal[conv_buf_len] = { 0.0f };
+    fill_random(signal, signal_length, 2);
+    set_impulse_response("au_03/proc_00/i/p_ir.wav", signal, signal_length);
+
+    const int32_t ir_length = ir_lengths[_i];
+    float ir[conv_buf_len] = { 0.0f };
+    fill_random(ir, ir_length, 3);
+    for (int32_t i = 0; i < ir_length; ++i)
+        ir[i] *= 0.1f;
+    set_impulse_response("au_03/proc_01/i/p_ir.wav", ir, ir_length);
+
+    validate();
+
+    float actual_buf[conv_buf_len] = { 0.0f };
+    render_single_pulse(actual_buf);
+
+    float expected_buf[conv_buf_len] = { 0.0f };
+    for (int32_t i = 0; i < conv_buf_len; ++i)
+    {
+        double sum = 0;
+        for (int32_t k = max(0, i - signal_length + 1); k <= min(i, ir_length - 1); ++k)
+            sum += (double)ir[k] * (double)signal[i - k];
+        expected_buf[i] = (float)sum;
+    }
+
+    check_buffers_equal(expected_buf, actual_buf, conv_buf_len, 0.0001f);
+}
+END_TEST
+
+
+static void make_gaincomp_effect(const char* map)
+{
+    assert(map != NULL);
+
+    // The convolution turns the pulse into a test signal that is fed to
+    // one gain compressor with a map table and another with exact evaluation
+    set_data("au_03/proc_00/in_00/p_manifest.json", "[0, {}]");
+    set_data("au_03/proc_00/out_00/p_manifest.json", "[0, {}]");
+    set_data("au_03/proc_00/p_manifest.json", "[0, { \"type\": \"convolve\" }]");
+    set_data("au_03/proc_00/p_signal_type.json", "[0, \"mixed\"]");
+
+    static const char* gc_procs[] = { "au_03/proc_01", "au_03/proc_02" };
+    for (int i = 0; i < 2; ++i)
+    {
+        char key[64] = "";
+        sprintf(key, "%s/in_00/p_manifest.json", gc_procs[i]);
+        set_data(key, "[0, {}]");
+        sprintf(key, "%s/out_00/p_manifest.json", gc_procs[i]);
+        set_data(key, "[0, {}]");
+        sprintf(key, "%s/p_manifest.json", gc_procs[i]);
+        set_data(key, "[0, { \"type\": \"gaincomp\" }]");
+        sprintf(key, "%s/p_signal_type.json", gc_procs[i]);
+        set_data(key, "[0, \"mixed\"]");
+        sprintf(key, "%s/c/p_b_map_enabled.json", gc_procs[i]);
+        set_data(key, "[0, true]");
+        sprintf(key, "%s/c/p_e_map.json", gc_procs[i]);
+        set_data(key, map);
+    }
+    set_data("au_03/proc_01/c/p_b_map_use_table.json", "[0, true]");
+
+    set_data("au_03/p_connections.json",
+            "[0,"
+            "[ [\"in_00\", \"proc_00/C/in_00\"], "
+            "  [\"proc_00/C/out_00\", \"proc_01/C/in_00\"], "
+            "  [\"proc_00/C/out_00\", \"proc_02/C/in_00\"], "
+            "  [\"proc_01/C/out_00\", \"out_00\"], "
+            "  [\"proc_02/C/out_00\", \"out_01\"] ]"
+            "]");
+
+    set_data("au_03/in_00/p_manifest.json", "[0, {}]");
+    set_data("au_03/out_00/p_manifest.json", "[0, {}]");
+    set_data("au_03/out_01/p_manifest.json", "[0, {}]");
+    set_data("au_03/p_manifest.json", "[0, { \"type\": \"effect\" }]");
+
+    make_debug_instrument();
+    set_data("au_02/proc_00/c/p_b_single_pulse.json", "[0, true]");
+
+    set_data("out_00/p_manifest.json", "[0, {}]");
+    set_data("out_01/p_manifest.json", "[0, {}]");
+    set_data("p_connections.json",
+            "[0,"
+            "[ [\"au_02/out_00\", \"au_03/in_00\"], "
+            "  [\"au_03/out_00\", \"out_00\"], "
+            "  [\"au_03/out_01\", \"out_01\"] ]"
+            "]");
+    set_data("p_control_map.json", "[0, [ [0, 2] ]]");
+    set_data("control_00/p_manifest.json", "[0, {}]");
+
+    return;
+}
+
+
+#define gc_buf_len 512
+
+
+static const char* gc_maps[] =
+{
+    "[0, { \"nodes\": [ [0, 0], [0.25, 0.6], [0.7, 0.8], [1, 1] ] }]",
+    "[0, { \"nodes\": [ [-1, -0.5], [0, 0.1], [0.5, 0.9], [1, 1] ] }]",
+    "[0, { \"nodes\": [ [-1, -1], [-0.2, 0.3], [0.01, -0.4], [0.02, 0.6], [1, 0] ] }]",
+};
+
+
+START_TEST(Gain_compression_map_table_matches_exact_evaluation)
+{
+    set_audio_rate(220);
+    set_mix_volume(0);
+    pause();
+
+    make_gaincomp_effect(gc_maps[_i]);
+
+    // Cover the whole map range and values outside it
+    float signal[gc_buf_len] = { 0.0f };
+    fill_random(signal, gc_buf_len, 4);
+    for (int32_t i = 0; i < gc_buf_len; ++i)
+        signal[i] *= 2.4f;
+    set_impulse_response("au_03/proc_00/i/p_ir.wav", signal, gc_buf_len);
+
+    validate();
+
+    kqt_Handle_fire_event(handle, 0, Note_On_55_Hz);
+    check_unexpected_error();
+
+    kqt_Handle_play(handle, gc_buf_len);
+    check_unexpected_error();
+    const long frames_available = kqt_Handle_get_frames_available(handle);
+    fail_if(frames_available != gc_buf_len,
+            "kqt_Handle_play rendered %ld instead of %d frames",
+            frames_available, gc_buf_len);
+    const float* ret_buf = kqt_Handle_get_audio(handle);
+    check_unexpected_error();
+
+    float table_buf[gc_buf_len] = { 0.0f };
+    float exact_buf[gc_buf_len] = { 0.0f };
+    for (int32_t i = 0; i < gc_buf_len; ++i)
+    {
+        table_buf[i] = ret_buf[i * 2];
+        exact_buf[i] = ret_buf[i * 2 + 1];
+    }
+
+    bool is_output_nonzero = false;
+    for (int32_t i = 0; i < gc_buf_len; ++i)
+        is_output_nonzero |= (fabsf(exact_buf[i]) > 0.5f);
+    fail_if(!is_output_nonzero, "Gain compression output is silent");
+
+    check_buffers_equal(exact_buf, table_buf, gc_buf_len, 0.0005f);
+}
+END_TEST
+
+
+static void make_control_rate_filter_effect(int control_interval)
+{
+    // The convolutions turn the pulse into an audio signal and a cutoff ramp
+    // that are fed to one filter at audio rate and another at control rate
+    static const char* conv_procs[] = { "au_03/proc_00", "au_03/proc_01" };
+    for (int i = 0; i < 2; ++i)
+    {
+        char key[64] = "";
+        sprintf(key, "%s/in_00/p_manifest.json", conv_procs[i]);
+        set_data(key, "[0, {}]");
+        sprintf(key, "%s/out_00/p_manifest.json", conv_procs[i]);
+        set_data(key, "[0, {}]");
+        sprintf(key, "%s/p_manifest.json", conv_procs[i]);
+        set_data(key, "[0, { \"type\": \"convolve\" }]");
+        sprintf(key, "%s/p_signal_type.json", conv_procs[i]);
+        set_data(key, "[0, \"mixed\"]");
+    }
+
+    static const char* filter_procs[] = { "au_03/proc_02", "au_03/proc_03" };
+    for (int i = 0; i < 2; ++i)
+    {
+        char key[64] = "";
+        for (int port = 0; port < 3; ++port)
+        {
+            sprintf(key, "%s/in_%02d/p_manifest.json", filter_procs[i], port);
+            set_data(key, "[0, {}]");
+        }
+        sprintf(key, "%s/out_00/p_manifest.json", filter_procs[i]);
+        set_data(key, "[0, {}]");
+        sprintf(key, "%s/p_manifest.json", filter_procs[i]);
+        set_data(key, "[0, { \"type\": \"filter\" }]");
+        sprintf(key, "%s/p_signal_type.json", filter_procs[i]);
+        set_data(key, "[0, \"mixed\"]");
+    }
+
+    char interval_data[32] = "";
+    sprintf(interval_data, "[0, %d]", control_interval);
+    set_data("au_03/proc_03/c/p_i_control_interval.json", interval_data);
+
+    set_data("au_03/p_connections.json",
+            "[0,"
+            "[ [\"in_00\", \"proc_00/C/in_00\"], "
+            "  [\"in_00\", \"proc_01/C/in_00\"], "
+            "  [\"proc_00/C/out_00\", \"proc_02/C/in_00\"], "
+            "  [\"proc_01/C/out_00\", \"proc_02/C/in_02\"], "
+            "  [\"proc_00/C/out_00\", \"proc_03/C/in_00\"], "
+            "  [\"proc_01/C/out_00\", \"proc_03/C/in_02\"], "
+            "  [\"proc_02/C/out_00\", \"out_00\"], "
+            "  [\"proc_03/C/out_00\", \"out_01\"] ]"
+            "]");
+
+    set_data("au_03/in_00/p_manifest.json", "[0, {}]");
+    set_data("au_03/out_00/p_manifest.json", "[0, {}]");
+    set_data("au_03/out_01/p_manifest.json", "[0, {}]");
+    set_data("au_03/p_manifest.json", "[0, { \"type\": \"effect\" }]");
+
+    make_debug_instrument();
+    set_data("au_02/proc_00/c/p_b_single_pulse.json", "[0, true]");
+
+    set_data("out_00/p_manifest.json", "[0, {}]");
+    set_data("out_01/p_manifest.json", "[0, {}]");
+    set_data("p_connections.json",
+            "[0,"
+            "[ [\"au_02/out_00\", \"au_03/in_00\"], "
+            "  [\"au_03/out_00\", \"out_00\"], "
+            "  [\"au_03/out_01\", \"out_01\"] ]"
+            "]");
+    set_data("p_control_map.json", "[0, [ [0, 2] ]]");
+    set_data("control_00/p_manifest.json", "[0, {}]");
+
+    return;
+}
+
+
+#define cr_buf_len 512
+
+
+static const int control_intervals[] = { 2, 16, 64 };
+
+
+START_TEST(Control_rate_filter_follows_audio_rate_filter)
+{
+    set_audio_rate(220);
+    set_mix_volume(0);
+    pause();
+
+    make_control_rate_filter_effect(control_intervals[_i]);
+
+    float signal[cr_buf_len] = { 0.0f };
+    fill_random(signal, cr_buf_len, 5);
+    set_impulse_response("au_03/proc_00/i/p_ir.wav", signal, cr_buf_len);
+
+    // Sweep the cutoff over a range that is not clamped at this audio rate
+    float cutoffs[cr_buf_len] = { 0.0f };
+    for (int32_t i = 0; i < cr_buf_len; ++i)
+        cutoffs[i] = -30.0f + 28.0f * (float)i / (float)cr_buf_len;
+    set_impulse_response("au_03/proc_01/i/p_ir.wav", cutoffs, cr_buf_len);
+
+    validate();
+
+    kqt_Handle_fire_event(handle, 0, Note_On_55_Hz);
+    check_unexpected_error();
+
+    // Use render calls that do not line up with the control points
+    float audio_rate_buf[cr_buf_len] = { 0.0f };
+    float control_rate_buf[cr_buf_len] = { 0.0f };
+    const int chunk_size = 100;
+    for (int offset = 0; offset < cr_buf_len; offset += chunk_size)
+    {
+        const int frame_count = min(chunk_size, cr_buf_len - offset);
+        kqt_Handle_play(handle, frame_count);
+        check_unexpected_error();
+        const long frames_available = kqt_Handle_get_frames_available(handle);
+        fail_if(frames_available != frame_count,
+                "kqt_Handle_play rendered %ld instead of %d frames",
+                frames_available, frame_count);
+        const float* ret_buf = kqt_Handle_get_audio(handle);
+        check_unexpected_error();
+
+        for (int i = 0; i < frame_count; ++i)
+        {
+            audio_rate_buf[offset + i] = ret_buf[i * 2];
+            control_rate_buf[offset + i] = ret_buf[i * 2 + 1];
+        }
+    }
+
+    // Make sure that the control interval is not ignored
+    bool is_interpolated = false;
+    for (int32_t i = 0; i < cr_buf_len; ++i)
+        is_interpolated |= (audio_rate_buf[i] != control_rate_buf[i]);
+    fail_if(!is_interpolated, "Control rate output matches audio rate output exactly");
+
+    // The interpolation error grows with the control interval
+    const float eps = 0.0005f * (float)control_intervals[_i];
+    check_buffers_equal(audio_rate_buf, control_rate_buf, cr_buf_len, eps);
+}
+END_TEST
+
+
 static Suite* DSP_suite(void)
 {
     Suite* s = suite_create("DSP");
@@ -107,6 +643,47 @@ static Suite* DSP_suite(void)
     tcase_add_checked_fixture(tc_chorus, setup_empty, handle_teardown);
 
     tcase_add_test(tc_chorus, Trivial_delay_is_identity);
+    tcase_add_test(tc_chorus, Constant_delay_spans_render_calls);
+    tcase_add_test(tc_chorus, Fractional_constant_delay_interpolates_linearly);
+
+    const int ir_length_count = (int)(sizeof(ir_lengths) / sizeof(ir_lengths[0]));
+
+    TCase* tc_convolution = tcase_create("convolution");
+    suite_add_tcase(s, tc_convolution);
+    tcase_set_timeout(tc_convolution, timeout);
+    tcase_add_checked_fixture(tc_convolution, setup_empty, handle_teardown);
+
+    tcase_add_loop_test(
+            tc_convolution,
+            Convolution_of_impulse_is_impulse_response,
+            0, ir_length_count);
+    tcase_add_loop_test(
+            tc_convolution,
+            Convolution_matches_direct_calculation,
+            0, ir_length_count);
+
+    TCase* tc_gaincomp = tcase_create("gaincomp");
+    suite_add_tcase(s, tc_gaincomp);
+    tcase_set_timeout(tc_gaincomp, timeout);
+    tcase_add_checked_fixture(tc_gaincomp, setup_empty, handle_teardown);
+
+    const int gc_map_count = (int)(sizeof(gc_maps) / sizeof(gc_maps[0]));
+    tcase_add_loop_test(
+            tc_gaincomp,
+            Gain_compression_map_table_matches_exact_evaluation,
+            0, gc_map_count);
+
+    TCase* tc_control_rate = tcase_create("control_rate");
+    suite_add_tcase(s, tc_control_rate);
+    tcase_set_timeout(tc_control_rate, timeout);
+    tcase_add_checked_fixture(tc_control_rate, setup_empty, handle_teardown);
+
+    const int interval_count =
+        (int)(sizeof(control_intervals) / sizeof(control_intervals[0]));
+    tcase_add_loop_test(
+            tc_control_rate,
+            Control_rate_filter_follows_audio_rate_filter,
+            0, interval_count);
 
     return s;
 }
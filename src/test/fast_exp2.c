@@ -1,7 +1,7 @@
 
 
 /*
- * Author: Tomi Jylhä-Ollila, Finland 2016-2018
+ * Author: Tomi Jylhä-Ollila, Finland 2016-2019
  *
  * This file is part of Kunquat.
  *
@@ -54,6 +54,86 @@ START_TEST(Maximum_relative_error_is_small)
 END_TEST
 
 
+START_TEST(Block_maximum_relative_error_is_small)
+{
+#if KQT_SSE2
+    static const double small = 0.000001;
+#else
+    static const double small = 0.001;
+#endif
+    static const int32_t test_count = 1048577;
+    static const int32_t block_size = 67;
+
+    float x_data[67] = { 0 };
+    float result_data[67] = { 0 };
+
+    for (int32_t i = 0; i < test_count; i += block_size)
+    {
+        const int32_t count =
+            (test_count - i < block_size) ? (test_count - i) : block_size;
+        for (int32_t k = 0; k < count; ++k)
+            x_data[k] = (float)((252.0 * (i + k) / test_count) - 125.0);
+
+        fast_exp2_block(result_data, x_data, count);
+
+        for (int32_t k = 0; k < count; ++k)
+        {
+            const double std_exp2 = exp2(x_data[k]);
+            const double rel_error = fabs((result_data[k] / std_exp2) - 1);
+
+            fail_unless(rel_error <= small,
+                    "fast_exp2_block yields %.7g for %.7g, which is too far from %.7g",
+                    result_data[k], x_data[k], std_exp2);
+        }
+    }
+}
+END_TEST
+
+
+START_TEST(Block_input_is_clamped_to_normal_range)
+{
+    const float x_data[3] = { -1000, 1000, INFINITY };
+    float result_data[3] = { 0 };
+
+    fast_exp2_block(result_data, x_data, 3);
+
+    for (int k = 0; k < 3; ++k)
+    {
+        fail_unless(isnormal(result_data[k]),
+                "fast_exp2_block yields %.7g for %.7g, which is not a normal value",
+                result_data[k], x_data[k]);
+    }
+}
+END_TEST
+
+
+START_TEST(Block_maps_negative_infinity_and_nan_to_zero)
+{
+    // Cover both the vectorised part and the remaining values
+    const float x_data[7] = { -INFINITY, 0, NAN, 1, 2, -INFINITY, NAN };
+    float result_data[7] = { 0 };
+
+    fast_exp2_block(result_data, x_data, 7);
+
+    for (int k = 0; k < 7; ++k)
+    {
+        if (isfinite(x_data[k]))
+        {
+            fail_unless(isnormal(result_data[k]),
+                    "fast_exp2_block yields %.7g for %.7g, which is not a normal value",
+                    result_data[k], x_data[k]);
+        }
+        else
+        {
+            fail_unless(result_data[k] == 0,
+                    "fast_exp2_block yields %.7g for %.7g instead of 0",
+                    result_data[k], x_data[k]);
+        }
+    }
+}
+END_TEST
+
+
 #if ENABLE_F4_TEST
 
 static float test_value_f(int32_t index, int32_t count)
@@ -98,6 +178,92 @@ END_TEST
 #endif // ENABLE_F4_TEST
 
 
+#ifdef KQT_LONG_TESTS
+
+#define BENCH_BLOCK_SIZE 256
+#define BENCH_ROUND_COUNT 40000
+
+
+typedef void (*exp2_func)(float* dest, const float* src, int32_t count);
+
+
+static void exp2_std(float* dest, const float* src, int32_t count)
+{
+    for (int32_t i = 0; i < count; ++i)
+        dest[i] = exp2f(src[i]);
+
+    return;
+}
+
+
+static void exp2_scalar(float* dest, const float* src, int32_t count)
+{
+    for (int32_t i = 0; i < count; ++i)
+        dest[i] = (float)fast_exp2(src[i]);
+
+    return;
+}
+
+
+#if ENABLE_F4_TEST
+static void exp2_f4(float* dest, const float* src, int32_t count)
+{
+    for (int32_t i = 0; i < count; i += 4)
+        _mm_storeu_ps(dest + i, fast_exp2_f4(_mm_loadu_ps(src + i)));
+
+    return;
+}
+#endif
+
+
+static void exp2_block(float* dest, const float* src, int32_t count)
+{
+    fast_exp2_block(dest, src, count);
+    return;
+}
+
+
+static void run_exp2_bench(const char* name, exp2_func func)
+{
+    float src[BENCH_BLOCK_SIZE] = { 0 };
+    float dest[BENCH_BLOCK_SIZE] = { 0 };
+    for (int32_t i = 0; i < BENCH_BLOCK_SIZE; ++i)
+        src[i] = (float)test_value(i, BENCH_BLOCK_SIZE) / 4.0f;
+
+    double check_sum = 0;
+
+    const int64_t start = get_bench_time();
+
+    for (int32_t r = 0; r < BENCH_ROUND_COUNT; ++r)
+    {
+        func(dest, src, BENCH_BLOCK_SIZE);
+        check_sum += dest[r % BENCH_BLOCK_SIZE];
+    }
+
+    const int64_t elapsed = get_bench_time() - start;
+
+    fail_unless(isfinite(check_sum), "%s produced non-finite values", name);
+
+    report_bench(name, "value", elapsed, (int64_t)BENCH_BLOCK_SIZE * BENCH_ROUND_COUNT);
+
+    return;
+}
+
+
+START_TEST(Benchmark_exp2_throughput)
+{
+    run_exp2_bench("exp2f", exp2_std);
+    run_exp2_bench("fast_exp2", exp2_scalar);
+#if ENABLE_F4_TEST
+    run_exp2_bench("fast_exp2_f4", exp2_f4);
+#endif
+    run_exp2_bench("fast_exp2_block", exp2_block);
+}
+END_TEST
+
+#endif // KQT_LONG_TESTS
+
+
 static Suite* Fast_exp2_suite(void)
 {
     Suite* s = suite_create("Fast_exp2");
@@ -109,10 +275,21 @@ static Suite* Fast_exp2_suite(void)
     tcase_set_timeout(tc_correctness, timeout);
 
     tcase_add_test(tc_correctness, Maximum_relative_error_is_small);
+    tcase_add_test(tc_correctness, Block_maximum_relative_error_is_small);
+    tcase_add_test(tc_correctness, Block_input_is_clamped_to_normal_range);
+    tcase_add_test(tc_correctness, Block_maps_negative_infinity_and_nan_to_zero);
 #if ENABLE_F4_TEST
     tcase_add_test(tc_correctness, Maximum_relative_error_is_small_f4);
 #endif
 
+#ifdef KQT_LONG_TESTS
+    TCase* tc_benchmark = tcase_create("benchmark");
+    suite_add_tcase(s, tc_benchmark);
+    tcase_set_timeout(tc_benchmark, LONG_TIMEOUT);
+
+    tcase_add_test(tc_benchmark, Benchmark_exp2_throughput);
+#endif
+
     return s;
 }
 
@@ -1,7 +1,7 @@
 
 
 /*
- * Author: Tomi Jylhä-Ollila, Finland 2016-2018
+ * Author: Tomi Jylhä-Ollila, Finland 2016-2019
  *
  * This file is part of Kunquat.
  *
@@ -48,6 +48,38 @@ START_TEST(Maximum_absolute_error_is_small)
 END_TEST
 
 
+START_TEST(Block_maximum_absolute_error_is_small)
+{
+    static const float small = 0.001f;
+    static const int32_t test_count = 1048574;
+    static const int32_t block_size = 67;
+
+    float x_data[67] = { 0 };
+    float result_data[67] = { 0 };
+
+    for (int32_t i = 1; i < test_count + 1; i += block_size)
+    {
+        const int32_t count =
+            (test_count + 1 - i < block_size) ? (test_count + 1 - i) : block_size;
+        for (int32_t k = 0; k < count; ++k)
+            x_data[k] = (float)((i + k) / (double)test_count);
+
+        fast_log2_block(result_data, x_data, count);
+
+        for (int32_t k = 0; k < count; ++k)
+        {
+            const float std_log2 = log2f(x_data[k]);
+            const float abs_error = fabsf(result_data[k] - std_log2);
+
+            fail_unless(abs_error <= small,
+                    "fast_log2_block yields %.7g for %.7g, which is %.7g from %.7g",
+                    result_data[k], x_data[k], abs_error, std_log2);
+        }
+    }
+}
+END_TEST
+
+
 #if ENABLE_F4_TEST
 START_TEST(Maximum_absolute_error_is_small_f4)
 {
@@ -83,6 +115,78 @@ END_TEST
 #endif // ENABLE_F4_TEST
 
 
+#ifdef KQT_LONG_TESTS
+
+#define BENCH_BLOCK_SIZE 256
+#define BENCH_ROUND_COUNT 40000
+
+
+typedef void (*log2_func)(float* dest, const float* src, int32_t count);
+
+
+static void log2_std(float* dest, const float* src, int32_t count)
+{
+    for (int32_t i = 0; i < count; ++i)
+        dest[i] = log2f(src[i]);
+
+    return;
+}
+
+
+static void log2_scalar(float* dest, const float* src, int32_t count)
+{
+    for (int32_t i = 0; i < count; ++i)
+        dest[i] = (float)fast_log2(src[i]);
+
+    return;
+}
+
+
+static void log2_block(float* dest, const float* src, int32_t count)
+{
+    fast_log2_block(dest, src, count);
+    return;
+}
+
+
+static void run_log2_bench(const char* name, log2_func func)
+{
+    float src[BENCH_BLOCK_SIZE] = { 0 };
+    float dest[BENCH_BLOCK_SIZE] = { 0 };
+    for (int32_t i = 0; i < BENCH_BLOCK_SIZE; ++i)
+        src[i] = (float)((i + 1) / 16.0);
+
+    double check_sum = 0;
+
+    const int64_t start = get_bench_time();
+
+    for (int32_t r = 0; r < BENCH_ROUND_COUNT; ++r)
+    {
+        func(dest, src, BENCH_BLOCK_SIZE);
+        check_sum += dest[r % BENCH_BLOCK_SIZE];
+    }
+
+    const int64_t elapsed = get_bench_time() - start;
+
+    fail_unless(isfinite(check_sum), "%s produced non-finite values", name);
+
+    report_bench(name, "value", elapsed, (int64_t)BENCH_BLOCK_SIZE * BENCH_ROUND_COUNT);
+
+    return;
+}
+
+
+START_TEST(Benchmark_log2_throughput)
+{
+    run_log2_bench("log2f", log2_std);
+    run_log2_bench("fast_log2", log2_scalar);
+    run_log2_bench("fast_log2_block", log2_block);
+}
+END_TEST
+
+#endif // KQT_LONG_TESTS
+
+
 static Suite* Fast_log2_suite(void)
 {
     Suite* s = suite_create("Fast_log2");
@@ -94,10 +198,19 @@ static Suite* Fast_log2_suite(void)
     tcase_set_timeout(tc_correctness, timeout);
 
     tcase_add_test(tc_correctness, Maximum_absolute_error_is_small);
+    tcase_add_test(tc_correctness, Block_maximum_absolute_error_is_small);
 #if ENABLE_F4_TEST
     tcase_add_test(tc_correctness, Maximum_absolute_error_is_small_f4);
 #endif
 
+#ifdef KQT_LONG_TESTS
+    TCase* tc_benchmark = tcase_create("benchmark");
+    suite_add_tcase(s, tc_benchmark);
+    tcase_set_timeout(tc_benchmark, LONG_TIMEOUT);
+
+    tcase_add_test(tc_benchmark, Benchmark_log2_throughput);
+#endif
+
     return s;
 }
 
@@ -1,7 +1,7 @@
 
 
 /*
- * Author: Tomi Jylhä-Ollila, Finland 2016
+ * Author: Tomi Jylhä-Ollila, Finland 2016-2019
  *
  * This file is part of Kunquat.
  *
@@ -20,6 +20,7 @@
 
 #include <math.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -135,6 +136,189 @@ START_TEST(Forward_and_inverse_transform_return_scaled_original)
 END_TEST
 
 
+START_TEST(Forward_transform_matches_direct_calculation)
+{
+    const int test_length = _i;
+
+    float data[max_test_length] = { 0 };
+    fill_data_noise(data, test_length);
+
+    double expected[max_test_length] = { 0 };
+    for (int k = 0; k <= test_length / 2; ++k)
+    {
+        double re = 0;
+        double im = 0;
+        for (int i = 0; i < test_length; ++i)
+        {
+            const double arg = PI2 * (double)i * (double)k / (double)test_length;
+            re += data[i] * cos(arg);
+            im -= data[i] * sin(arg);
+        }
+
+        if (k == 0)
+        {
+            expected[0] = re;
+        }
+        else
+        {
+            expected[k * 2 - 1] = re;
+            if (k * 2 < test_length)
+                expected[k * 2] = im;
+        }
+    }
+
+    FFT_worker_rfft(fw, data, test_length);
+
+    for (int i = 0; i < test_length; ++i)
+    {
+        fail_if(fabs(data[i] - expected[i]) > 0.01,
+                "Transform of length %d is inaccurate at index %d:"
+                " calculated %.7g, expected %.7g",
+                test_length, i, data[i], expected[i]);
+    }
+}
+END_TEST
+
+
+typedef struct Worker_pair
+{
+    FFT_worker vector_worker;
+    FFT_worker fftpack_worker;
+    FFT_worker* vector_fw;
+    FFT_worker* fftpack_fw;
+    float* vector_data;
+    float* fftpack_data;
+} Worker_pair;
+
+
+static void Worker_pair_init(Worker_pair* pair, int32_t length)
+{
+    pair->vector_fw = FFT_worker_init(&pair->vector_worker, length);
+
+    FFT_set_plans_enabled(false);
+    pair->fftpack_fw = FFT_worker_init(&pair->fftpack_worker, length);
+    FFT_set_plans_enabled(true);
+
+    pair->vector_data = malloc(sizeof(float) * (size_t)length);
+    pair->fftpack_data = malloc(sizeof(float) * (size_t)length);
+
+    fail_if(pair->vector_fw == NULL || pair->fftpack_fw == NULL,
+            "Could not allocate memory for FFT workers.");
+    fail_if(pair->vector_data == NULL || pair->fftpack_data == NULL,
+            "Could not allocate memory for FFT data.");
+    fail_if(pair->vector_fw->plan == NULL,
+            "Transform of length %d does not use a vectorised plan", (int)length);
+    fail_if(pair->fftpack_fw->plan != NULL,
+            "Transform of length %d uses a plan after disabling plans", (int)length);
+
+    fill_data_noise(pair->vector_data, (int)length);
+    memcpy(pair->fftpack_data, pair->vector_data, sizeof(float) * (size_t)length);
+
+    return;
+}
+
+
+static void Worker_pair_deinit(Worker_pair* pair)
+{
+    FFT_worker_deinit(pair->vector_fw);
+    FFT_worker_deinit(pair->fftpack_fw);
+    free(pair->vector_data);
+    free(pair->fftpack_data);
+
+    return;
+}
+
+
+static void check_data_match(
+        const Worker_pair* pair, int32_t length, float magnitude, const char* desc)
+{
+    const float max_error = 1e-5f * magnitude;
+
+    for (int32_t i = 0; i < length; ++i)
+    {
+        fail_if(fabsf(pair->vector_data[i] - pair->fftpack_data[i]) > max_error,
+                "%s transform of length %d differs at index %d:"
+                " vectorised %.7g, FFTPACK %.7g",
+                desc, (int)length, (int)i,
+                pair->vector_data[i], pair->fftpack_data[i]);
+    }
+
+    return;
+}
+
+
+START_TEST(Vectorised_transform_matches_fftpack)
+{
+    const int32_t test_length = (int32_t)1 << _i;
+
+    Worker_pair* pair = &(Worker_pair){ .vector_fw = NULL };
+    Worker_pair_init(pair, test_length);
+
+    FFT_worker_rfft(pair->vector_fw, pair->vector_data, test_length);
+    FFT_worker_rfft(pair->fftpack_fw, pair->fftpack_data, test_length);
+    // Transforming noise yields values with an expected magnitude of sqrt(length)
+    check_data_match(pair, test_length, sqrtf((float)test_length), "Forward");
+
+    FFT_worker_irfft(pair->vector_fw, pair->vector_data, test_length);
+    FFT_worker_irfft(pair->fftpack_fw, pair->fftpack_data, test_length);
+    // The inverse transform scales the original values by length
+    check_data_match(pair, test_length, (float)test_length, "Inverse");
+
+    Worker_pair_deinit(pair);
+}
+END_TEST
+
+
+#ifdef KQT_LONG_TESTS
+
+START_TEST(Benchmark_vectorised_and_fftpack_transforms)
+{
+    const int32_t lengths[] = { 1024, 16384, 262144, 1048576 };
+
+    for (size_t li = 0; li < sizeof(lengths) / sizeof(*lengths); ++li)
+    {
+        const int32_t length = lengths[li];
+        const int32_t round_count = max(1, (1 << 24) / length);
+
+        Worker_pair* pair = &(Worker_pair){ .vector_fw = NULL };
+        Worker_pair_init(pair, length);
+
+        char name[64] = "";
+
+        {
+            const int64_t start = get_bench_time();
+            for (int32_t r = 0; r < round_count; ++r)
+            {
+                FFT_worker_rfft(pair->fftpack_fw, pair->fftpack_data, length);
+                FFT_worker_irfft(pair->fftpack_fw, pair->fftpack_data, length);
+            }
+            const int64_t elapsed = get_bench_time() - start;
+
+            snprintf(name, sizeof(name), "FFTPACK, length %d", (int)length);
+            report_bench(name, "transform pair", elapsed, round_count);
+        }
+
+        {
+            const int64_t start = get_bench_time();
+            for (int32_t r = 0; r < round_count; ++r)
+            {
+                FFT_worker_rfft(pair->vector_fw, pair->vector_data, length);
+                FFT_worker_irfft(pair->vector_fw, pair->vector_data, length);
+            }
+            const int64_t elapsed = get_bench_time() - start;
+
+            snprintf(name, sizeof(name), "Vectorised, length %d", (int)length);
+            report_bench(name, "transform pair", elapsed, round_count);
+        }
+
+        Worker_pair_deinit(pair);
+    }
+}
+END_TEST
+
+#endif // KQT_LONG_TESTS
+
+
 static Suite* FFT_suite(void)
 {
     Suite* s = suite_create("FFT");
@@ -152,6 +336,20 @@ static Suite* FFT_suite(void)
             Forward_and_inverse_transform_return_scaled_original,
             1,
             max_test_length + 1);
+    tcase_add_loop_test(
+            tc_correctness,
+            Forward_transform_matches_direct_calculation,
+            1,
+            max_test_length + 1);
+    tcase_add_loop_test(tc_correctness, Vectorised_transform_matches_fftpack, 5, 17);
+
+#ifdef KQT_LONG_TESTS
+    TCase* tc_benchmark = tcase_create("benchmark");
+    suite_add_tcase(s, tc_benchmark);
+    tcase_set_timeout(tc_benchmark, LONG_TIMEOUT);
+
+    tcase_add_test(tc_benchmark, Benchmark_vectorised_and_fftpack_transforms);
+#endif
 
     return s;
 }
@@ -1,7 +1,7 @@
 
 
 /*
- * Authors: Tomi Jylhä-Ollila, Finland 2013-2016
+ * Authors: Tomi Jylhä-Ollila, Finland 2013-2019
  *          Ossi Saresoja, Finland 2013
  *
  * This file is part of Kunquat.
@@ -13,13 +13,18 @@
  */
 
 
+#include <handle_utils.h>
 #include <test_common.h>
 
+#include <kunquat/Handle.h>
+#include <kunquat/Player.h>
 #include <kunquat/testing.h>
 #include <mathnum/common.h>
 #include <player/devices/processors/Filter.h>
 
 #include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
 #include <string.h>
 
 
@@ -108,6 +113,96 @@ START_TEST(Two_Pole_Frequency_Response)
 END_TEST
 
 
+static void setup_filter_instrument(void)
+{
+    setup_debug_instrument();
+
+    set_data("au_00/p_connections.json",
+            "[0,"
+            "[ [\"proc_02/C/out_00\", \"out_00\"]"
+            ", [\"proc_02/C/out_01\", \"out_01\"]"
+            ", [\"proc_00/C/out_00\", \"proc_02/C/in_00\"]"
+            ", [\"proc_00/C/out_01\", \"proc_02/C/in_01\"]"
+            ", [\"proc_01/C/out_00\", \"proc_00/C/in_00\"]"
+            "]"
+            "]");
+
+    set_data("au_00/proc_02/p_manifest.json", "[0, { \"type\": \"filter\" }]");
+    set_data("au_00/proc_02/p_signal_type.json", "[0, \"voice\"]");
+    set_data("au_00/proc_02/in_00/p_manifest.json", "[0, {}]");
+    set_data("au_00/proc_02/in_01/p_manifest.json", "[0, {}]");
+    set_data("au_00/proc_02/out_00/p_manifest.json", "[0, {}]");
+    set_data("au_00/proc_02/out_01/p_manifest.json", "[0, {}]");
+    set_data("au_00/proc_02/c/p_f_cutoff.json", "[0, 40]");
+    set_data("au_00/proc_02/c/p_f_resonance.json", "[0, 80]");
+
+    validate();
+    check_unexpected_error();
+
+    return;
+}
+
+
+#define note_count 8
+#define held_len 8
+#define batch_test_len 256
+
+
+static void render_released_filter_notes(float* buf, bool enable_batching)
+{
+    kqt_set_voice_batching(enable_batching ? 1 : 0);
+
+    set_audio_rate(220);
+    pause();
+
+    // Released notes are rendered as background Voice groups
+    for (int ch = 0; ch < note_count; ++ch)
+    {
+        char note_on[64] = "";
+        snprintf(note_on, sizeof(note_on), "[\"n+\", %d]", -6000 + ch * 170);
+        kqt_Handle_fire_event(handle, ch, note_on);
+        check_unexpected_error();
+    }
+
+    long frames_done = 0;
+    while (frames_done < held_len)
+        frames_done += mix_and_fill(buf + frames_done, held_len - frames_done);
+
+    for (int ch = 0; ch < note_count; ++ch)
+        kqt_Handle_fire_event(handle, ch, "[\"n-\", null]");
+    check_unexpected_error();
+
+    while (frames_done < batch_test_len)
+        frames_done += mix_and_fill(buf + frames_done, batch_test_len - frames_done);
+
+    kqt_set_voice_batching(1);
+
+    return;
+}
+
+
+START_TEST(Batched_filter_voices_match_separate_voices)
+{
+    float expected[batch_test_len] = { 0 };
+    setup_filter_instrument();
+    render_released_filter_notes(expected, false);
+    handle_teardown();
+
+    setup_empty();
+    float actual[batch_test_len] = { 0 };
+    setup_filter_instrument();
+    render_released_filter_notes(actual, true);
+
+    bool has_release = false;
+    for (int i = held_len; i < batch_test_len; ++i)
+        has_release = has_release || (expected[i] != 0);
+    fail_if(!has_release, "Released notes did not produce any output");
+
+    check_buffers_equal(expected, actual, batch_test_len, 0.0f);
+}
+END_TEST
+
+
 static Suite* Filter_suite(void)
 {
     Suite* s = suite_create("Filter");
@@ -123,6 +218,13 @@ static Suite* Filter_suite(void)
             tc_two_pole, Two_Pole_Frequency_Response,
             1, cutoff_count + 1);
 
+    TCase* tc_batch = tcase_create("batch");
+    suite_add_tcase(s, tc_batch);
+    tcase_set_timeout(tc_batch, timeout);
+    tcase_add_checked_fixture(tc_batch, setup_empty, handle_teardown);
+
+    tcase_add_test(tc_batch, Batched_filter_voices_match_separate_voices);
+
     return s;
 }
 
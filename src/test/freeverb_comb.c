@@ -0,0 +1,224 @@
+
+
+/*
+ * Author: agent, 2026
+ *
+ * This file is part of Kunquat.
+ *
+ * CC0 1.0 Universal, http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * To the extent possible under law, Kunquat Affirmers have waived all
+ * copyright and related or neighboring rights to Kunquat.
+ */
+
+
+#include <test_common.h>
+
+#include <intrinsics.h>
+#include <mathnum/common.h>
+#include <player/devices/processors/Freeverb_comb_bank.h>
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+
+#define TEST_LENGTH 8192
+#define MAX_BUFFER_SIZE 2048
+
+
+static const int32_t buffer_size_sets[][FREEVERB_COMB_BANK_SIZE] =
+{
+    // Freeverb comb sizes at 48000 Hz
+    { 1215, 1293, 1390, 1476, 1548, 1623, 1695, 1760 },
+    // Short sizes that make the delay lines wrap around at different frames
+    { 1, 2, 3, 5, 8, 13, 21, 34 },
+    { 7, 7, 7, 7, 100, 100, 100, 100 },
+};
+#define buffer_size_set_count \
+    ((int)(sizeof(buffer_size_sets) / sizeof(buffer_size_sets[0])))
+
+
+// Scalar lowpass-feedback-comb filter that processes the comb filters one by one
+typedef struct Ref_comb
+{
+    float filter_store;
+    float buffer[MAX_BUFFER_SIZE];
+    int32_t buffer_size;
+    int32_t buffer_pos;
+} Ref_comb;
+
+
+static void Ref_comb_process(
+        Ref_comb* comb,
+        float* out_buf,
+        const float* in_buf,
+        const float* refls,
+        const float* damps,
+        int32_t frame_count)
+{
+    assert(comb != NULL);
+    assert(out_buf != NULL);
+    assert(in_buf != NULL);
+    assert(refls != NULL);
+    assert(damps != NULL);
+    assert(frame_count > 0);
+
+    for (int32_t i = 0; i < frame_count; ++i)
+    {
+        float output = comb->buffer[comb->buffer_pos];
+#if !KQT_SSE
+        output = undenormalise(output);
+#endif
+        const float damp1 = damps[i];
+        const float damp2 = 1 - damp1;
+
+        comb->filter_store = (output * damp2) + (comb->filter_store * damp1);
+#if !KQT_SSE
+        comb->filter_store = undenormalise(comb->filter_store);
+#endif
+        comb->buffer[comb->buffer_pos] = in_buf[i] + (comb->filter_store * refls[i]);
+
+        out_buf[i] += output;
+
+        ++comb->buffer_pos;
+        if (comb->buffer_pos >= comb->buffer_size)
+            comb->buffer_pos = 0;
+    }
+
+    return;
+}
+
+
+static float get_random(uint32_t* state)
+{
+    assert(state != NULL);
+    *state = *state * 1664525u + 1013904223u;
+    return (float)(*state >> 8) / (float)(1 << 24);
+}
+
+
+START_TEST(Comb_bank_matches_separate_scalar_combs)
+{
+    const int32_t* buffer_sizes = buffer_size_sets[_i];
+
+#if KQT_SSE
+    const unsigned int old_ftoz = _MM_GET_FLUSH_ZERO_MODE();
+    _MM_SET_FLUSH_ZERO_MODE(_MM_FLUSH_ZERO_ON);
+#endif
+
+    static float in_buf[TEST_LENGTH] = { 0.0f };
+    static float refls[TEST_LENGTH] = { 0.0f };
+    static float damps[TEST_LENGTH] = { 0.0f };
+    uint32_t random_state = 1;
+    for (int32_t i = 0; i < TEST_LENGTH; ++i)
+    {
+        // Leave silence at the end so that the tails decay towards denormals
+        in_buf[i] = (i < TEST_LENGTH / 2) ? get_random(&random_state) - 0.5f : 0.0f;
+        refls[i] = 0.7f + 0.28f * get_random(&random_state);
+        damps[i] = 0.4f * get_random(&random_state);
+    }
+
+    static Ref_comb ref_combs[FREEVERB_COMB_BANK_SIZE];
+    for (int k = 0; k < FREEVERB_COMB_BANK_SIZE; ++k)
+    {
+        assert(buffer_sizes[k] <= MAX_BUFFER_SIZE);
+        Ref_comb* comb = &ref_combs[k];
+        comb->filter_store = 0;
+        for (int32_t i = 0; i < MAX_BUFFER_SIZE; ++i)
+            comb->buffer[i] = 0;
+        comb->buffer_size = buffer_sizes[k];
+        comb->buffer_pos = 0;
+    }
+
+    Freeverb_comb_bank* bank = new_Freeverb_comb_bank(buffer_sizes);
+    fail_if(bank == NULL, "Could not allocate a Freeverb comb bank");
+
+    static float expected[TEST_LENGTH] = { 0.0f };
+    static float actual[TEST_LENGTH] = { 0.0f };
+    for (int32_t i = 0; i < TEST_LENGTH; ++i)
+    {
+        expected[i] = 0;
+        actual[i] = 0;
+    }
+
+    // Process in varying chunks so that chunk and delay line boundaries differ
+    int32_t frames_done = 0;
+    for (int part = 0; frames_done < TEST_LENGTH; ++part)
+    {
+        const int32_t chunk_size =
+            min(TEST_LENGTH - frames_done, 1 + (part * 97) % 700);
+
+        for (int k = 0; k < FREEVERB_COMB_BANK_SIZE; ++k)
+            Ref_comb_process(
+                    &ref_combs[k],
+                    expected + frames_done,
+                    in_buf + frames_done,
+                    refls + frames_done,
+                    damps + frames_done,
+                    chunk_size);
+
+        Freeverb_comb_bank_process(
+                bank,
+                actual + frames_done,
+                in_buf + frames_done,
+                refls + frames_done,
+                damps + frames_done,
+                chunk_size);
+
+        frames_done += chunk_size;
+    }
+
+    del_Freeverb_comb_bank(bank);
+
+#if KQT_SSE
+    _MM_SET_FLUSH_ZERO_MODE(old_ftoz);
+#endif
+
+    bool has_output = false;
+    for (int32_t i = 0; i < TEST_LENGTH; ++i)
+    {
+        fail_if(actual[i] != expected[i],
+                "Comb bank output %.9g differs from scalar comb output %.9g"
+                " at frame %d",
+                actual[i], expected[i], (int)i);
+        has_output |= (actual[i] != 0);
+    }
+
+    fail_if(!has_output, "Comb bank produced only silence");
+}
+END_TEST
+
+
+static Suite* Freeverb_comb_suite(void)
+{
+    Suite* s = suite_create("Freeverb_comb");
+
+    const int timeout = DEFAULT_TIMEOUT;
+
+    TCase* tc_bank = tcase_create("bank");
+    suite_add_tcase(s, tc_bank);
+    tcase_set_timeout(tc_bank, timeout);
+
+    tcase_add_loop_test(
+            tc_bank, Comb_bank_matches_separate_scalar_combs, 0, buffer_size_set_count);
+
+    return s;
+}
+
+
+int main(void)
+{
+    Suite* suite = Freeverb_comb_suite();
+    SRunner* sr = srunner_create(suite);
+#ifdef K_MEM_DEBUG
+    srunner_set_fork_status(sr, CK_NOFORK);
+#endif
+    srunner_run_all(sr, CK_NORMAL);
+    int fail_count = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    exit(fail_count > 0);
+}
+
+
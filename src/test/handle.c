@@ -1,7 +1,7 @@
 
 
 /*
- * Author: Tomi Jylhä-Ollila, Finland 2012-2016
+ * Author: Tomi Jylhä-Ollila, Finland 2012-2019
  *
  * This file is part of Kunquat.
  *
@@ -115,6 +115,352 @@ START_TEST(Set_audio_rate)
 END_TEST
 
 
+static void setup_padsynth_instrument_with_params(const char* params)
+{
+    assert(handle != 0);
+    assert(params != NULL);
+
+    set_data("au_00/p_manifest.json", "[0, { \"type\": \"instrument\" }]");
+    set_data("au_00/proc_00/p_manifest.json", "[0, { \"type\": \"padsynth\" }]");
+    set_data("au_00/proc_00/p_signal_type.json", "[0, \"voice\"]");
+    set_data("au_00/proc_00/c/p_ps_params.json", params);
+
+    validate();
+
+    return;
+}
+
+
+static const char padsynth_params[] =
+    "[0, { \"sample_length\": 16384"
+    ", \"harmonics\": [[1, 1], [2, 0.5], [3, 0.25]]"
+    "}]";
+
+
+static void setup_padsynth_instrument(void)
+{
+    setup_padsynth_instrument_with_params(padsynth_params);
+    return;
+}
+
+
+static char* record_padsynth_snapshot_with_params(const char* params, long* length)
+{
+    assert(handle != 0);
+    assert(params != NULL);
+    assert(length != NULL);
+
+    kqt_Handle_set_snapshot_recording(handle, 1);
+    check_unexpected_error();
+
+    setup_padsynth_instrument_with_params(params);
+
+    const char* snapshot = kqt_Handle_get_snapshot(handle, length);
+    check_unexpected_error();
+    fail_if(snapshot == NULL, "Could not get snapshot");
+
+    char* copy = malloc((size_t)*length);
+    fail_if(copy == NULL, "Could not allocate memory for snapshot copy");
+    memcpy(copy, snapshot, (size_t)*length);
+
+    return copy;
+}
+
+
+static char* record_padsynth_snapshot(long* length)
+{
+    return record_padsynth_snapshot_with_params(padsynth_params, length);
+}
+
+
+START_TEST(Snapshot_data_is_used_instead_of_computed_data)
+{
+    long length = 0;
+    char* snapshot = record_padsynth_snapshot(&length);
+
+    // Modify the sample data so that we can detect where it came from
+    snapshot[length / 2] ^= 0x40;
+
+    handle_teardown();
+    setup_empty();
+
+    kqt_Handle_set_snapshot(handle, snapshot, length);
+    check_unexpected_error();
+
+    long new_length = 0;
+    char* new_snapshot = record_padsynth_snapshot(&new_length);
+
+    fail_unless(new_length == length,
+            "Wrong snapshot length"
+            KT_VALUES("%ld", length, new_length));
+    fail_unless(memcmp(new_snapshot, snapshot, (size_t)length) == 0,
+            "Restored sample data does not match the snapshot");
+
+    kqt_Handle_set_snapshot(handle, NULL, 0);
+    check_unexpected_error();
+
+    free(new_snapshot);
+    free(snapshot);
+}
+END_TEST
+
+
+static void check_snapshot_with_modified_header_is_ignored(long header_offset)
+{
+    long length = 0;
+    char* snapshot = record_padsynth_snapshot(&length);
+    char* modified = malloc((size_t)length);
+    fail_if(modified == NULL, "Could not allocate memory for snapshot copy");
+    memcpy(modified, snapshot, (size_t)length);
+
+    // Modify the header and the sample data
+    modified[header_offset] ^= 0x40;
+    modified[length / 2] ^= 0x40;
+
+    handle_teardown();
+    setup_empty();
+
+    kqt_Handle_set_snapshot(handle, modified, length);
+    check_unexpected_error();
+
+    long new_length = 0;
+    char* new_snapshot = record_padsynth_snapshot(&new_length);
+
+    fail_unless(new_length == length,
+            "Wrong snapshot length"
+            KT_VALUES("%ld", length, new_length));
+    fail_unless(memcmp(new_snapshot, snapshot, (size_t)length) == 0,
+            "Sample data was not computed after ignoring snapshot");
+
+    kqt_Handle_set_snapshot(handle, NULL, 0);
+    check_unexpected_error();
+
+    free(new_snapshot);
+    free(modified);
+    free(snapshot);
+
+    return;
+}
+
+
+START_TEST(Snapshot_of_different_build_is_ignored)
+{
+    // The build string follows the magic, format version and byte order mark
+    check_snapshot_with_modified_header_is_ignored(16);
+}
+END_TEST
+
+
+START_TEST(Snapshot_of_different_generator_revision_is_ignored)
+{
+    // The generator revision follows the build string
+    check_snapshot_with_modified_header_is_ignored(16 + 64);
+}
+END_TEST
+
+
+START_TEST(Invalid_snapshot_is_rejected)
+{
+    static const char data[] = "This is not a snapshot, but it is long enough "
+        "to contain a snapshot header";
+
+    const int success = kqt_Handle_set_snapshot(handle, data, (long)sizeof(data));
+    fail_if(success,
+            "kqt_Handle_set_snapshot accepted invalid data");
+
+    const char* error_string = kqt_Handle_get_error(handle);
+    fail_if(strstr(error_string, "FormatError") == NULL,
+            "Unexpected error for invalid snapshot"
+            KT_VALUES("%s", "FormatError", error_string));
+
+    kqt_Handle_clear_error(handle);
+}
+END_TEST
+
+
+START_TEST(Sample_data_is_shared_between_handles)
+{
+    long length = 0;
+    char* snapshot = record_padsynth_snapshot(&length);
+
+    // Modify the sample data so that we can detect where it came from
+    snapshot[length / 2] ^= 0x40;
+
+    handle_teardown();
+    setup_empty();
+
+    kqt_Handle_set_snapshot(handle, snapshot, length);
+    check_unexpected_error();
+    setup_padsynth_instrument();
+
+    const kqt_Handle first_handle = handle;
+    handle = 0;
+    setup_empty();
+
+    long shared_length = 0;
+    char* shared_snapshot = record_padsynth_snapshot(&shared_length);
+
+    fail_unless(shared_length == length,
+            "Wrong snapshot length"
+            KT_VALUES("%ld", length, shared_length));
+    fail_unless(memcmp(shared_snapshot, snapshot, (size_t)length) == 0,
+            "Sample data was not shared with another handle");
+
+    // Changing the parameters in one handle must not affect the other
+    const kqt_Handle second_handle = handle;
+    handle = first_handle;
+    set_data("au_00/proc_00/c/p_ps_params.json",
+            "[0, { \"sample_length\": 16384"
+            ", \"harmonics\": [[1, 1], [2, 0.25]]"
+            "}]");
+    validate();
+
+    handle = second_handle;
+    kqt_Handle_set_snapshot_recording(handle, 0);
+    check_unexpected_error();
+
+    long new_length = 0;
+    char* new_snapshot = record_padsynth_snapshot(&new_length);
+
+    fail_unless(new_length == length,
+            "Wrong snapshot length"
+            KT_VALUES("%ld", length, new_length));
+    fail_unless(memcmp(new_snapshot, snapshot, (size_t)length) == 0,
+            "Shared sample data was modified by another handle");
+
+    kqt_del_Handle(first_handle);
+    check_unexpected_error();
+
+    free(new_snapshot);
+    free(shared_snapshot);
+    free(snapshot);
+}
+END_TEST
+
+
+START_TEST(Clearing_padsynth_params_does_not_modify_shared_data)
+{
+    // Use the default table size so that the sample map is reused, and a
+    // bandwidth that makes the table differ from the default one
+    static const char params[] =
+        "[0, { \"sample_length\": 262144"
+        ", \"bandwidth_base\": 100"
+        ", \"harmonics\": [[1, 1], [3, 0.5], [5, 0.25]]"
+        "}]";
+
+    long length = 0;
+    char* snapshot = record_padsynth_snapshot_with_params(params, &length);
+
+    const kqt_Handle first_handle = handle;
+    handle = 0;
+    setup_empty();
+    setup_padsynth_instrument_with_params(params);
+
+    // Fall back to default parameters in the second handle
+    kqt_Handle_set_data(handle, "au_00/proc_00/c/p_ps_params.json", "", 0);
+    check_unexpected_error();
+    validate();
+
+    handle_teardown();
+
+    // A new handle gets the shared data of the first handle
+    setup_empty();
+
+    long shared_length = 0;
+    char* shared_snapshot =
+        record_padsynth_snapshot_with_params(params, &shared_length);
+
+    fail_unless(shared_length == length,
+            "Wrong snapshot length"
+            KT_VALUES("%ld", length, shared_length));
+    fail_unless(memcmp(shared_snapshot, snapshot, (size_t)length) == 0,
+            "Shared sample data was modified by clearing parameters in another handle");
+
+    kqt_del_Handle(first_handle);
+    check_unexpected_error();
+
+    free(shared_snapshot);
+    free(snapshot);
+}
+END_TEST
+
+
+static void set_multi_table_padsynth_data(void)
+{
+    assert(handle != 0);
+
+    kqt_Handle_set_loader_thread_count(handle, 2);
+    check_unexpected_error();
+
+    set_data("au_00/p_manifest.json", "[0, { \"type\": \"instrument\" }]");
+    set_data("au_00/proc_00/p_manifest.json", "[0, { \"type\": \"padsynth\" }]");
+    set_data("au_00/proc_00/p_signal_type.json", "[0, \"voice\"]");
+    set_data("au_00/proc_00/c/p_ps_params.json",
+            "[0, { \"sample_length\": 16384"
+            ", \"sample_count\": 4"
+            ", \"pitch_range\": [-3600, 3600]"
+            ", \"harmonics\": [[1, 1], [2, 0.5], [4, 0.125]]"
+            "}]");
+
+    return;
+}
+
+
+START_TEST(Loading_progress_is_reported)
+{
+    set_multi_table_padsynth_data();
+
+    long tasks_done = -1;
+    long tasks_total = -1;
+    long long bytes_done = -1;
+    long long bytes_total = -1;
+    kqt_Handle_get_loading_progress(
+            handle, &tasks_done, &tasks_total, &bytes_done, &bytes_total);
+    check_unexpected_error();
+
+#ifdef ENABLE_THREADS
+    fail_unless(tasks_total == 4,
+            "Wrong number of loading tasks"
+            KT_VALUES("%ld", 4L, tasks_total));
+#endif
+    fail_unless(tasks_done >= 0 && tasks_done <= tasks_total,
+            "Invalid number of finished tasks: %ld of %ld",
+            tasks_done, tasks_total);
+    fail_unless(bytes_total == tasks_total * 16384LL * (long long)sizeof(float),
+            "Wrong amount of data in loading tasks"
+            KT_VALUES("%lld", tasks_total * 16384LL * (long long)sizeof(float),
+                bytes_total));
+    fail_unless(bytes_done >= 0 && bytes_done <= bytes_total,
+            "Invalid amount of processed data: %lld of %lld",
+            bytes_done, bytes_total);
+
+    validate();
+
+    kqt_Handle_get_loading_progress(
+            handle, &tasks_done, &tasks_total, &bytes_done, &bytes_total);
+    check_unexpected_error();
+
+    fail_unless(tasks_done == 0 && tasks_total == 0 &&
+                bytes_done == 0 && bytes_total == 0,
+            "Loading progress was not reset after validation");
+}
+END_TEST
+
+
+START_TEST(Cancelled_loading_invalidates_handle)
+{
+    set_multi_table_padsynth_data();
+
+    const int success = kqt_Handle_cancel_loading(handle);
+    check_unexpected_error();
+    fail_unless(success, "Could not cancel loading");
+
+    fail_if(kqt_Handle_validate(handle),
+            "Handle was validated after cancelled loading");
+}
+END_TEST
+
+
 static Suite* Handle_suite(void)
 {
     Suite* s = suite_create("Handle");
@@ -153,6 +499,26 @@ static Suite* Handle_suite(void)
             tc_render, Set_audio_rate,
             0, MIXING_RATE_COUNT);
 
+    TCase* tc_snapshot = tcase_create("snapshot");
+    suite_add_tcase(s, tc_snapshot);
+    tcase_set_timeout(tc_snapshot, timeout);
+    tcase_add_checked_fixture(tc_snapshot, setup_empty, handle_teardown);
+
+    tcase_add_test(tc_snapshot, Snapshot_data_is_used_instead_of_computed_data);
+    tcase_add_test(tc_snapshot, Snapshot_of_different_build_is_ignored);
+    tcase_add_test(tc_snapshot, Snapshot_of_different_generator_revision_is_ignored);
+    tcase_add_test(tc_snapshot, Invalid_snapshot_is_rejected);
+    tcase_add_test(tc_snapshot, Sample_data_is_shared_between_handles);
+    tcase_add_test(tc_snapshot, Clearing_padsynth_params_does_not_modify_shared_data);
+
+    TCase* tc_loading = tcase_create("loading");
+    suite_add_tcase(s, tc_loading);
+    tcase_set_timeout(tc_loading, timeout);
+    tcase_add_checked_fixture(tc_loading, setup_empty, handle_teardown);
+
+    tcase_add_test(tc_loading, Loading_progress_is_reported);
+    tcase_add_test(tc_loading, Cancelled_loading_invalidates_handle);
+
     return s;
 }
 
@@ -0,0 +1,278 @@
+
+
+/*
+ * Author: agent, 2026
+ *
+ * This file is part of Kunquat.
+ *
+ * CC0 1.0 Universal, http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * To the extent possible under law, Kunquat Affirmers have waived all
+ * copyright and related or neighboring rights to Kunquat.
+ */
+
+
+#include <test_common.h>
+
+#include <mathnum/common.h>
+#include <player/devices/processors/Ks_resample.h>
+#include <player/Work_buffer.h>
+
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+
+#define in_len 2048
+#define out_buf_len 4096
+
+
+static const int32_t rates[][2] =
+{
+    { 44100, 48000 },
+    { 30000, 48000 },
+    { 48000, 44100 },
+    { 48000, 22050 },
+};
+#define rate_count ((int)(sizeof(rates) / sizeof(rates[0])))
+
+
+static Work_buffer* new_Work_buffer_checked(int32_t size)
+{
+    Work_buffer* wb = new_Work_buffer(size);
+    fail_if(wb == NULL, "Could not allocate a Work buffer");
+    Work_buffer_clear(wb, 0, size);
+
+    return wb;
+}
+
+
+static void fill_random(float* dest, int32_t length, uint32_t seed)
+{
+    assert(dest != NULL);
+    assert(length >= 0);
+
+    uint32_t state = seed;
+    for (int32_t i = 0; i < length; ++i)
+    {
+        state = state * 1664525u + 1013904223u;
+        dest[i] = (float)(state >> 8) / (float)(1 << 24) - 0.5f;
+    }
+
+    return;
+}
+
+
+/*
+ * Get the input position that corresponds to an output frame. The resampler
+ * delays the upsampled signal by one frame more than the downsampled one.
+ */
+static double get_input_pos(int32_t out_index, int32_t from_rate, int32_t to_rate)
+{
+    const double delay = KS_SINC_WINDOW_EXTENT + ((to_rate > from_rate) ? 1 : 0);
+    return (out_index + 1) * (double)from_rate / (double)to_rate - delay;
+}
+
+
+static int32_t resample(
+        const float* input, float* output, int32_t from_rate, int32_t to_rate)
+{
+    assert(input != NULL);
+    assert(output != NULL);
+
+    Work_buffer* in_wb = new_Work_buffer_checked(in_len);
+    Work_buffer* out_wb = new_Work_buffer_checked(out_buf_len);
+
+    float* in_values = Work_buffer_get_contents_mut(in_wb);
+    for (int32_t i = 0; i < in_len; ++i)
+        in_values[i] = input[i];
+
+    Resample_state* state = &(Resample_state){ .from_rate = 0 };
+    Resample_state_init(state, from_rate, to_rate);
+    Resample_state_prepare_render(state, in_wb, out_wb);
+    Resample_state_process(state, in_len, out_buf_len);
+
+    const int32_t out_count = state->to_index;
+    const float* out_values = Work_buffer_get_contents(out_wb);
+    for (int32_t i = 0; i < out_count; ++i)
+        output[i] = out_values[i];
+
+    del_Work_buffer(in_wb);
+    del_Work_buffer(out_wb);
+
+    return out_count;
+}
+
+
+START_TEST(Resampling_follows_band_limited_sine)
+{
+    Ks_resample_init_sinc_table();
+
+    const int32_t from_rate = rates[_i][0];
+    const int32_t to_rate = rates[_i][1];
+
+    static const double freqs[] = { 100, 1000, 3000 };
+    for (int fi = 0; fi < (int)(sizeof(freqs) / sizeof(freqs[0])); ++fi)
+    {
+        const double freq = freqs[fi];
+
+        float input[in_len] = { 0.0f };
+        for (int32_t i = 0; i < in_len; ++i)
+            input[i] = (float)sin(2 * PI * freq * i / from_rate);
+
+        float output[out_buf_len] = { 0.0f };
+        const int32_t out_count = resample(input, output, from_rate, to_rate);
+        fail_if(out_count < in_len * (int64_t)to_rate / from_rate - 1,
+                "Resampling from %d Hz to %d Hz produced only %d frames",
+                (int)from_rate, (int)to_rate, (int)out_count);
+
+        // Skip the frames that depend on the silent history before the input
+        for (int32_t i = 2 * KS_SINC_TAP_COUNT; i < out_count; ++i)
+        {
+            const double pos = get_input_pos(i, from_rate, to_rate);
+            const double expected = sin(2 * PI * freq * pos / from_rate);
+            fail_if(fabs(output[i] - expected) > 0.005,
+                    "Resampled %.0f Hz sine from %d Hz to %d Hz has value %.6f"
+                    " instead of %.6f at frame %d",
+                    freq, (int)from_rate, (int)to_rate,
+                    output[i], expected, (int)i);
+        }
+    }
+}
+END_TEST
+
+
+static double get_windowed_sinc(double shift)
+{
+    if (shift == 0)
+        return 1;
+
+    const double w = shift / KS_SINC_WINDOW_EXTENT;
+    const double w2 = w * w;
+    const double window = 0.5 * w2 * w2 + 1.5 * (1 - w2) - 0.5;
+    return sin(shift * PI) / (shift * PI) * window;
+}
+
+
+START_TEST(Resampling_matches_exact_windowed_sinc)
+{
+    Ks_resample_init_sinc_table();
+
+    const int32_t from_rate = rates[_i][0];
+    const int32_t to_rate = rates[_i][1];
+
+    float input[in_len] = { 0.0f };
+    fill_random(input, in_len, 1);
+
+    float output[out_buf_len] = { 0.0f };
+    const int32_t out_count = resample(input, output, from_rate, to_rate);
+
+    for (int32_t i = 0; i < out_count; ++i)
+    {
+        const double pos = get_input_pos(i, from_rate, to_rate);
+        const int32_t first = (int32_t)floor(pos) - KS_SINC_WINDOW_EXTENT + 1;
+        const int32_t last = (int32_t)ceil(pos) + KS_SINC_WINDOW_EXTENT - 1;
+
+        double expected = 0;
+        for (int32_t k = max(0, first); k <= min(last, in_len - 1); ++k)
+            expected += input[k] * get_windowed_sinc(k - pos);
+
+        fail_if(fabs(output[i] - expected) > 0.0001,
+                "Resampling from %d Hz to %d Hz gave %.6f instead of %.6f"
+                " at frame %d",
+                (int)from_rate, (int)to_rate, output[i], expected, (int)i);
+    }
+}
+END_TEST
+
+
+START_TEST(Resampling_in_parts_matches_resampling_at_once)
+{
+    Ks_resample_init_sinc_table();
+
+    const int32_t from_rate = rates[_i][0];
+    const int32_t to_rate = rates[_i][1];
+
+    float input[in_len] = { 0.0f };
+    fill_random(input, in_len, 2);
+
+    float expected[out_buf_len] = { 0.0f };
+    const int32_t expected_count = resample(input, expected, from_rate, to_rate);
+
+    Work_buffer* in_wb = new_Work_buffer_checked(in_len);
+    Work_buffer* out_wb = new_Work_buffer_checked(out_buf_len);
+
+    float* in_values = Work_buffer_get_contents_mut(in_wb);
+    for (int32_t i = 0; i < in_len; ++i)
+        in_values[i] = input[i];
+
+    // Vary the limits so that both the input and the output limit stop
+    // the processing
+    Resample_state* state = &(Resample_state){ .from_rate = 0 };
+    Resample_state_init(state, from_rate, to_rate);
+    Resample_state_prepare_render(state, in_wb, out_wb);
+    for (int part = 0; state->from_index < in_len; ++part)
+    {
+        const int32_t input_limit = 17 + (part % 3) * 20;
+        const int32_t output_limit = 19 + ((part + 1) % 3) * 20;
+
+        const int32_t prev_from_index = state->from_index;
+        const int32_t prev_to_index = state->to_index;
+        Resample_state_process(
+                state, min(input_limit, in_len - state->from_index), output_limit);
+        fail_if((state->from_index == prev_from_index) &&
+                    (state->to_index == prev_to_index),
+                "Resampling made no progress");
+    }
+
+    fail_if(state->to_index != expected_count,
+            "Resampling in parts produced %d frames instead of %d",
+            (int)state->to_index, (int)expected_count);
+
+    const float* actual = Work_buffer_get_contents(out_wb);
+    for (int32_t i = 0; i < expected_count; ++i)
+        fail_if(actual[i] != expected[i],
+                "Resampling in parts gave %.6f instead of %.6f at frame %d",
+                actual[i], expected[i], (int)i);
+
+    del_Work_buffer(in_wb);
+    del_Work_buffer(out_wb);
+}
+END_TEST
+
+
+static Suite* Ks_resample_suite(void)
+{
+    Suite* s = suite_create("Ks_resample");
+
+    const int timeout = DEFAULT_TIMEOUT;
+
+    TCase* tc_sinc = tcase_create("sinc");
+    suite_add_tcase(s, tc_sinc);
+    tcase_set_timeout(tc_sinc, timeout);
+
+    tcase_add_loop_test(tc_sinc, Resampling_follows_band_limited_sine, 0, rate_count);
+    tcase_add_loop_test(tc_sinc, Resampling_matches_exact_windowed_sinc, 0, rate_count);
+    tcase_add_loop_test(
+            tc_sinc, Resampling_in_parts_matches_resampling_at_once, 0, rate_count);
+
+    return s;
+}
+
+
+int main(void)
+{
+    Suite* suite = Ks_resample_suite();
+    SRunner* sr = srunner_create(suite);
+#ifdef K_MEM_DEBUG
+    srunner_set_fork_status(sr, CK_NOFORK);
+#endif
+    srunner_run_all(sr, CK_NORMAL);
+    int fail_count = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    exit(fail_count > 0);
+}
+
+
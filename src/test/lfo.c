@@ -0,0 +1,450 @@
+
+
+/*
+ * Author: agent, 2026
+ *
+ * This file is part of Kunquat.
+ *
+ * CC0 1.0 Universal, http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * To the extent possible under law, Kunquat Affirmers have waived all
+ * copyright and related or neighboring rights to Kunquat.
+ */
+
+
+#include <test_common.h>
+
+#include <mathnum/common.h>
+#include <mathnum/Tstamp.h>
+#include <player/LFO.h>
+#include <player/Slider.h>
+#include <player/Work_buffer.h>
+
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+
+#define audio_rate 1000
+#define tempo 60
+#define fill_len 2048
+
+
+// Block sizes that do and do not line up with the internal chunks of LFO_fill
+static const int32_t chunk_sizes[] = { 1, 7, 64, 100, fill_len };
+#define chunk_size_count ((int)(sizeof(chunk_sizes) / sizeof(chunk_sizes[0])))
+
+
+static Tstamp* make_length(Tstamp* ts, double beats)
+{
+    assert(ts != NULL);
+    assert(beats >= 0);
+
+    const double whole_beats = floor(beats);
+    return Tstamp_set(
+            ts,
+            (int64_t)whole_beats,
+            (int32_t)((beats - whole_beats) * (double)KQT_TSTAMP_BEAT));
+}
+
+
+static Work_buffer* new_cleared_Work_buffer(void)
+{
+    Work_buffer* wb = new_Work_buffer(fill_len);
+    fail_if(wb == NULL, "Could not allocate a Work buffer");
+    Work_buffer_clear(wb, 0, fill_len);
+
+    return wb;
+}
+
+
+static void init_slider(Slider* slider, double slide_beats)
+{
+    assert(slider != NULL);
+
+    Slider_init(slider);
+    Slider_set_audio_rate(slider, audio_rate);
+    Slider_set_tempo(slider, tempo);
+
+    Tstamp* length = make_length(TSTAMP_AUTO, slide_beats);
+    Slider_set_length(slider, length);
+
+    return;
+}
+
+
+/*
+ * Fill the Slider in blocks and compare the result with calling Slider_step
+ * on a copy for each frame. The target is changed at change_pos, which splits
+ * the block at that position.
+ */
+static void check_slider_fill(
+        const Slider* orig_slider,
+        int32_t chunk_size,
+        int32_t change_pos,
+        double new_target)
+{
+    assert(orig_slider != NULL);
+    assert(chunk_size > 0);
+
+    Slider* slider = &(Slider){ .length = { 0 } };
+    Slider* ref = &(Slider){ .length = { 0 } };
+    Slider_copy(slider, orig_slider);
+    Slider_copy(ref, orig_slider);
+
+    Work_buffer* wb = new_cleared_Work_buffer();
+    const float* values = Work_buffer_get_contents(wb);
+
+    double value = Slider_get_value(slider);
+    double ref_value = value;
+
+    int32_t pos = 0;
+    while (pos < fill_len)
+    {
+        if (pos == change_pos)
+        {
+            Slider_change_target(slider, new_target);
+            Slider_change_target(ref, new_target);
+        }
+
+        int32_t stop = min(pos + chunk_size, fill_len);
+        if ((pos < change_pos) && (change_pos < stop))
+            stop = change_pos;
+
+        const int32_t ref_steps = Slider_estimate_active_steps_left(ref);
+        const int32_t ref_const_start =
+            (ref_steps > 0) ? min(pos + ref_steps, stop) : pos;
+
+        value = Slider_fill(slider, wb, pos, stop, value);
+
+        for (int32_t i = pos; i < stop; ++i)
+        {
+            if (Slider_in_progress(ref))
+                ref_value = Slider_step(ref);
+
+            fail_if(fabs(values[i] - ref_value) > 1e-5,
+                    "Slider_fill wrote %.9f instead of %.9f at frame %d"
+                    " with block size %d",
+                    values[i], ref_value, (int)i, (int)chunk_size);
+        }
+
+        fail_if(fabs(value - ref_value) > 1e-5,
+                "Slider_fill returned %.9f instead of %.9f after frame %d",
+                value, ref_value, (int)(stop - 1));
+
+        fail_if(Work_buffer_get_const_start(wb) != ref_const_start,
+                "Slider_fill marked frame %d as constant start instead of %d",
+                (int)Work_buffer_get_const_start(wb), (int)ref_const_start);
+
+        pos = stop;
+    }
+
+    del_Work_buffer(wb);
+
+    return;
+}
+
+
+START_TEST(Slider_fill_matches_repeated_steps)
+{
+    Slider* slider = &(Slider){ .length = { 0 } };
+
+    // The slide ends between frames 123 and 124
+    init_slider(slider, 0.1234);
+    Slider_start(slider, 5, -3);
+
+    check_slider_fill(slider, chunk_sizes[_i], -1, 0);
+}
+END_TEST
+
+
+START_TEST(Slider_fill_matches_repeated_steps_after_target_change)
+{
+    Slider* slider = &(Slider){ .length = { 0 } };
+
+    init_slider(slider, 0.5137);
+    Slider_start(slider, 2, 10);
+
+    check_slider_fill(slider, chunk_sizes[_i], 333, -4);
+}
+END_TEST
+
+
+START_TEST(Slider_fill_without_slide_is_constant)
+{
+    Slider* slider = &(Slider){ .length = { 0 } };
+    init_slider(slider, 0.25);
+
+    Work_buffer* wb = new_cleared_Work_buffer();
+
+    const int32_t chunk_size = chunk_sizes[_i];
+    for (int32_t pos = 0; pos < fill_len; pos += chunk_size)
+    {
+        const int32_t stop = min(pos + chunk_size, fill_len);
+        const double value = Slider_fill(slider, wb, pos, stop, 1.5);
+        fail_if(value != 1.5, "Slider_fill returned %.9f instead of 1.5", value);
+        fail_if(Work_buffer_get_const_start(wb) != pos,
+                "Slider_fill without slide marked frame %d as constant start"
+                " instead of %d",
+                (int)Work_buffer_get_const_start(wb), (int)pos);
+    }
+
+    const float* values = Work_buffer_get_contents(wb);
+    for (int32_t i = 0; i < fill_len; ++i)
+        fail_if(values[i] != 1.5f,
+                "Slider_fill without slide wrote %.9f at frame %d",
+                values[i], (int)i);
+
+    del_Work_buffer(wb);
+}
+END_TEST
+
+
+static void init_lfo(LFO* lfo, double speed, double depth)
+{
+    assert(lfo != NULL);
+
+    LFO_init(lfo);
+    LFO_set_audio_rate(lfo, audio_rate);
+    LFO_set_tempo(lfo, tempo);
+    LFO_set_speed(lfo, speed);
+    LFO_set_depth(lfo, depth);
+    LFO_turn_on(lfo);
+
+    return;
+}
+
+
+typedef void LFO_change(LFO* lfo);
+
+
+/*
+ * Fill the LFO in blocks and compare the result with calling LFO_step on a
+ * copy for each frame. The change is applied at change_pos, which splits the
+ * block at that position. Returns the frame after the last end of oscillation,
+ * or -1 if the oscillation did not end.
+ */
+static int32_t check_lfo_fill(
+        const LFO* orig_lfo, int32_t chunk_size, int32_t change_pos, LFO_change* change)
+{
+    assert(orig_lfo != NULL);
+    assert(chunk_size > 0);
+
+    LFO* lfo = &(LFO){ .on = false };
+    LFO* ref = &(LFO){ .on = false };
+    LFO_copy(lfo, orig_lfo);
+    LFO_copy(ref, orig_lfo);
+
+    Work_buffer* wb = new_cleared_Work_buffer();
+    const float* values = Work_buffer_get_contents(wb);
+
+    int32_t ref_end = -1;
+
+    int32_t pos = 0;
+    while (pos < fill_len)
+    {
+        if ((pos == change_pos) && (change != NULL))
+        {
+            change(lfo);
+            change(ref);
+        }
+
+        int32_t stop = min(pos + chunk_size, fill_len);
+        if ((pos < change_pos) && (change_pos < stop))
+            stop = change_pos;
+
+        Work_buffer_set_const_start(wb, pos);
+        LFO_fill(lfo, wb, pos, stop);
+
+        int32_t ref_const_start = pos;
+        for (int32_t i = pos; i < stop; ++i)
+        {
+            const bool was_active = LFO_active(ref);
+            const double ref_value = LFO_step(ref);
+            if (was_active || LFO_active(ref))
+                ref_const_start = i + 1;
+            if (was_active && !LFO_active(ref))
+                ref_end = i + 1;
+
+            fail_if(fabs(values[i] - ref_value) > 1e-5,
+                    "LFO_fill wrote %.9f instead of %.9f at frame %d"
+                    " with block size %d",
+                    values[i], ref_value, (int)i, (int)chunk_size);
+        }
+
+        fail_if(Work_buffer_get_const_start(wb) != ref_const_start,
+                "LFO_fill marked frame %d as constant start instead of %d",
+                (int)Work_buffer_get_const_start(wb), (int)ref_const_start);
+
+        pos = stop;
+    }
+
+    fail_if(LFO_active(lfo) != LFO_active(ref),
+            "LFO_fill left the LFO %s after the last block",
+            LFO_active(lfo) ? "active" : "inactive");
+
+    del_Work_buffer(wb);
+
+    return ref_end;
+}
+
+
+START_TEST(LFO_fill_matches_repeated_steps_with_fixed_parameters)
+{
+    LFO* lfo = &(LFO){ .on = false };
+    init_lfo(lfo, 7.3, 2.5);
+
+    check_lfo_fill(lfo, chunk_sizes[_i], -1, NULL);
+}
+END_TEST
+
+
+static void slide_speed(LFO* lfo)
+{
+    assert(lfo != NULL);
+
+    // The slide ends between frames 1149 and 1150
+    LFO_set_speed_slide(lfo, make_length(TSTAMP_AUTO, 0.3456));
+    LFO_set_speed(lfo, 31.0);
+
+    return;
+}
+
+
+START_TEST(LFO_fill_matches_repeated_steps_during_speed_slide)
+{
+    LFO* lfo = &(LFO){ .on = false };
+    init_lfo(lfo, 3.0, 1.0);
+
+    check_lfo_fill(lfo, chunk_sizes[_i], 803, slide_speed);
+}
+END_TEST
+
+
+static void slide_depth(LFO* lfo)
+{
+    assert(lfo != NULL);
+
+    LFO_set_depth_slide(lfo, make_length(TSTAMP_AUTO, 0.6789));
+    LFO_set_depth(lfo, 0.25);
+
+    return;
+}
+
+
+START_TEST(LFO_fill_matches_repeated_steps_during_depth_slide)
+{
+    LFO* lfo = &(LFO){ .on = false };
+    init_lfo(lfo, 11.0, 4.0);
+
+    check_lfo_fill(lfo, chunk_sizes[_i], 517, slide_depth);
+}
+END_TEST
+
+
+static void fade_out_depth(LFO* lfo)
+{
+    assert(lfo != NULL);
+
+    LFO_set_depth_slide(lfo, make_length(TSTAMP_AUTO, 0.4321));
+    LFO_set_depth(lfo, 0);
+
+    return;
+}
+
+
+START_TEST(LFO_fill_marks_frames_after_depth_fade_out_as_constant)
+{
+    LFO* lfo = &(LFO){ .on = false };
+    init_lfo(lfo, 5.0, 1.0);
+
+    const int32_t end = check_lfo_fill(lfo, chunk_sizes[_i], 250, fade_out_depth);
+    fail_if(end < 0, "Depth fade-out did not end the oscillation");
+}
+END_TEST
+
+
+static void turn_off(LFO* lfo)
+{
+    assert(lfo != NULL);
+
+    LFO_turn_off(lfo);
+
+    return;
+}
+
+
+START_TEST(LFO_fill_matches_repeated_steps_after_turning_off)
+{
+    LFO* lfo = &(LFO){ .on = false };
+    init_lfo(lfo, 4.0, 1.0);
+
+    check_lfo_fill(lfo, chunk_sizes[_i], 700, turn_off);
+}
+END_TEST
+
+
+static Suite* LFO_suite(void)
+{
+    Suite* s = suite_create("LFO");
+
+    const int timeout = DEFAULT_TIMEOUT;
+
+    TCase* tc_slider = tcase_create("slider");
+    suite_add_tcase(s, tc_slider);
+    tcase_set_timeout(tc_slider, timeout);
+
+    tcase_add_loop_test(
+            tc_slider, Slider_fill_matches_repeated_steps, 0, chunk_size_count);
+    tcase_add_loop_test(
+            tc_slider,
+            Slider_fill_matches_repeated_steps_after_target_change,
+            0, chunk_size_count);
+    tcase_add_loop_test(
+            tc_slider, Slider_fill_without_slide_is_constant, 0, chunk_size_count);
+
+    TCase* tc_lfo = tcase_create("lfo");
+    suite_add_tcase(s, tc_lfo);
+    tcase_set_timeout(tc_lfo, timeout);
+
+    tcase_add_loop_test(
+            tc_lfo,
+            LFO_fill_matches_repeated_steps_with_fixed_parameters,
+            0, chunk_size_count);
+    tcase_add_loop_test(
+            tc_lfo,
+            LFO_fill_matches_repeated_steps_during_speed_slide,
+            0, chunk_size_count);
+    tcase_add_loop_test(
+            tc_lfo,
+            LFO_fill_matches_repeated_steps_during_depth_slide,
+            0, chunk_size_count);
+    tcase_add_loop_test(
+            tc_lfo,
+            LFO_fill_marks_frames_after_depth_fade_out_as_constant,
+            0, chunk_size_count);
+    tcase_add_loop_test(
+            tc_lfo,
+            LFO_fill_matches_repeated_steps_after_turning_off,
+            0, chunk_size_count);
+
+    return s;
+}
+
+
+int main(void)
+{
+    Suite* suite = LFO_suite();
+    SRunner* sr = srunner_create(suite);
+#ifdef K_MEM_DEBUG
+    srunner_set_fork_status(sr, CK_NOFORK);
+#endif
+    srunner_run_all(sr, CK_NORMAL);
+    int fail_count = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    exit(fail_count > 0);
+}
+
+
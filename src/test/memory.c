@@ -1,7 +1,7 @@
 
 
 /*
- * Author: Tomi Jylhä-Ollila, Finland 2013-2018
+ * Author: Tomi Jylhä-Ollila, Finland 2013-2019
  *
  * This file is part of Kunquat.
  *
@@ -16,9 +16,11 @@
 #include <test_common.h>
 
 #include <kunquat/Handle.h>
+#include <containers/Arena.h>
 #include <kunquat/testing.h>
 #include <memory.h>
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
@@ -113,6 +115,245 @@ START_TEST(Aligned_alloc_returns_proper_base_address)
 END_TEST
 
 
+START_TEST(Arena_returns_aligned_separate_blocks)
+{
+    kqt_fake_out_of_memory(-1);
+
+    Arena* arena = new_Arena();
+    fail_if(arena == NULL, "Could not create Arena");
+
+#define ARENA_BLOCK_COUNT 256
+    char* blocks[ARENA_BLOCK_COUNT] = { NULL };
+    int64_t sizes[ARENA_BLOCK_COUNT] = { 0 };
+
+    for (int i = 0; i < ARENA_BLOCK_COUNT; ++i)
+    {
+        // Include blocks that do not fit in any regular chunk
+        sizes[i] = ((i % 37) == 36) ? 100000 + i : 1 + ((i * 13) % 97);
+        blocks[i] = Arena_alloc(arena, sizes[i]);
+        fail_if(blocks[i] == NULL, "Could not allocate block %d from Arena", i);
+
+        const intptr_t addr = (intptr_t)blocks[i];
+        fail_if(addr % (intptr_t)_Alignof(max_align_t) != 0,
+                "Arena block %d at address %p is not properly aligned", i, blocks[i]);
+
+        memset(blocks[i], i, (size_t)sizes[i]);
+    }
+
+    for (int i = 0; i < ARENA_BLOCK_COUNT; ++i)
+    {
+        for (int64_t k = 0; k < sizes[i]; ++k)
+        {
+            if (blocks[i][k] != (char)i)
+            {
+                fail("Arena block %d was overwritten at offset %d", i, (int)k);
+                break;
+            }
+        }
+    }
+#undef ARENA_BLOCK_COUNT
+
+    fail_if(Arena_get_size(arena) <= 0, "Arena did not report its size");
+
+    del_Arena(arena);
+}
+END_TEST
+
+
+START_TEST(Rendering_does_not_allocate_memory)
+{
+    setup_debug_instrument();
+
+#define RENDER_BLOCK_SIZE 256
+    float buf[RENDER_BLOCK_SIZE] = { 0.0f };
+
+    // Let the first render call settle any lazily created state
+    mix_and_fill(buf, RENDER_BLOCK_SIZE);
+
+    kqt_set_render_alloc_trap(1);
+
+    for (int i = 0; i < 64; ++i)
+    {
+        if (i % 16 == 0)
+            kqt_Handle_fire_event(handle, i / 16, Note_On_55_Hz);
+        else if (i % 16 == 8)
+            kqt_Handle_fire_event(handle, i / 16, "[\"n-\", null]");
+
+        mix_and_fill(buf, RENDER_BLOCK_SIZE);
+        kqt_Handle_receive_events(handle);
+        check_unexpected_error();
+    }
+#undef RENDER_BLOCK_SIZE
+
+    const long render_alloc_count = kqt_get_render_alloc_count();
+    kqt_set_render_alloc_trap(0);
+
+    fail_if(render_alloc_count != 0,
+            "Rendering made %ld memory allocations", render_alloc_count);
+}
+END_TEST
+
+
+START_TEST(Rendering_many_voices_does_not_allocate_memory)
+{
+    setup_debug_instrument();
+
+#define RENDER_BLOCK_SIZE 64
+    float buf[RENDER_BLOCK_SIZE] = { 0.0f };
+
+    mix_and_fill(buf, RENDER_BLOCK_SIZE);
+
+    kqt_set_render_alloc_trap(1);
+
+    // Keep more notes playing than fit in the initial voice state reservation
+    for (int i = 0; i < 48; ++i)
+    {
+        kqt_Handle_fire_event(handle, i, Note_On_55_Hz);
+        mix_and_fill(buf, RENDER_BLOCK_SIZE);
+        kqt_Handle_receive_events(handle);
+        check_unexpected_error();
+    }
+#undef RENDER_BLOCK_SIZE
+
+    const long render_alloc_count = kqt_get_render_alloc_count();
+    kqt_set_render_alloc_trap(0);
+
+    fail_if(render_alloc_count != 0,
+            "Rendering made %ld memory allocations", render_alloc_count);
+}
+END_TEST
+
+
+START_TEST(Memory_usage_follows_allocations)
+{
+    kqt_fake_out_of_memory(-1);
+
+    Memory_usage* root = new_Memory_usage(NULL);
+    Memory_usage* child = new_Memory_usage(root);
+    fail_if((root == NULL) || (child == NULL), "Could not create Memory usages");
+
+    Memory_usage* prev_usage = memory_set_usage(child);
+    const Memory_category prev_category = memory_set_category(MEMORY_CATEGORY_SAMPLES);
+    char* block = memory_alloc_items(char, 1000);
+    void* aligned_block = memory_alloc_items_aligned(char, 500, 64);
+    memory_set_category(MEMORY_CATEGORY_PATTERNS);
+    char* cleared_block = memory_calloc_items(char, 300);
+    memory_set_category(prev_category);
+    memory_set_usage(prev_usage);
+
+    fail_if((block == NULL) || (aligned_block == NULL) || (cleared_block == NULL),
+            "Could not allocate memory");
+
+    const int64_t sample_size = Memory_usage_get_size(child, MEMORY_CATEGORY_SAMPLES);
+    fail_if((sample_size < 1500) || (sample_size > 1500 + 64 + 1),
+            "Allocated sample memory was counted as %d bytes", (int)sample_size);
+    fail_if(Memory_usage_get_size(root, MEMORY_CATEGORY_SAMPLES) != sample_size,
+            "Sample memory of the child was not included in the parent");
+    fail_if(Memory_usage_get_size(root, MEMORY_CATEGORY_PATTERNS) != 300,
+            "Pattern memory was counted as %d bytes",
+            (int)Memory_usage_get_size(root, MEMORY_CATEGORY_PATTERNS));
+    fail_if(Memory_usage_get_total_size(root) != sample_size + 300,
+            "Total memory usage does not match the categories");
+
+    // Resized blocks are charged to the original Memory usage
+    block = memory_realloc_items(char, 4000, block);
+    fail_if(block == NULL, "Could not resize memory block");
+    fail_if(Memory_usage_get_size(root, MEMORY_CATEGORY_SAMPLES) != sample_size + 3000,
+            "Resized block was not counted correctly");
+
+    // Counters remain valid after deletion until all blocks are freed
+    del_Memory_usage(child);
+    memory_free(block);
+    memory_free_aligned(aligned_block);
+    memory_free(cleared_block);
+    fail_if(Memory_usage_get_total_size(root) != 0,
+            "Freed memory was not subtracted from the memory usage");
+
+    del_Memory_usage(root);
+}
+END_TEST
+
+
+START_TEST(Transferred_block_is_charged_to_shared_usage)
+{
+    kqt_fake_out_of_memory(-1);
+
+    Memory_usage* usage = new_Memory_usage(NULL);
+    fail_if(usage == NULL, "Could not create Memory usage");
+
+    Memory_usage* shared = memory_get_shared_usage();
+    const int64_t shared_size = Memory_usage_get_size(shared, MEMORY_CATEGORY_SAMPLES);
+
+    Memory_usage* prev_usage = memory_set_usage(usage);
+    const Memory_category prev_category = memory_set_category(MEMORY_CATEGORY_SAMPLES);
+    char* block = memory_alloc_items(char, 1000);
+    memory_set_category(prev_category);
+    memory_set_usage(prev_usage);
+    fail_if(block == NULL, "Could not allocate memory");
+
+    // The block keeps its category and no longer counts towards the old usage
+    memory_transfer(block, shared);
+    fail_if(Memory_usage_get_total_size(usage) != 0,
+            "Transferred block was still charged to the original Memory usage");
+    fail_if(Memory_usage_get_size(shared, MEMORY_CATEGORY_SAMPLES) != shared_size + 1000,
+            "Transferred block was not charged to the shared Memory usage");
+
+    del_Memory_usage(usage);
+    memory_free(block);
+    fail_if(Memory_usage_get_size(shared, MEMORY_CATEGORY_SAMPLES) != shared_size,
+            "Freed block was not subtracted from the shared Memory usage");
+}
+END_TEST
+
+
+static long long get_usage_value(const char* usage, const char* key)
+{
+    const char* pos = strstr(usage, key);
+    fail_if(pos == NULL, "Memory usage does not contain %s:\n%s", key, usage);
+    return strtoll(pos + strlen(key), NULL, 10);
+}
+
+
+START_TEST(Handle_memory_usage_includes_audio_units_and_patterns)
+{
+    setup_debug_instrument();
+
+    const char* usage = kqt_Handle_get_memory_usage(handle);
+    check_unexpected_error();
+    fail_if(usage == NULL, "kqt_Handle_get_memory_usage returned NULL");
+
+    // The top-level counters are written before the audio units
+    const long long total = get_usage_value(usage, "\"total\": ");
+    fail_if(total <= 0, "Handle reported memory usage of %lld bytes", total);
+    fail_if(get_usage_value(usage, "\"voices\": ") <= 0,
+            "Voice pool was not included in the memory usage");
+    get_usage_value(usage, "\"au_00\": {\"total\": ");
+    get_usage_value(usage, "\"proc_00\": {\"total\": ");
+    get_usage_value(usage, "\"proc_01\": {\"total\": ");
+    fail_if(get_usage_value(usage, "\"patterns\": ") != 0,
+            "Empty composition reported pattern memory");
+    get_usage_value(usage, "\"shared\": {\"total\": ");
+
+    set_data("album/p_manifest.json", "[0, {}]");
+    set_data("album/p_tracks.json", "[0, [0]]");
+    set_data("song_00/p_manifest.json", "[0, {}]");
+    set_data("song_00/p_order_list.json", "[0, [ [0, 0] ]]");
+    set_data("pat_000/p_manifest.json", "[0, {}]");
+    set_data("pat_000/instance_000/p_manifest.json", "[0, {}]");
+    set_data("pat_000/col_00/p_triggers.json",
+            "[0, [ [[0, 0], [\"n+\", \"0\"]], [[1, 0], [\"n-\", null]] ]]");
+    validate();
+
+    usage = kqt_Handle_get_memory_usage(handle);
+    check_unexpected_error();
+    fail_if(get_usage_value(usage, "\"patterns\": ") <= 0,
+            "Pattern memory was not included in the memory usage");
+    fail_if(get_usage_value(usage, "\"total\": ") <= total,
+            "Total memory usage did not grow after adding a pattern");
+}
+END_TEST
+
+
 Suite* Memory_suite(void)
 {
     Suite* s = suite_create("Memory");
@@ -128,6 +369,20 @@ Suite* Memory_suite(void)
     suite_add_tcase(s, tc_aligned);
     tcase_set_timeout(tc_aligned, timeout);
 
+    TCase* tc_arena = tcase_create("arena");
+    suite_add_tcase(s, tc_arena);
+    tcase_set_timeout(tc_arena, timeout);
+
+    TCase* tc_render = tcase_create("render");
+    suite_add_tcase(s, tc_render);
+    tcase_set_timeout(tc_render, timeout);
+    tcase_add_checked_fixture(tc_render, setup_empty, handle_teardown);
+
+    TCase* tc_usage = tcase_create("usage");
+    suite_add_tcase(s, tc_usage);
+    tcase_set_timeout(tc_usage, timeout);
+    tcase_add_checked_fixture(tc_usage, setup_empty, handle_teardown);
+
 #ifdef KQT_LONG_TESTS
     tcase_set_timeout(tc_oom, LONG_TIMEOUT);
     tcase_add_test(tc_oom, Out_of_memory_at_handle_creation_fails_cleanly);
@@ -135,6 +390,15 @@ Suite* Memory_suite(void)
 
     tcase_add_loop_test(tc_aligned, Aligned_alloc_returns_proper_base_address, 2, 64);
 
+    tcase_add_test(tc_arena, Arena_returns_aligned_separate_blocks);
+
+    tcase_add_test(tc_render, Rendering_does_not_allocate_memory);
+    tcase_add_test(tc_render, Rendering_many_voices_does_not_allocate_memory);
+
+    tcase_add_test(tc_usage, Memory_usage_follows_allocations);
+    tcase_add_test(tc_usage, Transferred_block_is_charged_to_shared_usage);
+    tcase_add_test(tc_usage, Handle_memory_usage_includes_audio_units_and_patterns);
+
     return s;
 }
 
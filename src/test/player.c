@@ -16,6 +16,7 @@
 #include <test_common.h>
 
 #include <kunquat/Handle.h>
+#include <kunquat/limits.h>
 #include <string/Streader.h>
 
 #include <stdint.h>
@@ -1339,6 +1340,300 @@ START_TEST(Query_voice_count_with_note)
 END_TEST
 
 
+static void check_voice_count(int expected_voices, int expected_groups)
+{
+    kqt_Handle_fire_event(handle, 0, "[\"qvoices\", null]");
+
+    char expected[128] = "";
+    snprintf(expected, 128,
+            "[[0, [\"qvoices\", null]], [0, [\"Avoices\", %d]],"
+            " [0, [\"Avgroups\", %d]]]",
+            expected_voices, expected_groups);
+
+    const char* events = kqt_Handle_receive_events(handle);
+    fail_if(strcmp(events, expected) != 0,
+            "Received event list %s instead of %s", events, expected);
+
+    return;
+}
+
+
+START_TEST(Voice_pool_size_limits_polyphony)
+{
+    set_audio_rate(220);
+    setup_debug_instrument();
+    pause();
+
+    fail_if(kqt_Handle_get_voice_pool_size(handle) != KQT_VOICES_MAX,
+            "Default voice pool size is %d instead of %d",
+            kqt_Handle_get_voice_pool_size(handle), KQT_VOICES_MAX);
+
+    // The debug instrument uses two voices per note
+    const int pool_sizes[] = { 1, 2, 4 };
+    const int expected_voice_counts[] = { 0, 2, 4 };
+    for (int i = 0; i < 3; ++i)
+    {
+        kqt_Handle_set_voice_pool_size(handle, pool_sizes[i]);
+        check_unexpected_error();
+
+        kqt_Handle_fire_event(handle, 0, Note_On_55_Hz);
+        kqt_Handle_fire_event(handle, 1, Note_On_55_Hz);
+        kqt_Handle_play(handle, 1);
+
+        check_voice_count(expected_voice_counts[i], expected_voice_counts[i] / 2);
+    }
+
+    fail_if(kqt_Handle_set_voice_pool_size(handle, 0) != 0,
+            "Voice pool size 0 was accepted");
+    fail_if(kqt_Handle_set_voice_pool_size(handle, KQT_VOICES_MAX + 1) != 0,
+            "Voice pool size %d was accepted", KQT_VOICES_MAX + 1);
+}
+END_TEST
+
+
+START_TEST(Karplus_strong_polyphony_is_limited_by_voice_pool_size)
+{
+    set_data("p_dc_blocker_enabled.json", "[0, false]");
+
+    set_data("out_00/p_manifest.json", "[0, {}]");
+    set_data("p_connections.json", "[0, [ [\"au_00/out_00\", \"out_00\"] ]]");
+
+    set_data("p_control_map.json", "[0, [[0, 0]]]");
+    set_data("control_00/p_manifest.json", "[0, {}]");
+
+    set_data("au_00/p_manifest.json", "[0, { \"type\": \"instrument\" }]");
+    set_data("au_00/out_00/p_manifest.json", "[0, {}]");
+    set_data("au_00/p_connections.json",
+            "[0,"
+            "[ [\"proc_00/C/out_00\", \"out_00\"]"
+            ", [\"proc_01/C/out_00\", \"proc_00/C/in_00\"]"
+            ", [\"proc_02/C/out_00\", \"proc_00/C/in_01\"]"
+            "]"
+            "]");
+
+    // The force processor keeps the voices alive
+    set_data("au_00/proc_00/p_manifest.json", "[0, { \"type\": \"ks\" }]");
+    set_data("au_00/proc_00/p_signal_type.json", "[0, \"voice\"]");
+    set_data("au_00/proc_00/in_00/p_manifest.json", "[0, {}]");
+    set_data("au_00/proc_00/in_01/p_manifest.json", "[0, {}]");
+    set_data("au_00/proc_00/out_00/p_manifest.json", "[0, {}]");
+
+    set_data("au_00/proc_01/p_manifest.json", "[0, { \"type\": \"pitch\" }]");
+    set_data("au_00/proc_01/p_signal_type.json", "[0, \"voice\"]");
+    set_data("au_00/proc_01/out_00/p_manifest.json", "[0, {}]");
+
+    set_data("au_00/proc_02/p_manifest.json", "[0, { \"type\": \"force\" }]");
+    set_data("au_00/proc_02/p_signal_type.json", "[0, \"voice\"]");
+    set_data("au_00/proc_02/out_00/p_manifest.json", "[0, {}]");
+
+    validate();
+    check_unexpected_error();
+
+    set_audio_rate(220);
+    pause();
+
+    // Hold more notes than fit in one chunk of Voice states
+    const int note_count = 40;
+    for (int i = 0; i < note_count; ++i)
+    {
+        kqt_Handle_fire_event(handle, i, Note_On_55_Hz);
+        kqt_Handle_play(handle, 1);
+    }
+
+    kqt_Handle_play(handle, 16);
+
+    // Each note uses three voices
+    check_voice_count(note_count * 3, note_count);
+
+    // The voice pool size is the only limit
+    kqt_Handle_set_voice_pool_size(handle, 9);
+    check_unexpected_error();
+
+    for (int i = 0; i < note_count; ++i)
+    {
+        kqt_Handle_fire_event(handle, i, Note_On_55_Hz);
+        kqt_Handle_play(handle, 1);
+    }
+
+    check_voice_count(9, 3);
+}
+END_TEST
+
+
+static void play_released_and_held_notes(void)
+{
+    kqt_Handle_fire_event(handle, 0, Note_On_55_Hz);
+    kqt_Handle_fire_event(handle, 1, Note_On_55_Hz);
+    kqt_Handle_fire_event(handle, 2, Note_On_55_Hz);
+    kqt_Handle_play(handle, 1);
+
+    kqt_Handle_fire_event(handle, 0, "[\"n-\", null]");
+    kqt_Handle_fire_event(handle, 1, "[\"n-\", null]");
+    kqt_Handle_play(handle, 1);
+
+    // Only count the voices of the next rendering step
+    kqt_Handle_fire_event(handle, 0, "[\"qvoices\", null]");
+    kqt_Handle_receive_events(handle);
+    kqt_Handle_play(handle, 1);
+
+    return;
+}
+
+
+START_TEST(Voice_governor_releases_background_voices_when_over_budget)
+{
+    set_audio_rate(220);
+    setup_debug_instrument();
+    pause();
+
+    fail_if(kqt_Handle_get_voice_governor_budget(handle) != 0,
+            "Voice governor is enabled by default");
+
+    // Without the governor, the released notes are still audible
+    play_released_and_held_notes();
+    check_voice_count(6, 3);
+    fail_if(kqt_Handle_get_voice_governor_intervention_count(handle) != 0,
+            "Disabled voice governor released voices");
+
+    kqt_Handle_fire_event(handle, 2, "[\"n-\", null]");
+    kqt_Handle_play(handle, 16);
+
+    // Any rendering exceeds a budget of one nanosecond
+    kqt_Handle_set_voice_governor_budget(handle, 1);
+    check_unexpected_error();
+    fail_if(kqt_Handle_get_voice_governor_budget(handle) != 1,
+            "Voice governor budget was not set");
+
+    play_released_and_held_notes();
+    check_voice_count(2, 1);
+    fail_if(kqt_Handle_get_voice_governor_intervention_count(handle) <= 0,
+            "Voice governor did not release background voices");
+
+    kqt_Handle_set_voice_governor_budget(handle, 0);
+    fail_if(kqt_Handle_get_voice_governor_intervention_count(handle) != 0,
+            "Setting the voice governor budget did not reset the intervention count");
+
+    fail_if(kqt_Handle_set_voice_governor_budget(handle, -1) != 0,
+            "Negative voice governor budget was accepted");
+}
+END_TEST
+
+
+static void setup_force_instrument(void)
+{
+    set_data("p_dc_blocker_enabled.json", "[0, false]");
+
+    set_data("out_00/p_manifest.json", "[0, {}]");
+    set_data("p_connections.json", "[0, [ [\"au_00/out_00\", \"out_00\"] ]]");
+
+    set_data("p_control_map.json", "[0, [[0, 0]]]");
+    set_data("control_00/p_manifest.json", "[0, {}]");
+
+    set_data("au_00/p_manifest.json", "[0, { \"type\": \"instrument\" }]");
+    set_data("au_00/out_00/p_manifest.json", "[0, {}]");
+    set_data("au_00/p_connections.json",
+            "[0,"
+            "[ [\"proc_03/C/out_00\", \"proc_00/C/in_00\"]"
+            ", [\"proc_00/C/out_00\", \"proc_01/C/in_00\"]"
+            ", [\"proc_02/C/out_00\", \"proc_01/C/in_02\"]"
+            ", [\"proc_01/C/out_00\", \"out_00\"]"
+            "]"
+            "]");
+
+    // The debug processor outputs 0.5 for held notes and -0.5 for released notes
+    set_data("au_00/proc_00/p_manifest.json", "[0, { \"type\": \"debug\" }]");
+    set_data("au_00/proc_00/p_signal_type.json", "[0, \"voice\"]");
+    set_data("au_00/proc_00/in_00/p_manifest.json", "[0, {}]");
+    set_data("au_00/proc_00/out_00/p_manifest.json", "[0, {}]");
+
+    set_data("au_00/proc_01/p_manifest.json", "[0, { \"type\": \"volume\" }]");
+    set_data("au_00/proc_01/p_signal_type.json", "[0, \"voice\"]");
+    set_data("au_00/proc_01/in_00/p_manifest.json", "[0, {}]");
+    set_data("au_00/proc_01/in_01/p_manifest.json", "[0, {}]");
+    set_data("au_00/proc_01/in_02/p_manifest.json", "[0, {}]");
+    set_data("au_00/proc_01/out_00/p_manifest.json", "[0, {}]");
+
+    // The default release envelope keeps released notes audible for a second
+    set_data("au_00/proc_02/p_manifest.json", "[0, { \"type\": \"force\" }]");
+    set_data("au_00/proc_02/p_signal_type.json", "[0, \"voice\"]");
+    set_data("au_00/proc_02/out_00/p_manifest.json", "[0, {}]");
+    set_data("au_00/proc_02/p_b_env_rel_enabled.json", "[0, true]");
+
+    set_data("au_00/proc_03/p_manifest.json", "[0, { \"type\": \"pitch\" }]");
+    set_data("au_00/proc_03/p_signal_type.json", "[0, \"voice\"]");
+    set_data("au_00/proc_03/out_00/p_manifest.json", "[0, {}]");
+
+    validate();
+    check_unexpected_error();
+
+    return;
+}
+
+
+START_TEST(Voice_governor_fades_out_the_quietest_background_voices)
+{
+    set_mix_volume(0);
+    setup_force_instrument();
+    set_audio_rate(4400);
+    pause();
+
+    // Release two notes of different forces and hold one at full force
+    kqt_Handle_fire_event(handle, 0, Note_On_55_Hz);
+    kqt_Handle_fire_event(handle, 0, "[\".f\", -6]");
+    kqt_Handle_fire_event(handle, 1, Note_On_55_Hz);
+    kqt_Handle_fire_event(handle, 1, "[\".f\", -12]");
+    kqt_Handle_fire_event(handle, 2, Note_On_55_Hz);
+    kqt_Handle_play(handle, 1);
+    kqt_Handle_fire_event(handle, 0, "[\"n-\", null]");
+    kqt_Handle_fire_event(handle, 1, "[\"n-\", null]");
+
+    float buf[128] = { 0 };
+    mix_and_fill(buf, 8);
+    const float full_level =
+        (float)(0.5 - 0.5 * (pow(10, -6 / 20.0) + pow(10, -12 / 20.0)));
+    fail_if(fabs(buf[7] - full_level) > 0.01,
+            "Expected level %.4f before the governor, got %.4f", full_level, buf[7]);
+
+    // Any rendering exceeds a budget of one nanosecond, so all background
+    // groups are released after the next call
+    kqt_Handle_set_voice_governor_budget(handle, 1);
+    mix_and_fill(buf, 8);
+    fail_if(kqt_Handle_get_voice_governor_intervention_count(handle) != 1,
+            "Voice governor intervened %lld times instead of once",
+            kqt_Handle_get_voice_governor_intervention_count(handle));
+
+    // Groups that are fading out are not released again
+    const int chunk_size = 8;
+    for (int offset = 0; offset < 128; offset += chunk_size)
+        mix_and_fill(buf + offset, chunk_size);
+
+    fail_if(kqt_Handle_get_voice_governor_intervention_count(handle) != 1,
+            "Voice governor intervened %lld times instead of once",
+            kqt_Handle_get_voice_governor_intervention_count(handle));
+
+    // The released groups ramp down without jumps, and the held note remains
+    // (the debug processor outputs a pulse at the start of each period, so
+    // only the ramp is checked for jumps)
+    fail_if(buf[0] > full_level + 0.1f,
+            "Released groups were cut instead of faded: level %.4f", buf[0]);
+    for (int i = 1; i < 48; ++i)
+    {
+        fail_if(fabs(buf[i] - buf[i - 1]) > 0.05,
+                "Output jumps from %.4f to %.4f at frame %d", buf[i - 1], buf[i], i);
+    }
+    fail_if(fabs(buf[127] - 0.5f) > 0.01,
+            "Expected the held note at level 0.5, got %.4f", buf[127]);
+
+    // A newly released note is handled in a new intervention
+    kqt_Handle_fire_event(handle, 2, "[\"n-\", null]");
+    mix_and_fill(buf, 8);
+    fail_if(kqt_Handle_get_voice_governor_intervention_count(handle) != 2,
+            "Voice governor intervened %lld times instead of twice",
+            kqt_Handle_get_voice_governor_intervention_count(handle));
+}
+END_TEST
+
+
 static bool test_reported_force(Streader* sr, double expected)
 {
     assert(sr != NULL);
@@ -1462,6 +1757,10 @@ static Suite* Player_suite(void)
     tcase_add_test(tc_events, Query_final_location);
     tcase_add_test(tc_events, Query_voice_count_with_silence);
     tcase_add_test(tc_events, Query_voice_count_with_note);
+    tcase_add_test(tc_events, Voice_pool_size_limits_polyphony);
+    tcase_add_test(tc_events, Karplus_strong_polyphony_is_limited_by_voice_pool_size);
+    tcase_add_test(tc_events, Voice_governor_releases_background_voices_when_over_budget);
+    tcase_add_test(tc_events, Voice_governor_fades_out_the_quietest_background_voices);
     tcase_add_test(tc_events, Query_note_force);
 
     return s;
@@ -0,0 +1,195 @@
+
+
+/*
+ * Author: agent, 2026
+ *
+ * This file is part of Kunquat.
+ *
+ * CC0 1.0 Universal, http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * To the extent possible under law, Kunquat Affirmers have waived all
+ * copyright and related or neighboring rights to Kunquat.
+ */
+
+
+#include <test_common.h>
+
+#include <mathnum/common.h>
+#include <mathnum/Random.h>
+
+#include <math.h>
+#include <stdint.h>
+
+
+#define BLOCK_SIZE 4099
+
+
+START_TEST(Block_values_are_in_range)
+{
+    static float values[BLOCK_SIZE];
+
+    Random* random = Random_init(RANDOM_AUTO, "test");
+
+    Random_get_float_lb_block(random, values, BLOCK_SIZE);
+    for (int32_t i = 0; i < BLOCK_SIZE; ++i)
+        fail_unless((values[i] >= 0.0f) && (values[i] < 1.0f),
+                "Random_get_float_lb_block yielded %.9g", values[i]);
+
+    Random_get_float_signal_block(random, values, BLOCK_SIZE);
+    for (int32_t i = 0; i < BLOCK_SIZE; ++i)
+        fail_unless((values[i] >= -1.0f) && (values[i] < 1.0f),
+                "Random_get_float_signal_block yielded %.9g", values[i]);
+}
+END_TEST
+
+
+START_TEST(Block_signal_mean_and_variance_are_correct)
+{
+    static float values[BLOCK_SIZE];
+
+    Random* random = Random_init(RANDOM_AUTO, "test");
+
+    double sum = 0;
+    double sum_sq = 0;
+    const int block_count = 64;
+    for (int bi = 0; bi < block_count; ++bi)
+    {
+        Random_get_float_signal_block(random, values, BLOCK_SIZE);
+        for (int32_t i = 0; i < BLOCK_SIZE; ++i)
+        {
+            sum += values[i];
+            sum_sq += values[i] * values[i];
+        }
+    }
+
+    const double count = (double)BLOCK_SIZE * block_count;
+    const double mean = sum / count;
+    const double variance = (sum_sq / count) - (mean * mean);
+
+    fail_unless(fabs(mean) < 0.01, "Mean of signal values is %.6f", mean);
+    fail_unless(fabs(variance - (1.0 / 3.0)) < 0.01,
+            "Variance of signal values is %.6f", variance);
+}
+END_TEST
+
+
+START_TEST(Block_sequence_does_not_depend_on_block_sizes)
+{
+    static float expected[BLOCK_SIZE];
+    static float actual[BLOCK_SIZE];
+
+    Random* random = Random_init(RANDOM_AUTO, "test");
+    Random_set_seed(random, 7);
+    Random_get_float_signal_block(random, expected, BLOCK_SIZE);
+
+    Random_reset(random);
+    int32_t pos = 0;
+    int32_t block_size = 1;
+    while (pos < BLOCK_SIZE)
+    {
+        const int32_t count = min(block_size, BLOCK_SIZE - pos);
+        Random_get_float_signal_block(random, actual + pos, count);
+        pos += count;
+        block_size = (block_size * 3) % 37;
+    }
+
+    for (int32_t i = 0; i < BLOCK_SIZE; ++i)
+        fail_unless(actual[i] == expected[i],
+                "Value %d of split blocks is %.9g instead of %.9g",
+                (int)i, actual[i], expected[i]);
+}
+END_TEST
+
+
+START_TEST(Block_sequence_is_independent_of_other_values)
+{
+    static float expected[BLOCK_SIZE];
+    static float actual[BLOCK_SIZE];
+
+    Random* random = Random_init(RANDOM_AUTO, "test");
+    const uint64_t expected_value = Random_get_uint64(random);
+    Random_get_float_signal_block(random, expected, BLOCK_SIZE);
+
+    Random_reset(random);
+    Random_get_float_signal_block(random, actual, BLOCK_SIZE / 2);
+    const uint64_t actual_value = Random_get_uint64(random);
+    Random_get_float_signal_block(
+            random, actual + BLOCK_SIZE / 2, BLOCK_SIZE - BLOCK_SIZE / 2);
+
+    fail_unless(actual_value == expected_value,
+            "Block values changed the value of Random_get_uint64");
+
+    for (int32_t i = 0; i < BLOCK_SIZE; ++i)
+        fail_unless(actual[i] == expected[i],
+                "Value %d of interleaved blocks is %.9g instead of %.9g",
+                (int)i, actual[i], expected[i]);
+}
+END_TEST
+
+
+START_TEST(Block_sequence_depends_on_context_and_seed)
+{
+    static float values[3][BLOCK_SIZE];
+
+    Random* randoms[3] =
+    {
+        Random_init(RANDOM_AUTO, "test"),
+        Random_init(RANDOM_AUTO, "test2"),
+        Random_init(RANDOM_AUTO, "test"),
+    };
+    Random_set_seed(randoms[2], 2);
+
+    for (int ri = 0; ri < 3; ++ri)
+        Random_get_float_signal_block(randoms[ri], values[ri], BLOCK_SIZE);
+
+    for (int ri = 1; ri < 3; ++ri)
+    {
+        int32_t equal_count = 0;
+        for (int32_t i = 0; i < BLOCK_SIZE; ++i)
+        {
+            if (values[ri][i] == values[0][i])
+                ++equal_count;
+        }
+
+        fail_unless(equal_count < 4,
+                "Random generator %d yielded %d values equal to the first one",
+                ri, (int)equal_count);
+    }
+}
+END_TEST
+
+
+static Suite* Random_suite(void)
+{
+    Suite* s = suite_create("Random");
+
+    static const int timeout = DEFAULT_TIMEOUT;
+
+    TCase* tc_block = tcase_create("block");
+    suite_add_tcase(s, tc_block);
+    tcase_set_timeout(tc_block, timeout);
+
+    tcase_add_test(tc_block, Block_values_are_in_range);
+    tcase_add_test(tc_block, Block_signal_mean_and_variance_are_correct);
+    tcase_add_test(tc_block, Block_sequence_does_not_depend_on_block_sizes);
+    tcase_add_test(tc_block, Block_sequence_is_independent_of_other_values);
+    tcase_add_test(tc_block, Block_sequence_depends_on_context_and_seed);
+
+    return s;
+}
+
+
+int main(void)
+{
+    Suite* suite = Random_suite();
+    SRunner* sr = srunner_create(suite);
+#ifdef K_MEM_DEBUG
+    srunner_set_fork_status(sr, CK_NOFORK);
+#endif
+    srunner_run_all(sr, CK_NORMAL);
+    const int fail_count = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    exit(fail_count > 0);
+}
+
+
@@ -0,0 +1,257 @@
+
+
+/*
+ * Author: agent, 2026
+ *
+ * This file is part of Kunquat.
+ *
+ * CC0 1.0 Universal, http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * To the extent possible under law, Kunquat Affirmers have waived all
+ * copyright and related or neighboring rights to Kunquat.
+ */
+
+
+#include <test_common.h>
+
+#include <init/Background_loader.h>
+#include <init/devices/Device_field.h>
+#include <init/devices/param_types/Sample.h>
+#include <init/devices/param_types/Sample_params.h>
+#include <mathnum/common.h>
+#include <memory.h>
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+
+#define TEST_LENGTH 1024
+#define TEST_PERIOD 64.0
+
+
+static Sample* make_sine_sample(int32_t length)
+{
+    float* buf = memory_alloc_items(float, length);
+    fail_if(buf == NULL, "Could not allocate memory for sample data");
+    for (int32_t i = 0; i < length; ++i)
+        buf[i] = (float)sin(i * PI2 / TEST_PERIOD);
+
+    Sample* sample = new_Sample_from_buffers(&buf, 1, length);
+    fail_if(sample == NULL, "Could not allocate memory for sample");
+
+    fail_if(!Sample_build_mips(sample), "Could not allocate memory for mip levels");
+
+    return sample;
+}
+
+
+START_TEST(Mip_levels_halve_sample_length)
+{
+    Sample* sample = make_sine_sample(TEST_LENGTH);
+
+    fail_unless(sample->mip_count == SAMPLE_MIP_LEVELS_MAX,
+            "Sample of length %d has %d mip levels instead of %d",
+            TEST_LENGTH, sample->mip_count, SAMPLE_MIP_LEVELS_MAX);
+
+    for (int level = 1; level <= sample->mip_count; ++level)
+    {
+        const Sample* mip = Sample_get_mip(sample, level);
+        const int64_t expected_len = TEST_LENGTH >> level;
+        fail_unless(mip->len == expected_len,
+                "Mip level %d has length %d instead of %d",
+                level, (int)mip->len, (int)expected_len);
+    }
+
+    del_Sample(sample);
+
+    // Short samples do not get mip levels
+    Sample* short_sample = make_sine_sample(32);
+    fail_unless(short_sample->mip_count == 0,
+            "Sample of length 32 has %d mip levels", short_sample->mip_count);
+    del_Sample(short_sample);
+}
+END_TEST
+
+
+START_TEST(Mip_levels_follow_decimated_signal)
+{
+    Sample* sample = make_sine_sample(TEST_LENGTH);
+
+    for (int level = 1; level <= sample->mip_count; ++level)
+    {
+        const Sample* mip = Sample_get_mip(sample, level);
+        const float* data = mip->data[0];
+        const int step = 1 << level;
+
+        // Skip the edges where the filter reaches outside the sample
+        for (int64_t i = 16; i < mip->len - 16; ++i)
+        {
+            const double expected = sin((double)(i * step) * PI2 / TEST_PERIOD);
+            fail_unless(fabs(data[i] - expected) < 0.01,
+                    "Mip level %d has %.6f instead of %.6f at index %d",
+                    level, data[i], expected, (int)i);
+        }
+    }
+
+    del_Sample(sample);
+}
+END_TEST
+
+
+static void check_mip_level(
+        const Sample* sample,
+        Sample_loop loop_mode,
+        int64_t loop_start,
+        int64_t loop_end,
+        double max_shift,
+        int expected)
+{
+    Sample_params* params = Sample_params_init(&(Sample_params){ .loop_start = 0 });
+    params->loop = loop_mode;
+    params->loop_start = loop_start;
+    params->loop_end = loop_end;
+
+    const int level = Sample_get_mip_level(sample, loop_mode, params, max_shift);
+    fail_unless(level == expected,
+            "Mip level for shift %.2f and loop %d..%d was %d instead of %d",
+            max_shift, (int)loop_start, (int)loop_end, level, expected);
+
+    return;
+}
+
+
+START_TEST(Mip_level_keeps_pitch_ratio_below_two)
+{
+    Sample* sample = make_sine_sample(TEST_LENGTH);
+
+    check_mip_level(sample, SAMPLE_LOOP_OFF, 0, 0, 0.5, 0);
+    check_mip_level(sample, SAMPLE_LOOP_OFF, 0, 0, 1.99, 0);
+    check_mip_level(sample, SAMPLE_LOOP_OFF, 0, 0, 2.0, 1);
+    check_mip_level(sample, SAMPLE_LOOP_OFF, 0, 0, 3.99, 1);
+    check_mip_level(sample, SAMPLE_LOOP_OFF, 0, 0, 4.0, 2);
+    check_mip_level(sample, SAMPLE_LOOP_OFF, 0, 0, 8.0, 3);
+
+    // The level cannot exceed the number of mip levels
+    check_mip_level(sample, SAMPLE_LOOP_OFF, 0, 0, 100.0, SAMPLE_MIP_LEVELS_MAX);
+
+    del_Sample(sample);
+
+    // This sample is only long enough for one level
+    Sample* short_sample = make_sine_sample(100);
+    fail_unless(short_sample->mip_count == 1,
+            "Sample of length 100 has %d mip levels instead of 1",
+            short_sample->mip_count);
+    check_mip_level(short_sample, SAMPLE_LOOP_OFF, 0, 0, 8.0, 1);
+    del_Sample(short_sample);
+
+    // Samples without mip levels are always rendered directly
+    Sample* tiny_sample = make_sine_sample(32);
+    check_mip_level(tiny_sample, SAMPLE_LOOP_OFF, 0, 0, 8.0, 0);
+    del_Sample(tiny_sample);
+}
+END_TEST
+
+
+START_TEST(Mip_level_represents_loop_points_exactly)
+{
+    const Sample_loop loop_mode = (_i == 0) ? SAMPLE_LOOP_UNI : SAMPLE_LOOP_BI;
+
+    Sample* sample = make_sine_sample(TEST_LENGTH);
+
+    // Both loop points must be multiples of the level step
+    check_mip_level(sample, loop_mode, 64, 960, 8.0, 3);
+    check_mip_level(sample, loop_mode, 68, 960, 8.0, 2);
+    check_mip_level(sample, loop_mode, 66, 960, 8.0, 1);
+    check_mip_level(sample, loop_mode, 65, 960, 8.0, 0);
+    check_mip_level(sample, loop_mode, 64, 964, 8.0, 2);
+    check_mip_level(sample, loop_mode, 64, 962, 8.0, 1);
+    check_mip_level(sample, loop_mode, 64, 961, 8.0, 0);
+
+    // Alignment does not raise the level above what the pitch ratio needs
+    check_mip_level(sample, loop_mode, 64, 960, 2.5, 1);
+
+    // The loop must be at least 2 frames long at the chosen level
+    check_mip_level(sample, loop_mode, 0, 16, 8.0, 3);
+    check_mip_level(sample, loop_mode, 0, 8, 8.0, 2);
+    check_mip_level(sample, loop_mode, 0, 4, 8.0, 1);
+    check_mip_level(sample, loop_mode, 0, 2, 8.0, 0);
+
+    // Loop points are ignored when the loop is disabled
+    check_mip_level(sample, SAMPLE_LOOP_OFF, 65, 961, 8.0, 3);
+
+    del_Sample(sample);
+}
+END_TEST
+
+
+START_TEST(Mips_are_built_by_background_loader)
+{
+    const int thread_count = _i;
+
+    Background_loader* loader = new_Background_loader();
+    fail_if(loader == NULL, "Could not allocate memory for background loader");
+    Background_loader_set_thread_count(loader, thread_count);
+
+    float* buf = memory_alloc_items(float, TEST_LENGTH);
+    fail_if(buf == NULL, "Could not allocate memory for sample data");
+    for (int32_t i = 0; i < TEST_LENGTH; ++i)
+        buf[i] = (float)sin(i * PI2 / TEST_PERIOD);
+
+    Sample* sample = new_Sample_from_buffers(&buf, 1, TEST_LENGTH);
+    fail_if(sample == NULL, "Could not allocate memory for sample");
+
+    Device_field* field = new_Device_field("smp_000/p_sample.wav", &sample);
+    fail_if(field == NULL, "Could not allocate memory for device field");
+
+    Device_field_build_sample_mips(field, loader);
+    Background_loader_wait_idle(loader);
+
+    fail_unless(Background_loader_get_first_error(loader) == NULL,
+            "Building mip levels with %d threads failed: %s",
+            thread_count, Background_loader_get_first_error(loader)->message);
+    fail_unless(sample->mip_count == SAMPLE_MIP_LEVELS_MAX,
+            "Sample built with %d threads has %d mip levels instead of %d",
+            thread_count, sample->mip_count, SAMPLE_MIP_LEVELS_MAX);
+
+    del_Device_field(field);
+    del_Background_loader(loader);
+}
+END_TEST
+
+
+static Suite* Sample_suite(void)
+{
+    Suite* s = suite_create("Sample");
+
+    static const int timeout = DEFAULT_TIMEOUT;
+
+    TCase* tc_mips = tcase_create("mips");
+    suite_add_tcase(s, tc_mips);
+    tcase_set_timeout(tc_mips, timeout);
+
+    tcase_add_test(tc_mips, Mip_levels_halve_sample_length);
+    tcase_add_test(tc_mips, Mip_levels_follow_decimated_signal);
+    tcase_add_test(tc_mips, Mip_level_keeps_pitch_ratio_below_two);
+    tcase_add_loop_test(tc_mips, Mip_level_represents_loop_points_exactly, 0, 2);
+    tcase_add_loop_test(tc_mips, Mips_are_built_by_background_loader, 0, 3);
+
+    return s;
+}
+
+
+int main(void)
+{
+    Suite* suite = Sample_suite();
+    SRunner* sr = srunner_create(suite);
+#ifdef K_MEM_DEBUG
+    srunner_set_fork_status(sr, CK_NOFORK);
+#endif
+    srunner_run_all(sr, CK_NORMAL);
+    const int fail_count = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    exit(fail_count > 0);
+}
+
+
@@ -0,0 +1,465 @@
+
+
+/*
+ * Author: agent, 2026
+ *
+ * This file is part of Kunquat.
+ *
+ * CC0 1.0 Universal, http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * To the extent possible under law, Kunquat Affirmers have waived all
+ * copyright and related or neighboring rights to Kunquat.
+ */
+
+
+#include <test_common.h>
+
+#include <init/devices/param_types/Sample.h>
+#include <init/devices/param_types/Sample_params.h>
+#include <init/devices/processors/Proc_sample.h>
+#include <mathnum/common.h>
+#include <memory.h>
+#include <player/devices/processors/Sample_interp.h>
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+
+#define TEST_LENGTH 1024
+#define TEST_PERIOD 37.3
+#define MAX_FRAMES 256
+
+
+static const char* interp_names[] =
+{
+    [SAMPLE_INTERP_CUBIC] = "cubic",
+    [SAMPLE_INTERP_SINC] = "sinc",
+};
+
+
+// Maximum errors against the signal for a sine with a period of TEST_PERIOD
+static const double max_errors[] =
+{
+    [SAMPLE_INTERP_CUBIC] = 0.0002,
+    [SAMPLE_INTERP_SINC] = 0.002,
+};
+
+
+void setup_interp_tables(void)
+{
+    Sample_interp_init_tables();
+    return;
+}
+
+
+typedef double (*signal_func)(double x);
+
+
+static double sine_signal(double x)
+{
+    return sin(x * PI2 / TEST_PERIOD);
+}
+
+
+/**
+ * Create a mono Sample filled with \a signal at integer positions.
+ *
+ * 16-bit samples are filled at half amplitude to leave room for rounding.
+ */
+static Sample* make_test_sample(bool is_float, int32_t length, signal_func signal)
+{
+    Sample* sample = NULL;
+
+    if (is_float)
+    {
+        float* buf = memory_alloc_items(float, length);
+        fail_if(buf == NULL, "Could not allocate memory for sample data");
+        for (int32_t i = 0; i < length; ++i)
+            buf[i] = (float)signal(i);
+
+        sample = new_Sample_from_buffers(&buf, 1, length);
+    }
+    else
+    {
+        int16_t* buf = memory_alloc_items(int16_t, length);
+        fail_if(buf == NULL, "Could not allocate memory for sample data");
+        for (int32_t i = 0; i < length; ++i)
+            buf[i] = (int16_t)lrint(signal(i) * 0x4000);
+
+        sample = new_Sample();
+        fail_if(sample == NULL, "Could not allocate memory for sample");
+        sample->bits = 16;
+        sample->is_float = false;
+        sample->len = length;
+        sample->data[0] = buf;
+    }
+
+    fail_if(sample == NULL, "Could not allocate memory for sample");
+
+    return sample;
+}
+
+
+/**
+ * Render frames at positions start + i * step and return the frame count.
+ *
+ * Positions at or beyond \a wrap_end are moved back by \a wrap_length, which
+ * matches the positions of a forward loop.
+ */
+static int32_t render_test_frames(
+        const Sample* sample,
+        const Sample_params* params,
+        Sample_interp interp,
+        double start,
+        double step,
+        int32_t frame_count,
+        double wrap_end,
+        double wrap_length,
+        double positions_out[MAX_FRAMES],
+        float out[MAX_FRAMES])
+{
+    int32_t positions[MAX_FRAMES] = { 0 };
+    float positions_rem[MAX_FRAMES] = { 0 };
+    float force_scales[MAX_FRAMES] = { 0 };
+
+    for (int32_t i = 0; i < frame_count; ++i)
+    {
+        double x = start + i * step;
+        if (x >= wrap_end)
+            x -= wrap_length;
+
+        positions_out[i] = x;
+        positions[i] = (int32_t)floor(x);
+        positions_rem[i] = (float)(x - floor(x));
+        force_scales[i] = 1;
+        out[i] = NAN;
+    }
+
+    float* abufs[KQT_BUFFERS_MAX] = { out, NULL };
+
+    return Sample_render_interpolated(
+            sample,
+            params->loop,
+            params,
+            interp,
+            positions,
+            positions_rem,
+            force_scales,
+            abufs,
+            frame_count,
+            1.0);
+}
+
+
+static void check_signal(
+        const double positions[MAX_FRAMES],
+        const float out[MAX_FRAMES],
+        int32_t frame_count,
+        signal_func signal,
+        double scale,
+        double max_error,
+        const char* desc)
+{
+    for (int32_t i = 0; i < frame_count; ++i)
+    {
+        const double expected = signal(positions[i]) * scale;
+        fail_if(fabs(out[i] - expected) > max_error,
+                "%s interpolation at position %.4f yields %.7g instead of %.7g",
+                desc, positions[i], out[i], expected);
+    }
+
+    return;
+}
+
+
+static void check_interp_follows_sine(
+        Sample_interp interp, bool is_float, Sample_loop loop, double start)
+{
+    Sample* sample = make_test_sample(is_float, TEST_LENGTH, sine_signal);
+
+    // A loop of 10 whole periods keeps the looped signal continuous
+    Sample_params* params = Sample_params_init(&(Sample_params){ .loop_start = 0 });
+    params->loop = loop;
+    params->loop_end = TEST_LENGTH - 3;
+    params->loop_start = params->loop_end - 373;
+
+    const double wrap_end =
+        (loop == SAMPLE_LOOP_UNI) ? (double)params->loop_end : INFINITY;
+    const double wrap_length = (double)(params->loop_end - params->loop_start);
+
+    double positions[MAX_FRAMES] = { 0 };
+    float out[MAX_FRAMES] = { 0 };
+    const int32_t frame_count = 64;
+    const int32_t rendered = render_test_frames(
+            sample,
+            params,
+            interp,
+            start,
+            0.37,
+            frame_count,
+            wrap_end,
+            wrap_length,
+            positions,
+            out);
+
+    fail_unless(rendered == frame_count,
+            "Rendered %d frames instead of %d", (int)rendered, (int)frame_count);
+
+    const double scale = is_float ? 1.0 : 0.5;
+    char desc[64] = "";
+    snprintf(desc, sizeof(desc), "%s %s",
+            is_float ? "Float" : "16-bit", interp_names[interp]);
+    check_signal(
+            positions, out, frame_count, sine_signal, scale, max_errors[interp], desc);
+
+    del_Sample(sample);
+
+    return;
+}
+
+
+START_TEST(Interpolation_follows_known_signal)
+{
+    const Sample_interp interp = (_i % 2 == 0) ? SAMPLE_INTERP_CUBIC : SAMPLE_INTERP_SINC;
+    const bool is_float = (_i / 2 == 0);
+
+    check_interp_follows_sine(interp, is_float, SAMPLE_LOOP_OFF, 100.29);
+}
+END_TEST
+
+
+START_TEST(Interpolation_continues_across_forward_loop_end)
+{
+    const Sample_interp interp = (_i % 2 == 0) ? SAMPLE_INTERP_CUBIC : SAMPLE_INTERP_SINC;
+    const bool is_float = (_i / 2 == 0);
+
+    // Taps cross the loop end between the positions TEST_LENGTH - 14 and
+    // TEST_LENGTH - 3, and the positions themselves wrap at TEST_LENGTH - 3
+    check_interp_follows_sine(interp, is_float, SAMPLE_LOOP_UNI, TEST_LENGTH - 14.71);
+}
+END_TEST
+
+
+#define BI_PERIOD 32.0
+#define BI_LOOP_START 256
+#define BI_LOOP_END (BI_LOOP_START + 3 * 32 + 1)
+
+
+static double cosine_signal(double x)
+{
+    // Both turning points of the bidirectional loop are at extrema
+    return cos((x - BI_LOOP_START) * PI2 / BI_PERIOD);
+}
+
+
+START_TEST(Interpolation_reflects_at_bidirectional_loop_end)
+{
+    const Sample_interp interp = (_i % 2 == 0) ? SAMPLE_INTERP_CUBIC : SAMPLE_INTERP_SINC;
+    const bool is_float = (_i / 2 == 0);
+
+    // Data after the loop end does not follow the signal, so reading it by
+    // mistake would show up as an error
+    Sample* sample = make_test_sample(is_float, BI_LOOP_END + 16, cosine_signal);
+    for (int32_t i = BI_LOOP_END; i < BI_LOOP_END + 16; ++i)
+    {
+        if (is_float)
+            ((float*)sample->data[0])[i] = -1;
+        else
+            ((int16_t*)sample->data[0])[i] = -0x4000;
+    }
+
+    Sample_params* params = Sample_params_init(&(Sample_params){ .loop_start = 0 });
+    params->loop = SAMPLE_LOOP_BI;
+    params->loop_start = BI_LOOP_START;
+    params->loop_end = BI_LOOP_END;
+
+    // Approach the turning point at BI_LOOP_END - 1 from below
+    double positions[MAX_FRAMES] = { 0 };
+    float out[MAX_FRAMES] = { 0 };
+    const int32_t frame_count = 40;
+    const int32_t rendered = render_test_frames(
+            sample,
+            params,
+            interp,
+            BI_LOOP_END - 11.8,
+            0.27,
+            frame_count,
+            INFINITY,
+            0,
+            positions,
+            out);
+
+    fail_unless(rendered == frame_count,
+            "Rendered %d frames instead of %d", (int)rendered, (int)frame_count);
+
+    // The period is shorter than in the other tests
+    const double max_error = 0.005;
+    const double scale = is_float ? 1.0 : 0.5;
+    char desc[64] = "";
+    snprintf(desc, sizeof(desc), "Bidirectional %s %s",
+            is_float ? "float" : "16-bit", interp_names[interp]);
+    check_signal(positions, out, frame_count, cosine_signal, scale, max_error, desc);
+
+    del_Sample(sample);
+}
+END_TEST
+
+
+START_TEST(Unlooped_sample_ends_at_sample_length)
+{
+    const Sample_interp interp = (_i % 2 == 0) ? SAMPLE_INTERP_CUBIC : SAMPLE_INTERP_SINC;
+
+    Sample* sample = make_test_sample(true, TEST_LENGTH, sine_signal);
+    Sample_params* params = Sample_params_init(&(Sample_params){ .loop_start = 0 });
+
+    double positions[MAX_FRAMES] = { 0 };
+    float out[MAX_FRAMES] = { 0 };
+    const int32_t frame_count = 16;
+    const int32_t rendered = render_test_frames(
+            sample,
+            params,
+            interp,
+            TEST_LENGTH - 3.5,
+            0.5,
+            frame_count,
+            INFINITY,
+            0,
+            positions,
+            out);
+
+    // Positions TEST_LENGTH - 3.5 ... TEST_LENGTH - 0.5 are inside the sample
+    fail_unless(rendered == 7,
+            "Rendered %d frames instead of 7", (int)rendered);
+
+    for (int32_t i = 0; i < rendered; ++i)
+    {
+        fail_unless(isfinite(out[i]) && (fabsf(out[i]) <= 1.1f),
+                "Frame %d at position %.4f has value %.7g",
+                (int)i, positions[i], out[i]);
+    }
+
+    del_Sample(sample);
+}
+END_TEST
+
+
+#ifdef KQT_LONG_TESTS
+
+START_TEST(Benchmark_voices_per_core)
+{
+    static const int32_t audio_rate = 48000;
+    static const int32_t round_count = 4000;
+
+    Sample* sample = make_test_sample(false, TEST_LENGTH * 64, sine_signal);
+    Sample_params* params = Sample_params_init(&(Sample_params){ .loop_start = 0 });
+
+    // Play at a pitch ratio of 1.37, moving to a new part of the sample in each round
+    int32_t base_positions[MAX_FRAMES] = { 0 };
+    int32_t positions[MAX_FRAMES] = { 0 };
+    float positions_rem[MAX_FRAMES] = { 0 };
+    float force_scales[MAX_FRAMES] = { 0 };
+    for (int32_t i = 0; i < MAX_FRAMES; ++i)
+    {
+        const double x = i * 1.37;
+        base_positions[i] = (int32_t)x;
+        positions_rem[i] = (float)(x - floor(x));
+        force_scales[i] = 1;
+    }
+
+    float out[MAX_FRAMES] = { 0 };
+    float* abufs[KQT_BUFFERS_MAX] = { out, NULL };
+
+    for (int interp = SAMPLE_INTERP_CUBIC; interp < SAMPLE_INTERP_COUNT; ++interp)
+    {
+        double check_sum = 0;
+        const int64_t start = get_bench_time();
+
+        for (int32_t r = 0; r < round_count; ++r)
+        {
+            const int32_t offset = (r % 128) * 351;
+            for (int32_t i = 0; i < MAX_FRAMES; ++i)
+                positions[i] = base_positions[i] + offset;
+
+            Sample_render_interpolated(
+                    sample,
+                    params->loop,
+                    params,
+                    (Sample_interp)interp,
+                    positions,
+                    positions_rem,
+                    force_scales,
+                    abufs,
+                    MAX_FRAMES,
+                    1.0);
+
+            check_sum += out[r % MAX_FRAMES];
+        }
+
+        const int64_t elapsed = get_bench_time() - start;
+        const int64_t frame_count = (int64_t)round_count * MAX_FRAMES;
+
+        fail_unless(isfinite(check_sum), "Interpolation produced non-finite values");
+
+        report_bench(interp_names[interp], "frame", elapsed, frame_count);
+        fprintf(stderr, "%s: about %.0f voices per core at %d Hz\n",
+                interp_names[interp],
+                1e9 * (double)frame_count / ((double)elapsed * audio_rate),
+                (int)audio_rate);
+    }
+
+    del_Sample(sample);
+}
+END_TEST
+
+#endif // KQT_LONG_TESTS
+
+
+static Suite* Sample_interp_suite(void)
+{
+    Suite* s = suite_create("Sample_interp");
+
+    static const int timeout = DEFAULT_TIMEOUT;
+
+    TCase* tc_correctness = tcase_create("correctness");
+    suite_add_tcase(s, tc_correctness);
+    tcase_set_timeout(tc_correctness, timeout);
+    tcase_add_checked_fixture(tc_correctness, setup_interp_tables, NULL);
+
+    // Loop index bit 0 selects the mode and bit 1 the sample format
+    tcase_add_loop_test(tc_correctness, Interpolation_follows_known_signal, 0, 4);
+    tcase_add_loop_test(
+            tc_correctness, Interpolation_continues_across_forward_loop_end, 0, 4);
+    tcase_add_loop_test(
+            tc_correctness, Interpolation_reflects_at_bidirectional_loop_end, 0, 4);
+    tcase_add_loop_test(tc_correctness, Unlooped_sample_ends_at_sample_length, 0, 2);
+
+#ifdef KQT_LONG_TESTS
+    TCase* tc_benchmark = tcase_create("benchmark");
+    suite_add_tcase(s, tc_benchmark);
+    tcase_set_timeout(tc_benchmark, LONG_TIMEOUT);
+    tcase_add_checked_fixture(tc_benchmark, setup_interp_tables, NULL);
+
+    tcase_add_test(tc_benchmark, Benchmark_voices_per_core);
+#endif
+
+    return s;
+}
+
+
+int main(void)
+{
+    Suite* suite = Sample_interp_suite();
+    SRunner* sr = srunner_create(suite);
+#ifdef K_MEM_DEBUG
+    srunner_set_fork_status(sr, CK_NOFORK);
+#endif
+    srunner_run_all(sr, CK_NORMAL);
+    const int fail_count = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    exit(fail_count > 0);
+}
+
+
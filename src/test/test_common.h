@@ -1,7 +1,7 @@
 
 
 /*
- * Author: Tomi Jylhä-Ollila, Finland 2012-2016
+ * Author: Tomi Jylhä-Ollila, Finland 2012-2019
  *
  * This file is part of Kunquat.
  *
@@ -18,7 +18,10 @@
 
 #include <check.h>
 
+#include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <time.h>
 
 
 #ifdef K_MEM_DEBUG
@@ -37,6 +40,51 @@
 #define LONG_TIMEOUT 300
 
 
+#ifdef KQT_LONG_TESTS
+
+/**
+ * Get the current time for measuring benchmarks.
+ *
+ * \return   The time in nanoseconds from an unspecified starting point.
+ */
+static inline int64_t get_bench_time(void)
+{
+    struct timespec ts;
+
+#ifdef CLOCK_MONOTONIC
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0)
+        return 0;
+#else
+    if (timespec_get(&ts, TIME_UTC) != TIME_UTC)
+        return 0;
+#endif
+
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+
+/**
+ * Print the result of a benchmark.
+ *
+ * Benchmarks only report their results, as the timings depend on the machine.
+ *
+ * \param name         The name of the benchmark -- must not be \c NULL.
+ * \param unit         The name of the measured unit of work -- must not be
+ *                     \c NULL.
+ * \param elapsed      The elapsed time in nanoseconds -- must be >= \c 0.
+ * \param unit_count   The number of units processed -- must be > \c 0.
+ */
+static inline void report_bench(
+        const char* name, const char* unit, int64_t elapsed, int64_t unit_count)
+{
+    fprintf(stderr, "%s: %.3f ns per %s\n",
+            name, (double)elapsed / (double)unit_count, unit);
+    return;
+}
+
+#endif // KQT_LONG_TESTS
+
+
 #endif // KQT_TEST_COMMON_H
 
 
@@ -335,6 +335,24 @@ START_TEST(Validation_rejects_nonexistent_pattern_instances_in_songs)
 END_TEST
 
 
+START_TEST(Validation_rejects_removal_of_pattern_instance_used_in_song)
+{
+    set_silent_composition();
+    validate();
+
+    set_data("pat_000/col_00/p_triggers.json", "[0, [ [[0, 0], [\"n+\", \"0\"]] ]]");
+    validate();
+
+    set_data("pat_000/instance_000/p_manifest.json", "");
+
+    kqt_Handle_validate(handle);
+
+    check_validation_error("instance",
+            "Handle accepts removal of a pattern instance used in a song");
+}
+END_TEST
+
+
 START_TEST(Validation_rejects_reused_pattern_instances_in_song)
 {
     set_silent_composition();
@@ -411,6 +429,8 @@ Suite* Validation_suite(void)
             0, TEST_PAT_INST_COUNT);
     tcase_add_test(tc_reject,
             Validation_rejects_nonexistent_pattern_instances_in_songs);
+    tcase_add_test(tc_reject,
+            Validation_rejects_removal_of_pattern_instance_used_in_song);
     tcase_add_test(tc_reject,
             Validation_rejects_reused_pattern_instances_in_song);
     tcase_add_test(tc_reject,
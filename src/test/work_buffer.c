@@ -0,0 +1,387 @@
+
+
+/*
+ * Author: agent, 2026
+ *
+ * This file is part of Kunquat.
+ *
+ * CC0 1.0 Universal, http://creativecommons.org/publicdomain/zero/1.0/
+ *
+ * To the extent possible under law, Kunquat Affirmers have waived all
+ * copyright and related or neighboring rights to Kunquat.
+ */
+
+
+#include <handle_utils.h>
+#include <test_common.h>
+
+#include <containers/Array.h>
+#include <kunquat/Handle.h>
+#include <kunquat/Player.h>
+#include <kunquat/testing.h>
+#include <player/Work_buffer.h>
+#include <player/Work_buffer_sharing.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#define buf_size 16
+
+
+static Work_buffer* new_filled_Work_buffer(float offset)
+{
+    Work_buffer* buffer = new_Work_buffer(buf_size);
+    fail_if(buffer == NULL, "Could not allocate a Work buffer");
+
+    float* contents = Work_buffer_get_contents_mut(buffer);
+    for (int i = 0; i < buf_size; ++i)
+        contents[i] = offset + (float)i;
+
+    return buffer;
+}
+
+
+START_TEST(Borrowed_contents_are_shared_until_restored)
+{
+    Work_buffer* lender = new_filled_Work_buffer(0);
+    Work_buffer* buffer = new_filled_Work_buffer(100);
+
+    Work_buffer_borrow_contents(buffer, lender);
+
+    fail_if(Work_buffer_get_contents(buffer) != Work_buffer_get_contents(lender),
+            "Borrowing Work buffer does not use the contents of the lender");
+
+    float* contents = Work_buffer_get_contents_mut(buffer);
+    for (int i = 0; i < buf_size; ++i)
+        contents[i] = -(float)i;
+
+    const float* lender_contents = Work_buffer_get_contents(lender);
+    for (int i = 0; i < buf_size; ++i)
+    {
+        fail_if(lender_contents[i] != -(float)i,
+                "Lender contents at index %d is %.1f instead of %.1f",
+                i, lender_contents[i], -(float)i);
+    }
+
+    // Restored contents are separate and start out invalid
+    fail_if(!Work_buffer_restore_contents(buffer),
+            "Could not restore Work buffer contents");
+    fail_if(Work_buffer_is_valid(buffer),
+            "Restored Work buffer is still valid");
+
+    Work_buffer_clear(buffer, 0, buf_size);
+    fail_if(Work_buffer_get_contents(buffer) == Work_buffer_get_contents(lender),
+            "Restored Work buffer still uses the contents of the lender");
+
+    contents = Work_buffer_get_contents_mut(buffer);
+    for (int i = 0; i < buf_size; ++i)
+        contents[i] = 1000;
+
+    for (int i = 0; i < buf_size; ++i)
+    {
+        fail_if(lender_contents[i] != -(float)i,
+                "Writing to a restored Work buffer modified the lender at index %d",
+                i);
+    }
+
+    // Restoring own contents is a no-op
+    fail_if(!Work_buffer_restore_contents(lender),
+            "Could not restore Work buffer contents of a lender");
+    fail_if(!Work_buffer_is_valid(lender), "Lender was invalidated");
+
+    del_Work_buffer(buffer);
+    del_Work_buffer(lender);
+}
+END_TEST
+
+
+START_TEST(Borrowing_work_buffer_keeps_own_validity_and_const_start)
+{
+    Work_buffer* lender = new_filled_Work_buffer(0);
+    Work_buffer* buffer = new_filled_Work_buffer(100);
+
+    Work_buffer_set_const_start(lender, 4);
+    Work_buffer_set_final(lender, true);
+
+    Work_buffer_borrow_contents(buffer, lender);
+
+    Work_buffer_mark_valid(buffer);
+    Work_buffer_set_const_start(buffer, 12);
+    Work_buffer_set_final(buffer, false);
+
+    fail_if(Work_buffer_get_const_start(lender) != 4,
+            "Lender constant start changed to %d",
+            (int)Work_buffer_get_const_start(lender));
+    fail_if(!Work_buffer_is_final(lender),
+            "Lender finality changed with the borrower");
+
+    Work_buffer_invalidate(buffer);
+    fail_if(!Work_buffer_is_valid(lender),
+            "Invalidating the borrower invalidated the lender");
+    fail_if(Work_buffer_get_const_start(buffer) != 12,
+            "Borrower constant start is %d instead of 12",
+            (int)Work_buffer_get_const_start(buffer));
+
+    Work_buffer_clear(lender, 0, buf_size);
+    fail_if(Work_buffer_is_valid(buffer),
+            "Clearing the lender validated the borrower");
+    fail_if(Work_buffer_get_const_start(buffer) != 12,
+            "Clearing the lender changed borrower constant start to %d",
+            (int)Work_buffer_get_const_start(buffer));
+
+    del_Work_buffer(buffer);
+    del_Work_buffer(lender);
+}
+END_TEST
+
+
+START_TEST(Borrowed_contents_follow_lender_resize)
+{
+    Work_buffer* lender = new_filled_Work_buffer(0);
+    Work_buffer* buffer = new_filled_Work_buffer(100);
+
+    Work_buffer_borrow_contents(buffer, lender);
+
+    const int32_t new_size = buf_size * 4;
+    fail_if(!Work_buffer_resize(lender, new_size), "Could not resize lender");
+    fail_if(!Work_buffer_resize(buffer, new_size), "Could not resize borrower");
+    fail_if(Work_buffer_get_size(buffer) != new_size,
+            "Borrower size is %d instead of %d",
+            (int)Work_buffer_get_size(buffer), (int)new_size);
+
+    Work_buffer_clear(lender, 0, new_size);
+    float* contents = Work_buffer_get_contents_mut(buffer);
+    for (int i = 0; i < new_size; ++i)
+        contents[i] = (float)i;
+
+    const float* lender_contents = Work_buffer_get_contents(lender);
+    for (int i = 0; i < new_size; ++i)
+    {
+        fail_if(lender_contents[i] != (float)i,
+                "Lender contents at index %d is %.1f instead of %.1f",
+                i, lender_contents[i], (float)i);
+    }
+
+    del_Work_buffer(buffer);
+    del_Work_buffer(lender);
+}
+END_TEST
+
+
+static int find_binding(const Array* bindings, const Work_buffer* buffer)
+{
+    for (int64_t i = 0; i < Array_get_size(bindings); ++i)
+    {
+        const Work_buffer_binding* binding = Array_get_ref(bindings, i);
+        if (binding->buffer == buffer)
+            return (int)i;
+    }
+
+    return -1;
+}
+
+
+START_TEST(Sharing_binds_work_buffers_with_disjoint_lifetimes)
+{
+    Work_buffer* bufs[4] = { NULL };
+    for (int i = 0; i < 4; ++i)
+        bufs[i] = new_filled_Work_buffer((float)(i * 100));
+
+    Work_buffer_sharing* sharing = new_Work_buffer_sharing();
+    Array* bindings = new_Array(sizeof(Work_buffer_binding));
+    fail_if((sharing == NULL) || (bindings == NULL), "Could not allocate sharing");
+
+    // 0 and 2 do not overlap, 3 is in use for the whole plan
+    fail_if(!Work_buffer_sharing_add_use(sharing, bufs[2], 2, 3), "Out of memory");
+    fail_if(!Work_buffer_sharing_add_use(sharing, bufs[0], 0, 1), "Out of memory");
+    fail_if(!Work_buffer_sharing_add_use(sharing, bufs[1], 1, 2), "Out of memory");
+    fail_if(!Work_buffer_sharing_add_use(
+                sharing, bufs[3], WORK_BUFFER_STEP_BEFORE, WORK_BUFFER_STEP_AFTER),
+            "Out of memory");
+    fail_if(Work_buffer_sharing_extend_use(sharing, bufs[0], -1) != true,
+            "Could not extend the lifetime of an added Work buffer");
+
+    fail_if(!Work_buffer_sharing_get_bindings(sharing, bindings), "Out of memory");
+    fail_if(Array_get_size(bindings) != 1,
+            "Found %d bindings instead of 1", (int)Array_get_size(bindings));
+
+    const int index = find_binding(bindings, bufs[2]);
+    fail_if(index < 0, "Work buffer 2 was not bound");
+    const Work_buffer_binding* binding = Array_get_ref(bindings, index);
+    fail_if(binding->lender != bufs[0], "Work buffer 2 was not bound to 0");
+
+    Work_buffer_bindings_apply(bindings);
+    Work_buffer_mark_valid(bufs[2]);
+    fail_if(Work_buffer_get_contents(bufs[2]) != Work_buffer_get_contents(bufs[0]),
+            "Bound Work buffer does not use the contents of its lender");
+    fail_if(!Work_buffer_restore_contents(bufs[2]), "Out of memory");
+
+    // Overlapping lifetimes prevent sharing
+    Array_clear(bindings);
+    fail_if(!Work_buffer_sharing_extend_use(sharing, bufs[0], 2), "Buffer not found");
+    fail_if(!Work_buffer_sharing_get_bindings(sharing, bindings), "Out of memory");
+    fail_if(Array_get_size(bindings) != 0,
+            "Found %d bindings for overlapping Work buffers",
+            (int)Array_get_size(bindings));
+
+    del_Array(bindings);
+    del_Work_buffer_sharing(sharing);
+    for (int i = 0; i < 4; ++i)
+        del_Work_buffer(bufs[i]);
+}
+END_TEST
+
+
+static void setup_volume_chain_instrument(bool include_pitch)
+{
+    assert(handle != 0);
+
+    setup_debug_instrument();
+
+    // The pitch processor output has the same slot as the output of proc_02
+    set_data("au_00/p_connections.json",
+            include_pitch
+            ? "[0,"
+              "[ [\"proc_03/C/out_00\", \"out_00\"]"
+              ", [\"proc_02/C/out_00\", \"proc_03/C/in_00\"]"
+              ", [\"proc_00/C/out_00\", \"proc_02/C/in_00\"]"
+              ", [\"proc_01/C/out_00\", \"proc_00/C/in_00\"]"
+              "]"
+              "]"
+            : "[0,"
+              "[ [\"proc_03/C/out_00\", \"out_00\"]"
+              ", [\"proc_02/C/out_00\", \"proc_03/C/in_00\"]"
+              ", [\"proc_00/C/out_00\", \"proc_02/C/in_00\"]"
+              "]"
+              "]");
+
+    for (int i = 2; i < 4; ++i)
+    {
+        char key[64] = "";
+        snprintf(key, sizeof(key), "au_00/proc_%02d/p_manifest.json", i);
+        set_data(key, "[0, { \"type\": \"volume\" }]");
+        snprintf(key, sizeof(key), "au_00/proc_%02d/p_signal_type.json", i);
+        set_data(key, "[0, \"voice\"]");
+        snprintf(key, sizeof(key), "au_00/proc_%02d/in_00/p_manifest.json", i);
+        set_data(key, "[0, {}]");
+        snprintf(key, sizeof(key), "au_00/proc_%02d/out_00/p_manifest.json", i);
+        set_data(key, "[0, {}]");
+    }
+
+    if (!include_pitch)
+    {
+        set_data("au_00/proc_01/p_manifest.json", "");
+        set_data("au_00/proc_01/p_signal_type.json", "");
+        set_data("au_00/proc_01/out_00/p_manifest.json", "");
+    }
+
+    validate();
+    check_unexpected_error();
+
+    return;
+}
+
+
+#define render_len 256
+
+
+static void render_notes(float* buf)
+{
+    set_audio_rate(220);
+    pause();
+
+    kqt_Handle_fire_event(handle, 0, Note_On_55_Hz);
+    kqt_Handle_fire_event(handle, 1, "[\"n+\", 0]");
+    check_unexpected_error();
+
+    long frames_left = render_len;
+    while (frames_left > 0)
+        frames_left -= mix_and_fill(buf + render_len - frames_left, frames_left);
+
+    return;
+}
+
+
+START_TEST(Removing_lender_device_restores_borrowed_contents)
+{
+    float expected[render_len] = { 0 };
+    setup_volume_chain_instrument(false);
+    render_notes(expected);
+    handle_teardown();
+
+    setup_empty();
+    float actual[render_len] = { 0 };
+    setup_volume_chain_instrument(true);
+    render_notes(actual);
+
+    // Remove the pitch processor that lends its output to proc_02
+    set_data("au_00/p_connections.json",
+            "[0,"
+            "[ [\"proc_03/C/out_00\", \"out_00\"]"
+            ", [\"proc_02/C/out_00\", \"proc_03/C/in_00\"]"
+            ", [\"proc_00/C/out_00\", \"proc_02/C/in_00\"]"
+            "]"
+            "]");
+    set_data("au_00/proc_01/p_manifest.json", "");
+    set_data("au_00/proc_01/p_signal_type.json", "");
+    set_data("au_00/proc_01/out_00/p_manifest.json", "");
+
+    // Rendering is not possible until the signal plans are updated
+    fail_if(kqt_Handle_play(handle, 1) != 0,
+            "Rendering succeeded before validation");
+    kqt_Handle_clear_error(handle);
+
+    validate();
+    check_unexpected_error();
+
+    kqt_Handle_set_position(handle, 0, 0);
+    check_unexpected_error();
+    render_notes(actual);
+
+    check_buffers_equal(expected, actual, render_len, 0.0f);
+}
+END_TEST
+
+
+static Suite* Work_buffer_suite(void)
+{
+    Suite* s = suite_create("Work_buffer");
+
+    const int timeout = DEFAULT_TIMEOUT;
+
+    TCase* tc_contents = tcase_create("contents");
+    TCase* tc_sharing = tcase_create("sharing");
+    suite_add_tcase(s, tc_contents);
+    suite_add_tcase(s, tc_sharing);
+    tcase_set_timeout(tc_contents, timeout);
+    tcase_set_timeout(tc_sharing, timeout);
+    tcase_add_checked_fixture(tc_sharing, setup_empty, handle_teardown);
+
+    tcase_add_test(tc_contents, Borrowed_contents_are_shared_until_restored);
+    tcase_add_test(tc_contents, Borrowing_work_buffer_keeps_own_validity_and_const_start);
+    tcase_add_test(tc_contents, Borrowed_contents_follow_lender_resize);
+    tcase_add_test(tc_contents, Sharing_binds_work_buffers_with_disjoint_lifetimes);
+
+    tcase_add_test(tc_sharing, Removing_lender_device_restores_borrowed_contents);
+
+    return s;
+}
+
+
+int main(void)
+{
+    Suite* suite = Work_buffer_suite();
+    SRunner* sr = srunner_create(suite);
+#ifdef K_MEM_DEBUG
+    srunner_set_fork_status(sr, CK_NOFORK);
+#endif
+    srunner_run_all(sr, CK_NORMAL);
+    int fail_count = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    exit(fail_count > 0);
+}
+
+